@@ -466,16 +466,9 @@ int compare_read_req(const void* a, const void* b)
     }
 }
 
-/**
- * Service a list of client read requests using either local
- * data or forwarding requests to the server.
- *
- * @param in_reqs     a list of read requests
- * @param in_count    number of read requests
- *
- * @return error code
- */
-int process_gfid_reads(read_req_t* in_reqs, int in_count)
+/* service a list of client read requests once, using either local
+ * data or forwarding requests to the server */
+static int gfid_reads_once(read_req_t* in_reqs, int in_count)
 {
     int i, rc, read_rc;
 
@@ -578,9 +571,15 @@ int process_gfid_reads(read_req_t* in_reqs, int in_count)
     LOGDBG("mread[%u]: n_reqs=%d, reqs(%p)",
            mread_id, server_count, server_reqs);
 
+    /* when tracing, time the rpc and the wait for read completion */
+    uint64_t trace_id = unifyfs_trace_new_id();
+    uint64_t trace_start = unifyfs_trace_start();
+
     /* invoke multi-read rpc on server */
-    read_rc = invoke_client_mread_rpc(mread_id, server_count, size, buffer);
+    read_rc = invoke_client_mread_rpc(mread_id, server_count, trace_id,
+                                      size, buffer);
     free(buffer);
+    unifyfs_trace_end("client_mread_rpc", trace_id, trace_start);
 
     if (read_rc != UNIFYFS_SUCCESS) {
         /* mark requests as failed if we couldn't even start the read(s) */
@@ -633,6 +632,7 @@ int process_gfid_reads(read_req_t* in_reqs, int in_count)
                mread->id, wait_rc, mread->n_reads, mread->n_error);
         pthread_mutex_unlock(&(mread->mutex));
     }
+    unifyfs_trace_end("client_mread", trace_id, trace_start);
 
     /* got all of the data we'll get from the server, check for short reads
      * and whether those short reads are from errors, holes, or end of file */
@@ -749,4 +749,71 @@ int process_gfid_reads(read_req_t* in_reqs, int in_count)
     return ret;
 }
 
+/**
+ * Service a list of client read requests using either local
+ * data or forwarding requests to the server. Requests that fail with
+ * ESTALE, because the log chunks of their extents were released before
+ * the server read them, are issued again so that the server looks up
+ * the current extents.
+ *
+ * @param in_reqs     a list of read requests
+ * @param in_count    number of read requests
+ *
+ * @return error code
+ */
+int process_gfid_reads(read_req_t* in_reqs, int in_count)
+{
+    int i;
+    int ret = gfid_reads_once(in_reqs, in_count);
+
+    int retries = 0;
+    while ((ret == UNIFYFS_SUCCESS) &&
+           (retries < UNIFYFS_CLIENT_READ_STALE_RETRIES)) {
+        int stale_count = 0;
+        for (i = 0; i < in_count; i++) {
+            if (in_reqs[i].errcode == ESTALE) {
+                stale_count++;
+            }
+        }
+        if (0 == stale_count) {
+            break;
+        }
+        retries++;
+        LOGDBG("retrying %d stale read requests (attempt %d)",
+               stale_count, retries);
+
+        /* gather the stale requests, remembering where each came from */
+        read_req_t* stale = calloc(stale_count, sizeof(read_req_t));
+        int* slots = calloc(stale_count, sizeof(int));
+        if ((NULL == stale) || (NULL == slots)) {
+            free(stale);
+            free(slots);
+            return ENOMEM;
+        }
+        int n = 0;
+        for (i = 0; i < in_count; i++) {
+            if (in_reqs[i].errcode == ESTALE) {
+                read_req_t* req = stale + n;
+                *req = in_reqs[i];
+                req->cover_begin_offset = (size_t)-1;
+                req->cover_end_offset = (size_t)-1;
+                req->nread = 0;
+                req->errcode = UNIFYFS_SUCCESS;
+                slots[n++] = i;
+            }
+        }
+
+        /* requests may be reordered, but each keeps its buffer, so they
+         * can be put back in any of the slots they came from */
+        ret = gfid_reads_once(stale, stale_count);
+        for (i = 0; i < stale_count; i++) {
+            in_reqs[slots[i]] = stale[i];
+        }
+        free(stale);
+        free(slots);
+    }
+
+    return ret;
+}
+
 
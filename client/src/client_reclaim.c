@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "client_reclaim.h"
+#include "unifyfs_log.h"
+
+static logio_context* log_ctx;    /* log of the client */
+static client_reclaim_ops log_ops; /* operations that involve the server */
+static size_t log_n_chunks;       /* number of log chunks, 0 if disabled */
+static size_t log_chunk_sz;       /* size of a log chunk */
+static uint8_t* log_chunk_state;  /* state of each chunk */
+static size_t* log_chunk_live;    /* unsynced bytes referenced in chunk */
+static useconds_t log_reclaim_delay; /* server delay to release chunks */
+
+static size_t log_reclaimed_unsynced; /* bytes of unsynced data reclaimed */
+static size_t log_reclaimed_synced;   /* bytes of synced data reclaimed */
+static size_t log_reclaimable;        /* bytes last reported by server */
+static size_t log_compacted;          /* bytes moved by log compaction */
+
+/* call fn for each chunk spanned by the given log data, with the index
+ * of the chunk and the number of data bytes within it */
+static void foreach_log_chunk(off_t log_pos,
+                              size_t length,
+                              void (*fn)(size_t, size_t, int),
+                              int arg)
+{
+    while (length > 0) {
+        size_t ndx;
+        off_t chunk_off;
+        int rc = unifyfs_logio_get_chunk(log_ctx, log_pos,
+                                         &ndx, &chunk_off);
+        if ((rc != UNIFYFS_SUCCESS) || (ndx >= log_n_chunks)) {
+            LOGWARN("log offset %zu is outside of log", (size_t)log_pos);
+            return;
+        }
+
+        size_t nbytes = log_chunk_sz - (size_t)(log_pos - chunk_off);
+        if (nbytes > length) {
+            nbytes = length;
+        }
+        fn(ndx, nbytes, arg);
+
+        log_pos += (off_t) nbytes;
+        length -= nbytes;
+    }
+}
+
+/* add (added != 0) or remove references to unsynced bytes of a chunk */
+static void chunk_ref(size_t ndx, size_t nbytes, int added)
+{
+    if (LOG_CHUNK_UNSYNCED != log_chunk_state[ndx]) {
+        return;
+    }
+    if (added) {
+        log_chunk_live[ndx] += nbytes;
+    } else if (log_chunk_live[ndx] > nbytes) {
+        log_chunk_live[ndx] -= nbytes;
+    } else {
+        log_chunk_live[ndx] = 0;
+    }
+}
+
+/* set the state of a chunk */
+static void chunk_set_state(size_t ndx, size_t nbytes, int state)
+{
+    log_chunk_state[ndx] = (uint8_t) state;
+    log_chunk_live[ndx] = 0;
+}
+
+/* release a log chunk */
+static void free_log_chunk(size_t ndx)
+{
+    off_t chunk_off;
+    int rc = unifyfs_logio_chunk_offset(log_ctx, ndx, &chunk_off);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = unifyfs_logio_free(log_ctx, chunk_off, log_chunk_sz);
+    }
+    if (rc != UNIFYFS_SUCCESS) {
+        LOGERR("failed to release log chunk %zu", ndx);
+    }
+    log_chunk_state[ndx] = LOG_CHUNK_FREE;
+    log_chunk_live[ndx] = 0;
+}
+
+/* release a chunk spanned by log data, for foreach_log_chunk() */
+static void chunk_free(size_t ndx, size_t nbytes, int arg)
+{
+    free_log_chunk(ndx);
+}
+
+/* update references to unsynced log data */
+void client_reclaim_ref(off_t log_pos, size_t length, int added)
+{
+    if (log_n_chunks > 0) {
+        foreach_log_chunk(log_pos, length, chunk_ref, added);
+    }
+}
+
+/* set the state of the chunks holding the given log data */
+void client_reclaim_set_state(off_t log_pos, size_t length, int state)
+{
+    if (log_n_chunks > 0) {
+        foreach_log_chunk(log_pos, length, chunk_set_state, state);
+    }
+}
+
+/* release the chunks holding the given log data */
+void client_reclaim_free(off_t log_pos, size_t length)
+{
+    if (log_n_chunks > 0) {
+        foreach_log_chunk(log_pos, length, chunk_free, 0);
+    }
+}
+
+/* release chunks of unsynced data that is no longer referenced */
+void client_reclaim_unsynced(void)
+{
+    for (size_t i = 0; i < log_n_chunks; i++) {
+        if ((LOG_CHUNK_UNSYNCED == log_chunk_state[i]) &&
+            (0 == log_chunk_live[i])) {
+            free_log_chunk(i);
+            log_reclaimed_unsynced += log_chunk_sz;
+        }
+    }
+}
+
+/* release chunks of synced data that the server no longer references */
+int client_reclaim_synced(void)
+{
+    if (0 == log_n_chunks) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    uint64_t* chunks = calloc(log_n_chunks, sizeof(uint64_t));
+    if (NULL == chunks) {
+        return ENOMEM;
+    }
+
+    size_t n_chunks = 0;
+    int rc = log_ops.release(chunks, log_n_chunks, &n_chunks,
+                             &log_reclaimable);
+    if (rc != UNIFYFS_SUCCESS) {
+        LOGERR("reclaim rpc failed");
+    }
+    for (size_t i = 0; i < n_chunks; i++) {
+        size_t ndx = (size_t) chunks[i];
+        if ((ndx < log_n_chunks) &&
+            (LOG_CHUNK_SYNCED == log_chunk_state[ndx])) {
+            free_log_chunk(ndx);
+            log_reclaimed_synced += log_chunk_sz;
+        } else {
+            LOGWARN("server released log chunk %zu that is not synced", ndx);
+        }
+    }
+    LOGDBG("released %zu log chunks (%zu bytes still reclaimable)",
+           n_chunks, log_reclaimable);
+
+    free(chunks);
+    return rc;
+}
+
+/* record the bytes of synced data the server reports as reclaimable */
+void client_reclaim_set_reclaimable(size_t bytes)
+{
+    log_reclaimable = bytes;
+}
+
+/* count bytes moved by log compaction */
+void client_reclaim_add_compacted(size_t bytes)
+{
+    log_compacted += bytes;
+}
+
+/* try to free log space for a write that could not allocate it, returns
+ * nonzero if any space was released */
+int client_reclaim_log_space(void)
+{
+    if (0 == log_n_chunks) {
+        return 0;
+    }
+
+    size_t before = log_reclaimed_unsynced + log_reclaimed_synced;
+
+    /* syncing tells the server about overwritten data, and releases
+     * any unsynced data that is no longer referenced */
+    log_ops.sync();
+    client_reclaim_unsynced();
+
+    /* wait for the server to release chunks still in their delay */
+    if (log_reclaimable > 0) {
+        client_reclaim_synced();
+        if (log_reclaimable > 0) {
+            usleep(log_reclaim_delay);
+            client_reclaim_synced();
+        }
+    }
+
+    return ((log_reclaimed_unsynced + log_reclaimed_synced) != before);
+}
+
+/* get the state of a log chunk */
+int client_reclaim_chunk_state(size_t ndx)
+{
+    if (ndx >= log_n_chunks) {
+        return LOG_CHUNK_FREE;
+    }
+    return (int) log_chunk_state[ndx];
+}
+
+/* get the bytes of unsynced and synced data released, and the bytes last
+ * reported as reclaimable by the server */
+void client_reclaim_get_counts(size_t* unsynced,
+                               size_t* synced,
+                               size_t* reclaimable)
+{
+    *unsynced = log_reclaimed_unsynced;
+    *synced = log_reclaimed_synced;
+    *reclaimable = log_reclaimable;
+}
+
+/* return nonzero if log chunks are tracked */
+int client_reclaim_enabled(void)
+{
+    return (log_n_chunks > 0);
+}
+
+/* start tracking log chunks to reclaim log space */
+int client_reclaim_init(logio_context* logio,
+                        long delay_usec,
+                        const client_reclaim_ops* ops)
+{
+    size_t n_chunks = 0;
+    size_t chunk_sz = 0;
+    unifyfs_logio_get_chunks(logio, &n_chunks, &chunk_sz);
+    if (0 == n_chunks) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    log_chunk_state = calloc(n_chunks, sizeof(uint8_t));
+    log_chunk_live = calloc(n_chunks, sizeof(size_t));
+    if ((NULL == log_chunk_state) || (NULL == log_chunk_live)) {
+        LOGERR("failed to allocate log chunk state for %zu chunks",
+               n_chunks);
+        free(log_chunk_state);
+        free(log_chunk_live);
+        log_chunk_state = NULL;
+        log_chunk_live = NULL;
+        return ENOMEM;
+    }
+    log_ctx = logio;
+    log_ops = *ops;
+    log_n_chunks = n_chunks;
+    log_chunk_sz = chunk_sz;
+    log_reclaim_delay = (useconds_t) delay_usec;
+    log_reclaimed_unsynced = 0;
+    log_reclaimed_synced = 0;
+    log_reclaimable = 0;
+    log_compacted = 0;
+    return UNIFYFS_SUCCESS;
+}
+
+/* stop tracking log chunks */
+void client_reclaim_fini(void)
+{
+    if (0 == log_n_chunks) {
+        return;
+    }
+
+    LOGINFO("reclaimed %zu bytes of unsynced and %zu bytes of synced "
+            "log data (%zu bytes reclaimable), compacted %zu bytes",
+            log_reclaimed_unsynced, log_reclaimed_synced, log_reclaimable,
+            log_compacted);
+
+    free(log_chunk_state);
+    free(log_chunk_live);
+    log_chunk_state = NULL;
+    log_chunk_live = NULL;
+    log_n_chunks = 0;
+    log_ctx = NULL;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef _UNIFYFS_CLIENT_RECLAIM_H
+#define _UNIFYFS_CLIENT_RECLAIM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "unifyfs_logio.h"
+
+/*
+ * Log space reclamation.
+ *
+ * Each write reserves whole log chunks, so a chunk only holds data of a
+ * single write. The client tracks the bytes of each chunk referenced by
+ * extents it has not yet synced, and releases chunks of unsynced data
+ * that has been overwritten, truncated, or unlinked. Once extents are
+ * synced, the server tracks references to their data and tells the client
+ * which chunks it may release.
+ */
+
+/* state of a log chunk */
+enum {
+    LOG_CHUNK_FREE = 0, /* not reserved by a write */
+    LOG_CHUNK_UNSYNCED, /* holds data of extents not yet synced */
+    LOG_CHUNK_SYNCED    /* holds data of synced extents */
+};
+
+/* operations that involve the server */
+typedef struct client_reclaim_ops {
+    /* sync the write extents of all files with the server */
+    int (*sync)(void);
+
+    /* get the indices of up to max_chunks chunks of synced data that the
+     * server released, and the bytes it still considers reclaimable */
+    int (*release)(uint64_t* chunks, size_t max_chunks,
+                   size_t* n_chunks, size_t* reclaimable);
+} client_reclaim_ops;
+
+/* start tracking the chunks of the log, with the server delay before
+ * chunks of synced data are released */
+int client_reclaim_init(logio_context* logio,
+                        long delay_usec,
+                        const client_reclaim_ops* ops);
+
+/* stop tracking log chunks */
+void client_reclaim_fini(void);
+
+/* return nonzero if log chunks are tracked */
+int client_reclaim_enabled(void);
+
+/* add (added != 0) or remove references to unsynced log data */
+void client_reclaim_ref(off_t log_pos, size_t length, int added);
+
+/* set the state of the chunks holding the given log data */
+void client_reclaim_set_state(off_t log_pos, size_t length, int state);
+
+/* release the chunks holding the given log data */
+void client_reclaim_free(off_t log_pos, size_t length);
+
+/* release chunks of unsynced data that is no longer referenced */
+void client_reclaim_unsynced(void);
+
+/* release chunks of synced data that the server no longer references */
+int client_reclaim_synced(void);
+
+/* record the bytes of synced data the server reports as reclaimable */
+void client_reclaim_set_reclaimable(size_t bytes);
+
+/* count bytes moved by log compaction */
+void client_reclaim_add_compacted(size_t bytes);
+
+/* try to free log space for a write that could not allocate it, returns
+ * nonzero if any space was released */
+int client_reclaim_log_space(void);
+
+/* get the state of a log chunk */
+int client_reclaim_chunk_state(size_t ndx);
+
+/* get the bytes of unsynced and synced data released, and the bytes last
+ * reported as reclaimable by the server */
+void client_reclaim_get_counts(size_t* unsynced,
+                               size_t* synced,
+                               size_t* reclaimable);
+
+#endif /* _UNIFYFS_CLIENT_RECLAIM_H */
@@ -59,8 +59,12 @@ static void register_client_rpcs(client_rpc_context_t* ctx)
     CLIENT_REGISTER_RPC(truncate);
     CLIENT_REGISTER_RPC(unlink);
     CLIENT_REGISTER_RPC(laminate);
+    CLIENT_REGISTER_RPC(transfer);
+    CLIENT_REGISTER_RPC(readthrough);
     CLIENT_REGISTER_RPC(fsync);
     CLIENT_REGISTER_RPC(mread);
+    CLIENT_REGISTER_RPC(reclaim);
+    CLIENT_REGISTER_RPC(compact);
     CLIENT_REGISTER_RPC_HANDLER(mread_req_data);
     CLIENT_REGISTER_RPC_HANDLER(mread_req_complete);
 
@@ -599,7 +603,7 @@ int invoke_client_unlink_rpc(int gfid)
 }
 
 /* invokes the client-to-server laminate rpc function */
-int invoke_client_laminate_rpc(int gfid)
+int invoke_client_laminate_rpc(int gfid, uint64_t trace_id)
 {
     /* check that we have initialized margo */
     if (NULL == client_rpc_context) {
@@ -614,6 +618,7 @@ int invoke_client_laminate_rpc(int gfid)
     in.app_id    = (int32_t) unifyfs_app_id;
     in.client_id = (int32_t) unifyfs_client_id;
     in.gfid      = (int32_t) gfid;
+    in.trace_id  = trace_id;
 
     /* call rpc function */
     LOGDBG("invoking the laminate rpc function in client");
@@ -643,14 +648,115 @@ int invoke_client_laminate_rpc(int gfid)
     return ret;
 }
 
-/* invokes the client sync rpc function */
-int invoke_client_sync_rpc(int gfid)
+/* invokes the client-to-server transfer rpc function, to have all
+ * servers write the data of a laminated file to dst_file */
+int invoke_client_transfer_rpc(int gfid, const char* dst_file)
 {
     /* check that we have initialized margo */
     if (NULL == client_rpc_context) {
         return UNIFYFS_FAILURE;
     }
 
+    /* get handle to rpc function */
+    hg_handle_t handle = create_handle(client_rpc_context->rpcs.transfer_id);
+
+    /* fill in input struct */
+    unifyfs_transfer_in_t in;
+    in.app_id    = (int32_t) unifyfs_app_id;
+    in.client_id = (int32_t) unifyfs_client_id;
+    in.gfid      = (int32_t) gfid;
+    in.dst_file  = (hg_const_string_t) dst_file;
+
+    /* call rpc function */
+    LOGDBG("invoking the transfer rpc function in client");
+    hg_return_t hret = margo_forward(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_forward() failed");
+        margo_destroy(handle);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* decode response */
+    int ret;
+    unifyfs_transfer_out_t out;
+    hret = margo_get_output(handle, &out);
+    if (hret == HG_SUCCESS) {
+        LOGDBG("Got response ret=%" PRIi32, out.ret);
+        ret = (int) out.ret;
+        margo_free_output(handle, &out);
+    } else {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    }
+
+    /* free resources */
+    margo_destroy(handle);
+
+    return ret;
+}
+
+/* invokes the client-to-server readthrough rpc function, to register
+ * a file on all servers whose data is read from backing_file */
+int invoke_client_readthrough_rpc(unifyfs_file_attr_t* attr,
+                                  const char* backing_file)
+{
+    /* check that we have initialized margo */
+    if (NULL == client_rpc_context) {
+        return UNIFYFS_FAILURE;
+    }
+
+    /* get handle to rpc function */
+    hg_handle_t handle =
+        create_handle(client_rpc_context->rpcs.readthrough_id);
+
+    /* fill in input struct */
+    unifyfs_readthrough_in_t in;
+    in.app_id       = (int32_t) unifyfs_app_id;
+    in.client_id    = (int32_t) unifyfs_client_id;
+    in.attr         = *attr;
+    in.backing_file = (hg_const_string_t) backing_file;
+
+    /* call rpc function */
+    LOGDBG("invoking the readthrough rpc function in client");
+    hg_return_t hret = margo_forward(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_forward() failed");
+        margo_destroy(handle);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* decode response */
+    int ret;
+    unifyfs_readthrough_out_t out;
+    hret = margo_get_output(handle, &out);
+    if (hret == HG_SUCCESS) {
+        LOGDBG("Got response ret=%" PRIi32, out.ret);
+        ret = (int) out.ret;
+        margo_free_output(handle, &out);
+    } else {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    }
+
+    /* free resources */
+    margo_destroy(handle);
+
+    return ret;
+}
+
+/* invokes the client sync rpc function, sets reclaimable to the bytes
+ * of the client log the server reports are no longer referenced */
+int invoke_client_sync_rpc(int gfid, uint64_t trace_id,
+                           size_t* reclaimable, size_t* compactable)
+{
+    *reclaimable = 0;
+    *compactable = 0;
+
+    /* check that we have initialized margo */
+    if (NULL == client_rpc_context) {
+        return UNIFYFS_FAILURE;
+    }
+
     /* get handle to rpc function */
     hg_handle_t handle = create_handle(client_rpc_context->rpcs.fsync_id);
 
@@ -659,6 +765,7 @@ int invoke_client_sync_rpc(int gfid)
     in.app_id    = (int32_t) unifyfs_app_id;
     in.client_id = (int32_t) unifyfs_client_id;
     in.gfid      = (int32_t) gfid;
+    in.trace_id  = trace_id;
 
     /* call rpc function */
     LOGINFO("invoking the sync rpc function in client");
@@ -676,6 +783,125 @@ int invoke_client_sync_rpc(int gfid)
     if (hret == HG_SUCCESS) {
         LOGDBG("Got response ret=%" PRIi32, out.ret);
         ret = (int) out.ret;
+        *reclaimable = (size_t) out.reclaimable;
+        *compactable = (size_t) out.compactable;
+        margo_free_output(handle, &out);
+    } else {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    }
+
+    /* free resources */
+    margo_destroy(handle);
+
+    return ret;
+}
+
+/* invokes the client compact rpc function, which moves live data of
+ * sparsely used log chunks into the reserved log range */
+int invoke_client_compact_rpc(off_t log_offset, size_t length,
+                              size_t* used, size_t* moved)
+{
+    *used = 0;
+    *moved = 0;
+
+    /* check that we have initialized margo */
+    if (NULL == client_rpc_context) {
+        return UNIFYFS_FAILURE;
+    }
+
+    /* get handle to rpc function */
+    hg_handle_t handle = create_handle(client_rpc_context->rpcs.compact_id);
+
+    /* fill in input struct */
+    unifyfs_compact_in_t in;
+    in.app_id     = (int32_t) unifyfs_app_id;
+    in.client_id  = (int32_t) unifyfs_client_id;
+    in.log_offset = (hg_size_t) log_offset;
+    in.length     = (hg_size_t) length;
+
+    /* call rpc function */
+    LOGDBG("invoking the compact rpc function in client");
+    hg_return_t hret = margo_forward(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_forward() failed");
+        margo_destroy(handle);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* decode response */
+    int ret;
+    unifyfs_compact_out_t out;
+    hret = margo_get_output(handle, &out);
+    if (hret == HG_SUCCESS) {
+        LOGDBG("Got response ret=%" PRIi32, out.ret);
+        ret = (int) out.ret;
+        *used = (size_t) out.used;
+        *moved = (size_t) out.moved;
+        margo_free_output(handle, &out);
+    } else {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    }
+
+    /* free resources */
+    margo_destroy(handle);
+
+    return ret;
+}
+
+/* invokes the client reclaim rpc function, which fills chunks with the
+ * indices of up to max_chunks log chunks that are ready to be released */
+int invoke_client_reclaim_rpc(uint64_t* chunks, size_t max_chunks,
+                              size_t* n_chunks, size_t* reclaimable)
+{
+    *n_chunks = 0;
+    *reclaimable = 0;
+
+    /* check that we have initialized margo */
+    if (NULL == client_rpc_context) {
+        return UNIFYFS_FAILURE;
+    }
+
+    /* get handle to rpc function */
+    hg_handle_t handle = create_handle(client_rpc_context->rpcs.reclaim_id);
+
+    /* initialize bulk handle for chunk indices */
+    unifyfs_reclaim_in_t in;
+    void* buf = (void*) chunks;
+    hg_size_t size = (hg_size_t)(max_chunks * sizeof(uint64_t));
+    hg_return_t hret = margo_bulk_create(client_rpc_context->mid,
+                                         1, &buf, &size,
+                                         HG_BULK_WRITE_ONLY, &in.bulk_chunks);
+    if (hret != HG_SUCCESS) {
+        margo_destroy(handle);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* fill input struct */
+    in.app_id    = (int32_t) unifyfs_app_id;
+    in.client_id = (int32_t) unifyfs_client_id;
+    in.bulk_size = size;
+
+    /* call rpc function */
+    LOGDBG("invoking the reclaim rpc function in client");
+    hret = margo_forward(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_forward() failed");
+        margo_bulk_free(in.bulk_chunks);
+        margo_destroy(handle);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* decode response */
+    int ret;
+    unifyfs_reclaim_out_t out;
+    hret = margo_get_output(handle, &out);
+    if (hret == HG_SUCCESS) {
+        LOGDBG("Got response ret=%" PRIi32, out.ret);
+        ret = (int) out.ret;
+        *n_chunks = (size_t) out.num_chunks;
+        *reclaimable = (size_t) out.reclaimable;
         margo_free_output(handle, &out);
     } else {
         LOGERR("margo_get_output() failed");
@@ -683,6 +909,7 @@ int invoke_client_sync_rpc(int gfid)
     }
 
     /* free resources */
+    margo_bulk_free(in.bulk_chunks);
     margo_destroy(handle);
 
     return ret;
@@ -690,6 +917,7 @@ int invoke_client_sync_rpc(int gfid)
 
 /* invokes the client mread rpc function */
 int invoke_client_mread_rpc(unsigned int reqid, int read_count,
+                            uint64_t trace_id,
                             size_t extents_size, void* extents_buffer)
 {
     /* check that we have initialized margo */
@@ -714,6 +942,7 @@ int invoke_client_mread_rpc(unsigned int reqid, int read_count,
     in.app_id     = (int32_t) unifyfs_app_id;
     in.client_id  = (int32_t) unifyfs_client_id;
     in.read_count = (int32_t) read_count;
+    in.trace_id   = trace_id;
     in.bulk_size  = (hg_size_t) extents_size;
 
     /* call rpc function */
@@ -33,8 +33,12 @@ typedef struct ClientRpcIds {
     hg_id_t truncate_id;
     hg_id_t unlink_id;
     hg_id_t laminate_id;
+    hg_id_t transfer_id;
+    hg_id_t readthrough_id;
     hg_id_t fsync_id;
     hg_id_t mread_id;
+    hg_id_t reclaim_id;
+    hg_id_t compact_id;
     hg_id_t mread_req_data_id;
     hg_id_t mread_req_complete_id;
 } client_rpcs_t;
@@ -71,11 +75,24 @@ int invoke_client_truncate_rpc(int gfid, size_t filesize);
 
 int invoke_client_unlink_rpc(int gfid);
 
-int invoke_client_laminate_rpc(int gfid);
+int invoke_client_laminate_rpc(int gfid, uint64_t trace_id);
 
-int invoke_client_sync_rpc(int gfid);
+int invoke_client_transfer_rpc(int gfid, const char* dst_file);
+
+int invoke_client_readthrough_rpc(unifyfs_file_attr_t* attr,
+                                  const char* backing_file);
+
+int invoke_client_sync_rpc(int gfid, uint64_t trace_id,
+                           size_t* reclaimable, size_t* compactable);
+
+int invoke_client_reclaim_rpc(uint64_t* chunks, size_t max_chunks,
+                              size_t* n_chunks, size_t* reclaimable);
+
+int invoke_client_compact_rpc(off_t log_offset, size_t length,
+                              size_t* used, size_t* moved);
 
 int invoke_client_mread_rpc(unsigned int reqid, int read_count,
+                            uint64_t trace_id,
                             size_t extents_size, void* extents_buffer);
 
 #endif // MARGO_CLIENT_H
@@ -42,10 +42,134 @@
 
 #include "unifyfs-internal.h"
 #include "unifyfs-fixed.h"
+#include "client_reclaim.h"
 #include "unifyfs_log.h"
 #include "margo_client.h"
 #include "seg_tree.h"
 
+/* ---------------------------------------
+ * Log space reclamation
+ * --------------------------------------- */
+
+/* sync the write extents of all files, for client_reclaim_log_space() */
+static int reclaim_sync_all(void)
+{
+    return unifyfs_sync(-1);
+}
+
+static const client_reclaim_ops reclaim_ops = {
+    .sync = reclaim_sync_all,
+    .release = invoke_client_reclaim_rpc
+};
+
+/* release the log data of unsynced extents in the tree that overlap
+ * the range [start, end] */
+static void release_unsynced_extents(struct seg_tree* tree,
+                                     unsigned long start,
+                                     unsigned long end)
+{
+    if (!client_reclaim_enabled()) {
+        return;
+    }
+
+    seg_tree_rdlock(tree);
+    struct seg_tree_node* node = seg_tree_find_nolock(tree, start, end);
+    while ((NULL != node) && (node->start <= end)) {
+        unsigned long s = (node->start > start) ? node->start : start;
+        unsigned long e = (node->end < end) ? node->end : end;
+        client_reclaim_ref((off_t)(node->ptr + (s - node->start)),
+                           (size_t)(e - s + 1), 0);
+        node = seg_tree_iter(tree, node);
+    }
+    seg_tree_unlock(tree);
+}
+
+/* reserve nbytes of log space for the server to move live data of
+ * sparsely used chunks into, and release the space it does not use */
+static void compact_log(size_t nbytes)
+{
+    off_t log_off;
+    int rc = unifyfs_logio_alloc(logio_ctx, nbytes, &log_off);
+    if (rc != UNIFYFS_SUCCESS) {
+        LOGDBG("no log space to compact %zu bytes", nbytes);
+        return;
+    }
+
+    /* the server tracks references to the data moved into the space */
+    client_reclaim_set_state(log_off, nbytes, LOG_CHUNK_SYNCED);
+
+    size_t used = 0;
+    size_t moved = 0;
+    rc = invoke_client_compact_rpc(log_off, nbytes, &used, &moved);
+    if (rc == UNIFYFS_ERROR_MARGO) {
+        /* we don't know which chunks hold data, so keep them all */
+        LOGERR("compact rpc failed");
+        return;
+    }
+    client_reclaim_add_compacted(moved);
+
+    /* the server wrote the moved data in place, now it may be tiered */
+    if (used > 0) {
+        unifyfs_logio_set_written(logio_ctx, log_off, used);
+    }
+
+    /* release chunks that hold no moved data */
+    size_t n_chunks = 0;
+    size_t chunk_sz = 0;
+    unifyfs_logio_get_chunks(logio_ctx, &n_chunks, &chunk_sz);
+    size_t keep = ((used + chunk_sz - 1) / chunk_sz) * chunk_sz;
+    if (keep < nbytes) {
+        client_reclaim_free(log_off + (off_t)keep, nbytes - keep);
+    }
+    LOGDBG("log compaction moved %zu bytes into %zu chunks",
+           moved, keep / chunk_sz);
+}
+
+/* bytes of sparse chunk data the server last offered to compact */
+static size_t compact_pending;
+
+/* compact the log if the server offered to at the last sync and the log
+ * is filling up. Compaction copies data and updates extents on the
+ * servers, so it is left out of syncs and only done once the space it
+ * frees is likely to be needed */
+static void compact_log_if_full(void)
+{
+    if (0 == __atomic_load_n(&compact_pending, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    off_t shmem_sz = 0;
+    off_t spill_sz = 0;
+    size_t shmem_used = 0;
+    size_t spill_used = 0;
+    unifyfs_logio_get_sizes(logio_ctx, &shmem_sz, &spill_sz);
+    unifyfs_logio_get_usage(logio_ctx, &shmem_used, &spill_used);
+    size_t log_sz = (size_t)(shmem_sz + spill_sz);
+    size_t used = shmem_used + spill_used;
+    if ((used * 100) < (log_sz * UNIFYFS_CLIENT_COMPACT_LOG_USAGE)) {
+        return;
+    }
+
+    /* only one writer does the pending compaction */
+    size_t nbytes = __atomic_exchange_n(&compact_pending, 0,
+                                        __ATOMIC_RELAXED);
+    if (nbytes > 0) {
+        compact_log(nbytes);
+    }
+}
+
+/* start tracking log chunks to reclaim log space */
+int unifyfs_logio_reclaim_init(long delay_usec)
+{
+    return client_reclaim_init(logio_ctx, delay_usec, &reclaim_ops);
+}
+
+/* stop tracking log chunks */
+void unifyfs_logio_reclaim_fini(void)
+{
+    client_reclaim_fini();
+}
+
 /* ---------------------------------------
  * Operations on client write index
  * --------------------------------------- */
@@ -87,6 +211,12 @@ static int add_write_meta_to_index(unifyfs_filemeta_t* meta,
         unifyfs_sync(meta->fid);
     }
 
+    /* release log data of unsynced writes we overwrite */
+    if (length > 0) {
+        release_unsynced_extents(&meta->extents_sync,
+                                 file_pos, file_pos + length - 1);
+    }
+
     /* store the write in our segment tree used for syncing with server. */
     seg_tree_add(&meta->extents_sync,
                  file_pos,
@@ -158,7 +288,9 @@ int truncate_write_meta(unifyfs_filemeta_t* meta, off_t trunc_sz)
 {
     if (0 == trunc_sz) {
         /* All writes should be removed. Clear extents_sync */
+        release_unsynced_extents(&meta->extents_sync, 0, ULONG_MAX);
         seg_tree_clear(&meta->extents_sync);
+        client_reclaim_unsynced();
 
         if (unifyfs_local_extents) {
             /* Clear the local extent cache too */
@@ -168,7 +300,9 @@ int truncate_write_meta(unifyfs_filemeta_t* meta, off_t trunc_sz)
     }
 
     unsigned long trunc_off = (unsigned long) trunc_sz;
+    release_unsynced_extents(&meta->extents_sync, trunc_off, ULONG_MAX);
     int rc = seg_tree_remove(&meta->extents_sync, trunc_off, ULONG_MAX);
+    client_reclaim_unsynced();
     if (unifyfs_local_extents) {
         rc = seg_tree_remove(&meta->extents, trunc_off, ULONG_MAX);
     }
@@ -181,6 +315,63 @@ int truncate_write_meta(unifyfs_filemeta_t* meta, off_t trunc_sz)
     return rc;
 }
 
+/*
+ * Release the log space of write extents that were never synced.
+ *
+ * This function is called when we discard a file's write metadata.
+ */
+void release_write_meta(unifyfs_filemeta_t* meta)
+{
+    release_unsynced_extents(&meta->extents_sync, 0, ULONG_MAX);
+    client_reclaim_unsynced();
+}
+
+/* pass an access hint for the file data of extents in the tree that
+ * overlap the range [start, end] to the log storage */
+static void advise_extents(struct seg_tree* tree,
+                           unsigned long start,
+                           unsigned long end,
+                           int advice)
+{
+    seg_tree_rdlock(tree);
+    struct seg_tree_node* node = seg_tree_find_nolock(tree, start, end);
+    while ((NULL != node) && (node->start <= end)) {
+        unsigned long s = (node->start > start) ? node->start : start;
+        unsigned long e = (node->end < end) ? node->end : end;
+        unifyfs_logio_advise(logio_ctx, (off_t)(node->ptr + (s - node->start)),
+                             (size_t)(e - s + 1), advice);
+        node = seg_tree_iter(tree, node);
+    }
+    seg_tree_unlock(tree);
+}
+
+/*
+ * Pass an access hint for a range of a file to the log storage. Only data
+ * written by this client is covered: its unsynced extents, and its synced
+ * extents when local extents are tracked.
+ */
+int unifyfs_fid_logio_advise(unifyfs_filemeta_t* meta,
+                             off_t pos,
+                             off_t len,
+                             int advice)
+{
+    assert(meta != NULL);
+    if (meta->storage != FILE_STORAGE_LOGIO) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    unsigned long start = (unsigned long) pos;
+    unsigned long end = ULONG_MAX;
+    if (len > 0) {
+        end = start + (unsigned long)len - 1;
+    }
+
+    advise_extents(&meta->extents_sync, start, end, advice);
+    if (unifyfs_local_extents) {
+        advise_extents(&meta->extents, start, end, advice);
+    }
+    return UNIFYFS_SUCCESS;
+}
 
 /*
  * Sync all the write extents for the target file(s) to the server.
@@ -232,7 +423,13 @@ int unifyfs_sync(int target_fid)
             }
 
             /* tell the server to grab our new extents */
-            tmp_rc = invoke_client_sync_rpc(meta->gfid);
+            uint64_t trace_id = unifyfs_trace_new_id();
+            uint64_t trace_start = unifyfs_trace_start();
+            size_t reclaimable = 0;
+            size_t compactable = 0;
+            tmp_rc = invoke_client_sync_rpc(meta->gfid, trace_id,
+                                            &reclaimable, &compactable);
+            unifyfs_trace_end("client_sync", trace_id, trace_start);
             if (UNIFYFS_SUCCESS != tmp_rc) {
                 /* something went wrong when trying to flush extents */
                 LOGERR("failed to flush write index to server for gfid=%d",
@@ -243,6 +440,33 @@ int unifyfs_sync(int target_fid)
             /* we've sync'd, so mark this file as being up-to-date */
             meta->needs_sync = 0;
 
+            /* the server now tracks the data of the synced extents,
+             * release any unsynced data that is no longer referenced */
+            if (client_reclaim_enabled()) {
+                unifyfs_index_t* indexes = unifyfs_indices.index_entry;
+                size_t n_entries = *unifyfs_indices.ptr_num_entries;
+                for (size_t i = 0; i < n_entries; i++) {
+                    client_reclaim_set_state((off_t) indexes[i].log_pos,
+                                             (size_t) indexes[i].length,
+                                             LOG_CHUNK_SYNCED);
+                }
+                client_reclaim_unsynced();
+
+                /* release synced data the server no longer references */
+                client_reclaim_set_reclaimable(reclaimable);
+                if (reclaimable > 0) {
+                    client_reclaim_synced();
+                }
+
+                /* remember that the server can compact sparsely used
+                 * chunks, unless our local extent cache would still refer
+                 * to the old copies of the data it moves */
+                if (!unifyfs_local_extents) {
+                    __atomic_store_n(&compact_pending, compactable,
+                                     __ATOMIC_RELAXED);
+                }
+            }
+
             /* flushed, clear buffer and refresh number of entries
              * and number remaining */
             clear_index();
@@ -302,20 +526,37 @@ int unifyfs_fid_logio_write(int fid,
         return EINVAL;
     }
 
+    /* free sparsely used chunks before the log runs out of space */
+    if (client_reclaim_enabled()) {
+        compact_log_if_full();
+    }
+
     /* allocate space in the log for this write */
     off_t log_off;
     int rc = unifyfs_logio_alloc(logio_ctx, count, &log_off);
+    if ((rc == ENOSPC) && client_reclaim_log_space()) {
+        /* try again after releasing unreferenced log space */
+        rc = unifyfs_logio_alloc(logio_ctx, count, &log_off);
+    }
     if (rc != UNIFYFS_SUCCESS) {
         LOGERR("logio_alloc(%zu) failed", count);
         return rc;
     }
 
+    /* the allocation is referenced until we know how much was written */
+    client_reclaim_set_state(log_off, count, LOG_CHUNK_UNSYNCED);
+    client_reclaim_ref(log_off, count, 1);
+
     /* do the write */
     rc = unifyfs_logio_write(logio_ctx, log_off, count, buf, nwritten);
     if (rc != UNIFYFS_SUCCESS) {
         LOGERR("logio_write(%zu, %zu) failed", log_off, count);
+        client_reclaim_ref(log_off, count, 0);
         return rc;
     }
+    if (*nwritten < count) {
+        client_reclaim_ref(log_off + (off_t)(*nwritten), count - *nwritten, 0);
+    }
 
     if (*nwritten < count) {
         LOGWARN("partial logio_write() @ offset=%zu (%zu of %zu bytes)",
@@ -51,6 +51,16 @@ off_t unifyfs_rewrite_index_from_seg_tree(unifyfs_filemeta_t* meta);
 /* remove/truncate write extents in client metadata */
 int truncate_write_meta(unifyfs_filemeta_t* meta, off_t trunc_sz);
 
+/* release log space of write extents that were never synced */
+void release_write_meta(unifyfs_filemeta_t* meta);
+
+/* start tracking log chunks to reclaim log space of overwritten,
+ * truncated, and unlinked data */
+int unifyfs_logio_reclaim_init(long delay_usec);
+
+/* stop tracking log chunks */
+void unifyfs_logio_reclaim_fini(void);
+
 /* sync all writes for target file(s) with the server */
 int unifyfs_sync(int target_fid);
 
@@ -64,4 +74,13 @@ int unifyfs_fid_logio_write(
     size_t* nwritten          /* returns number of bytes written */
 );
 
+/* pass an access hint for the file range [pos, pos + len) to the log
+ * storage of the local data of the file */
+int unifyfs_fid_logio_advise(
+    unifyfs_filemeta_t* meta, /* meta data for file */
+    off_t pos,                /* file position of range start */
+    off_t len,                /* range length, or 0 for end of file */
+    int advice                /* one of logio_advice_e */
+);
+
 #endif /* UNIFYFS_FIXED_H */
@@ -103,7 +103,10 @@
 #include "unifyfs_log.h"
 #include "unifyfs_logio.h"
 #include "unifyfs_meta.h"
+#include "unifyfs_numa.h"
 #include "unifyfs_shm.h"
+#include "unifyfs_spillio.h"
+#include "unifyfs_trace.h"
 #include "seg_tree.h"
 
 // client headers
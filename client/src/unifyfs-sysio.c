@@ -43,6 +43,7 @@
 #include "unifyfs.h"
 #include "unifyfs-internal.h"
 #include "unifyfs-sysio.h"
+#include "unifyfs-fixed.h"
 #include "margo_client.h"
 #include "client_read.h"
 
@@ -1358,29 +1359,38 @@ int UNIFYFS_WRAP(posix_fadvise)(int fd, off_t offset, off_t len, int advice)
             return errno;
         }
 
+        if ((offset < 0) || (len < 0)) {
+            errno = EINVAL;
+            return errno;
+        }
+
         /* process advice from caller */
+        unifyfs_filemeta_t* meta;
         switch (advice) {
         case POSIX_FADV_NORMAL:
         case POSIX_FADV_SEQUENTIAL:
         /* can use this hint for a better compression strategy */
         case POSIX_FADV_RANDOM:
         case POSIX_FADV_NOREUSE:
+            break;
         case POSIX_FADV_WILLNEED:
-        /* with the spill-over case, we can use this hint to
-         * to better manage the in-memory parts of a file. On
-         * getting this advice, move the chunks that are on the
-         * spill-over device to the in-memory portion
-         */
+            /* with the spill-over case, move the chunks of the file data
+             * that are on the spill-over device to the in-memory portion */
+            meta = unifyfs_get_meta_from_fid(fid);
+            if (NULL != meta) {
+                unifyfs_fid_logio_advise(meta, offset, len,
+                                         LOGIO_ADVICE_WILLNEED);
+            }
+            break;
         case POSIX_FADV_DONTNEED:
             /* similar to the previous case, but move contents from memory
-             * to the spill-over device instead.
-             */
-
-            /* ERROR: fn not yet supported */
-            fprintf(stderr, "Function not yet supported @ %s:%d\n",
-                    __FILE__, __LINE__);
-            errno = ENOTSUP;
-            return errno;
+             * to the spill-over device instead */
+            meta = unifyfs_get_meta_from_fid(fid);
+            if (NULL != meta) {
+                unifyfs_fid_logio_advise(meta, offset, len,
+                                         LOGIO_ADVICE_DONTNEED);
+            }
+            break;
         default:
             /* this function returns the errno itself, not -1 */
             errno = EINVAL;
@@ -2161,7 +2171,10 @@ static int __chmod(int fid, mode_t mode)
     if ((meta->mode & 0222) &&
         (((meta->mode & 0222) & mode) == 0)) {
         /* We're laminating. */
-        ret = invoke_client_laminate_rpc(gfid);
+        uint64_t trace_id = unifyfs_trace_new_id();
+        uint64_t trace_start = unifyfs_trace_start();
+        ret = invoke_client_laminate_rpc(gfid, trace_id);
+        unifyfs_trace_end("client_laminate", trace_id, trace_start);
         if (ret) {
             LOGERR("laminate failed");
             errno = unifyfs_rc_errno(ret);
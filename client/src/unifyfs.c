@@ -567,7 +567,9 @@ static int fid_store_free(int fid)
     unifyfs_filemeta_t* meta = unifyfs_get_meta_from_fid(fid);
     if ((meta != NULL) && (meta->fid == fid)) {
         if (meta->storage == FILE_STORAGE_LOGIO) {
-            /* Free our write seg_tree */
+            /* Release log space of writes we never synced,
+             * and free our write seg_tree */
+            release_write_meta(meta);
             seg_tree_destroy(&meta->extents_sync);
 
             /* Free our extent seg_tree */
@@ -1776,6 +1778,15 @@ static int unifyfs_init(void)
         unifyfs_max_index_entries =
             unifyfs_index_buf_size / sizeof(unifyfs_index_t);
 
+        /* start recording request traces if enabled */
+        char trace_label[64];
+        snprintf(trace_label, sizeof(trace_label), "client %d:%d",
+                 unifyfs_app_id, unifyfs_client_id);
+        rc = unifyfs_trace_init(&client_cfg, trace_label);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("failed to initialize request tracing");
+        }
+
         /* record the max fd for the system */
         /* RLIMIT_NOFILE specifies a value one greater than the maximum
          * file descriptor number that can be opened by this process */
@@ -1839,6 +1850,12 @@ static int unifyfs_init(void)
             return UNIFYFS_FAILURE;
         }
 
+        /* find the NUMA nodes, so the log can be placed on ours */
+        rc = unifyfs_numa_init(&client_cfg);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGWARN("failed to initialize NUMA placement");
+        }
+
         /* initialize log-based I/O context */
         rc = unifyfs_logio_init_client(unifyfs_app_id, unifyfs_client_id,
                                        &client_cfg, &logio_ctx);
@@ -1848,6 +1865,39 @@ static int unifyfs_init(void)
             return rc;
         }
 
+        if (NULL != logio_ctx->spill_hdr) {
+            /* large writes to spill are split into concurrent pieces */
+            rc = unifyfs_spillio_init(&client_cfg);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to initialize asynchronous spill I/O");
+            }
+        }
+
+        /* Determine whether we reclaim log space of data that is
+         * overwritten, truncated, or unlinked */
+        bool reclaim = true;
+        cfgval = client_cfg.logio_reclaim;
+        if (cfgval != NULL) {
+            rc = configurator_bool_val(cfgval, &b);
+            if (rc == 0) {
+                reclaim = (bool)b;
+            }
+        }
+        if (reclaim) {
+            long delay = UNIFYFS_LOGIO_RECLAIM_DELAY;
+            cfgval = client_cfg.logio_reclaim_delay;
+            if (cfgval != NULL) {
+                rc = configurator_int_val(cfgval, &l);
+                if ((rc == 0) && (l >= 0)) {
+                    delay = l;
+                }
+            }
+            rc = unifyfs_logio_reclaim_init(delay);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to initialize log space reclaim");
+            }
+        }
+
         /* remember that we've now initialized the library */
         unifyfs_initialized = 1;
     }
@@ -1867,7 +1917,12 @@ static int unifyfs_finalize(void)
         return UNIFYFS_FAILURE;
     }
 
+    /* write request trace */
+    unifyfs_trace_fini();
+
     /* close spillover files */
+    unifyfs_logio_reclaim_fini();
+    unifyfs_spillio_fini();
     if (NULL != logio_ctx) {
         unifyfs_logio_close(logio_ctx, 0);
         logio_ctx = NULL;
@@ -2161,71 +2216,157 @@ enum {
     UNIFYFS_TX_PARALLEL = 1,
 };
 
+/* write count bytes of buf to fd at offset, retrying short writes,
+ * returns 0 or errno */
+static int tx_pwrite_all(int fd, const char* buf, size_t count, off_t offset)
+{
+    while (count > 0) {
+        ssize_t n = pwrite(fd, buf, count, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        buf += n;
+        count -= (size_t) n;
+        offset += (off_t) n;
+    }
+    return 0;
+}
+
+/* a read of one transfer buffer, run on a helper thread so that it
+ * overlaps with the write of the previous buffer */
+typedef struct {
+    int fd;           /* source file */
+    char* buf;        /* transfer buffer */
+    size_t len;       /* bytes to read */
+    off_t offset;     /* source file offset */
+    size_t nread;     /* bytes read, less than len at EOF */
+    int err;          /* errno of a failed read */
+} tx_read_t;
+
+static void* tx_read(void* arg)
+{
+    tx_read_t* rd = (tx_read_t*) arg;
+
+    rd->nread = 0;
+    rd->err = 0;
+    while (rd->nread < rd->len) {
+        ssize_t n = pread(rd->fd, rd->buf + rd->nread,
+                          rd->len - rd->nread,
+                          rd->offset + (off_t) rd->nread);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            rd->err = errno;
+            break;
+        } else if (n == 0) {  /* EOF */
+            break;
+        }
+        rd->nread += (size_t) n;
+    }
+
+    return NULL;
+}
+
+/* copy count bytes at offset of fd_src to the same offset of fd_dst.
+ * Transfers larger than one buffer use two, reading the next buffer
+ * while the current one is written. Returns 0 or errno */
 static
 ssize_t do_transfer_data(int fd_src, int fd_dst, off_t offset, size_t count)
 {
     ssize_t ret = 0;
-    off_t pos = 0;
-    ssize_t n_written = 0;
-    ssize_t n_left = 0;
-    ssize_t n_processed = 0;
+    int i = 0;
+    int cur = 0;
+    int n_bufs = 1;
+    size_t done = 0;
     size_t len = UNIFYFS_TX_BUFSIZE;
-    char* buf = NULL;
+    tx_read_t rd[2];
+    pthread_t reader;
 
-    buf = malloc(UNIFYFS_TX_BUFSIZE);
-    if (!buf) {
-        LOGERR("failed to allocate transfer buffer");
-        return ENOMEM;
+    if (0 == count) {
+        return 0;
     }
 
-    pos = lseek(fd_src, offset, SEEK_SET);
-    if (pos == (off_t) -1) {
-        LOGERR("lseek failed (%d: %s)\n", errno, strerror(errno));
-        ret = errno;
-        goto out;
+    /* small files, which are most of a typical manifest, do not need a
+     * whole transfer buffer */
+    if (count > UNIFYFS_TX_BUFSIZE) {
+        n_bufs = 2;
+    } else {
+        len = count;
     }
 
-    pos = lseek(fd_dst, offset, SEEK_SET);
-    if (pos == (off_t) -1) {
-        LOGERR("lseek failed (%d: %s)\n", errno, strerror(errno));
-        ret = errno;
-        goto out;
+    memset(rd, 0, sizeof(rd));
+    for (i = 0; i < n_bufs; i++) {
+        rd[i].fd = fd_src;
+        rd[i].buf = malloc(len);
+        if (!rd[i].buf) {
+            LOGERR("failed to allocate transfer buffer");
+            ret = ENOMEM;
+            goto out;
+        }
     }
 
-    while (count > n_processed) {
-        if (len > count) {
-            len = count;
-        }
+    rd[0].len = len;
+    rd[0].offset = offset;
+    tx_read(&rd[0]);
 
-        n_left = read(fd_src, buf, len);
+    while (1) {
+        tx_read_t* rd_cur = &rd[cur];
+        tx_read_t* rd_next = &rd[cur ^ 1];
+        int more = 0;
+        int reading = 0;
 
-        if (n_left == 0) {  /* EOF */
+        if (rd_cur->err) {
+            ret = rd_cur->err;
+            LOGERR("read failed (%d: %s)", (int) ret, strerror(ret));
             break;
-        } else if (n_left < 0) {   /* error */
-            ret = errno;
-            goto out;
+        }
+        done += rd_cur->nread;
+
+        /* a short read means we reached the end of the source */
+        if ((n_bufs == 2) && (done < count) &&
+            (rd_cur->nread == rd_cur->len)) {
+            more = 1;
+            rd_next->offset = offset + (off_t) done;
+            rd_next->len = count - done;
+            if (rd_next->len > UNIFYFS_TX_BUFSIZE) {
+                rd_next->len = UNIFYFS_TX_BUFSIZE;
+            }
+            if (0 == pthread_create(&reader, NULL, tx_read, rd_next)) {
+                reading = 1;
+            }
         }
 
-        do {
-            n_written = write(fd_dst, buf, n_left);
-
-            if (n_written < 0) {
-                ret = errno;
-                goto out;
-            } else if (n_written == 0 && errno && errno != EAGAIN) {
-                ret = errno;
-                goto out;
+        if (rd_cur->nread > 0) {
+            ret = tx_pwrite_all(fd_dst, rd_cur->buf, rd_cur->nread,
+                                rd_cur->offset);
+            if (ret) {
+                LOGERR("write failed (%d: %s)", (int) ret, strerror(ret));
             }
+        }
 
-            n_left -= n_written;
-            n_processed += n_written;
-        } while (n_left);
+        if (reading) {
+            pthread_join(reader, NULL);
+        }
+        if (ret || !more) {
+            break;
+        }
+        if (!reading) {
+            /* no helper thread, read the next buffer ourselves */
+            tx_read(rd_next);
+        }
+        cur ^= 1;
     }
 
 out:
-    if (buf) {
-        free(buf);
-        buf = NULL;
+    for (i = 0; i < n_bufs; i++) {
+        if (rd[i].buf) {
+            free(rd[i].buf);
+            rd[i].buf = NULL;
+        }
     }
 
     return ret;
@@ -2438,3 +2579,240 @@ int unifyfs_transfer_file(const char* src, const char* dst, int parallel)
     }
     return local_return_val;
 }
+
+int unifyfs_transfer_file_range(const char* src, const char* dst,
+                                off_t offset, size_t length)
+{
+    int ret = 0;
+    int fd_src = -1;
+    int fd_dst = -1;
+
+    fd_src = open(src, O_RDONLY);
+    if (fd_src < 0) {
+        LOGERR("failed to open file %s", src);
+        return -errno;
+    }
+
+    fd_dst = open(dst, O_WRONLY);
+    if (fd_dst < 0) {
+        LOGERR("failed to open file %s", dst);
+        ret = errno;
+        goto out_close_src;
+    }
+
+    LOGDBG("range transfer (%d/%d): offset=%lu, length=%lu",
+           client_rank, global_rank_cnt,
+           (unsigned long) offset, (unsigned long) length);
+
+    ret = do_transfer_data(fd_src, fd_dst, offset, length);
+    if (ret) {
+        LOGERR("failed to transfer data (ret=%d, %s)", ret, strerror(ret));
+    } else if (fsync(fd_dst)) {
+        ret = errno;
+    }
+
+    close(fd_dst);
+out_close_src:
+    close(fd_src);
+
+    return -ret;
+}
+
+/* copy path to abs_path, prefixed by the current working directory if
+ * it is relative, returns 0 or negative errno */
+static int get_absolute_path(const char* path,
+                             char* abs_path,
+                             size_t len)
+{
+    int ret;
+    if (path[0] == '/') {
+        ret = snprintf(abs_path, len, "%s", path);
+    } else {
+        char* cwd = getcwd(NULL, 0);
+        if (NULL == cwd) {
+            return -errno;
+        }
+        ret = snprintf(abs_path, len, "%s/%s", cwd, path);
+        free(cwd);
+    }
+    if ((ret < 0) || (ret >= (int) len)) {
+        return -ENAMETOOLONG;
+    }
+    return 0;
+}
+
+int unifyfs_transfer_file_direct(const char* src, const char* dst)
+{
+    int ret = 0;
+    int fd = -1;
+    struct stat sb_dst = { 0, };
+    char src_upath[UNIFYFS_MAX_FILENAME];
+    char dst_upath[UNIFYFS_MAX_FILENAME];
+    char dst_path[UNIFYFS_MAX_FILENAME] = { 0, };
+    char tmp_path[UNIFYFS_MAX_FILENAME];
+
+    /* servers can only stage out from unifyfs to another file system */
+    if (!unifyfs_intercept_path(src, src_upath) ||
+        unifyfs_intercept_path(dst, dst_upath)) {
+        return -EINVAL;
+    }
+
+    /* only laminated files can be staged out by the servers, check before
+     * touching the destination */
+    int gfid = unifyfs_generate_gfid(src_upath);
+    unifyfs_file_attr_t gfattr = { 0, };
+    ret = unifyfs_get_global_file_meta(gfid, &gfattr);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get attributes of %s", src);
+        return -unifyfs_rc_errno(ret);
+    }
+    if (NULL != gfattr.filename) {
+        free(gfattr.filename);
+    }
+    if (!gfattr.is_laminated) {
+        LOGERR("direct transfer of %s requires a laminated file", src);
+        return -EINVAL;
+    }
+
+    /* the servers do not share our working directory */
+    ret = get_absolute_path(dst, dst_path, sizeof(dst_path));
+    if (ret) {
+        return ret;
+    }
+
+    ret = stat(dst_path, &sb_dst);
+    if ((ret == 0) && S_ISDIR(sb_dst.st_mode)) {
+        char* src_copy = strdup(src);
+        if (NULL == src_copy) {
+            return -ENOMEM;
+        }
+        size_t len = strlen(dst_path);
+        ret = snprintf(dst_path + len, sizeof(dst_path) - len, "/%s",
+                       basename(src_copy));
+        free(src_copy);
+        if ((ret < 0) || (ret >= (int)(sizeof(dst_path) - len))) {
+            return -ENAMETOOLONG;
+        }
+    }
+
+    /* the servers write into a temporary file next to the destination,
+     * which replaces the destination only once every server succeeded */
+    ret = snprintf(tmp_path, sizeof(tmp_path), "%s.unifyfs.%d",
+                   dst_path, (int) getpid());
+    if ((ret < 0) || (ret >= (int) sizeof(tmp_path))) {
+        return -ENAMETOOLONG;
+    }
+
+    /* create the temporary file with its final size, the servers only
+     * write the data they hold */
+    fd = open(tmp_path, O_CREAT | O_EXCL | O_WRONLY, 0644);
+    if (fd < 0) {
+        ret = -errno;
+        LOGERR("failed to create file %s", tmp_path);
+        return ret;
+    }
+    ret = ftruncate(fd, (off_t) gfattr.size);
+    if (ret < 0) {
+        ret = -errno;
+        close(fd);
+        unlink(tmp_path);
+        return ret;
+    }
+    close(fd);
+
+    LOGDBG("direct transfer: src=%s, dst=%s, length=%lu",
+           src, dst_path, (unsigned long) gfattr.size);
+
+    ret = invoke_client_transfer_rpc(gfid, tmp_path);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("direct transfer of %s failed (%s)",
+               src, unifyfs_rc_enum_description(ret));
+        unlink(tmp_path);
+        return -unifyfs_rc_errno(ret);
+    }
+
+    if (rename(tmp_path, dst_path) < 0) {
+        ret = -errno;
+        LOGERR("failed to rename %s to %s", tmp_path, dst_path);
+        unlink(tmp_path);
+        return ret;
+    }
+
+    return 0;
+}
+
+int unifyfs_transfer_file_lazy(const char* src, const char* dst)
+{
+    int ret = 0;
+    struct stat sb_src = { 0, };
+    struct stat sb_dst = { 0, };
+    char src_upath[UNIFYFS_MAX_FILENAME];
+    char dst_upath[UNIFYFS_MAX_FILENAME];
+    char src_path[UNIFYFS_MAX_FILENAME] = { 0, };
+
+    /* servers can only read through from another file system */
+    if (unifyfs_intercept_path(src, src_upath) ||
+        !unifyfs_intercept_path(dst, dst_upath)) {
+        return -EINVAL;
+    }
+
+    ret = stat(src, &sb_src);
+    if (ret < 0) {
+        return -errno;
+    }
+    if (!S_ISREG(sb_src.st_mode)) {
+        return -EINVAL;
+    }
+
+    /* the servers do not share our working directory */
+    ret = get_absolute_path(src, src_path, sizeof(src_path));
+    if (ret) {
+        return ret;
+    }
+
+    ret = UNIFYFS_WRAP(stat)(dst, &sb_dst);
+    if ((ret == 0) && S_ISDIR(sb_dst.st_mode)) {
+        char* src_copy = strdup(src);
+        if (NULL == src_copy) {
+            return -ENOMEM;
+        }
+        size_t len = strlen(dst_upath);
+        ret = snprintf(dst_upath + len, sizeof(dst_upath) - len, "/%s",
+                       basename(src_copy));
+        free(src_copy);
+        if ((ret < 0) || (ret >= (int)(sizeof(dst_upath) - len))) {
+            return -ENAMETOOLONG;
+        }
+        ret = UNIFYFS_WRAP(stat)(dst_upath, &sb_dst);
+    }
+    if (ret == 0) {
+        return -EEXIST;
+    }
+
+    /* the file is laminated from the start, with the size and times of
+     * the backing file */
+    unifyfs_file_attr_t fattr;
+    memset(&fattr, 0, sizeof(fattr));
+    fattr.filename     = dst_upath;
+    fattr.gfid         = unifyfs_generate_gfid(dst_upath);
+    fattr.is_laminated = 1;
+    fattr.mode         = S_IFREG | (sb_src.st_mode & 0777 & ~0222);
+    fattr.uid          = getuid();
+    fattr.gid          = getgid();
+    fattr.size         = (uint64_t) sb_src.st_size;
+    fattr.atime        = sb_src.st_atim;
+    fattr.mtime        = sb_src.st_mtim;
+    fattr.ctime        = sb_src.st_ctim;
+
+    LOGDBG("lazy transfer: src=%s, dst=%s, length=%lu",
+           src_path, dst_upath, (unsigned long) sb_src.st_size);
+
+    ret = invoke_client_readthrough_rpc(&fattr, src_path);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("read-through registration of %s failed (%s)",
+               dst_upath, unifyfs_rc_enum_description(ret));
+        return -unifyfs_rc_errno(ret);
+    }
+
+    return 0;
+}
@@ -16,6 +16,7 @@
 #define UNIFYFS_H
 
 #include <stddef.h>
+#include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,50 @@ int unifyfs_transfer_file_parallel(const char* src, const char* dst)
     return unifyfs_transfer_file(src, dst, 1);
 }
 
+/**
+ * @brief copy @length bytes at @offset of @src to the same offset of @dst,
+ * which must already exist. This lets processes split the transfer of a
+ * file, with each copying a different range. @dst is not laminated.
+ *
+ * @param src source file path
+ * @param dst destination file path
+ * @param offset file offset of the range
+ * @param length length of the range in bytes
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int unifyfs_transfer_file_range(const char* src, const char* dst,
+                                off_t offset, size_t length);
+
+/**
+ * @brief stage out a laminated unifyfs file by having every server write
+ * the file data it holds directly to @dst, so no data passes through the
+ * calling process. @src should specify a unifyfs pathname and @dst a
+ * pathname in a file system shared by all servers. Only one process
+ * should call this for each file.
+ *
+ * @param src source file path in unifyfs
+ * @param dst destination file path
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int unifyfs_transfer_file_direct(const char* src, const char* dst);
+
+/**
+ * @brief stage in a file without copying its data. @dst is created as a
+ * laminated unifyfs file with the size of @src, and its data is read from
+ * @src by the unifyfs servers the first time it is needed. @src should
+ * specify a pathname in a file system shared by all servers, which must
+ * not change while @dst exists, and @dst a unifyfs pathname. Only one
+ * process should call this for each file.
+ *
+ * @param src source file path
+ * @param dst destination file path in unifyfs
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int unifyfs_transfer_file_lazy(const char* src, const char* dst);
+
 
 #ifdef __cplusplus
 } // extern "C"
@@ -32,6 +32,8 @@ UNIFYFS_COMMON_BASE_SRCS = \
   %reldir%/unifyfs_meta.c \
   %reldir%/unifyfs_misc.c \
   %reldir%/unifyfs_misc.h \
+  %reldir%/unifyfs_numa.h \
+  %reldir%/unifyfs_numa.c \
   %reldir%/unifyfs_rpc_util.h \
   %reldir%/unifyfs_rpc_util.c \
   %reldir%/unifyfs_rpc_types.h \
@@ -41,6 +43,10 @@ UNIFYFS_COMMON_BASE_SRCS = \
   %reldir%/unifyfs_rc.c \
   %reldir%/unifyfs_shm.h \
   %reldir%/unifyfs_shm.c \
+  %reldir%/unifyfs_spillio.h \
+  %reldir%/unifyfs_spillio.c \
+  %reldir%/unifyfs_trace.h \
+  %reldir%/unifyfs_trace.c \
   %reldir%/unifyfs-stack.h \
   %reldir%/unifyfs-stack.c
 
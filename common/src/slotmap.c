@@ -303,6 +303,67 @@ ssize_t slotmap_reserve(slot_map* smap,
     return (ssize_t)-1;
 }
 
+/**
+ * Reserve the given consecutive slots in the slot_map.
+ *
+ * @param smap valid slot_map pointer
+ * @param start_index starting slot index
+ * @param num_slots number of slots to reserve
+ *
+ * @return start_index, or -1 if any of the slots is used
+ */
+ssize_t slotmap_reserve_at(slot_map* smap,
+                           size_t start_index,
+                           size_t num_slots)
+{
+    if ((NULL == smap) || (0 == num_slots) ||
+        ((start_index + num_slots) > smap->total_slots)) {
+        return (ssize_t)-1;
+    }
+
+    uint8_t* usemap = get_use_map(smap);
+    for (size_t i = 0; i < num_slots; i++) {
+        if (check_slot(usemap, start_index + i)) {
+            return (ssize_t)-1;
+        }
+    }
+
+    for (size_t i = 0; i < num_slots; i++) {
+        use_slot(usemap, start_index + i);
+    }
+    smap->used_slots += num_slots;
+    return (ssize_t)start_index;
+}
+
+/**
+ * Get the high-water mark of the slot_map.
+ *
+ * @param smap valid slot_map pointer
+ *
+ * @return slot index just past the highest used slot, or 0 if none are used
+ */
+size_t slotmap_high_water(slot_map* smap)
+{
+    if ((NULL == smap) || (0 == smap->used_slots)) {
+        return 0;
+    }
+
+    uint8_t* usemap = get_use_map(smap);
+    size_t byte_ndx = slot_map_bytes(smap->total_slots);
+    while (byte_ndx > 0) {
+        byte_ndx--;
+        uint8_t byte_val = usemap[byte_ndx];
+        if (byte_val != 0) {
+            for (int bit = 7; bit >= 0; bit--) {
+                if (BYTE_VAL_BIT(byte_val, bit)) {
+                    return BYTE_BIT_TO_SLOT(byte_ndx, bit) + 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
 /**
  * Release consecutive slots in the slot_map.
  *
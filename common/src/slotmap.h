@@ -68,6 +68,24 @@ int slotmap_clear(slot_map* smap);
 ssize_t slotmap_reserve(slot_map* smap,
                         size_t num_slots);
 
+/**
+ * Reserve the given consecutive slots in the slot_map.
+ * @param smap valid slot_map pointer
+ * @param start_index starting slot index
+ * @param num_slots number of slots to reserve
+ * @return start_index, or -1 if any of the slots is used
+ */
+ssize_t slotmap_reserve_at(slot_map* smap,
+                           size_t start_index,
+                           size_t num_slots);
+
+/**
+ * Get the high-water mark of the slot_map.
+ * @param smap valid slot_map pointer
+ * @return slot index just past the highest used slot, or 0 if none are used
+ */
+size_t slotmap_high_water(slot_map* smap);
+
 /**
  * Release consecutive slots in the slot_map.
  *
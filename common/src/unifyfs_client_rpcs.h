@@ -34,13 +34,16 @@ extern "C" {
 typedef enum {
     UNIFYFS_CLIENT_RPC_INVALID = 0,
     UNIFYFS_CLIENT_RPC_ATTACH,
+    UNIFYFS_CLIENT_RPC_COMPACT,
     UNIFYFS_CLIENT_RPC_FILESIZE,
     UNIFYFS_CLIENT_RPC_LAMINATE,
     UNIFYFS_CLIENT_RPC_METAGET,
     UNIFYFS_CLIENT_RPC_METASET,
     UNIFYFS_CLIENT_RPC_MOUNT,
     UNIFYFS_CLIENT_RPC_READ,
+    UNIFYFS_CLIENT_RPC_READTHROUGH,
     UNIFYFS_CLIENT_RPC_SYNC,
+    UNIFYFS_CLIENT_RPC_TRANSFER,
     UNIFYFS_CLIENT_RPC_TRUNCATE,
     UNIFYFS_CLIENT_RPC_UNLINK,
     UNIFYFS_CLIENT_RPC_UNMOUNT
@@ -113,12 +116,19 @@ DECLARE_MARGO_RPC_HANDLER(unifyfs_metaget_rpc)
  *
  * given a client identified by (app_id, client_id) as input, read the write
  * extents for one or more of the client's files from the shared memory index
- * and update the global metadata for the file(s) */
+ * and update the global metadata for the file(s). trace_id is nonzero when
+ * the request is traced. Returns the bytes of the client's log that are
+ * no longer referenced and may be reclaimed, and the bytes of log space
+ * the client should reserve for compaction of its log (zero if none) */
 MERCURY_GEN_PROC(unifyfs_fsync_in_t,
                  ((int32_t)(app_id))
                  ((int32_t)(client_id))
-                 ((int32_t)(gfid)))
-MERCURY_GEN_PROC(unifyfs_fsync_out_t, ((int32_t)(ret)))
+                 ((int32_t)(gfid))
+                 ((uint64_t)(trace_id)))
+MERCURY_GEN_PROC(unifyfs_fsync_out_t,
+                 ((int32_t)(ret))
+                 ((hg_size_t)(reclaimable))
+                 ((hg_size_t)(compactable)))
 DECLARE_MARGO_RPC_HANDLER(unifyfs_fsync_rpc)
 
 /* unifyfs_filesize_rpc (client => server)
@@ -166,11 +176,86 @@ DECLARE_MARGO_RPC_HANDLER(unifyfs_unlink_rpc)
 MERCURY_GEN_PROC(unifyfs_laminate_in_t,
                  ((int32_t)(app_id))
                  ((int32_t)(client_id))
-                 ((int32_t)(gfid)))
+                 ((int32_t)(gfid))
+                 ((uint64_t)(trace_id)))
 MERCURY_GEN_PROC(unifyfs_laminate_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(unifyfs_laminate_rpc)
 
+/* unifyfs_transfer_rpc (client => server)
+ *
+ * given a global file id of a laminated file, have every server write
+ * the file data it holds to the destination file */
+MERCURY_GEN_PROC(unifyfs_transfer_in_t,
+                 ((int32_t)(app_id))
+                 ((int32_t)(client_id))
+                 ((int32_t)(gfid))
+                 ((hg_const_string_t)(dst_file)))
+MERCURY_GEN_PROC(unifyfs_transfer_out_t,
+                 ((int32_t)(ret)))
+DECLARE_MARGO_RPC_HANDLER(unifyfs_transfer_rpc)
+
+/* unifyfs_readthrough_rpc (client => server)
+ *
+ * given the attributes of a new file and the path of a backing file,
+ * register the file on every server, with its data to be read from the
+ * backing file on demand */
+MERCURY_GEN_PROC(unifyfs_readthrough_in_t,
+                 ((int32_t)(app_id))
+                 ((int32_t)(client_id))
+                 ((unifyfs_file_attr_t)(attr))
+                 ((hg_const_string_t)(backing_file)))
+MERCURY_GEN_PROC(unifyfs_readthrough_out_t,
+                 ((int32_t)(ret)))
+DECLARE_MARGO_RPC_HANDLER(unifyfs_readthrough_rpc)
+
+/* unifyfs_stats_rpc (client => server)
+ *
+ * get server statistics as JSON, from the local server only or from
+ * all servers when all is set */
+MERCURY_GEN_PROC(unifyfs_stats_in_t,
+                 ((int32_t)(all)))
+MERCURY_GEN_PROC(unifyfs_stats_out_t,
+                 ((int32_t)(ret))
+                 ((hg_const_string_t)(json)))
+DECLARE_MARGO_RPC_HANDLER(unifyfs_stats_rpc)
+
+/* unifyfs_reclaim_rpc (client => server)
+ *
+ * given a client identified by (app_id, client_id) and a bulk buffer
+ * for an array of uint64_t log chunk indices, fill the buffer with the
+ * chunks of the client's log that are no longer referenced and are ready
+ * to be released by the client. Returns the number of chunks and the
+ * bytes of unreferenced chunks that are not yet ready */
+MERCURY_GEN_PROC(unifyfs_reclaim_in_t,
+                 ((int32_t)(app_id))
+                 ((int32_t)(client_id))
+                 ((hg_size_t)(bulk_size))
+                 ((hg_bulk_t)(bulk_chunks)))
+MERCURY_GEN_PROC(unifyfs_reclaim_out_t,
+                 ((int32_t)(ret))
+                 ((hg_size_t)(num_chunks))
+                 ((hg_size_t)(reclaimable)))
+DECLARE_MARGO_RPC_HANDLER(unifyfs_reclaim_rpc)
+
+/* unifyfs_compact_rpc (client => server)
+ *
+ * given a client identified by (app_id, client_id) and a range of log
+ * space the client reserved for compaction, move live data of sparsely
+ * used chunks of the client's log into the range. Returns the bytes of
+ * the range holding moved data, which the client must keep, and the
+ * bytes of data now referenced at the new location */
+MERCURY_GEN_PROC(unifyfs_compact_in_t,
+                 ((int32_t)(app_id))
+                 ((int32_t)(client_id))
+                 ((hg_size_t)(log_offset))
+                 ((hg_size_t)(length)))
+MERCURY_GEN_PROC(unifyfs_compact_out_t,
+                 ((int32_t)(ret))
+                 ((hg_size_t)(used))
+                 ((hg_size_t)(moved)))
+DECLARE_MARGO_RPC_HANDLER(unifyfs_compact_rpc)
+
 /* unifyfs_mread_rpc (client => server)
  *
  * given mread (mread_id, app_id, client_id) and count of read requests,
@@ -181,6 +266,7 @@ MERCURY_GEN_PROC(unifyfs_mread_in_t,
                  ((int32_t)(app_id))
                  ((int32_t)(client_id))
                  ((int32_t)(read_count))
+                 ((uint64_t)(trace_id))
                  ((hg_size_t)(bulk_size))
                  ((hg_bulk_t)(bulk_extents)))
 MERCURY_GEN_PROC(unifyfs_mread_out_t, ((int32_t)(ret)))
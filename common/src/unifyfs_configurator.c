@@ -1033,3 +1033,28 @@ int configurator_directory_check(const char *s,
             return errno; // invalid
     }
 }
+
+int configurator_directory_list_check(const char *s,
+                                      const char *k,
+                                      const char *val,
+                                      char **o)
+{
+    int rc = 0;
+    char *list, *dir, *saveptr;
+
+    if (val == NULL)
+        return 0;
+
+    // check each directory of a colon-separated list
+    list = strdup(val);
+    if (list == NULL)
+        return ENOMEM;
+    for (dir = strtok_r(list, ":", &saveptr); dir != NULL;
+         dir = strtok_r(NULL, ":", &saveptr)) {
+        rc = configurator_directory_check(s, k, dir, o);
+        if (rc != 0)
+            break;
+    }
+    free(list);
+    return rc;
+}
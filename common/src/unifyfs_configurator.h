@@ -79,20 +79,49 @@
     UNIFYFS_CFG_CLI(log, file, STRING, unifyfsd.log, "log file name", NULL, 'l', "specify log file name") \
     UNIFYFS_CFG_CLI(log, dir, STRING, LOGDIR, "log file directory", configurator_directory_check, 'L', "specify full path to directory to contain log file") \
     UNIFYFS_CFG(log, on_error, BOOL, off, "turn on verbose logging when an error is encountered", NULL) \
+    UNIFYFS_CFG(log, async, BOOL, on, "write log messages from a background thread", NULL) \
     UNIFYFS_CFG(logio, chunk_size, INT, UNIFYFS_LOGIO_CHUNK_SIZE, "log-based I/O data chunk size", NULL) \
+    UNIFYFS_CFG(logio, compact_threshold, INT, UNIFYFS_LOGIO_COMPACT_THRESHOLD, "compact log chunks holding less than this percent of live data (0 disables)", NULL) \
+    UNIFYFS_CFG(logio, numa, BOOL, on, "place log shared memory and the server threads copying it on the client NUMA node", NULL) \
+    UNIFYFS_CFG(logio, reclaim, BOOL, on, "reclaim log space of overwritten, truncated, and unlinked data", NULL) \
+    UNIFYFS_CFG(logio, reclaim_delay, INT, UNIFYFS_LOGIO_RECLAIM_DELAY, "usecs to wait before releasing unreferenced log chunks", NULL) \
     UNIFYFS_CFG(logio, shmem_size, INT, UNIFYFS_LOGIO_SHMEM_SIZE, "log-based I/O shared memory region size", NULL) \
     UNIFYFS_CFG(logio, spill_size, INT, UNIFYFS_LOGIO_SPILL_SIZE, "log-based I/O spillover file size", NULL) \
-    UNIFYFS_CFG(logio, spill_dir, STRING, NULLSTRING, "spillover directory", configurator_directory_check) \
+    UNIFYFS_CFG(logio, spill_dir, STRING, NULLSTRING, "spillover directory, or colon-separated list of directories to stripe spillover data across", configurator_directory_list_check) \
+    UNIFYFS_CFG(logio, spill_io_depth, INT, UNIFYFS_SPILLIO_DEPTH, "spillover file reads and writes in flight per thread (0 disables)", NULL) \
+    UNIFYFS_CFG(logio, spill_io_threads, INT, UNIFYFS_SPILLIO_THREADS, "spillover I/O threads used without io_uring", NULL) \
+    UNIFYFS_CFG(logio, spill_io_uring, BOOL, on, "use io_uring for spillover file I/O when available", NULL) \
+    UNIFYFS_CFG(logio, spill_odirect, BOOL, off, "use O_DIRECT for spillover file data", NULL) \
+    UNIFYFS_CFG(logio, tier_free_pct, INT, UNIFYFS_LOGIO_TIER_FREE_PCT, "percent of shmem chunks to keep free by moving cold chunks to spillover", NULL) \
+    UNIFYFS_CFG(logio, tier_interval, INT, UNIFYFS_LOGIO_TIER_INTERVAL, "usecs between passes of the chunk tiering thread", NULL) \
+    UNIFYFS_CFG(logio, tiering, BOOL, on, "move log chunks between shmem and spillover based on use", NULL) \
+    UNIFYFS_CFG(margo, bcast_degree, INT, UNIFYFS_BCAST_SMALL_DEGREE, "k-ary broadcast tree degree for small messages", NULL) \
+    UNIFYFS_CFG(margo, bcast_large_degree, INT, UNIFYFS_BCAST_LARGE_DEGREE, "k-ary broadcast tree degree for large messages", NULL) \
+    UNIFYFS_CFG(margo, bcast_large_size, INT, UNIFYFS_BCAST_LARGE_SIZE, "minimum payload size of large broadcast messages", NULL) \
+    UNIFYFS_CFG(margo, bcast_large_tree, STRING, kary, "broadcast tree type for large messages (kary|binomial)", NULL) \
+    UNIFYFS_CFG(margo, bcast_tree, STRING, kary, "broadcast tree type for small messages (kary|binomial)", NULL) \
+    UNIFYFS_CFG(margo, client_pool_size, INT, UNIFYFS_MARGO_CLIENT_POOL_SIZE, "default handler threads for client rpcs", NULL) \
+    UNIFYFS_CFG(margo, coll_pool_size, INT, UNIFYFS_MARGO_COLL_POOL_SIZE, "handler threads for server broadcast rpcs (0 uses default pools)", NULL) \
+    UNIFYFS_CFG(margo, data_pool_size, INT, UNIFYFS_MARGO_DATA_POOL_SIZE, "handler threads for data read rpcs (0 uses default pools)", NULL) \
+    UNIFYFS_CFG(margo, io_pool_size, INT, UNIFYFS_MARGO_IO_POOL_SIZE, "threads for i/o on backing files (0 uses default pools)", NULL) \
+    UNIFYFS_CFG(margo, meta_pool_size, INT, UNIFYFS_MARGO_META_POOL_SIZE, "handler threads for metadata rpcs (0 uses default pools)", NULL) \
+    UNIFYFS_CFG(margo, server_pool_size, INT, UNIFYFS_MARGO_SERVER_POOL_SIZE, "default handler threads for server rpcs", NULL) \
     UNIFYFS_CFG(margo, tcp, BOOL, on, "use TCP for server-to-server margo RPCs", NULL) \
     UNIFYFS_CFG(meta, db_name, STRING, META_DEFAULT_DB_NAME, "metadata database name", NULL) \
     UNIFYFS_CFG(meta, db_path, STRING, RUNDIR, "metadata database path", configurator_directory_check) \
     UNIFYFS_CFG(meta, server_ratio, INT, META_DEFAULT_SERVER_RATIO, "metadata server ratio", NULL) \
     UNIFYFS_CFG(meta, range_size, INT, META_DEFAULT_RANGE_SZ, "metadata range size", NULL) \
+    UNIFYFS_CFG(meta, stripe_extents, BOOL, off, "partition file extent metadata across servers by offset range", NULL) \
+    UNIFYFS_CFG(meta, sync_batch_extents, INT, UNIFYFS_META_SYNC_BATCH_EXTENTS, "maximum number of extents batched in one owner update", NULL) \
+    UNIFYFS_CFG(meta, sync_batch_usec, INT, UNIFYFS_META_SYNC_BATCH_USEC, "time (usecs) to batch client syncs before updating file owner", NULL) \
     UNIFYFS_CFG_CLI(runstate, dir, STRING, RUNDIR, "runstate file directory", configurator_directory_check, 'R', "specify full path to directory to contain server-local state") \
     UNIFYFS_CFG_CLI(server, hostfile, STRING, NULLSTRING, "server hostfile name", NULL, 'H', "specify full path to server hostfile") \
     UNIFYFS_CFG_CLI(server, init_timeout, INT, UNIFYFS_DEFAULT_INIT_TIMEOUT, "timeout of waiting for server initialization", NULL, 't', "timeout in seconds to wait for servers to be ready for clients") \
     UNIFYFS_CFG(server, max_app_clients, INT, MAX_APP_CLIENTS, "maximum number of clients per application", NULL) \
+    UNIFYFS_CFG(server, stats_interval, INT, UNIFYFS_STATS_INTERVAL, "interval (seconds) between server stats dumps (0 disables)", NULL) \
     UNIFYFS_CFG_CLI(sharedfs, dir, STRING, NULLSTRING, "shared file system directory", configurator_directory_check, 'S', "specify full path to directory to contain server shared files") \
+    UNIFYFS_CFG(trace, dir, STRING, NULLSTRING, "request trace file directory (tracing disabled when unset)", configurator_directory_check) \
+    UNIFYFS_CFG(trace, max_events, INT, UNIFYFS_TRACE_MAX_EVENTS, "maximum number of trace events recorded per process", NULL) \
 
 #ifdef __cplusplus
 extern "C" {
@@ -207,6 +236,11 @@ int configurator_directory_check(const char *section,
                                  const char *val,
                                  char **oval);
 
+int configurator_directory_list_check(const char *section,
+                                      const char *key,
+                                      const char *val,
+                                      char **oval);
+
 
 #ifdef __cplusplus
 } /* extern C */
@@ -62,7 +62,26 @@
 #define MAX_APP_CLIENTS 256        /* max # clients per application */
 #define MIN_USLEEP_INTERVAL 50     /* unit: us */
 #define UNIFYFS_DEFAULT_INIT_TIMEOUT 120 /* server init timeout (seconds) */
+#define UNIFYFS_BCAST_SMALL_DEGREE 8     /* bcast tree degree, small msgs */
+#define UNIFYFS_BCAST_LARGE_DEGREE 2     /* bcast tree degree, large msgs */
+#define UNIFYFS_BCAST_LARGE_SIZE (64 * KIB) /* min size of large bcast msgs */
+#define UNIFYFS_BCAST_SEGMENT_SIZE MIB   /* laminate bcast segment size */
+#define UNIFYFS_BCAST_SEGMENT_WINDOW 4   /* min laminate segments in flight */
+#define UNIFYFS_MARGO_CLIENT_POOL_SIZE 4 /* client rpc handler threads */
+#define UNIFYFS_MARGO_SERVER_POOL_SIZE 4 /* server rpc handler threads */
+#define UNIFYFS_MARGO_META_POOL_SIZE 2   /* metadata rpc handler threads */
+#define UNIFYFS_MARGO_DATA_POOL_SIZE 0   /* data rpc handler threads */
+#define UNIFYFS_MARGO_COLL_POOL_SIZE 2   /* broadcast rpc handler threads */
+#define UNIFYFS_MARGO_IO_POOL_SIZE 4     /* backing file i/o threads */
+#define UNIFYFS_META_SYNC_BATCH_USEC 200 /* sync batch window (usecs) */
+#define UNIFYFS_META_SYNC_BATCH_EXTENTS (64 * KIB) /* max sync batch size */
+#define UNIFYFS_TRANSFER_BUF_SIZE (16 * MIB) /* stage-out read buffer */
+#define UNIFYFS_TRANSFER_MAX_READS 1024     /* stage-out log reads in batch */
+#define UNIFYFS_READTHROUGH_BLOCK_SIZE MIB  /* read-through fetch unit */
+#define UNIFYFS_STATS_INTERVAL 0         /* stats dump interval (seconds) */
+#define UNIFYFS_TRACE_MAX_EVENTS MIB     /* max trace events per process */
 #define UNIFYFSD_PID_FILENAME "unifyfsd.pids"
+#define UNIFYFSD_STATS_FILENAME "unifyfsd-stats.json"
 #define UNIFYFS_STAGE_STATUS_FILENAME "unifyfs-stage.status"
 
 // Client
@@ -72,12 +91,24 @@
 #define UNIFYFS_CLIENT_WRITE_INDEX_SIZE (20 * MIB)
 #define UNIFYFS_CLIENT_MAX_READ_COUNT KIB      /* max # active read requests */
 #define UNIFYFS_CLIENT_READ_TIMEOUT_SECONDS 60
+#define UNIFYFS_CLIENT_READ_STALE_RETRIES 3    /* re-issues of stale reads */
 #define UNIFYFS_CLIENT_MAX_ACTIVE_REQUESTS 64  /* max concurrent client reqs */
+#define UNIFYFS_CLIENT_COMPACT_LOG_USAGE 75    /* log % used to compact at */
 
 // Log-based I/O
 #define UNIFYFS_LOGIO_CHUNK_SIZE (4 * MIB)
 #define UNIFYFS_LOGIO_SHMEM_SIZE (256 * MIB)
 #define UNIFYFS_LOGIO_SPILL_SIZE (GIB)
+#define UNIFYFS_LOGIO_MAX_SPILL_DIRS 16     /* spill files striped across */
+#define UNIFYFS_LOGIO_RECLAIM_DELAY 500000  /* usecs to hold dead chunks */
+#define UNIFYFS_LOGIO_COMPACT_THRESHOLD 25  /* % live data of sparse chunks */
+#define UNIFYFS_LOGIO_COMPACT_MAX_CHUNKS 16 /* chunks filled per compaction */
+#define UNIFYFS_LOGIO_TIER_FREE_PCT 10      /* percent of shmem kept free */
+#define UNIFYFS_LOGIO_TIER_INTERVAL 100000  /* usecs between tiering passes */
+#define UNIFYFS_LOGIO_TIER_HOT_HITS 4       /* reads to promote spill chunk */
+#define UNIFYFS_SPILLIO_DEPTH 32            /* spill I/O requests in flight */
+#define UNIFYFS_SPILLIO_THREADS 8           /* spill I/O threads w/o io_uring */
+#define UNIFYFS_NUMA_MIN_COPY (256 * KIB)   /* chunk read bytes to move for */
 
 /* NOTE: max read size = UNIFYFS_MAX_SPLIT_CNT * META_DEFAULT_RANGE_SZ */
 #define UNIFYFS_MAX_SPLIT_CNT (4 * KIB)
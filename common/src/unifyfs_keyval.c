@@ -29,7 +29,9 @@
 #include <dirent.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -475,6 +477,58 @@ static int unifyfs_pmix_fence(void)
     return rc;
 }
 
+// lookup the rank-specific key of every rank in a single PMIx_Lookup,
+// leaves the value of any rank not found as NULL
+static int unifyfs_pmix_lookup_all(const char* key,
+                                   char** ovals)
+{
+    int rc, r, wait;
+    size_t ndir;
+    pmix_data_range_t range;
+    pmix_info_t* directives;
+    pmix_pdata_t* pdata;
+    char pmix_key[PMIX_MAX_KEYLEN+1];
+
+    if (!pmix_initialized) {
+        return (int)UNIFYFS_ERROR_PMI;
+    }
+
+    /* set keys to lookup */
+    PMIX_PDATA_CREATE(pdata, kv_nranks);
+    for (r = 0; r < kv_nranks; r++) {
+        snprintf(pmix_key, sizeof(pmix_key), "%d.%s", r, key);
+        PMIX_PDATA_LOAD(&pdata[r], &pmix_myproc, pmix_key, NULL,
+                        PMIX_STRING);
+    }
+
+    /* modify lookup behavior */
+    wait = 1;
+    ndir = 2;
+    range = PMIX_RANGE_GLOBAL;
+    PMIX_INFO_CREATE(directives, ndir);
+    PMIX_INFO_LOAD(&directives[0], PMIX_RANGE, &range, PMIX_DATA_RANGE);
+    PMIX_INFO_LOAD(&directives[1], PMIX_WAIT, &wait, PMIX_INT);
+
+    /* try lookup */
+    rc = PMIx_Lookup(pdata, (size_t)kv_nranks, directives, ndir);
+    if (rc != PMIX_SUCCESS) {
+        LOGERR("PMIx rank %d: PMIx_Lookup(*.%s) failed: %s",
+               pmix_myproc.rank, key, PMIx_Error_string(rc));
+        rc = (int)UNIFYFS_ERROR_PMI;
+    } else {
+        for (r = 0; r < kv_nranks; r++) {
+            if (pdata[r].value.data.string != NULL) {
+                ovals[r] = strdup(pdata[r].value.data.string);
+            }
+        }
+        rc = (int)UNIFYFS_SUCCESS;
+    }
+    /* cleanup */
+    PMIX_PDATA_FREE(pdata, kv_nranks);
+    PMIX_INFO_FREE(directives, ndir);
+    return rc;
+}
+
 #endif // USE_PMIX
 
 
@@ -484,6 +538,150 @@ static char localfs_kvdir[UNIFYFS_MAX_FILENAME];
 static char sharedfs_kvdir[UNIFYFS_MAX_FILENAME];
 static char sharedfs_rank_kvdir[UNIFYFS_MAX_FILENAME];
 static int have_sharedfs_kvstore; // = 0
+static int fskv_fence_count;      // = 0
+static char fskv_run_nonce[64];   // identifies this run in marker names
+
+// fan-in/fan-out degree of the sharedfs fence tree
+#define UNIFYFS_FSKV_FENCE_DEGREE 8
+
+// bounds on the delay between polls for fence marker files
+#define UNIFYFS_FSKV_FENCE_MIN_USEC 1000
+#define UNIFYFS_FSKV_FENCE_MAX_USEC 100000
+
+// seconds between warnings while waiting on a fence marker
+#define UNIFYFS_FSKV_FENCE_WARN_SECS 60
+
+// seconds to wait on a fence marker before giving up
+#define UNIFYFS_FSKV_FENCE_TIMEOUT_SECS 900
+
+// prefix of fence marker file names
+#define UNIFYFS_FSKV_FENCE_PREFIX "fence."
+
+// name of the file in which rank 0 publishes its fallback nonce
+#define UNIFYFS_FSKV_NONCE_FILE UNIFYFS_FSKV_FENCE_PREFIX "nonce"
+
+// seconds a fallback nonce may predate the start of a rank and still be
+// taken as one of this run, allowing for servers launched at different
+// times and for clock differences between nodes
+#define UNIFYFS_FSKV_NONCE_SKEW_SECS 300
+
+// share a nonce derived from the start time and pid of rank 0 with all
+// ranks through a file in the rank 0 kvstore directory. a clean exit
+// removes the file, and a file left by a crashed run is told apart by
+// its time, so the other ranks poll until rank 0 has replaced it
+static int unifyfs_fskv_bcast_nonce(void)
+{
+    FILE* kvf;
+    char nfile[UNIFYFS_MAX_FILENAME];
+    unsigned long nonce_time = 0;
+    unsigned long nonce_pid = 0;
+    time_t start = time(NULL);
+
+    if (0 == kv_myrank) {
+        char tmpfile[UNIFYFS_MAX_FILENAME];
+        scnprintf(fskv_run_nonce, sizeof(fskv_run_nonce), "%lx-%lx",
+                  (unsigned long) start, (unsigned long) getpid());
+        scnprintf(nfile, sizeof(nfile), "%s/%s",
+                  sharedfs_rank_kvdir, UNIFYFS_FSKV_NONCE_FILE);
+        scnprintf(tmpfile, sizeof(tmpfile), "%s.tmp", nfile);
+        kvf = fopen(tmpfile, "w");
+        if (NULL == kvf) {
+            LOGERR("failed to create nonce file %s", tmpfile);
+            return (int)UNIFYFS_ERROR_KEYVAL;
+        }
+        fprintf(kvf, "%s\n", fskv_run_nonce);
+        if (0 != fclose(kvf)) {
+            LOGERR("failed to write nonce file %s", tmpfile);
+            return (int)UNIFYFS_ERROR_KEYVAL;
+        }
+        if (0 != rename(tmpfile, nfile)) {
+            LOGERR("failed to rename nonce file %s - %s",
+                   tmpfile, strerror(errno));
+            return (int)UNIFYFS_ERROR_KEYVAL;
+        }
+        return (int)UNIFYFS_SUCCESS;
+    }
+
+    scnprintf(nfile, sizeof(nfile), "%s/0/%s",
+              sharedfs_kvdir, UNIFYFS_FSKV_NONCE_FILE);
+    useconds_t delay = UNIFYFS_FSKV_FENCE_MIN_USEC;
+    while (1) {
+        kvf = fopen(nfile, "r");
+        if (NULL != kvf) {
+            int n = fscanf(kvf, "%lx-%lx", &nonce_time, &nonce_pid);
+            fclose(kvf);
+            if ((2 == n) &&
+                ((time_t) nonce_time + UNIFYFS_FSKV_NONCE_SKEW_SECS >= start)) {
+                break;
+            }
+        }
+
+        time_t now = time(NULL);
+        if ((now - start) >= UNIFYFS_FSKV_FENCE_TIMEOUT_SECS) {
+            LOGERR("timed out waiting on nonce file %s after %d seconds",
+                   nfile, (int)(now - start));
+            return (int)UNIFYFS_ERROR_TIMEOUT;
+        }
+        usleep(delay);
+        delay *= 2;
+        if (delay > UNIFYFS_FSKV_FENCE_MAX_USEC) {
+            delay = UNIFYFS_FSKV_FENCE_MAX_USEC;
+        }
+    }
+    scnprintf(fskv_run_nonce, sizeof(fskv_run_nonce), "%lx-%lx",
+              nonce_time, nonce_pid);
+    return (int)UNIFYFS_SUCCESS;
+}
+
+// set the nonce that makes marker names unique to this run, so that a
+// marker left by a previous run is never taken for one of ours. all
+// servers of a run read the same hostfile, which is rewritten for each
+// run, so its modification time serves. without one, use the job id,
+// and without that, the nonce rank 0 shares
+static int unifyfs_fskv_set_nonce(unifyfs_cfg_t* cfg)
+{
+    struct stat s;
+    const char* jobid_vars[] = {
+        "SLURM_JOB_ID", "LSB_JOBID", "PBS_JOBID", "FLUX_JOB_ID", NULL
+    };
+
+    if ((NULL != cfg->server_hostfile) &&
+        (0 == stat(cfg->server_hostfile, &s))) {
+        scnprintf(fskv_run_nonce, sizeof(fskv_run_nonce), "%lx-%lx",
+                  (unsigned long) s.st_mtim.tv_sec,
+                  (unsigned long) s.st_mtim.tv_nsec);
+        return (int)UNIFYFS_SUCCESS;
+    }
+    for (int i = 0; NULL != jobid_vars[i]; i++) {
+        const char* jobid = getenv(jobid_vars[i]);
+        if ((NULL != jobid) && (NULL == strchr(jobid, '/'))) {
+            scnprintf(fskv_run_nonce, sizeof(fskv_run_nonce), "%s", jobid);
+            return (int)UNIFYFS_SUCCESS;
+        }
+    }
+    return unifyfs_fskv_bcast_nonce();
+}
+
+// remove stale fence markers left in a rank kvstore directory
+static void unifyfs_fskv_fence_cleanup(void)
+{
+    struct dirent* de;
+    char marker[UNIFYFS_MAX_FILENAME];
+    size_t prefix_len = strlen(UNIFYFS_FSKV_FENCE_PREFIX);
+
+    DIR* rkv = opendir(sharedfs_rank_kvdir);
+    if (NULL == rkv) {
+        return;
+    }
+    while (NULL != (de = readdir(rkv))) {
+        if (0 == strncmp(de->d_name, UNIFYFS_FSKV_FENCE_PREFIX, prefix_len)) {
+            scnprintf(marker, sizeof(marker), "%s/%s",
+                      sharedfs_rank_kvdir, de->d_name);
+            remove(marker);
+        }
+    }
+    closedir(rkv);
+}
 
 static int unifyfs_fskv_init(unifyfs_cfg_t* cfg)
 {
@@ -558,6 +756,13 @@ static int unifyfs_fskv_init(unifyfs_cfg_t* cfg)
             }
         }
         have_sharedfs_kvstore = 1;
+
+        // a previous run may have left fence markers behind
+        unifyfs_fskv_fence_cleanup();
+        rc = unifyfs_fskv_set_nonce(cfg);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
     }
 
     kv_max_keylen = UNIFYFS_MAX_KV_KEYLEN;
@@ -785,8 +990,72 @@ static int unifyfs_fskv_publish_remote(const char* key,
     return (int)UNIFYFS_SUCCESS;
 }
 
+// create the named fence marker in my rank kvstore directory
+static int unifyfs_fskv_fence_mark(const char* name)
+{
+    FILE* kvf;
+    char marker[UNIFYFS_MAX_FILENAME];
+
+    scnprintf(marker, sizeof(marker), "%s/%s",
+              sharedfs_rank_kvdir, name);
+    kvf = fopen(marker, "w");
+    if (NULL == kvf) {
+        LOGERR("failed to create fence marker %s", marker);
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+    fclose(kvf);
+
+    return (int)UNIFYFS_SUCCESS;
+}
+
+// wait for the named fence marker to appear in the given rank's kvstore
+// directory, polling with exponential backoff. gives up after
+// UNIFYFS_FSKV_FENCE_TIMEOUT_SECS, as when the rank has died
+static int unifyfs_fskv_fence_wait(int rank,
+                                   const char* name)
+{
+    struct stat s;
+    char marker[UNIFYFS_MAX_FILENAME];
+    useconds_t delay = UNIFYFS_FSKV_FENCE_MIN_USEC;
+    time_t start = time(NULL);
+    time_t last_warn = start;
+
+    scnprintf(marker, sizeof(marker), "%s/%d/%s",
+              sharedfs_kvdir, rank, name);
+    while (0 != stat(marker, &s)) {
+        usleep(delay);
+        delay *= 2;
+        if (delay > UNIFYFS_FSKV_FENCE_MAX_USEC) {
+            delay = UNIFYFS_FSKV_FENCE_MAX_USEC;
+        }
+
+        time_t now = time(NULL);
+        if ((now - start) >= UNIFYFS_FSKV_FENCE_TIMEOUT_SECS) {
+            LOGERR("timed out waiting on fence marker %s after %d seconds",
+                   marker, (int)(now - start));
+            return (int)UNIFYFS_ERROR_TIMEOUT;
+        }
+        if ((now - last_warn) >= UNIFYFS_FSKV_FENCE_WARN_SECS) {
+            LOGWARN("still waiting on fence marker %s after %d seconds",
+                    marker, (int)(now - start));
+            last_warn = now;
+        }
+    }
+    return (int)UNIFYFS_SUCCESS;
+}
+
+// barrier across all servers using marker files in the sharedfs kvstore.
+// ranks form a tree of degree UNIFYFS_FSKV_FENCE_DEGREE. each rank waits
+// for its children to arrive before marking its own arrival, and once the
+// root has arrived, the release propagates back down the tree. a rank only
+// ever polls the markers of its parent and children, so no rank has to
+// scan the directories of all other ranks
 static int unifyfs_fskv_fence(void)
 {
+    int rc, i;
+    char arrive[128];
+    char release[128];
+
     if (!have_sharedfs_kvstore) {
         return (int)UNIFYFS_ERROR_KEYVAL;
     }
@@ -795,12 +1064,187 @@ static int unifyfs_fskv_fence(void)
         return (int)UNIFYFS_SUCCESS;
     }
 
-    // TODO - use a file as a counting semaphore??
-    sleep(10);
+    // marker names are unique to each fence of this run
+    int fence_id = fskv_fence_count++;
+    scnprintf(arrive, sizeof(arrive), "%s%s.arrive.%d",
+              UNIFYFS_FSKV_FENCE_PREFIX, fskv_run_nonce, fence_id);
+    scnprintf(release, sizeof(release), "%s%s.release.%d",
+              UNIFYFS_FSKV_FENCE_PREFIX, fskv_run_nonce, fence_id);
+
+    int first_child = (kv_myrank * UNIFYFS_FSKV_FENCE_DEGREE) + 1;
+    int last_child = first_child + UNIFYFS_FSKV_FENCE_DEGREE - 1;
+    if (last_child >= kv_nranks) {
+        last_child = kv_nranks - 1;
+    }
+
+    // gather arrivals up the tree
+    for (i = first_child; i <= last_child; i++) {
+        rc = unifyfs_fskv_fence_wait(i, arrive);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
+    }
+    rc = unifyfs_fskv_fence_mark(arrive);
+    if (rc != (int)UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    // wait for release from parent, then release my children
+    if (kv_myrank != 0) {
+        int parent = (kv_myrank - 1) / UNIFYFS_FSKV_FENCE_DEGREE;
+        rc = unifyfs_fskv_fence_wait(parent, release);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
+    }
+    if (first_child < kv_nranks) {
+        rc = unifyfs_fskv_fence_mark(release);
+    }
+
+    return rc;
+}
+
+// write all known rank values to the named gather file in my rank kvstore
+// directory. the file is renamed into place once complete, so a reader
+// that finds it always sees its full contents
+static int unifyfs_fskv_gather_write(const char* name,
+                                     char** vals)
+{
+    int r;
+    FILE* kvf;
+    char gfile[UNIFYFS_MAX_FILENAME];
+    char tmpfile[UNIFYFS_MAX_FILENAME];
+
+    scnprintf(gfile, sizeof(gfile), "%s/%s",
+              sharedfs_rank_kvdir, name);
+    scnprintf(tmpfile, sizeof(tmpfile), "%s.tmp", gfile);
+    kvf = fopen(tmpfile, "w");
+    if (NULL == kvf) {
+        LOGERR("failed to create gather file %s", tmpfile);
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+    for (r = 0; r < kv_nranks; r++) {
+        if (NULL != vals[r]) {
+            fprintf(kvf, "%d %s\n", r, vals[r]);
+        }
+    }
+    if (0 != fclose(kvf)) {
+        LOGERR("failed to write gather file %s", tmpfile);
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+    if (0 != rename(tmpfile, gfile)) {
+        LOGERR("failed to rename gather file %s - %s",
+               tmpfile, strerror(errno));
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+    return (int)UNIFYFS_SUCCESS;
+}
+
+// wait for the named gather file of the given rank, then merge its
+// rank values into vals
+static int unifyfs_fskv_gather_read(int rank,
+                                    const char* name,
+                                    char** vals)
+{
+    int r;
+    FILE* kvf;
+    char gfile[UNIFYFS_MAX_FILENAME];
+    char kvalue[kv_max_vallen];
+
+    int rc = unifyfs_fskv_fence_wait(rank, name);
+    if (rc != (int)UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    scnprintf(gfile, sizeof(gfile), "%s/%d/%s",
+              sharedfs_kvdir, rank, name);
+    kvf = fopen(gfile, "r");
+    if (NULL == kvf) {
+        LOGERR("failed to open gather file %s", gfile);
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+    // bound the value field by the size of kvalue
+    char fmt[32];
+    scnprintf(fmt, sizeof(fmt), "%%d %%%zus\n", sizeof(kvalue) - 1);
+    memset(kvalue, 0, sizeof(kvalue));
+    while (2 == fscanf(kvf, fmt, &r, kvalue)) {
+        if ((r >= 0) && (r < kv_nranks) && (NULL == vals[r])) {
+            vals[r] = strdup(kvalue);
+        }
+    }
+    fclose(kvf);
 
     return (int)UNIFYFS_SUCCESS;
 }
 
+// gather the values every rank published for key using the same tree as
+// unifyfs_fskv_fence(). each rank merges the subtree files of its children
+// with its own value and writes its subtree file for its parent. the full
+// table is then passed back down the tree. every rank opens at most
+// DEGREE + 2 files rather than one file per rank, and the gather also
+// acts as a fence
+static int unifyfs_fskv_gather(const char* key,
+                               char** vals)
+{
+    int rc, i;
+    char up[128];
+    char down[128];
+
+    if (!have_sharedfs_kvstore) {
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+
+    rc = unifyfs_fskv_lookup_remote(kv_myrank, key, &vals[kv_myrank]);
+    if (rc != (int)UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    if (1 == kv_nranks) {
+        return (int)UNIFYFS_SUCCESS;
+    }
+
+    // file names are unique to each fence or gather of this run
+    int gather_id = fskv_fence_count++;
+    scnprintf(up, sizeof(up), "%s%s.gather-up.%d",
+              UNIFYFS_FSKV_FENCE_PREFIX, fskv_run_nonce, gather_id);
+    scnprintf(down, sizeof(down), "%s%s.gather-down.%d",
+              UNIFYFS_FSKV_FENCE_PREFIX, fskv_run_nonce, gather_id);
+
+    int first_child = (kv_myrank * UNIFYFS_FSKV_FENCE_DEGREE) + 1;
+    int last_child = first_child + UNIFYFS_FSKV_FENCE_DEGREE - 1;
+    if (last_child >= kv_nranks) {
+        last_child = kv_nranks - 1;
+    }
+
+    // gather subtree values up the tree
+    for (i = first_child; i <= last_child; i++) {
+        rc = unifyfs_fskv_gather_read(i, up, vals);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
+    }
+    if (kv_myrank != 0) {
+        rc = unifyfs_fskv_gather_write(up, vals);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
+
+        // get the full table from my parent
+        int parent = (kv_myrank - 1) / UNIFYFS_FSKV_FENCE_DEGREE;
+        rc = unifyfs_fskv_gather_read(parent, down, vals);
+        if (rc != (int)UNIFYFS_SUCCESS) {
+            return rc;
+        }
+    }
+
+    // pass the full table down to my children
+    if (first_child < kv_nranks) {
+        rc = unifyfs_fskv_gather_write(down, vals);
+    }
+
+    return rc;
+}
+
 //--------------------- K-V Store API ---------------------
 
 // Initialize key-value store
@@ -1053,6 +1497,9 @@ int unifyfs_keyval_publish_remote(const char* key,
 int unifyfs_keyval_fence_remote(void)
 {
     int rc;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
 #if defined(USE_PMIX)
     rc = unifyfs_pmix_fence();
 #elif defined(USE_PMI2)
@@ -1060,5 +1507,82 @@ int unifyfs_keyval_fence_remote(void)
 #else
     rc = unifyfs_fskv_fence();
 #endif
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double secs = (double)(end.tv_sec - start.tv_sec) +
+                  ((double)(end.tv_nsec - start.tv_nsec) / 1.0e9);
+    LOGINFO("keyval fence across %d servers took %.3f seconds (rc=%d)",
+            kv_nranks, secs, rc);
     return rc;
 }
+
+// Gather the values of a key published by all servers
+int unifyfs_keyval_gather_remote(const char* key,
+                                 int* ocount,
+                                 char*** ovals)
+{
+    int rc, r;
+
+    if ((NULL == key) || (NULL == ocount) || (NULL == ovals)) {
+        LOGERR("NULL parameter");
+        return EINVAL;
+    }
+
+    if (!kv_initialized) {
+        return (int)UNIFYFS_ERROR_KEYVAL;
+    }
+
+    char** vals = (char**) calloc((size_t)kv_nranks, sizeof(char*));
+    if (NULL == vals) {
+        return ENOMEM;
+    }
+
+#if defined(USE_PMIX) || defined(USE_PMI2)
+    rc = unifyfs_keyval_fence_remote();
+    if (rc == (int)UNIFYFS_SUCCESS) {
+# if defined(USE_PMIX)
+        unifyfs_pmix_lookup_all(key, vals);
+# else
+        char rank_key[kv_max_keylen];
+        for (r = 0; r < kv_nranks; r++) {
+            snprintf(rank_key, sizeof(rank_key), "%d.%s", r, key);
+            unifyfs_pmi2_lookup(rank_key, &vals[r]);
+        }
+# endif
+        // fall back to the sharedfs kvstore for any rank not found
+        for (r = 0; r < kv_nranks; r++) {
+            if (NULL == vals[r]) {
+                rc = unifyfs_fskv_lookup_remote(r, key, &vals[r]);
+                if (rc != (int)UNIFYFS_SUCCESS) {
+                    break;
+                }
+            }
+        }
+    }
+#else
+    rc = unifyfs_fskv_gather(key, vals);
+#endif
+
+    if (rc == (int)UNIFYFS_SUCCESS) {
+        for (r = 0; r < kv_nranks; r++) {
+            if (NULL == vals[r]) {
+                LOGERR("no value for '%s' from rank %d", key, r);
+                rc = (int)UNIFYFS_ERROR_KEYVAL;
+                break;
+            }
+        }
+    }
+
+    if (rc != (int)UNIFYFS_SUCCESS) {
+        LOGERR("remote keyval gather for '%s' failed", key);
+        for (r = 0; r < kv_nranks; r++) {
+            free(vals[r]);
+        }
+        free(vals);
+        return rc;
+    }
+
+    *ocount = kv_nranks;
+    *ovals = vals;
+    return (int)UNIFYFS_SUCCESS;
+}
@@ -55,6 +55,13 @@ int unifyfs_keyval_lookup_remote(int rank,
 // block until a particular key-value pair published by all servers
 int unifyfs_keyval_fence_remote(void);
 
+// gather the values of a key published by all servers into an array
+// indexed by rank (collective, includes a fence). on success, *ovals is
+// an allocated array of *ocount allocated strings
+int unifyfs_keyval_gather_remote(const char* key,
+                                 int* ocount,
+                                 char*** ovals);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
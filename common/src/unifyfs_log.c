@@ -31,6 +31,11 @@
 #include "unifyfs_log.h"
 
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -45,6 +50,9 @@ int unifyfs_log_on_error; // = 0
 /* pointer to log file stream */
 FILE* unifyfs_log_stream; // = NULL
 
+/* set while the background log writer is running */
+int unifyfs_log_async; // = 0
+
 /* used within LOG macro to build a timestamp */
 time_t unifyfs_log_time;
 struct tm* unifyfs_log_ltime;
@@ -88,34 +96,679 @@ int unifyfs_log_open(const char* file)
 
 static const char* null_func = "?func?";
 
+/* write a message to the log stream, without flushing */
+static void log_write(const char* timestamp,
+                      pid_t tid,
+                      const char* srcfile,
+                      int lineno,
+                      const char* function,
+                      const char* msg)
+{
+    const char* file = srcfile;
+    const char* func = function;
+    if (NULL != file) {
+        file += unifyfs_log_source_base_len;
+    }
+    if (NULL == func) {
+        func = null_func;
+    }
+    fprintf(unifyfs_log_stream, "%s tid=%ld @ %s() [%s:%d] %s\n",
+            timestamp, (long)tid, func, file, lineno, msg);
+}
+
+/* format a message time with microseconds */
+static void log_timestamp(const struct timespec* now,
+                          char* buf,
+                          size_t size)
+{
+    struct tm log_ltime;
+    localtime_r(&(now->tv_sec), &log_ltime);
+    size_t len = strftime(buf, size, "%Y-%m-%dT%H:%M:%S", &log_ltime);
+    snprintf(buf + len, size - len, ".%06u",
+             (unsigned int)(now->tv_nsec / 1000) % 1000000);
+}
+
 /* print a message to the log with given time and source context */
-void unifyfs_log_print(time_t now,
+void unifyfs_log_print(const struct timespec* now,
                        const char* srcfile,
                        int lineno,
                        const char* function,
                        char* msg)
 {
     char timestamp[64] = {0};
-    struct tm* log_ltime = localtime(&now);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", log_ltime);
+    log_timestamp(now, timestamp, sizeof(timestamp));
 
-    char* file = (char*)srcfile;
-    char* func = (char*)function;
-    if (NULL != file) {
-        file += unifyfs_log_source_base_len;
+    log_write(timestamp, unifyfs_gettid(), srcfile, lineno, function, msg);
+    fflush(unifyfs_log_stream);
+}
+
+/*
+ * Asynchronous logging.
+ *
+ * Each thread that logs a message gets its own ring buffer, holding
+ * variable-size records of formatted messages. The thread is the only
+ * producer for its ring and the background writer thread is the only
+ * consumer, so records are added and removed without locks by advancing
+ * the ring head and tail with atomic operations, and the writer does all
+ * of the stdio work. When a ring is full, the message is dropped and
+ * counted rather than blocking the logging thread, and the writer reports
+ * the drops in the log.
+ *
+ * Every record takes a global sequence number, and the writer merges the
+ * rings in sequence order, so messages appear in the order they were
+ * logged across threads. While adding a record, a thread marks its ring
+ * busy from before it takes the sequence number until the record is
+ * published, which lets the writer wait for records numbered below the
+ * last number it saw before writing any of them. The wait is bounded by
+ * LOG_ORDER_SPINS, so the order across threads is approximate: a thread
+ * descheduled while adding a record may have it written after records
+ * that other threads logged later. Messages of one thread always appear
+ * in the order they were logged.
+ *
+ * The writer sleeps on a condition variable while the rings are empty,
+ * and is woken by the next message. Error messages are written before
+ * LOGERR() returns, and queued messages are written at exit and when the
+ * process gets a fatal signal, so the messages that explain a failure are
+ * not lost with it. The signal handler formats records itself and writes
+ * them with write(2), since stdio is not async-signal-safe, so its
+ * timestamps are seconds since the epoch rather than local time.
+ *
+ * Rings are kept on a list that only grows. When a thread exits, its ring
+ * is released for reuse by a later thread once the writer has drained it.
+ */
+
+#define LOG_RING_SIZE (128 * 1024)    /* bytes per ring, power of two */
+#define LOG_MSG_MAX 4096              /* max message size, with NUL */
+#define LOG_ORDER_SPINS 1000          /* max waits for a record being added */
+#define LOG_ALIGN(sz) (((sz) + 7) & ~((size_t)7))
+
+typedef struct {
+    unsigned long seq;                /* message order across threads */
+    struct timespec now;              /* message time */
+    const char* srcfile;              /* source file */
+    const char* function;             /* source function */
+    int lineno;                       /* source line */
+    int len;                          /* message size, -1 to skip to start */
+} log_record;                         /* followed by the message */
+
+typedef struct log_ring {
+    struct log_ring* next;            /* next ring on list of all rings */
+    int owned;                        /* set while a thread owns the ring */
+    int busy;                         /* set while a record is added */
+    pid_t tid;                        /* owning thread id */
+    unsigned long head;               /* next byte to add (owner) */
+    unsigned long tail;               /* next byte to write (writer) */
+    unsigned long dropped;            /* messages dropped when full */
+    unsigned long reported;           /* drops reported by the writer */
+    char buf[LOG_RING_SIZE] __attribute__((aligned(8)));
+} log_ring;
+
+static log_ring* log_rings; // = NULL
+static __thread log_ring* thread_ring; // = NULL
+static pthread_key_t log_ring_key;
+static pthread_once_t log_ring_key_once = PTHREAD_ONCE_INIT;
+static unsigned long log_seq;         /* next message sequence number */
+static unsigned long log_written;     /* messages written by drains */
+
+/* set while a drain consumes records, either under log_drain_lock or
+ * from the fatal signal handler, which cannot take the lock */
+static int log_draining; // = 0
+
+/* log stream descriptor, for writing from the fatal signal handler */
+static int log_fatal_fd = -1;
+
+/* held to write queued messages */
+static pthread_mutex_t log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* the writer waits on log_wait_cond while the rings are empty */
+static pthread_t log_writer;
+static pthread_mutex_t log_wait_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wait_cond = PTHREAD_COND_INITIALIZER;
+static int log_writer_idle; // = 0
+static int log_writer_exit; // = 0
+
+/* signals for which queued messages are written before the process dies */
+static const int log_fatal_signals[] = {
+    SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGSEGV
+};
+#define LOG_NUM_FATAL_SIGNALS \
+    (sizeof(log_fatal_signals) / sizeof(log_fatal_signals[0]))
+static struct sigaction log_fatal_prev[LOG_NUM_FATAL_SIGNALS];
+
+/* release a thread's ring on thread exit */
+static void log_ring_release(void* arg)
+{
+    log_ring* ring = (log_ring*) arg;
+    __atomic_store_n(&(ring->owned), 0, __ATOMIC_RELEASE);
+}
+
+static void log_ring_key_create(void)
+{
+    pthread_key_create(&log_ring_key, log_ring_release);
+}
+
+/* get the calling thread's ring, reusing a drained ring released by
+ * an exited thread or adding a new one to the list */
+static log_ring* log_ring_get(void)
+{
+    if (NULL != thread_ring) {
+        return thread_ring;
     }
-    if (NULL == func) {
-        func = (char*) null_func;
+
+    log_ring* ring;
+    for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE);
+         NULL != ring; ring = ring->next) {
+        int unowned = 0;
+        if (__atomic_compare_exchange_n(&(ring->owned), &unowned, 1, 0,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+            if (__atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE) ==
+                ring->head) {
+                break;
+            }
+            /* not yet drained, leave it for later */
+            __atomic_store_n(&(ring->owned), 0, __ATOMIC_RELEASE);
+        }
     }
-    fprintf(unifyfs_log_stream, "%s tid=%ld @ %s() [%s:%d] %s\n",
-            timestamp, (long)unifyfs_gettid(), func, file, lineno, msg);
+
+    if (NULL == ring) {
+        ring = (log_ring*) calloc(1, sizeof(log_ring));
+        if (NULL == ring) {
+            return NULL;
+        }
+        ring->owned = 1;
+        ring->next = __atomic_load_n(&log_rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&log_rings, &(ring->next), ring,
+                                            1, __ATOMIC_RELEASE,
+                                            __ATOMIC_RELAXED)) {
+        }
+    }
+
+    ring->tid = unifyfs_gettid();
+    pthread_setspecific(log_ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+/* add a message of len bytes (with NUL) to the ring,
+ * returns zero if the ring is full */
+static int log_ring_add(log_ring* ring,
+                        const struct timespec* now,
+                        const char* srcfile,
+                        int lineno,
+                        const char* function,
+                        const char* msg,
+                        size_t len)
+{
+    /* only this thread advances the head, the writer advances the tail */
+    size_t size = LOG_ALIGN(sizeof(log_record) + len);
+    unsigned long head = ring->head;
+    unsigned long tail = __atomic_load_n(&(ring->tail), __ATOMIC_ACQUIRE);
+    size_t off = head & (LOG_RING_SIZE - 1);
+    size_t rem = LOG_RING_SIZE - off;
+    size_t need = (rem < size) ? (rem + size) : size;
+    if (((head - tail) + need) > LOG_RING_SIZE) {
+        return 0;
+    }
+
+    if (rem < size) {
+        /* the record does not fit before the end, skip to the start */
+        if (rem >= sizeof(log_record)) {
+            ((log_record*)(ring->buf + off))->len = -1;
+        }
+        head += rem;
+        off = 0;
+    }
+
+    __atomic_store_n(&(ring->busy), 1, __ATOMIC_SEQ_CST);
+    log_record* rec = (log_record*)(ring->buf + off);
+    rec->seq = __atomic_fetch_add(&log_seq, 1, __ATOMIC_SEQ_CST);
+    rec->now = *now;
+    rec->srcfile = srcfile;
+    rec->function = function;
+    rec->lineno = lineno;
+    rec->len = (int) len;
+    memcpy(rec + 1, msg, len);
+
+    /* publish the record to the writer */
+    __atomic_store_n(&(ring->head), head + size, __ATOMIC_RELEASE);
+    __atomic_store_n(&(ring->busy), 0, __ATOMIC_RELEASE);
+    return 1;
+}
+
+/* get the next record to write from the ring, or NULL if it is empty.
+ * Only called by the drain. */
+static log_record* log_ring_next(log_ring* ring)
+{
+    unsigned long head = __atomic_load_n(&(ring->head), __ATOMIC_ACQUIRE);
+    while (ring->tail != head) {
+        size_t off = ring->tail & (LOG_RING_SIZE - 1);
+        size_t rem = LOG_RING_SIZE - off;
+        log_record* rec = (log_record*)(ring->buf + off);
+        if ((rem >= sizeof(log_record)) && (rec->len >= 0)) {
+            return rec;
+        }
+        /* skip the unused end of the ring */
+        __atomic_store_n(&(ring->tail), ring->tail + rem, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* get the lowest numbered queued record below limit, and its ring,
+ * or NULL if there is none */
+static log_record* log_next_record(unsigned long limit,
+                                   log_ring** min_ring)
+{
+    log_record* min_rec = NULL;
+    for (log_ring* ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE);
+         NULL != ring; ring = ring->next) {
+        log_record* rec = log_ring_next(ring);
+        if ((NULL != rec) && ((long)(rec->seq - limit) < 0) &&
+            ((NULL == min_rec) || ((long)(rec->seq - min_rec->seq) < 0))) {
+            *min_ring = ring;
+            min_rec = rec;
+        }
+    }
+    return min_rec;
+}
+
+/* free the space of a written record */
+static void log_record_done(log_ring* ring,
+                            log_record* rec)
+{
+    size_t size = LOG_ALIGN(sizeof(log_record) + (size_t)rec->len);
+    __atomic_store_n(&(ring->tail), ring->tail + size, __ATOMIC_RELEASE);
+}
+
+/* write queued messages of all rings in the order they were logged,
+ * returns number written. Called with log_drain_lock held. First waits
+ * briefly for messages that are being added. */
+static size_t log_drain(void)
+{
+    static time_t last_sec = (time_t) -1;
+    static char seconds[32];
+    char timestamp[64] = {0};
+    size_t count = 0;
+    log_ring* ring;
+
+    /* the fatal signal handler may be draining in another thread */
+    int idle = 0;
+    while (!__atomic_compare_exchange_n(&log_draining, &idle, 1, 0,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+        idle = 0;
+        sched_yield();
+    }
+
+    /* wait for records numbered below limit to be published */
+    unsigned long limit = __atomic_load_n(&log_seq, __ATOMIC_SEQ_CST);
+    for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE);
+         NULL != ring; ring = ring->next) {
+        for (int i = 0; (i < LOG_ORDER_SPINS) &&
+             __atomic_load_n(&(ring->busy), __ATOMIC_SEQ_CST); i++) {
+            sched_yield();
+        }
+    }
+
+    for (;;) {
+        /* find the lowest numbered record below the limit */
+        log_ring* min_ring = NULL;
+        log_record* min_rec = log_next_record(limit, &min_ring);
+        if (NULL == min_rec) {
+            break;
+        }
+
+        if (min_rec->now.tv_sec != last_sec) {
+            struct tm log_ltime;
+            localtime_r(&(min_rec->now.tv_sec), &log_ltime);
+            strftime(seconds, sizeof(seconds), "%Y-%m-%dT%H:%M:%S",
+                     &log_ltime);
+            last_sec = min_rec->now.tv_sec;
+        }
+        snprintf(timestamp, sizeof(timestamp), "%s.%06u", seconds,
+                 (unsigned int)(min_rec->now.tv_nsec / 1000) % 1000000);
+        log_write(timestamp, min_ring->tid, min_rec->srcfile,
+                  min_rec->lineno, min_rec->function,
+                  (const char*)(min_rec + 1));
+        count++;
+
+        /* free the space as soon as possible */
+        log_record_done(min_ring, min_rec);
+    }
+    __atomic_store_n(&log_written, log_written + count, __ATOMIC_SEQ_CST);
+
+    for (ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE);
+         NULL != ring; ring = ring->next) {
+        unsigned long dropped = __atomic_load_n(&(ring->dropped),
+                                                __ATOMIC_RELAXED);
+        if (dropped != ring->reported) {
+            if ('\0' == timestamp[0]) {
+                struct timespec now;
+                clock_gettime(CLOCK_REALTIME, &now);
+                log_timestamp(&now, timestamp, sizeof(timestamp));
+            }
+            fprintf(unifyfs_log_stream,
+                    "%s tid=%ld dropped %lu log messages (ring full)\n",
+                    timestamp, (long)ring->tid, dropped - ring->reported);
+            ring->reported = dropped;
+            count++;
+        }
+    }
+
+    if (count) {
+        fflush(unifyfs_log_stream);
+    }
+    __atomic_store_n(&log_draining, 0, __ATOMIC_RELEASE);
+    return count;
+}
+
+/* append a string to the signal handler's line buffer */
+static size_t log_fatal_str(char* buf,
+                            size_t off,
+                            size_t size,
+                            const char* str)
+{
+    while ((off < size) && ('\0' != *str)) {
+        buf[off++] = *str++;
+    }
+    return off;
+}
+
+/* append an unsigned number, zero-padded to width digits, to the signal
+ * handler's line buffer */
+static size_t log_fatal_num(char* buf,
+                            size_t off,
+                            size_t size,
+                            unsigned long num,
+                            int width)
+{
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + (num % 10));
+        num /= 10;
+    } while ((num > 0) && (n < (int)sizeof(digits)));
+    while (n < width) {
+        digits[n++] = '0';
+    }
+    while ((off < size) && (n > 0)) {
+        buf[off++] = digits[--n];
+    }
+    return off;
+}
+
+/* write queued messages in the order they were logged using only
+ * async-signal-safe calls, for the fatal signal handler. Lines have the
+ * layout of log_write(), with the time in seconds since the epoch */
+static void log_drain_fatal(void)
+{
+    static char line[LOG_MSG_MAX + 512];
+    unsigned long limit = __atomic_load_n(&log_seq, __ATOMIC_SEQ_CST);
+
+    for (;;) {
+        log_ring* ring = NULL;
+        log_record* rec = log_next_record(limit, &ring);
+        if (NULL == rec) {
+            break;
+        }
+
+        const char* file = rec->srcfile;
+        if (NULL != file) {
+            file += unifyfs_log_source_base_len;
+        } else {
+            file = "";
+        }
+        const char* func = rec->function;
+        if (NULL == func) {
+            func = null_func;
+        }
+
+        size_t size = sizeof(line) - 1;
+        size_t off = 0;
+        off = log_fatal_num(line, off, size,
+                            (unsigned long) rec->now.tv_sec, 0);
+        off = log_fatal_str(line, off, size, ".");
+        off = log_fatal_num(line, off, size,
+                            (unsigned long)(rec->now.tv_nsec / 1000), 6);
+        off = log_fatal_str(line, off, size, " tid=");
+        off = log_fatal_num(line, off, size, (unsigned long) ring->tid, 0);
+        off = log_fatal_str(line, off, size, " @ ");
+        off = log_fatal_str(line, off, size, func);
+        off = log_fatal_str(line, off, size, "() [");
+        off = log_fatal_str(line, off, size, file);
+        off = log_fatal_str(line, off, size, ":");
+        off = log_fatal_num(line, off, size, (unsigned long) rec->lineno, 0);
+        off = log_fatal_str(line, off, size, "] ");
+        off = log_fatal_str(line, off, size, (const char*)(rec + 1));
+        line[off++] = '\n';
+
+        size_t done = 0;
+        while (done < off) {
+            ssize_t rc = write(log_fatal_fd, line + done, off - done);
+            if (rc <= 0) {
+                break;
+            }
+            done += (size_t) rc;
+        }
+
+        log_record_done(ring, rec);
+    }
+}
+
+/* return nonzero if messages have been logged but not yet written */
+static int log_pending(void)
+{
+    return (__atomic_load_n(&log_seq, __ATOMIC_SEQ_CST) !=
+            __atomic_load_n(&log_written, __ATOMIC_SEQ_CST));
+}
+
+/* write all queued messages now */
+void unifyfs_log_flush(void)
+{
+    pthread_mutex_lock(&log_drain_lock);
+    log_drain();
+    pthread_mutex_unlock(&log_drain_lock);
+}
+
+/* wake the writer if it is waiting for messages */
+static void log_writer_wake(void)
+{
+    if (__atomic_load_n(&log_writer_idle, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&log_wait_lock);
+        pthread_cond_signal(&log_wait_cond);
+        pthread_mutex_unlock(&log_wait_lock);
+    }
+}
+
+/* add one message to the calling thread's log ring buffer */
+void unifyfs_log_record(unifyfs_log_level_t level,
+                        const char* srcfile,
+                        int lineno,
+                        const char* function,
+                        const char* fmt, ...)
+{
+    va_list args;
+    struct timespec now;
+    char msg[LOG_MSG_MAX];
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    va_start(args, fmt);
+    int n = vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    if (n < 0) {
+        msg[0] = '\0';
+        n = 0;
+    }
+    size_t len = ((size_t)n < sizeof(msg)) ? ((size_t)n + 1) : sizeof(msg);
+
+    log_ring* ring = log_ring_get();
+    if (NULL == ring) {
+        /* no ring, write the message directly after those queued */
+        pthread_mutex_lock(&log_drain_lock);
+        log_drain();
+        unifyfs_log_print(&now, srcfile, lineno, function, msg);
+        pthread_mutex_unlock(&log_drain_lock);
+        return;
+    }
+
+    int added = log_ring_add(ring, &now, srcfile, lineno, function,
+                             msg, len);
+    if (!added && (level <= LOG_ERR)) {
+        /* make room rather than lose an error */
+        unifyfs_log_flush();
+        added = log_ring_add(ring, &now, srcfile, lineno, function,
+                             msg, len);
+    }
+    if (!added) {
+        __atomic_fetch_add(&(ring->dropped), 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (level <= LOG_ERR) {
+        /* errors are written before we return */
+        unifyfs_log_flush();
+    } else {
+        log_writer_wake();
+    }
+}
+
+static void* log_writer_main(void* arg)
+{
+    while (!__atomic_load_n(&log_writer_exit, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&log_drain_lock);
+        size_t count = log_drain();
+        pthread_mutex_unlock(&log_drain_lock);
+        if (count) {
+            continue;
+        }
+
+        /* sleep until a message is logged, a thread that logs one after
+         * we set idle will see it and signal us */
+        pthread_mutex_lock(&log_wait_lock);
+        __atomic_store_n(&log_writer_idle, 1, __ATOMIC_SEQ_CST);
+        if (!log_pending() &&
+            !__atomic_load_n(&log_writer_exit, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&log_wait_cond, &log_wait_lock);
+        }
+        __atomic_store_n(&log_writer_idle, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&log_wait_lock);
+    }
+
+    /* write anything queued before we were stopped */
+    unifyfs_log_flush();
+    return NULL;
+}
+
+/* write queued messages before the process dies from a fatal signal,
+ * then let the signal take its course */
+static void log_fatal_signal(int sig)
+{
+    /* skip the drain if the signal hit while one was running, and keep
+     * other drains out while we write */
+    int idle = 0;
+    if ((log_fatal_fd >= 0) &&
+        __atomic_compare_exchange_n(&log_draining, &idle, 1, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        log_drain_fatal();
+        __atomic_store_n(&log_draining, 0, __ATOMIC_RELEASE);
+    }
+
+    for (size_t i = 0; i < LOG_NUM_FATAL_SIGNALS; i++) {
+        if (log_fatal_signals[i] == sig) {
+            sigaction(sig, &(log_fatal_prev[i]), NULL);
+        }
+    }
+    raise(sig);
+}
+
+/* write queued messages when the process exits */
+static void log_atexit(void)
+{
+    unifyfs_log_async_stop();
+}
+
+/* start the background log writer */
+int unifyfs_log_async_start(void)
+{
+    static int atexit_registered; // = 0
+
+    if (unifyfs_log_async) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    if (NULL == unifyfs_log_stream) {
+        unifyfs_log_stream = stderr;
+    }
+
+    pthread_once(&log_ring_key_once, log_ring_key_create);
+
+    /* the stream is fixed while the writer runs, so its descriptor is
+     * safe to use from the fatal signal handler */
     fflush(unifyfs_log_stream);
+    log_fatal_fd = fileno(unifyfs_log_stream);
+
+    log_writer_exit = 0;
+    int rc = pthread_create(&log_writer, NULL, log_writer_main, NULL);
+    if (rc) {
+        return rc;
+    }
+    __atomic_store_n(&unifyfs_log_async, 1, __ATOMIC_RELEASE);
+
+    if (!atexit_registered) {
+        atexit(log_atexit);
+        atexit_registered = 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = log_fatal_signal;
+    sigemptyset(&sa.sa_mask);
+    for (size_t i = 0; i < LOG_NUM_FATAL_SIGNALS; i++) {
+        sigaction(log_fatal_signals[i], &sa, &(log_fatal_prev[i]));
+    }
+
+    return UNIFYFS_SUCCESS;
+}
+
+/* write queued messages and stop the background log writer */
+void unifyfs_log_async_stop(void)
+{
+    if (!unifyfs_log_async) {
+        return;
+    }
+
+    /* new messages are written directly from here on */
+    __atomic_store_n(&unifyfs_log_async, 0, __ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < LOG_NUM_FATAL_SIGNALS; i++) {
+        sigaction(log_fatal_signals[i], &(log_fatal_prev[i]), NULL);
+    }
+
+    pthread_mutex_lock(&log_wait_lock);
+    __atomic_store_n(&log_writer_exit, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&log_wait_cond);
+    pthread_mutex_unlock(&log_wait_lock);
+    pthread_join(log_writer, NULL);
+}
+
+/* get the number of messages dropped because a ring was full */
+unsigned long unifyfs_log_dropped(void)
+{
+    unsigned long dropped = 0;
+    for (log_ring* ring = __atomic_load_n(&log_rings, __ATOMIC_ACQUIRE);
+         NULL != ring; ring = ring->next) {
+        dropped += __atomic_load_n(&(ring->dropped), __ATOMIC_RELAXED);
+    }
+    return dropped;
 }
 
 /* close our log file stream.
  * returns UNIFYFS_SUCCESS on success */
 int unifyfs_log_close(void)
 {
+    /* write out any queued messages */
+    unifyfs_log_async_stop();
+
     /* if stream is open, and its not stderr, close it */
     if (NULL != unifyfs_log_stream) {
         if (unifyfs_log_stream != stderr) {
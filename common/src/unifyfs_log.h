@@ -52,16 +52,39 @@ typedef enum {
 extern unifyfs_log_level_t unifyfs_log_level;
 extern int unifyfs_log_on_error;
 extern FILE* unifyfs_log_stream;
+extern int unifyfs_log_async;
 
 pid_t unifyfs_gettid(void);
 
 /* print one message to debug file stream */
-void unifyfs_log_print(time_t now,
+void unifyfs_log_print(const struct timespec* now,
                        const char* srcfile,
                        int lineno,
                        const char* function,
                        char* msg);
 
+/* add one message to the calling thread's log ring buffer, for
+ * output by the background log writer */
+void unifyfs_log_record(unifyfs_log_level_t level,
+                        const char* srcfile,
+                        int lineno,
+                        const char* function,
+                        const char* fmt, ...);
+
+/* start a background thread to write log messages, after which threads
+ * queue messages in per-thread ring buffers rather than writing them,
+ * returns UNIFYFS_SUCCESS on success */
+int unifyfs_log_async_start(void);
+
+/* write any queued log messages and stop the background writer */
+void unifyfs_log_async_stop(void);
+
+/* write any queued log messages now */
+void unifyfs_log_flush(void);
+
+/* get the number of messages dropped because a ring buffer was full */
+unsigned long unifyfs_log_dropped(void);
+
 /* open specified file as debug file stream,
  * returns UNIFYFS_SUCCESS on success */
 int unifyfs_log_open(const char* file);
@@ -79,14 +102,21 @@ void unifyfs_set_log_on_error(void);
 #define LOG(level, ...) \
     do { \
         if (level <= unifyfs_log_level) { \
-            if (NULL == unifyfs_log_stream) { \
-                unifyfs_log_stream = stderr; \
+            if (unifyfs_log_async) { \
+                unifyfs_log_record(level, __FILE__, __LINE__, __func__, \
+                                   __VA_ARGS__); \
+            } else { \
+                if (NULL == unifyfs_log_stream) { \
+                    unifyfs_log_stream = stderr; \
+                } \
+                const char* srcfile = __FILE__; \
+                struct timespec log_time; \
+                clock_gettime(CLOCK_REALTIME, &log_time); \
+                char msg[4096] = {0}; \
+                scnprintf(msg, sizeof(msg), __VA_ARGS__); \
+                unifyfs_log_print(&log_time, srcfile, __LINE__, __func__, \
+                                  msg); \
             } \
-            const char* srcfile = __FILE__; \
-            time_t log_time = time(NULL); \
-            char msg[4096] = {0}; \
-            scnprintf(msg, sizeof(msg), __VA_ARGS__); \
-            unifyfs_log_print(log_time, srcfile, __LINE__, __func__, msg); \
         } \
     } while (0)
 
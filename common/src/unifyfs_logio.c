@@ -12,23 +12,35 @@
  * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 
 #include "unifyfs_log.h"
 #include "unifyfs_logio.h"
 #include "unifyfs_meta.h"
+#include "unifyfs_numa.h"
 #include "unifyfs_shm.h"
+#include "unifyfs_spillio.h"
 #include "slotmap.h"
 
 #define LOGIO_SHMEM_FMTSTR "logio_mem.%d.%d"
 #define LOGIO_SPILL_FMTSTR "%s/logio_spill.%d.%d"
+#define LOGIO_STRIPE_FMTSTR "%s/logio_spill.%d.%d.%d"
+#define LOGIO_TIERS_FMTSTR "logio_tiers.%d.%d"
 
 
 /* log-based I/O header - first page of shmem region or spill file */
@@ -36,8 +48,13 @@ typedef struct log_header {
     size_t data_sz;            /* total data bytes in log */
     size_t reserved_sz;        /* reserved data bytes */
     size_t chunk_sz;           /* data chunk size */
-    size_t max_reserved_slot;  /* slot index for last reserved chunk */
+    size_t reserved_end;       /* slot index just past highest reserved
+                                * chunk, i.e., the high-water mark */
     off_t data_offset;         /* file/memory offset where data chunks start */
+    size_t tier_sz;            /* size of chunk tier map region, or 0 */
+    size_t spill_align;        /* O_DIRECT alignment of spill data, or 0 */
+    size_t spill_stripes;      /* spill files the data is striped across */
+    size_t numa_node;          /* NUMA node of shmem region + 1, or 0 */
 } log_header;
 /* chunk slot_map immediately follows header and occupies rest of the page */
 // slot_map chunk_map;         /* chunk slot_map that tracks reservations */
@@ -49,6 +66,83 @@ slot_map* log_header_to_chunkmap(log_header* hdr)
     return (slot_map*)(hdrp + sizeof(log_header));
 }
 
+/*
+ * Chunk tiering.
+ *
+ * When a client has both shmem and spillover storage, the data of each log
+ * chunk may be held by any physical chunk of either tier. The mapping is
+ * kept in a shared memory tier map, so log offsets stay the same when data
+ * is moved and the server reads through the same mapping. A background
+ * thread in the client moves the coldest written chunks from shmem to the
+ * spillover file to keep some shmem chunks free for new writes, and moves
+ * chunks that are read often, or that are advised to be needed, back to
+ * shmem when there is room. Readers use the per-chunk sequence number to
+ * retry a read that raced with a move of the chunk.
+ */
+
+/* tier map entry for a log chunk */
+typedef struct tier_entry {
+    uint32_t seq;   /* odd while the chunk is being remapped */
+    uint32_t phys;  /* physical chunk holding the data */
+    uint32_t hits;  /* reads since last decay */
+    uint32_t pad;
+} tier_entry;
+
+/* chunk tier map - in its own shmem region */
+typedef struct tier_map {
+    size_t n_chunks;       /* number of log (and physical) chunks */
+    size_t mem_chunks;     /* physical chunks in shmem, the rest spill */
+    tier_entry chunks[];
+} tier_map;
+
+/* client state flags for a log chunk */
+#define TIER_ALLOCATED 0x01
+#define TIER_WRITTEN   0x02
+#define TIER_BUSY      0x04  /* being moved */
+#define TIER_WILLNEED  0x08
+#define TIER_DONTNEED  0x10
+
+typedef struct logio_tiers {
+    shm_context* shm;      /* tier map shmem region */
+    tier_map* map;
+
+    /* the remaining fields are only used by the client */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;   /* signals the thread and waiters on moves */
+    pthread_t thrd;
+    int thrd_active;
+    int stop;
+    uint8_t* state;        /* state flags of each log chunk */
+    uint16_t* writers;     /* writes in progress to each log chunk */
+    uint8_t* phys_used;    /* whether each physical chunk holds data */
+    size_t mem_free;       /* free physical chunks in shmem */
+    size_t spill_free;     /* free physical chunks in spill */
+    size_t free_target;    /* shmem chunks to keep free for new writes */
+    uint64_t interval_us;  /* time between passes of the thread */
+    char* buf;             /* chunk copy buffer */
+    size_t demoted;        /* chunks moved to spill */
+    size_t promoted;       /* chunks moved to shmem */
+} logio_tiers;
+
+static int tier_init_client(logio_context* ctx,
+                            const int app_id,
+                            const int client_id,
+                            const unifyfs_cfg_t* client_cfg);
+static int tier_init_server(logio_context* ctx,
+                            const int app_id,
+                            const int client_id);
+static void tier_fini(logio_context* ctx);
+static int tier_assign(logio_context* ctx, off_t log_offset, size_t nbytes);
+static void tier_release(logio_context* ctx, off_t log_offset, size_t nbytes);
+static int tier_read(logio_context* ctx, off_t log_offset, size_t nbytes,
+                     char* obuf, size_t* obytes);
+static int tier_write(logio_context* ctx, off_t log_offset, size_t nbytes,
+                      const char* ibuf, size_t* obytes);
+static int tier_phys_offset(logio_context* ctx, uint32_t phys,
+                            off_t* offset);
+static int logio_batch_worthwhile(logio_context* ctx, off_t log_offset,
+                                  size_t nbytes);
+
 /* convenience method to return system page size */
 size_t get_page_size(void)
 {
@@ -147,6 +241,358 @@ static void* map_spillfile(int spill_fd, int mmap_prot)
     return addr;
 }
 
+/*
+ * O_DIRECT spill I/O.
+ *
+ * When enabled, spill file data is read and written with O_DIRECT so it
+ * bypasses the page cache. The data offset and chunk size of the spill
+ * log are then multiples of the I/O alignment the file system needs, so
+ * whole chunks are transferred directly. Other transfers are staged
+ * through an aligned bounce buffer, reading and writing back the partial
+ * blocks at either end. That is safe since each log chunk, and so each
+ * block of the spill file, has one writer at a time.
+ */
+
+/* bytes staged at a time by unaligned O_DIRECT transfers */
+#define LOGIO_BOUNCE_SZ (1024 * 1024)
+
+static __thread char* spill_bounce; // = NULL
+static __thread size_t spill_bounce_sz; // = 0
+static pthread_key_t spill_bounce_key;
+static pthread_once_t spill_bounce_key_once = PTHREAD_ONCE_INIT;
+
+static void spill_bounce_key_create(void)
+{
+    pthread_key_create(&spill_bounce_key, free);
+}
+
+/* get the calling thread's bounce buffer for the given alignment */
+static char* spill_bounce_get(size_t align,
+                              size_t* bounce_sz)
+{
+    size_t sz = LOGIO_BOUNCE_SZ;
+    if (sz < (2 * align)) {
+        sz = 2 * align;
+    }
+    sz += (align - (sz % align)) % align;
+    if ((NULL == spill_bounce) || (spill_bounce_sz < sz) ||
+        ((uintptr_t)spill_bounce % align)) {
+        pthread_once(&spill_bounce_key_once, spill_bounce_key_create);
+        free(spill_bounce);
+        spill_bounce = NULL;
+        spill_bounce_sz = 0;
+        void* buf = NULL;
+        if (0 == posix_memalign(&buf, align, sz)) {
+            spill_bounce = buf;
+            spill_bounce_sz = sz;
+        }
+        pthread_setspecific(spill_bounce_key, spill_bounce);
+    }
+    *bounce_sz = spill_bounce_sz;
+    return spill_bounce;
+}
+
+/* whether a spill transfer can be done as is */
+static inline
+int spill_io_aligned(logio_context* ctx,
+                     const char* buf,
+                     size_t len,
+                     off_t offset)
+{
+    size_t align = ctx->spill_align;
+    return (0 == align) ||
+           ((0 == ((uintptr_t)buf % align)) &&
+            (0 == (len % align)) &&
+            (0 == ((size_t)offset % align)));
+}
+
+/* read or write spill file data like pread()/pwrite(), staging transfers
+ * that are not aligned for O_DIRECT through a bounce buffer */
+static ssize_t logio_spill_pio(logio_context* ctx,
+                               int fd,
+                               int write,
+                               char* buf,
+                               size_t len,
+                               off_t offset)
+{
+    if (spill_io_aligned(ctx, buf, len, offset)) {
+        if (write) {
+            return pwrite(fd, buf, len, offset);
+        }
+        return pread(fd, buf, len, offset);
+    }
+
+    size_t align = ctx->spill_align;
+    size_t bounce_sz;
+    char* bounce = spill_bounce_get(align, &bounce_sz);
+    if (NULL == bounce) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ssize_t rc = 0;
+    size_t done = 0;
+    while (done < len) {
+        off_t pos = offset + (off_t)done;
+        size_t head = (size_t)pos % align;
+        off_t start = pos - (off_t)head;
+        size_t n = len - done;
+        if (n > (bounce_sz - head)) {
+            n = bounce_sz - head;
+        }
+        size_t span = head + n;
+        span += (align - (span % align)) % align;
+
+        size_t moved = 0;
+        if (write) {
+            /* fill in the partial blocks at either end */
+            if (head) {
+                rc = pread(fd, bounce, align, start);
+                if (rc < 0) {
+                    break;
+                }
+            }
+            if (((head + n) != span) && ((0 == head) || (span > align))) {
+                rc = pread(fd, bounce + (span - align), align,
+                           start + (off_t)(span - align));
+                if (rc < 0) {
+                    break;
+                }
+            }
+            memcpy(bounce + head, buf + done, n);
+            rc = pwrite(fd, bounce, span, start);
+            if (rc < 0) {
+                break;
+            }
+            if ((size_t)rc > head) {
+                moved = (size_t)rc - head;
+                if (moved > n) {
+                    moved = n;
+                }
+            }
+        } else {
+            rc = pread(fd, bounce, span, start);
+            if (rc < 0) {
+                break;
+            }
+            if ((size_t)rc > head) {
+                moved = (size_t)rc - head;
+                if (moved > n) {
+                    moved = n;
+                }
+                memcpy(buf + done, bounce + head, moved);
+            }
+        }
+        done += moved;
+        if (moved < n) {
+            break;
+        }
+    }
+
+    if ((0 == done) && (rc < 0)) {
+        return -1;
+    }
+    return (ssize_t) done;
+}
+
+/* get the alignment needed for O_DIRECT I/O to a file, or 0 if the file
+ * system does not support it */
+static size_t get_odirect_align(int fd)
+{
+    size_t align = get_page_size();
+#ifdef STATX_DIOALIGN
+    struct statx stx;
+    if ((0 == statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx)) &&
+        (stx.stx_mask & STATX_DIOALIGN)) {
+        if (0 == stx.stx_dio_offset_align) {
+            return 0;
+        }
+        align = stx.stx_dio_offset_align;
+        if (stx.stx_dio_mem_align > align) {
+            align = stx.stx_dio_mem_align;
+        }
+    }
+#endif
+    return align;
+}
+
+/* switch the spill files of a log to O_DIRECT, or back */
+static int set_odirect(int* fds,
+                       int n_fds,
+                       int on)
+{
+    for (int i = 0; i < n_fds; i++) {
+        int flags = fcntl(fds[i], F_GETFL);
+        if (-1 != flags) {
+            flags = on ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+            flags = fcntl(fds[i], F_SETFL, flags);
+        }
+        if (-1 == flags) {
+            int err = errno;
+            if (on) {
+                set_odirect(fds, i, 0);
+            }
+            return err;
+        }
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/*
+ * Striped spill storage.
+ *
+ * The spill directory setting may list several directories separated by
+ * colons, such as one on each local drive. A client then has a spill file
+ * in each, and its spill log chunks are striped round robin across them.
+ * The first file holds the log header. Which directory holds it varies
+ * by client, so that clients with small logs are spread across drives.
+ * Each file keeps the same data offset as the first, and chunk k of the
+ * spill log is chunk (k / n) of file (k % n) for n files.
+ */
+
+/* open (or create) the spill files of a client log, one in each of the
+ * colon-separated spill directories */
+static int open_spill_files(const char* spill_dir,
+                            const int app_id,
+                            const int client_id,
+                            const size_t spill_sz,
+                            int* n_files,
+                            int** pfds,
+                            char*** ppaths)
+{
+    char* list = strdup(spill_dir);
+    if (NULL == list) {
+        return ENOMEM;
+    }
+    char* dirs[UNIFYFS_LOGIO_MAX_SPILL_DIRS];
+    int n = 0;
+    char* saveptr = NULL;
+    for (char* dir = strtok_r(list, ":", &saveptr); NULL != dir;
+         dir = strtok_r(NULL, ":", &saveptr)) {
+        if (n == UNIFYFS_LOGIO_MAX_SPILL_DIRS) {
+            LOGWARN("using only the first %d spill directories", n);
+            break;
+        }
+        dirs[n++] = dir;
+    }
+    if (0 == n) {
+        LOGERR("no spill directory given in '%s'", spill_dir);
+        free(list);
+        return EINVAL;
+    }
+
+    int* fds = malloc(n * sizeof(int));
+    char** paths = calloc(n, sizeof(char*));
+    if ((NULL == fds) || (NULL == paths)) {
+        free(fds);
+        free(paths);
+        free(list);
+        return ENOMEM;
+    }
+
+    int rc = UNIFYFS_SUCCESS;
+    int opened = 0;
+    for (int i = 0; i < n; i++) {
+        const char* dir = dirs[((unsigned)client_id + (unsigned)i) % n];
+        char path[UNIFYFS_MAX_FILENAME];
+        if (0 == i) {
+            snprintf(path, sizeof(path), LOGIO_SPILL_FMTSTR,
+                     dir, app_id, client_id);
+        } else {
+            snprintf(path, sizeof(path), LOGIO_STRIPE_FMTSTR,
+                     dir, app_id, client_id, i);
+        }
+        paths[i] = strdup(path);
+        fds[i] = get_spillfile(path, spill_sz);
+        if ((NULL == paths[i]) || (fds[i] < 0)) {
+            LOGERR("Failed to open logio spill file %s", path);
+            rc = UNIFYFS_FAILURE;
+            if (fds[i] >= 0) {
+                opened++;
+            }
+            break;
+        }
+        opened++;
+    }
+    free(list);
+
+    if (rc != UNIFYFS_SUCCESS) {
+        for (int i = 0; i < opened; i++) {
+            close(fds[i]);
+        }
+        for (int i = 0; i < n; i++) {
+            free(paths[i]);
+        }
+        free(fds);
+        free(paths);
+        return rc;
+    }
+
+    *n_files = n;
+    *pfds = fds;
+    *ppaths = paths;
+    return UNIFYFS_SUCCESS;
+}
+
+/* locate data at an offset into the spill log data. Sets the file
+ * and file offset holding it, and returns how many of len bytes are
+ * contiguous there */
+static size_t spill_locate(logio_context* ctx,
+                           off_t spill_off,
+                           size_t len,
+                           int* fd,
+                           off_t* file_off)
+{
+    log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+    if (ctx->spill_nstripes <= 1) {
+        *fd = ctx->spill_fd;
+        *file_off = spill_hdr->data_offset + spill_off;
+        return len;
+    }
+
+    size_t n = (size_t) ctx->spill_nstripes;
+    size_t chunk_sz = spill_hdr->chunk_sz;
+    size_t chunk = (size_t)spill_off / chunk_sz;
+    size_t within = (size_t)spill_off % chunk_sz;
+    *fd = ctx->spill_stripe_fds[chunk % n];
+    *file_off = spill_hdr->data_offset +
+                (off_t)(((chunk / n) * chunk_sz) + within);
+    if (len > (chunk_sz - within)) {
+        len = chunk_sz - within;
+    }
+    return len;
+}
+
+/* read or write data at an offset into the spill log data, like
+ * pread()/pwrite() */
+static ssize_t logio_spill_io(logio_context* ctx,
+                              int write,
+                              char* buf,
+                              size_t len,
+                              off_t spill_off)
+{
+    size_t done = 0;
+    while (done < len) {
+        int fd;
+        off_t file_off;
+        size_t n = spill_locate(ctx, spill_off + (off_t)done, len - done,
+                                &fd, &file_off);
+        ssize_t rc = logio_spill_pio(ctx, fd, write, buf + done, n,
+                                     file_off);
+        if (rc < 0) {
+            if (0 == done) {
+                return -1;
+            }
+            break;
+        }
+        done += (size_t) rc;
+        if ((size_t)rc < n) {
+            break;
+        }
+    }
+    return (ssize_t) done;
+}
+
 /* Initialize logio context for server */
 int unifyfs_logio_init_server(const int app_id,
                               const int client_id,
@@ -173,30 +619,38 @@ int unifyfs_logio_init_server(const int app_id,
         }
     }
 
-    char spillfile[UNIFYFS_MAX_FILENAME];
     void* spill_mapping = NULL;
     int spill_fd = -1;
+    int n_stripes = 0;
+    int* stripe_fds = NULL;
+    char** stripe_files = NULL;
     if (spill_size) {
         if (NULL == spill_dir) {
             LOGERR("Spill directory not given!");
             return EINVAL;
         }
 
-        /* open the spill over file */
-        snprintf(spillfile, sizeof(spillfile), LOGIO_SPILL_FMTSTR,
-                 spill_dir, app_id, client_id);
-        spill_fd = get_spillfile(spillfile, spill_size);
-        if (spill_fd < 0) {
+        /* open the spill over files */
+        int rc = open_spill_files(spill_dir, app_id, client_id, spill_size,
+                                  &n_stripes, &stripe_fds, &stripe_files);
+        if (rc != UNIFYFS_SUCCESS) {
             LOGERR("Failed to open logio spill file!");
             return UNIFYFS_FAILURE;
         } else {
             /* map first page of the spill over file, which contains log header
              * and chunk slot_map. server only needs read access. */
+            spill_fd = stripe_fds[0];
             spill_mapping = map_spillfile(spill_fd, PROT_READ);
             if (NULL == spill_mapping) {
                 LOGERR("Failed to map logio spill file header!");
                 return UNIFYFS_FAILURE;
             }
+            log_header* spill_hdr = (log_header*) spill_mapping;
+            if (spill_hdr->spill_stripes != (size_t)n_stripes) {
+                LOGERR("client spill log has %zu stripes, not %d",
+                       spill_hdr->spill_stripes, n_stripes);
+                return UNIFYFS_ERROR_BADCONFIG;
+            }
         }
     }
 
@@ -206,11 +660,42 @@ int unifyfs_logio_init_server(const int app_id,
         return ENOMEM;
     }
     ctx->shmem = shm_ctx;
+    ctx->numa_node = -1;
+    if (NULL != shm_ctx) {
+        /* node the client placed its shmem log on */
+        log_header* shmem_hdr = (log_header*) shm_ctx->addr;
+        ctx->numa_node = (int)(shmem_hdr->numa_node) - 1;
+    }
     ctx->spill_hdr = spill_mapping;
     ctx->spill_fd = spill_fd;
     ctx->spill_sz = spill_size;
+    ctx->spill_nstripes = n_stripes;
+    ctx->spill_stripe_fds = stripe_fds;
+    ctx->spill_stripe_files = stripe_files;
     if (spill_size) {
-        ctx->spill_file = strdup(spillfile);
+        ctx->spill_file = strdup(stripe_files[0]);
+    }
+    if (NULL != spill_mapping) {
+        /* use O_DIRECT for spill data if the client does */
+        log_header* spill_hdr = (log_header*) spill_mapping;
+        if (spill_hdr->spill_align) {
+            int rc = set_odirect(stripe_fds, n_stripes, 1);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGWARN("Failed to set O_DIRECT on logio spill file %s - %s",
+                        ctx->spill_file, strerror(rc));
+            } else {
+                ctx->spill_align = spill_hdr->spill_align;
+            }
+        }
+    }
+    if ((NULL != shm_ctx) && (NULL != spill_mapping)) {
+        /* read through the chunk tier map if the client uses one */
+        int rc = tier_init_server(ctx, app_id, client_id);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("Failed to attach logio chunk tier map!");
+            unifyfs_logio_close(ctx, 0);
+            return rc;
+        }
     }
     *pctx = ctx;
     LOGDBG("logio_context for client [%d:%d] - "
@@ -225,7 +710,8 @@ int unifyfs_logio_init_server(const int app_id,
  * (note: intended for client use only) */
 static int init_log_header(char* log_region,
                            size_t region_size,
-                           size_t chunk_size)
+                           size_t chunk_size,
+                           size_t align)
 {
     size_t pgsz = get_page_size();
 
@@ -237,11 +723,21 @@ static int init_log_header(char* log_region,
     /* zero all log header fields */
     memset(log_region, 0, sizeof(log_header));
 
-    /* chunk data starts after header page */
-    size_t data_size = region_size - pgsz;
+    /* chunk data starts after header page, at a multiple of the
+     * O_DIRECT alignment if one is given */
+    size_t data_offset = pgsz;
+    if (align > pgsz) {
+        data_offset = align;
+    }
+    if (region_size <= data_offset) {
+        LOGERR("log region size %zu is too small", region_size);
+        return UNIFYFS_FAILURE;
+    }
+    size_t data_size = region_size - data_offset;
     hdr->data_sz = data_size;
     hdr->chunk_sz = chunk_size;
-    hdr->data_offset = (off_t)pgsz;
+    hdr->data_offset = (off_t)data_offset;
+    hdr->spill_align = align;
 
     /* initialize chunk slot map (immediately follows header in memory) */
     char* slotmap = log_region + sizeof(log_header);
@@ -293,27 +789,6 @@ int unifyfs_logio_init_client(const int app_id,
         }
     }
 
-    shm_context* shm_ctx = NULL;
-    if (memlog_size) {
-        /* allocate logio shared memory buffer */
-        char shm_name[SHMEM_NAME_LEN] = {0};
-        snprintf(shm_name, sizeof(shm_name), LOGIO_SHMEM_FMTSTR,
-                 app_id, client_id);
-        shm_ctx = unifyfs_shm_alloc(shm_name, memlog_size);
-        if (NULL == shm_ctx) {
-            LOGERR("Failed to create logio shmem buffer!");
-            return UNIFYFS_ERROR_SHMEM;
-        }
-
-        /* initialize shmem log header */
-        char* memlog = (char*) shm_ctx->addr;
-        rc = init_log_header(memlog, memlog_size, chunk_size);
-        if (rc != UNIFYFS_SUCCESS) {
-            LOGERR("Failed to initialize shmem logio header");
-            return rc;
-        }
-    }
-
     /* will we use spillover to store the files? */
     size_t spill_size = 0;
     cfgval = client_cfg->logio_spill_size;
@@ -330,10 +805,25 @@ int unifyfs_logio_init_client(const int app_id,
         unifyfs_use_spillover = 1;
     }
 
+    /* should spill data bypass the page cache? */
+    bool spill_odirect = false;
+    cfgval = client_cfg->logio_spill_odirect;
+    if (cfgval != NULL) {
+        bool b;
+        rc = configurator_bool_val(cfgval, &b);
+        if (rc == 0) {
+            spill_odirect = b;
+        }
+    }
+
     void* spill_mapping = NULL;
+    size_t spill_align = 0;
     int spill_fd = -1;
+    int n_stripes = 0;
+    int* stripe_fds = NULL;
+    char** stripe_files = NULL;
     if (unifyfs_use_spillover) {
-        /* get directory in which to create spill over files */
+        /* get directories in which to create spill over files */
         cfgval = client_cfg->logio_spill_dir;
         if (NULL == cfgval) {
             LOGERR("UNIFYFS_LOGIO_SPILL_DIR configuration not set! "
@@ -341,17 +831,15 @@ int unifyfs_logio_init_client(const int app_id,
             return UNIFYFS_ERROR_BADCONFIG;
         }
 
-        /* define path to the spill over file for data chunks */
-        char spillfile[UNIFYFS_MAX_FILENAME];
-        snprintf(spillfile, sizeof(spillfile), LOGIO_SPILL_FMTSTR,
-                 cfgval, app_id, client_id);
-
-        /* create the spill over file */
-        spill_fd = get_spillfile(spillfile, spill_size);
-        if (spill_fd < 0) {
+        /* create the spill over files for data chunks */
+        rc = open_spill_files(cfgval, app_id, client_id, spill_size,
+                              &n_stripes, &stripe_fds, &stripe_files);
+        if (rc != UNIFYFS_SUCCESS) {
             LOGERR("Failed to open logio spill file!");
             return UNIFYFS_FAILURE;
         } else {
+            const char* spillfile = stripe_files[0];
+            spill_fd = stripe_fds[0];
             /* map first page of the spill over file, which contains log header
              * and chunk slot_map. client needs read and write access. */
             spill_mapping = map_spillfile(spill_fd, PROT_READ|PROT_WRITE);
@@ -360,16 +848,95 @@ int unifyfs_logio_init_client(const int app_id,
                 return UNIFYFS_FAILURE;
             }
 
+            /* use O_DIRECT for spill data, with the chunks of both logs
+             * a multiple of the I/O alignment */
+            if (spill_odirect) {
+                for (int i = 0; i < n_stripes; i++) {
+                    size_t align = get_odirect_align(stripe_fds[i]);
+                    if ((0 == i) || (0 == align) ||
+                        ((0 != spill_align) && (align > spill_align))) {
+                        spill_align = align;
+                    }
+                }
+                if (0 == spill_align) {
+                    LOGWARN("O_DIRECT not supported for spill file %s",
+                            spillfile);
+                } else if (UNIFYFS_SUCCESS !=
+                           (rc = set_odirect(stripe_fds, n_stripes, 1))) {
+                    LOGWARN("Failed to set O_DIRECT on spill file %s - %s",
+                            spillfile, strerror(rc));
+                    spill_align = 0;
+                } else if (chunk_size % spill_align) {
+                    chunk_size += spill_align - (chunk_size % spill_align);
+                    LOGWARN("chunk size raised to %zu B for O_DIRECT",
+                            chunk_size);
+                }
+            }
+
             /* initialize spill log header */
             char* spill = (char*) spill_mapping;
-            rc = init_log_header(spill, spill_size, chunk_size);
+            rc = init_log_header(spill, spill_size, chunk_size, spill_align);
             if (rc != UNIFYFS_SUCCESS) {
                 LOGERR("Failed to initialize shmem logio header");
                 return rc;
             }
+
+            /* size the files for their share of the striped chunks */
+            log_header* spill_hdr = (log_header*) spill;
+            spill_hdr->spill_stripes = (size_t) n_stripes;
+            if (n_stripes > 1) {
+                slot_map* chunkmap = log_header_to_chunkmap(spill_hdr);
+                size_t per_stripe = bytes_to_chunks(chunkmap->total_slots,
+                                                    (size_t)n_stripes);
+                off_t stripe_sz = spill_hdr->data_offset +
+                                  (off_t)(per_stripe * chunk_size);
+                for (int i = 0; i < n_stripes; i++) {
+                    if (0 != ftruncate(stripe_fds[i], stripe_sz)) {
+                        int err = errno;
+                        LOGWARN("ftruncate(%s) failed: %s",
+                                stripe_files[i], strerror(err));
+                    }
+                }
+                LOGDBG("striping spill chunks across %d files", n_stripes);
+            }
         }
     }
 
+    shm_context* shm_ctx = NULL;
+    int numa_node = -1;
+    if (memlog_size) {
+        /* allocate logio shared memory buffer */
+        char shm_name[SHMEM_NAME_LEN] = {0};
+        snprintf(shm_name, sizeof(shm_name), LOGIO_SHMEM_FMTSTR,
+                 app_id, client_id);
+        shm_ctx = unifyfs_shm_alloc(shm_name, memlog_size);
+        if (NULL == shm_ctx) {
+            LOGERR("Failed to create logio shmem buffer!");
+            return UNIFYFS_ERROR_SHMEM;
+        }
+
+        /* place the shmem pages on our NUMA node, so that the server
+         * threads copying from it can run there too */
+        if (unifyfs_numa_enabled()) {
+            numa_node = unifyfs_numa_current_node();
+            rc = unifyfs_numa_bind(shm_ctx->addr, memlog_size, numa_node);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGWARN("Failed to place logio shmem on NUMA node %d - %s",
+                        numa_node, strerror(rc));
+                numa_node = -1;
+            }
+        }
+
+        /* initialize shmem log header */
+        char* memlog = (char*) shm_ctx->addr;
+        rc = init_log_header(memlog, memlog_size, chunk_size, 0);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("Failed to initialize shmem logio header");
+            return rc;
+        }
+        ((log_header*) memlog)->numa_node = (size_t)(numa_node + 1);
+    }
+
     logio_context* ctx = (logio_context*) calloc(1, sizeof(logio_context));
     if (NULL == ctx) {
         LOGERR("Failed to allocate logio context!");
@@ -379,6 +946,21 @@ int unifyfs_logio_init_client(const int app_id,
     ctx->spill_hdr = spill_mapping;
     ctx->spill_fd = spill_fd;
     ctx->spill_sz = spill_size;
+    ctx->spill_align = spill_align;
+    ctx->spill_nstripes = n_stripes;
+    ctx->numa_node = numa_node;
+    ctx->spill_stripe_fds = stripe_fds;
+    ctx->spill_stripe_files = stripe_files;
+
+    if ((NULL != shm_ctx) && (NULL != spill_mapping)) {
+        /* move chunks between shmem and spill in the background */
+        rc = tier_init_client(ctx, app_id, client_id, client_cfg);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("Failed to initialize logio chunk tiering");
+            unifyfs_logio_close(ctx, 0);
+            return rc;
+        }
+    }
     *pctx = ctx;
 
     return UNIFYFS_SUCCESS;
@@ -393,6 +975,11 @@ int unifyfs_logio_close(logio_context* ctx,
     }
 
     int rc;
+    if (NULL != ctx->tiers) {
+        /* stop chunk tiering before releasing the storage */
+        tier_fini(ctx);
+    }
+
     if (NULL != ctx->shmem) {
         /* release shmem region */
         rc = unifyfs_shm_free(&(ctx->shmem));
@@ -422,6 +1009,23 @@ int unifyfs_logio_close(logio_context* ctx,
             }
             ctx->spill_fd = -1;
         }
+        for (int i = 1; i < ctx->spill_nstripes; i++) {
+            /* close and remove the other stripe files */
+            close(ctx->spill_stripe_fds[i]);
+            if (clean_spill && (ctx->spill_file != NULL)) {
+                rc = unlink(ctx->spill_stripe_files[i]);
+                if (rc != 0) {
+                    int err = errno;
+                    LOGERR("Failed to unlink logio spill file %s (errno=%s)",
+                           ctx->spill_stripe_files[i], strerror(err));
+                }
+            }
+        }
+        for (int i = 0; i < ctx->spill_nstripes; i++) {
+            free(ctx->spill_stripe_files[i]);
+        }
+        free(ctx->spill_stripe_files);
+        free(ctx->spill_stripe_fds);
         if (clean_spill && (ctx->spill_file != NULL)) {
             rc = unlink(ctx->spill_file);
             if (rc != 0) {
@@ -439,10 +1043,30 @@ int unifyfs_logio_close(logio_context* ctx,
     return UNIFYFS_SUCCESS;
 }
 
-/* Allocate write space from logio context */
-int unifyfs_logio_alloc(logio_context* ctx,
-                        const size_t nbytes,
-                        off_t* log_offset)
+/* update the high-water mark of the log after reserving chunks */
+static inline
+void log_reserved(log_header* hdr, size_t slot, size_t n_chunks)
+{
+    if ((slot + n_chunks) > hdr->reserved_end) {
+        hdr->reserved_end = slot + n_chunks;
+    }
+}
+
+/* update the high-water mark of the log after releasing chunks, which
+ * only moves when the highest reserved chunks were released */
+static inline
+void log_released(log_header* hdr, size_t slot, size_t n_chunks)
+{
+    if ((slot + n_chunks) >= hdr->reserved_end) {
+        hdr->reserved_end =
+            slotmap_high_water(log_header_to_chunkmap(hdr));
+    }
+}
+
+/* Reserve log chunks for write space */
+static int logio_reserve(logio_context* ctx,
+                         const size_t nbytes,
+                         off_t* log_offset)
 {
     if ((NULL == ctx) ||
         ((nbytes > 0) && (NULL == log_offset))) {
@@ -487,19 +1111,22 @@ int unifyfs_logio_alloc(logio_context* ctx,
             /* success, all needed chunks allocated in shmem */
             allocated_bytes = res_chunks * chunk_sz;
             shmem_hdr->reserved_sz += allocated_bytes;
-            shmem_hdr->max_reserved_slot = (res_slot + res_chunks) - 1;
+            log_reserved(shmem_hdr, res_slot, res_chunks);
             res_off = (off_t)(res_slot * chunk_sz);
             *log_offset = res_off;
             return UNIFYFS_SUCCESS;
         }
 
-        /* could not get full allocation in shmem, reserve any available
-         * chunks at the end of the shmem log */
+        /* could not get full allocation in shmem, reserve the free chunks
+         * past the high-water mark, which end the shmem log. Free chunks
+         * below it may be followed by chunks still in use, so they can't
+         * be joined with the start of the spill log */
         size_t log_end_chunks = chunkmap->total_slots -
-                                (shmem_hdr->max_reserved_slot + 1);
+                                shmem_hdr->reserved_end;
         if (log_end_chunks > 0) {
             res_chunks = log_end_chunks;
-            res_slot = slotmap_reserve(chunkmap, res_chunks);
+            res_slot = slotmap_reserve_at(chunkmap, shmem_hdr->reserved_end,
+                                          res_chunks);
             if (-1 != res_slot) {
                 /* reserved all chunks at end of shmem log */
                 allocated_bytes = res_chunks * chunk_sz;
@@ -530,7 +1157,7 @@ int unifyfs_logio_alloc(logio_context* ctx,
             if (0 == mem_res_at_end) {
                 /* success, full reservation in spill */
                 spill_hdr->reserved_sz += allocated_bytes;
-                spill_hdr->max_reserved_slot = (res_slot + res_chunks) - 1;
+                log_reserved(spill_hdr, res_slot, res_chunks);
                 res_off = (off_t)(res_slot * chunk_sz);
                 if (NULL != shmem_hdr) {
                     /* update log offset to account for shmem log size */
@@ -569,8 +1196,7 @@ int unifyfs_logio_alloc(logio_context* ctx,
                     if (-1 != res_slot) {
                         /* success, full reservation in spill */
                         spill_hdr->reserved_sz += allocated_bytes;
-                        spill_hdr->max_reserved_slot =
-                            (res_slot + res_chunks) - 1;
+                        log_reserved(spill_hdr, res_slot, res_chunks);
                         res_off = (off_t)(res_slot * chunk_sz);
                         if (NULL != shmem_hdr) {
                             /* update log offset to include shmem log size */
@@ -582,10 +1208,9 @@ int unifyfs_logio_alloc(logio_context* ctx,
                 } else {
                     /* successful reservation spanning shmem and spill */
                     shmem_hdr->reserved_sz += mem_allocation;
-                    shmem_hdr->max_reserved_slot =
-                        (mem_res_slot + mem_res_nchk) - 1;
+                    log_reserved(shmem_hdr, mem_res_slot, mem_res_nchk);
                     spill_hdr->reserved_sz += allocated_bytes;
-                    spill_hdr->max_reserved_slot = (res_slot + res_chunks) - 1;
+                    log_reserved(spill_hdr, res_slot, res_chunks);
                     *log_offset = res_off;
                     return UNIFYFS_SUCCESS;
                 }
@@ -605,6 +1230,22 @@ int unifyfs_logio_alloc(logio_context* ctx,
     return ENOSPC;
 }
 
+/* Allocate write space from logio context */
+int unifyfs_logio_alloc(logio_context* ctx,
+                        const size_t nbytes,
+                        off_t* log_offset)
+{
+    int rc = logio_reserve(ctx, nbytes, log_offset);
+    if ((rc == UNIFYFS_SUCCESS) && (nbytes > 0) && (NULL != ctx->tiers)) {
+        /* choose the physical chunks that will hold the data */
+        rc = tier_assign(ctx, *log_offset, nbytes);
+        if (rc != UNIFYFS_SUCCESS) {
+            unifyfs_logio_free(ctx, *log_offset, nbytes);
+        }
+    }
+    return rc;
+}
+
 /* Release previously allocated write space from logio context */
 int unifyfs_logio_free(logio_context* ctx,
                        const off_t log_offset,
@@ -619,6 +1260,11 @@ int unifyfs_logio_free(logio_context* ctx,
         return UNIFYFS_SUCCESS;
     }
 
+    if (NULL != ctx->tiers) {
+        /* release the physical chunks holding the data */
+        tier_release(ctx, log_offset, nbytes);
+    }
+
     log_header* shmem_hdr = NULL;
     log_header* spill_hdr = NULL;
     slot_map* chunkmap;
@@ -647,6 +1293,8 @@ int unifyfs_logio_free(logio_context* ctx,
         rc = slotmap_release(chunkmap, chunk_slot, num_chunks);
         if (rc != UNIFYFS_SUCCESS) {
             LOGERR("slotmap_release() for logio shmem failed");
+        } else {
+            log_released(shmem_hdr, chunk_slot, num_chunks);
         }
     }
     if (sz_in_spill > 0) {
@@ -659,17 +1307,20 @@ int unifyfs_logio_free(logio_context* ctx,
         rc = slotmap_release(chunkmap, chunk_slot, num_chunks);
         if (rc != UNIFYFS_SUCCESS) {
             LOGERR("slotmap_release() for logio spill failed");
+        } else {
+            log_released(spill_hdr, chunk_slot, num_chunks);
         }
     }
     return rc;
 }
 
-/* Read data from logio context */
-int unifyfs_logio_read(logio_context* ctx,
-                       const off_t log_offset,
-                       const size_t nbytes,
-                       char* obuf,
-                       size_t* obytes)
+/* Read data at the given storage offset, which is the same as the log
+ * offset when chunk tiering is not used */
+static int logio_read_direct(logio_context* ctx,
+                             const off_t log_offset,
+                             const size_t nbytes,
+                             char* obuf,
+                             size_t* obytes)
 {
     if ((NULL == ctx) ||
         ((nbytes > 0) && (NULL == obuf))) {
@@ -712,12 +1363,9 @@ int unifyfs_logio_read(logio_context* ctx,
         nread += sz_in_mem;
     }
     if (sz_in_spill > 0) {
-        log_header* spill_hdr = (log_header*) ctx->spill_hdr;
-        spill_offset += spill_hdr->data_offset;
-
         /* read data from spillover file */
-        ssize_t rc = pread(ctx->spill_fd, (obuf + sz_in_mem),
-                           sz_in_spill, spill_offset);
+        ssize_t rc = logio_spill_io(ctx, 0, (obuf + sz_in_mem),
+                                    sz_in_spill, spill_offset);
         if (-1 == rc) {
             err_rc = errno;
             LOGERR("pread(spillfile) failed: %s", strerror(err_rc));
@@ -739,12 +1387,27 @@ int unifyfs_logio_read(logio_context* ctx,
     }
 }
 
-/* Write data to logio context */
-int unifyfs_logio_write(logio_context* ctx,
-                        const off_t log_offset,
-                        const size_t nbytes,
-                        const char* ibuf,
-                        size_t* obytes)
+/* Read data from logio context */
+int unifyfs_logio_read(logio_context* ctx,
+                       const off_t log_offset,
+                       const size_t nbytes,
+                       char* obuf,
+                       size_t* obytes)
+{
+    if ((NULL != ctx) && (NULL != ctx->tiers) &&
+        (nbytes > 0) && (NULL != obuf)) {
+        return tier_read(ctx, log_offset, nbytes, obuf, obytes);
+    }
+    return logio_read_direct(ctx, log_offset, nbytes, obuf, obytes);
+}
+
+/* Write data at the given storage offset, which is the same as the log
+ * offset when chunk tiering is not used */
+static int logio_write_direct(logio_context* ctx,
+                              const off_t log_offset,
+                              const size_t nbytes,
+                              const char* ibuf,
+                              size_t* obytes)
 {
     if ((NULL == ctx) ||
         ((nbytes > 0) && (NULL == ibuf))) {
@@ -785,12 +1448,9 @@ int unifyfs_logio_write(logio_context* ctx,
         nwrite += sz_in_mem;
     }
     if (sz_in_spill > 0) {
-        log_header* spill_hdr = (log_header*) ctx->spill_hdr;
-        spill_offset += spill_hdr->data_offset;
-
         /* write data to spillover file */
-        ssize_t rc = pwrite(ctx->spill_fd, (ibuf + sz_in_mem),
-                            sz_in_spill, spill_offset);
+        ssize_t rc = logio_spill_io(ctx, 1, (char*)(ibuf + sz_in_mem),
+                                    sz_in_spill, spill_offset);
         if (-1 == rc) {
             err_rc = errno;
             LOGERR("pwrite(spillfile) failed: %s", strerror(err_rc));
@@ -815,18 +1475,503 @@ int unifyfs_logio_write(logio_context* ctx,
     }
 }
 
-/* Sync any spill data to disk for given logio context */
-int unifyfs_logio_sync(logio_context* ctx)
-{
-    if ((ctx->spill_sz) && (-1 != ctx->spill_fd)) {
-        /* fsync spill file */
-        int rc = fsync(ctx->spill_fd);
-        if (rc != 0) {
-            int err = errno;
-            LOGERR("Failed to fsync logio spill file (errno=%s)",
-                   strerror(err));
-            return err;
-        }
+/* Write data to logio context */
+int unifyfs_logio_write(logio_context* ctx,
+                        const off_t log_offset,
+                        const size_t nbytes,
+                        const char* ibuf,
+                        size_t* obytes)
+{
+    if ((NULL != ctx) && (NULL != ibuf) &&
+        logio_batch_worthwhile(ctx, log_offset, nbytes)) {
+        /* large write to spill, write its pieces concurrently */
+        logio_io io = {
+            .ctx = ctx,
+            .log_offset = log_offset,
+            .nbytes = nbytes,
+            .buf = (char*) ibuf
+        };
+        int rc = unifyfs_logio_write_batch(&io, 1);
+        if (rc == UNIFYFS_SUCCESS) {
+            if (NULL != obytes) {
+                *obytes = io.nio;
+            }
+            if ((io.nio > 0) || (io.rc == UNIFYFS_SUCCESS)) {
+                return UNIFYFS_SUCCESS;
+            }
+            return io.rc;
+        }
+    }
+    if ((NULL != ctx) && (NULL != ctx->tiers) &&
+        (nbytes > 0) && (NULL != ibuf)) {
+        return tier_write(ctx, log_offset, nbytes, ibuf, obytes);
+    }
+    return logio_write_direct(ctx, log_offset, nbytes, ibuf, obytes);
+}
+
+/* a piece of a batched read or write that is in the spill file */
+typedef struct logio_seg {
+    spillio_req req;
+    logio_io* io;
+    off_t log_offset;  /* log offset of the piece */
+    ssize_t ndx;       /* tier map chunk of the piece, or -1 */
+    uint32_t seq;      /* tier map sequence number when looked up */
+    char* buf;         /* caller buffer, if staged for O_DIRECT */
+    size_t len;        /* caller length, if staged for O_DIRECT */
+} logio_seg;
+
+/* most bytes of a batch to stage in aligned buffers for O_DIRECT */
+#define LOGIO_STAGE_MAX (64 * 1024 * 1024)
+
+/* whether a write is large enough, and may land in spill, so that it
+ * is worth splitting it into concurrent pieces */
+static int logio_batch_worthwhile(logio_context* ctx,
+                                  off_t log_offset,
+                                  size_t nbytes)
+{
+    if ((NULL == ctx->spill_hdr) || (-1 == ctx->spill_fd)) {
+        return 0;
+    }
+    log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+    if (nbytes <= spill_hdr->chunk_sz) {
+        return 0;
+    }
+    if ((NULL == ctx->tiers) && (NULL != ctx->shmem)) {
+        log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+        if ((log_offset + (off_t)nbytes) <= (off_t)shmem_hdr->data_sz) {
+            return 0;
+        }
+    }
+    return (NULL != unifyfs_spillio_queue());
+}
+
+/* add spill pieces of at most max_len bytes for the data at the given
+ * storage offset in the spill range. Returns the number of pieces */
+static size_t logio_add_spill_segs(logio_io* io,
+                                   int write,
+                                   off_t storage_off,
+                                   off_t mem_size,
+                                   size_t io_off,
+                                   size_t len,
+                                   size_t max_len,
+                                   ssize_t ndx,
+                                   uint32_t seq,
+                                   logio_seg* segs)
+{
+    logio_context* ctx = io->ctx;
+    off_t spill_off = storage_off - mem_size;
+    size_t count = 0;
+    while (len > 0) {
+        int fd;
+        off_t file_off;
+        size_t n = (len > max_len) ? max_len : len;
+        n = spill_locate(ctx, spill_off, n, &fd, &file_off);
+        logio_seg* seg = segs + count++;
+        memset(seg, 0, sizeof(*seg));
+        seg->req.fd = fd;
+        seg->req.write = write;
+        seg->req.buf = io->buf + io_off;
+        seg->req.len = n;
+        seg->req.offset = file_off;
+        seg->req.arg = seg;
+        seg->io = io;
+        seg->log_offset = io->log_offset + (off_t)io_off;
+        seg->ndx = ndx;
+        seg->seq = seq;
+        spill_off += (off_t) n;
+        io_off += n;
+        len -= n;
+    }
+    return count;
+}
+
+/* read or write the shmem part of a batched I/O directly */
+static void logio_batch_mem(logio_io* io,
+                            int write,
+                            off_t storage_off,
+                            size_t io_off,
+                            size_t len)
+{
+    size_t n = 0;
+    int rc;
+    if (write) {
+        rc = logio_write_direct(io->ctx, storage_off, len,
+                                io->buf + io_off, &n);
+    } else {
+        rc = logio_read_direct(io->ctx, storage_off, len,
+                               io->buf + io_off, &n);
+    }
+    if (rc != UNIFYFS_SUCCESS) {
+        io->rc = rc;
+    }
+    io->nio += n;
+}
+
+/* done writing a piece of a tiered log chunk on the client */
+static void logio_batch_tier_write_done(logio_context* ctx,
+                                        size_t ndx)
+{
+    logio_tiers* tiers = ctx->tiers;
+    pthread_mutex_lock(&(tiers->lock));
+    tiers->writers[ndx]--;
+    tiers->state[ndx] |= TIER_WRITTEN;
+    pthread_mutex_unlock(&(tiers->lock));
+}
+
+/* set up the pieces of one batched I/O, doing the shmem parts directly.
+ * Returns the number of spill pieces added to segs */
+static size_t logio_batch_prepare(logio_io* io,
+                                  int write,
+                                  logio_seg* segs)
+{
+    logio_context* ctx = io->ctx;
+    log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+    size_t chunk_sz = spill_hdr->chunk_sz;
+    off_t mem_size = 0;
+    if (NULL != ctx->shmem) {
+        log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+        mem_size = (off_t) shmem_hdr->data_sz;
+    }
+
+    size_t count = 0;
+    if (NULL == ctx->tiers) {
+        size_t sz_in_mem = 0;
+        size_t sz_in_spill = 0;
+        off_t spill_offset = 0;
+        get_log_sizes(io->log_offset, io->nbytes, (size_t)mem_size,
+                      &sz_in_mem, &sz_in_spill, &spill_offset);
+        if (sz_in_mem > 0) {
+            logio_batch_mem(io, write, io->log_offset, 0, sz_in_mem);
+        }
+        if (sz_in_spill > 0) {
+            count = logio_add_spill_segs(io, write, mem_size + spill_offset,
+                                         mem_size, sz_in_mem, sz_in_spill,
+                                         chunk_sz, -1, 0, segs);
+        }
+        return count;
+    }
+
+    /* with tiering, each chunk of the data is looked up in the tier map */
+    logio_tiers* tiers = ctx->tiers;
+    tier_map* map = tiers->map;
+    size_t done = 0;
+    while (done < io->nbytes) {
+        size_t ndx;
+        off_t chunk_off;
+        off_t pos = io->log_offset + (off_t)done;
+        int rc = unifyfs_logio_get_chunk(ctx, pos, &ndx, &chunk_off);
+        if (rc != UNIFYFS_SUCCESS) {
+            io->rc = rc;
+            break;
+        }
+        size_t within = (size_t)(pos - chunk_off);
+        size_t len = chunk_sz - within;
+        if (len > (io->nbytes - done)) {
+            len = io->nbytes - done;
+        }
+
+        tier_entry* ent = map->chunks + ndx;
+        uint32_t seq = 0;
+        uint32_t phys;
+        if (write && (NULL != tiers->state)) {
+            pthread_mutex_lock(&(tiers->lock));
+            while (tiers->state[ndx] & TIER_BUSY) {
+                pthread_cond_wait(&(tiers->cond), &(tiers->lock));
+            }
+            tiers->writers[ndx]++;
+            phys = ent->phys;
+            pthread_mutex_unlock(&(tiers->lock));
+        } else {
+            if (!write) {
+                __atomic_add_fetch(&(ent->hits), 1, __ATOMIC_RELAXED);
+            }
+            seq = __atomic_load_n(&(ent->seq), __ATOMIC_ACQUIRE);
+            while (seq & 1) {
+                /* chunk is being remapped */
+                sched_yield();
+                seq = __atomic_load_n(&(ent->seq), __ATOMIC_ACQUIRE);
+            }
+            phys = __atomic_load_n(&(ent->phys), __ATOMIC_ACQUIRE);
+        }
+
+        off_t storage_off;
+        rc = tier_phys_offset(ctx, phys, &storage_off);
+        if (rc != UNIFYFS_SUCCESS) {
+            io->rc = rc;
+            if (write && (NULL != tiers->state)) {
+                logio_batch_tier_write_done(ctx, ndx);
+            }
+            break;
+        }
+        storage_off += (off_t) within;
+
+        if (storage_off < mem_size) {
+            logio_batch_mem(io, write, storage_off, done, len);
+            if (write && (NULL != tiers->state)) {
+                logio_batch_tier_write_done(ctx, ndx);
+            } else if (!write &&
+                       (__atomic_load_n(&(ent->seq), __ATOMIC_ACQUIRE)
+                        != seq)) {
+                /* chunk moved while we read it, read it again */
+                size_t n = 0;
+                tier_read(ctx, pos, len, io->buf + done, &n);
+            }
+        } else {
+            count += logio_add_spill_segs(io, write, storage_off, mem_size,
+                                          done, len, len, (ssize_t)ndx,
+                                          seq, segs + count);
+        }
+        done += len;
+    }
+    return count;
+}
+
+/* stage spill pieces that are not aligned for O_DIRECT, but start at an
+ * aligned file offset, through aligned buffers so they can still be in
+ * flight concurrently. A partial last block of a write is read first.
+ * Returns the staging memory, or NULL if nothing was staged */
+static char* logio_batch_stage(logio_seg* segs,
+                               size_t n_segs,
+                               int write)
+{
+    size_t total = 0;
+    size_t max_align = 0;
+    for (size_t i = 0; i < n_segs; i++) {
+        logio_seg* seg = segs + i;
+        logio_context* ctx = seg->io->ctx;
+        size_t align = ctx->spill_align;
+        if (spill_io_aligned(ctx, seg->req.buf, seg->req.len,
+                             seg->req.offset) ||
+            ((size_t)seg->req.offset % align)) {
+            continue;
+        }
+        if (align > max_align) {
+            max_align = align;
+        }
+        total += seg->req.len + (2 * align);
+    }
+    if ((0 == total) || (total > LOGIO_STAGE_MAX)) {
+        return NULL;
+    }
+
+    void* stage = NULL;
+    if (0 != posix_memalign(&stage, max_align, total)) {
+        return NULL;
+    }
+
+    size_t pos = 0;
+    for (size_t i = 0; i < n_segs; i++) {
+        logio_seg* seg = segs + i;
+        logio_context* ctx = seg->io->ctx;
+        size_t align = ctx->spill_align;
+        if (spill_io_aligned(ctx, seg->req.buf, seg->req.len,
+                             seg->req.offset) ||
+            ((size_t)seg->req.offset % align)) {
+            continue;
+        }
+        pos += (align - (pos % align)) % align;
+        size_t span = seg->req.len;
+        span += (align - (span % align)) % align;
+        char* sbuf = (char*)stage + pos;
+        pos += span;
+
+        if (write) {
+            if (span != seg->req.len) {
+                off_t last = seg->req.offset + (off_t)(span - align);
+                if (pread(seg->req.fd, sbuf + (span - align), align,
+                          last) < 0) {
+                    /* leave it for a synchronous transfer */
+                    continue;
+                }
+            }
+            memcpy(sbuf, seg->req.buf, seg->req.len);
+        }
+        seg->buf = seg->req.buf;
+        seg->len = seg->req.len;
+        seg->req.buf = sbuf;
+        seg->req.len = span;
+    }
+    return (char*) stage;
+}
+
+/* read or write a batch of log data, with the spill parts in flight
+ * concurrently */
+static int logio_batch(logio_io* ios,
+                       size_t n_ios,
+                       int write)
+{
+    if ((n_ios > 0) && (NULL == ios)) {
+        return EINVAL;
+    }
+
+    spillio_queue* q = unifyfs_spillio_queue();
+
+    /* count the most spill pieces we might need */
+    size_t max_segs = 0;
+    for (size_t i = 0; i < n_ios; i++) {
+        logio_io* io = ios + i;
+        io->nio = 0;
+        io->rc = UNIFYFS_SUCCESS;
+        if ((NULL == io->ctx) || ((io->nbytes > 0) && (NULL == io->buf))) {
+            io->rc = EINVAL;
+        } else if ((NULL != q) && (NULL != io->ctx->spill_hdr)) {
+            log_header* spill_hdr = (log_header*) io->ctx->spill_hdr;
+            max_segs += (io->nbytes / spill_hdr->chunk_sz) + 2;
+        }
+    }
+
+    logio_seg* segs = NULL;
+    spillio_req** reqs = NULL;
+    if (max_segs > 0) {
+        segs = calloc(max_segs, sizeof(logio_seg));
+        reqs = calloc(max_segs, sizeof(spillio_req*));
+        if ((NULL == segs) || (NULL == reqs)) {
+            free(segs);
+            free(reqs);
+            segs = NULL;
+            reqs = NULL;
+        }
+    }
+
+    size_t n_segs = 0;
+    for (size_t i = 0; i < n_ios; i++) {
+        logio_io* io = ios + i;
+        if ((io->rc != UNIFYFS_SUCCESS) || (0 == io->nbytes)) {
+            continue;
+        }
+        if ((NULL == segs) || (NULL == io->ctx->spill_hdr)) {
+            /* no spill, or no queue - use a synchronous transfer */
+            if (write && (NULL != io->ctx->tiers)) {
+                io->rc = tier_write(io->ctx, io->log_offset, io->nbytes,
+                                    io->buf, &(io->nio));
+            } else if (write) {
+                io->rc = logio_write_direct(io->ctx, io->log_offset,
+                                            io->nbytes, io->buf, &(io->nio));
+            } else {
+                io->rc = unifyfs_logio_read(io->ctx, io->log_offset,
+                                            io->nbytes, io->buf, &(io->nio));
+            }
+            continue;
+        }
+        n_segs += logio_batch_prepare(io, write, segs + n_segs);
+    }
+
+    char* stage = NULL;
+    if (n_segs > 0) {
+        /* pieces that are not aligned for O_DIRECT are staged, or else
+         * transferred synchronously after the others complete, so the
+         * partial blocks they share are not updated concurrently */
+        stage = logio_batch_stage(segs, n_segs, write);
+        size_t n_reqs = 0;
+        for (size_t i = 0; i < n_segs; i++) {
+            logio_seg* seg = segs + i;
+            if (spill_io_aligned(seg->io->ctx, seg->req.buf, seg->req.len,
+                                 seg->req.offset)) {
+                reqs[n_reqs++] = &(seg->req);
+            }
+        }
+        unifyfs_spillio_run(q, reqs, n_reqs);
+        for (size_t i = 0; i < n_segs; i++) {
+            logio_seg* seg = segs + i;
+            if (!spill_io_aligned(seg->io->ctx, seg->req.buf, seg->req.len,
+                                  seg->req.offset)) {
+                ssize_t n = logio_spill_pio(seg->io->ctx, seg->req.fd, write,
+                                            seg->req.buf, seg->req.len,
+                                            seg->req.offset);
+                seg->req.result = (n < 0) ? -errno : n;
+            } else if (NULL != seg->buf) {
+                /* copy out of staging, counting only the caller's bytes */
+                ssize_t n = seg->req.result;
+                if (n > (ssize_t)seg->len) {
+                    n = (ssize_t)seg->len;
+                }
+                if (!write && (n > 0)) {
+                    memcpy(seg->buf, seg->req.buf, (size_t)n);
+                }
+                seg->req.result = n;
+                seg->req.buf = seg->buf;
+                seg->req.len = seg->len;
+            }
+        }
+
+        for (size_t i = 0; i < n_segs; i++) {
+            logio_seg* seg = segs + i;
+            logio_io* io = seg->io;
+            logio_context* ctx = io->ctx;
+            ssize_t result = seg->req.result;
+            if ((-1 != seg->ndx) && (NULL != ctx->tiers)) {
+                tier_entry* ent = ctx->tiers->map->chunks + seg->ndx;
+                if (write && (NULL != ctx->tiers->state)) {
+                    logio_batch_tier_write_done(ctx, (size_t)seg->ndx);
+                } else if (!write &&
+                           (__atomic_load_n(&(ent->seq), __ATOMIC_ACQUIRE)
+                            != seg->seq)) {
+                    /* chunk moved while we read it, read it again */
+                    size_t n = 0;
+                    int rc = tier_read(ctx, seg->log_offset, seg->req.len,
+                                       seg->req.buf, &n);
+                    result = (rc == UNIFYFS_SUCCESS) ? (ssize_t)n : -rc;
+                }
+            }
+            if (result < 0) {
+                io->rc = (int)(-result);
+                LOGERR("%s(spillfile) failed: %s",
+                       (write ? "pwrite" : "pread"), strerror(io->rc));
+            } else {
+                io->nio += (size_t) result;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n_ios; i++) {
+        logio_io* io = ios + i;
+        if ((io->nio > 0) && (io->nio != io->nbytes)) {
+            LOGDBG("partial log %s: %zu of %zu bytes",
+                   (write ? "write" : "read"), io->nio, io->nbytes);
+        }
+    }
+
+    free(stage);
+    free(segs);
+    free(reqs);
+    return UNIFYFS_SUCCESS;
+}
+
+/* Read a batch of data from logio contexts */
+int unifyfs_logio_read_batch(logio_io* ios,
+                             size_t n_ios)
+{
+    return logio_batch(ios, n_ios, 0);
+}
+
+/* Write a batch of data to logio contexts */
+int unifyfs_logio_write_batch(logio_io* ios,
+                              size_t n_ios)
+{
+    return logio_batch(ios, n_ios, 1);
+}
+
+/* Sync any spill data to disk for given logio context */
+int unifyfs_logio_sync(logio_context* ctx)
+{
+    if ((ctx->spill_sz) && (-1 != ctx->spill_fd)) {
+        /* fsync spill files. With O_DIRECT, the data is not cached, and
+         * only the block allocations need to be flushed */
+        for (int i = 0; i < ctx->spill_nstripes; i++) {
+            int fd = ctx->spill_stripe_fds[i];
+            int rc;
+            if (ctx->spill_align) {
+                rc = fdatasync(fd);
+            } else {
+                rc = fsync(fd);
+            }
+            if (rc != 0) {
+                int err = errno;
+                LOGERR("Failed to fsync logio spill file (errno=%s)",
+                       strerror(err));
+                return err;
+            }
+        }
     }
     return UNIFYFS_SUCCESS;
 }
@@ -858,3 +2003,887 @@ int unifyfs_logio_get_sizes(logio_context* ctx,
 
     return UNIFYFS_SUCCESS;
 }
+
+/* Get the shmem and spill data bytes currently in use */
+int unifyfs_logio_get_usage(logio_context* ctx,
+                            size_t* shmem_used,
+                            size_t* spill_used)
+{
+    if (NULL == ctx) {
+        return EINVAL;
+    }
+
+    if (NULL != shmem_used) {
+        *shmem_used = 0;
+        if (NULL != ctx->shmem) {
+            log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+            slot_map* chunkmap = log_header_to_chunkmap(shmem_hdr);
+            *shmem_used = chunkmap->used_slots * shmem_hdr->chunk_sz;
+        }
+    }
+
+    if (NULL != spill_used) {
+        *spill_used = 0;
+        if (NULL != ctx->spill_hdr) {
+            log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+            slot_map* chunkmap = log_header_to_chunkmap(spill_hdr);
+            *spill_used = chunkmap->used_slots * spill_hdr->chunk_sz;
+        }
+    }
+
+    return UNIFYFS_SUCCESS;
+}
+
+/* Get the number of data chunks in the log and the chunk size */
+int unifyfs_logio_get_chunks(logio_context* ctx,
+                             size_t* n_chunks,
+                             size_t* chunk_sz)
+{
+    if (NULL == ctx) {
+        return EINVAL;
+    }
+
+    size_t count = 0;
+    size_t csz = 0;
+    if (NULL != ctx->shmem) {
+        log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+        slot_map* chunkmap = log_header_to_chunkmap(shmem_hdr);
+        count += chunkmap->total_slots;
+        csz = shmem_hdr->chunk_sz;
+    }
+    if (NULL != ctx->spill_hdr) {
+        log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+        slot_map* chunkmap = log_header_to_chunkmap(spill_hdr);
+        count += chunkmap->total_slots;
+        csz = spill_hdr->chunk_sz;
+    }
+
+    if (NULL != n_chunks) {
+        *n_chunks = count;
+    }
+    if (NULL != chunk_sz) {
+        *chunk_sz = csz;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* Get the chunk holding the data at a given log offset */
+int unifyfs_logio_get_chunk(logio_context* ctx,
+                            const off_t log_offset,
+                            size_t* chunk_ndx,
+                            off_t* chunk_offset)
+{
+    if ((NULL == ctx) || (NULL == chunk_ndx) || (log_offset < 0)) {
+        return EINVAL;
+    }
+
+    size_t mem_chunks = 0;
+    off_t mem_size = 0;
+    size_t ndx;
+    if (NULL != ctx->shmem) {
+        log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+        slot_map* chunkmap = log_header_to_chunkmap(shmem_hdr);
+        mem_chunks = chunkmap->total_slots;
+        mem_size = (off_t) shmem_hdr->data_sz;
+        if (log_offset < mem_size) {
+            ndx = (size_t)log_offset / shmem_hdr->chunk_sz;
+            if (ndx >= mem_chunks) {
+                return EINVAL;
+            }
+            *chunk_ndx = ndx;
+            if (NULL != chunk_offset) {
+                *chunk_offset = (off_t)(ndx * shmem_hdr->chunk_sz);
+            }
+            return UNIFYFS_SUCCESS;
+        }
+    }
+
+    if (NULL != ctx->spill_hdr) {
+        log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+        slot_map* chunkmap = log_header_to_chunkmap(spill_hdr);
+        ndx = (size_t)(log_offset - mem_size) / spill_hdr->chunk_sz;
+        if (ndx < chunkmap->total_slots) {
+            *chunk_ndx = mem_chunks + ndx;
+            if (NULL != chunk_offset) {
+                *chunk_offset = mem_size + (off_t)(ndx * spill_hdr->chunk_sz);
+            }
+            return UNIFYFS_SUCCESS;
+        }
+    }
+
+    return EINVAL;
+}
+
+/* Get the log offset of the start of a chunk */
+int unifyfs_logio_chunk_offset(logio_context* ctx,
+                               const size_t chunk_ndx,
+                               off_t* log_offset)
+{
+    if ((NULL == ctx) || (NULL == log_offset)) {
+        return EINVAL;
+    }
+
+    size_t ndx = chunk_ndx;
+    off_t mem_size = 0;
+    if (NULL != ctx->shmem) {
+        log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+        slot_map* chunkmap = log_header_to_chunkmap(shmem_hdr);
+        if (ndx < chunkmap->total_slots) {
+            *log_offset = (off_t)(ndx * shmem_hdr->chunk_sz);
+            return UNIFYFS_SUCCESS;
+        }
+        ndx -= chunkmap->total_slots;
+        mem_size = (off_t) shmem_hdr->data_sz;
+    }
+
+    if (NULL != ctx->spill_hdr) {
+        log_header* spill_hdr = (log_header*) ctx->spill_hdr;
+        slot_map* chunkmap = log_header_to_chunkmap(spill_hdr);
+        if (ndx < chunkmap->total_slots) {
+            *log_offset = mem_size + (off_t)(ndx * spill_hdr->chunk_sz);
+            return UNIFYFS_SUCCESS;
+        }
+    }
+
+    return EINVAL;
+}
+
+/* ---- chunk tiering ---- */
+
+/* get the log chunk range covering the given log data */
+static int tier_chunk_range(logio_context* ctx,
+                            off_t log_offset,
+                            size_t nbytes,
+                            size_t* first,
+                            size_t* last)
+{
+    int rc = unifyfs_logio_get_chunk(ctx, log_offset, first, NULL);
+    if (rc == UNIFYFS_SUCCESS) {
+        off_t end = log_offset + (off_t)nbytes - 1;
+        rc = unifyfs_logio_get_chunk(ctx, end, last, NULL);
+    }
+    return rc;
+}
+
+/* get the storage offset of a physical chunk, which is numbered like
+ * the log chunks */
+static int tier_phys_offset(logio_context* ctx,
+                            uint32_t phys,
+                            off_t* offset)
+{
+    return unifyfs_logio_chunk_offset(ctx, (size_t)phys, offset);
+}
+
+/* set the physical chunk of a log chunk, so that readers that may have
+ * used the old physical chunk will retry */
+static void tier_remap(tier_entry* ent,
+                       uint32_t phys)
+{
+    __atomic_add_fetch(&(ent->seq), 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&(ent->phys), phys, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&(ent->seq), 1, __ATOMIC_ACQ_REL);
+}
+
+/* find a free physical chunk in the given range, or return -1 */
+static ssize_t tier_find_free(logio_tiers* tiers,
+                              size_t begin,
+                              size_t end)
+{
+    for (size_t p = begin; p < end; p++) {
+        if (!tiers->phys_used[p]) {
+            return (ssize_t) p;
+        }
+    }
+    return -1;
+}
+
+/* mark a physical chunk as used or free (caller holds lock) */
+static void tier_set_used(logio_tiers* tiers,
+                          size_t phys,
+                          int used)
+{
+    size_t* nfree = (phys < tiers->map->mem_chunks) ?
+                    &(tiers->mem_free) : &(tiers->spill_free);
+    if (used && !tiers->phys_used[phys]) {
+        tiers->phys_used[phys] = 1;
+        (*nfree)--;
+    } else if (!used && tiers->phys_used[phys]) {
+        tiers->phys_used[phys] = 0;
+        (*nfree)++;
+    }
+}
+
+/* move the data of a log chunk to the given free physical chunk. The lock
+ * is held by the caller, and released while copying the data */
+static int tier_move(logio_context* ctx,
+                     size_t ndx,
+                     size_t new_phys)
+{
+    logio_tiers* tiers = ctx->tiers;
+    tier_entry* ent = tiers->map->chunks + ndx;
+    size_t old_phys = (size_t) ent->phys;
+    size_t chunk_sz;
+    unifyfs_logio_get_chunks(ctx, NULL, &chunk_sz);
+
+    /* writes and frees of the chunk wait until the move is done */
+    tier_set_used(tiers, new_phys, 1);
+    tiers->state[ndx] |= TIER_BUSY;
+    pthread_mutex_unlock(&(tiers->lock));
+
+    off_t src, dst;
+    size_t nread = 0;
+    size_t nwrite = 0;
+    int rc = tier_phys_offset(ctx, (uint32_t)old_phys, &src);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = tier_phys_offset(ctx, (uint32_t)new_phys, &dst);
+    }
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = logio_read_direct(ctx, src, chunk_sz, tiers->buf, &nread);
+    }
+    if ((rc == UNIFYFS_SUCCESS) && (nread == chunk_sz)) {
+        rc = logio_write_direct(ctx, dst, chunk_sz, tiers->buf, &nwrite);
+    }
+    if ((rc == UNIFYFS_SUCCESS) && (nwrite != chunk_sz)) {
+        rc = EIO;
+    }
+
+    pthread_mutex_lock(&(tiers->lock));
+    if (rc == UNIFYFS_SUCCESS) {
+        tier_remap(ent, (uint32_t)new_phys);
+        tier_set_used(tiers, old_phys, 0);
+    } else {
+        LOGERR("failed to move log chunk %zu (rc=%d)", ndx, rc);
+        tier_set_used(tiers, new_phys, 0);
+    }
+    tiers->state[ndx] &= ~TIER_BUSY;
+    pthread_cond_broadcast(&(tiers->cond));
+    return rc;
+}
+
+/* pick the log chunk to move out of shmem, or return -1. Chunks advised
+ * as not needed go first, then the least read chunks while fewer than
+ * the target number of shmem chunks are free */
+static ssize_t tier_pick_demote(logio_tiers* tiers)
+{
+    tier_map* map = tiers->map;
+    ssize_t coldest = -1;
+    uint32_t coldest_hits = UINT32_MAX;
+    int need_space = (tiers->mem_free < tiers->free_target);
+    for (size_t i = 0; i < map->n_chunks; i++) {
+        uint8_t st = tiers->state[i];
+        if (((st & (TIER_WRITTEN | TIER_BUSY)) != TIER_WRITTEN) ||
+            (tiers->writers[i] > 0) ||
+            (map->chunks[i].phys >= map->mem_chunks)) {
+            continue;
+        }
+        if (st & TIER_DONTNEED) {
+            return (ssize_t) i;
+        }
+        if (need_space && !(st & TIER_WILLNEED)) {
+            uint32_t hits = __atomic_load_n(&(map->chunks[i].hits),
+                                            __ATOMIC_RELAXED);
+            if (hits < coldest_hits) {
+                coldest = (ssize_t) i;
+                coldest_hits = hits;
+            }
+        }
+    }
+    return coldest;
+}
+
+/* pick the spill chunk to move into shmem, or return -1. Chunks advised
+ * as needed go first, then the most read chunks over the hot threshold.
+ * Like demotion, only written chunks are moved, since another process
+ * may still be writing the others in place */
+static ssize_t tier_pick_promote(logio_tiers* tiers)
+{
+    tier_map* map = tiers->map;
+    ssize_t hottest = -1;
+    uint32_t hottest_hits = 0;
+    for (size_t i = 0; i < map->n_chunks; i++) {
+        uint8_t st = tiers->state[i];
+        if (((st & (TIER_WRITTEN | TIER_BUSY)) != TIER_WRITTEN) ||
+            (st & TIER_DONTNEED) ||
+            (tiers->writers[i] > 0) ||
+            (map->chunks[i].phys < map->mem_chunks)) {
+            continue;
+        }
+        if (st & TIER_WILLNEED) {
+            return (ssize_t) i;
+        }
+        uint32_t hits = __atomic_load_n(&(map->chunks[i].hits),
+                                        __ATOMIC_RELAXED);
+        if ((hits >= UNIFYFS_LOGIO_TIER_HOT_HITS) && (hits > hottest_hits)) {
+            hottest = (ssize_t) i;
+            hottest_hits = hits;
+        }
+    }
+    return hottest;
+}
+
+/* one pass of the tiering thread (caller holds lock) */
+static void tier_pass(logio_context* ctx)
+{
+    logio_tiers* tiers = ctx->tiers;
+    tier_map* map = tiers->map;
+    ssize_t ndx, phys;
+
+    /* demote while spill has room */
+    while (!tiers->stop && (tiers->spill_free > 0)) {
+        ndx = tier_pick_demote(tiers);
+        if (-1 == ndx) {
+            break;
+        }
+        phys = tier_find_free(tiers, map->mem_chunks, map->n_chunks);
+        if (-1 == phys) {
+            break;
+        }
+        tiers->state[ndx] &= ~TIER_DONTNEED;
+        if (tier_move(ctx, (size_t)ndx, (size_t)phys) == UNIFYFS_SUCCESS) {
+            tiers->demoted++;
+        }
+    }
+
+    /* promote while shmem has more free chunks than we keep for writes */
+    while (!tiers->stop && (tiers->mem_free > tiers->free_target)) {
+        ndx = tier_pick_promote(tiers);
+        if (-1 == ndx) {
+            break;
+        }
+        phys = tier_find_free(tiers, 0, map->mem_chunks);
+        if (-1 == phys) {
+            break;
+        }
+        tiers->state[ndx] &= ~TIER_WILLNEED;
+        if (tier_move(ctx, (size_t)ndx, (size_t)phys) == UNIFYFS_SUCCESS) {
+            tiers->promoted++;
+        }
+    }
+
+    /* age the read counts so that promotion follows recent reads */
+    for (size_t i = 0; i < map->n_chunks; i++) {
+        uint32_t hits = __atomic_load_n(&(map->chunks[i].hits),
+                                        __ATOMIC_RELAXED);
+        if (hits) {
+            __atomic_store_n(&(map->chunks[i].hits), hits / 2,
+                             __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/* tiering thread main loop */
+static void* tier_thread_main(void* arg)
+{
+    logio_context* ctx = (logio_context*) arg;
+    logio_tiers* tiers = ctx->tiers;
+
+    pthread_mutex_lock(&(tiers->lock));
+    while (!tiers->stop) {
+        struct timeval now;
+        struct timespec wakeup;
+        gettimeofday(&now, NULL);
+        uint64_t usecs = (uint64_t)now.tv_usec + tiers->interval_us;
+        wakeup.tv_sec = now.tv_sec + (time_t)(usecs / 1000000);
+        wakeup.tv_nsec = (long)(usecs % 1000000) * 1000;
+        pthread_cond_timedwait(&(tiers->cond), &(tiers->lock), &wakeup);
+        if (!tiers->stop) {
+            tier_pass(ctx);
+        }
+    }
+    pthread_mutex_unlock(&(tiers->lock));
+    return NULL;
+}
+
+/* create the tier map of a client log and start the tiering thread */
+static int tier_init_client(logio_context* ctx,
+                            const int app_id,
+                            const int client_id,
+                            const unifyfs_cfg_t* client_cfg)
+{
+    long l;
+    bool b;
+
+    bool enabled = true;
+    if ((NULL != client_cfg->logio_tiering) &&
+        (0 == configurator_bool_val(client_cfg->logio_tiering, &b))) {
+        enabled = b;
+    }
+    if (!enabled) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    uint64_t interval = UNIFYFS_LOGIO_TIER_INTERVAL;
+    if ((NULL != client_cfg->logio_tier_interval) &&
+        (0 == configurator_int_val(client_cfg->logio_tier_interval, &l)) &&
+        (l > 0)) {
+        interval = (uint64_t) l;
+    }
+    long free_pct = UNIFYFS_LOGIO_TIER_FREE_PCT;
+    if ((NULL != client_cfg->logio_tier_free_pct) &&
+        (0 == configurator_int_val(client_cfg->logio_tier_free_pct, &l)) &&
+        (l >= 0) && (l <= 100)) {
+        free_pct = l;
+    }
+
+    log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+    slot_map* chunkmap = log_header_to_chunkmap(shmem_hdr);
+    size_t mem_chunks = chunkmap->total_slots;
+    size_t n_chunks = 0;
+    size_t chunk_sz = 0;
+    unifyfs_logio_get_chunks(ctx, &n_chunks, &chunk_sz);
+    if ((0 == mem_chunks) || (mem_chunks == n_chunks) ||
+        (n_chunks > UINT32_MAX)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    logio_tiers* tiers = calloc(1, sizeof(logio_tiers));
+    if (NULL == tiers) {
+        return ENOMEM;
+    }
+    tiers->state = calloc(n_chunks, sizeof(uint8_t));
+    tiers->writers = calloc(n_chunks, sizeof(uint16_t));
+    tiers->phys_used = calloc(n_chunks, sizeof(uint8_t));
+    /* the copy buffer is aligned for O_DIRECT transfers of whole chunks */
+    void* buf = NULL;
+    size_t buf_align = get_page_size();
+    if (ctx->spill_align > buf_align) {
+        buf_align = ctx->spill_align;
+    }
+    if (0 == posix_memalign(&buf, buf_align, chunk_sz)) {
+        tiers->buf = buf;
+    }
+    if ((NULL == tiers->state) || (NULL == tiers->writers) ||
+        (NULL == tiers->phys_used) || (NULL == tiers->buf)) {
+        LOGERR("failed to allocate tiering state for %zu chunks", n_chunks);
+        free(tiers->state);
+        free(tiers->writers);
+        free(tiers->phys_used);
+        free(tiers->buf);
+        free(tiers);
+        return ENOMEM;
+    }
+
+    /* create the shared tier map, with each chunk initially held by the
+     * physical chunk of the same index */
+    char shm_name[SHMEM_NAME_LEN] = {0};
+    snprintf(shm_name, sizeof(shm_name), LOGIO_TIERS_FMTSTR,
+             app_id, client_id);
+    size_t map_sz = sizeof(tier_map) + (n_chunks * sizeof(tier_entry));
+    tiers->shm = unifyfs_shm_alloc(shm_name, map_sz);
+    if (NULL == tiers->shm) {
+        LOGERR("Failed to create logio tier map shmem region!");
+        free(tiers->state);
+        free(tiers->writers);
+        free(tiers->phys_used);
+        free(tiers->buf);
+        free(tiers);
+        return UNIFYFS_ERROR_SHMEM;
+    }
+    tiers->map = (tier_map*) tiers->shm->addr;
+    memset(tiers->map, 0, map_sz);
+    tiers->map->n_chunks = n_chunks;
+    tiers->map->mem_chunks = mem_chunks;
+    for (size_t i = 0; i < n_chunks; i++) {
+        tiers->map->chunks[i].phys = (uint32_t) i;
+    }
+    tiers->mem_free = mem_chunks;
+    tiers->spill_free = n_chunks - mem_chunks;
+    tiers->free_target = (mem_chunks * (size_t)free_pct) / 100;
+    tiers->interval_us = interval;
+    pthread_mutex_init(&(tiers->lock), NULL);
+    pthread_cond_init(&(tiers->cond), NULL);
+    ctx->tiers = tiers;
+
+    /* tell the server to read through the tier map */
+    shmem_hdr->tier_sz = map_sz;
+
+    int rc = pthread_create(&(tiers->thrd), NULL, tier_thread_main, ctx);
+    if (rc != 0) {
+        LOGERR("failed to create logio tiering thread (rc=%d)", rc);
+        return UNIFYFS_FAILURE;
+    }
+    tiers->thrd_active = 1;
+    LOGDBG("logio chunk tiering - %zu shmem chunks, %zu spill chunks, "
+           "keeping %zu shmem chunks free",
+           mem_chunks, n_chunks - mem_chunks, tiers->free_target);
+    return UNIFYFS_SUCCESS;
+}
+
+/* attach to the tier map of a client log, if it uses one */
+static int tier_init_server(logio_context* ctx,
+                            const int app_id,
+                            const int client_id)
+{
+    log_header* shmem_hdr = (log_header*) ctx->shmem->addr;
+    size_t map_sz = shmem_hdr->tier_sz;
+    if (0 == map_sz) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    logio_tiers* tiers = calloc(1, sizeof(logio_tiers));
+    if (NULL == tiers) {
+        return ENOMEM;
+    }
+    char shm_name[SHMEM_NAME_LEN] = {0};
+    snprintf(shm_name, sizeof(shm_name), LOGIO_TIERS_FMTSTR,
+             app_id, client_id);
+    tiers->shm = unifyfs_shm_alloc(shm_name, map_sz);
+    if (NULL == tiers->shm) {
+        free(tiers);
+        return UNIFYFS_ERROR_SHMEM;
+    }
+    tiers->map = (tier_map*) tiers->shm->addr;
+    ctx->tiers = tiers;
+    return UNIFYFS_SUCCESS;
+}
+
+/* stop the tiering thread and release tiering state */
+static void tier_fini(logio_context* ctx)
+{
+    logio_tiers* tiers = ctx->tiers;
+    if (tiers->thrd_active) {
+        pthread_mutex_lock(&(tiers->lock));
+        tiers->stop = 1;
+        pthread_cond_broadcast(&(tiers->cond));
+        pthread_mutex_unlock(&(tiers->lock));
+        pthread_join(tiers->thrd, NULL);
+        tiers->thrd_active = 0;
+        LOGDBG("logio chunk tiering - demoted %zu, promoted %zu chunks",
+               tiers->demoted, tiers->promoted);
+    }
+    if (NULL != tiers->state) {
+        /* client owns the tier map */
+        pthread_mutex_destroy(&(tiers->lock));
+        pthread_cond_destroy(&(tiers->cond));
+        free(tiers->state);
+        free(tiers->writers);
+        free(tiers->phys_used);
+        free(tiers->buf);
+    }
+    if (NULL != tiers->shm) {
+        int rc = unifyfs_shm_free(&(tiers->shm));
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("Failed to release logio tier map shmem region!");
+        }
+    }
+    free(tiers);
+    ctx->tiers = NULL;
+}
+
+/* assign free physical chunks to newly allocated log chunks, preferring
+ * shmem */
+static int tier_assign(logio_context* ctx,
+                       off_t log_offset,
+                       size_t nbytes)
+{
+    logio_tiers* tiers = ctx->tiers;
+    if (NULL == tiers->state) {
+        return UNIFYFS_SUCCESS;
+    }
+    tier_map* map = tiers->map;
+
+    size_t first, last;
+    int rc = tier_chunk_range(ctx, log_offset, nbytes, &first, &last);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    pthread_mutex_lock(&(tiers->lock));
+    for (size_t i = first; i <= last; i++) {
+        ssize_t phys = -1;
+        while (-1 == phys) {
+            phys = tier_find_free(tiers, 0, map->mem_chunks);
+            if (-1 == phys) {
+                phys = tier_find_free(tiers, map->mem_chunks, map->n_chunks);
+            }
+            if (-1 == phys) {
+                /* every log chunk has one physical chunk, so one will be
+                 * free once a move in progress is done */
+                pthread_cond_wait(&(tiers->cond), &(tiers->lock));
+            }
+        }
+        tier_set_used(tiers, (size_t)phys, 1);
+        tiers->state[i] = TIER_ALLOCATED;
+        tiers->writers[i] = 0;
+        __atomic_store_n(&(map->chunks[i].hits), 0, __ATOMIC_RELAXED);
+        tier_remap(map->chunks + i, (uint32_t)phys);
+    }
+    if (tiers->mem_free < tiers->free_target) {
+        /* wake the thread to make room in shmem */
+        pthread_cond_broadcast(&(tiers->cond));
+    }
+    pthread_mutex_unlock(&(tiers->lock));
+    return UNIFYFS_SUCCESS;
+}
+
+/* release the physical chunks of freed log chunks */
+static void tier_release(logio_context* ctx,
+                         off_t log_offset,
+                         size_t nbytes)
+{
+    logio_tiers* tiers = ctx->tiers;
+    if (NULL == tiers->state) {
+        return;
+    }
+
+    size_t first, last;
+    if (tier_chunk_range(ctx, log_offset, nbytes, &first, &last)
+        != UNIFYFS_SUCCESS) {
+        return;
+    }
+
+    pthread_mutex_lock(&(tiers->lock));
+    for (size_t i = first; i <= last; i++) {
+        while (tiers->state[i] & TIER_BUSY) {
+            pthread_cond_wait(&(tiers->cond), &(tiers->lock));
+        }
+        if (tiers->state[i] & TIER_ALLOCATED) {
+            tier_set_used(tiers, (size_t)tiers->map->chunks[i].phys, 0);
+        }
+        tiers->state[i] = 0;
+    }
+    pthread_mutex_unlock(&(tiers->lock));
+}
+
+/* read log data through the tier map */
+static int tier_read(logio_context* ctx,
+                     off_t log_offset,
+                     size_t nbytes,
+                     char* obuf,
+                     size_t* obytes)
+{
+    tier_map* map = ctx->tiers->map;
+    size_t chunk_sz;
+    unifyfs_logio_get_chunks(ctx, NULL, &chunk_sz);
+
+    int rc = UNIFYFS_SUCCESS;
+    size_t done = 0;
+    while (done < nbytes) {
+        size_t ndx;
+        off_t chunk_off;
+        off_t pos = log_offset + (off_t)done;
+        rc = unifyfs_logio_get_chunk(ctx, pos, &ndx, &chunk_off);
+        if (rc != UNIFYFS_SUCCESS) {
+            break;
+        }
+        size_t within = (size_t)(pos - chunk_off);
+        size_t len = chunk_sz - within;
+        if (len > (nbytes - done)) {
+            len = nbytes - done;
+        }
+
+        tier_entry* ent = map->chunks + ndx;
+        __atomic_add_fetch(&(ent->hits), 1, __ATOMIC_RELAXED);
+        size_t nread = 0;
+        while (1) {
+            uint32_t seq = __atomic_load_n(&(ent->seq), __ATOMIC_ACQUIRE);
+            if (seq & 1) {
+                /* chunk is being remapped */
+                sched_yield();
+                continue;
+            }
+            uint32_t phys = __atomic_load_n(&(ent->phys), __ATOMIC_ACQUIRE);
+            off_t phys_off;
+            rc = tier_phys_offset(ctx, phys, &phys_off);
+            if (rc == UNIFYFS_SUCCESS) {
+                rc = logio_read_direct(ctx, phys_off + (off_t)within, len,
+                                       obuf + done, &nread);
+            }
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&(ent->seq), __ATOMIC_RELAXED) == seq) {
+                break;
+            }
+        }
+        if (rc != UNIFYFS_SUCCESS) {
+            break;
+        }
+        done += nread;
+        if (nread < len) {
+            break;
+        }
+    }
+
+    if (NULL != obytes) {
+        *obytes = done;
+    }
+    if (done) {
+        return UNIFYFS_SUCCESS;
+    }
+    return rc;
+}
+
+/* write log data through the tier map */
+static int tier_write(logio_context* ctx,
+                      off_t log_offset,
+                      size_t nbytes,
+                      const char* ibuf,
+                      size_t* obytes)
+{
+    logio_tiers* tiers = ctx->tiers;
+    tier_map* map = tiers->map;
+    size_t chunk_sz;
+    unifyfs_logio_get_chunks(ctx, NULL, &chunk_sz);
+
+    int rc = UNIFYFS_SUCCESS;
+    size_t done = 0;
+    while (done < nbytes) {
+        size_t ndx;
+        off_t chunk_off;
+        off_t pos = log_offset + (off_t)done;
+        rc = unifyfs_logio_get_chunk(ctx, pos, &ndx, &chunk_off);
+        if (rc != UNIFYFS_SUCCESS) {
+            break;
+        }
+        size_t within = (size_t)(pos - chunk_off);
+        size_t len = chunk_sz - within;
+        if (len > (nbytes - done)) {
+            len = nbytes - done;
+        }
+
+        /* on the client, keep the chunk in place while writing. Chunks
+         * the server writes are not moved until the client marks them
+         * written with unifyfs_logio_set_written() */
+        uint32_t phys;
+        if (NULL != tiers->state) {
+            pthread_mutex_lock(&(tiers->lock));
+            while (tiers->state[ndx] & TIER_BUSY) {
+                pthread_cond_wait(&(tiers->cond), &(tiers->lock));
+            }
+            tiers->writers[ndx]++;
+            phys = map->chunks[ndx].phys;
+            pthread_mutex_unlock(&(tiers->lock));
+        } else {
+            phys = __atomic_load_n(&(map->chunks[ndx].phys),
+                                   __ATOMIC_ACQUIRE);
+        }
+
+        size_t nwrite = 0;
+        off_t phys_off;
+        rc = tier_phys_offset(ctx, phys, &phys_off);
+        if (rc == UNIFYFS_SUCCESS) {
+            rc = logio_write_direct(ctx, phys_off + (off_t)within, len,
+                                    ibuf + done, &nwrite);
+        }
+
+        if (NULL != tiers->state) {
+            pthread_mutex_lock(&(tiers->lock));
+            tiers->writers[ndx]--;
+            tiers->state[ndx] |= TIER_WRITTEN;
+            pthread_mutex_unlock(&(tiers->lock));
+        }
+        if (rc != UNIFYFS_SUCCESS) {
+            break;
+        }
+        done += nwrite;
+        if (nwrite < len) {
+            break;
+        }
+    }
+
+    if (NULL != obytes) {
+        *obytes = done;
+    }
+    if (done) {
+        return UNIFYFS_SUCCESS;
+    }
+    return rc;
+}
+
+/* Give a hint on future access to log data */
+int unifyfs_logio_advise(logio_context* ctx,
+                         const off_t log_offset,
+                         const size_t nbytes,
+                         int advice)
+{
+    if ((NULL == ctx) || (log_offset < 0)) {
+        return EINVAL;
+    }
+    if ((advice != LOGIO_ADVICE_WILLNEED) &&
+        (advice != LOGIO_ADVICE_DONTNEED)) {
+        return EINVAL;
+    }
+
+    logio_tiers* tiers = ctx->tiers;
+    if ((0 == nbytes) || (NULL == tiers) || (NULL == tiers->state)) {
+        /* just a hint, nothing to do without tiering */
+        return UNIFYFS_SUCCESS;
+    }
+
+    size_t first, last;
+    int rc = tier_chunk_range(ctx, log_offset, nbytes, &first, &last);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    uint8_t set = (advice == LOGIO_ADVICE_WILLNEED) ?
+                  TIER_WILLNEED : TIER_DONTNEED;
+    uint8_t clear = (advice == LOGIO_ADVICE_WILLNEED) ?
+                    TIER_DONTNEED : TIER_WILLNEED;
+    pthread_mutex_lock(&(tiers->lock));
+    for (size_t i = first; i <= last; i++) {
+        if (tiers->state[i] & TIER_ALLOCATED) {
+            tiers->state[i] = (tiers->state[i] & ~clear) | set;
+        }
+    }
+    pthread_cond_broadcast(&(tiers->cond));
+    pthread_mutex_unlock(&(tiers->lock));
+    return UNIFYFS_SUCCESS;
+}
+
+/* Mark log data written by another process as written */
+int unifyfs_logio_set_written(logio_context* ctx,
+                              const off_t log_offset,
+                              const size_t nbytes)
+{
+    if ((NULL == ctx) || (log_offset < 0)) {
+        return EINVAL;
+    }
+
+    logio_tiers* tiers = ctx->tiers;
+    if ((0 == nbytes) || (NULL == tiers) || (NULL == tiers->state)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    size_t first, last;
+    int rc = tier_chunk_range(ctx, log_offset, nbytes, &first, &last);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    pthread_mutex_lock(&(tiers->lock));
+    for (size_t i = first; i <= last; i++) {
+        if (tiers->state[i] & TIER_ALLOCATED) {
+            tiers->state[i] |= TIER_WRITTEN;
+        }
+    }
+    pthread_mutex_unlock(&(tiers->lock));
+    return UNIFYFS_SUCCESS;
+}
+
+/* Get the number of chunks moved by chunk tiering */
+int unifyfs_logio_get_tier_counts(logio_context* ctx,
+                                  size_t* demoted,
+                                  size_t* promoted)
+{
+    if (NULL == ctx) {
+        return EINVAL;
+    }
+
+    size_t down = 0;
+    size_t up = 0;
+    logio_tiers* tiers = ctx->tiers;
+    if ((NULL != tiers) && (NULL != tiers->state)) {
+        pthread_mutex_lock(&(tiers->lock));
+        down = tiers->demoted;
+        up = tiers->promoted;
+        pthread_mutex_unlock(&(tiers->lock));
+    }
+
+    if (NULL != demoted) {
+        *demoted = down;
+    }
+    if (NULL != promoted) {
+        *promoted = up;
+    }
+    return UNIFYFS_SUCCESS;
+}
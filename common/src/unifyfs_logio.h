@@ -27,6 +27,9 @@ extern "C" {
 /* convenience method to return system page size */
 size_t get_page_size(void);
 
+/* chunk tiering state, see unifyfs_logio.c */
+struct logio_tiers;
+
 /* log-based I/O context structure */
 typedef struct logio_context {
     shm_context* shmem;   /* shmem region for memory storage */
@@ -34,8 +37,20 @@ typedef struct logio_context {
     char*  spill_file;    /* pathname of spillover file */
     size_t spill_sz;      /* size of spillover file */
     int    spill_fd;      /* spillover file descriptor */
+    size_t spill_align;   /* O_DIRECT alignment of spill data I/O, or 0 */
+    int    spill_nstripes; /* number of spill files data is striped across */
+    int*   spill_stripe_fds;     /* spill file descriptors, by stripe */
+    char** spill_stripe_files;   /* spill file pathnames, by stripe */
+    struct logio_tiers* tiers; /* chunk tiering state, or NULL */
+    int    numa_node;     /* NUMA node of shmem region, or -1 if unknown */
 } logio_context;
 
+/* hints on future access to log data */
+typedef enum {
+    LOGIO_ADVICE_WILLNEED = 1, /* data will be read soon */
+    LOGIO_ADVICE_DONTNEED = 2  /* data will not be read soon */
+} logio_advice_e;
+
 /**
  * Initialize logio context for server.
  *
@@ -43,7 +58,8 @@ typedef struct logio_context {
  * @param client_id client id
  * @param mem_sz shared memory region size for storing data
  * @param spill_sz spillfile size for storing data
- * @param spill_dir path to spillfile parent directory
+ * @param spill_dir path to spillfile parent directory, or a colon-separated
+ *                  list of directories to stripe spill data across
  * @param[out] ctx address of logio context pointer, set to new context
  * @return UNIFYFS_SUCCESS, or error code
  */
@@ -134,6 +150,40 @@ int unifyfs_logio_write(logio_context* ctx,
                         const char* buf,
                         size_t* obytes);
 
+/* a read or write of a logio batch */
+typedef struct logio_io {
+    logio_context* ctx;   /* log to access */
+    off_t log_offset;     /* log offset of data */
+    size_t nbytes;        /* size of data in bytes */
+    char* buf;            /* data buffer */
+    size_t nio;           /* [out] number of bytes transferred */
+    int rc;               /* [out] UNIFYFS_SUCCESS, or error code */
+} logio_io;
+
+/**
+ * Read a batch of data from logio contexts. Data in spillover files is
+ * read with concurrent requests when asynchronous spill I/O is available,
+ * see unifyfs_spillio.h. The result of each read is set in its entry.
+ *
+ * @param ios array of reads
+ * @param n_ios number of reads
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_read_batch(logio_io* ios,
+                             size_t n_ios);
+
+/**
+ * Write a batch of data to logio contexts. Data in spillover files is
+ * written with concurrent requests when asynchronous spill I/O is
+ * available. The result of each write is set in its entry.
+ *
+ * @param ios array of writes
+ * @param n_ios number of writes
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_write_batch(logio_io* ios,
+                              size_t n_ios);
+
 /**
  * Sync any spill data to disk for given logio context.
  *
@@ -154,6 +204,102 @@ int unifyfs_logio_get_sizes(logio_context* ctx,
                             off_t* shmem_sz,
                             off_t* spill_sz);
 
+/**
+ * Get the shmem and spill data bytes currently allocated.
+ *
+ * @param ctx pointer to logio context
+ * @param[out] shmem_used if non-NULL, set to bytes in use in shmem
+ * @param[out] spill_used if non-NULL, set to bytes in use in spillover
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_get_usage(logio_context* ctx,
+                            size_t* shmem_used,
+                            size_t* spill_used);
+
+/**
+ * Get the number of data chunks in the log and the chunk size. Chunks
+ * are numbered from the start of the shmem data through the end of the
+ * spillover data.
+ *
+ * @param ctx pointer to logio context
+ * @param[out] n_chunks if non-NULL, set to number of data chunks
+ * @param[out] chunk_sz if non-NULL, set to size of a data chunk in bytes
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_get_chunks(logio_context* ctx,
+                             size_t* n_chunks,
+                             size_t* chunk_sz);
+
+/**
+ * Get the chunk holding the data at a given log offset.
+ *
+ * @param ctx pointer to logio context
+ * @param log_offset log offset of data
+ * @param[out] chunk_ndx set to index of chunk holding the data
+ * @param[out] chunk_offset if non-NULL, set to log offset of chunk start
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_get_chunk(logio_context* ctx,
+                            const off_t log_offset,
+                            size_t* chunk_ndx,
+                            off_t* chunk_offset);
+
+/**
+ * Get the log offset of the start of a chunk.
+ *
+ * @param ctx pointer to logio context
+ * @param chunk_ndx index of chunk
+ * @param[out] log_offset set to log offset of chunk start
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_chunk_offset(logio_context* ctx,
+                               const size_t chunk_ndx,
+                               off_t* log_offset);
+
+/**
+ * Give a hint on future access to the log data in the given range. With
+ * chunk tiering, chunks of data that will be needed are moved to shmem,
+ * and chunks of data that will not be needed are moved to spillover.
+ *
+ * @param ctx pointer to logio context
+ * @param log_offset log offset of data
+ * @param nbytes size of data in bytes
+ * @param advice one of logio_advice_e
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_advise(logio_context* ctx,
+                         const off_t log_offset,
+                         const size_t nbytes,
+                         int advice);
+
+/**
+ * Mark log data written by another process, such as the server, as
+ * written, so chunk tiering may move its chunks. Chunks that were never
+ * marked written are not moved, so the other process can write them
+ * in place.
+ *
+ * @param ctx pointer to logio context
+ * @param log_offset log offset of data
+ * @param nbytes size of data in bytes
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_set_written(logio_context* ctx,
+                              const off_t log_offset,
+                              const size_t nbytes);
+
+/**
+ * Get the number of chunks moved between shmem and spillover by chunk
+ * tiering.
+ *
+ * @param ctx pointer to logio context
+ * @param[out] demoted if non-NULL, set to chunks moved to spillover
+ * @param[out] promoted if non-NULL, set to chunks moved to shmem
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_logio_get_tier_counts(logio_context* ctx,
+                                  size_t* demoted,
+                                  size_t* promoted);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
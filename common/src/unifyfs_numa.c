@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "unifyfs_const.h"
+#include "unifyfs_log.h"
+#include "unifyfs_numa.h"
+
+#if defined(SYS_mbind) && defined(SYS_set_mempolicy) && \
+    defined(SYS_get_mempolicy) && defined(SYS_getcpu)
+# define NUMA_SYSCALLS 1
+#endif
+
+/* memory policy values, from linux/mempolicy.h */
+#define NUMA_MPOL_DEFAULT   0
+#define NUMA_MPOL_PREFERRED 1
+#define NUMA_MPOL_MF_MOVE   (1 << 1)
+
+/* the kernel reads one less than the given number of node mask bits */
+#define NUMA_MASK_MAXNODE (UNIFYFS_NUMA_MAX_CPUS + 1)
+
+#define NUMA_SYSFS_DIR "/sys/devices/system/node"
+
+#define MASK_BITS (8 * sizeof(unsigned long))
+
+typedef unsigned long numa_mask[UNIFYFS_NUMA_MASK_WORDS];
+
+static struct {
+    int enabled;        /* placement is done */
+    int n_nodes;        /* highest online node + 1 */
+    numa_mask* cpus;    /* CPUs of each node */
+} numa;
+
+/* parse a list such as "0-3,8,10-11" into a bit mask */
+static int parse_list(const char* list,
+                      unsigned long* mask)
+{
+    memset(mask, 0, sizeof(numa_mask));
+    const char* p = list;
+    while ((*p != '\0') && (*p != '\n')) {
+        char* end;
+        long lo = strtol(p, &end, 10);
+        long hi = lo;
+        if (end == p) {
+            return EINVAL;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p) {
+                return EINVAL;
+            }
+        }
+        for (long i = lo; (i <= hi) && (i < UNIFYFS_NUMA_MAX_CPUS); i++) {
+            mask[i / MASK_BITS] |= (1UL << (i % MASK_BITS));
+        }
+        p = (*end == ',') ? (end + 1) : end;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* read a list file from the sysfs node directory into a bit mask */
+static int read_list(const char* name,
+                     unsigned long* mask)
+{
+    char path[128];
+    char list[4096];
+    snprintf(path, sizeof(path), "%s/%s", NUMA_SYSFS_DIR, name);
+    FILE* fp = fopen(path, "r");
+    if (NULL == fp) {
+        return errno;
+    }
+    char* line = fgets(list, sizeof(list), fp);
+    fclose(fp);
+    if (NULL == line) {
+        return EIO;
+    }
+    return parse_list(list, mask);
+}
+
+static inline
+int mask_test(const unsigned long* mask,
+              int bit)
+{
+    return (mask[bit / MASK_BITS] >> (bit % MASK_BITS)) & 1UL;
+}
+
+int unifyfs_numa_init(const unifyfs_cfg_t* cfg)
+{
+    bool b;
+
+    if (NULL != numa.cpus) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    int want_numa = 1;
+    if ((NULL != cfg) && (NULL != cfg->logio_numa) &&
+        (0 == configurator_bool_val(cfg->logio_numa, &b))) {
+        want_numa = (int) b;
+    }
+    numa.enabled = 0;
+    if (!want_numa) {
+        return UNIFYFS_SUCCESS;
+    }
+
+#ifdef NUMA_SYSCALLS
+    numa_mask online;
+    if (UNIFYFS_SUCCESS != read_list("online", online)) {
+        LOGDBG("NUMA node information not available");
+        return UNIFYFS_SUCCESS;
+    }
+    int n_nodes = 0;
+    int n_online = 0;
+    for (int i = 0; i < UNIFYFS_NUMA_MAX_CPUS; i++) {
+        if (mask_test(online, i)) {
+            n_nodes = i + 1;
+            n_online++;
+        }
+    }
+    if (n_online < 2) {
+        /* nothing to place */
+        return UNIFYFS_SUCCESS;
+    }
+
+    numa.cpus = calloc(n_nodes, sizeof(numa_mask));
+    if (NULL == numa.cpus) {
+        return ENOMEM;
+    }
+    for (int i = 0; i < n_nodes; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "node%d/cpulist", i);
+        if (mask_test(online, i)) {
+            read_list(name, numa.cpus[i]);
+        }
+    }
+    numa.n_nodes = n_nodes;
+    numa.enabled = 1;
+    LOGINFO("NUMA placement enabled for %d nodes", n_online);
+#endif
+
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_numa_enabled(void)
+{
+    return numa.enabled;
+}
+
+int unifyfs_numa_current_node(void)
+{
+#ifdef NUMA_SYSCALLS
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (0 == syscall(SYS_getcpu, &cpu, &node, NULL)) {
+        return (int) node;
+    }
+#endif
+    return -1;
+}
+
+int unifyfs_numa_bind(void* addr,
+                      size_t len,
+                      int node)
+{
+    if (!numa.enabled || (node < 0) || (node >= numa.n_nodes)) {
+        return EINVAL;
+    }
+#ifdef NUMA_SYSCALLS
+    numa_mask nodes = {0};
+    nodes[node / MASK_BITS] = 1UL << (node % MASK_BITS);
+    if (0 != syscall(SYS_mbind, addr, len, NUMA_MPOL_PREFERRED, nodes,
+                     NUMA_MASK_MAXNODE, NUMA_MPOL_MF_MOVE)) {
+        return errno;
+    }
+    return UNIFYFS_SUCCESS;
+#else
+    return ENOSYS;
+#endif
+}
+
+int unifyfs_numa_enter(int node,
+                       unifyfs_numa_place* place)
+{
+    place->node = -1;
+    if (!numa.enabled || (node < 0) || (node >= numa.n_nodes)) {
+        return EINVAL;
+    }
+    if (node == unifyfs_numa_current_node()) {
+        /* already there */
+        return UNIFYFS_SUCCESS;
+    }
+#ifdef NUMA_SYSCALLS
+    if ((0 != sched_getaffinity(0, sizeof(cpu_set_t),
+                                (cpu_set_t*) place->cpus)) ||
+        (0 != syscall(SYS_get_mempolicy, &(place->mode), place->nodes,
+                      NUMA_MASK_MAXNODE, NULL, 0))) {
+        return errno;
+    }
+    if (0 != sched_setaffinity(0, sizeof(cpu_set_t),
+                               (cpu_set_t*) numa.cpus[node])) {
+        return errno;
+    }
+    numa_mask nodes = {0};
+    nodes[node / MASK_BITS] = 1UL << (node % MASK_BITS);
+    syscall(SYS_set_mempolicy, NUMA_MPOL_PREFERRED, nodes,
+            NUMA_MASK_MAXNODE);
+    place->node = node;
+    return UNIFYFS_SUCCESS;
+#else
+    return ENOSYS;
+#endif
+}
+
+void unifyfs_numa_leave(unifyfs_numa_place* place)
+{
+    if (place->node < 0) {
+        return;
+    }
+#ifdef NUMA_SYSCALLS
+    if (NUMA_MPOL_DEFAULT == place->mode) {
+        syscall(SYS_set_mempolicy, NUMA_MPOL_DEFAULT, NULL, 0);
+    } else {
+        syscall(SYS_set_mempolicy, place->mode, place->nodes,
+                NUMA_MASK_MAXNODE);
+    }
+    sched_setaffinity(0, sizeof(cpu_set_t), (cpu_set_t*) place->cpus);
+#endif
+    place->node = -1;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_NUMA_H
+#define UNIFYFS_NUMA_H
+
+#include <stddef.h>
+
+#include "unifyfs_configurator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * NUMA placement.
+ *
+ * Clients place the shared memory of their logs on the NUMA node they
+ * run on, and servers move a thread to the node holding the client log
+ * data it copies, so that the copies do not cross the socket
+ * interconnect. This uses the Linux memory policy system calls directly,
+ * and does nothing on systems with a single node.
+ */
+
+/* most CPUs and NUMA nodes supported */
+#define UNIFYFS_NUMA_MAX_CPUS 1024
+#define UNIFYFS_NUMA_MASK_WORDS (UNIFYFS_NUMA_MAX_CPUS / (8 * sizeof(long)))
+
+/* saved thread placement, to restore after unifyfs_numa_enter() */
+typedef struct unifyfs_numa_place {
+    int node;        /* node entered, or -1 if the thread was not moved */
+    int mode;        /* previous memory policy mode */
+    unsigned long nodes[UNIFYFS_NUMA_MASK_WORDS]; /* previous policy nodes */
+    unsigned long cpus[UNIFYFS_NUMA_MASK_WORDS];  /* previous CPU affinity */
+} unifyfs_numa_place;
+
+/**
+ * Read NUMA settings from configuration and discover the NUMA nodes.
+ *
+ * @param cfg configuration (may be NULL for defaults)
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_numa_init(const unifyfs_cfg_t* cfg);
+
+/**
+ * Get whether NUMA placement is enabled and there is more than one node.
+ *
+ * @return nonzero if placement is done
+ */
+int unifyfs_numa_enabled(void);
+
+/**
+ * Get the NUMA node of the CPU the calling thread runs on.
+ *
+ * @return node, or -1 if unknown
+ */
+int unifyfs_numa_current_node(void);
+
+/**
+ * Prefer a NUMA node for the pages of a shared memory region, moving
+ * pages already mapped by the caller there.
+ *
+ * @param addr page-aligned start of region
+ * @param len region length
+ * @param node NUMA node
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_numa_bind(void* addr, size_t len, int node);
+
+/**
+ * Move the calling thread to the CPUs of a NUMA node, and prefer that
+ * node for its memory allocations, until unifyfs_numa_leave().
+ *
+ * @param node NUMA node
+ * @param[out] place saved placement
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_numa_enter(int node, unifyfs_numa_place* place);
+
+/**
+ * Restore the placement of the calling thread saved by
+ * unifyfs_numa_enter().
+ *
+ * @param place saved placement
+ */
+void unifyfs_numa_leave(unifyfs_numa_place* place);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* UNIFYFS_NUMA_H */
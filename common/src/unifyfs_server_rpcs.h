@@ -48,6 +48,7 @@ MERCURY_GEN_PROC(chunk_read_request_in_t,
                  ((int32_t)(client_id))
                  ((int32_t)(req_id))
                  ((int32_t)(num_chks))
+                 ((uint64_t)(trace_id))
                  ((hg_size_t)(bulk_size))
                  ((hg_bulk_t)(bulk_handle)))
 MERCURY_GEN_PROC(chunk_read_request_out_t,
@@ -61,26 +62,42 @@ MERCURY_GEN_PROC(chunk_read_response_in_t,
                  ((int32_t)(client_id))
                  ((int32_t)(req_id))
                  ((int32_t)(num_chks))
+                 ((uint64_t)(trace_id))
                  ((hg_size_t)(bulk_size))
                  ((hg_bulk_t)(bulk_handle)))
 MERCURY_GEN_PROC(chunk_read_response_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(chunk_read_response_rpc)
 
-/* Add file extents at owner */
+/* Add file extents at owner. When extent metadata is striped, the
+ * extents are those of the target server's offset ranges, filesize
+ * holds the end of the last byte written to let the owner track the
+ * file size, and attr holds the file attributes for a target server
+ * that has no inode for the file yet */
 MERCURY_GEN_PROC(add_extents_in_t,
                  ((int32_t)(src_rank))
                  ((int32_t)(gfid))
                  ((int32_t)(num_extents))
+                 ((hg_size_t)(filesize))
+                 ((unifyfs_file_attr_t)(attr))
+                 ((hg_size_t)(extents_size))
                  ((hg_bulk_t)(extents)))
 MERCURY_GEN_PROC(add_extents_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(add_extents_rpc)
 
-/* Find file extent locations by querying owner */
+/* Move the log data of file extents at owner. Uses the add_extents
+ * types, where the extents bulk holds num_extents extents with their
+ * current log offsets followed by the same extents with their new log
+ * offsets, and filesize and attr are unused */
+DECLARE_MARGO_RPC_HANDLER(relocate_extents_rpc)
+
+/* Find file extent locations by querying owner. The extents may belong
+ * to any files owned by the target server. On success, the locations bulk
+ * holds the chunk locations of each extent in request order, followed by
+ * an array of num_extents chunk counts (uint32_t) */
 MERCURY_GEN_PROC(find_extents_in_t,
                  ((int32_t)(src_rank))
-                 ((int32_t)(gfid))
                  ((int32_t)(num_extents))
                  ((hg_bulk_t)(extents)))
 MERCURY_GEN_PROC(find_extents_out_t,
@@ -129,6 +146,14 @@ MERCURY_GEN_PROC(truncate_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(truncate_rpc)
 
+/* Get server statistics as a JSON object */
+MERCURY_GEN_PROC(server_stats_in_t,
+                 ((int32_t)(src_rank)))
+MERCURY_GEN_PROC(server_stats_out_t,
+                 ((int32_t)(ret))
+                 ((hg_const_string_t)(json)))
+DECLARE_MARGO_RPC_HANDLER(server_stats_rpc)
+
 /*---- Collective RPCs ----*/
 
 /* Broadcast file extents to all servers */
@@ -136,6 +161,7 @@ MERCURY_GEN_PROC(extent_bcast_in_t,
                  ((int32_t)(root))
                  ((int32_t)(gfid))
                  ((int32_t)(num_extents))
+                 ((hg_size_t)(extents_size))
                  ((hg_bulk_t)(extents)))
 MERCURY_GEN_PROC(extent_bcast_out_t,
                  ((int32_t)(ret)))
@@ -151,12 +177,17 @@ MERCURY_GEN_PROC(fileattr_bcast_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(fileattr_bcast_rpc)
 
-/* Broadcast laminated file metadata to all servers */
+/* Broadcast laminated file metadata to all servers. The extents are sent
+ * in segments, num_extents is the number of extents in this segment and
+ * is_final is set for the last segment */
 MERCURY_GEN_PROC(laminate_bcast_in_t,
                  ((int32_t)(root))
                  ((int32_t)(gfid))
                  ((int32_t)(num_extents))
+                 ((int32_t)(total_extents))
+                 ((int32_t)(is_final))
                  ((unifyfs_file_attr_t)(attr))
+                 ((hg_size_t)(extents_size))
                  ((hg_bulk_t)(extents)))
 MERCURY_GEN_PROC(laminate_bcast_out_t,
                  ((int32_t)(ret)))
@@ -179,6 +210,37 @@ MERCURY_GEN_PROC(unlink_bcast_out_t,
                  ((int32_t)(ret)))
 DECLARE_MARGO_RPC_HANDLER(unlink_bcast_rpc)
 
+/* Broadcast stage-out of a laminated file to all servers */
+MERCURY_GEN_PROC(transfer_bcast_in_t,
+                 ((int32_t)(root))
+                 ((int32_t)(gfid))
+                 ((hg_const_string_t)(dst_file)))
+MERCURY_GEN_PROC(transfer_bcast_out_t,
+                 ((int32_t)(ret)))
+DECLARE_MARGO_RPC_HANDLER(transfer_bcast_rpc)
+
+/* Broadcast registration of a read-through file to all servers */
+MERCURY_GEN_PROC(readthrough_bcast_in_t,
+                 ((int32_t)(root))
+                 ((unifyfs_file_attr_t)(attr))
+                 ((hg_const_string_t)(backing_file)))
+MERCURY_GEN_PROC(readthrough_bcast_out_t,
+                 ((int32_t)(ret)))
+DECLARE_MARGO_RPC_HANDLER(readthrough_bcast_rpc)
+
+/* Read a block of a read-through file from its backing file into the
+ * cache log of the target server, which returns the log location */
+MERCURY_GEN_PROC(readthrough_fetch_in_t,
+                 ((int32_t)(gfid))
+                 ((hg_size_t)(offset))
+                 ((hg_size_t)(length)))
+MERCURY_GEN_PROC(readthrough_fetch_out_t,
+                 ((hg_size_t)(log_offset))
+                 ((int32_t)(client_id))
+                 ((uint64_t)(log_epoch))
+                 ((int32_t)(ret)))
+DECLARE_MARGO_RPC_HANDLER(readthrough_fetch_rpc)
+
 
 #ifdef __cplusplus
 } // extern "C"
@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+#endif
+
+#include "unifyfs_const.h"
+#include "unifyfs_log.h"
+#include "unifyfs_spillio.h"
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && \
+    defined(IORING_FEAT_RW_CUR_POS)
+# define SPILLIO_URING 1
+#endif
+
+#ifdef SPILLIO_URING
+/* mapped io_uring submission and completion rings */
+typedef struct uring {
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;
+    size_t sq_sz;
+    void* cq_ptr;
+    size_t cq_sz;
+    size_t sqes_sz;
+} uring;
+#endif
+
+struct spillio_queue {
+    size_t depth;          /* max requests in flight */
+    size_t inflight;       /* requests submitted and not yet reaped */
+#ifdef SPILLIO_URING
+    int use_uring;
+    uring ring;
+#endif
+    /* completions from the I/O threads */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    spillio_req* done_head;
+    spillio_req* done_tail;
+};
+
+/* global asynchronous I/O state */
+static struct {
+    int initialized;
+    int use_uring;
+    size_t depth;
+    pthread_key_t queue_key;
+
+    /* I/O thread pool */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    spillio_req* head;
+    spillio_req* tail;
+    pthread_t* threads;
+    int n_threads;
+    int stop;
+} spillio;
+
+#ifdef SPILLIO_URING
+
+static int uring_setup(unsigned entries, struct io_uring_params* p)
+{
+    return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags)
+{
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                         flags, NULL, 0);
+}
+
+/* create an io_uring with room for the given number of requests */
+static int uring_init(uring* r, unsigned entries)
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+
+    r->fd = uring_setup(entries, &p);
+    if (r->fd < 0) {
+        return errno;
+    }
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        /* kernel lacks the plain read/write operations */
+        close(r->fd);
+        return ENOSYS;
+    }
+
+    r->sq_sz = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+    r->cq_sz = p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe));
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_sz > r->sq_sz) {
+            r->sq_sz = r->cq_sz;
+        }
+        r->cq_sz = r->sq_sz;
+    }
+    r->sq_ptr = mmap(NULL, r->sq_sz, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == r->sq_ptr) {
+        int err = errno;
+        close(r->fd);
+        return err;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ptr = r->sq_ptr;
+    } else {
+        r->cq_ptr = mmap(NULL, r->cq_sz, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, r->fd,
+                         IORING_OFF_CQ_RING);
+        if (MAP_FAILED == r->cq_ptr) {
+            int err = errno;
+            munmap(r->sq_ptr, r->sq_sz);
+            close(r->fd);
+            return err;
+        }
+    }
+    r->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_sz, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (MAP_FAILED == r->sqes) {
+        int err = errno;
+        if (r->cq_ptr != r->sq_ptr) {
+            munmap(r->cq_ptr, r->cq_sz);
+        }
+        munmap(r->sq_ptr, r->sq_sz);
+        close(r->fd);
+        return err;
+    }
+
+    char* sq = (char*) r->sq_ptr;
+    r->sq_head  = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail  = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask  = (unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    char* cq = (char*) r->cq_ptr;
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes    = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return UNIFYFS_SUCCESS;
+}
+
+static void uring_fini(uring* r)
+{
+    munmap(r->sqes, r->sqes_sz);
+    if (r->cq_ptr != r->sq_ptr) {
+        munmap(r->cq_ptr, r->cq_sz);
+    }
+    munmap(r->sq_ptr, r->sq_sz);
+    close(r->fd);
+}
+
+/* queue requests in the submission ring and submit them */
+static int uring_submit(uring* r, spillio_req** reqs, size_t n_reqs)
+{
+    unsigned tail = *(r->sq_tail);
+    unsigned mask = *(r->sq_mask);
+    for (size_t i = 0; i < n_reqs; i++) {
+        spillio_req* req = reqs[i];
+        unsigned ndx = tail & mask;
+        struct io_uring_sqe* sqe = r->sqes + ndx;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = req->write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = req->fd;
+        sqe->addr = (uint64_t)(uintptr_t) req->buf;
+        sqe->len = (uint32_t) req->len;
+        sqe->off = (uint64_t) req->offset;
+        sqe->user_data = (uint64_t)(uintptr_t) req;
+        r->sq_array[ndx] = ndx;
+        tail++;
+    }
+    __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned to_submit = (unsigned) n_reqs;
+    while (to_submit > 0) {
+        int rc = uring_enter(r->fd, to_submit, 0, 0);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        to_submit -= (unsigned) rc;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* reap up to max_done completions, waiting for at least min_done */
+static int uring_reap(uring* r, size_t min_done,
+                      spillio_req** done, size_t max_done, size_t* n_done)
+{
+    size_t count = 0;
+    while (count < max_done) {
+        unsigned head = *(r->cq_head);
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        unsigned mask = *(r->cq_mask);
+        while ((head != tail) && (count < max_done)) {
+            struct io_uring_cqe* cqe = r->cqes + (head & mask);
+            spillio_req* req = (spillio_req*)(uintptr_t) cqe->user_data;
+            req->result = (ssize_t) cqe->res;
+            done[count++] = req;
+            head++;
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+        if (count >= min_done) {
+            break;
+        }
+
+        int rc = uring_enter(r->fd, 0, (unsigned)(min_done - count),
+                             IORING_ENTER_GETEVENTS);
+        if ((rc < 0) && (errno != EINTR)) {
+            *n_done = count;
+            return errno;
+        }
+    }
+    *n_done = count;
+    return UNIFYFS_SUCCESS;
+}
+
+#endif /* SPILLIO_URING */
+
+/* do a request with pread() or pwrite() */
+static void spillio_do_req(spillio_req* req)
+{
+    ssize_t rc;
+    do {
+        if (req->write) {
+            rc = pwrite(req->fd, req->buf, req->len, req->offset);
+        } else {
+            rc = pread(req->fd, req->buf, req->len, req->offset);
+        }
+    } while ((rc < 0) && (errno == EINTR));
+    req->result = (rc < 0) ? (ssize_t)(-errno) : rc;
+}
+
+/* I/O thread main loop */
+static void* spillio_thread_main(void* arg)
+{
+    pthread_mutex_lock(&(spillio.lock));
+    while (1) {
+        while ((NULL == spillio.head) && !spillio.stop) {
+            pthread_cond_wait(&(spillio.cond), &(spillio.lock));
+        }
+        if (NULL == spillio.head) {
+            break;
+        }
+        spillio_req* req = spillio.head;
+        spillio.head = req->next;
+        if (NULL == spillio.head) {
+            spillio.tail = NULL;
+        }
+        pthread_mutex_unlock(&(spillio.lock));
+
+        spillio_do_req(req);
+
+        /* post completion to the submitting queue */
+        spillio_queue* q = req->queue;
+        req->next = NULL;
+        pthread_mutex_lock(&(q->lock));
+        if (NULL == q->done_tail) {
+            q->done_head = req;
+        } else {
+            q->done_tail->next = req;
+        }
+        q->done_tail = req;
+        pthread_cond_signal(&(q->cond));
+        pthread_mutex_unlock(&(q->lock));
+
+        pthread_mutex_lock(&(spillio.lock));
+    }
+    pthread_mutex_unlock(&(spillio.lock));
+    return NULL;
+}
+
+static void spillio_queue_destroy(void* arg)
+{
+    spillio_queue* q = (spillio_queue*) arg;
+    if (NULL == q) {
+        return;
+    }
+
+    /* wait for requests still in flight */
+    while (q->inflight > 0) {
+        spillio_req* done[16];
+        size_t n_done = 0;
+        if (unifyfs_spillio_reap(q, 1, done, 16, &n_done) != 0) {
+            break;
+        }
+    }
+#ifdef SPILLIO_URING
+    if (q->use_uring) {
+        uring_fini(&(q->ring));
+    }
+#endif
+    pthread_mutex_destroy(&(q->lock));
+    pthread_cond_destroy(&(q->cond));
+    free(q);
+}
+
+static spillio_queue* spillio_queue_create(void)
+{
+    spillio_queue* q = calloc(1, sizeof(spillio_queue));
+    if (NULL == q) {
+        return NULL;
+    }
+    q->depth = spillio.depth;
+    pthread_mutex_init(&(q->lock), NULL);
+    pthread_cond_init(&(q->cond), NULL);
+#ifdef SPILLIO_URING
+    if (spillio.use_uring) {
+        int rc = uring_init(&(q->ring), (unsigned) q->depth);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGWARN("io_uring setup failed (%s), using I/O threads",
+                    strerror(rc));
+        } else {
+            q->use_uring = 1;
+        }
+    }
+#endif
+    return q;
+}
+
+int unifyfs_spillio_init(const unifyfs_cfg_t* cfg)
+{
+    long l;
+    bool b;
+
+    if (spillio.initialized) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    spillio.depth = UNIFYFS_SPILLIO_DEPTH;
+    if ((NULL != cfg) && (NULL != cfg->logio_spill_io_depth) &&
+        (0 == configurator_int_val(cfg->logio_spill_io_depth, &l))) {
+        if (l <= 0) {
+            /* asynchronous spill I/O disabled */
+            return UNIFYFS_SUCCESS;
+        }
+        spillio.depth = (size_t) l;
+    }
+    int n_threads = UNIFYFS_SPILLIO_THREADS;
+    if ((NULL != cfg) && (NULL != cfg->logio_spill_io_threads) &&
+        (0 == configurator_int_val(cfg->logio_spill_io_threads, &l)) &&
+        (l > 0)) {
+        n_threads = (int) l;
+    }
+    int want_uring = 1;
+    if ((NULL != cfg) && (NULL != cfg->logio_spill_io_uring) &&
+        (0 == configurator_bool_val(cfg->logio_spill_io_uring, &b))) {
+        want_uring = (int) b;
+    }
+
+    spillio.use_uring = 0;
+#ifdef SPILLIO_URING
+    if (want_uring) {
+        /* check that the kernel lets us create a ring */
+        uring r;
+        int rc = uring_init(&r, (unsigned) spillio.depth);
+        if (rc == UNIFYFS_SUCCESS) {
+            uring_fini(&r);
+            spillio.use_uring = 1;
+        } else {
+            LOGINFO("io_uring is not available (%s)", strerror(rc));
+        }
+    }
+#else
+    (void) want_uring;
+#endif
+
+    if (0 != pthread_key_create(&(spillio.queue_key),
+                                spillio_queue_destroy)) {
+        return UNIFYFS_FAILURE;
+    }
+    pthread_mutex_init(&(spillio.lock), NULL);
+    pthread_cond_init(&(spillio.cond), NULL);
+    spillio.head = NULL;
+    spillio.tail = NULL;
+    spillio.stop = 0;
+
+    /* I/O threads serve queues that could not use io_uring, so they are
+     * always started */
+    spillio.threads = calloc((size_t)n_threads, sizeof(pthread_t));
+    if (NULL == spillio.threads) {
+        return ENOMEM;
+    }
+    for (int i = 0; i < n_threads; i++) {
+        int rc = pthread_create(spillio.threads + i, NULL,
+                                spillio_thread_main, NULL);
+        if (rc != 0) {
+            LOGERR("failed to create spill I/O thread (rc=%d)", rc);
+            break;
+        }
+        spillio.n_threads++;
+    }
+    if (0 == spillio.n_threads) {
+        free(spillio.threads);
+        spillio.threads = NULL;
+        pthread_key_delete(spillio.queue_key);
+        return UNIFYFS_ERROR_THRDINIT;
+    }
+
+    spillio.initialized = 1;
+    LOGINFO("asynchronous spill I/O using %s (depth=%zu)",
+            spillio.use_uring ? "io_uring" : "I/O threads", spillio.depth);
+    return UNIFYFS_SUCCESS;
+}
+
+void unifyfs_spillio_fini(void)
+{
+    if (!spillio.initialized) {
+        return;
+    }
+
+    spillio_queue* q = pthread_getspecific(spillio.queue_key);
+    if (NULL != q) {
+        pthread_setspecific(spillio.queue_key, NULL);
+        spillio_queue_destroy(q);
+    }
+
+    pthread_mutex_lock(&(spillio.lock));
+    spillio.stop = 1;
+    pthread_cond_broadcast(&(spillio.cond));
+    pthread_mutex_unlock(&(spillio.lock));
+    for (int i = 0; i < spillio.n_threads; i++) {
+        pthread_join(spillio.threads[i], NULL);
+    }
+    free(spillio.threads);
+    spillio.threads = NULL;
+    spillio.n_threads = 0;
+
+    pthread_key_delete(spillio.queue_key);
+    pthread_mutex_destroy(&(spillio.lock));
+    pthread_cond_destroy(&(spillio.cond));
+    spillio.initialized = 0;
+}
+
+spillio_queue* unifyfs_spillio_queue(void)
+{
+    if (!spillio.initialized) {
+        return NULL;
+    }
+
+    spillio_queue* q = pthread_getspecific(spillio.queue_key);
+    if (NULL == q) {
+        q = spillio_queue_create();
+        if (NULL != q) {
+            pthread_setspecific(spillio.queue_key, q);
+        }
+    }
+    return q;
+}
+
+size_t unifyfs_spillio_depth(spillio_queue* q)
+{
+    return (NULL == q) ? 0 : q->depth;
+}
+
+int unifyfs_spillio_uses_uring(void)
+{
+    return spillio.use_uring;
+}
+
+int unifyfs_spillio_submit(spillio_queue* q,
+                           spillio_req** reqs,
+                           size_t n_reqs,
+                           size_t* n_submitted)
+{
+    if ((NULL == q) || (NULL == n_submitted) ||
+        ((n_reqs > 0) && (NULL == reqs))) {
+        return EINVAL;
+    }
+
+    size_t n = q->depth - q->inflight;
+    if (n > n_reqs) {
+        n = n_reqs;
+    }
+    *n_submitted = 0;
+    if (0 == n) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        reqs[i]->result = 0;
+        reqs[i]->queue = q;
+        reqs[i]->next = NULL;
+    }
+
+#ifdef SPILLIO_URING
+    if (q->use_uring) {
+        int rc = uring_submit(&(q->ring), reqs, n);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("io_uring submit failed (%s)", strerror(rc));
+            return rc;
+        }
+        q->inflight += n;
+        *n_submitted = n;
+        return UNIFYFS_SUCCESS;
+    }
+#endif
+
+    /* hand requests to the I/O threads */
+    pthread_mutex_lock(&(spillio.lock));
+    for (size_t i = 0; i < n; i++) {
+        if (NULL == spillio.tail) {
+            spillio.head = reqs[i];
+        } else {
+            spillio.tail->next = reqs[i];
+        }
+        spillio.tail = reqs[i];
+    }
+    pthread_cond_broadcast(&(spillio.cond));
+    pthread_mutex_unlock(&(spillio.lock));
+    q->inflight += n;
+    *n_submitted = n;
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_spillio_reap(spillio_queue* q,
+                         size_t min_done,
+                         spillio_req** done,
+                         size_t max_done,
+                         size_t* n_done)
+{
+    if ((NULL == q) || (NULL == n_done) ||
+        ((max_done > 0) && (NULL == done))) {
+        return EINVAL;
+    }
+
+    *n_done = 0;
+    if (min_done > q->inflight) {
+        min_done = q->inflight;
+    }
+    if (min_done > max_done) {
+        min_done = max_done;
+    }
+    if ((0 == q->inflight) || (0 == max_done)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    int rc = UNIFYFS_SUCCESS;
+    size_t count = 0;
+#ifdef SPILLIO_URING
+    if (q->use_uring) {
+        rc = uring_reap(&(q->ring), min_done, done, max_done, &count);
+        q->inflight -= count;
+        *n_done = count;
+        return rc;
+    }
+#endif
+
+    pthread_mutex_lock(&(q->lock));
+    while (count < max_done) {
+        while ((NULL == q->done_head) && (count < min_done)) {
+            pthread_cond_wait(&(q->cond), &(q->lock));
+        }
+        spillio_req* req = q->done_head;
+        if (NULL == req) {
+            break;
+        }
+        q->done_head = req->next;
+        if (NULL == q->done_head) {
+            q->done_tail = NULL;
+        }
+        done[count++] = req;
+    }
+    pthread_mutex_unlock(&(q->lock));
+    q->inflight -= count;
+    *n_done = count;
+    return rc;
+}
+
+int unifyfs_spillio_run(spillio_queue* q,
+                        spillio_req** reqs,
+                        size_t n_reqs)
+{
+    if ((n_reqs > 0) && (NULL == reqs)) {
+        return EINVAL;
+    }
+
+    if (NULL == q) {
+        /* no queue, do the requests one at a time */
+        for (size_t i = 0; i < n_reqs; i++) {
+            spillio_do_req(reqs[i]);
+        }
+        return UNIFYFS_SUCCESS;
+    }
+
+    spillio_req* done[64];
+    size_t next = 0;
+    size_t completed = 0;
+    while (completed < n_reqs) {
+        if (next < n_reqs) {
+            size_t n = 0;
+            int rc = unifyfs_spillio_submit(q, reqs + next, n_reqs - next,
+                                            &n);
+            if (rc != UNIFYFS_SUCCESS) {
+                /* do the rest synchronously */
+                for (size_t i = next; i < n_reqs; i++) {
+                    spillio_do_req(reqs[i]);
+                }
+                completed += (n_reqs - next);
+                next = n_reqs;
+            } else {
+                next += n;
+            }
+        }
+        if (q->inflight > 0) {
+            size_t n_done = 0;
+            int rc = unifyfs_spillio_reap(q, 1, done, 64, &n_done);
+            if (rc != UNIFYFS_SUCCESS) {
+                return rc;
+            }
+            completed += n_done;
+        }
+    }
+    return UNIFYFS_SUCCESS;
+}
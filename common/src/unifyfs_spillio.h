@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_SPILLIO_H
+#define UNIFYFS_SPILLIO_H
+
+#include <sys/types.h>
+
+#include "unifyfs_configurator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Asynchronous spill file I/O.
+ *
+ * Reads and writes of spill files are submitted in batches to a queue,
+ * and their completions reaped from it, so that several are in flight
+ * at once. Each thread gets its own queue. Queues use io_uring when the
+ * kernel supports it, and otherwise hand requests to a shared pool of
+ * I/O threads that use pread()/pwrite().
+ */
+
+/* a spill file read or write */
+typedef struct spillio_req {
+    int fd;           /* file to access */
+    int write;        /* nonzero to write, zero to read */
+    char* buf;        /* data buffer */
+    size_t len;       /* bytes to transfer */
+    off_t offset;     /* file offset */
+    ssize_t result;   /* [out] bytes transferred, or negative errno */
+    void* arg;        /* caller data */
+
+    /* internal */
+    struct spillio_req* next;
+    struct spillio_queue* queue;
+} spillio_req;
+
+typedef struct spillio_queue spillio_queue;
+
+/**
+ * Initialize asynchronous spill file I/O from configuration. Without
+ * it, no queues are available and callers use synchronous I/O.
+ *
+ * @param cfg configuration (may be NULL for defaults)
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_spillio_init(const unifyfs_cfg_t* cfg);
+
+/**
+ * Stop I/O threads and release the queue of the calling thread.
+ */
+void unifyfs_spillio_fini(void);
+
+/**
+ * Get the queue of the calling thread, creating it on first use.
+ *
+ * @return queue pointer, or NULL if asynchronous I/O is not initialized
+ */
+spillio_queue* unifyfs_spillio_queue(void);
+
+/**
+ * Get the number of requests that may be in flight on a queue.
+ *
+ * @param q queue pointer
+ * @return queue depth
+ */
+size_t unifyfs_spillio_depth(spillio_queue* q);
+
+/**
+ * Submit requests, up to the space left in the queue.
+ *
+ * @param q queue pointer
+ * @param reqs array of pointers to requests
+ * @param n_reqs number of requests
+ * @param[out] n_submitted set to number of requests submitted
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_spillio_submit(spillio_queue* q,
+                           spillio_req** reqs,
+                           size_t n_reqs,
+                           size_t* n_submitted);
+
+/**
+ * Reap completed requests, waiting until at least min_done have
+ * completed (or all in flight, if fewer).
+ *
+ * @param q queue pointer
+ * @param min_done number of completions to wait for
+ * @param done array to hold pointers to completed requests
+ * @param max_done size of done array
+ * @param[out] n_done set to number of completed requests returned
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_spillio_reap(spillio_queue* q,
+                         size_t min_done,
+                         spillio_req** done,
+                         size_t max_done,
+                         size_t* n_done);
+
+/**
+ * Submit requests and wait for all of them to complete.
+ *
+ * @param q queue pointer
+ * @param reqs array of pointers to requests
+ * @param n_reqs number of requests
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_spillio_run(spillio_queue* q,
+                        spillio_req** reqs,
+                        size_t n_reqs);
+
+/**
+ * Get whether queues use io_uring.
+ *
+ * @return nonzero if io_uring is used
+ */
+int unifyfs_spillio_uses_uring(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* UNIFYFS_SPILLIO_H */
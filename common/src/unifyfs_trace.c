@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unifyfs_const.h"
+#include "unifyfs_log.h"
+#include "unifyfs_rc.h"
+#include "unifyfs_trace.h"
+
+/* a recorded trace event */
+typedef struct {
+    const char* name;   /* stage name (string constant) */
+    uint64_t trace_id;  /* id of traced request */
+    uint64_t ts;        /* start time (usecs since epoch) */
+    uint64_t dur;       /* duration (usecs) */
+    pid_t tid;          /* recording thread */
+    int done;           /* set once the event is fully recorded */
+} trace_event_t;
+
+int unifyfs_trace_enabled; /* = 0 */
+
+static trace_event_t* trace_events;   /* event buffer */
+static size_t trace_max_events;       /* event buffer capacity */
+static size_t trace_next_event;       /* next free event slot */
+static size_t trace_dropped;          /* events recorded after buffer full */
+static int trace_recorders;           /* threads inside trace_event */
+static uint64_t trace_next_id;        /* per-process trace id counter */
+static uint64_t trace_id_prefix;      /* process-unique high id bits */
+static char trace_label[UNIFYFS_MAX_FILENAME];
+static char trace_file[UNIFYFS_MAX_FILENAME];
+
+uint64_t unifyfs_trace_new_id(void)
+{
+    if (!unifyfs_trace_enabled) {
+        return 0;
+    }
+    uint64_t count = __atomic_add_fetch(&trace_next_id, 1, __ATOMIC_RELAXED);
+    return trace_id_prefix | (count & 0xFFFFFFFFULL);
+}
+
+void unifyfs_trace_event(const char* name,
+                         uint64_t trace_id,
+                         uint64_t start_us,
+                         uint64_t end_us)
+{
+    if (!unifyfs_trace_enabled || (0 == trace_id)) {
+        return;
+    }
+
+    /* announce this recorder before checking again that tracing is
+     * enabled, so fini either sees it or it sees tracing disabled */
+    __atomic_add_fetch(&trace_recorders, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&unifyfs_trace_enabled, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&trace_recorders, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    size_t ndx = __atomic_fetch_add(&trace_next_event, 1, __ATOMIC_RELAXED);
+    if (ndx >= trace_max_events) {
+        __atomic_add_fetch(&trace_dropped, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&trace_recorders, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    trace_event_t* ev = trace_events + ndx;
+    ev->name     = name;
+    ev->trace_id = trace_id;
+    ev->ts       = start_us;
+    ev->dur      = (end_us > start_us) ? (end_us - start_us) : 0;
+    ev->tid      = unifyfs_gettid();
+    __atomic_store_n(&(ev->done), 1, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&trace_recorders, 1, __ATOMIC_RELEASE);
+}
+
+int unifyfs_trace_init(unifyfs_cfg_t* cfg, const char* label)
+{
+    unifyfs_trace_enabled = 0;
+    if ((NULL == cfg) || (NULL == cfg->trace_dir)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    long max_events = UNIFYFS_TRACE_MAX_EVENTS;
+    if (NULL != cfg->trace_max_events) {
+        int rc = configurator_int_val(cfg->trace_max_events, &max_events);
+        if (rc) {
+            LOGERR("failed to read configuration");
+            return rc;
+        }
+    }
+    if (max_events <= 0) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    trace_events = calloc((size_t)max_events, sizeof(trace_event_t));
+    if (NULL == trace_events) {
+        LOGERR("failed to allocate trace buffer (%ld events)", max_events);
+        return ENOMEM;
+    }
+    trace_max_events = (size_t)max_events;
+    trace_next_event = 0;
+    trace_dropped = 0;
+
+    char host[UNIFYFS_MAX_HOSTNAME] = { 0 };
+    gethostname(host, sizeof(host) - 1);
+    pid_t pid = getpid();
+    snprintf(trace_file, sizeof(trace_file), "%s/unifyfs-trace.%s.%d.json",
+             cfg->trace_dir, host, (int)pid);
+    snprintf(trace_label, sizeof(trace_label), "%s (%s)", label, host);
+
+    /* the high bits of trace ids are a hash of the host name and pid,
+     * so ids from different processes don't collide */
+    uint32_t hash = 2166136261u;
+    for (char* c = host; *c; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    hash = (hash ^ (uint32_t)pid) * 16777619u;
+    trace_id_prefix = ((uint64_t)hash) << 32;
+    trace_next_id = 0;
+
+    unifyfs_trace_enabled = 1;
+    LOGINFO("tracing requests to %s (max %ld events)", trace_file, max_events);
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_trace_fini(void)
+{
+    if (!unifyfs_trace_enabled) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* stop new events, then wait for threads still recording one
+     * before the buffer is written and freed */
+    __atomic_store_n(&unifyfs_trace_enabled, 0, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&trace_recorders, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+
+    int ret = UNIFYFS_SUCCESS;
+    FILE* fp = fopen(trace_file, "w");
+    if (NULL == fp) {
+        ret = errno;
+        LOGERR("failed to open trace file %s - %s",
+               trace_file, strerror(ret));
+    } else {
+        int pid = (int)getpid();
+        fprintf(fp, "{\"traceEvents\":[\n");
+        fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                "\"args\":{\"name\":\"%s\"}}", pid, trace_label);
+
+        size_t count = __atomic_load_n(&trace_next_event, __ATOMIC_RELAXED);
+        if (count > trace_max_events) {
+            count = trace_max_events;
+        }
+        for (size_t i = 0; i < count; i++) {
+            trace_event_t* ev = trace_events + i;
+            if (!__atomic_load_n(&(ev->done), __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"unifyfs\","
+                    "\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 ","
+                    "\"pid\":%d,\"tid\":%d,"
+                    "\"args\":{\"trace_id\":\"%016" PRIx64 "\"}}",
+                    ev->name, ev->ts, ev->dur, pid, (int)ev->tid,
+                    ev->trace_id);
+        }
+        fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        if (0 != fclose(fp)) {
+            ret = errno;
+            LOGERR("failed to write trace file %s - %s",
+                   trace_file, strerror(ret));
+        }
+    }
+
+    size_t dropped = __atomic_load_n(&trace_dropped, __ATOMIC_RELAXED);
+    if (dropped) {
+        LOGWARN("trace buffer full, dropped %zu events", dropped);
+    }
+
+    free(trace_events);
+    trace_events = NULL;
+    trace_max_events = 0;
+
+    return ret;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_TRACE_H
+#define UNIFYFS_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "unifyfs_configurator.h"
+
+/*
+ * Request tracing.
+ *
+ * When enabled, clients assign a trace id to each read, sync, and laminate
+ * request, and the id is passed along in the rpcs used to service the
+ * request. Each process records the time spent in each stage of a traced
+ * request as an event in a fixed-size in-memory buffer, which is written
+ * at exit as a Chrome trace-event JSON file named
+ * unifyfs-trace.<host>.<pid>.json in the configured trace directory.
+ * Trace files from clients and servers may be concatenated into a single
+ * trace to view with chrome://tracing or Perfetto, and all events for a
+ * request share its trace id. Events recorded after the buffer is full
+ * are dropped.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* nonzero when tracing is enabled for this process */
+extern int unifyfs_trace_enabled;
+
+/* get current time in usecs since the epoch, as used for event times */
+static inline uint64_t unifyfs_trace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+/* get start time of a traced stage, or zero when tracing is disabled */
+static inline uint64_t unifyfs_trace_start(void)
+{
+    if (unifyfs_trace_enabled) {
+        return unifyfs_trace_now();
+    }
+    return 0;
+}
+
+/* get a new trace id that is unique across processes, returns zero
+ * when tracing is disabled */
+uint64_t unifyfs_trace_new_id(void);
+
+/* record an event for a stage of the request with the given trace id
+ * that started at start_us and ended at end_us. The name must be a
+ * string constant. Nothing is recorded for a zero trace id */
+void unifyfs_trace_event(const char* name,
+                         uint64_t trace_id,
+                         uint64_t start_us,
+                         uint64_t end_us);
+
+/* record an event for a stage that started at start_us and ends now */
+static inline void unifyfs_trace_end(const char* name,
+                                     uint64_t trace_id,
+                                     uint64_t start_us)
+{
+    if (unifyfs_trace_enabled && trace_id) {
+        unifyfs_trace_event(name, trace_id, start_us, unifyfs_trace_now());
+    }
+}
+
+/* read trace settings from configuration, and allocate the event buffer
+ * when tracing is enabled. The label names this process in the trace */
+int unifyfs_trace_init(unifyfs_cfg_t* cfg, const char* label);
+
+/* stop recording, wait for threads still recording an event, then write
+ * recorded events to the trace file and free the event buffer */
+int unifyfs_trace_fini(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* UNIFYFS_TRACE_H */
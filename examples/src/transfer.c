@@ -38,6 +38,7 @@ static int rank;
 static int total_ranks;
 static int rank_worker;
 static int parallel;
+static int direct;
 static int debug;
 
 static char* mountpoint = "/unifyfs";  /* unifyfs mountpoint */
@@ -50,6 +51,7 @@ static unsigned long bufsize = 64 * (1 << 10);
 
 static struct option long_opts[] = {
     { "debug", 0, 0, 'd' },
+    { "direct", 0, 0, 'D' },
     { "help", 0, 0, 'h' },
     { "mount", 1, 0, 'm' },
     { "parallel", 0, 0, 'p' },
@@ -58,7 +60,7 @@ static struct option long_opts[] = {
     { 0, 0, 0, 0},
 };
 
-static char* short_opts = "dhm:pr:u";
+static char* short_opts = "dDhm:pr:u";
 
 static const char* usage_str =
     "\n"
@@ -67,6 +69,8 @@ static const char* usage_str =
     "Available options:\n"
     " -d, --debug                  pause before running test\n"
     "                              (handy for attaching in debugger)\n"
+    " -D, --direct                 stage out by unifyfs servers\n"
+    "                              (source must be laminated)\n"
     " -h, --help                   help message\n"
     " -m, --mount=<mountpoint>     use <mountpoint> for unifyfs\n"
     "                              (default: /unifyfs)\n"
@@ -107,6 +111,10 @@ int main(int argc, char** argv)
             debug = 1;
             break;
 
+        case 'D':
+            direct = 1;
+            break;
+
         case 'm':
             mountpoint = strdup(optarg);
             break;
@@ -164,7 +172,12 @@ int main(int argc, char** argv)
 
         MPI_Barrier(MPI_COMM_WORLD);
 
-        if (rank == rank_worker) {
+        if ((rank == rank_worker) && direct) {
+            ret = unifyfs_transfer_file_direct(srcpath, dstpath);
+            if (ret) {
+                test_print(rank, "copy failed (%d: %s)", ret, strerror(-ret));
+            }
+        } else if (rank == rank_worker) {
             ret = unifyfs_transfer_file_serial(srcpath, dstpath);
             if (ret) {
                 test_print(rank, "copy failed (%d: %s)", ret, strerror(ret));
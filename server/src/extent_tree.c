@@ -42,6 +42,29 @@ int compare_func(
 RB_PROTOTYPE(ext_tree, extent_tree_node, entry, compare_func)
 RB_GENERATE(ext_tree, extent_tree_node, entry, compare_func)
 
+/* log data reference callback, NULL when not tracking references */
+static extent_tree_ref_fn extent_ref_fn; // = NULL
+
+void extent_tree_set_ref_callback(extent_tree_ref_fn fn)
+{
+    extent_ref_fn = fn;
+}
+
+/* report a change in references to the log data of the logical range
+ * [start, end] of the given extent */
+static inline void extent_ref(
+    struct extent_tree_node* node,
+    unsigned long start,
+    unsigned long end,
+    int added)
+{
+    if (NULL != extent_ref_fn) {
+        extent_ref_fn(node->svr_rank, node->app_id, node->cli_id,
+                      node->pos + (start - node->start),
+                      (end - start) + 1, added);
+    }
+}
+
 /* Returns 0 on success, positive non-zero error code otherwise */
 int extent_tree_init(struct extent_tree* extent_tree)
 {
@@ -67,7 +90,8 @@ static struct extent_tree_node* extent_tree_node_alloc(
     int svr_rank,        /* rank of server hosting data */
     int app_id,          /* application id (namespace) on server rank */
     int cli_id,          /* client rank on server rank */
-    unsigned long pos)   /* physical offset of data in log */
+    unsigned long pos,   /* physical offset of data in log */
+    unsigned long epoch) /* log release epoch when data was synced */
 {
     /* allocate a new node structure */
     struct extent_tree_node* node = calloc(1, sizeof(*node));
@@ -82,6 +106,7 @@ static struct extent_tree_node* extent_tree_node_alloc(
     node->app_id   = app_id;
     node->cli_id   = cli_id;
     node->pos      = pos;
+    node->epoch    = epoch;
 
     return node;
 }
@@ -146,14 +171,15 @@ int extent_tree_add(
     int svr_rank,        /* rank of server hosting data */
     int app_id,          /* application id (namespace) on server rank */
     int cli_id,          /* client rank on server rank */
-    unsigned long pos)   /* physical offset of data in log */
+    unsigned long pos,   /* physical offset of data in log */
+    unsigned long epoch) /* log release epoch when data was synced */
 {
     /* assume we'll succeed */
     int rc = 0;
 
     /* Create node to define our new range */
     struct extent_tree_node* node = extent_tree_node_alloc(
-        start, end, svr_rank, app_id, cli_id, pos);
+        start, end, svr_rank, app_id, cli_id, pos, epoch);
     if (!node) {
         return ENOMEM;
     }
@@ -161,6 +187,19 @@ int extent_tree_add(
     /* lock the tree so we can modify it */
     extent_tree_wrlock(extent_tree);
 
+    /* a compacted tree is immutable */
+    if (NULL != extent_tree->flat) {
+        LOGERR("cannot add extent [%lu, %lu] to a compacted extent tree",
+               start, end);
+        free(node);
+        rc = EROFS;
+        goto release_add;
+    }
+
+    /* account for the new reference before releasing any overlapped
+     * data, so data referenced again is never seen as unreferenced */
+    extent_ref(node, start, end, 1);
+
     /* Try to insert our range into the RB tree.  If it overlaps with any other
      * range, then it is not inserted, and the overlapping range node is
      * returned in 'overlap'.  If 'overlap' is NULL, then there were no
@@ -180,6 +219,7 @@ int extent_tree_add(
              * range in the tree defined in overlap.
              * We can't find a non-overlapping range.
              * Delete the existing range. */
+            extent_ref(overlap, overlap->start, overlap->end, 0);
             RB_REMOVE(ext_tree, &extent_tree->head, overlap);
             free(overlap);
             extent_tree->count--;
@@ -192,11 +232,13 @@ int extent_tree_add(
             struct extent_tree_node* resized = extent_tree_node_alloc(
                 new_start, new_end,
                 overlap->svr_rank, overlap->app_id, overlap->cli_id,
-                overlap->pos + (new_start - overlap->start));
+                overlap->pos + (new_start - overlap->start),
+                overlap->epoch);
             if (!resized) {
                 /* failed to allocate memory for range node,
                  * bail out and release lock without further
                  * changing state of extent tree */
+                extent_ref(node, start, end, 0);
                 free(node);
                 rc = ENOMEM;
                 goto release_add;
@@ -213,11 +255,13 @@ int extent_tree_add(
                 remaining = extent_tree_node_alloc(
                     resized->end + 1, overlap->end,
                     overlap->svr_rank, overlap->app_id, overlap->cli_id,
-                    overlap->pos + (resized->end + 1 - overlap->start));
+                    overlap->pos + (resized->end + 1 - overlap->start),
+                    overlap->epoch);
                 if (!remaining) {
                     /* failed to allocate memory for range node,
                      * bail out and release lock without further
                      * changing state of extent tree */
+                    extent_ref(node, start, end, 0);
                     free(node);
                     free(resized);
                     rc = ENOMEM;
@@ -225,7 +269,13 @@ int extent_tree_add(
                 }
             }
 
-            /* Remove our old range and release it */
+            /* Remove our old range and release it, the split ranges
+             * keep references to the data that is not overlapped */
+            extent_ref(resized, resized->start, resized->end, 1);
+            if (remaining != NULL) {
+                extent_ref(remaining, remaining->start, remaining->end, 1);
+            }
+            extent_ref(overlap, overlap->start, overlap->end, 0);
             RB_REMOVE(ext_tree, &extent_tree->head, overlap);
             free(overlap);
             extent_tree->count--;
@@ -265,6 +315,7 @@ int extent_tree_add(
         if (prev->svr_rank == target->svr_rank &&
             prev->cli_id   == target->cli_id   &&
             prev->app_id   == target->app_id   &&
+            prev->epoch    == target->epoch    &&
             pos_end        == target->pos) {
             /* the preceding extent describes a log position adjacent to
              * the extent we just added, so we can merge them,
@@ -292,6 +343,7 @@ int extent_tree_add(
         if (target->svr_rank == next->svr_rank &&
             target->cli_id   == next->cli_id   &&
             target->app_id   == next->app_id   &&
+            target->epoch    == next->epoch    &&
             pos_end          == next->pos) {
             /* the target extent describes a log position adjacent to
              * the next extent, so we can merge them,
@@ -313,9 +365,230 @@ release_add:
     return rc;
 }
 
+/* return index of first extent in the flat index whose end offset is
+ * not less than the given offset, or count if there is none. since the
+ * extents are sorted and non-overlapping, the end offsets are sorted too.
+ * the loop body has no data-dependent branches, so it compiles to
+ * conditional moves and a fixed number of iterations for a given count */
+static inline unsigned long flat_lower_bound(
+    const unsigned long* ends,
+    unsigned long count,
+    unsigned long offset)
+{
+    if (0 == count) {
+        return 0;
+    }
+
+    const unsigned long* base = ends;
+    unsigned long n = count;
+    while (n > 1) {
+        unsigned long half = n / 2;
+        base += (base[half - 1] < offset) * half;
+        n -= half;
+    }
+    return (unsigned long)(base - ends) + (*base < offset);
+}
+
+/* fill a (detached) tree node from the given flat index entry */
+static inline void flat_get_node(
+    struct extent_tree_flat* flat,
+    unsigned long i,
+    struct extent_tree_node* node)
+{
+    node->start    = flat->start[i];
+    node->end      = flat->end[i];
+    node->svr_rank = flat->svr_rank[i];
+    node->app_id   = flat->app_id[i];
+    node->cli_id   = flat->cli_id[i];
+    node->pos      = flat->pos[i];
+    node->epoch    = flat->epoch[i];
+}
+
+/* search flat index for entry that overlaps with given start/end
+ * offsets, return index of first overlapping entry if found, or
+ * count otherwise. assumes caller has lock on tree */
+static unsigned long extent_tree_flat_find(
+    struct extent_tree* extent_tree, /* compacted tree to search */
+    unsigned long start, /* starting offset to search */
+    unsigned long end)   /* ending offset to search */
+{
+    struct extent_tree_flat* flat = extent_tree->flat;
+    unsigned long count = flat->n_extents;
+    unsigned long i = flat_lower_bound(flat->end, count, start);
+    if ((i < count) && (flat->start[i] <= end)) {
+        return i;
+    }
+    return count;
+}
+
+/* compute the range of blocks [*first, *last] of the pattern that overlap
+ * with given start/end offsets, returns 1 if any block overlaps, 0 if not */
+static inline int pattern_block_range(
+    const struct extent_tree_pattern* p,
+    unsigned long start,
+    unsigned long end,
+    unsigned long* first,
+    unsigned long* last)
+{
+    if (end < p->start) {
+        return 0;
+    }
+
+    /* first block whose ending offset is at least start */
+    unsigned long lo = 0;
+    if (start >= (p->start + p->length)) {
+        unsigned long diff = start - (p->start + p->length - 1);
+        lo = (diff + p->stride - 1) / p->stride;
+    }
+
+    /* last block whose starting offset is at most end */
+    unsigned long hi = (end - p->start) / p->stride;
+    if (hi >= p->count) {
+        hi = p->count - 1;
+    }
+
+    if (lo > hi) {
+        return 0;
+    }
+    *first = lo;
+    *last  = hi;
+    return 1;
+}
+
+/* compute the range of patterns [*first, *last) that may overlap with
+ * given start/end offsets. patterns are sorted by start, and the running
+ * maximum of their ending offsets is non-decreasing, so both bounds are
+ * found with a binary search */
+static inline void flat_pattern_range(
+    struct extent_tree_flat* flat,
+    unsigned long start,
+    unsigned long end,
+    unsigned long* first,
+    unsigned long* last)
+{
+    /* first pattern whose blocks may extend to start */
+    unsigned long lo = flat_lower_bound(flat->pattern_max_end,
+                                        flat->n_patterns, start);
+
+    /* first pattern that starts beyond end */
+    unsigned long hi = flat->n_patterns;
+    unsigned long i = lo;
+    while (i < hi) {
+        unsigned long mid = i + ((hi - i) / 2);
+        if (flat->patterns[mid].start <= end) {
+            i = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *first = lo;
+    *last  = hi;
+}
+
+/* fill a (detached) tree node from the given block of a pattern */
+static inline void pattern_get_node(
+    const struct extent_tree_pattern* p,
+    unsigned long k,
+    struct extent_tree_node* node)
+{
+    node->start    = p->start + (k * p->stride);
+    node->end      = node->start + p->length - 1;
+    node->svr_rank = p->svr_rank;
+    node->app_id   = p->app_id;
+    node->cli_id   = p->cli_id;
+    node->pos      = p->pos + (k * p->pos_stride);
+    node->epoch    = p->epoch;
+}
+
+static int compare_node_start(const void* a, const void* b)
+{
+    const struct extent_tree_node* n1 = a;
+    const struct extent_tree_node* n2 = b;
+    if (n1->start < n2->start) {
+        return -1;
+    } else if (n1->start > n2->start) {
+        return 1;
+    }
+    return 0;
+}
+
+/* collect the extents of a compacted tree that overlap with given
+ * start/end offsets into a newly allocated array of detached nodes
+ * sorted by starting offset, expanding any overlapping pattern blocks.
+ * assumes caller has lock on tree. Returns 0 on success, ENOMEM if
+ * allocation fails */
+static int extent_tree_flat_collect(
+    struct extent_tree* extent_tree, /* compacted tree to search */
+    unsigned long start,             /* starting offset to search */
+    unsigned long end,               /* ending offset to search */
+    unsigned long* n_nodes,          /* [out] number of extents */
+    struct extent_tree_node** nodes) /* [out] extent array */
+{
+    struct extent_tree_flat* flat = extent_tree->flat;
+    unsigned long first, last;
+    unsigned long i, k;
+
+    *n_nodes = 0;
+    *nodes = NULL;
+
+    /* count overlapping plain extents */
+    unsigned long first_ndx = extent_tree_flat_find(extent_tree, start, end);
+    unsigned long end_ndx = first_ndx;
+    while ((end_ndx < flat->n_extents) && (flat->start[end_ndx] <= end)) {
+        end_ndx++;
+    }
+    unsigned long count = end_ndx - first_ndx;
+
+    /* count overlapping pattern blocks */
+    unsigned long pat_first, pat_last;
+    flat_pattern_range(flat, start, end, &pat_first, &pat_last);
+    unsigned long n_blocks = 0;
+    for (i = pat_first; i < pat_last; i++) {
+        const struct extent_tree_pattern* p = &flat->patterns[i];
+        if (pattern_block_range(p, start, end, &first, &last)) {
+            n_blocks += (last - first + 1);
+        }
+    }
+    count += n_blocks;
+
+    if (0 == count) {
+        return 0;
+    }
+
+    struct extent_tree_node* out_nodes = calloc(count, sizeof(*out_nodes));
+    if (NULL == out_nodes) {
+        return ENOMEM;
+    }
+
+    unsigned long n = 0;
+    for (i = first_ndx; i < end_ndx; i++) {
+        flat_get_node(flat, i, &out_nodes[n++]);
+    }
+    if (n_blocks) {
+        for (i = pat_first; i < pat_last; i++) {
+            const struct extent_tree_pattern* p = &flat->patterns[i];
+            if (pattern_block_range(p, start, end, &first, &last)) {
+                for (k = first; k <= last; k++) {
+                    pattern_get_node(p, k, &out_nodes[n++]);
+                }
+            }
+        }
+
+        /* extents never overlap, so sorting by start restores offset order */
+        qsort(out_nodes, count, sizeof(*out_nodes), compare_node_start);
+    }
+    assert(n == count);
+
+    *n_nodes = count;
+    *nodes = out_nodes;
+    return 0;
+}
+
 /* search tree for entry that overlaps with given start/end
  * offsets, return first overlapping entry if found, NULL otherwise,
- * assumes caller has lock on tree */
+ * assumes caller has lock on tree (see extent_tree_flat_find() for
+ * compacted trees) */
 struct extent_tree_node* extent_tree_find(
     struct extent_tree* extent_tree, /* tree to search */
     unsigned long start, /* starting offset to search */
@@ -323,7 +596,7 @@ struct extent_tree_node* extent_tree_find(
 {
     /* Create a range of just our starting byte offset */
     struct extent_tree_node* node = extent_tree_node_alloc(
-        start, start, 0, 0, 0, 0);
+        start, start, 0, 0, 0, 0, 0);
     if (!node) {
         return NULL;
     }
@@ -356,6 +629,11 @@ int extent_tree_truncate(
     struct extent_tree* tree, /* tree to truncate */
     unsigned long size)       /* size to truncate extents to */
 {
+    if (extent_tree_is_compact(tree)) {
+        LOGERR("cannot truncate a compacted extent tree");
+        return EROFS;
+    }
+
     if (0 == size) {
         extent_tree_clear(tree);
         return 0;
@@ -384,6 +662,7 @@ int extent_tree_truncate(
             /* remove this node from the tree and release it */
             LOGDBG("removing node [%lu, %lu] due to truncate=%lu",
                    node->start, node->end, size);
+            extent_ref(oldnode, oldnode->start, oldnode->end, 0);
             RB_REMOVE(ext_tree, &tree->head, oldnode);
             free(oldnode);
 
@@ -392,6 +671,7 @@ int extent_tree_truncate(
         } else {
             /* the range of this node overlaps with the truncated size
              * so just update its end to be the new size */
+            extent_ref(node, size, node->end, 0);
             node->end = size - 1;
             break;
         }
@@ -412,6 +692,55 @@ int extent_tree_truncate(
     return 0;
 }
 
+/* move the log data of extents within [start, end] that were written
+ * by the given client at log offset old_pos to log offset new_pos,
+ * synced at log release epoch new_epoch.
+ * Extents now holding other data are left alone. Returns EBUSY if some
+ * of the old data is held by an extent that extends beyond the range,
+ * or EROFS if the tree has been compacted */
+int extent_tree_relocate(
+    struct extent_tree* tree,  /* tree to update */
+    unsigned long start,       /* starting logical offset of data */
+    unsigned long end,         /* ending logical offset of data */
+    int svr_rank,              /* rank of server hosting data */
+    int app_id,                /* application id of client */
+    int cli_id,                /* client rank on server */
+    unsigned long old_pos,     /* current log offset of data */
+    unsigned long new_pos,     /* new log offset of data */
+    unsigned long new_epoch)   /* log release epoch of new data */
+{
+    if (extent_tree_is_compact(tree)) {
+        return EROFS;
+    }
+
+    int ret = 0;
+
+    extent_tree_wrlock(tree);
+
+    struct extent_tree_node* node = extent_tree_find(tree, start, end);
+    while ((NULL != node) && (node->start <= end)) {
+        if ((node->svr_rank == svr_rank) &&
+            (node->app_id == app_id) &&
+            (node->cli_id == cli_id) &&
+            (node->pos == (old_pos + (node->start - start)))) {
+            if ((node->start < start) || (node->end > end)) {
+                /* only part of this extent's data is being moved */
+                ret = EBUSY;
+            } else {
+                extent_ref(node, node->start, node->end, 0);
+                node->pos = new_pos + (node->start - start);
+                node->epoch = new_epoch;
+                extent_ref(node, node->start, node->end, 1);
+            }
+        }
+        node = extent_tree_iter(tree, node);
+    }
+
+    extent_tree_unlock(tree);
+
+    return ret;
+}
+
 /*
  * Given a range tree and a starting node, iterate though all the nodes
  * in the tree, returning the next one each time.  If start is NULL, then
@@ -509,6 +838,31 @@ void extent_tree_clear(struct extent_tree* extent_tree)
 
     extent_tree_wrlock(extent_tree);
 
+    /* release the flat index of a compacted tree */
+    if (NULL != extent_tree->flat) {
+        struct extent_tree_flat* flat = extent_tree->flat;
+        if (NULL != extent_ref_fn) {
+            unsigned long i, k;
+            for (i = 0; i < flat->n_extents; i++) {
+                extent_ref_fn(flat->svr_rank[i], flat->app_id[i],
+                              flat->cli_id[i], flat->pos[i],
+                              (flat->end[i] - flat->start[i]) + 1, 0);
+            }
+            for (i = 0; i < flat->n_patterns; i++) {
+                struct extent_tree_pattern* pat = flat->patterns + i;
+                for (k = 0; k < pat->count; k++) {
+                    extent_ref_fn(pat->svr_rank, pat->app_id, pat->cli_id,
+                                  pat->pos + (k * pat->pos_stride),
+                                  pat->length, 0);
+                }
+            }
+        }
+        free(extent_tree->flat);
+        extent_tree->flat  = NULL;
+        extent_tree->count = 0;
+        extent_tree->max   = 0;
+    }
+
     if (RB_EMPTY(&extent_tree->head)) {
         /* extent_tree is empty, nothing to do */
         extent_tree_unlock(extent_tree);
@@ -518,12 +872,14 @@ void extent_tree_clear(struct extent_tree* extent_tree)
     /* Remove and free each node in the tree */
     while ((node = extent_tree_iter(extent_tree, node))) {
         if (oldnode) {
+            extent_ref(oldnode, oldnode->start, oldnode->end, 0);
             RB_REMOVE(ext_tree, &extent_tree->head, oldnode);
             free(oldnode);
         }
         oldnode = node;
     }
     if (oldnode) {
+        extent_ref(oldnode, oldnode->start, oldnode->end, 0);
         RB_REMOVE(ext_tree, &extent_tree->head, oldnode);
         free(oldnode);
     }
@@ -575,7 +931,39 @@ int extent_tree_span(
     extent_tree_rdlock(extent_tree);
 
     int count = 0;
-    struct extent_tree_node* next = extent_tree_find(extent_tree, start, end);
+    struct extent_tree_node* next = NULL;
+    if (NULL != extent_tree->flat) {
+        /* walk the flat index of a compacted tree */
+        unsigned long n_nodes = 0;
+        struct extent_tree_node* nodes = NULL;
+        int rc = extent_tree_flat_collect(extent_tree, start, end,
+                                          &n_nodes, &nodes);
+        if (rc) {
+            extent_tree_unlock(extent_tree);
+            return rc;
+        }
+        for (unsigned long i = 0; (i < n_nodes) && (count < max); i++) {
+            struct extent_tree_node* node = &nodes[i];
+
+            /* fill in key */
+            unifyfs_key_t* key = &keys[count];
+            key->gfid   = gfid;
+            key->offset = node->start;
+
+            /* fill in value */
+            unifyfs_val_t* val = &vals[count];
+            val->addr           = node->pos;
+            val->len            = node->end - node->start + 1;
+            val->delegator_rank = node->svr_rank;
+            val->app_id         = node->app_id;
+            val->rank           = node->cli_id;
+
+            count++;
+        }
+        free(nodes);
+    } else {
+        next = extent_tree_find(extent_tree, start, end);
+    }
     while (next != NULL       &&
            next->start <= end &&
            count < max) {
@@ -640,6 +1028,7 @@ static void chunk_req_from_extent(
     chunk->rank = n->svr_rank;
     chunk->log_client_id = n->cli_id;
     chunk->log_app_id = n->app_id;
+    chunk->log_epoch = n->epoch;
 }
 
 int extent_tree_get_chunk_list(
@@ -659,6 +1048,40 @@ int extent_tree_get_chunk_list(
 
     extent_tree_rdlock(extent_tree);
 
+    if (NULL != extent_tree->flat) {
+        /* binary search the flat index of a compacted tree */
+        unsigned long n_nodes = 0;
+        struct extent_tree_node* nodes = NULL;
+        ret = extent_tree_flat_collect(extent_tree, offset, end,
+                                       &n_nodes, &nodes);
+        if (ret) {
+            goto out_unlock;
+        }
+        count = (unsigned int) n_nodes;
+
+        *n_chunks = count;
+        if (0 == count) {
+            goto out_unlock;
+        }
+
+        out_chunks = calloc(count, sizeof(*out_chunks));
+        if (!out_chunks) {
+            free(nodes);
+            ret = ENOMEM;
+            goto out_unlock;
+        }
+
+        current = out_chunks;
+        for (unsigned long i = 0; i < n_nodes; i++) {
+            chunk_req_from_extent(offset, len, &nodes[i], current);
+            current += 1;
+        }
+        free(nodes);
+
+        *chunks = out_chunks;
+        goto out_unlock;
+    }
+
     first = extent_tree_find(extent_tree, offset, end);
     next = first;
     while (next && next->start <= end) {
@@ -696,3 +1119,310 @@ out_unlock:
     return ret;
 }
 
+/* node reference used to group extents by client during compaction */
+struct compact_ref {
+    struct extent_tree_node* node; /* extent tree node */
+    unsigned long ndx;             /* index of node in offset order */
+};
+
+/* order by server rank, app id, client id, then starting offset */
+static int compare_compact_ref(const void* a, const void* b)
+{
+    const struct extent_tree_node* n1 = ((const struct compact_ref*)a)->node;
+    const struct extent_tree_node* n2 = ((const struct compact_ref*)b)->node;
+    if (n1->svr_rank != n2->svr_rank) {
+        return (n1->svr_rank < n2->svr_rank) ? -1 : 1;
+    }
+    if (n1->app_id != n2->app_id) {
+        return (n1->app_id < n2->app_id) ? -1 : 1;
+    }
+    if (n1->cli_id != n2->cli_id) {
+        return (n1->cli_id < n2->cli_id) ? -1 : 1;
+    }
+    return compare_node_start(n1, n2);
+}
+
+static int compare_pattern_start(const void* a, const void* b)
+{
+    const struct extent_tree_pattern* p1 = a;
+    const struct extent_tree_pattern* p2 = b;
+    if (p1->start < p2->start) {
+        return -1;
+    } else if (p1->start > p2->start) {
+        return 1;
+    }
+    return 0;
+}
+
+/* return 1 if both nodes were written by the same client */
+static inline int same_client(
+    const struct extent_tree_node* n1,
+    const struct extent_tree_node* n2)
+{
+    return ((n1->svr_rank == n2->svr_rank) &&
+            (n1->app_id == n2->app_id) &&
+            (n1->cli_id == n2->cli_id));
+}
+
+/* find runs of regularly strided extents from the same client, and record
+ * them as patterns. refs must be sorted with compare_compact_ref(). sets
+ * in_pattern[ndx] for each node covered by a pattern, and returns the
+ * number of patterns written to patterns (which must have room for
+ * n / EXTENT_TREE_PATTERN_MIN entries) */
+static unsigned long find_extent_patterns(
+    struct compact_ref* refs,
+    unsigned long n,
+    char* in_pattern,
+    struct extent_tree_pattern* patterns)
+{
+    unsigned long n_patterns = 0;
+    unsigned long j = 0;
+    while (j < n) {
+        struct extent_tree_node* base = refs[j].node;
+        unsigned long length = base->end - base->start + 1;
+        unsigned long stride = 0;
+        unsigned long pos_stride = 0;
+
+        /* extend the run while length, stride and log stride hold */
+        unsigned long m = j + 1;
+        for ( ; m < n; m++) {
+            struct extent_tree_node* prev = refs[m - 1].node;
+            struct extent_tree_node* curr = refs[m].node;
+            if (!same_client(prev, curr) ||
+                (curr->epoch != prev->epoch) ||
+                ((curr->end - curr->start + 1) != length)) {
+                break;
+            }
+
+            /* the log offset stride may be negative, which unsigned
+             * arithmetic handles by wrapping around */
+            unsigned long s  = curr->start - prev->start;
+            unsigned long ps = curr->pos - prev->pos;
+            if (m == (j + 1)) {
+                stride     = s;
+                pos_stride = ps;
+            } else if ((s != stride) || (ps != pos_stride)) {
+                break;
+            }
+        }
+
+        unsigned long run = m - j;
+        if (run < EXTENT_TREE_PATTERN_MIN) {
+            j++;
+            continue;
+        }
+
+        struct extent_tree_pattern* p = &patterns[n_patterns++];
+        p->start      = base->start;
+        p->length     = length;
+        p->stride     = stride;
+        p->count      = run;
+        p->pos        = base->pos;
+        p->pos_stride = pos_stride;
+        p->svr_rank   = base->svr_rank;
+        p->app_id     = base->app_id;
+        p->cli_id     = base->cli_id;
+        p->epoch      = base->epoch;
+        for (unsigned long k = j; k < m; k++) {
+            in_pattern[refs[k].ndx] = 1;
+        }
+        j = m;
+    }
+    return n_patterns;
+}
+
+/* Convert the tree into an immutable flat index, freeing all tree nodes */
+int extent_tree_compact(struct extent_tree* extent_tree)
+{
+    int ret = 0;
+    unsigned long i;
+
+    extent_tree_wrlock(extent_tree);
+
+    if ((NULL != extent_tree->flat) || (0 == extent_tree->count)) {
+        /* already compacted, or nothing to compact */
+        goto out_unlock;
+    }
+
+    /* group nodes by client to find strided patterns */
+    unsigned long n = extent_tree->count;
+    struct compact_ref* refs = calloc(n, sizeof(*refs));
+    char* in_pattern = calloc(n, sizeof(char));
+    struct extent_tree_pattern* tmp_patterns =
+        calloc((n / EXTENT_TREE_PATTERN_MIN) + 1, sizeof(*tmp_patterns));
+    if ((NULL == refs) || (NULL == in_pattern) || (NULL == tmp_patterns)) {
+        LOGERR("failed to allocate extent compaction state");
+        free(refs);
+        free(in_pattern);
+        free(tmp_patterns);
+        ret = ENOMEM;
+        goto out_unlock;
+    }
+
+    i = 0;
+    struct extent_tree_node* node = NULL;
+    while (NULL != (node = extent_tree_iter(extent_tree, node))) {
+        refs[i].node = node;
+        refs[i].ndx  = i;
+        i++;
+    }
+    assert(i == n);
+    qsort(refs, n, sizeof(*refs), compare_compact_ref);
+
+    unsigned long n_patterns = find_extent_patterns(refs, n, in_pattern,
+                                                    tmp_patterns);
+    unsigned long n_extents = n;
+    for (i = 0; i < n_patterns; i++) {
+        n_extents -= tmp_patterns[i].count;
+    }
+
+    /* allocate all arrays with a single allocation, placing the arrays
+     * of longs and the patterns ahead of the arrays of ints to keep them
+     * aligned */
+    size_t sz = sizeof(struct extent_tree_flat) +
+                (n_extents * 4 * sizeof(unsigned long)) +
+                (n_patterns * sizeof(unsigned long)) +
+                (n_patterns * sizeof(struct extent_tree_pattern)) +
+                (n_extents * 3 * sizeof(int));
+    struct extent_tree_flat* flat = malloc(sz);
+    if (NULL == flat) {
+        LOGERR("failed to allocate flat extent index");
+        free(refs);
+        free(in_pattern);
+        free(tmp_patterns);
+        ret = ENOMEM;
+        goto out_unlock;
+    }
+    flat->bytes      = sz;
+    flat->n_extents  = n_extents;
+    flat->start      = (unsigned long*)(flat + 1);
+    flat->end        = flat->start + n_extents;
+    flat->pos        = flat->end + n_extents;
+    flat->epoch      = flat->pos + n_extents;
+    flat->pattern_max_end = flat->epoch + n_extents;
+    flat->n_patterns = n_patterns;
+    flat->patterns   = (struct extent_tree_pattern*)
+                       (flat->pattern_max_end + n_patterns);
+    flat->svr_rank   = (int*)(flat->patterns + n_patterns);
+    flat->app_id     = flat->svr_rank + n_extents;
+    flat->cli_id     = flat->app_id + n_extents;
+
+    memcpy(flat->patterns, tmp_patterns,
+           n_patterns * sizeof(struct extent_tree_pattern));
+    qsort(flat->patterns, n_patterns, sizeof(struct extent_tree_pattern),
+          compare_pattern_start);
+
+    /* record the running maximum of pattern ending offsets, patterns of
+     * different clients interleave so a later pattern may end earlier */
+    unsigned long max_end = 0;
+    for (i = 0; i < n_patterns; i++) {
+        struct extent_tree_pattern* p = flat->patterns + i;
+        unsigned long p_end = p->start + ((p->count - 1) * p->stride) +
+                              p->length - 1;
+        if (p_end > max_end) {
+            max_end = p_end;
+        }
+        flat->pattern_max_end[i] = max_end;
+    }
+
+    /* copy the remaining nodes in order */
+    unsigned long e = 0;
+    i = 0;
+    node = NULL;
+    while (NULL != (node = extent_tree_iter(extent_tree, node))) {
+        if (!in_pattern[i]) {
+            flat->start[e]    = node->start;
+            flat->end[e]      = node->end;
+            flat->pos[e]      = node->pos;
+            flat->epoch[e]    = node->epoch;
+            flat->svr_rank[e] = node->svr_rank;
+            flat->app_id[e]   = node->app_id;
+            flat->cli_id[e]   = node->cli_id;
+            e++;
+        }
+        i++;
+    }
+    assert(i == n);
+    assert(e == n_extents);
+
+    /* release all tree nodes */
+    for (i = 0; i < n; i++) {
+        free(refs[i].node);
+    }
+    RB_INIT(&extent_tree->head);
+
+    free(refs);
+    free(in_pattern);
+    free(tmp_patterns);
+
+    extent_tree->flat = flat;
+
+    LOGDBG("compacted %lu extents into flat index of %lu extents "
+           "and %lu patterns (%zu bytes)", n, n_extents, n_patterns, sz);
+
+out_unlock:
+    extent_tree_unlock(extent_tree);
+
+    return ret;
+}
+
+/* Return 1 if the tree has been compacted, 0 otherwise */
+int extent_tree_is_compact(struct extent_tree* extent_tree)
+{
+    extent_tree_rdlock(extent_tree);
+    int compact = (NULL != extent_tree->flat);
+    extent_tree_unlock(extent_tree);
+    return compact;
+}
+
+/* copy all extents in the tree to a newly allocated array */
+int extent_tree_get_nodes(
+    struct extent_tree* extent_tree,   /* extent tree to copy */
+    size_t* n_nodes,                   /* [out] number of extents */
+    struct extent_tree_node** nodes)   /* [out] extent array */
+{
+    int ret = 0;
+    unsigned long i = 0;
+
+    *n_nodes = 0;
+    *nodes = NULL;
+
+    extent_tree_rdlock(extent_tree);
+
+    unsigned long n = extent_tree->count;
+    if (0 == n) {
+        goto out_unlock;
+    }
+
+    if (NULL != extent_tree->flat) {
+        /* expand the whole compacted index */
+        unsigned long n_flat = 0;
+        ret = extent_tree_flat_collect(extent_tree, 0, ULONG_MAX,
+                                       &n_flat, nodes);
+        if (0 == ret) {
+            assert(n_flat == n);
+            *n_nodes = (size_t) n_flat;
+        }
+        goto out_unlock;
+    }
+
+    struct extent_tree_node* out_nodes = calloc(n, sizeof(*out_nodes));
+    if (NULL == out_nodes) {
+        ret = ENOMEM;
+        goto out_unlock;
+    }
+
+    struct extent_tree_node* curr = NULL;
+    while (NULL != (curr = extent_tree_iter(extent_tree, curr))) {
+        out_nodes[i] = *curr;
+        i++;
+    }
+
+    *n_nodes = n;
+    *nodes = out_nodes;
+
+out_unlock:
+    extent_tree_unlock(extent_tree);
+
+    return ret;
+}
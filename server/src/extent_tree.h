@@ -25,6 +25,48 @@ struct extent_tree_node {
     int app_id;          /* application id (namespace) on server rank */
     int cli_id;          /* client rank on server rank */
     unsigned long pos;   /* physical offset of data in log */
+    unsigned long epoch; /* log release epoch when data was synced */
+};
+
+/* a run of equal-length extents written by a single client at a regular
+ * stride, as produced by IOR-style strided writes. Block k of the pattern
+ * covers logical offsets [start + k*stride, start + k*stride + length - 1]
+ * and its data begins at log offset pos + k*pos_stride */
+struct extent_tree_pattern {
+    unsigned long start;      /* starting logical offset of first block */
+    unsigned long length;     /* length of each block */
+    unsigned long stride;     /* logical offset stride between blocks */
+    unsigned long count;      /* number of blocks */
+    unsigned long pos;        /* physical offset of first block in log */
+    unsigned long pos_stride; /* physical offset stride between blocks */
+    int svr_rank;             /* rank of server hosting data */
+    int app_id;               /* application id (namespace) on server rank */
+    int cli_id;               /* client rank on server rank */
+    unsigned long epoch;      /* log release epoch of all blocks */
+};
+
+/* minimum number of regularly strided extents stored as a pattern */
+#define EXTENT_TREE_PATTERN_MIN 4
+
+/* immutable flat index of extents, sorted by starting offset and stored
+ * as a struct-of-arrays in a single allocation. Regularly strided extents
+ * are stored as patterns instead, and expanded on lookup. Lookups binary
+ * search both the extents and the patterns, using pattern_max_end to find
+ * the first pattern that can reach a range, so they never scan all
+ * patterns */
+struct extent_tree_flat {
+    size_t bytes;          /* total size of the flat index allocation */
+    unsigned long n_extents; /* number of extents stored in arrays below */
+    unsigned long* start;  /* starting logical offset of each extent */
+    unsigned long* end;    /* ending logical offset of each extent */
+    unsigned long* pos;    /* physical offset of data in log */
+    unsigned long* epoch;  /* log release epoch when data was synced */
+    int* svr_rank;         /* rank of server hosting data */
+    int* app_id;           /* application id (namespace) on server rank */
+    int* cli_id;           /* client rank on server rank */
+    unsigned long n_patterns; /* number of strided patterns */
+    struct extent_tree_pattern* patterns; /* patterns, sorted by start */
+    unsigned long* pattern_max_end; /* max ending offset of patterns [0, i] */
 };
 
 struct extent_tree {
@@ -32,8 +74,26 @@ struct extent_tree {
     pthread_rwlock_t rwlock;
     unsigned long count;     /* number of segments stored in tree */
     unsigned long max;       /* maximum logical offset value in the tree */
+    struct extent_tree_flat* flat; /* flat index, set once compacted */
 };
 
+/* callback invoked as log data referenced by extents is added to or
+ * removed from any extent tree, given the server rank, application and
+ * client ids, log offset, and length of the data, with added set to
+ * nonzero for new references. Splitting and coalescing extents does not
+ * change the referenced data, and compacting a tree keeps its references.
+ * It is called with the tree locked for writing */
+typedef void (*extent_tree_ref_fn)(int svr_rank,
+                                   int app_id,
+                                   int cli_id,
+                                   unsigned long pos,
+                                   unsigned long length,
+                                   int added);
+
+/* set the log data reference callback for all extent trees,
+ * pass NULL to disable */
+void extent_tree_set_ref_callback(extent_tree_ref_fn fn);
+
 /* Returns 0 on success, positive non-zero error code otherwise */
 int extent_tree_init(struct extent_tree* extent_tree);
 
@@ -50,6 +110,7 @@ void extent_tree_destroy(struct extent_tree* extent_tree);
 
 /*
  * Add an entry to the range tree.  Returns 0 on success, nonzero otherwise.
+ * Returns EROFS if the tree has been compacted.
  */
 int extent_tree_add(
     struct extent_tree* extent_tree, /* tree to add new extent item */
@@ -58,7 +119,8 @@ int extent_tree_add(
     int svr_rank,        /* rank of server hosting data */
     int app_id,          /* application id (namespace) on server rank */
     int cli_id,          /* client rank on server rank */
-    unsigned long pos    /* physical offset of data in log */
+    unsigned long pos,   /* physical offset of data in log */
+    unsigned long epoch  /* log release epoch when data was synced */
 );
 
 /* search tree for entry that overlaps with given start/end
@@ -72,12 +134,32 @@ struct extent_tree_node* extent_tree_find(
 
 /* truncate extents to use new maximum, discards extent entries
  * that exceed the new truncated size, and rewrites any entry
- * that overlaps */
+ * that overlaps. Returns EROFS if the tree has been compacted. */
 int extent_tree_truncate(
     struct extent_tree* extent_tree, /* tree to truncate */
     unsigned long size               /* size to truncate extents to */
 );
 
+/*
+ * Move the log data of extents in [start, end] that the given client wrote
+ * at log offset old_pos to new_pos, as done when compacting a client log.
+ * The moved extents get the log release epoch new_epoch.
+ * Extents that now hold other data are left alone. Returns 0 on success,
+ * EBUSY if an extent holding some of the data extends beyond the range,
+ * or EROFS if the tree has been compacted.
+ */
+int extent_tree_relocate(
+    struct extent_tree* extent_tree, /* tree to update */
+    unsigned long start,   /* starting logical offset of data */
+    unsigned long end,     /* ending logical offset of data */
+    int svr_rank,          /* rank of server hosting data */
+    int app_id,            /* application id (namespace) on server rank */
+    int cli_id,            /* client rank on server rank */
+    unsigned long old_pos, /* current physical offset of data in log */
+    unsigned long new_pos, /* new physical offset of data in log */
+    unsigned long new_epoch /* log release epoch of data at new_pos */
+);
+
 /*
  * Given a range tree and a starting node, iterate though all the nodes
  * in the tree, returning the next one each time.  If start is NULL, then
@@ -97,6 +179,9 @@ int extent_tree_truncate(
  * Note: this function does no locking, and assumes you're properly locking
  * and unlocking the extent_tree before doing the iteration (see
  * extent_tree_rdlock()/extent_tree_wrlock()/extent_tree_unlock()).
+ *
+ * Note: a compacted tree has no nodes to iterate over, so this always
+ * returns NULL for such trees. Use extent_tree_get_nodes() instead.
  */
 struct extent_tree_node* extent_tree_iter(
     struct extent_tree* extent_tree,
@@ -164,6 +249,28 @@ int extent_tree_get_chunk_list(
     unsigned int* n_chunks,          /* [out] number of chunks returned */
     chunk_read_req_t** chunks);      /* [out] extent array */
 
+/*
+ * Convert the tree into an immutable flat index, freeing all tree nodes.
+ * Lookups on a compacted tree use binary search over contiguous arrays,
+ * and the tree can no longer be modified other than by clearing it.
+ * Runs of at least EXTENT_TREE_PATTERN_MIN extents from the same client
+ * with equal length and constant logical and log strides are stored as
+ * a single pattern entry.
+ * This is meant to be done once a file is laminated.
+ * Returns 0 on success (or if already compacted), ENOMEM otherwise.
+ */
+int extent_tree_compact(struct extent_tree* extent_tree);
+
+/* Return 1 if the tree has been compacted, 0 otherwise */
+int extent_tree_is_compact(struct extent_tree* extent_tree);
+
+/* copy all extents in the tree to a newly allocated array, which the
+ * caller should free(). Works for both normal and compacted trees. */
+int extent_tree_get_nodes(
+    struct extent_tree* extent_tree,   /* extent tree to copy */
+    size_t* n_nodes,                   /* [out] number of extents */
+    struct extent_tree_node** nodes);  /* [out] extent array */
+
 /* dump method for debugging extent trees */
 static inline
 void extent_tree_dump(struct extent_tree* extent_tree)
@@ -174,6 +281,22 @@ void extent_tree_dump(struct extent_tree* extent_tree)
 
     extent_tree_rdlock(extent_tree);
 
+    struct extent_tree_flat* flat = extent_tree->flat;
+    if (NULL != flat) {
+        for (unsigned long i = 0; i < flat->n_extents; i++) {
+            LOGDBG("[%lu-%lu] @ %d(%d:%d) log offset %lu",
+                   flat->start[i], flat->end[i], flat->svr_rank[i],
+                   flat->app_id[i], flat->cli_id[i], flat->pos[i]);
+        }
+        for (unsigned long i = 0; i < flat->n_patterns; i++) {
+            struct extent_tree_pattern* p = &flat->patterns[i];
+            LOGDBG("[%lu-%lu] x %lu stride %lu @ %d(%d:%d) "
+                   "log offset %lu stride %lu",
+                   p->start, p->start + p->length - 1, p->count, p->stride,
+                   p->svr_rank, p->app_id, p->cli_id, p->pos, p->pos_stride);
+        }
+    }
+
     struct extent_tree_node* node = NULL;
     while ((node = extent_tree_iter(extent_tree, node))) {
         LOGDBG("[%lu-%lu] @ %d(%d:%d) log offset %lu",
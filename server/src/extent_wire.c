@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extent_wire.h"
+
+/* dictionary of the distinct logs referenced by a set of extents */
+struct wire_logs {
+    size_t count;      /* number of logs */
+    int* svr_rank;     /* log server rank */
+    int* app_id;       /* log application id */
+    int* cli_id;       /* log client id */
+    uint64_t* next;    /* expected log position of next extent */
+    uint64_t* epoch;   /* log release epoch of previous extent */
+    size_t* index;     /* log index of each extent (encode only) */
+};
+
+static void wire_logs_free(struct wire_logs* logs)
+{
+    free(logs->svr_rank);
+    free(logs->app_id);
+    free(logs->cli_id);
+    free(logs->next);
+    free(logs->epoch);
+    free(logs->index);
+    memset(logs, 0, sizeof(*logs));
+}
+
+static int wire_logs_alloc(struct wire_logs* logs, size_t max_logs)
+{
+    memset(logs, 0, sizeof(*logs));
+    if (0 == max_logs) {
+        return 0;
+    }
+    logs->svr_rank = calloc(max_logs, sizeof(int));
+    logs->app_id = calloc(max_logs, sizeof(int));
+    logs->cli_id = calloc(max_logs, sizeof(int));
+    logs->next = calloc(max_logs, sizeof(uint64_t));
+    logs->epoch = calloc(max_logs, sizeof(uint64_t));
+    if ((NULL == logs->svr_rank) || (NULL == logs->app_id) ||
+        (NULL == logs->cli_id) || (NULL == logs->next) ||
+        (NULL == logs->epoch)) {
+        wire_logs_free(logs);
+        return ENOMEM;
+    }
+    return 0;
+}
+
+static inline uint64_t zigzag_encode(int64_t val)
+{
+    return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t val)
+{
+    return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+static inline size_t varint_size(uint64_t val)
+{
+    size_t n = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline unsigned char* varint_put(unsigned char* p, uint64_t val)
+{
+    while (val >= 0x80) {
+        *p++ = (unsigned char)(val | 0x80);
+        val >>= 7;
+    }
+    *p++ = (unsigned char)val;
+    return p;
+}
+
+/* read a varint from [*p, end), returns 0 on success or EINVAL */
+static inline int varint_get(const unsigned char** p,
+                             const unsigned char* end,
+                             uint64_t* val)
+{
+    uint64_t v = 0;
+    int shift = 0;
+    const unsigned char* c = *p;
+    while (c < end) {
+        unsigned char byte = *c++;
+        if (shift > 63) {
+            return EINVAL;
+        }
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *p = c;
+            *val = v;
+            return 0;
+        }
+        shift += 7;
+    }
+    return EINVAL;
+}
+
+/* build the dictionary of logs for the extents, using an open addressing
+ * hash table from log to dictionary index */
+static int wire_logs_build(const struct extent_tree_node* extents,
+                           size_t num_extents,
+                           struct wire_logs* logs)
+{
+    size_t i;
+    int rc = wire_logs_alloc(logs, num_extents);
+    if (rc || (0 == num_extents)) {
+        return rc;
+    }
+    logs->index = calloc(num_extents, sizeof(size_t));
+
+    size_t cap = 16;
+    while (cap < (2 * num_extents)) {
+        cap <<= 1;
+    }
+    size_t* slots = malloc(cap * sizeof(size_t));
+    if ((NULL == logs->index) || (NULL == slots)) {
+        free(slots);
+        wire_logs_free(logs);
+        return ENOMEM;
+    }
+    for (i = 0; i < cap; i++) {
+        slots[i] = SIZE_MAX;
+    }
+
+    for (i = 0; i < num_extents; i++) {
+        const struct extent_tree_node* ext = extents + i;
+        uint64_t h = ((uint64_t)(unsigned int)ext->svr_rank * 0x9E3779B1u) ^
+                     ((uint64_t)(unsigned int)ext->app_id * 0x85EBCA77u) ^
+                     ((uint64_t)(unsigned int)ext->cli_id * 0xC2B2AE3Du);
+        size_t s = (size_t)(h ^ (h >> 17)) & (cap - 1);
+        while (slots[s] != SIZE_MAX) {
+            size_t l = slots[s];
+            if ((logs->svr_rank[l] == ext->svr_rank) &&
+                (logs->app_id[l] == ext->app_id) &&
+                (logs->cli_id[l] == ext->cli_id)) {
+                break;
+            }
+            s = (s + 1) & (cap - 1);
+        }
+        if (slots[s] == SIZE_MAX) {
+            size_t l = logs->count++;
+            logs->svr_rank[l] = ext->svr_rank;
+            logs->app_id[l] = ext->app_id;
+            logs->cli_id[l] = ext->cli_id;
+            slots[s] = l;
+        }
+        logs->index[i] = slots[s];
+    }
+
+    free(slots);
+    return 0;
+}
+
+int extent_wire_encode(const struct extent_tree_node* extents,
+                       size_t num_extents,
+                       void** buf,
+                       size_t* size)
+{
+    size_t i;
+    struct wire_logs logs;
+    int rc = wire_logs_build(extents, num_extents, &logs);
+    if (rc) {
+        return rc;
+    }
+
+    /* first pass computes the encoded size */
+    size_t bytes = varint_size(EXTENT_WIRE_VERSION) +
+                   varint_size(num_extents) +
+                   varint_size(logs.count);
+    for (i = 0; i < logs.count; i++) {
+        bytes += varint_size(zigzag_encode(logs.svr_rank[i]));
+        bytes += varint_size(zigzag_encode(logs.app_id[i]));
+        bytes += varint_size(zigzag_encode(logs.cli_id[i]));
+    }
+    uint64_t next_start = 0;
+    for (i = 0; i < num_extents; i++) {
+        const struct extent_tree_node* ext = extents + i;
+        size_t l = logs.index[i];
+        uint64_t length = (uint64_t)(ext->end - ext->start);
+        bytes += varint_size(l);
+        bytes += varint_size(zigzag_encode(
+            (int64_t)((uint64_t)ext->start - next_start)));
+        bytes += varint_size(length);
+        bytes += varint_size(zigzag_encode(
+            (int64_t)((uint64_t)ext->pos - logs.next[l])));
+        bytes += varint_size(zigzag_encode(
+            (int64_t)((uint64_t)ext->epoch - logs.epoch[l])));
+        next_start = (uint64_t)ext->end + 1;
+        logs.next[l] = (uint64_t)ext->pos + length + 1;
+        logs.epoch[l] = (uint64_t)ext->epoch;
+    }
+
+    unsigned char* out = malloc(bytes);
+    if (NULL == out) {
+        wire_logs_free(&logs);
+        return ENOMEM;
+    }
+
+    /* second pass writes the encoded extents */
+    unsigned char* p = out;
+    p = varint_put(p, EXTENT_WIRE_VERSION);
+    p = varint_put(p, num_extents);
+    p = varint_put(p, logs.count);
+    for (i = 0; i < logs.count; i++) {
+        p = varint_put(p, zigzag_encode(logs.svr_rank[i]));
+        p = varint_put(p, zigzag_encode(logs.app_id[i]));
+        p = varint_put(p, zigzag_encode(logs.cli_id[i]));
+        logs.next[i] = 0;
+        logs.epoch[i] = 0;
+    }
+    next_start = 0;
+    for (i = 0; i < num_extents; i++) {
+        const struct extent_tree_node* ext = extents + i;
+        size_t l = logs.index[i];
+        uint64_t length = (uint64_t)(ext->end - ext->start);
+        p = varint_put(p, l);
+        p = varint_put(p, zigzag_encode(
+            (int64_t)((uint64_t)ext->start - next_start)));
+        p = varint_put(p, length);
+        p = varint_put(p, zigzag_encode(
+            (int64_t)((uint64_t)ext->pos - logs.next[l])));
+        p = varint_put(p, zigzag_encode(
+            (int64_t)((uint64_t)ext->epoch - logs.epoch[l])));
+        next_start = (uint64_t)ext->end + 1;
+        logs.next[l] = (uint64_t)ext->pos + length + 1;
+        logs.epoch[l] = (uint64_t)ext->epoch;
+    }
+
+    wire_logs_free(&logs);
+
+    *buf = out;
+    *size = bytes;
+    return 0;
+}
+
+int extent_wire_decode(const void* buf,
+                       size_t size,
+                       size_t* num_extents,
+                       struct extent_tree_node** extents)
+{
+    size_t i;
+    uint64_t version, count, num_logs;
+    const unsigned char* p = buf;
+    const unsigned char* end = p + size;
+
+    *num_extents = 0;
+    *extents = NULL;
+
+    if ((NULL == buf) ||
+        varint_get(&p, end, &version) ||
+        (version != EXTENT_WIRE_VERSION) ||
+        varint_get(&p, end, &count) ||
+        varint_get(&p, end, &num_logs)) {
+        return EINVAL;
+    }
+
+    /* each log takes at least 3 bytes and each extent at least 5,
+     * which bounds allocations for corrupt counts */
+    size_t remaining = (size_t)(end - p);
+    if ((num_logs > (remaining / 3)) || (count > (remaining / 5)) ||
+        (num_logs > count)) {
+        return EINVAL;
+    }
+
+    struct wire_logs logs;
+    int rc = wire_logs_alloc(&logs, (size_t)num_logs);
+    if (rc) {
+        return rc;
+    }
+    for (i = 0; i < num_logs; i++) {
+        uint64_t svr, app, cli;
+        if (varint_get(&p, end, &svr) ||
+            varint_get(&p, end, &app) ||
+            varint_get(&p, end, &cli)) {
+            wire_logs_free(&logs);
+            return EINVAL;
+        }
+        logs.svr_rank[i] = (int) zigzag_decode(svr);
+        logs.app_id[i] = (int) zigzag_decode(app);
+        logs.cli_id[i] = (int) zigzag_decode(cli);
+    }
+
+    struct extent_tree_node* out = NULL;
+    if (count > 0) {
+        out = calloc((size_t)count, sizeof(*out));
+        if (NULL == out) {
+            wire_logs_free(&logs);
+            return ENOMEM;
+        }
+    }
+
+    uint64_t next_start = 0;
+    for (i = 0; i < count; i++) {
+        uint64_t l, start_delta, length, pos_delta, epoch_delta;
+        if (varint_get(&p, end, &l) || (l >= num_logs) ||
+            varint_get(&p, end, &start_delta) ||
+            varint_get(&p, end, &length) ||
+            varint_get(&p, end, &pos_delta) ||
+            varint_get(&p, end, &epoch_delta)) {
+            free(out);
+            wire_logs_free(&logs);
+            return EINVAL;
+        }
+        struct extent_tree_node* ext = out + i;
+        uint64_t start = next_start + (uint64_t)zigzag_decode(start_delta);
+        uint64_t pos = logs.next[l] + (uint64_t)zigzag_decode(pos_delta);
+        uint64_t epoch = logs.epoch[l] +
+                         (uint64_t)zigzag_decode(epoch_delta);
+        ext->start = (unsigned long) start;
+        ext->end = (unsigned long)(start + length);
+        ext->pos = (unsigned long) pos;
+        ext->epoch = (unsigned long) epoch;
+        ext->svr_rank = logs.svr_rank[l];
+        ext->app_id = logs.app_id[l];
+        ext->cli_id = logs.cli_id[l];
+        next_start = start + length + 1;
+        logs.next[l] = pos + length + 1;
+        logs.epoch[l] = epoch;
+    }
+
+    wire_logs_free(&logs);
+
+    if (p != end) {
+        free(out);
+        return EINVAL;
+    }
+
+    *num_extents = (size_t) count;
+    *extents = out;
+    return 0;
+}
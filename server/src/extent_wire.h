@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef __EXTENT_WIRE_H__
+#define __EXTENT_WIRE_H__
+
+#include <stddef.h>
+
+#include "extent_tree.h"
+
+/*
+ * Compact wire format for arrays of extents sent between servers.
+ *
+ * Unlike a raw array of struct extent_tree_node, the format has no extent
+ * tree pointers or padding. The distinct (svr_rank, app_id, cli_id) logs
+ * holding the data of the extents are stored once in a dictionary, and
+ * each extent refers to its log by dictionary index. Offsets are stored
+ * as variable-length integers, with the start offset relative to the end
+ * of the previous extent, and the log position and log release epoch
+ * relative to those of the previous extent from the same log. Contiguous
+ * and strided writes thus encode to a few bytes per extent.
+ *
+ * Layout, where all values are LEB128 varints and signed values are
+ * zigzag-encoded:
+ *   version, num_extents, num_logs
+ *   num_logs x (svr_rank, app_id, cli_id)
+ *   num_extents x (log index, start delta, end - start, pos delta,
+ *                  epoch delta)
+ */
+
+#define EXTENT_WIRE_VERSION 2
+
+/*
+ * Encode the array of extents. On success, sets buf to an allocated buffer
+ * holding the encoded extents, and size to its length in bytes. The caller
+ * must free the buffer.
+ *
+ * Returns 0 on success, ENOMEM if allocation fails.
+ */
+int extent_wire_encode(const struct extent_tree_node* extents,
+                       size_t num_extents,
+                       void** buf,
+                       size_t* size);
+
+/*
+ * Decode the size bytes of encoded extents in buf. On success, sets
+ * num_extents to the number of extents and extents to an allocated
+ * array holding them (NULL if there are none). The caller must free
+ * the array.
+ *
+ * Returns 0 on success, EINVAL if buf is malformed, or ENOMEM if
+ * allocation fails.
+ */
+int extent_wire_decode(const void* buf,
+                       size_t size,
+                       size_t* num_extents,
+                       struct extent_tree_node** extents);
+
+#endif /* __EXTENT_WIRE_H__ */
@@ -28,10 +28,141 @@
 ServerRpcContext_t* unifyfsd_rpc_context;
 bool margo_use_tcp = true;
 bool margo_lazy_connect; // = false
-int  margo_client_server_pool_sz = 4;
-int  margo_server_server_pool_sz = 4;
+int  margo_client_server_pool_sz = UNIFYFS_MARGO_CLIENT_POOL_SIZE;
+int  margo_server_server_pool_sz = UNIFYFS_MARGO_SERVER_POOL_SIZE;
+int  margo_meta_pool_sz = UNIFYFS_MARGO_META_POOL_SIZE;
+int  margo_data_pool_sz = UNIFYFS_MARGO_DATA_POOL_SIZE;
+int  margo_coll_pool_sz = UNIFYFS_MARGO_COLL_POOL_SIZE;
+int  margo_io_pool_sz = UNIFYFS_MARGO_IO_POOL_SIZE;
 int  margo_use_progress_thread = 1;
 
+/* Rpc handlers are run in a pool of handler threads chosen by the class of
+ * the rpc, so that bursts of large data transfers or broadcasts do not
+ * delay small metadata rpcs queued behind them. Each class pool is shared
+ * by the client-server and server-server margo instances. A class with no
+ * threads uses the default handler pool of each margo instance. The io
+ * pool also runs work that rpc handlers hand off, so that blocking i/o
+ * on backing files does not hold up the handler threads. */
+typedef enum {
+    RPC_POOL_META = 0, /* metadata lookups and updates */
+    RPC_POOL_DATA,     /* file data reads */
+    RPC_POOL_COLL,     /* collective broadcasts among servers */
+    RPC_POOL_IO,       /* i/o on backing files */
+    RPC_POOL_COUNT
+} rpc_pool_class_e;
+
+typedef struct {
+    const char* name;
+    int* size;             /* number of handler threads */
+    ABT_pool pool;         /* pool of handler ULTs */
+    ABT_xstream* xstreams; /* handler threads */
+} rpc_pool_t;
+
+static rpc_pool_t rpc_pools[RPC_POOL_COUNT] = {
+    { "metadata",   &margo_meta_pool_sz, ABT_POOL_NULL, NULL },
+    { "data",       &margo_data_pool_sz, ABT_POOL_NULL, NULL },
+    { "collective", &margo_coll_pool_sz, ABT_POOL_NULL, NULL },
+    { "io",         &margo_io_pool_sz,   ABT_POOL_NULL, NULL },
+};
+
+/* get the pool for handing off i/o on backing files, or ABT_POOL_NULL
+ * if it has no threads */
+ABT_pool margo_server_io_pool(void)
+{
+    return rpc_pools[RPC_POOL_IO].pool;
+}
+
+/* register an rpc whose handler runs in the pool of the given class */
+#define MARGO_REGISTER_CLASS(mid, name, in, out, fn, cls) \
+    MARGO_REGISTER_PROVIDER(mid, name, in, out, fn, \
+                            MARGO_DEFAULT_PROVIDER_ID, rpc_pools[cls].pool)
+
+/* stop the first n_threads handler threads of a class pool, newest
+ * first. The pool is freed along with its last thread, or here if it
+ * never got one. */
+static void rpc_pool_free(rpc_pool_t* rp, int n_threads)
+{
+    if (NULL != rp->xstreams) {
+        for (int i = n_threads - 1; i >= 0; i--) {
+            if (ABT_XSTREAM_NULL != rp->xstreams[i]) {
+                ABT_xstream_join(rp->xstreams[i]);
+                ABT_xstream_free(&(rp->xstreams[i]));
+            }
+        }
+        free(rp->xstreams);
+        rp->xstreams = NULL;
+    }
+    if ((n_threads <= 0) && (ABT_POOL_NULL != rp->pool)) {
+        ABT_pool_free(&(rp->pool));
+    }
+    rp->pool = ABT_POOL_NULL;
+}
+
+/* create the handler threads of each rpc class pool, on failure the
+ * pools and threads already created are freed in reverse order */
+static int rpc_pools_init(void)
+{
+    int ret = UNIFYFS_SUCCESS;
+    int c;
+    int i = 0;
+    for (c = 0; c < RPC_POOL_COUNT; c++) {
+        rpc_pool_t* rp = rpc_pools + c;
+        int n_threads = *(rp->size);
+        if (n_threads <= 0) {
+            LOGINFO("%s rpcs use default handler pools", rp->name);
+            continue;
+        }
+
+        i = 0;
+        rp->xstreams = calloc(n_threads, sizeof(ABT_xstream));
+        if (NULL == rp->xstreams) {
+            ret = ENOMEM;
+            goto fail;
+        }
+        int rc = ABT_pool_create_basic(ABT_POOL_FIFO_WAIT,
+                                       ABT_POOL_ACCESS_MPMC,
+                                       ABT_TRUE, &(rp->pool));
+        if (rc != ABT_SUCCESS) {
+            LOGERR("failed to create %s rpc pool", rp->name);
+            rp->pool = ABT_POOL_NULL;
+            ret = UNIFYFS_FAILURE;
+            goto fail;
+        }
+        for (i = 0; i < n_threads; i++) {
+            rc = ABT_xstream_create_basic(ABT_SCHED_BASIC_WAIT, 1,
+                                          &(rp->pool),
+                                          ABT_SCHED_CONFIG_NULL,
+                                          &(rp->xstreams[i]));
+            if (rc != ABT_SUCCESS) {
+                LOGERR("failed to create %s rpc handler thread %d",
+                       rp->name, i);
+                rp->xstreams[i] = ABT_XSTREAM_NULL;
+                ret = UNIFYFS_FAILURE;
+                goto fail;
+            }
+        }
+        LOGINFO("%s rpcs use %d handler threads", rp->name, n_threads);
+    }
+    return UNIFYFS_SUCCESS;
+
+fail:
+    /* class c has i threads, the classes before it are complete */
+    rpc_pool_free(rpc_pools + c, i);
+    while (--c >= 0) {
+        rpc_pool_free(rpc_pools + c, *(rpc_pools[c].size));
+    }
+    return ret;
+}
+
+/* stop the handler threads of each rpc class pool in reverse order of
+ * creation, the pools are freed along with the threads */
+static void rpc_pools_fini(void)
+{
+    for (int c = RPC_POOL_COUNT - 1; c >= 0; c--) {
+        rpc_pool_free(rpc_pools + c, *(rpc_pools[c].size));
+    }
+}
+
 #if defined(NA_HAS_SM)
 static const char* PROTOCOL_MARGO_SHM = "na+sm";
 #else
@@ -130,79 +261,125 @@ static margo_instance_id setup_remote_target(void)
 static void register_server_server_rpcs(margo_instance_id mid)
 {
     unifyfsd_rpc_context->rpcs.server_pid_id =
-        MARGO_REGISTER(mid, "server_pid_rpc",
-                       server_pid_in_t, server_pid_out_t,
-                       server_pid_rpc);
+        MARGO_REGISTER_CLASS(mid, "server_pid_rpc",
+                             server_pid_in_t, server_pid_out_t,
+                             server_pid_rpc,
+                             RPC_POOL_META);
+
+    unifyfsd_rpc_context->rpcs.server_stats_id =
+        MARGO_REGISTER_CLASS(mid, "server_stats_rpc",
+                             server_stats_in_t, server_stats_out_t,
+                             server_stats_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.chunk_read_request_id =
-        MARGO_REGISTER(mid, "chunk_read_request_rpc",
-                       chunk_read_request_in_t, chunk_read_request_out_t,
-                       chunk_read_request_rpc);
+        MARGO_REGISTER_CLASS(mid, "chunk_read_request_rpc",
+                             chunk_read_request_in_t, chunk_read_request_out_t,
+                             chunk_read_request_rpc,
+                             RPC_POOL_DATA);
 
     unifyfsd_rpc_context->rpcs.chunk_read_response_id =
-        MARGO_REGISTER(mid, "chunk_read_response_rpc",
-                       chunk_read_response_in_t, chunk_read_response_out_t,
-                       chunk_read_response_rpc);
+        MARGO_REGISTER_CLASS(mid, "chunk_read_response_rpc",
+                             chunk_read_response_in_t,
+                             chunk_read_response_out_t,
+                             chunk_read_response_rpc,
+                             RPC_POOL_DATA);
 
     unifyfsd_rpc_context->rpcs.extent_add_id =
-        MARGO_REGISTER(mid, "add_extents_rpc",
-                       add_extents_in_t, add_extents_out_t,
-                       add_extents_rpc);
+        MARGO_REGISTER_CLASS(mid, "add_extents_rpc",
+                             add_extents_in_t, add_extents_out_t,
+                             add_extents_rpc,
+                             RPC_POOL_META);
+
+    unifyfsd_rpc_context->rpcs.extent_relocate_id =
+        MARGO_REGISTER_CLASS(mid, "relocate_extents_rpc",
+                             add_extents_in_t, add_extents_out_t,
+                             relocate_extents_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.extent_bcast_id =
-        MARGO_REGISTER(mid, "extent_bcast_rpc",
-                       extent_bcast_in_t, extent_bcast_out_t,
-                       extent_bcast_rpc);
+        MARGO_REGISTER_CLASS(mid, "extent_bcast_rpc",
+                             extent_bcast_in_t, extent_bcast_out_t,
+                             extent_bcast_rpc,
+                             RPC_POOL_COLL);
 
     unifyfsd_rpc_context->rpcs.extent_lookup_id =
-        MARGO_REGISTER(mid, "find_extents_rpc",
-                       find_extents_in_t, find_extents_out_t,
-                       find_extents_rpc);
+        MARGO_REGISTER_CLASS(mid, "find_extents_rpc",
+                             find_extents_in_t, find_extents_out_t,
+                             find_extents_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.fileattr_bcast_id =
-        MARGO_REGISTER(mid, "fileattr_bcast_rpc",
-                       fileattr_bcast_in_t, fileattr_bcast_out_t,
-                       fileattr_bcast_rpc);
+        MARGO_REGISTER_CLASS(mid, "fileattr_bcast_rpc",
+                             fileattr_bcast_in_t, fileattr_bcast_out_t,
+                             fileattr_bcast_rpc,
+                             RPC_POOL_COLL);
 
     unifyfsd_rpc_context->rpcs.filesize_id =
-        MARGO_REGISTER(mid, "filesize_rpc",
-                       filesize_in_t, filesize_out_t,
-                       filesize_rpc);
+        MARGO_REGISTER_CLASS(mid, "filesize_rpc",
+                             filesize_in_t, filesize_out_t,
+                             filesize_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.laminate_id =
-        MARGO_REGISTER(mid, "laminate_rpc",
-                       laminate_in_t, laminate_out_t,
-                       laminate_rpc);
+        MARGO_REGISTER_CLASS(mid, "laminate_rpc",
+                             laminate_in_t, laminate_out_t,
+                             laminate_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.laminate_bcast_id =
-        MARGO_REGISTER(mid, "laminate_bcast_rpc",
-                       laminate_bcast_in_t, laminate_bcast_out_t,
-                       laminate_bcast_rpc);
+        MARGO_REGISTER_CLASS(mid, "laminate_bcast_rpc",
+                             laminate_bcast_in_t, laminate_bcast_out_t,
+                             laminate_bcast_rpc,
+                             RPC_POOL_COLL);
 
     unifyfsd_rpc_context->rpcs.metaget_id =
-        MARGO_REGISTER(mid, "metaget_rpc",
-                       metaget_in_t, metaget_out_t,
-                       metaget_rpc);
+        MARGO_REGISTER_CLASS(mid, "metaget_rpc",
+                             metaget_in_t, metaget_out_t,
+                             metaget_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.metaset_id =
-        MARGO_REGISTER(mid, "metaset_rpc",
-                       metaset_in_t, metaset_out_t,
-                       metaset_rpc);
+        MARGO_REGISTER_CLASS(mid, "metaset_rpc",
+                             metaset_in_t, metaset_out_t,
+                             metaset_rpc,
+                             RPC_POOL_META);
+
+    unifyfsd_rpc_context->rpcs.readthrough_fetch_id =
+        MARGO_REGISTER_CLASS(mid, "readthrough_fetch_rpc",
+                             readthrough_fetch_in_t, readthrough_fetch_out_t,
+                             readthrough_fetch_rpc,
+                             RPC_POOL_IO);
+
+    unifyfsd_rpc_context->rpcs.readthrough_bcast_id =
+        MARGO_REGISTER_CLASS(mid, "readthrough_bcast_rpc",
+                             readthrough_bcast_in_t, readthrough_bcast_out_t,
+                             readthrough_bcast_rpc,
+                             RPC_POOL_COLL);
+
+    unifyfsd_rpc_context->rpcs.transfer_bcast_id =
+        MARGO_REGISTER_CLASS(mid, "transfer_bcast_rpc",
+                             transfer_bcast_in_t, transfer_bcast_out_t,
+                             transfer_bcast_rpc,
+                             RPC_POOL_COLL);
 
     unifyfsd_rpc_context->rpcs.truncate_id =
-        MARGO_REGISTER(mid, "truncate_rpc",
-                       truncate_in_t, truncate_out_t,
-                       truncate_rpc);
+        MARGO_REGISTER_CLASS(mid, "truncate_rpc",
+                             truncate_in_t, truncate_out_t,
+                             truncate_rpc,
+                             RPC_POOL_META);
 
     unifyfsd_rpc_context->rpcs.truncate_bcast_id =
-        MARGO_REGISTER(mid, "truncate_bcast_rpc",
-                       truncate_bcast_in_t, truncate_bcast_out_t,
-                       truncate_bcast_rpc);
+        MARGO_REGISTER_CLASS(mid, "truncate_bcast_rpc",
+                             truncate_bcast_in_t, truncate_bcast_out_t,
+                             truncate_bcast_rpc,
+                             RPC_POOL_COLL);
 
     unifyfsd_rpc_context->rpcs.unlink_bcast_id =
-        MARGO_REGISTER(mid, "unlink_bcast_rpc",
-                       unlink_bcast_in_t, unlink_bcast_out_t,
-                       unlink_bcast_rpc);
+        MARGO_REGISTER_CLASS(mid, "unlink_bcast_rpc",
+                             unlink_bcast_in_t, unlink_bcast_out_t,
+                             unlink_bcast_rpc,
+                             RPC_POOL_COLL);
 }
 
 /* setup_local_target - Initializes the client-server margo target */
@@ -252,49 +429,85 @@ static margo_instance_id setup_local_target(void)
 static void register_client_server_rpcs(margo_instance_id mid)
 {
     /* register the RPC handler functions */
-    MARGO_REGISTER(mid, "unifyfs_attach_rpc",
-                   unifyfs_attach_in_t, unifyfs_attach_out_t,
-                   unifyfs_attach_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_mount_rpc",
-                   unifyfs_mount_in_t, unifyfs_mount_out_t,
-                   unifyfs_mount_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_unmount_rpc",
-                   unifyfs_unmount_in_t, unifyfs_unmount_out_t,
-                   unifyfs_unmount_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_metaget_rpc",
-                   unifyfs_metaget_in_t, unifyfs_metaget_out_t,
-                   unifyfs_metaget_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_metaset_rpc",
-                   unifyfs_metaset_in_t, unifyfs_metaset_out_t,
-                   unifyfs_metaset_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_fsync_rpc",
-                   unifyfs_fsync_in_t, unifyfs_fsync_out_t,
-                   unifyfs_fsync_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_filesize_rpc",
-                   unifyfs_filesize_in_t, unifyfs_filesize_out_t,
-                   unifyfs_filesize_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_truncate_rpc",
-                   unifyfs_truncate_in_t, unifyfs_truncate_out_t,
-                   unifyfs_truncate_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_unlink_rpc",
-                   unifyfs_unlink_in_t, unifyfs_unlink_out_t,
-                   unifyfs_unlink_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_laminate_rpc",
-                   unifyfs_laminate_in_t, unifyfs_laminate_out_t,
-                   unifyfs_laminate_rpc);
-
-    MARGO_REGISTER(mid, "unifyfs_mread_rpc",
-                   unifyfs_mread_in_t, unifyfs_mread_out_t,
-                   unifyfs_mread_rpc);
+    MARGO_REGISTER_CLASS(mid, "unifyfs_attach_rpc",
+                         unifyfs_attach_in_t, unifyfs_attach_out_t,
+                         unifyfs_attach_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_mount_rpc",
+                         unifyfs_mount_in_t, unifyfs_mount_out_t,
+                         unifyfs_mount_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_unmount_rpc",
+                         unifyfs_unmount_in_t, unifyfs_unmount_out_t,
+                         unifyfs_unmount_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_metaget_rpc",
+                         unifyfs_metaget_in_t, unifyfs_metaget_out_t,
+                         unifyfs_metaget_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_metaset_rpc",
+                         unifyfs_metaset_in_t, unifyfs_metaset_out_t,
+                         unifyfs_metaset_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_fsync_rpc",
+                         unifyfs_fsync_in_t, unifyfs_fsync_out_t,
+                         unifyfs_fsync_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_filesize_rpc",
+                         unifyfs_filesize_in_t, unifyfs_filesize_out_t,
+                         unifyfs_filesize_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_truncate_rpc",
+                         unifyfs_truncate_in_t, unifyfs_truncate_out_t,
+                         unifyfs_truncate_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_unlink_rpc",
+                         unifyfs_unlink_in_t, unifyfs_unlink_out_t,
+                         unifyfs_unlink_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_laminate_rpc",
+                         unifyfs_laminate_in_t, unifyfs_laminate_out_t,
+                         unifyfs_laminate_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_transfer_rpc",
+                         unifyfs_transfer_in_t, unifyfs_transfer_out_t,
+                         unifyfs_transfer_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_readthrough_rpc",
+                         unifyfs_readthrough_in_t, unifyfs_readthrough_out_t,
+                         unifyfs_readthrough_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_reclaim_rpc",
+                         unifyfs_reclaim_in_t, unifyfs_reclaim_out_t,
+                         unifyfs_reclaim_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_compact_rpc",
+                         unifyfs_compact_in_t, unifyfs_compact_out_t,
+                         unifyfs_compact_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_stats_rpc",
+                         unifyfs_stats_in_t, unifyfs_stats_out_t,
+                         unifyfs_stats_rpc,
+                         RPC_POOL_META);
+
+    MARGO_REGISTER_CLASS(mid, "unifyfs_mread_rpc",
+                         unifyfs_mread_in_t, unifyfs_mread_out_t,
+                         unifyfs_mread_rpc,
+                         RPC_POOL_DATA);
 
     /* register the RPCs we call (and capture assigned hg_id_t) */
     unifyfsd_rpc_context->rpcs.client_mread_data_id =
@@ -355,6 +568,11 @@ int margo_server_rpc_init(void)
     }
 #endif
 
+    rc = rpc_pools_init();
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
     margo_instance_id mid;
     mid = setup_local_target();
     if (mid == MARGO_INSTANCE_NULL) {
@@ -409,6 +627,9 @@ int margo_server_rpc_finalize(void)
         /* NOTE: 2nd call to margo_finalize() sometimes crashes - Margo bug? */
         margo_finalize(ctx->shm_mid);
 
+        /* stop rpc handler threads */
+        rpc_pools_fini();
+
         /* free memory allocated for context structure */
         free(ctx);
     }
@@ -416,10 +637,26 @@ int margo_server_rpc_finalize(void)
     return rc;
 }
 
+/* free a table of keyval strings returned by a gather */
+static void free_keyval_table(int count, char** vals)
+{
+    if (NULL != vals) {
+        for (int i = 0; i < count; i++) {
+            free(vals[i]);
+        }
+        free(vals);
+    }
+}
+
 /* margo_connect_servers
  *
- * Using address strings found in glb_servers, resolve
- * each peer server's margo address.
+ * Gather the pmi rank and margo address strings published by all
+ * servers, and resolve each peer server's margo address.
+ *
+ * The values of all servers are collected by one collective gather per
+ * key, rather than a fence followed by a remote lookup for each server
+ * and key, so the number of kvstore operations per server does not grow
+ * with the number of servers.
  */
 int margo_connect_servers(void)
 {
@@ -427,39 +664,51 @@ int margo_connect_servers(void)
     int ret = (int)UNIFYFS_SUCCESS;
     size_t i;
     hg_return_t hret;
+    int n_ranks = 0;
+    int n_addrs = 0;
+    char** pmi_rank_strs = NULL;
+    char** margo_addr_strs = NULL;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
-    // block until a margo_svr key pair published by all servers
-    rc = unifyfs_keyval_fence_remote();
+    // blocks until all servers have published their keys
+    rc = unifyfs_keyval_gather_remote(key_unifyfsd_pmi_rank,
+                                      &n_ranks, &pmi_rank_strs);
     if ((int)UNIFYFS_SUCCESS != rc) {
-        LOGERR("keyval fence on margo_svr key failed");
-        ret = (int)UNIFYFS_FAILURE;
-        return ret;
+        LOGERR("keyval gather of pmi ranks failed");
+        return (int)UNIFYFS_FAILURE;
     }
+    rc = unifyfs_keyval_gather_remote(key_unifyfsd_margo_svr,
+                                      &n_addrs, &margo_addr_strs);
+    if ((int)UNIFYFS_SUCCESS != rc) {
+        LOGERR("keyval gather of margo server addresses failed");
+        free_keyval_table(n_ranks, pmi_rank_strs);
+        return (int)UNIFYFS_FAILURE;
+    }
+    if (((size_t)n_ranks < glb_num_servers) ||
+        ((size_t)n_addrs < glb_num_servers)) {
+        LOGERR("gathered %d pmi ranks and %d margo addresses for %zu servers",
+               n_ranks, n_addrs, glb_num_servers);
+        free_keyval_table(n_ranks, pmi_rank_strs);
+        free_keyval_table(n_addrs, margo_addr_strs);
+        return (int)UNIFYFS_FAILURE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    LOGINFO("gathered addresses of %zu servers in %.3f seconds",
+            glb_num_servers,
+            (double)(end.tv_sec - start.tv_sec) +
+            ((double)(end.tv_nsec - start.tv_nsec) / 1.0e9));
 
     for (i = 0; i < glb_num_servers; i++) {
-        int remote_pmi_rank = -1;
-        char* pmi_rank_str = NULL;
-        char* margo_addr_str = NULL;
-
-        rc = unifyfs_keyval_lookup_remote(i, key_unifyfsd_pmi_rank,
-                                          &pmi_rank_str);
-        if ((int)UNIFYFS_SUCCESS != rc) {
-            LOGERR("server index=%zu - pmi rank lookup failed", i);
-            ret = (int)UNIFYFS_FAILURE;
-            return ret;
-        }
-        if (NULL != pmi_rank_str) {
-            remote_pmi_rank = atoi(pmi_rank_str);
-            free(pmi_rank_str);
-        }
-        glb_servers[i].pmi_rank = remote_pmi_rank;
+        int remote_pmi_rank = atoi(pmi_rank_strs[i]);
+        char* margo_addr_str = margo_addr_strs[i];
 
-        margo_addr_str = rpc_lookup_remote_server_addr(i);
-        if (NULL == margo_addr_str) {
-            LOGERR("server index=%zu - margo server lookup failed", i);
-            ret = (int)UNIFYFS_FAILURE;
-            return ret;
-        }
+        /* the server table takes ownership of the address string */
+        margo_addr_strs[i] = NULL;
+
+        glb_servers[i].pmi_rank = remote_pmi_rank;
         glb_servers[i].margo_svr_addr = HG_ADDR_NULL;
         glb_servers[i].margo_svr_addr_str = margo_addr_str;
         LOGDBG("server index=%zu, pmi_rank=%d, margo_addr=%s",
@@ -476,6 +725,9 @@ int margo_connect_servers(void)
         }
     }
 
+    free_keyval_table(n_ranks, pmi_rank_strs);
+    free_keyval_table(n_addrs, margo_addr_strs);
+
     return ret;
 }
 
@@ -36,13 +36,18 @@ typedef struct ServerRpcIds {
     hg_id_t extent_add_id;
     hg_id_t extent_bcast_id;
     hg_id_t extent_lookup_id;
+    hg_id_t extent_relocate_id;
     hg_id_t filesize_id;
     hg_id_t laminate_id;
     hg_id_t laminate_bcast_id;
     hg_id_t metaget_id;
     hg_id_t metaset_id;
     hg_id_t fileattr_bcast_id;
+    hg_id_t readthrough_bcast_id;
+    hg_id_t readthrough_fetch_id;
     hg_id_t server_pid_id;
+    hg_id_t server_stats_id;
+    hg_id_t transfer_bcast_id;
     hg_id_t truncate_id;
     hg_id_t truncate_bcast_id;
     hg_id_t unlink_bcast_id;
@@ -63,6 +68,20 @@ extern ServerRpcContext_t* unifyfsd_rpc_context;
 extern bool margo_use_tcp;
 extern bool margo_lazy_connect;
 
+/* rpc handler thread counts of the default pools of the client-server
+ * and server-server margo instances, and of the metadata, data,
+ * collective, and backing file i/o pools */
+extern int margo_client_server_pool_sz;
+extern int margo_server_server_pool_sz;
+extern int margo_meta_pool_sz;
+extern int margo_data_pool_sz;
+extern int margo_coll_pool_sz;
+extern int margo_io_pool_sz;
+
+/* get the pool for handing off i/o on backing files, or ABT_POOL_NULL
+ * if it has no threads */
+ABT_pool margo_server_io_pool(void);
+
 int margo_server_rpc_init(void);
 int margo_server_rpc_finalize(void);
 
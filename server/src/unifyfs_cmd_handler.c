@@ -35,6 +35,8 @@
 #include "unifyfs_global.h"
 #include "unifyfs_metadata_mdhim.h"
 #include "unifyfs_request_manager.h"
+#include "unifyfs_p2p_rpc.h"
+#include "unifyfs_reclaim.h"
 
 // margo rpcs
 #include "margo_server.h"
@@ -402,6 +404,8 @@ static void unifyfs_fsync_rpc(hg_handle_t handle)
         /* return to caller */
         unifyfs_fsync_out_t out;
         out.ret = (int32_t) ret;
+        out.reclaimable = 0;
+        out.compactable = 0;
         hret = margo_respond(handle, &out);
         if (hret != HG_SUCCESS) {
             LOGERR("margo_respond() failed");
@@ -413,6 +417,72 @@ static void unifyfs_fsync_rpc(hg_handle_t handle)
 }
 DEFINE_MARGO_RPC_HANDLER(unifyfs_fsync_rpc)
 
+/* given a client and a range of its log reserved for compaction,
+ * move live data of sparsely used log chunks into the range */
+static void unifyfs_compact_rpc(hg_handle_t handle)
+{
+    int ret = UNIFYFS_SUCCESS;
+    hg_return_t hret;
+
+    /* get input params */
+    unifyfs_compact_in_t* in = malloc(sizeof(*in));
+    if (NULL == in) {
+        ret = ENOMEM;
+    } else {
+        hret = margo_get_input(handle, in);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_get_input() failed");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            client_rpc_req_t* req = malloc(sizeof(client_rpc_req_t));
+            if (NULL == req) {
+                ret = ENOMEM;
+            } else {
+                /* compaction is processed in order with the client's
+                 * syncs, so none of its extents are in flight */
+                unifyfs_fops_ctx_t ctx = {
+                    .app_id = in->app_id,
+                    .client_id = in->client_id,
+                };
+                req->req_type = UNIFYFS_CLIENT_RPC_COMPACT;
+                req->handle = handle;
+                req->input = (void*) in;
+                req->bulk_buf = NULL;
+                req->bulk_sz = 0;
+                ret = rm_submit_client_rpc_request(&ctx, req);
+            }
+
+            if (ret != UNIFYFS_SUCCESS) {
+                if (NULL != req) {
+                    free(req);
+                }
+                margo_free_input(handle, in);
+            }
+        }
+    }
+
+    /* if we hit an error during request submission, respond with the error */
+    if (ret != UNIFYFS_SUCCESS) {
+        if (NULL != in) {
+            free(in);
+        }
+
+        /* return to caller */
+        unifyfs_compact_out_t out;
+        out.ret = (int32_t) ret;
+        out.used = 0;
+        out.moved = 0;
+        hret = margo_respond(handle, &out);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_respond() failed");
+        }
+
+        /* free margo resources */
+        margo_destroy(handle);
+    }
+}
+DEFINE_MARGO_RPC_HANDLER(unifyfs_compact_rpc)
+
 /* given an app_id, client_id, global file id,
  * return current file size */
 static void unifyfs_filesize_rpc(hg_handle_t handle)
@@ -664,6 +734,255 @@ static void unifyfs_laminate_rpc(hg_handle_t handle)
 }
 DEFINE_MARGO_RPC_HANDLER(unifyfs_laminate_rpc)
 
+/* given an app_id, client_id, global file id, and destination path,
+ * stage out the laminated file from all servers */
+static void unifyfs_transfer_rpc(hg_handle_t handle)
+{
+    int ret = UNIFYFS_SUCCESS;
+    hg_return_t hret;
+
+    /* get input params */
+    unifyfs_transfer_in_t* in = malloc(sizeof(*in));
+    if (NULL == in) {
+        ret = ENOMEM;
+    } else {
+        hret = margo_get_input(handle, in);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_get_input() failed");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            client_rpc_req_t* req = malloc(sizeof(client_rpc_req_t));
+            if (NULL == req) {
+                ret = ENOMEM;
+            } else {
+                unifyfs_fops_ctx_t ctx = {
+                    .app_id = in->app_id,
+                    .client_id = in->client_id,
+                };
+                req->req_type = UNIFYFS_CLIENT_RPC_TRANSFER;
+                req->handle = handle;
+                req->input = (void*) in;
+                req->bulk_buf = NULL;
+                req->bulk_sz = 0;
+                ret = rm_submit_client_rpc_request(&ctx, req);
+            }
+
+            if (ret != UNIFYFS_SUCCESS) {
+                if (NULL != req) {
+                    free(req);
+                }
+                margo_free_input(handle, in);
+            }
+        }
+    }
+
+    /* if we hit an error during request submission, respond with the error */
+    if (ret != UNIFYFS_SUCCESS) {
+        if (NULL != in) {
+            free(in);
+        }
+
+        /* return to caller */
+        unifyfs_transfer_out_t out;
+        out.ret = (int32_t) ret;
+        hret = margo_respond(handle, &out);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_respond() failed");
+        }
+
+        /* free margo resources */
+        margo_destroy(handle);
+    }
+
+}
+DEFINE_MARGO_RPC_HANDLER(unifyfs_transfer_rpc)
+
+/* given an app_id, client_id, file attributes, and backing file path,
+ * register a read-through file on all servers */
+static void unifyfs_readthrough_rpc(hg_handle_t handle)
+{
+    int ret = UNIFYFS_SUCCESS;
+    hg_return_t hret;
+
+    /* get input params */
+    unifyfs_readthrough_in_t* in = malloc(sizeof(*in));
+    if (NULL == in) {
+        ret = ENOMEM;
+    } else {
+        hret = margo_get_input(handle, in);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_get_input() failed");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            client_rpc_req_t* req = malloc(sizeof(client_rpc_req_t));
+            if (NULL == req) {
+                ret = ENOMEM;
+            } else {
+                unifyfs_fops_ctx_t ctx = {
+                    .app_id = in->app_id,
+                    .client_id = in->client_id,
+                };
+                req->req_type = UNIFYFS_CLIENT_RPC_READTHROUGH;
+                req->handle = handle;
+                req->input = (void*) in;
+                req->bulk_buf = NULL;
+                req->bulk_sz = 0;
+                ret = rm_submit_client_rpc_request(&ctx, req);
+            }
+
+            if (ret != UNIFYFS_SUCCESS) {
+                if (NULL != req) {
+                    free(req);
+                }
+                margo_free_input(handle, in);
+            }
+        }
+    }
+
+    /* if we hit an error during request submission, respond with the error */
+    if (ret != UNIFYFS_SUCCESS) {
+        if (NULL != in) {
+            free(in);
+        }
+
+        /* return to caller */
+        unifyfs_readthrough_out_t out;
+        out.ret = (int32_t) ret;
+        hret = margo_respond(handle, &out);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_respond() failed");
+        }
+
+        /* free margo resources */
+        margo_destroy(handle);
+    }
+
+}
+DEFINE_MARGO_RPC_HANDLER(unifyfs_readthrough_rpc)
+
+/* returns server statistics as JSON, from this server only or from
+ * all servers */
+static void unifyfs_stats_rpc(hg_handle_t handle)
+{
+    int ret = UNIFYFS_SUCCESS;
+    char* json = NULL;
+
+    /* get input params */
+    unifyfs_stats_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        ret = unifyfs_invoke_server_stats_rpc((int)in.all, &json);
+        margo_free_input(handle, &in);
+    }
+
+    /* build output structure to return to caller */
+    unifyfs_stats_out_t out;
+    out.ret = ret;
+    out.json = (NULL != json) ? json : "";
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    margo_destroy(handle);
+    if (NULL != json) {
+        free(json);
+    }
+}
+DEFINE_MARGO_RPC_HANDLER(unifyfs_stats_rpc)
+
+/* given a client identified by (app_id, client_id), push the indices of
+ * its log chunks that are ready to be released to the client bulk buffer */
+static void unifyfs_reclaim_rpc(hg_handle_t handle)
+{
+    int ret = UNIFYFS_SUCCESS;
+    size_t n_chunks = 0;
+    size_t reclaimable = 0;
+
+    /* get input params */
+    unifyfs_reclaim_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        app_client* client = get_app_client(in.app_id, in.client_id);
+        size_t max_chunks = (size_t)in.bulk_size / sizeof(uint64_t);
+        uint64_t* chunks = NULL;
+        if (NULL == client) {
+            ret = EINVAL;
+        } else if (max_chunks > 0) {
+            chunks = calloc(max_chunks, sizeof(uint64_t));
+            if (NULL == chunks) {
+                ret = ENOMEM;
+            } else {
+                ret = unifyfs_reclaim_release(client, chunks, max_chunks,
+                                              &n_chunks);
+            }
+        }
+
+        if ((ret == UNIFYFS_SUCCESS) && (n_chunks > 0)) {
+            /* get mercury info to set up bulk transfer */
+            const struct hg_info* hgi = margo_get_info(handle);
+            assert(hgi);
+            margo_instance_id mid = margo_hg_info_get_instance(hgi);
+            assert(mid != MARGO_INSTANCE_NULL);
+
+            /* register local source buffer for bulk access */
+            void* buf = (void*) chunks;
+            hg_size_t size = (hg_size_t)(n_chunks * sizeof(uint64_t));
+            hg_bulk_t bulk_handle;
+            hret = margo_bulk_create(mid, 1, &buf, &size,
+                                     HG_BULK_READ_ONLY, &bulk_handle);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                /* push chunk list to client */
+                hret = margo_bulk_transfer(mid, HG_BULK_PUSH, hgi->addr,
+                                           in.bulk_chunks, 0,
+                                           bulk_handle, 0, size);
+                if (hret != HG_SUCCESS) {
+                    LOGERR("margo_bulk_transfer() failed");
+                    ret = UNIFYFS_ERROR_MARGO;
+                }
+                margo_bulk_free(bulk_handle);
+            }
+            if (ret != UNIFYFS_SUCCESS) {
+                /* the released chunks stay reserved in the client log */
+                LOGERR("failed to release %zu log chunks to client %d:%d",
+                       n_chunks, (int)in.app_id, (int)in.client_id);
+                n_chunks = 0;
+            }
+        }
+
+        unifyfs_reclaim_get_counts(client, &reclaimable, NULL);
+        free(chunks);
+        margo_free_input(handle, &in);
+    }
+
+    /* build output structure to return to caller */
+    unifyfs_reclaim_out_t out;
+    out.ret = (int32_t) ret;
+    out.num_chunks = (hg_size_t) n_chunks;
+    out.reclaimable = (hg_size_t) reclaimable;
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    margo_destroy(handle);
+}
+DEFINE_MARGO_RPC_HANDLER(unifyfs_reclaim_rpc)
 
 /* given (mread_id, app_id, client_id) and count of read requests,
  * followed by a bulk data array of read extents (unifyfs_extent_t),
@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <time.h>
+
+#include "unifyfs_compact.h"
+#include "unifyfs_inode.h"
+#include "unifyfs_p2p_rpc.h"
+#include "unifyfs_reclaim.h"
+
+/* percent of a chunk below which its live data is compacted, 0 disables */
+static long compact_threshold = UNIFYFS_LOGIO_COMPACT_THRESHOLD;
+
+/* an extent whose data is moved */
+typedef struct {
+    int gfid;
+    struct extent_tree_node extent;
+    unsigned long new_pos;
+} compact_extent;
+
+/* state of the search for extents to move */
+typedef struct {
+    app_client* client;
+    uint8_t* sparse;          /* per-chunk sparse flags */
+    size_t n_chunks;          /* number of chunks in log */
+    size_t chunk_sz;          /* size of a log chunk */
+    size_t capacity;          /* bytes of reserved space */
+    size_t total;             /* bytes of extents found */
+    size_t n_extents;         /* number of extents found */
+    size_t max_extents;       /* capacity of extents array */
+    compact_extent* extents;  /* extents found */
+} compact_search;
+
+/* get current time in usecs */
+static inline uint64_t compact_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+/* returns 1 if all chunks holding the log data are sparse */
+static int is_sparse_data(compact_search* cs,
+                          unsigned long pos,
+                          unsigned long length)
+{
+    logio_context* logio = cs->client->logio;
+    off_t log_off = (off_t) pos;
+    off_t last = (off_t)(pos + length - 1);
+    while (log_off <= last) {
+        size_t ndx;
+        off_t chunk_off;
+        int rc = unifyfs_logio_get_chunk(logio, log_off, &ndx, &chunk_off);
+        if ((rc != UNIFYFS_SUCCESS) || (ndx >= cs->n_chunks) ||
+            !cs->sparse[ndx]) {
+            return 0;
+        }
+        log_off = chunk_off + (off_t) cs->chunk_sz;
+    }
+    return 1;
+}
+
+/* inode extent callback to collect extents of the client with data
+ * in sparse chunks, stops once the reserved space is full */
+static int find_sparse_extent(int gfid,
+                              struct extent_tree_node* node,
+                              void* arg)
+{
+    compact_search* cs = (compact_search*) arg;
+    app_client* client = cs->client;
+
+    if ((node->svr_rank != glb_pmi_rank) ||
+        (node->app_id != client->app_id) ||
+        (node->cli_id != client->client_id)) {
+        return 0;
+    }
+
+    size_t length = (size_t)(node->end - node->start) + 1;
+    if (((cs->total + length) > cs->capacity) ||
+        !is_sparse_data(cs, node->pos, length)) {
+        return 0;
+    }
+
+    if (cs->n_extents == cs->max_extents) {
+        size_t max = (cs->max_extents) ? (2 * cs->max_extents) : 64;
+        compact_extent* extents = realloc(cs->extents,
+                                          max * sizeof(compact_extent));
+        if (NULL == extents) {
+            /* move the extents found so far */
+            return 1;
+        }
+        cs->extents = extents;
+        cs->max_extents = max;
+    }
+
+    compact_extent* ce = cs->extents + cs->n_extents;
+    ce->gfid = gfid;
+    ce->extent = *node;
+    ce->new_pos = 0;
+    cs->n_extents++;
+    cs->total += length;
+
+    return (cs->total == cs->capacity);
+}
+
+/* sort extents by file */
+static int compare_compact_extents(const void* a, const void* b)
+{
+    const compact_extent* ea = a;
+    const compact_extent* eb = b;
+    if (ea->gfid != eb->gfid) {
+        return (ea->gfid < eb->gfid) ? -1 : 1;
+    }
+    if (ea->extent.start != eb->extent.start) {
+        return (ea->extent.start < eb->extent.start) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* copy length bytes of log data at src to dst, using buffer buf of
+ * size buf_sz */
+static int copy_log_data(logio_context* logio,
+                         off_t src,
+                         off_t dst,
+                         size_t length,
+                         char* buf,
+                         size_t buf_sz)
+{
+    while (length > 0) {
+        size_t n = (length < buf_sz) ? length : buf_sz;
+        size_t nread = 0;
+        size_t nwrite = 0;
+        int rc = unifyfs_logio_read(logio, src, n, buf, &nread);
+        if ((rc == UNIFYFS_SUCCESS) && (nread != n)) {
+            rc = EIO;
+        }
+        if (rc == UNIFYFS_SUCCESS) {
+            rc = unifyfs_logio_write(logio, dst, n, buf, &nwrite);
+            if ((rc == UNIFYFS_SUCCESS) && (nwrite != n)) {
+                rc = EIO;
+            }
+        }
+        if (rc != UNIFYFS_SUCCESS) {
+            return rc;
+        }
+        src += (off_t) n;
+        dst += (off_t) n;
+        length -= n;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* point the extents of a file to their new copies, synced at log release
+ * epoch, at the owner and then locally, returns the bytes of data moved */
+static size_t relocate_file_extents(compact_extent* ces, size_t count,
+                                    uint64_t epoch)
+{
+    int gfid = ces[0].gfid;
+    struct extent_tree_node* old_nodes = calloc(count, sizeof(*old_nodes));
+    struct extent_tree_node* new_nodes = calloc(count, sizeof(*new_nodes));
+    if ((NULL == old_nodes) || (NULL == new_nodes)) {
+        LOGERR("failed to allocate extents for compaction");
+        free(old_nodes);
+        free(new_nodes);
+        return 0;
+    }
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        old_nodes[i] = ces[i].extent;
+        new_nodes[i] = ces[i].extent;
+        new_nodes[i].pos = ces[i].new_pos;
+        new_nodes[i].epoch = (unsigned long) epoch;
+        bytes += (size_t)(ces[i].extent.end - ces[i].extent.start) + 1;
+    }
+
+    /* the local inode may only drop its references to the old data, which
+     * lets the old chunks be released, once the owner no longer uses it */
+    int rc = unifyfs_invoke_relocate_extents_rpc(gfid, (unsigned int)count,
+                                                 old_nodes, new_nodes);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = unifyfs_inode_relocate_extents(gfid, (int)count,
+                                            old_nodes, new_nodes);
+        if (rc != UNIFYFS_SUCCESS) {
+            /* point the owner back to the old data, which is still
+             * referenced locally */
+            int undo_rc = unifyfs_invoke_relocate_extents_rpc(gfid,
+                (unsigned int)count, new_nodes, old_nodes);
+            if (undo_rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to restore %zu extents of gfid=%d at owner "
+                       "(rc=%d)", count, gfid, undo_rc);
+            }
+        }
+    }
+    if ((rc != UNIFYFS_SUCCESS) && (rc != ENOENT)) {
+        LOGDBG("failed to relocate %zu extents of gfid=%d (rc=%d)",
+               count, gfid, rc);
+    }
+    if (rc != UNIFYFS_SUCCESS) {
+        bytes = 0;
+    }
+
+    free(old_nodes);
+    free(new_nodes);
+    return bytes;
+}
+
+int unifyfs_compact_init(unifyfs_cfg_t* cfg)
+{
+    long l;
+
+    compact_threshold = UNIFYFS_LOGIO_COMPACT_THRESHOLD;
+    if ((NULL != cfg) && (NULL != cfg->logio_compact_threshold)) {
+        if ((0 == configurator_int_val(cfg->logio_compact_threshold, &l)) &&
+            (l >= 0) && (l <= 100)) {
+            compact_threshold = l;
+        }
+    }
+
+    if (compact_threshold > 0) {
+        LOGINFO("compacting client log chunks with less than %ld%% "
+                "live data", compact_threshold);
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+size_t unifyfs_compact_check(app_client* client)
+{
+    if ((compact_threshold <= 0) || meta_stripe_extents ||
+        (NULL == client) || (NULL == client->logio)) {
+        return 0;
+    }
+
+    size_t n_chunks = 0;
+    size_t chunk_sz = 0;
+    unifyfs_logio_get_chunks(client->logio, &n_chunks, &chunk_sz);
+    if (0 == n_chunks) {
+        return 0;
+    }
+
+    uint8_t* sparse = calloc(n_chunks, sizeof(uint8_t));
+    if (NULL == sparse) {
+        return 0;
+    }
+    size_t n_sparse = 0;
+    size_t live = 0;
+    size_t max_live = (chunk_sz * (size_t)compact_threshold) / 100;
+    int rc = unifyfs_reclaim_get_sparse(client, max_live, sparse,
+                                        &n_sparse, &live);
+    free(sparse);
+    if (rc != UNIFYFS_SUCCESS) {
+        return 0;
+    }
+
+    /* only compact if it frees at least one chunk */
+    size_t need = (live + chunk_sz - 1) / chunk_sz;
+    if (need >= n_sparse) {
+        return 0;
+    }
+    if (need > UNIFYFS_LOGIO_COMPACT_MAX_CHUNKS) {
+        need = UNIFYFS_LOGIO_COMPACT_MAX_CHUNKS;
+    }
+    return need * chunk_sz;
+}
+
+int unifyfs_compact_client(app_client* client,
+                           off_t offset,
+                           size_t length,
+                           size_t* used,
+                           size_t* moved)
+{
+    if ((NULL == client) || (NULL == used) || (NULL == moved)) {
+        return EINVAL;
+    }
+
+    *used = 0;
+    *moved = 0;
+    if ((compact_threshold <= 0) || meta_stripe_extents ||
+        (NULL == client->logio) || (0 == length)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    uint64_t start = compact_now();
+
+    compact_search cs;
+    memset(&cs, 0, sizeof(cs));
+    cs.client = client;
+    cs.capacity = length;
+
+    unifyfs_logio_get_chunks(client->logio, &(cs.n_chunks), &(cs.chunk_sz));
+    size_t chunk_sz = cs.chunk_sz;
+    if (0 == cs.n_chunks) {
+        return UNIFYFS_SUCCESS;
+    }
+    cs.sparse = calloc(cs.n_chunks, sizeof(uint8_t));
+    char* buf = malloc(chunk_sz);
+    if ((NULL == cs.sparse) || (NULL == buf)) {
+        free(cs.sparse);
+        free(buf);
+        return ENOMEM;
+    }
+
+    /* find the extents with data in sparse chunks */
+    size_t n_sparse = 0;
+    size_t live = 0;
+    size_t max_live = (chunk_sz * (size_t)compact_threshold) / 100;
+    int ret = unifyfs_reclaim_get_sparse(client, max_live, cs.sparse,
+                                         &n_sparse, &live);
+    if ((ret == UNIFYFS_SUCCESS) && (n_sparse > 1)) {
+        /* only the files the client synced can hold its data */
+        int* gfids = NULL;
+        size_t n_gfids = 0;
+        ret = unifyfs_reclaim_get_files(client, &gfids, &n_gfids);
+        for (size_t f = 0; (ret == UNIFYFS_SUCCESS) && (f < n_gfids) &&
+                           (cs.total < cs.capacity); f++) {
+            int rc = unifyfs_inode_foreach_extent(gfids[f],
+                                                  find_sparse_extent, &cs);
+            if (rc == ENOENT) {
+                unifyfs_reclaim_remove_file(client, gfids[f]);
+            }
+        }
+        free(gfids);
+    }
+
+    /* copy their data to the reserved space */
+    off_t dst = offset;
+    size_t n_copied = 0;
+    for (size_t i = 0; (ret == UNIFYFS_SUCCESS) && (i < cs.n_extents); i++) {
+        compact_extent* ce = cs.extents + i;
+        size_t len = (size_t)(ce->extent.end - ce->extent.start) + 1;
+        ret = copy_log_data(client->logio, (off_t) ce->extent.pos, dst,
+                            len, buf, chunk_sz);
+        if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("failed to copy %zu bytes of client %d:%d log data",
+                   len, client->app_id, client->client_id);
+            break;
+        }
+        ce->new_pos = (unsigned long) dst;
+        dst += (off_t) len;
+        n_copied++;
+    }
+    *used = (size_t)(dst - offset);
+    if (n_copied > 0) {
+        int rc = unifyfs_logio_sync(client->logio);
+        if (rc != UNIFYFS_SUCCESS) {
+            /* the new copies are not durable, so leave the data in place */
+            ret = rc;
+            n_copied = 0;
+        }
+    }
+
+    /* point the extents to the new copies, one file at a time */
+    qsort(cs.extents, n_copied, sizeof(compact_extent),
+          compare_compact_extents);
+    uint64_t epoch = unifyfs_reclaim_epoch(client);
+    size_t i = 0;
+    while (i < n_copied) {
+        size_t j = i + 1;
+        while ((j < n_copied) && (cs.extents[j].gfid == cs.extents[i].gfid)) {
+            j++;
+        }
+        *moved += relocate_file_extents(cs.extents + i, j - i, epoch);
+        i = j;
+    }
+
+    /* the client keeps the used space, so let chunks of it that hold no
+     * relocated data be released */
+    if (*moved < *used) {
+        unifyfs_reclaim_unreferenced(client, offset, *used);
+    }
+
+    uint64_t elapsed = compact_now() - start;
+    unifyfs_reclaim_add_compacted(client, *moved, elapsed);
+    if (n_copied > 0) {
+        LOGINFO("compacted client %d:%d log - moved %zu of %zu bytes "
+                "from %zu sparse chunks in %" PRIu64 " usecs",
+                client->app_id, client->client_id, *moved, *used,
+                n_sparse, elapsed);
+    }
+
+    free(cs.extents);
+    free(cs.sparse);
+    free(buf);
+    return ret;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_COMPACT_H
+#define UNIFYFS_COMPACT_H
+
+#include "unifyfs_global.h"
+
+/*
+ * Client log compaction.
+ *
+ * A log chunk whose data is only partly overwritten stays in use, so logs
+ * with many partial overwrites fill up with sparsely used chunks, and new
+ * writes spill to the slower spill file. Using the per-chunk reference
+ * counts kept for log space reclamation, the server finds chunks that hold
+ * less than logio.compact_threshold percent of live data. When moving their
+ * data would free at least one chunk, the server asks the client to reserve
+ * space for it in the sync response, since only the client may allocate
+ * chunks in its log. The client then sends a compact rpc with the reserved
+ * range, and the server copies the live extents of the sparse chunks into
+ * it and points the extents at the file owner and in its local inodes to
+ * the new copies. Extents are only moved where they still refer to the
+ * old copy, so data synced meanwhile is not replaced. The old chunks are
+ * then no longer referenced and are released by log space reclamation.
+ */
+
+/* read compaction settings from server configuration */
+int unifyfs_compact_init(unifyfs_cfg_t* cfg);
+
+/* get the bytes of log space the client should reserve to compact its
+ * log, or zero when compaction is not needed */
+size_t unifyfs_compact_check(app_client* client);
+
+/* move live data of sparse chunks of the client log into the reserved log
+ * range [offset, offset + length). Sets used to the bytes of the range
+ * holding moved data, and moved to the bytes of data now referenced at
+ * the new location */
+int unifyfs_compact_client(app_client* client,
+                           off_t offset,
+                           size_t length,
+                           size_t* used,
+                           size_t* moved);
+
+#endif /* UNIFYFS_COMPACT_H */
@@ -26,6 +26,7 @@ struct _unifyfs_fops_ctx {
     int app_id;
     int client_id;
     int mread_id;
+    uint64_t trace_id; /* nonzero for traced requests */
 };
 typedef struct _unifyfs_fops_ctx unifyfs_fops_ctx_t;
 
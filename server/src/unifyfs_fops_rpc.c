@@ -16,6 +16,7 @@
 #include "unifyfs_inode.h"
 #include "unifyfs_group_rpc.h"
 #include "unifyfs_p2p_rpc.h"
+#include "unifyfs_reclaim.h"
 #include "unifyfs_request_manager.h"
 
 
@@ -33,6 +34,29 @@ int rpc_init(unifyfs_cfg_t* cfg)
     }
     meta_slice_sz = (size_t) range_sz;
 
+    ret = configurator_bool_val(cfg->meta_stripe_extents,
+                                &meta_stripe_extents);
+    if (ret != 0) {
+        LOGERR("failed to read configuration (meta_stripe_extents)");
+        return ret;
+    }
+    if (meta_stripe_extents) {
+        LOGINFO("striping file extent metadata across servers "
+                "(stripe size %zu)", meta_slice_sz);
+    }
+
+    ret = unifyfs_p2p_rpc_init(cfg);
+    if (ret != 0) {
+        LOGERR("failed to initialize p2p rpc settings");
+        return ret;
+    }
+
+    ret = unifyfs_group_rpc_init(cfg);
+    if (ret != 0) {
+        LOGERR("failed to initialize group rpc settings");
+        return ret;
+    }
+
     return ret;
 }
 
@@ -113,6 +137,10 @@ int rpc_fsync(unifyfs_fops_ctx_t* ctx,
     /* the sync rpc now contains extents from a single file/gfid */
     assert(gfid == meta_payload[0].gfid);
 
+    /* the data is in the log as of the current release epoch */
+    uint64_t epoch = unifyfs_reclaim_epoch(client);
+    unifyfs_reclaim_add_file(client, gfid);
+
     for (i = 0; i < num_extents; i++) {
         struct extent_tree_node* extent = &extents[i];
         unifyfs_index_t* meta = &meta_payload[i];
@@ -123,6 +151,7 @@ int rpc_fsync(unifyfs_fops_ctx_t* ctx,
         extent->app_id = ctx->app_id;
         extent->cli_id = ctx->client_id;
         extent->pos = meta->log_pos;
+        extent->epoch = (unsigned long) epoch;
     }
 
     /* update local inode state first */
@@ -256,35 +285,58 @@ int submit_read_request(unifyfs_fops_ctx_t* ctx,
         return UNIFYFS_FAILURE;
     }
 
-    /* TODO: when multiple extents from the same file are requested, it would
-     *       be nice to fetch all the chunks in one call to find_extents rpc.
-     *       this is difficult now because the returned chunks are not
-     *       necessarily in the same order as the requested extents */
+    /* look up the chunks of all extents at once, which sends a single
+     * request to each server that owns any of the requested files */
+    unsigned int n_all_chunks = 0;
+    chunk_read_req_t* all_chunks = NULL;
+    unsigned int* ext_chunks = calloc(count, sizeof(unsigned int));
+    if (NULL == ext_chunks) {
+        return ENOMEM;
+    }
+    uint64_t trace_start = unifyfs_trace_start();
+    int ret = unifyfs_invoke_find_extents_batch_rpc(count, extents,
+                                                    ext_chunks,
+                                                    &n_all_chunks,
+                                                    &all_chunks);
+    unifyfs_trace_end("server_extent_lookup", ctx->trace_id, trace_start);
+    if (ret) {
+        LOGERR("failed to find extent locations");
+        free(ext_chunks);
+        return ret;
+    }
 
-    int ret = UNIFYFS_SUCCESS;
+    /* chunks of each extent are contiguous and in extent order */
+    chunk_read_req_t* ext_pos = all_chunks;
     unsigned int extent_ndx = 0;
     for ( ; extent_ndx < count; extent_ndx++) {
         unifyfs_inode_extent_t* ext = extents + extent_ndx;
-        unsigned int n_chunks = 0;
-        chunk_read_req_t* chunks = NULL;
-        int rc = unifyfs_invoke_find_extents_rpc(ext->gfid, 1, ext,
-                                                 &n_chunks, &chunks);
-        if (rc) {
-            LOGERR("failed to find extent locations");
-            return rc;
-        }
+        unsigned int n_chunks = ext_chunks[extent_ndx];
         if (n_chunks > 0) {
+            /* give each read request its own copy of its chunks,
+             * sorted by server rank */
+            size_t chunks_sz = n_chunks * sizeof(chunk_read_req_t);
+            chunk_read_req_t* chunks = malloc(chunks_sz);
+            if (NULL == chunks) {
+                LOGERR("failed to allocate memory for chunk locations");
+                ret = ENOMEM;
+                break;
+            }
+            memcpy(chunks, ext_pos, chunks_sz);
+            ext_pos += n_chunks;
+            qsort(chunks, n_chunks, sizeof(chunk_read_req_t),
+                  compare_chunk_read_reqs);
+
             /* prepare the remote read requests */
             unsigned int n_remote_reads = 0;
             server_chunk_reads_t* remote_reads = NULL;
-            rc = create_remote_read_requests(n_chunks, chunks,
-                                             &n_remote_reads, &remote_reads);
+            int rc = create_remote_read_requests(n_chunks, chunks,
+                                                 &n_remote_reads,
+                                                 &remote_reads);
             if (rc) {
                 LOGERR("failed to prepare the remote read requests");
-                if (NULL != chunks) {
-                    free(chunks);
-                }
-                return rc;
+                free(chunks);
+                ret = rc;
+                break;
             }
 
             /* fill the information of server_read_req_t and submit */
@@ -297,6 +349,7 @@ int submit_read_request(unifyfs_fops_ctx_t* ctx,
             rdreq.num_server_reads = (int) n_remote_reads;
             rdreq.remote_reads = remote_reads;
             rdreq.extent = *ext;
+            rdreq.trace_id = ctx->trace_id;
             ret = rm_submit_read_request(&rdreq);
         } else {
             LOGDBG("extent(gfid=%d, offset=%lu, len=%lu) has no data",
@@ -305,6 +358,11 @@ int submit_read_request(unifyfs_fops_ctx_t* ctx,
         }
     }
 
+    if (NULL != all_chunks) {
+        free(all_chunks);
+    }
+    free(ext_chunks);
+
     return ret;
 }
 
@@ -52,6 +52,7 @@
 #include "unifyfs_logio.h"
 #include "unifyfs_meta.h"
 #include "unifyfs_shm.h"
+#include "unifyfs_trace.h"
 #include "unifyfs_client_rpcs.h"
 #include "unifyfs_server_rpcs.h"
 
@@ -76,7 +77,7 @@ typedef struct {
 extern server_info_t* glb_servers; /* array of server info structs */
 extern size_t glb_num_servers; /* number of entries in glb_servers array */
 
-extern struct unifyfs_inode_tree* global_inode_tree; /* global inode tree */
+extern struct unifyfs_inode_table* global_inode_table; /* global inodes */
 
 /* defines commands for messages sent to service manager threads */
 typedef enum {
@@ -100,6 +101,7 @@ typedef struct {
     int log_app_id;     /* remote log application id */
     int log_client_id;  /* remote log client id */
     int rank;           /* remote server rank who holds data */
+    uint64_t log_epoch; /* remote log release epoch when data was synced */
 } chunk_read_req_t;
 
 typedef struct {
@@ -116,6 +118,7 @@ typedef struct {
     int client_id;           /* client id of requesting client process */
     int num_chunks;          /* number of chunk requests/responses */
     readreq_status_e status; /* summary status for chunk reads */
+    uint64_t trace_id;       /* trace id of client read, or zero */
     size_t total_sz;         /* total size of data requested */
     chunk_read_req_t* reqs;  /* @RM: subarray of server_read_req_t.chunks
                               * @SM: received requests buffer */
@@ -126,6 +129,9 @@ typedef struct {
 // forward declaration of reqmgr_thrd
 struct reqmgr_thrd;
 
+// forward declaration of log_reclaim
+struct log_reclaim;
+
 /**
  * Structure to maintain application client state, including
  * logio and shared memory contexts, margo rpc address, etc.
@@ -141,6 +147,7 @@ typedef struct app_client {
     struct reqmgr_thrd* reqmgr; /* this client's request manager thread */
 
     logio_context* logio;    /* logio context for write data */
+    struct log_reclaim* reclaim; /* log space reclaim state */
 
     shm_context* shmem_super; /* shmem context for superblock region */
     size_t super_meta_offset; /* superblock offset to index metadata */
@@ -177,6 +184,10 @@ app_client* new_app_client(app_config* app,
                            const char* margo_addr_str,
                            const int dbg_rank);
 
+/* create a client for log data written by the server itself */
+app_client* new_server_app_client(app_config* app,
+                                  const unifyfs_cfg_t* cfg);
+
 unifyfs_rc attach_app_client(app_client* client,
                              const char* logio_spill_dir,
                              const size_t logio_spill_size,
@@ -189,4 +200,10 @@ unifyfs_rc disconnect_app_client(app_client* clnt);
 
 unifyfs_rc cleanup_app_client(app_config* app, app_client* clnt);
 
+unifyfs_rc get_storage_usage(size_t* shmem_bytes, size_t* spill_bytes);
+
+/* call fn with each application client and the given argument,
+ * while holding the application state mutex */
+unifyfs_rc foreach_app_client(void (*fn)(app_client*, void*), void* arg);
+
 #endif // UNIFYFS_GLOBAL_H
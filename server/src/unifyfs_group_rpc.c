@@ -17,10 +17,157 @@
 #include "margo_server.h"
 #include "unifyfs_server_rpcs.h"
 #include "unifyfs_group_rpc.h"
+#include "extent_wire.h"
+#include "unifyfs_stats.h"
+#include "unifyfs_readthrough.h"
+#include "unifyfs_transfer.h"
 
-#ifndef UNIFYFS_BCAST_K_ARY
-# define UNIFYFS_BCAST_K_ARY 2
-#endif
+/* broadcast tree shape */
+typedef struct {
+    unifyfs_tree_type_e type;
+    int degree; /* k-ary tree degree */
+} bcast_tree_shape;
+
+/* Tree shapes used for broadcasts. Small control messages (e.g., truncate,
+ * unlink, and file attributes) use a wide and shallow tree to minimize
+ * latency, while large payloads (e.g., extents) use a narrow tree so that
+ * each server forwards the payload to fewer children. The shape is chosen
+ * per operation, and for operations that carry extents also from the
+ * payload size, which is known to every server in the tree, so all servers
+ * must be configured with the same settings. */
+static bcast_tree_shape bcast_small_shape = {
+    UNIFYFS_TREE_K_ARY, UNIFYFS_BCAST_SMALL_DEGREE
+};
+static bcast_tree_shape bcast_large_shape = {
+    UNIFYFS_TREE_K_ARY, UNIFYFS_BCAST_LARGE_DEGREE
+};
+static size_t bcast_large_size = UNIFYFS_BCAST_LARGE_SIZE;
+
+/* broadcast operations */
+typedef enum {
+    BCAST_EXTENTS = 0,
+    BCAST_LAMINATE,
+    BCAST_TRUNCATE,
+    BCAST_FILEATTR,
+    BCAST_UNLINK,
+    BCAST_TRANSFER,
+    BCAST_READTHROUGH,
+    BCAST_NUM_OPS
+} bcast_op_e;
+
+/* how the tree shape of each broadcast operation is chosen. Extents and
+ * lamination carry file extents, whose size ranges from a few bytes to
+ * many megabytes, so their shape follows the payload size. The other
+ * operations send a fixed-size control message, and each server does its
+ * part (e.g., writing its data for a transfer) after forwarding, so they
+ * always use the wide tree to start all servers as early as possible */
+static const struct {
+    const char* name;
+    int sized; /* shape depends on payload size */
+} bcast_ops[BCAST_NUM_OPS] = {
+    [BCAST_EXTENTS]     = { "extents",     1 },
+    [BCAST_LAMINATE]    = { "laminate",    1 },
+    [BCAST_TRUNCATE]    = { "truncate",    0 },
+    [BCAST_FILEATTR]    = { "fileattr",    0 },
+    [BCAST_UNLINK]      = { "unlink",      0 },
+    [BCAST_TRANSFER]    = { "transfer",    0 },
+    [BCAST_READTHROUGH] = { "readthrough", 0 },
+};
+
+/* set broadcast tree shape from configuration values */
+static void bcast_shape_config(const char* name,
+                               const char* type_str,
+                               const char* degree_str,
+                               bcast_tree_shape* shape)
+{
+    unifyfs_tree_type_e type;
+    long degree;
+
+    if (NULL != type_str) {
+        if (0 == unifyfs_tree_type_parse(type_str, &type)) {
+            shape->type = type;
+        } else {
+            LOGWARN("invalid %s broadcast tree type '%s', using %s",
+                    name, type_str, unifyfs_tree_type_name(shape->type));
+        }
+    }
+
+    if (NULL != degree_str) {
+        if ((0 == configurator_int_val(degree_str, &degree)) &&
+            (degree >= 1)) {
+            shape->degree = (int) degree;
+        } else {
+            LOGWARN("invalid %s broadcast tree degree '%s', using %d",
+                    name, degree_str, shape->degree);
+        }
+    }
+}
+
+/* read broadcast tree settings from server configuration */
+int unifyfs_group_rpc_init(unifyfs_cfg_t* cfg)
+{
+    long large_size;
+
+    if (NULL == cfg) {
+        return EINVAL;
+    }
+
+    bcast_shape_config("small", cfg->margo_bcast_tree,
+                       cfg->margo_bcast_degree, &bcast_small_shape);
+    bcast_shape_config("large", cfg->margo_bcast_large_tree,
+                       cfg->margo_bcast_large_degree, &bcast_large_shape);
+
+    if (NULL != cfg->margo_bcast_large_size) {
+        if ((0 == configurator_int_val(cfg->margo_bcast_large_size,
+                                       &large_size)) &&
+            (large_size >= 0)) {
+            bcast_large_size = (size_t) large_size;
+        } else {
+            LOGWARN("invalid broadcast large payload size '%s', using %zu",
+                    cfg->margo_bcast_large_size, bcast_large_size);
+        }
+    }
+
+    for (int op = 0; op < BCAST_NUM_OPS; op++) {
+        if (bcast_ops[op].sized) {
+            LOGINFO("%s broadcast tree: %s(%d) below %zu bytes, "
+                    "%s(%d) otherwise", bcast_ops[op].name,
+                    unifyfs_tree_type_name(bcast_small_shape.type),
+                    bcast_small_shape.degree, bcast_large_size,
+                    unifyfs_tree_type_name(bcast_large_shape.type),
+                    bcast_large_shape.degree);
+        } else {
+            LOGINFO("%s broadcast tree: %s(%d)", bcast_ops[op].name,
+                    unifyfs_tree_type_name(bcast_small_shape.type),
+                    bcast_small_shape.degree);
+        }
+    }
+
+    return UNIFYFS_SUCCESS;
+}
+
+/* initialize broadcast tree rooted at given rank, using the tree shape
+ * of the operation for the given payload size */
+static int bcast_tree_init(bcast_op_e op,
+                           int root,
+                           size_t payload_size,
+                           unifyfs_tree_t* tree)
+{
+    bcast_tree_shape* shape = &bcast_small_shape;
+    if (bcast_ops[op].sized && (payload_size >= bcast_large_size)) {
+        shape = &bcast_large_shape;
+    }
+    int rc = unifyfs_tree_init_type(glb_pmi_rank, glb_pmi_size, root,
+                                    shape->type, shape->degree, tree);
+    if (rc != UNIFYFS_SUCCESS) {
+        /* leave an empty tree, which is safe to free */
+        LOGERR("failed to create %s broadcast tree rooted at %d (rc=%d)",
+               bcast_ops[op].name, root, rc);
+        memset(tree, 0, sizeof(*tree));
+        tree->parent_rank = -1;
+    }
+    return rc;
+}
 
 /* server collective (coll) margo request structure */
 typedef struct {
@@ -91,6 +238,7 @@ static int wait_for_request(coll_request* creq)
 static void extent_bcast_rpc(hg_handle_t handle)
 {
     LOGDBG("MARGOTREE: extent bcast handler");
+    uint64_t start = unifyfs_stats_start();
 
     /* assume we'll succeed */
     int32_t ret = UNIFYFS_SUCCESS;
@@ -111,31 +259,37 @@ static void extent_bcast_rpc(hg_handle_t handle)
         int gfid = (int) in.gfid;
         int32_t num_extents = (int32_t) in.num_extents;
 
-        /* allocate memory for extents */
-        struct extent_tree_node* extents;
-        extents = calloc(num_extents, sizeof(struct extent_tree_node));
+        /* allocate memory for encoded extents */
+        hg_size_t buf_size = in.extents_size;
+        void* datap = malloc((size_t)buf_size);
 
         /* get client address */
         const struct hg_info* info = margo_get_info(handle);
         hg_addr_t client_address = info->addr;
 
-        /* expose local bulk buffer */
-        hg_size_t buf_size = num_extents * sizeof(struct extent_tree_node);
-        hg_bulk_t extent_data;
-        void* datap = extents;
-        hret = margo_bulk_create(mid, 1, &datap, &buf_size,
-                                 HG_BULK_READWRITE, &extent_data);
-        if (hret != HG_SUCCESS) {
-            LOGERR("margo_bulk_create() failed");
-            ret = UNIFYFS_ERROR_MARGO;
+        /* expose local bulk buffer, the encoded extents are forwarded
+         * to our children as received */
+        hg_bulk_t extent_data = HG_BULK_NULL;
+        if (NULL == datap) {
+            LOGERR("allocation for bulk extents failed");
+            ret = ENOMEM;
         } else {
+            hret = margo_bulk_create(mid, 1, &datap, &buf_size,
+                                     HG_BULK_READWRITE, &extent_data);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+                extent_data = HG_BULK_NULL;
+            }
+        }
+        if (HG_BULK_NULL != extent_data) {
             int i, rc;
             hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_bcast_id;
 
             /* create communication tree structure */
             unifyfs_tree_t bcast_tree;
-            unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, in.root,
-                              UNIFYFS_BCAST_K_ARY, &bcast_tree);
+            int tree_ret = bcast_tree_init(BCAST_EXTENTS, in.root,
+                                           (size_t)buf_size, &bcast_tree);
 
             /* initiate data transfer */
             margo_request bulk_request;
@@ -184,13 +338,27 @@ static void extent_bcast_rpc(hg_handle_t handle)
                     }
                 }
 
-                ret = unifyfs_inode_add_extents(gfid, num_extents, extents);
+                size_t n_decoded = 0;
+                struct extent_tree_node* extents = NULL;
+                ret = extent_wire_decode(datap, (size_t)buf_size,
+                                         &n_decoded, &extents);
+                if ((ret == UNIFYFS_SUCCESS) &&
+                    (n_decoded != (size_t)num_extents)) {
+                    ret = EINVAL;
+                }
                 if (ret) {
-                    LOGERR("add of remote extents failed (ret=%d)", ret);
-                    // what do we do now?
+                    LOGERR("failed to decode remote extents (ret=%d)", ret);
+                } else {
+                    ret = unifyfs_inode_add_extents(gfid, num_extents,
+                                                    extents);
+                    if (ret) {
+                        LOGERR("add of remote extents failed (ret=%d)", ret);
+                        // what do we do now?
+                    }
+                    LOGDBG("added %d extents (%zu bytes) from %d",
+                           num_extents, (size_t)buf_size, (int)in.root);
                 }
-                LOGDBG("added %d extents (%zu bytes) from %d",
-                       num_extents, (size_t)buf_size, (int)in.root);
+                free(extents);
 
                 if (NULL != requests) {
                     /* wait for the requests to finish */
@@ -226,9 +394,15 @@ static void extent_bcast_rpc(hg_handle_t handle)
             /* free bulk data handle */
             margo_bulk_free(extent_data);
 
+            /* our subtree did not get the extents without a tree */
+            if (tree_ret != UNIFYFS_SUCCESS) {
+                ret = tree_ret;
+            }
+
             /* release communication tree resources */
             unifyfs_tree_free(&bcast_tree);
         }
+        free(datap);
         margo_free_input(handle, &in);
     }
 
@@ -246,6 +420,8 @@ static void extent_bcast_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_EXTENTS, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(extent_bcast_rpc)
 
@@ -268,9 +444,13 @@ int extent_bcast_forward(const unifyfs_tree_t* broadcast_tree,
      * TODO: possibly get this from memory pool */
     coll_request* requests = calloc(child_count,
                                     sizeof(*requests));
+    if (NULL == requests) {
+        return ENOMEM;
+    }
 
     /* forward request down the tree */
-    int i, rc, ret;
+    int i, rc;
+    int ret = UNIFYFS_SUCCESS;
     coll_request* req;
     hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_bcast_id;
     for (i = 0; i < child_count; i++) {
@@ -311,6 +491,7 @@ int extent_bcast_forward(const unifyfs_tree_t* broadcast_tree,
             ret = rc;
         }
     }
+    free(requests);
 
     return ret;
 }
@@ -322,21 +503,36 @@ int unifyfs_invoke_broadcast_extents_rpc(int gfid, unsigned int len,
     /* assuming success */
     int ret = UNIFYFS_SUCCESS;
 
+    hg_size_t num_extents = len;
+
+    /* encode the extents to send */
+    void* datap = NULL;
+    size_t wire_size = 0;
+    ret = extent_wire_encode(extents, (size_t)num_extents,
+                             &datap, &wire_size);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to encode extents for gfid=%d (ret=%d)", gfid, ret);
+        free(extents);
+        return ret;
+    }
+    hg_size_t buf_size = (hg_size_t) wire_size;
+
     /* create communication tree */
     unifyfs_tree_t bcast_tree;
-    unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, glb_pmi_rank,
-                      UNIFYFS_BCAST_K_ARY, &bcast_tree);
-
-    hg_size_t num_extents = len;
-    hg_size_t buf_size = num_extents * sizeof(*extents);
+    ret = bcast_tree_init(BCAST_EXTENTS, glb_pmi_rank, wire_size,
+                          &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        free(datap);
+        free(extents);
+        return ret;
+    }
 
-    LOGDBG("broadcasting %u extents for gfid=%d)",
-           len, gfid);
+    LOGDBG("broadcasting %u extents (%zu bytes) for gfid=%d)",
+           len, wire_size, gfid);
 
-    /* create bulk data structure containing the extents
+    /* create bulk data structure containing the encoded extents
      * NOTE: bulk data is always read only at the root of the broadcast tree */
     hg_bulk_t extents_bulk;
-    void* datap = (void*) extents;
     hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid, 1,
                                          &datap, &buf_size,
                                          HG_BULK_READ_ONLY, &extents_bulk);
@@ -349,16 +545,18 @@ int unifyfs_invoke_broadcast_extents_rpc(int gfid, unsigned int len,
         in.root = (int32_t)glb_pmi_rank;
         in.gfid = gfid;
         in.num_extents = num_extents;
+        in.extents_size = buf_size;
         in.extents = extents_bulk;
 
-        extent_bcast_forward(&bcast_tree, &in);
+        ret = extent_bcast_forward(&bcast_tree, &in);
 
         /* free bulk data handle */
         margo_bulk_free(extents_bulk);
     }
 
-    /* free tree resources and passed extents */
+    /* free tree resources, encoded and passed extents */
     unifyfs_tree_free(&bcast_tree);
+    free(datap);
     free(extents);
 
     return ret;
@@ -368,192 +566,28 @@ int unifyfs_invoke_broadcast_extents_rpc(int gfid, unsigned int len,
  * Broadcast file attributes and extents metadata due to laminate
  *************************************************************************/
 
-/* file extents metadata broadcast rpc handler */
-static void laminate_bcast_rpc(hg_handle_t handle)
-{
-    LOGDBG("MARGOTREE: laminate bcast handler");
-
-    int32_t ret;
-
-    /* get instance id */
-    margo_instance_id mid = margo_hg_handle_get_instance(handle);
-
-    /* get input params */
-    laminate_bcast_in_t in;
-    hg_return_t hret = margo_get_input(handle, &in);
-    if (hret != HG_SUCCESS) {
-        LOGERR("margo_get_input() failed");
-        ret = UNIFYFS_ERROR_MARGO;
-    } else {
-        /* get root of tree and global file id to lookup filesize
-         * record tag calling process wants us to include in our
-         * later response */
-        int gfid = (int) in.gfid;
-        size_t num_extents = (size_t) in.num_extents;
-        unifyfs_file_attr_t* fattr = &(in.attr);
-
-        /* allocate memory for extents */
-        struct extent_tree_node* extents;
-        extents = calloc(num_extents, sizeof(struct extent_tree_node));
-
-        /* get client address */
-        const struct hg_info* info = margo_get_info(handle);
-        hg_addr_t client_address = info->addr;
-
-        /* expose local bulk buffer */
-        hg_size_t buf_size = num_extents * sizeof(struct extent_tree_node);
-        hg_bulk_t extent_data;
-        void* datap = extents;
-        hret = margo_bulk_create(mid, 1, &datap, &buf_size,
-                                 HG_BULK_READWRITE, &extent_data);
-        if (hret != HG_SUCCESS) {
-            LOGERR("margo_bulk_create() failed");
-            ret = UNIFYFS_ERROR_MARGO;
-        } else {
-            int i, rc;
-            hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.laminate_bcast_id;
-
-            /* create communication tree structure */
-            unifyfs_tree_t bcast_tree;
-            unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, in.root,
-                              UNIFYFS_BCAST_K_ARY, &bcast_tree);
-
-            /* initiate data transfer */
-            margo_request bulk_request;
-            hret = margo_bulk_itransfer(mid, HG_BULK_PULL,
-                                        client_address, in.extents, 0,
-                                        extent_data, 0,
-                                        buf_size, &bulk_request);
-            if (hret != HG_SUCCESS) {
-                LOGERR("margo_bulk_itransfer() failed");
-                ret = UNIFYFS_ERROR_MARGO;
-            }
-
-            /* allocate memory for request objects
-             * TODO: possibly get this from memory pool */
-            coll_request* requests =
-                calloc(bcast_tree.child_count, sizeof(*requests));
-            if (NULL == requests) {
-                ret = ENOMEM;
-            } else {
-                /* allocate mercury handles for forwarding the request */
-                for (i = 0; i < bcast_tree.child_count; i++) {
-                    /* allocate handle for request to this child */
-                    int child = bcast_tree.child_ranks[i];
-                    get_request_handle(req_hgid, child, requests+i);
-                }
-            }
-
-            /* wait for data transfer to finish */
-            hret = margo_wait(bulk_request);
-            if (hret != HG_SUCCESS) {
-                LOGERR("margo_wait() for bulk transfer failed");
-                ret = UNIFYFS_ERROR_MARGO;
-            } else {
-                LOGINFO("laminating gfid=%d, received %zu extents from %d",
-                       gfid, num_extents, (int)in.root);
-
-                if (NULL != requests) {
-                    /* update input structure to point to local bulk handle */
-                    in.extents = extent_data;
-
-                    /* forward request down the tree */
-                    for (i = 0; i < bcast_tree.child_count; i++) {
-                        /* invoke filesize request rpc on child */
-                        rc = forward_request((void*)&in, requests+i);
-                    }
-                }
-
-                /* update inode file attributes. first check to make sure inode
-                 * for the gfid exists. if it doesn't, create it with given
-                 * attrs. otherwise, just do a metadata update. */
-                unifyfs_file_attr_t existing_fattr;
-                ret = unifyfs_inode_metaget(gfid, &existing_fattr);
-                if (ret == ENOENT) {
-                    /* create with is_laminated=0 so extents can be added */
-                    fattr->is_laminated = 0;
-                    ret = unifyfs_inode_create(gfid, fattr);
-                    if (ret != UNIFYFS_SUCCESS) {
-                        LOGERR("inode create failed (ret=%d)", ret);
-                    }
-                    fattr->is_laminated = 1;
-                }
-
-                /* add the final set of extents */
-                ret = unifyfs_inode_add_extents(gfid, num_extents, extents);
-                if (ret != UNIFYFS_SUCCESS) {
-                    LOGERR("laminate extents update failed (ret=%d)", ret);
-                } else {
-                    ret = unifyfs_inode_metaset(gfid,
-                                                UNIFYFS_FILE_ATTR_OP_LAMINATE,
-                                                fattr);
-                    if (ret != UNIFYFS_SUCCESS) {
-                        LOGERR("laminate attrs update failed (ret=%d)", ret);
-                    }
-                }
-
-                if (NULL != requests) {
-                    /* wait for the requests to finish */
-                    coll_request* req;
-                    for (i = 0; i < bcast_tree.child_count; i++) {
-                        req = requests + i;
-                        rc = wait_for_request(req);
-                        if (rc == UNIFYFS_SUCCESS) {
-                            /* get the output of the rpc */
-                            laminate_bcast_out_t out;
-                            hret = margo_get_output(req->handle, &out);
-                            if (hret != HG_SUCCESS) {
-                                LOGERR("margo_get_output() failed");
-                                ret = UNIFYFS_ERROR_MARGO;
-                            } else {
-                                /* set return value */
-                                int child_ret = (int) out.ret;
-                                LOGDBG("MARGOTREE: laminate child[%d] "
-                                        "response: %d", i, child_ret);
-                                if (child_ret != UNIFYFS_SUCCESS) {
-                                    ret = child_ret;
-                                }
-                                margo_free_output(req->handle, &out);
-                            }
-                            margo_destroy(req->handle);
-                        } else {
-                            ret = rc;
-                        }
-                    }
-                    free(requests);
-                }
-            }
-            /* free bulk data handle */
-            margo_bulk_free(extent_data);
-
-            /* release communication tree resources */
-            unifyfs_tree_free(&bcast_tree);
-        }
-        margo_free_input(handle, &in);
-    }
-
-    /* build our output values */
-    laminate_bcast_out_t out;
-    out.ret = ret;
-
-    /* send output back to caller */
-    hret = margo_respond(handle, &out);
-    if (hret != HG_SUCCESS) {
-        LOGERR("margo_respond() failed");
-    }
-
-    LOGDBG("MARGOTREE: laminate bcast handler - responded");
-
-    /* free margo resources */
-    margo_destroy(handle);
-}
-DEFINE_MARGO_RPC_HANDLER(laminate_bcast_rpc)
-
-/* Forward the laminate broadcast to all children and wait for responses */
+/* Laminate broadcasts are segmented so that they are pipelined down the
+ * tree. The root splits the extents of the file into segments of at most
+ * UNIFYFS_BCAST_SEGMENT_SIZE bytes of extent structs, encodes each one
+ * in the extent wire format, and keeps several segment broadcasts in
+ * flight. A segment is only acknowledged once it has reached the leaves,
+ * so the root keeps one segment in flight per level of the tree, and at
+ * least UNIFYFS_BCAST_SEGMENT_WINDOW. Each server forwards the encoded segment
+ * to its children as soon as it has pulled it from its parent, and then
+ * decodes and adds the segment extents to its local inode while its
+ * children do the same. The last segment is only broadcast once all other
+ * segments have been acknowledged by the whole tree, and has is_final set
+ * so that each server marks the file laminated after adding it. */
+
+/* Forward the laminate segment broadcast to all children without waiting,
+ * sets requests to the array of child requests to wait on */
 static
-int laminate_bcast_forward(const unifyfs_tree_t* broadcast_tree,
-                           laminate_bcast_in_t* in)
+int laminate_bcast_start(const unifyfs_tree_t* broadcast_tree,
+                         laminate_bcast_in_t* in,
+                         coll_request** requests)
 {
+    *requests = NULL;
+
     /* get info for tree */
     int* child_ranks = broadcast_tree->child_ranks;
     int child_count  = broadcast_tree->child_count;
@@ -561,37 +595,66 @@ int laminate_bcast_forward(const unifyfs_tree_t* broadcast_tree,
         return UNIFYFS_SUCCESS;
     }
 
-    int gfid = (int) in->gfid;
-    LOGDBG("MARGOTREE: laminate bcast forward for gfid=%d", gfid);
+    LOGDBG("MARGOTREE: laminate bcast forward for gfid=%d (%d extents)",
+           (int)in->gfid, (int)in->num_extents);
 
-    /* allocate memory for request objects
-     * TODO: possibly get this from memory pool */
-    coll_request* requests = calloc(child_count,
-                                    sizeof(*requests));
+    /* allocate memory for request objects */
+    coll_request* reqs = calloc(child_count, sizeof(*reqs));
+    if (NULL == reqs) {
+        return ENOMEM;
+    }
 
     /* forward request down the tree */
-    int i, rc, ret;
+    int i, rc;
+    int ret = UNIFYFS_SUCCESS;
     coll_request* req;
     hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.laminate_bcast_id;
     for (i = 0; i < child_count; i++) {
-        req = requests + i;
+        req = reqs + i;
 
         /* allocate handle */
         rc = get_request_handle(req_hgid, child_ranks[i], req);
         if (rc == UNIFYFS_SUCCESS) {
-            /* invoke extbcast request rpc on child */
+            /* invoke laminate request rpc on child */
             rc = forward_request((void*)in, req);
+            if (rc != UNIFYFS_SUCCESS) {
+                margo_destroy(req->handle);
+                req->handle = HG_HANDLE_NULL;
+                ret = rc;
+            }
         } else {
+            req->handle = HG_HANDLE_NULL;
             ret = rc;
         }
     }
 
+    *requests = reqs;
+    return ret;
+}
+
+/* Wait for responses to a laminate segment broadcast started with
+ * laminate_bcast_start(), and free the requests */
+static
+int laminate_bcast_wait(const unifyfs_tree_t* broadcast_tree,
+                        coll_request* requests)
+{
+    int i, rc;
+    int ret = UNIFYFS_SUCCESS;
+    coll_request* req;
+
+    if (NULL == requests) {
+        return UNIFYFS_SUCCESS;
+    }
+
     /* wait for the requests to finish */
-    for (i = 0; i < child_count; i++) {
+    for (i = 0; i < broadcast_tree->child_count; i++) {
         req = requests + i;
+        if (HG_HANDLE_NULL == req->handle) {
+            /* forward failed */
+            continue;
+        }
         rc = wait_for_request(req);
         if (rc == UNIFYFS_SUCCESS) {
-            LOGDBG("MARGOTREE: laminate bcast - child[%d] responded", i);
             /* get the output of the rpc */
             laminate_bcast_out_t out;
             hg_return_t hret = margo_get_output(req->handle, &out);
@@ -600,77 +663,383 @@ int laminate_bcast_forward(const unifyfs_tree_t* broadcast_tree,
                 ret = UNIFYFS_ERROR_MARGO;
             } else {
                 /* set return value */
-                int child_ret = out.ret;
+                int child_ret = (int) out.ret;
+                LOGDBG("MARGOTREE: laminate child[%d] response: %d",
+                       i, child_ret);
                 if (child_ret != UNIFYFS_SUCCESS) {
                     ret = child_ret;
                 }
                 margo_free_output(req->handle, &out);
             }
-            margo_destroy(req->handle);
         } else {
             ret = rc;
         }
+        margo_destroy(req->handle);
     }
+    free(requests);
 
     return ret;
 }
 
-/* Execute broadcast tree for attributes and extent metadata due to laminate */
-int unifyfs_invoke_broadcast_laminate(int gfid)
+/* add the extents of a laminate segment to the local inode, and mark the
+ * file laminated once the final segment has been added */
+static int laminate_apply_segment(laminate_bcast_in_t* in,
+                                  struct extent_tree_node* extents)
 {
-    int ret;
-
-    LOGDBG("broadcasting laminate for gfid=%d", gfid);
+    int gfid = (int) in->gfid;
+    int num_extents = (int) in->num_extents;
+    unifyfs_file_attr_t* fattr = &(in->attr);
+
+    /* first check to make sure inode for the gfid exists. if it doesn't,
+     * create it with given attrs. segments may be handled concurrently,
+     * so another segment may have created it first */
+    unifyfs_file_attr_t existing_fattr;
+    int ret = unifyfs_inode_metaget(gfid, &existing_fattr);
+    if (ret == ENOENT) {
+        /* create with is_laminated=0 so extents can be added */
+        unifyfs_file_attr_t create_fattr = *fattr;
+        create_fattr.is_laminated = 0;
+        ret = unifyfs_inode_create(gfid, &create_fattr);
+        if (ret == EEXIST) {
+            ret = UNIFYFS_SUCCESS;
+        } else if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("inode create failed (ret=%d)", ret);
+        }
+    }
 
-    /* get attributes and extents metadata */
-    unifyfs_file_attr_t attrs;
-    ret = unifyfs_inode_metaget(gfid, &attrs);
-    if (ret != UNIFYFS_SUCCESS) {
-        LOGERR("failed to get file attributes for gfid=%d", gfid);
-        return ret;
+    if ((ret == UNIFYFS_SUCCESS) && (num_extents > 0)) {
+        ret = unifyfs_inode_add_extents(gfid, num_extents, extents);
+        if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("laminate extents update failed (ret=%d)", ret);
+        }
     }
 
-    size_t n_extents;
-    struct extent_tree_node* extents;
-    ret = unifyfs_inode_get_extents(gfid, &n_extents, &extents);
-    if (ret != UNIFYFS_SUCCESS) {
-        LOGERR("failed to get extents for gfid=%d", gfid);
-        return ret;
+    if ((ret == UNIFYFS_SUCCESS) && in->is_final) {
+        ret = unifyfs_inode_metaset(gfid, UNIFYFS_FILE_ATTR_OP_LAMINATE,
+                                    fattr);
+        if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("laminate attrs update failed (ret=%d)", ret);
+        }
     }
 
-    /* create bulk data structure containing the extents
-     * NOTE: bulk data is always read only at the root of the broadcast tree */
-    hg_size_t num_extents = n_extents;
-    hg_size_t buf_size = num_extents * sizeof(*extents);
-    hg_bulk_t extents_bulk;
-    void* datap = (void*) extents;
-    hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid, 1,
-                                         &datap, &buf_size,
-                                         HG_BULK_READ_ONLY, &extents_bulk);
-    if (hret != HG_SUCCESS) {
-        LOGERR("margo_bulk_create() failed");
-        ret = UNIFYFS_ERROR_MARGO;
-    } else {
-        /* create broadcast communication tree */
-        unifyfs_tree_t bcast_tree;
-        unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, glb_pmi_rank,
-                          UNIFYFS_BCAST_K_ARY, &bcast_tree);
+    return ret;
+}
 
-        /* fill input struct and forward */
+/* file extents metadata broadcast rpc handler */
+static void laminate_bcast_rpc(hg_handle_t handle)
+{
+    LOGDBG("MARGOTREE: laminate bcast handler");
+    uint64_t start = unifyfs_stats_start();
+
+    int32_t ret = UNIFYFS_SUCCESS;
+
+    /* get instance id */
+    margo_instance_id mid = margo_hg_handle_get_instance(handle);
+
+    /* get input params */
+    laminate_bcast_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        int gfid = (int) in.gfid;
+        size_t num_extents = (size_t) in.num_extents;
+        size_t total_extents = (size_t) in.total_extents;
+        hg_bulk_t parent_extents = in.extents;
+        hg_bulk_t extent_data = HG_BULK_NULL;
+        void* wire_buf = NULL;
+        struct extent_tree_node* extents = NULL;
+
+        /* pull encoded segment extents from our parent */
+        hg_size_t buf_size = in.extents_size;
+        if (num_extents > 0) {
+            wire_buf = malloc((size_t)buf_size);
+            if (NULL == wire_buf) {
+                ret = ENOMEM;
+            } else {
+                /* get client address */
+                const struct hg_info* info = margo_get_info(handle);
+                hg_addr_t client_address = info->addr;
+
+                /* expose local bulk buffer */
+                hret = margo_bulk_create(mid, 1, &wire_buf, &buf_size,
+                                         HG_BULK_READWRITE, &extent_data);
+                if (hret != HG_SUCCESS) {
+                    LOGERR("margo_bulk_create() failed");
+                    extent_data = HG_BULK_NULL;
+                    ret = UNIFYFS_ERROR_MARGO;
+                } else {
+                    hret = margo_bulk_transfer(mid, HG_BULK_PULL,
+                                               client_address,
+                                               parent_extents, 0,
+                                               extent_data, 0,
+                                               buf_size);
+                    if (hret != HG_SUCCESS) {
+                        LOGERR("margo_bulk_transfer() failed");
+                        ret = UNIFYFS_ERROR_MARGO;
+                    }
+                }
+            }
+        }
+        if ((ret == UNIFYFS_SUCCESS) && (num_extents > 0)) {
+            size_t n_decoded = 0;
+            ret = extent_wire_decode(wire_buf, (size_t)buf_size,
+                                     &n_decoded, &extents);
+            if ((ret == UNIFYFS_SUCCESS) && (n_decoded != num_extents)) {
+                ret = EINVAL;
+            }
+            if (ret != UNIFYFS_SUCCESS) {
+                LOGERR("failed to decode laminate extents (ret=%d)", ret);
+            }
+        }
+
+        if (ret == UNIFYFS_SUCCESS) {
+            LOGDBG("laminating gfid=%d, received %zu of %zu extents from %d",
+                   gfid, num_extents, total_extents, (int)in.root);
+
+            /* create communication tree structure, the shape depends on
+             * the size of all segments so it is the same for each one */
+            unifyfs_tree_t bcast_tree;
+            int fwd_ret = bcast_tree_init(BCAST_LAMINATE, in.root,
+                total_extents * sizeof(struct extent_tree_node), &bcast_tree);
+
+            /* forward encoded segment down the tree using our local bulk
+             * handle, then update our inode while the children do the same */
+            coll_request* requests = NULL;
+            if (fwd_ret == UNIFYFS_SUCCESS) {
+                in.extents = extent_data;
+                fwd_ret = laminate_bcast_start(&bcast_tree, &in, &requests);
+                in.extents = parent_extents;
+            }
+
+            ret = laminate_apply_segment(&in, extents);
+
+            int child_ret = laminate_bcast_wait(&bcast_tree, requests);
+            if (fwd_ret != UNIFYFS_SUCCESS) {
+                ret = fwd_ret;
+            } else if (child_ret != UNIFYFS_SUCCESS) {
+                ret = child_ret;
+            }
+
+            /* release communication tree resources */
+            unifyfs_tree_free(&bcast_tree);
+
+            if (in.is_final) {
+                LOGINFO("laminated gfid=%d with %zu extents from %d",
+                        gfid, total_extents, (int)in.root);
+            }
+        }
+
+        /* free bulk data handle and extents */
+        if (HG_BULK_NULL != extent_data) {
+            margo_bulk_free(extent_data);
+        }
+        free(wire_buf);
+        free(extents);
+
+        margo_free_input(handle, &in);
+    }
+
+    /* build our output values */
+    laminate_bcast_out_t out;
+    out.ret = ret;
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    LOGDBG("MARGOTREE: laminate bcast handler - responded");
+
+    /* free margo resources */
+    margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_LAMINATE, start, ret);
+}
+DEFINE_MARGO_RPC_HANDLER(laminate_bcast_rpc)
+
+/* laminate segment broadcast in flight at the root */
+typedef struct {
+    int active;
+    void* wire_buf;         /* encoded segment extents */
+    hg_bulk_t bulk;         /* bulk handle for encoded extents */
+    coll_request* requests; /* requests to children */
+} laminate_segment;
+
+/* wait for a laminate segment broadcast in flight to finish */
+static int laminate_segment_wait(const unifyfs_tree_t* broadcast_tree,
+                                 laminate_segment* seg)
+{
+    int ret = UNIFYFS_SUCCESS;
+    if (seg->active) {
+        ret = laminate_bcast_wait(broadcast_tree, seg->requests);
+        if (HG_BULK_NULL != seg->bulk) {
+            margo_bulk_free(seg->bulk);
+        }
+        free(seg->wire_buf);
+        seg->active = 0;
+        seg->wire_buf = NULL;
+        seg->bulk = HG_BULK_NULL;
+        seg->requests = NULL;
+    }
+    return ret;
+}
+
+/* Execute broadcast tree for attributes and extent metadata due to laminate */
+int unifyfs_invoke_broadcast_laminate(int gfid)
+{
+    int ret, rc;
+
+    LOGDBG("broadcasting laminate for gfid=%d", gfid);
+
+    /* get attributes and extents metadata */
+    unifyfs_file_attr_t attrs;
+    ret = unifyfs_inode_metaget(gfid, &attrs);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get file attributes for gfid=%d", gfid);
+        return ret;
+    }
+
+    size_t n_extents;
+    struct extent_tree_node* extents;
+    ret = unifyfs_inode_get_extents(gfid, &n_extents, &extents);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get extents for gfid=%d", gfid);
+        return ret;
+    }
+
+    /* create broadcast communication tree */
+    unifyfs_tree_t bcast_tree;
+    ret = bcast_tree_init(BCAST_LAMINATE, glb_pmi_rank,
+                          n_extents * sizeof(*extents), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        free(extents);
+        return ret;
+    }
+
+    /* split extents into segments, always sending at least one */
+    size_t seg_extents = UNIFYFS_BCAST_SEGMENT_SIZE / sizeof(*extents);
+    if (0 == seg_extents) {
+        seg_extents = 1;
+    }
+    size_t n_segments = (n_extents + seg_extents - 1) / seg_extents;
+    if (0 == n_segments) {
+        n_segments = 1;
+    }
+
+    LOGDBG("broadcasting %zu extents for gfid=%d in %zu segments",
+           n_extents, gfid, n_segments);
+
+    /* keep a segment in flight for each level of the tree, so that all
+     * levels are busy while the acknowledgements come back up */
+    size_t window_size = UNIFYFS_BCAST_SEGMENT_WINDOW;
+    if ((size_t)(bcast_tree.depth + 1) > window_size) {
+        window_size = (size_t)(bcast_tree.depth + 1);
+    }
+    if (window_size > n_segments) {
+        window_size = n_segments;
+    }
+    laminate_segment* window = calloc(window_size, sizeof(*window));
+    if (NULL == window) {
+        unifyfs_tree_free(&bcast_tree);
+        free(extents);
+        return ENOMEM;
+    }
+
+    /* nothing to send if we have no children */
+    if (0 == bcast_tree.child_count) {
+        n_segments = 0;
+    }
+
+    size_t i, j;
+    for (i = 0; i < n_segments; i++) {
+        laminate_segment* seg = window + (i % window_size);
+        int is_final = (i == (n_segments - 1));
+
+        /* the final segment must follow all others, otherwise wait
+         * for the oldest segment if the window is full */
+        if (is_final) {
+            for (j = 0; j < window_size; j++) {
+                rc = laminate_segment_wait(&bcast_tree, window + j);
+                if (rc != UNIFYFS_SUCCESS) {
+                    ret = rc;
+                }
+            }
+        } else {
+            rc = laminate_segment_wait(&bcast_tree, seg);
+            if (rc != UNIFYFS_SUCCESS) {
+                ret = rc;
+            }
+        }
+        if (ret != UNIFYFS_SUCCESS) {
+            break;
+        }
+
+        /* encode the segment extents and create bulk data structure
+         * containing them
+         * NOTE: bulk data is always read only at the root of the tree */
+        size_t offset = i * seg_extents;
+        size_t count = n_extents - offset;
+        if (count > seg_extents) {
+            count = seg_extents;
+        }
+        size_t wire_size = 0;
+        seg->wire_buf = NULL;
+        seg->bulk = HG_BULK_NULL;
+        if (count > 0) {
+            rc = extent_wire_encode(extents + offset, count,
+                                    &(seg->wire_buf), &wire_size);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to encode laminate extents (rc=%d)", rc);
+                ret = rc;
+                break;
+            }
+            hg_size_t buf_size = (hg_size_t) wire_size;
+            hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid,
+                                                 1, &(seg->wire_buf),
+                                                 &buf_size,
+                                                 HG_BULK_READ_ONLY,
+                                                 &(seg->bulk));
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                free(seg->wire_buf);
+                seg->wire_buf = NULL;
+                seg->bulk = HG_BULK_NULL;
+                ret = UNIFYFS_ERROR_MARGO;
+                break;
+            }
+        }
+
+        /* fill input struct and forward */
         laminate_bcast_in_t in;
         in.root = (int32_t) glb_pmi_rank;
         in.gfid = (int32_t) gfid;
         in.attr = attrs;
-        in.num_extents = (int32_t) num_extents;
-        in.extents = extents_bulk;
-        laminate_bcast_forward(&bcast_tree, &in);
-
-        /* free tree resources */
-        unifyfs_tree_free(&bcast_tree);
+        in.num_extents = (int32_t) count;
+        in.total_extents = (int32_t) n_extents;
+        in.is_final = (int32_t) is_final;
+        in.extents_size = (hg_size_t) wire_size;
+        in.extents = seg->bulk;
+        seg->active = 1;
+        rc = laminate_bcast_start(&bcast_tree, &in, &(seg->requests));
+        if (rc != UNIFYFS_SUCCESS) {
+            ret = rc;
+        }
+    }
 
-        /* free bulk data handle */
-        margo_bulk_free(extents_bulk);
+    /* wait for any segments still in flight */
+    for (j = 0; j < window_size; j++) {
+        rc = laminate_segment_wait(&bcast_tree, window + j);
+        if (rc != UNIFYFS_SUCCESS) {
+            ret = rc;
+        }
     }
+    free(window);
+
+    /* free tree resources */
+    unifyfs_tree_free(&bcast_tree);
 
     /* free extents array */
     free(extents);
@@ -784,6 +1153,7 @@ out:
 static void truncate_bcast_rpc(hg_handle_t handle)
 {
     LOGDBG("MARGOTREE: truncate bcast handler");
+    uint64_t start = unifyfs_stats_start();
 
     /* assume we'll succeed */
     int32_t ret = UNIFYFS_SUCCESS;
@@ -797,10 +1167,11 @@ static void truncate_bcast_rpc(hg_handle_t handle)
     } else {
         /* create communication tree */
         unifyfs_tree_t bcast_tree;
-        unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, in.root,
-                        UNIFYFS_BCAST_K_ARY, &bcast_tree);
-
-        ret = truncate_bcast_forward(&bcast_tree, &in);
+        ret = bcast_tree_init(BCAST_TRUNCATE, in.root, sizeof(in),
+                              &bcast_tree);
+        if (ret == UNIFYFS_SUCCESS) {
+            ret = truncate_bcast_forward(&bcast_tree, &in);
+        }
 
         unifyfs_tree_free(&bcast_tree);
         margo_free_input(handle, &in);
@@ -818,6 +1189,8 @@ static void truncate_bcast_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_TRUNCATE, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(truncate_bcast_rpc)
 
@@ -827,13 +1200,13 @@ int unifyfs_invoke_broadcast_truncate(int gfid, size_t filesize)
     LOGDBG("broadcasting truncate for gfid=%d filesize=%zu",
            gfid, filesize);
 
-    /* assuming success */
-    int ret = UNIFYFS_SUCCESS;
-
     /* create communication tree */
     unifyfs_tree_t bcast_tree;
-    unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, glb_pmi_rank,
-                      UNIFYFS_BCAST_K_ARY, &bcast_tree);
+    int ret = bcast_tree_init(BCAST_TRUNCATE, glb_pmi_rank,
+                              sizeof(truncate_bcast_in_t), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
 
     /* fill in input struct */
     truncate_bcast_in_t in;
@@ -945,6 +1318,7 @@ out:
 static void fileattr_bcast_rpc(hg_handle_t handle)
 {
     LOGDBG("MARGOTREE: fileattr bcast handler");
+    uint64_t start = unifyfs_stats_start();
 
     /* assume we'll succeed */
     int32_t ret = UNIFYFS_SUCCESS;
@@ -958,10 +1332,11 @@ static void fileattr_bcast_rpc(hg_handle_t handle)
     } else {
         /* create communication tree */
         unifyfs_tree_t bcast_tree;
-        unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, in.root,
-                        UNIFYFS_BCAST_K_ARY, &bcast_tree);
-
-        ret = fileattr_bcast_forward(&bcast_tree, &in);
+        ret = bcast_tree_init(BCAST_FILEATTR, in.root, sizeof(in),
+                              &bcast_tree);
+        if (ret == UNIFYFS_SUCCESS) {
+            ret = fileattr_bcast_forward(&bcast_tree, &in);
+        }
 
         unifyfs_tree_free(&bcast_tree);
         margo_free_input(handle, &in);
@@ -979,6 +1354,8 @@ static void fileattr_bcast_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_FILEATTR, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(fileattr_bcast_rpc)
 
@@ -991,8 +1368,11 @@ int unifyfs_invoke_broadcast_fileattr(int gfid,
 
     /* create communication tree */
     unifyfs_tree_t bcast_tree;
-    unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, glb_pmi_rank,
-                      UNIFYFS_BCAST_K_ARY, &bcast_tree);
+    int ret = bcast_tree_init(BCAST_FILEATTR, glb_pmi_rank,
+                              sizeof(fileattr_bcast_in_t), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
 
     /* fill in input struct */
     fileattr_bcast_in_t in;
@@ -1001,7 +1381,7 @@ int unifyfs_invoke_broadcast_fileattr(int gfid,
     in.attrop = attr_op;
     in.attr = *fattr;
 
-    int ret = fileattr_bcast_forward(&bcast_tree, &in);
+    ret = fileattr_bcast_forward(&bcast_tree, &in);
     if (ret) {
         LOGERR("fileattr_bcast_forward failed: (ret=%d)", ret);
     }
@@ -1106,6 +1486,7 @@ out:
 static void unlink_bcast_rpc(hg_handle_t handle)
 {
     LOGDBG("MARGOTREE: unlink bcast handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
 
@@ -1118,10 +1499,11 @@ static void unlink_bcast_rpc(hg_handle_t handle)
     } else {
         /* create communication tree */
         unifyfs_tree_t bcast_tree;
-        unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, in.root,
-                        UNIFYFS_BCAST_K_ARY, &bcast_tree);
-
-        ret = unlink_bcast_forward(&bcast_tree, &in);
+        ret = bcast_tree_init(BCAST_UNLINK, in.root, sizeof(in),
+                              &bcast_tree);
+        if (ret == UNIFYFS_SUCCESS) {
+            ret = unlink_bcast_forward(&bcast_tree, &in);
+        }
 
         unifyfs_tree_free(&bcast_tree);
         margo_free_input(handle, &in);
@@ -1139,6 +1521,8 @@ static void unlink_bcast_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_UNLINK, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(unlink_bcast_rpc)
 
@@ -1149,15 +1533,18 @@ int unifyfs_invoke_broadcast_unlink(int gfid)
 
     /* create communication tree */
     unifyfs_tree_t bcast_tree;
-    unifyfs_tree_init(glb_pmi_rank, glb_pmi_size, glb_pmi_rank,
-                      UNIFYFS_BCAST_K_ARY, &bcast_tree);
+    int ret = bcast_tree_init(BCAST_UNLINK, glb_pmi_rank,
+                              sizeof(unlink_bcast_in_t), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
 
     /* fill in input struct */
     unlink_bcast_in_t in;
     in.root = (int32_t) glb_pmi_rank;
     in.gfid = (int32_t) gfid;
 
-    int ret = unlink_bcast_forward(&bcast_tree, &in);
+    ret = unlink_bcast_forward(&bcast_tree, &in);
     if (ret) {
         LOGERR("unlink_bcast_forward failed: (ret=%d)", ret);
     }
@@ -1166,3 +1553,361 @@ int unifyfs_invoke_broadcast_unlink(int gfid)
 
     return ret;
 }
+
+/*************************************************************************
+ * Broadcast file stage-out
+ *************************************************************************/
+
+/* Forward the stage-out broadcast to all children, write the data we
+ * hold on an i/o thread while they write theirs, and wait for their
+ * responses. The handler thread yields while waiting, so other
+ * broadcasts are not held up by the writes */
+static
+int transfer_bcast_forward(const unifyfs_tree_t* broadcast_tree,
+                           transfer_bcast_in_t* in)
+{
+    int i, rc, ret;
+    int gfid = (int) in->gfid;
+    coll_request* requests = NULL;
+
+    LOGDBG("MARGOTREE: transfer bcast forward (gfid=%d)", gfid);
+
+    ret = UNIFYFS_SUCCESS;
+
+    /* get info for tree */
+    int child_count  = broadcast_tree->child_count;
+    int* child_ranks = broadcast_tree->child_ranks;
+    if (child_count > 0) {
+        LOGDBG("MARGOTREE: %d: sending transfer to %d children",
+               glb_pmi_rank, child_count);
+
+        /* allocate memory for request objects */
+        requests = calloc(child_count, sizeof(coll_request));
+        if (!requests) {
+            return ENOMEM;
+        }
+
+        /* forward request down the tree */
+        coll_request* req;
+        hg_id_t hgid = unifyfsd_rpc_context->rpcs.transfer_bcast_id;
+        for (i = 0; i < child_count; i++) {
+            req = requests + i;
+
+            /* get rank of this child */
+            int child = child_ranks[i];
+            LOGDBG("MARGOTREE: transfer child[%d] is rank %d - %s",
+                   i, child, glb_servers[child].margo_svr_addr_str);
+
+            /* allocate handle */
+            rc = get_request_handle(hgid, child, req);
+            if (rc == UNIFYFS_SUCCESS) {
+                /* invoke transfer request rpc on child */
+                rc = forward_request((void*)in, req);
+                if (rc != UNIFYFS_SUCCESS) {
+                    margo_destroy(req->handle);
+                    req->handle = HG_HANDLE_NULL;
+                    ret = rc;
+                }
+            } else {
+                req->handle = HG_HANDLE_NULL;
+                ret = rc;
+            }
+        }
+    }
+
+    /* write the file data held in our client logs */
+    unifyfs_transfer_req* local = NULL;
+    rc = unifyfs_transfer_local_start(gfid, in->dst_file, &local);
+    if (rc != UNIFYFS_SUCCESS) {
+        ret = rc;
+    }
+
+    /* wait for the requests to finish */
+    for (i = 0; i < child_count; i++) {
+        coll_request* req = requests + i;
+        if (HG_HANDLE_NULL == req->handle) {
+            continue;
+        }
+        rc = wait_for_request(req);
+        if (rc == UNIFYFS_SUCCESS) {
+            /* get the output of the rpc */
+            transfer_bcast_out_t out;
+            hg_return_t hret = margo_get_output(req->handle, &out);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_get_output() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                /* set return value */
+                int child_ret = out.ret;
+                LOGDBG("MARGOTREE: transfer child[%d] response: ret=%d",
+                       i, child_ret);
+                if (child_ret != UNIFYFS_SUCCESS) {
+                    ret = child_ret;
+                }
+                margo_free_output(req->handle, &out);
+            }
+        } else {
+            ret = rc;
+        }
+        margo_destroy(req->handle);
+    }
+    free(requests);
+
+    if (NULL != local) {
+        rc = unifyfs_transfer_local_wait(local, NULL);
+        if (rc != UNIFYFS_SUCCESS) {
+            ret = rc;
+        }
+    }
+
+    return ret;
+}
+
+/* stage-out broadcast rpc handler */
+static void transfer_bcast_rpc(hg_handle_t handle)
+{
+    LOGDBG("MARGOTREE: transfer bcast handler");
+    uint64_t start = unifyfs_stats_start();
+
+    int32_t ret;
+
+    /* get input params */
+    transfer_bcast_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        /* create communication tree */
+        unifyfs_tree_t bcast_tree;
+        ret = bcast_tree_init(BCAST_TRANSFER, in.root, sizeof(in),
+                              &bcast_tree);
+        if (ret == UNIFYFS_SUCCESS) {
+            ret = transfer_bcast_forward(&bcast_tree, &in);
+        }
+
+        unifyfs_tree_free(&bcast_tree);
+        margo_free_input(handle, &in);
+    }
+
+    /* build our output values */
+    transfer_bcast_out_t out;
+    out.ret = ret;
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_TRANSFER, start, ret);
+}
+DEFINE_MARGO_RPC_HANDLER(transfer_bcast_rpc)
+
+/* Execute broadcast tree for file stage-out */
+int unifyfs_invoke_broadcast_transfer(int gfid,
+                                      const char* dst_file)
+{
+    LOGDBG("broadcasting transfer for gfid=%d to %s", gfid, dst_file);
+
+    /* create communication tree */
+    unifyfs_tree_t bcast_tree;
+    int ret = bcast_tree_init(BCAST_TRANSFER, glb_pmi_rank,
+                              sizeof(transfer_bcast_in_t), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
+
+    /* fill in input struct */
+    transfer_bcast_in_t in;
+    in.root = (int32_t) glb_pmi_rank;
+    in.gfid = (int32_t) gfid;
+    in.dst_file = dst_file;
+
+    ret = transfer_bcast_forward(&bcast_tree, &in);
+    if (ret) {
+        LOGERR("transfer_bcast_forward failed: (ret=%d)", ret);
+    }
+
+    unifyfs_tree_free(&bcast_tree);
+
+    return ret;
+}
+
+/*************************************************************************
+ * Broadcast read-through file registration
+ *************************************************************************/
+
+/* Forward the read-through registration to all children, register the
+ * file locally, and wait for their responses */
+static
+int readthrough_bcast_forward(const unifyfs_tree_t* broadcast_tree,
+                              readthrough_bcast_in_t* in)
+{
+    int i, rc, ret;
+    int gfid = (int) in->attr.gfid;
+    coll_request* requests = NULL;
+
+    LOGDBG("MARGOTREE: readthrough bcast forward (gfid=%d)", gfid);
+
+    ret = UNIFYFS_SUCCESS;
+
+    /* get info for tree */
+    int child_count  = broadcast_tree->child_count;
+    int* child_ranks = broadcast_tree->child_ranks;
+    if (child_count > 0) {
+        LOGDBG("MARGOTREE: %d: sending readthrough to %d children",
+               glb_pmi_rank, child_count);
+
+        /* allocate memory for request objects */
+        requests = calloc(child_count, sizeof(coll_request));
+        if (!requests) {
+            return ENOMEM;
+        }
+
+        /* forward request down the tree */
+        coll_request* req;
+        hg_id_t hgid = unifyfsd_rpc_context->rpcs.readthrough_bcast_id;
+        for (i = 0; i < child_count; i++) {
+            req = requests + i;
+
+            /* get rank of this child */
+            int child = child_ranks[i];
+            LOGDBG("MARGOTREE: readthrough child[%d] is rank %d - %s",
+                   i, child, glb_servers[child].margo_svr_addr_str);
+
+            /* allocate handle */
+            rc = get_request_handle(hgid, child, req);
+            if (rc == UNIFYFS_SUCCESS) {
+                /* invoke readthrough request rpc on child */
+                rc = forward_request((void*)in, req);
+                if (rc != UNIFYFS_SUCCESS) {
+                    margo_destroy(req->handle);
+                    req->handle = HG_HANDLE_NULL;
+                    ret = rc;
+                }
+            } else {
+                req->handle = HG_HANDLE_NULL;
+                ret = rc;
+            }
+        }
+    }
+
+    /* create the file locally */
+    unifyfs_file_attr_t attr = in->attr;
+    rc = unifyfs_readthrough_register(&attr, in->backing_file);
+    if (rc != UNIFYFS_SUCCESS) {
+        ret = rc;
+    }
+
+    /* wait for the requests to finish */
+    for (i = 0; i < child_count; i++) {
+        coll_request* req = requests + i;
+        if (HG_HANDLE_NULL == req->handle) {
+            continue;
+        }
+        rc = wait_for_request(req);
+        if (rc == UNIFYFS_SUCCESS) {
+            /* get the output of the rpc */
+            readthrough_bcast_out_t out;
+            hg_return_t hret = margo_get_output(req->handle, &out);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_get_output() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                /* set return value */
+                int child_ret = out.ret;
+                LOGDBG("MARGOTREE: readthrough child[%d] response: ret=%d",
+                       i, child_ret);
+                if (child_ret != UNIFYFS_SUCCESS) {
+                    ret = child_ret;
+                }
+                margo_free_output(req->handle, &out);
+            }
+        } else {
+            ret = rc;
+        }
+        margo_destroy(req->handle);
+    }
+    free(requests);
+
+    return ret;
+}
+
+/* read-through registration broadcast rpc handler */
+static void readthrough_bcast_rpc(hg_handle_t handle)
+{
+    LOGDBG("MARGOTREE: readthrough bcast handler");
+    uint64_t start = unifyfs_stats_start();
+
+    int32_t ret;
+
+    /* get input params */
+    readthrough_bcast_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        /* create communication tree */
+        unifyfs_tree_t bcast_tree;
+        ret = bcast_tree_init(BCAST_READTHROUGH, in.root, sizeof(in),
+                              &bcast_tree);
+        if (ret == UNIFYFS_SUCCESS) {
+            ret = readthrough_bcast_forward(&bcast_tree, &in);
+        }
+
+        unifyfs_tree_free(&bcast_tree);
+        margo_free_input(handle, &in);
+    }
+
+    /* build our output values */
+    readthrough_bcast_out_t out;
+    out.ret = ret;
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_BCAST_READTHROUGH, start, ret);
+}
+DEFINE_MARGO_RPC_HANDLER(readthrough_bcast_rpc)
+
+/* Execute broadcast tree for read-through file registration */
+int unifyfs_invoke_broadcast_readthrough(unifyfs_file_attr_t* attr,
+                                         const char* backing_file)
+{
+    LOGDBG("broadcasting readthrough for gfid=%d from %s",
+           attr->gfid, backing_file);
+
+    /* create communication tree */
+    unifyfs_tree_t bcast_tree;
+    int ret = bcast_tree_init(BCAST_READTHROUGH, glb_pmi_rank,
+                              sizeof(readthrough_bcast_in_t), &bcast_tree);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
+
+    /* fill in input struct */
+    readthrough_bcast_in_t in;
+    in.root = (int32_t) glb_pmi_rank;
+    in.attr = *attr;
+    in.backing_file = backing_file;
+
+    ret = readthrough_bcast_forward(&bcast_tree, &in);
+    if (ret) {
+        LOGERR("readthrough_bcast_forward failed: (ret=%d)", ret);
+    }
+
+    unifyfs_tree_free(&bcast_tree);
+
+    return ret;
+}
@@ -20,6 +20,15 @@
 
 /* Collective Server RPCs */
 
+/**
+ * @brief Read broadcast tree settings from the server configuration
+ *
+ * @param cfg  server configuration
+ *
+ * @return success|failure
+ */
+int unifyfs_group_rpc_init(unifyfs_cfg_t* cfg);
+
 /**
  * @brief Broadcast file extents metadata to all servers
  *
@@ -74,5 +83,28 @@ int unifyfs_invoke_broadcast_truncate(int gfid, size_t filesize);
  */
 int unifyfs_invoke_broadcast_unlink(int gfid);
 
+/**
+ * @brief Write the data of a laminated file to a destination file,
+ *        with each server writing the extents held in its client logs
+ *
+ * @param gfid      target file
+ * @param dst_file  destination file path, which must exist
+ *
+ * @return success|failure
+ */
+int unifyfs_invoke_broadcast_transfer(int gfid, const char* dst_file);
+
+/**
+ * @brief Register a read-through file on all servers, whose data is read
+ *        from a backing file when first needed
+ *
+ * @param attr          attributes of the new file
+ * @param backing_file  path of the backing file, readable by all servers
+ *
+ * @return success|failure
+ */
+int unifyfs_invoke_broadcast_readthrough(unifyfs_file_attr_t* attr,
+                                         const char* backing_file);
+
 
 #endif // UNIFYFS_GROUP_RPC_H
@@ -21,8 +21,31 @@
 #include "unifyfs_inode.h"
 #include "unifyfs_inode_tree.h"
 
-struct unifyfs_inode_tree _global_inode_tree;
-struct unifyfs_inode_tree* global_inode_tree = &_global_inode_tree;
+struct unifyfs_inode_table _global_inode_table;
+struct unifyfs_inode_table* global_inode_table = &_global_inode_table;
+
+/* get the global inode tree shard that holds the inode for gfid */
+static inline
+struct unifyfs_inode_tree* inode_tree(int gfid)
+{
+    return unifyfs_inode_table_shard(global_inode_table, gfid);
+}
+
+/* convert the extents of a laminated file into an immutable flat index,
+ * assumes caller holds the inode write lock */
+static
+void unifyfs_inode_compact_extents(struct unifyfs_inode* ino)
+{
+    if ((NULL != ino->extents) && ino->attr.is_laminated &&
+        (NULL == ino->backing_path)) {
+        int rc = extent_tree_compact(ino->extents);
+        if (rc) {
+            /* lookups still work on the uncompacted tree */
+            LOGWARN("failed to compact extents of laminated file (gfid=%d)",
+                    ino->gfid);
+        }
+    }
+}
 
 static inline
 struct unifyfs_inode* unifyfs_inode_alloc(int gfid, unifyfs_file_attr_t* attr)
@@ -50,6 +73,10 @@ int unifyfs_inode_destroy(struct unifyfs_inode* ino)
             free(ino->attr.filename);
         }
 
+        if (NULL != ino->backing_path) {
+            free(ino->backing_path);
+        }
+
         if (NULL != ino->extents) {
             extent_tree_destroy(ino->extents);
             free(ino->extents);
@@ -112,11 +139,11 @@ int unifyfs_inode_create(int gfid, unifyfs_file_attr_t* attr)
 
     ino = unifyfs_inode_alloc(gfid, attr);
 
-    unifyfs_inode_tree_wrlock(global_inode_tree);
+    unifyfs_inode_tree_wrlock(inode_tree(gfid));
     {
-        ret = unifyfs_inode_tree_insert(global_inode_tree, ino);
+        ret = unifyfs_inode_tree_insert(inode_tree(gfid), ino);
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     if (ret) {
         free(ino);
@@ -125,6 +152,63 @@ int unifyfs_inode_create(int gfid, unifyfs_file_attr_t* attr)
     return ret;
 }
 
+int unifyfs_inode_create_backed(int gfid, unifyfs_file_attr_t* attr,
+                                const char* backing_path)
+{
+    int ret = UNIFYFS_SUCCESS;
+    struct unifyfs_inode* ino = NULL;
+
+    if (!attr || !backing_path) {
+        return EINVAL;
+    }
+
+    ino = unifyfs_inode_alloc(gfid, attr);
+    if (NULL == ino) {
+        return ENOMEM;
+    }
+    ino->backing_path = strdup(backing_path);
+    if (NULL == ino->backing_path) {
+        unifyfs_inode_destroy(ino);
+        return ENOMEM;
+    }
+
+    unifyfs_inode_tree_wrlock(inode_tree(gfid));
+    {
+        ret = unifyfs_inode_tree_insert(inode_tree(gfid), ino);
+    }
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
+
+    if (ret) {
+        unifyfs_inode_destroy(ino);
+    }
+
+    return ret;
+}
+
+int unifyfs_inode_get_backing_path(int gfid, char** path)
+{
+    int ret = UNIFYFS_SUCCESS;
+    struct unifyfs_inode* ino = NULL;
+
+    *path = NULL;
+
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
+    {
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
+        if (!ino) {
+            ret = ENOENT;
+        } else if (NULL != ino->backing_path) {
+            *path = strdup(ino->backing_path);
+            if (NULL == *path) {
+                ret = ENOMEM;
+            }
+        }
+    }
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
+
+    return ret;
+}
+
 int unifyfs_inode_update_attr(int gfid, int attr_op,
                               unifyfs_file_attr_t* attr)
 {
@@ -135,18 +219,21 @@ int unifyfs_inode_update_attr(int gfid, int attr_op,
         return EINVAL;
     }
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
             unifyfs_inode_wrlock(ino);
             unifyfs_file_attr_update(attr_op, &ino->attr, attr);
+            if (attr_op == UNIFYFS_FILE_ATTR_OP_LAMINATE) {
+                unifyfs_inode_compact_extents(ino);
+            }
             unifyfs_inode_unlock(ino);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -170,20 +257,20 @@ int unifyfs_inode_metaget(int gfid, unifyfs_file_attr_t* attr)
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    if (!global_inode_tree || !attr) {
+    if (!global_inode_table || !attr) {
         return EINVAL;
     }
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (ino) {
             *attr = ino->attr;
         } else {
             ret = ENOENT;
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -193,11 +280,11 @@ int unifyfs_inode_unlink(int gfid)
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_wrlock(global_inode_tree);
+    unifyfs_inode_tree_wrlock(inode_tree(gfid));
     {
-        ret = unifyfs_inode_tree_remove(global_inode_tree, gfid, &ino);
+        ret = unifyfs_inode_tree_remove(inode_tree(gfid), gfid, &ino);
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     if (ret == UNIFYFS_SUCCESS) {
         ret = unifyfs_inode_destroy(ino);
@@ -211,9 +298,9 @@ int unifyfs_inode_truncate(int gfid, unsigned long size)
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
@@ -232,7 +319,50 @@ int unifyfs_inode_truncate(int gfid, unsigned long size)
             unifyfs_inode_unlock(ino);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
+
+    return ret;
+}
+
+int unifyfs_inode_relocate_extents(int gfid, int num_extents,
+                                   struct extent_tree_node* old_nodes,
+                                   struct extent_tree_node* new_nodes)
+{
+    int ret = UNIFYFS_SUCCESS;
+    struct unifyfs_inode* ino = NULL;
+
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
+    {
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
+        if (!ino) {
+            ret = ENOENT;
+        } else {
+            unifyfs_inode_wrlock(ino);
+            {
+                if (NULL != ino->extents) {
+                    for (int i = 0; i < num_extents; i++) {
+                        struct extent_tree_node* cur = old_nodes + i;
+                        int rc = extent_tree_relocate(ino->extents,
+                                                      cur->start, cur->end,
+                                                      cur->svr_rank,
+                                                      cur->app_id,
+                                                      cur->cli_id,
+                                                      cur->pos,
+                                                      new_nodes[i].pos,
+                                                      new_nodes[i].epoch);
+                        if (rc) {
+                            LOGDBG("failed to relocate extent [%lu, %lu] "
+                                   "of gfid=%d (rc=%d)",
+                                   cur->start, cur->end, gfid, rc);
+                            ret = rc;
+                        }
+                    }
+                }
+            }
+            unifyfs_inode_unlock(ino);
+        }
+    }
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -245,15 +375,15 @@ int unifyfs_inode_add_extents(int gfid, int num_extents,
     struct unifyfs_inode* ino = NULL;
     struct extent_tree* tree = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
             goto out_unlock_tree;
         }
 
-        if (ino->attr.is_laminated) {
+        if (ino->attr.is_laminated && (NULL == ino->backing_path)) {
             LOGERR("trying to add extents to a laminated file (gfid=%d)",
                    gfid);
             ret = EINVAL;
@@ -288,7 +418,8 @@ int unifyfs_inode_add_extents(int gfid, int num_extents,
 
                 ret = extent_tree_add(tree, current->start, current->end,
                                       current->svr_rank, current->app_id,
-                                      current->cli_id, current->pos);
+                                      current->cli_id, current->pos,
+                                      current->epoch);
                 if (ret) {
                     LOGERR("failed to add extent [%lu, %lu] to gfid=%d",
                            current->start, current->end, gfid);
@@ -313,7 +444,7 @@ out_unlock_inode:
         ABT_mutex_unlock(ino->abt_sync);
     }
 out_unlock_tree:
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -324,9 +455,9 @@ int unifyfs_inode_get_filesize(int gfid, size_t* offset)
     size_t filesize = 0;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
@@ -342,7 +473,35 @@ int unifyfs_inode_get_filesize(int gfid, size_t* offset)
             LOGDBG("local file size (gfid=%d): %lu", gfid, filesize);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
+
+    return ret;
+}
+
+int unifyfs_inode_extend_filesize(int gfid, size_t size)
+{
+    int ret = UNIFYFS_SUCCESS;
+    struct unifyfs_inode* ino = NULL;
+
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
+    {
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
+        if (!ino) {
+            ret = ENOENT;
+        } else {
+            unifyfs_inode_wrlock(ino);
+            {
+                if (ino->attr.is_laminated) {
+                    LOGERR("cannot extend a laminated file (gfid=%d)", gfid);
+                    ret = EINVAL;
+                } else if ((uint64_t)size > ino->attr.size) {
+                    ino->attr.size = size;
+                }
+            }
+            unifyfs_inode_unlock(ino);
+        }
+    }
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -352,20 +511,21 @@ int unifyfs_inode_laminate(int gfid)
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
             unifyfs_inode_wrlock(ino);
             ino->attr.is_laminated = 1;
+            unifyfs_inode_compact_extents(ino);
             unifyfs_inode_unlock(ino);
 
             LOGDBG("file laminated (gfid=%d)", gfid);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -380,37 +540,26 @@ int unifyfs_inode_get_extents(int gfid, size_t* n,
         return EINVAL;
     }
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
             unifyfs_inode_rdlock(ino);
             {
-                int i = 0;
-                struct extent_tree* tree = ino->extents;
-                size_t n_nodes = tree->count;
-                struct extent_tree_node* _nodes = calloc(n_nodes,
-                                                         sizeof(*_nodes));
-                struct extent_tree_node* curr = NULL;
-
-                if (!_nodes) {
-                    ret = ENOMEM;
+                if (NULL != ino->extents) {
+                    /* handles both live and compacted extent trees */
+                    ret = extent_tree_get_nodes(ino->extents, n, nodes);
                 } else {
-                    while (NULL != (curr = extent_tree_iter(tree, curr))) {
-                        _nodes[i] = *curr;
-                        i++;
-                    }
-
-                    *n = n_nodes;
-                    *nodes = _nodes;
+                    *n = 0;
+                    *nodes = NULL;
                 }
             }
             unifyfs_inode_unlock(ino);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -423,9 +572,9 @@ int unifyfs_inode_get_extent_chunks(unifyfs_inode_extent_t* extent,
     struct unifyfs_inode* ino = NULL;
     int gfid = extent->gfid;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
@@ -445,7 +594,7 @@ int unifyfs_inode_get_extent_chunks(unifyfs_inode_extent_t* extent,
             unifyfs_inode_unlock(ino);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     if (ret == UNIFYFS_SUCCESS) {
         /* extent_tree_get_chunk_list does not populate the gfid field */
@@ -460,7 +609,6 @@ int unifyfs_inode_get_extent_chunks(unifyfs_inode_extent_t* extent,
     return ret;
 }
 
-static
 int compare_chunk_read_reqs(const void* _c1, const void* _c2)
 {
     chunk_read_req_t* c1 = (chunk_read_req_t*) _c1;
@@ -476,10 +624,11 @@ int compare_chunk_read_reqs(const void* _c1, const void* _c2)
 }
 
 
-int unifyfs_inode_resolve_extent_chunks(unsigned int n_extents,
-                                        unifyfs_inode_extent_t* extents,
-                                        unsigned int* n_locs,
-                                        chunk_read_req_t** chunklocs)
+int unifyfs_inode_resolve_extent_chunk_lists(unsigned int n_extents,
+                                             unifyfs_inode_extent_t* extents,
+                                             unsigned int* ext_chunks,
+                                             unsigned int* n_locs,
+                                             chunk_read_req_t** chunklocs)
 {
     int ret = UNIFYFS_SUCCESS;
     unsigned int i = 0;
@@ -496,8 +645,9 @@ int unifyfs_inode_resolve_extent_chunks(unsigned int n_extents,
         goto out_fail;
     }
 
-    n_resolved = (unsigned int*) buf;
-    resolved = (chunk_read_req_t**) &n_resolved[n_extents];
+    /* pointers go first to keep them naturally aligned */
+    resolved = (chunk_read_req_t**) buf;
+    n_resolved = (unsigned int*) &resolved[n_extents];
 
     /* resolve chunks addresses for all requests from inode tree */
     for (i = 0; i < n_extents; i++) {
@@ -520,7 +670,8 @@ int unifyfs_inode_resolve_extent_chunks(unsigned int n_extents,
 
     LOGDBG("resolved %d chunks for read request", n_chunks);
     if (n_chunks > 0) {
-        /* store all chunks in a flat array */
+        /* store all chunks in a flat array, keeping the chunks of each
+         * extent together and in the order the extents were given */
         chunks = calloc(n_chunks, sizeof(*chunks));
         if (!chunks) {
             LOGERR("failed to allocate memory for storing resolved chunks");
@@ -534,22 +685,12 @@ int unifyfs_inode_resolve_extent_chunks(unsigned int n_extents,
                 *pos = resolved[i][j];
                 pos++;
             }
-            if (resolved[i]) {
-                free(resolved[i]);
-            }
-        }
-
-        /* sort the requests based on server rank */
-        qsort(chunks, n_chunks, sizeof(*chunks), compare_chunk_read_reqs);
-
-        chunk_read_req_t* chk = chunks;
-        for (i = 0; i < n_chunks; i++, chk++) {
-            LOGDBG(" [%d] (offset=%lu, nbytes=%lu) @ (%d log(%d:%d:%lu))",
-                   i, chk->offset, chk->nbytes, chk->rank,
-                   chk->log_client_id, chk->log_app_id, chk->log_offset);
         }
     }
 
+    if (NULL != ext_chunks) {
+        memcpy(ext_chunks, n_resolved, n_extents * sizeof(*ext_chunks));
+    }
     *n_locs = n_chunks;
     *chunklocs = chunks;
 
@@ -562,12 +703,50 @@ out_fail:
     }
 
     if (NULL != buf) {
+        for (i = 0; i < n_extents; i++) {
+            if (resolved[i]) {
+                free(resolved[i]);
+            }
+        }
         free(buf);
     }
 
     return ret;
 }
 
+int unifyfs_inode_resolve_extent_chunks(unsigned int n_extents,
+                                        unifyfs_inode_extent_t* extents,
+                                        unsigned int* n_locs,
+                                        chunk_read_req_t** chunklocs)
+{
+    unsigned int n_chunks = 0;
+    chunk_read_req_t* chunks = NULL;
+
+    int ret = unifyfs_inode_resolve_extent_chunk_lists(n_extents, extents,
+                                                       NULL,
+                                                       &n_chunks, &chunks);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
+
+    if (n_chunks > 0) {
+        /* sort the requests based on server rank */
+        qsort(chunks, n_chunks, sizeof(*chunks), compare_chunk_read_reqs);
+
+        chunk_read_req_t* chk = chunks;
+        for (unsigned int i = 0; i < n_chunks; i++, chk++) {
+            LOGDBG(" [%d] (offset=%lu, nbytes=%lu) @ (%d log(%d:%d:%lu))",
+                   i, chk->offset, chk->nbytes, chk->rank,
+                   chk->log_client_id, chk->log_app_id, chk->log_offset);
+        }
+    }
+
+    *n_locs = n_chunks;
+    *chunklocs = chunks;
+
+    return ret;
+}
+
 int unifyfs_inode_span_extents(
     int gfid,                      /* global file id we're looking in */
     unsigned long start,           /* starting logical offset */
@@ -580,9 +759,9 @@ int unifyfs_inode_span_extents(
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
@@ -599,7 +778,7 @@ int unifyfs_inode_span_extents(
         }
 
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
@@ -609,9 +788,9 @@ int unifyfs_inode_dump(int gfid)
     int ret = UNIFYFS_SUCCESS;
     struct unifyfs_inode* ino = NULL;
 
-    unifyfs_inode_tree_rdlock(global_inode_tree);
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
     {
-        ino = unifyfs_inode_tree_search(global_inode_tree, gfid);
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
         if (!ino) {
             ret = ENOENT;
         } else {
@@ -626,7 +805,69 @@ int unifyfs_inode_dump(int gfid)
             unifyfs_inode_unlock(ino);
         }
     }
-    unifyfs_inode_tree_unlock(global_inode_tree);
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
+
+    return ret;
+}
+
+int unifyfs_inode_foreach_extent(int gfid,
+                                 unifyfs_inode_extent_fn fn,
+                                 void* arg)
+{
+    int ret = UNIFYFS_SUCCESS;
+    struct unifyfs_inode* ino = NULL;
+
+    unifyfs_inode_tree_rdlock(inode_tree(gfid));
+    {
+        ino = unifyfs_inode_tree_search(inode_tree(gfid), gfid);
+        if (!ino) {
+            ret = ENOENT;
+        } else {
+            unifyfs_inode_rdlock(ino);
+            if ((NULL != ino->extents) && !ino->attr.is_laminated) {
+                int stop = 0;
+                struct extent_tree_node* node = NULL;
+                extent_tree_rdlock(ino->extents);
+                while (!stop &&
+                       (node = extent_tree_iter(ino->extents, node))) {
+                    stop = fn(gfid, node, arg);
+                }
+                extent_tree_unlock(ino->extents);
+            }
+            unifyfs_inode_unlock(ino);
+        }
+    }
+    unifyfs_inode_tree_unlock(inode_tree(gfid));
 
     return ret;
 }
+
+int unifyfs_inode_get_counts(size_t* n_inodes, size_t* n_extents)
+{
+    size_t inodes = 0;
+    size_t extents = 0;
+
+    if (!global_inode_table || !global_inode_table->shards) {
+        return EINVAL;
+    }
+
+    for (unsigned int i = 0; i < global_inode_table->n_shards; i++) {
+        struct unifyfs_inode_tree* tree = &(global_inode_table->shards[i]);
+        struct unifyfs_inode* ino = NULL;
+
+        unifyfs_inode_tree_rdlock(tree);
+        while ((ino = unifyfs_inode_tree_iter(tree, ino))) {
+            inodes++;
+            unifyfs_inode_rdlock(ino);
+            if (NULL != ino->extents) {
+                extents += extent_tree_count(ino->extents);
+            }
+            unifyfs_inode_unlock(ino);
+        }
+        unifyfs_inode_tree_unlock(tree);
+    }
+
+    *n_inodes = inodes;
+    *n_extents = extents;
+    return UNIFYFS_SUCCESS;
+}
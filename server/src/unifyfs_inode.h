@@ -38,6 +38,7 @@ struct unifyfs_inode {
     int gfid;                     /* global file identifier */
     unifyfs_file_attr_t attr;     /* file attributes */
     struct extent_tree* extents;  /* extent information */
+    char* backing_path;           /* read-through source file, or NULL */
 
     pthread_rwlock_t rwlock;      /* rwlock for pthread access */
     ABT_mutex abt_sync;           /* mutex for argobots ULT access */
@@ -45,7 +46,7 @@ struct unifyfs_inode {
 
 /**
  * @brief create a new inode with given parameters. The newly created inode
- * will be inserted to the global inode tree (global_inode_tree).
+ * will be inserted to the global inode table (global_inode_table).
  *
  * @param gfid global file identifier.
  * @param attr attributes of the new file.
@@ -54,6 +55,31 @@ struct unifyfs_inode {
  */
 int unifyfs_inode_create(int gfid, unifyfs_file_attr_t* attr);
 
+/**
+ * @brief create a new read-through inode, whose data is read on demand
+ * from a backing file. Unlike other laminated files, extents can still be
+ * added for data read from the backing file.
+ *
+ * @param gfid global file identifier.
+ * @param attr attributes of the new file.
+ * @param backing_path path of the backing file.
+ *
+ * @return 0 on success, errno otherwise
+ */
+int unifyfs_inode_create_backed(int gfid, unifyfs_file_attr_t* attr,
+                                const char* backing_path);
+
+/**
+ * @brief get the backing file path of a read-through file.
+ *
+ * @param gfid global file identifier
+ * @param path [out] copy of the path, which the caller should free(), or
+ *             NULL if the file is not a read-through file
+ *
+ * @return 0 on success, errno otherwise
+ */
+int unifyfs_inode_get_backing_path(int gfid, char** path);
+
 /**
  * @brief update the attributes of file with @gfid. The attributes are
  * selectively updated with unifyfs_file_attr_update() function (see
@@ -133,6 +159,21 @@ int unifyfs_inode_get_extents(int gfid, size_t* n,
  */
 int unifyfs_inode_add_extents(int gfid, int n, struct extent_tree_node* nodes);
 
+/**
+ * @brief move the log data of extents in the inode to new log offsets
+ *
+ * @param gfid the global file identifier
+ * @param n the number of extents in @old_nodes and @new_nodes
+ * @param old_nodes extents with the current log offsets of the data
+ * @param new_nodes the same extents with the new log offsets
+ *
+ * @return 0 on success, EBUSY if some extents could not be moved,
+ * errno otherwise
+ */
+int unifyfs_inode_relocate_extents(int gfid, int n,
+                                   struct extent_tree_node* old_nodes,
+                                   struct extent_tree_node* new_nodes);
+
 /**
  * @brief get the maximum file size from the local extent tree of given file
  *
@@ -143,6 +184,17 @@ int unifyfs_inode_add_extents(int gfid, int n, struct extent_tree_node* nodes);
  */
 int unifyfs_inode_get_filesize(int gfid, size_t* offset);
 
+/**
+ * @brief grow the size of given file to at least the given size. the size
+ * is left unchanged if it is already larger.
+ *
+ * @param gfid global file identifier
+ * @param size minimum file size
+ *
+ * @return 0 on success, errno otherwise
+ */
+int unifyfs_inode_extend_filesize(int gfid, size_t size);
+
 /**
  * @brief set the given file as laminated
  *
@@ -167,7 +219,33 @@ int unifyfs_inode_get_extent_chunks(unifyfs_inode_extent_t* extent,
                                     chunk_read_req_t** chunks);
 
 /**
- * @brief Get chunk locations for an array of file extents
+ * @brief Compare two chunk read requests by server rank, for use with qsort()
+ */
+int compare_chunk_read_reqs(const void* _c1, const void* _c2);
+
+/**
+ * @brief Get chunk locations for an array of file extents, keeping the
+ * chunks of each extent contiguous and in the same order as the extents
+ *
+ * @param n_extents  number of input extents
+ * @param extents    array or requested extents
+ *
+ * @param[out] ext_chunks number of chunks for each extent (array of length
+ *                        n_extents allocated by caller, may be NULL)
+ * @param[out] n_locs     number of output chunk locations
+ * @param[out] chunklocs  array of output chunk locations
+ *
+ * @return UNIFYFS_SUCCESS, or error code
+ */
+int unifyfs_inode_resolve_extent_chunk_lists(unsigned int n_extents,
+                                             unifyfs_inode_extent_t* extents,
+                                             unsigned int* ext_chunks,
+                                             unsigned int* n_locs,
+                                             chunk_read_req_t** chunklocs);
+
+/**
+ * @brief Get chunk locations for an array of file extents, sorted by
+ * server rank
  *
  * @param n_extents  number of input extents
  * @param extents    array or requested extents
@@ -218,5 +296,34 @@ int unifyfs_inode_span_extents(
  */
 int unifyfs_inode_dump(int gfid);
 
+/**
+ * @brief count the inodes and extents held in the global inode table
+ *
+ * @param n_inodes [out] number of inodes
+ * @param n_extents [out] total number of extents of all inodes
+ *
+ * @return 0 on success, errno otherwise
+ */
+int unifyfs_inode_get_counts(size_t* n_inodes, size_t* n_extents);
+
+/* callback for unifyfs_inode_foreach_extent(), return nonzero to stop */
+typedef int (*unifyfs_inode_extent_fn)(int gfid,
+                                       struct extent_tree_node* extent,
+                                       void* arg);
+
+/**
+ * @brief call @fn for each extent of the file, unless it is laminated.
+ * The inode is read-locked during the call, so @fn must not modify it
+ *
+ * @param gfid file identifier
+ * @param fn callback function
+ * @param arg argument passed to @fn
+ *
+ * @return 0 on success, ENOENT if the file does not exist
+ */
+int unifyfs_inode_foreach_extent(int gfid,
+                                 unifyfs_inode_extent_fn fn,
+                                 void* arg);
+
 #endif /* __UNIFYFS_INODE_H */
 
@@ -213,3 +213,60 @@ void unifyfs_inode_tree_clear(
     unifyfs_inode_tree_unlock(tree);
 }
 
+/* Returns 0 on success, positive non-zero error code otherwise */
+int unifyfs_inode_table_init(
+    struct unifyfs_inode_table* table,
+    unsigned int n_shards)
+{
+    int ret = 0;
+    unsigned int i;
+
+    if (!table || (n_shards == 0)) {
+        return EINVAL;
+    }
+
+    /* round up to a power of two, so shards can be selected by mask */
+    unsigned int n = 1;
+    while (n < n_shards) {
+        n <<= 1;
+    }
+
+    memset(table, 0, sizeof(*table));
+    table->shards = calloc(n, sizeof(*(table->shards)));
+    if (!table->shards) {
+        return ENOMEM;
+    }
+    table->n_shards = n;
+
+    for (i = 0; i < n; i++) {
+        ret = unifyfs_inode_tree_init(&table->shards[i]);
+        if (ret) {
+            /* unwind the shards initialized so far */
+            while (i-- > 0) {
+                unifyfs_inode_tree_destroy(&table->shards[i]);
+            }
+            free(table->shards);
+            table->shards = NULL;
+            table->n_shards = 0;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+/* Remove and free all nodes and shards in the unifyfs_inode_table. */
+void unifyfs_inode_table_destroy(
+    struct unifyfs_inode_table* table)
+{
+    unsigned int i;
+
+    if (table && table->shards) {
+        for (i = 0; i < table->n_shards; i++) {
+            unifyfs_inode_tree_destroy(&table->shards[i]);
+        }
+        free(table->shards);
+        table->shards = NULL;
+        table->n_shards = 0;
+    }
+}
@@ -174,5 +174,62 @@ static inline void unifyfs_inode_tree_unlock(struct unifyfs_inode_tree* tree)
     pthread_rwlock_unlock(&tree->rwlock);
 }
 
+/*
+ * unifyfs_inode_table: hash-partitioned set of inode trees (shards), keyed by
+ * gfid. Each shard is a unifyfs_inode_tree with its own lock, so operations
+ * on files that map to different shards never contend for the same lock.
+ */
+struct unifyfs_inode_table {
+    unsigned int n_shards;              /** number of shards (power of two) */
+    struct unifyfs_inode_tree* shards;  /** array of inode tree shards */
+};
+
+/* default number of shards in the global inode table */
+#ifndef UNIFYFS_INODE_TABLE_SHARDS
+#define UNIFYFS_INODE_TABLE_SHARDS 64
+#endif
+
+/**
+ * @brief initialize the inode table.
+ *
+ * @param table the table structure to be initialized. this should be
+ * allocated by the caller.
+ * @param n_shards number of shards, rounded up to a power of two
+ *
+ * @return 0 on success, errno otherwise
+ */
+int unifyfs_inode_table_init(struct unifyfs_inode_table* table,
+                             unsigned int n_shards);
+
+/**
+ * @brief Remove and free all inodes and shards in the inode table.
+ *
+ * @param table inode table to destroy
+ */
+void unifyfs_inode_table_destroy(struct unifyfs_inode_table* table);
+
+/**
+ * @brief Get the inode tree shard responsible for @gfid. The caller should
+ * lock/unlock the returned tree as described above.
+ *
+ * @param table inode table
+ * @param gfid global file identifier
+ *
+ * @return inode tree shard
+ */
+static inline
+struct unifyfs_inode_tree* unifyfs_inode_table_shard(
+    struct unifyfs_inode_table* table,
+    int gfid)
+{
+    /* gfids are hashes of file paths, but mix the bits anyway so
+     * that the low bits used to pick a shard are well distributed */
+    unsigned int h = (unsigned int) gfid;
+    h ^= h >> 16;
+    h *= 0x45d9f3bU;
+    h ^= h >> 16;
+    return &(table->shards[h & (table->n_shards - 1)]);
+}
+
 #endif /* __UNIFYFS_INODE_TREE_H */
 
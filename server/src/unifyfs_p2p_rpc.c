@@ -17,17 +17,35 @@
 #include "unifyfs_server_rpcs.h"
 #include "unifyfs_p2p_rpc.h"
 #include "unifyfs_group_rpc.h"
+#include "unifyfs_readthrough.h"
+#include "extent_wire.h"
+#include "unifyfs_stats.h"
 
 /*************************************************************************
  * Peer-to-peer RPC helper methods
  *************************************************************************/
 
+/* partition extent metadata of each file by offset range */
+bool meta_stripe_extents = false;
+
 /* determine server responsible for maintaining target file's metadata */
 int hash_gfid_to_server(int gfid)
 {
     return gfid % glb_pmi_size;
 }
 
+/* determine server responsible for maintaining target file's extent
+ * metadata at the given file offset. When striping, consecutive offset
+ * ranges are assigned round-robin starting from the file owner */
+int hash_gfid_offset_to_server(int gfid, size_t offset)
+{
+    if (!meta_stripe_extents) {
+        return hash_gfid_to_server(gfid);
+    }
+    size_t stripe = offset / meta_slice_sz;
+    return (int)(((size_t)gfid + stripe) % (size_t)glb_pmi_size);
+}
+
 /* server peer-to-peer (p2p) margo request structure */
 typedef struct {
     margo_request request;
@@ -96,10 +114,35 @@ int wait_for_request(p2p_request* req)
  * File extents metadata update request
  *************************************************************************/
 
+/* make sure we have an inode for a file whose striped extent metadata
+ * we maintain, creating it from the attributes sent with the extents
+ * if needed */
+static int striped_extents_inode_check(int gfid,
+                                       unifyfs_file_attr_t* attrs)
+{
+    unifyfs_file_attr_t local;
+    int ret = unifyfs_inode_metaget(gfid, &local);
+    if (ret == ENOENT) {
+        if (attrs->gfid != gfid) {
+            LOGERR("missing attributes for striped extents of gfid=%d",
+                   gfid);
+            return EINVAL;
+        }
+        ret = unifyfs_inode_metaset(gfid, UNIFYFS_FILE_ATTR_OP_CREATE,
+                                    attrs);
+        if (ret == EEXIST) {
+            /* created by a concurrent request */
+            ret = UNIFYFS_SUCCESS;
+        }
+    }
+    return ret;
+}
+
 /* Add extents rpc handler */
 static void add_extents_rpc(hg_handle_t handle)
 {
     LOGDBG("add_extents rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     /* assume we'll succeed */
     int32_t ret = UNIFYFS_SUCCESS;
@@ -119,14 +162,28 @@ static void add_extents_rpc(hg_handle_t handle)
         int sender = in.src_rank;
         int gfid = in.gfid;
         size_t num_extents = (size_t) in.num_extents;
-        size_t bulk_sz = num_extents * sizeof(struct extent_tree_node);
+        size_t filesize = (size_t) in.filesize;
+        size_t bulk_sz = (size_t) in.extents_size;
+
+        if (meta_stripe_extents) {
+            /* we may not have seen this file before */
+            ret = striped_extents_inode_check(gfid, &(in.attr));
+            if (ret != UNIFYFS_SUCCESS) {
+                LOGERR("failed to get inode for striped extents of gfid=%d",
+                       gfid);
+            }
+        }
 
-        /* allocate memory for extents */
-        void* extents_buf = malloc(bulk_sz);
-        if (NULL == extents_buf) {
-            LOGERR("allocation for bulk extents failed");
-            ret = ENOMEM;
-        } else {
+        /* allocate memory for encoded extents */
+        void* extents_buf = NULL;
+        if ((ret == UNIFYFS_SUCCESS) && (num_extents > 0)) {
+            extents_buf = malloc(bulk_sz);
+            if (NULL == extents_buf) {
+                LOGERR("allocation for bulk extents failed");
+                ret = ENOMEM;
+            }
+        }
+        if (NULL != extents_buf) {
             /* register local target buffer for bulk access */
             hg_bulk_t bulk_handle;
             hret = margo_bulk_create(mid, 1, &extents_buf, &bulk_sz,
@@ -144,20 +201,45 @@ static void add_extents_rpc(hg_handle_t handle)
                     LOGERR("margo_bulk_transfer() failed");
                     ret = UNIFYFS_ERROR_MARGO;
                 } else {
-                    /* store new extents */
-                    LOGINFO("received %zu extents for gfid=%d from %d",
-                           num_extents, gfid, sender);
-                    struct extent_tree_node* extents = extents_buf;
-                    ret = unifyfs_inode_add_extents(gfid, num_extents, extents);
+                    /* decode and store new extents */
+                    size_t n_decoded = 0;
+                    struct extent_tree_node* extents = NULL;
+                    ret = extent_wire_decode(extents_buf, bulk_sz,
+                                             &n_decoded, &extents);
+                    if ((ret == UNIFYFS_SUCCESS) &&
+                        (n_decoded != num_extents)) {
+                        ret = EINVAL;
+                    }
                     if (ret) {
-                        LOGERR("failed to add extents from %d (ret=%d)",
-                               sender, ret);
+                        LOGERR("failed to decode %zu extents from %d "
+                               "(ret=%d)", num_extents, sender, ret);
+                    } else {
+                        LOGINFO("received %zu extents (%zu bytes) for "
+                                "gfid=%d from %d",
+                                num_extents, bulk_sz, gfid, sender);
+                        ret = unifyfs_inode_add_extents(gfid, num_extents,
+                                                        extents);
+                        if (ret) {
+                            LOGERR("failed to add extents from %d (ret=%d)",
+                                   sender, ret);
+                        }
                     }
+                    free(extents);
                 }
                 margo_bulk_free(bulk_handle);
             }
             free(extents_buf);
         }
+
+        /* with striped extents, the owner may not see the extent
+         * that ends the file, so it relies on the sender's size */
+        if ((ret == UNIFYFS_SUCCESS) && (filesize > 0)) {
+            ret = unifyfs_inode_extend_filesize(gfid, filesize);
+            if (ret) {
+                LOGERR("failed to extend size of gfid=%d to %zu (ret=%d)",
+                       gfid, filesize, ret);
+            }
+        }
         margo_free_input(handle, &in);
     }
 
@@ -173,14 +255,504 @@ static void add_extents_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_ADD_EXTENTS, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(add_extents_rpc)
 
+/* state of an add extents request sent to a single server */
+typedef struct {
+    int rank;                          /* target server */
+    unsigned int num_extents;          /* number of extents */
+    struct extent_tree_node* extents;  /* extents to add */
+    size_t filesize;                   /* file size hint, or zero */
+    unifyfs_file_attr_t* attrs;        /* file attributes, or NULL */
+    void* wire_buf;                    /* encoded extents */
+    size_t wire_size;                  /* size of encoded extents */
+    hg_bulk_t bulk_handle;             /* bulk handle for encoded extents */
+    p2p_request req;                   /* margo request */
+    int in_flight;                     /* set while request is pending */
+    int ret;                           /* request status */
+} add_extents_request;
+
+/* forward extents to a remote server */
+static int add_extents_forward(int gfid, add_extents_request* areq)
+{
+    p2p_request* preq = &(areq->req);
+    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_add_id;
+    int rc = get_request_handle(req_hgid, areq->rank, preq);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    /* encode extents and create a margo bulk transfer handle for them */
+    areq->wire_buf = NULL;
+    areq->wire_size = 0;
+    areq->bulk_handle = HG_BULK_NULL;
+    if (areq->num_extents > 0) {
+        rc = extent_wire_encode(areq->extents, (size_t)areq->num_extents,
+                                &(areq->wire_buf), &(areq->wire_size));
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("failed to encode extents (rc=%d)", rc);
+            margo_destroy(preq->handle);
+            return rc;
+        }
+        hg_size_t buf_sz = (hg_size_t) areq->wire_size;
+        hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid,
+                                             1, &(areq->wire_buf), &buf_sz,
+                                             HG_BULK_READ_ONLY,
+                                             &(areq->bulk_handle));
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_bulk_create() failed");
+            free(areq->wire_buf);
+            areq->wire_buf = NULL;
+            margo_destroy(preq->handle);
+            return UNIFYFS_ERROR_MARGO;
+        }
+    }
+
+    /* fill rpc input struct and forward request */
+    add_extents_in_t in;
+    in.src_rank = (int32_t) glb_pmi_rank;
+    in.gfid = (int32_t) gfid;
+    in.num_extents = (int32_t) areq->num_extents;
+    in.filesize = (hg_size_t) areq->filesize;
+    if (NULL != areq->attrs) {
+        in.attr = *(areq->attrs);
+    } else {
+        unifyfs_file_attr_set_invalid(&(in.attr));
+    }
+    in.extents_size = (hg_size_t) areq->wire_size;
+    in.extents = areq->bulk_handle;
+    rc = forward_request((void*)&in, preq);
+    if (rc != UNIFYFS_SUCCESS) {
+        if (areq->bulk_handle != HG_BULK_NULL) {
+            margo_bulk_free(areq->bulk_handle);
+        }
+        free(areq->wire_buf);
+        areq->wire_buf = NULL;
+        margo_destroy(preq->handle);
+    }
+    return rc;
+}
+
+/* wait for extents forwarded to a remote server */
+static int add_extents_complete(add_extents_request* areq)
+{
+    p2p_request* preq = &(areq->req);
+
+    /* wait for request completion */
+    int ret = wait_for_request(preq);
+    if (areq->bulk_handle != HG_BULK_NULL) {
+        margo_bulk_free(areq->bulk_handle);
+    }
+    free(areq->wire_buf);
+    areq->wire_buf = NULL;
+    if (ret != UNIFYFS_SUCCESS) {
+        margo_destroy(preq->handle);
+        return ret;
+    }
+
+    /* get the output of the rpc */
+    add_extents_out_t out;
+    hg_return_t hret = margo_get_output(preq->handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        /* set return value */
+        ret = out.ret;
+        margo_free_output(preq->handle, &out);
+    }
+    margo_destroy(preq->handle);
+
+    return ret;
+}
+
+/* Add extents to the servers owning their offset ranges. Extents are
+ * split at range boundaries, and the owner always gets a request so
+ * that it can track the file size */
+static int add_striped_extents(int gfid,
+                               unsigned int num_extents,
+                               struct extent_tree_node* extents)
+{
+    int ret = UNIFYFS_SUCCESS;
+    unsigned int i;
+    int r;
+
+    /* count the pieces of each extent on each server */
+    unsigned int* rank_count = calloc(glb_pmi_size, sizeof(unsigned int));
+    unsigned int* rank_start = calloc(glb_pmi_size, sizeof(unsigned int));
+    if ((NULL == rank_count) || (NULL == rank_start)) {
+        LOGERR("failed to allocate memory for striped extents");
+        free(rank_count);
+        free(rank_start);
+        return ENOMEM;
+    }
+    size_t filesize = 0;
+    size_t num_pieces = 0;
+    for (i = 0; i < num_extents; i++) {
+        size_t pos = extents[i].start;
+        size_t last = extents[i].end;
+        while (pos <= last) {
+            size_t stripe_end = ((pos / meta_slice_sz) + 1) * meta_slice_sz;
+            rank_count[hash_gfid_offset_to_server(gfid, pos)]++;
+            num_pieces++;
+            pos = stripe_end;
+        }
+        if ((last + 1) > filesize) {
+            filesize = last + 1;
+        }
+    }
+
+    /* split the extents into per-server runs of pieces */
+    struct extent_tree_node* pieces = calloc(num_pieces, sizeof(*pieces));
+    add_extents_request* reqs = calloc(glb_pmi_size, sizeof(*reqs));
+    if ((NULL == pieces) || (NULL == reqs)) {
+        LOGERR("failed to allocate memory for striped extents");
+        ret = ENOMEM;
+        goto out;
+    }
+    for (r = 1; r < glb_pmi_size; r++) {
+        rank_start[r] = rank_start[r - 1] + rank_count[r - 1];
+    }
+    for (r = 0; r < glb_pmi_size; r++) {
+        reqs[r].rank = r;
+        reqs[r].extents = pieces + rank_start[r];
+        reqs[r].num_extents = 0;
+    }
+    for (i = 0; i < num_extents; i++) {
+        size_t pos = extents[i].start;
+        size_t last = extents[i].end;
+        while (pos <= last) {
+            size_t stripe_end = ((pos / meta_slice_sz) + 1) * meta_slice_sz;
+            size_t end = (stripe_end - 1 < last) ? (stripe_end - 1) : last;
+            r = hash_gfid_offset_to_server(gfid, pos);
+            struct extent_tree_node* piece =
+                reqs[r].extents + reqs[r].num_extents;
+            *piece = extents[i];
+            piece->start = pos;
+            piece->end = end;
+            piece->pos = extents[i].pos + (pos - extents[i].start);
+            reqs[r].num_extents++;
+            pos = end + 1;
+        }
+    }
+
+    /* the sender already added all extents to its local inode, so we
+     * send its attributes along to servers of other ranges that may not
+     * have an inode for the file yet, rather than have them ask the owner */
+    unifyfs_file_attr_t attrs;
+    ret = unifyfs_inode_metaget(gfid, &attrs);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get attributes of gfid=%d (ret=%d)", gfid, ret);
+        goto out;
+    }
+    if (NULL != attrs.filename) {
+        attrs.filename = strdup(attrs.filename);
+    }
+
+    /* only forward to remote servers that have pieces, plus the owner */
+    int owner_rank = hash_gfid_to_server(gfid);
+    reqs[owner_rank].filesize = filesize;
+    for (r = 0; r < glb_pmi_size; r++) {
+        add_extents_request* areq = reqs + r;
+        if ((r == glb_pmi_rank) ||
+            ((areq->num_extents == 0) && (r != owner_rank))) {
+            continue;
+        }
+        if (r != owner_rank) {
+            areq->attrs = &attrs;
+        }
+        LOGDBG("forwarding %u striped extents of gfid=%d to server %d",
+               areq->num_extents, gfid, r);
+        areq->ret = add_extents_forward(gfid, areq);
+        if (areq->ret == UNIFYFS_SUCCESS) {
+            areq->in_flight = 1;
+        } else {
+            ret = areq->ret;
+        }
+    }
+    for (r = 0; r < glb_pmi_size; r++) {
+        add_extents_request* areq = reqs + r;
+        if (areq->in_flight) {
+            areq->ret = add_extents_complete(areq);
+            if (areq->ret != UNIFYFS_SUCCESS) {
+                LOGERR("failed to add striped extents on server %d (ret=%d)",
+                       r, areq->ret);
+                ret = areq->ret;
+            }
+        }
+    }
+    free(attrs.filename);
+
+out:
+    free(reqs);
+    free(pieces);
+    free(rank_count);
+    free(rank_start);
+
+    return ret;
+}
+
+/* send extents to the file owner and wait for completion */
+static int add_extents_to_owner(int gfid,
+                                int owner_rank,
+                                unsigned int num_extents,
+                                struct extent_tree_node* extents)
+{
+    add_extents_request areq;
+    memset(&areq, 0, sizeof(areq));
+    areq.rank = owner_rank;
+    areq.num_extents = num_extents;
+    areq.extents = extents;
+    int rc = add_extents_forward(gfid, &areq);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    /* wait for request completion */
+    return add_extents_complete(&areq);
+}
+
+/* Extent updates from the clients of this server for the same file are
+ * group-committed to the file owner. The first sync to arrive for a file
+ * becomes the leader of a new batch, and waits up to meta.sync_batch_usec
+ * for other syncs of the file to append their extents, or until the batch
+ * holds meta.sync_batch_extents extents. The leader then closes the batch,
+ * sends all of its extents in a single add_extents rpc, and wakes the
+ * other syncs with the result. */
+typedef struct extent_batch {
+    struct extent_batch* next;         /* next open batch */
+    int gfid;                          /* target file */
+    int owner_rank;                    /* file owner */
+    unsigned int num_extents;          /* number of extents in batch */
+    unsigned int max_extents;          /* capacity of extents array */
+    struct extent_tree_node* extents;  /* batched extents */
+    int num_syncs;                     /* syncs waiting on batch */
+    int done;                          /* set once rpc has completed */
+    int ret;                           /* rpc status */
+    ABT_cond full_cond;                /* signals leader batch is full */
+    ABT_cond done_cond;                /* signals waiters rpc completed */
+} extent_batch;
+
+/* batch window (usecs) and size, a zero window disables batching */
+static long sync_batch_usec = UNIFYFS_META_SYNC_BATCH_USEC;
+static long sync_batch_extents = UNIFYFS_META_SYNC_BATCH_EXTENTS;
+
+/* list of batches still accepting extents, protected by batch_sync */
+static extent_batch* open_batches;
+static ABT_mutex batch_sync = ABT_MUTEX_NULL;
+
+static void extent_batch_free(extent_batch* batch)
+{
+    ABT_cond_free(&(batch->full_cond));
+    ABT_cond_free(&(batch->done_cond));
+    free(batch->extents);
+    free(batch);
+}
+
+/* find open batch for the file, or create one. sets leader if the
+ * batch was created. must hold batch_sync */
+static extent_batch* extent_batch_get(int gfid, int owner_rank, int* leader)
+{
+    extent_batch* batch;
+    for (batch = open_batches; NULL != batch; batch = batch->next) {
+        if (batch->gfid == gfid) {
+            *leader = 0;
+            return batch;
+        }
+    }
+
+    batch = calloc(1, sizeof(*batch));
+    if (NULL == batch) {
+        return NULL;
+    }
+    batch->gfid = gfid;
+    batch->owner_rank = owner_rank;
+    if ((ABT_cond_create(&(batch->full_cond)) != ABT_SUCCESS) ||
+        (ABT_cond_create(&(batch->done_cond)) != ABT_SUCCESS)) {
+        free(batch);
+        return NULL;
+    }
+    batch->next = open_batches;
+    open_batches = batch;
+    *leader = 1;
+    return batch;
+}
+
+/* remove batch from list of open batches. must hold batch_sync */
+static void extent_batch_close(extent_batch* batch)
+{
+    extent_batch** prev = &open_batches;
+    while (NULL != *prev) {
+        if (*prev == batch) {
+            *prev = batch->next;
+            break;
+        }
+        prev = &((*prev)->next);
+    }
+    batch->next = NULL;
+}
+
+/* append extents to batch. must hold batch_sync */
+static int extent_batch_append(extent_batch* batch,
+                               unsigned int num_extents,
+                               struct extent_tree_node* extents)
+{
+    unsigned int count = batch->num_extents + num_extents;
+    if (count > batch->max_extents) {
+        unsigned int max = (batch->max_extents > 0) ?
+                           (2 * batch->max_extents) : num_extents;
+        if (max < count) {
+            max = count;
+        }
+        struct extent_tree_node* grown =
+            realloc(batch->extents, max * sizeof(*grown));
+        if (NULL == grown) {
+            return ENOMEM;
+        }
+        batch->extents = grown;
+        batch->max_extents = max;
+    }
+    memcpy(batch->extents + batch->num_extents, extents,
+           num_extents * sizeof(*extents));
+    batch->num_extents = count;
+    return UNIFYFS_SUCCESS;
+}
+
+/* add extents to the owner as part of a batch */
+static int add_extents_batched(int gfid,
+                               int owner_rank,
+                               unsigned int num_extents,
+                               struct extent_tree_node* extents)
+{
+    int ret;
+    int leader = 0;
+
+    ABT_mutex_lock(batch_sync);
+
+    extent_batch* batch = extent_batch_get(gfid, owner_rank, &leader);
+    if (NULL == batch) {
+        ABT_mutex_unlock(batch_sync);
+        LOGWARN("failed to batch extents for gfid=%d, sending directly",
+                gfid);
+        return add_extents_to_owner(gfid, owner_rank, num_extents, extents);
+    }
+    ret = extent_batch_append(batch, num_extents, extents);
+    if (ret != UNIFYFS_SUCCESS) {
+        if (leader) {
+            extent_batch_close(batch);
+            extent_batch_free(batch);
+        }
+        ABT_mutex_unlock(batch_sync);
+        return add_extents_to_owner(gfid, owner_rank, num_extents, extents);
+    }
+    batch->num_syncs++;
+
+    if (leader) {
+        /* wait for the batch window to expire or the batch to fill */
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += sync_batch_usec / 1000000;
+        deadline.tv_nsec += (sync_batch_usec % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            deadline.tv_sec++;
+        }
+        while (batch->num_extents < (unsigned int)sync_batch_extents) {
+            if (ABT_cond_timedwait(batch->full_cond, batch_sync,
+                                   &deadline) != ABT_SUCCESS) {
+                break;
+            }
+        }
+        extent_batch_close(batch);
+        ABT_mutex_unlock(batch_sync);
+
+        LOGDBG("sending %u extents from %d syncs for gfid=%d to %d",
+               batch->num_extents, batch->num_syncs, gfid, owner_rank);
+        ret = add_extents_to_owner(gfid, owner_rank,
+                                   batch->num_extents, batch->extents);
+
+        ABT_mutex_lock(batch_sync);
+        batch->ret = ret;
+        batch->done = 1;
+        ABT_cond_broadcast(batch->done_cond);
+    } else {
+        /* wake the leader if we filled the batch */
+        if (batch->num_extents >= (unsigned int)sync_batch_extents) {
+            ABT_cond_signal(batch->full_cond);
+        }
+        while (!batch->done) {
+            ABT_cond_wait(batch->done_cond, batch_sync);
+        }
+        ret = batch->ret;
+    }
+
+    /* last sync out frees the batch */
+    batch->num_syncs--;
+    if (0 == batch->num_syncs) {
+        extent_batch_free(batch);
+    }
+
+    ABT_mutex_unlock(batch_sync);
+
+    return ret;
+}
+
+/* read sync batching settings from server configuration */
+int unifyfs_p2p_rpc_init(unifyfs_cfg_t* cfg)
+{
+    long val;
+
+    if (NULL == cfg) {
+        return EINVAL;
+    }
+
+    if (NULL != cfg->meta_sync_batch_usec) {
+        if ((0 == configurator_int_val(cfg->meta_sync_batch_usec, &val)) &&
+            (val >= 0)) {
+            sync_batch_usec = val;
+        } else {
+            LOGWARN("invalid sync batch window '%s', using %ld usecs",
+                    cfg->meta_sync_batch_usec, sync_batch_usec);
+        }
+    }
+
+    if (NULL != cfg->meta_sync_batch_extents) {
+        if ((0 == configurator_int_val(cfg->meta_sync_batch_extents, &val)) &&
+            (val > 0)) {
+            sync_batch_extents = val;
+        } else {
+            LOGWARN("invalid sync batch size '%s', using %ld extents",
+                    cfg->meta_sync_batch_extents, sync_batch_extents);
+        }
+    }
+
+    if ((sync_batch_usec > 0) && (ABT_MUTEX_NULL == batch_sync)) {
+        if (ABT_mutex_create(&batch_sync) != ABT_SUCCESS) {
+            LOGERR("failed to create sync batch mutex");
+            sync_batch_usec = 0;
+        }
+    }
+
+    if (sync_batch_usec > 0) {
+        LOGINFO("batching extent syncs to file owners for up to %ld usecs "
+                "or %ld extents", sync_batch_usec, sync_batch_extents);
+    }
+
+    return UNIFYFS_SUCCESS;
+}
+
 /* Add extents to target file */
 int unifyfs_invoke_add_extents_rpc(int gfid,
                                    unsigned int num_extents,
                                    struct extent_tree_node* extents)
 {
+    if (meta_stripe_extents) {
+        return add_striped_extents(gfid, num_extents, extents);
+    }
+
     int owner_rank = hash_gfid_to_server(gfid);
     if (owner_rank == glb_pmi_rank) {
         /* I'm the owner, already did local add */
@@ -188,159 +760,853 @@ int unifyfs_invoke_add_extents_rpc(int gfid,
     }
 
     /* forward request to file owner */
-    p2p_request preq;
-    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_add_id;
-    int rc = get_request_handle(req_hgid, owner_rank, &preq);
-    if (rc != UNIFYFS_SUCCESS) {
-        return rc;
+    if ((sync_batch_usec > 0) && (num_extents > 0)) {
+        return add_extents_batched(gfid, owner_rank, num_extents, extents);
     }
+    return add_extents_to_owner(gfid, owner_rank, num_extents, extents);
+}
 
-    /* create a margo bulk transfer handle for extents array */
-    hg_bulk_t bulk_handle;
-    void* buf = (void*) extents;
-    size_t buf_sz = (size_t)num_extents * sizeof(struct extent_tree_node);
-    hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid,
-                                         1, &buf, &buf_sz,
-                                         HG_BULK_READ_ONLY, &bulk_handle);
+/*************************************************************************
+ * File extents relocation request
+ *************************************************************************/
+
+/* Relocate extents rpc handler. The extents bulk holds the extents with
+ * their current log offsets, followed by the same extents with their
+ * new log offsets */
+static void relocate_extents_rpc(hg_handle_t handle)
+{
+    LOGDBG("relocate_extents rpc handler");
+    uint64_t start = unifyfs_stats_start();
+
+    int32_t ret = UNIFYFS_SUCCESS;
+
+    const struct hg_info* hgi = margo_get_info(handle);
+    assert(hgi);
+    margo_instance_id mid = margo_hg_info_get_instance(hgi);
+    assert(mid != MARGO_INSTANCE_NULL);
+
+    /* get input params */
+    add_extents_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
     if (hret != HG_SUCCESS) {
-        LOGERR("margo_bulk_create() failed");
-        return UNIFYFS_ERROR_MARGO;
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        int sender = in.src_rank;
+        int gfid = in.gfid;
+        size_t num_extents = (size_t) in.num_extents;
+        size_t bulk_sz = (size_t) in.extents_size;
+
+        void* extents_buf = NULL;
+        if (num_extents > 0) {
+            extents_buf = malloc(bulk_sz);
+            if (NULL == extents_buf) {
+                LOGERR("allocation for bulk extents failed");
+                ret = ENOMEM;
+            }
+        }
+        if (NULL != extents_buf) {
+            hg_bulk_t bulk_handle;
+            hret = margo_bulk_create(mid, 1, &extents_buf, &bulk_sz,
+                                     HG_BULK_WRITE_ONLY, &bulk_handle);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                hret = margo_bulk_transfer(mid, HG_BULK_PULL,
+                                           hgi->addr, in.extents, 0,
+                                           bulk_handle, 0,
+                                           bulk_sz);
+                if (hret != HG_SUCCESS) {
+                    LOGERR("margo_bulk_transfer() failed");
+                    ret = UNIFYFS_ERROR_MARGO;
+                } else {
+                    size_t n_decoded = 0;
+                    struct extent_tree_node* extents = NULL;
+                    ret = extent_wire_decode(extents_buf, bulk_sz,
+                                             &n_decoded, &extents);
+                    if ((ret == UNIFYFS_SUCCESS) &&
+                        (n_decoded != (2 * num_extents))) {
+                        ret = EINVAL;
+                    }
+                    if (ret) {
+                        LOGERR("failed to decode %zu relocated extents "
+                               "from %d (ret=%d)", num_extents, sender, ret);
+                    } else {
+                        LOGDBG("relocating %zu extents of gfid=%d from %d",
+                               num_extents, gfid, sender);
+                        ret = unifyfs_inode_relocate_extents(gfid,
+                                  (int) num_extents, extents,
+                                  extents + num_extents);
+                    }
+                    free(extents);
+                }
+                margo_bulk_free(bulk_handle);
+            }
+            free(extents_buf);
+        }
+        margo_free_input(handle, &in);
     }
 
-    /* fill rpc input struct and forward request */
-    add_extents_in_t in;
-    in.src_rank = (int32_t) glb_pmi_rank;
-    in.gfid = (int32_t) gfid;
-    in.num_extents = (int32_t) num_extents;
-    in.extents = bulk_handle;
-    rc = forward_request((void*)&in, &preq);
-    if (rc != UNIFYFS_SUCCESS) {
-        return rc;
+    /* send output back to caller */
+    add_extents_out_t out;
+    out.ret = ret;
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
     }
-    margo_bulk_free(bulk_handle);
 
-    /* wait for request completion */
-    rc = wait_for_request(&preq);
-    if (rc != UNIFYFS_SUCCESS) {
-        return rc;
+    /* free margo resources */
+    margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_RELOCATE_EXTENTS, start, ret);
+}
+DEFINE_MARGO_RPC_HANDLER(relocate_extents_rpc)
+
+/* Move the log data of extents at the file owner */
+int unifyfs_invoke_relocate_extents_rpc(int gfid,
+                                        unsigned int num_extents,
+                                        struct extent_tree_node* old_extents,
+                                        struct extent_tree_node* new_extents)
+{
+    if (meta_stripe_extents) {
+        /* the extents may be spread over many servers */
+        return UNIFYFS_ERROR_NYI;
+    }
+
+    int owner_rank = hash_gfid_to_server(gfid);
+    if ((owner_rank == glb_pmi_rank) || (0 == num_extents)) {
+        /* I'm the owner, caller updates local inode */
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* encode the old extents followed by the new ones */
+    struct extent_tree_node* extents =
+        malloc(2 * num_extents * sizeof(*extents));
+    if (NULL == extents) {
+        return ENOMEM;
+    }
+    memcpy(extents, old_extents, num_extents * sizeof(*extents));
+    memcpy(extents + num_extents, new_extents,
+           num_extents * sizeof(*extents));
+    void* wire_buf = NULL;
+    size_t wire_size = 0;
+    int rc = extent_wire_encode(extents, 2 * (size_t)num_extents,
+                                &wire_buf, &wire_size);
+    free(extents);
+    if (rc != UNIFYFS_SUCCESS) {
+        LOGERR("failed to encode extents (rc=%d)", rc);
+        return rc;
+    }
+
+    p2p_request preq;
+    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_relocate_id;
+    rc = get_request_handle(req_hgid, owner_rank, &preq);
+    if (rc != UNIFYFS_SUCCESS) {
+        free(wire_buf);
+        return rc;
+    }
+
+    hg_bulk_t bulk_handle;
+    hg_size_t buf_sz = (hg_size_t) wire_size;
+    hg_return_t hret = margo_bulk_create(unifyfsd_rpc_context->svr_mid,
+                                         1, &wire_buf, &buf_sz,
+                                         HG_BULK_READ_ONLY, &bulk_handle);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_bulk_create() failed");
+        margo_destroy(preq.handle);
+        free(wire_buf);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* fill rpc input struct and forward request */
+    add_extents_in_t in;
+    in.src_rank = (int32_t) glb_pmi_rank;
+    in.gfid = (int32_t) gfid;
+    in.num_extents = (int32_t) num_extents;
+    in.filesize = 0;
+    unifyfs_file_attr_set_invalid(&(in.attr));
+    in.extents_size = (hg_size_t) wire_size;
+    in.extents = bulk_handle;
+    rc = forward_request((void*)&in, &preq);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = wait_for_request(&preq);
+    }
+
+    int ret = rc;
+    if (rc == UNIFYFS_SUCCESS) {
+        add_extents_out_t out;
+        hret = margo_get_output(preq.handle, &out);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_get_output() failed");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            ret = out.ret;
+            margo_free_output(preq.handle, &out);
+        }
+    }
+    margo_bulk_free(bulk_handle);
+    margo_destroy(preq.handle);
+    free(wire_buf);
+
+    return ret;
+}
+
+/*************************************************************************
+ * File extents metadata lookup request
+ *************************************************************************/
+
+/* find extents rpc handler */
+static void find_extents_rpc(hg_handle_t handle)
+{
+    LOGDBG("find_extents rpc handler");
+    uint64_t start = unifyfs_stats_start();
+
+    int32_t ret;
+    unsigned int num_chunks = 0;
+    unsigned int n_ext = 0;
+    unsigned int* ext_chunks = NULL;
+    chunk_read_req_t* chunk_locs = NULL;
+
+    const struct hg_info* hgi = margo_get_info(handle);
+    assert(hgi);
+
+    margo_instance_id mid = margo_hg_info_get_instance(hgi);
+    assert(mid != MARGO_INSTANCE_NULL);
+
+    /* get input params */
+    find_extents_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        int sender = in.src_rank;
+        size_t num_extents = (size_t) in.num_extents;
+        size_t bulk_sz = num_extents * sizeof(unifyfs_inode_extent_t);
+        n_ext = (unsigned int) num_extents;
+
+        /* allocate memory for extents and per-extent chunk counts */
+        void* extents_buf = malloc(bulk_sz);
+        ext_chunks = calloc(num_extents, sizeof(*ext_chunks));
+        if ((NULL == extents_buf) || (NULL == ext_chunks)) {
+            LOGERR("allocation for bulk extents failed");
+            ret = ENOMEM;
+        } else {
+            /* register local target buffer for bulk access */
+            hg_bulk_t bulk_req_handle;
+            hret = margo_bulk_create(mid, 1, &extents_buf, &bulk_sz,
+                                     HG_BULK_WRITE_ONLY, &bulk_req_handle);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                /* get list of read requests */
+                hret = margo_bulk_transfer(mid, HG_BULK_PULL,
+                                           hgi->addr, in.extents, 0,
+                                           bulk_req_handle, 0,
+                                           bulk_sz);
+                if (hret != HG_SUCCESS) {
+                    LOGERR("margo_bulk_transfer() failed");
+                    ret = UNIFYFS_ERROR_MARGO;
+                } else {
+                    /* lookup requested extents */
+                    unifyfs_inode_extent_t* extents = extents_buf;
+                    LOGDBG("received %u extent lookups from %d",
+                           n_ext, sender);
+
+                    /* make sure I'm the owner */
+                    for (unsigned int i = 0; i < n_ext; i++) {
+                        assert(glb_pmi_rank ==
+                               hash_gfid_offset_to_server(extents[i].gfid,
+                                                          extents[i].offset));
+                    }
+
+                    /* read any missing data of read-through files */
+                    ret = unifyfs_readthrough_fill(sender, n_ext, extents);
+                    if (ret == UNIFYFS_SUCCESS) {
+                        ret = unifyfs_inode_resolve_extent_chunk_lists(n_ext,
+                            extents, ext_chunks, &num_chunks, &chunk_locs);
+                    }
+                    if (ret == UNIFYFS_SUCCESS) {
+                        ret = unifyfs_readthrough_add_direct(sender, n_ext,
+                            extents, ext_chunks, &num_chunks, &chunk_locs);
+                    }
+                    if (ret) {
+                        LOGERR("failed to find extents for %d (ret=%d)",
+                               sender, ret);
+                    } else if (num_chunks == 0) {
+                        LOGDBG("extent lookup found no matching chunks");
+                    }
+                }
+                margo_bulk_free(bulk_req_handle);
+            }
+        }
+        if (NULL != extents_buf) {
+            free(extents_buf);
+        }
+        margo_free_input(handle, &in);
+    }
+
+    /* define a bulk handle to transfer chunk address info, followed by
+     * the chunk count of each extent */
+    hg_bulk_t bulk_resp_handle = HG_BULK_NULL;
+    if (ret == UNIFYFS_SUCCESS) {
+        if (num_chunks > 0) {
+            void* bufs[2];
+            hg_size_t buf_szs[2];
+            bufs[0] = (void*) chunk_locs;
+            buf_szs[0] = (hg_size_t)num_chunks * sizeof(chunk_read_req_t);
+            bufs[1] = (void*) ext_chunks;
+            buf_szs[1] = (hg_size_t)n_ext * sizeof(*ext_chunks);
+            hret = margo_bulk_create(mid, 2, bufs, buf_szs,
+                                     HG_BULK_READ_ONLY, &bulk_resp_handle);
+            if (hret != HG_SUCCESS) {
+                LOGERR("margo_bulk_create() failed");
+                ret = UNIFYFS_ERROR_MARGO;
+            }
+        }
+    }
+
+    /* fill rpc response struct with output values */
+    find_extents_out_t out;
+    out.ret           = ret;
+    out.num_locations = num_chunks;
+    out.locations     = bulk_resp_handle;
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    if (bulk_resp_handle != HG_BULK_NULL) {
+        margo_bulk_free(bulk_resp_handle);
+    }
+    if (NULL != chunk_locs) {
+        free(chunk_locs);
+    }
+    if (NULL != ext_chunks) {
+        free(ext_chunks);
+    }
+    margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_FIND_EXTENTS, start, ret);
+}
+DEFINE_MARGO_RPC_HANDLER(find_extents_rpc)
+
+/* state of a batched extent lookup sent to a single server */
+typedef struct {
+    int rank;                         /* server to resolve extents */
+    unsigned int num_extents;         /* number of extents in batch */
+    unsigned int* ext_ndx;            /* caller index of each extent */
+    unifyfs_inode_extent_t* extents;  /* extents to resolve */
+    unsigned int* ext_chunks;         /* chunk count of each extent */
+    unsigned int num_chunks;          /* total number of chunks */
+    chunk_read_req_t* chunks;         /* chunk locations in extent order */
+    hg_bulk_t bulk_handle;            /* bulk handle for extents array */
+    p2p_request req;                  /* request, when rank is remote */
+    int ret;                          /* lookup status */
+} find_extents_batch;
+
+/* determine whether we have the final extents of a laminated file.
+ * the extents of read-through files are only known to their owners */
+static int find_extents_is_laminated(int gfid)
+{
+    /* do local inode metadata lookup to check for laminated */
+    unifyfs_file_attr_t attrs;
+    int ret = unifyfs_inode_metaget(gfid, &attrs);
+    return ((ret == UNIFYFS_SUCCESS) && attrs.is_laminated &&
+            !unifyfs_readthrough_is_backed(gfid));
+}
+
+/* forward a batch of extent lookups to a remote server */
+static int find_extents_batch_forward(find_extents_batch* batch)
+{
+    p2p_request* preq = &(batch->req);
+    margo_instance_id mid = unifyfsd_rpc_context->svr_mid;
+    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_lookup_id;
+    int rc = get_request_handle(req_hgid, batch->rank, preq);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    /* create a margo bulk transfer handle for extents array */
+    void* buf = (void*) batch->extents;
+    size_t buf_sz = (size_t)batch->num_extents *
+                    sizeof(unifyfs_inode_extent_t);
+    hg_return_t hret = margo_bulk_create(mid, 1, &buf, &buf_sz,
+                                         HG_BULK_READ_ONLY,
+                                         &(batch->bulk_handle));
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_bulk_create() failed");
+        margo_destroy(preq->handle);
+        preq->handle = HG_HANDLE_NULL;
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    /* fill rpc input struct and forward request */
+    find_extents_in_t in;
+    in.src_rank = (int32_t) glb_pmi_rank;
+    in.num_extents = (int32_t) batch->num_extents;
+    in.extents = batch->bulk_handle;
+    rc = forward_request((void*)&in, preq);
+    if (rc != UNIFYFS_SUCCESS) {
+        margo_bulk_free(batch->bulk_handle);
+        batch->bulk_handle = HG_BULK_NULL;
+        margo_destroy(preq->handle);
+        preq->handle = HG_HANDLE_NULL;
+    }
+    return rc;
+}
+
+/* wait for a forwarded batch of extent lookups, and pull back the
+ * resolved chunk locations */
+static int find_extents_batch_complete(find_extents_batch* batch)
+{
+    p2p_request* preq = &(batch->req);
+    margo_instance_id mid = unifyfsd_rpc_context->svr_mid;
+
+    /* wait for request completion */
+    int ret = wait_for_request(preq);
+    margo_bulk_free(batch->bulk_handle);
+    batch->bulk_handle = HG_BULK_NULL;
+    if (ret != UNIFYFS_SUCCESS) {
+        margo_destroy(preq->handle);
+        return ret;
+    }
+
+    /* get the output of the rpc */
+    find_extents_out_t out;
+    hg_return_t hret = margo_get_output(preq->handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_output() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        /* set return value */
+        ret = out.ret;
+        unsigned int n_chks = (unsigned int) out.num_locations;
+        if ((ret == UNIFYFS_SUCCESS) && (n_chks > 0)) {
+            /* got some chunks to read, allocate a buffer to hold chunk
+             * location data followed by the per-extent chunk counts */
+            size_t chks_sz = (size_t)n_chks * sizeof(chunk_read_req_t);
+            size_t cnts_sz = (size_t)batch->num_extents *
+                             sizeof(*(batch->ext_chunks));
+            size_t buf_sz = chks_sz + cnts_sz;
+            void* buf = malloc(buf_sz);
+            if (NULL == buf) {
+                LOGERR("allocation for bulk locations failed");
+                ret = ENOMEM;
+            } else {
+                /* create a margo bulk transfer handle for
+                 * locations array */
+                hg_bulk_t bulk_resp_handle;
+                hret = margo_bulk_create(mid, 1, &buf, &buf_sz,
+                                         HG_BULK_WRITE_ONLY,
+                                         &bulk_resp_handle);
+                if (hret != HG_SUCCESS) {
+                    LOGERR("margo_bulk_create() failed");
+                    ret = UNIFYFS_ERROR_MARGO;
+                } else {
+                    /* pull locations array */
+                    hret = margo_bulk_transfer(mid, HG_BULK_PULL,
+                                               preq->peer, out.locations, 0,
+                                               bulk_resp_handle, 0,
+                                               buf_sz);
+                    if (hret != HG_SUCCESS) {
+                        LOGERR("margo_bulk_transfer() failed");
+                        ret = UNIFYFS_ERROR_MARGO;
+                    } else {
+                        LOGDBG("received %u chunk locations for %u extents "
+                               "from server %d",
+                               n_chks, batch->num_extents, batch->rank);
+                        memcpy(batch->ext_chunks, (char*)buf + chks_sz,
+                               cnts_sz);
+                        batch->chunks = (chunk_read_req_t*) buf;
+                        batch->num_chunks = n_chks;
+                        buf = NULL;
+                    }
+                    margo_bulk_free(bulk_resp_handle);
+                }
+                if (NULL != buf) {
+                    free(buf);
+                }
+            }
+        }
+        margo_free_output(preq->handle, &out);
+    }
+    margo_destroy(preq->handle);
+
+    return ret;
+}
+
+/* Lookup extent locations, sending a single request to each server */
+static int find_extents_batched(unsigned int num_extents,
+                                unifyfs_inode_extent_t* extents,
+                                unsigned int* ext_chunks,
+                                unsigned int* num_chunks,
+                                chunk_read_req_t** chunks)
+{
+    int ret = UNIFYFS_SUCCESS;
+    unsigned int i, j;
+    unsigned int n_batches = 0;
+    find_extents_batch* batches = NULL;
+
+    /* map each server rank to its batch, and each extent to its server */
+    int* rank_batch = malloc(glb_pmi_size * sizeof(int));
+    int* ext_rank = malloc(num_extents * sizeof(int));
+    unsigned int* ext_start = malloc(num_extents * sizeof(unsigned int));
+    if ((NULL == rank_batch) || (NULL == ext_rank) || (NULL == ext_start)) {
+        LOGERR("failed to allocate memory for extent lookup");
+        ret = ENOMEM;
+        goto out;
+    }
+    for (i = 0; i < (unsigned int)glb_pmi_size; i++) {
+        rank_batch[i] = -1;
+    }
+
+    /* determine target server of each extent, which is ourself if we
+     * own the extent or the file is laminated. reuse the lamination
+     * state for runs of extents from the same file */
+    int last_gfid = -1;
+    int last_laminated = -1;
+    for (i = 0; i < num_extents; i++) {
+        int gfid = extents[i].gfid;
+        if (gfid != last_gfid) {
+            last_gfid = gfid;
+            last_laminated = -1;
+        }
+        int rank = hash_gfid_offset_to_server(gfid, extents[i].offset);
+        if (rank != glb_pmi_rank) {
+            if (last_laminated == -1) {
+                last_laminated = find_extents_is_laminated(gfid);
+            }
+            if (last_laminated) {
+                rank = glb_pmi_rank;
+            }
+        }
+        ext_rank[i] = rank;
+        if (rank_batch[rank] == -1) {
+            rank_batch[rank] = (int) n_batches++;
+        }
+    }
+
+    /* allocate batches, and group the extents by target server */
+    batches = calloc(n_batches, sizeof(*batches));
+    if (NULL == batches) {
+        LOGERR("failed to allocate memory for extent lookup");
+        ret = ENOMEM;
+        goto out;
+    }
+    for (i = 0; i < num_extents; i++) {
+        find_extents_batch* batch = batches + rank_batch[ext_rank[i]];
+        batch->rank = ext_rank[i];
+        batch->num_extents++;
+    }
+    for (j = 0; j < n_batches; j++) {
+        find_extents_batch* batch = batches + j;
+        batch->bulk_handle = HG_BULK_NULL;
+        batch->ext_ndx = calloc(batch->num_extents, sizeof(unsigned int));
+        batch->ext_chunks = calloc(batch->num_extents, sizeof(unsigned int));
+        batch->extents = calloc(batch->num_extents,
+                                sizeof(unifyfs_inode_extent_t));
+        if ((NULL == batch->ext_ndx) || (NULL == batch->ext_chunks) ||
+            (NULL == batch->extents)) {
+            LOGERR("failed to allocate memory for extent lookup");
+            ret = ENOMEM;
+            goto out;
+        }
+        batch->num_extents = 0;
+    }
+    for (i = 0; i < num_extents; i++) {
+        find_extents_batch* batch = batches + rank_batch[ext_rank[i]];
+        batch->ext_ndx[batch->num_extents] = i;
+        batch->extents[batch->num_extents] = extents[i];
+        batch->num_extents++;
+    }
+
+    /* forward all remote lookups first, so they proceed concurrently
+     * with each other and with our local lookups */
+    for (j = 0; j < n_batches; j++) {
+        find_extents_batch* batch = batches + j;
+        if (batch->rank != glb_pmi_rank) {
+            LOGDBG("forwarding %u extent lookups to server %d",
+                   batch->num_extents, batch->rank);
+            batch->ret = find_extents_batch_forward(batch);
+        }
+    }
+    for (j = 0; j < n_batches; j++) {
+        find_extents_batch* batch = batches + j;
+        if (batch->rank == glb_pmi_rank) {
+            batch->ret = unifyfs_readthrough_fill(glb_pmi_rank,
+                                                  batch->num_extents,
+                                                  batch->extents);
+            if (batch->ret == UNIFYFS_SUCCESS) {
+                batch->ret = unifyfs_inode_resolve_extent_chunk_lists(
+                    batch->num_extents, batch->extents, batch->ext_chunks,
+                    &(batch->num_chunks), &(batch->chunks));
+            }
+            if (batch->ret == UNIFYFS_SUCCESS) {
+                batch->ret = unifyfs_readthrough_add_direct(glb_pmi_rank,
+                    batch->num_extents, batch->extents, batch->ext_chunks,
+                    &(batch->num_chunks), &(batch->chunks));
+            }
+            if (batch->ret) {
+                LOGERR("failed to find %u local extents (ret=%d)",
+                       batch->num_extents, batch->ret);
+            }
+        }
+    }
+    for (j = 0; j < n_batches; j++) {
+        find_extents_batch* batch = batches + j;
+        if ((batch->rank != glb_pmi_rank) &&
+            (batch->ret == UNIFYFS_SUCCESS)) {
+            batch->ret = find_extents_batch_complete(batch);
+        }
+        if (batch->ret != UNIFYFS_SUCCESS) {
+            LOGERR("extent lookup on server %d failed (ret=%d)",
+                   batch->rank, batch->ret);
+            ret = batch->ret;
+        }
+    }
+    if (ret != UNIFYFS_SUCCESS) {
+        goto out;
+    }
+
+    /* scatter the per-extent chunk counts back to caller order */
+    unsigned int total = 0;
+    for (j = 0; j < n_batches; j++) {
+        find_extents_batch* batch = batches + j;
+        for (i = 0; i < batch->num_extents; i++) {
+            ext_chunks[batch->ext_ndx[i]] = batch->ext_chunks[i];
+        }
+        total += batch->num_chunks;
+    }
+    for (i = 0; i < num_extents; i++) {
+        ext_start[i] = (i == 0) ? 0 : (ext_start[i - 1] + ext_chunks[i - 1]);
+    }
+
+    if (total > 0) {
+        chunk_read_req_t* out_chunks = calloc(total, sizeof(*out_chunks));
+        if (NULL == out_chunks) {
+            LOGERR("failed to allocate memory for chunk locations");
+            ret = ENOMEM;
+            goto out;
+        }
+
+        /* copy each extent's chunks to its position in caller order */
+        for (j = 0; j < n_batches; j++) {
+            find_extents_batch* batch = batches + j;
+            chunk_read_req_t* src = batch->chunks;
+            for (i = 0; i < batch->num_extents; i++) {
+                unsigned int n = batch->ext_chunks[i];
+                if (n > 0) {
+                    memcpy(out_chunks + ext_start[batch->ext_ndx[i]], src,
+                           n * sizeof(*src));
+                    src += n;
+                }
+            }
+        }
+        *chunks = out_chunks;
+        *num_chunks = total;
+    }
+
+out:
+    if (NULL != batches) {
+        for (j = 0; j < n_batches; j++) {
+            find_extents_batch* batch = batches + j;
+            if (NULL != batch->ext_ndx) {
+                free(batch->ext_ndx);
+            }
+            if (NULL != batch->ext_chunks) {
+                free(batch->ext_chunks);
+            }
+            if (NULL != batch->extents) {
+                free(batch->extents);
+            }
+            if (NULL != batch->chunks) {
+                free(batch->chunks);
+            }
+        }
+        free(batches);
+    }
+    if (NULL != rank_batch) {
+        free(rank_batch);
+    }
+    if (NULL != ext_rank) {
+        free(ext_rank);
+    }
+    if (NULL != ext_start) {
+        free(ext_start);
+    }
+
+    return ret;
+}
+
+/* Lookup extent locations for any number of files */
+int unifyfs_invoke_find_extents_batch_rpc(unsigned int num_extents,
+                                          unifyfs_inode_extent_t* extents,
+                                          unsigned int* ext_chunks,
+                                          unsigned int* num_chunks,
+                                          chunk_read_req_t** chunks)
+{
+    if ((NULL == extents) || (NULL == ext_chunks) ||
+        (NULL == num_chunks) || (NULL == chunks)) {
+        return EINVAL;
+    }
+    *num_chunks = 0;
+    *chunks = NULL;
+    if (num_extents == 0) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    if (!meta_stripe_extents) {
+        return find_extents_batched(num_extents, extents, ext_chunks,
+                                    num_chunks, chunks);
+    }
+
+    /* split the extents at stripe boundaries, so that each piece is
+     * resolved by the server owning its offset range. the chunks of the
+     * pieces of an extent are contiguous and in order, so the chunk count
+     * of each extent is the sum over its pieces */
+    unsigned int i;
+    unsigned int num_pieces = 0;
+    int need_split = 0;
+    for (i = 0; i < num_extents; i++) {
+        if (extents[i].length > 0) {
+            size_t first = extents[i].offset / meta_slice_sz;
+            size_t last = (extents[i].offset + extents[i].length - 1) /
+                          meta_slice_sz;
+            num_pieces += (unsigned int)(last - first + 1);
+            if (last != first) {
+                need_split = 1;
+            }
+        }
+    }
+    if (!need_split) {
+        return find_extents_batched(num_extents, extents, ext_chunks,
+                                    num_chunks, chunks);
+    }
+
+    unifyfs_inode_extent_t* pieces = calloc(num_pieces, sizeof(*pieces));
+    unsigned int* piece_chunks = calloc(num_pieces, sizeof(unsigned int));
+    if ((NULL == pieces) || (NULL == piece_chunks)) {
+        LOGERR("failed to allocate memory for extent lookup");
+        free(pieces);
+        free(piece_chunks);
+        return ENOMEM;
+    }
+    unsigned int n = 0;
+    for (i = 0; i < num_extents; i++) {
+        size_t pos = extents[i].offset;
+        size_t end = pos + extents[i].length;
+        while (pos < end) {
+            size_t stripe_end = ((pos / meta_slice_sz) + 1) * meta_slice_sz;
+            size_t piece_end = (stripe_end < end) ? stripe_end : end;
+            pieces[n].gfid = extents[i].gfid;
+            pieces[n].offset = pos;
+            pieces[n].length = piece_end - pos;
+            n++;
+            pos = piece_end;
+        }
+    }
+    assert(n == num_pieces);
+
+    int ret = find_extents_batched(num_pieces, pieces, piece_chunks,
+                                   num_chunks, chunks);
+    if (ret == UNIFYFS_SUCCESS) {
+        n = 0;
+        for (i = 0; i < num_extents; i++) {
+            ext_chunks[i] = 0;
+            size_t pos = extents[i].offset;
+            size_t end = pos + extents[i].length;
+            while (pos < end) {
+                ext_chunks[i] += piece_chunks[n];
+                pos += pieces[n].length;
+                n++;
+            }
+        }
+    }
+    free(pieces);
+    free(piece_chunks);
+
+    return ret;
+}
+
+/* Lookup extent locations for target file */
+int unifyfs_invoke_find_extents_rpc(int gfid,
+                                    unsigned int num_extents,
+                                    unifyfs_inode_extent_t* extents,
+                                    unsigned int* num_chunks,
+                                    chunk_read_req_t** chunks)
+{
+    if ((NULL == num_chunks) || (NULL == chunks)) {
+        return EINVAL;
+    }
+    *num_chunks = 0;
+    *chunks = NULL;
+
+    for (unsigned int i = 0; i < num_extents; i++) {
+        if (extents[i].gfid != gfid) {
+            LOGERR("extent %u does not belong to gfid=%d", i, gfid);
+            return EINVAL;
+        }
     }
 
-    /* get the output of the rpc */
-    int ret;
-    add_extents_out_t out;
-    hret = margo_get_output(preq.handle, &out);
-    if (hret != HG_SUCCESS) {
-        LOGERR("margo_get_output() failed");
-        ret = UNIFYFS_ERROR_MARGO;
-    } else {
-        /* set return value */
-        ret = out.ret;
-        margo_free_output(preq.handle, &out);
+    unsigned int* ext_chunks = calloc(num_extents, sizeof(unsigned int));
+    if (NULL == ext_chunks) {
+        return ENOMEM;
+    }
+    int ret = unifyfs_invoke_find_extents_batch_rpc(num_extents, extents,
+                                                    ext_chunks,
+                                                    num_chunks, chunks);
+    free(ext_chunks);
+
+    if ((ret == UNIFYFS_SUCCESS) && (*num_chunks > 0)) {
+        /* sort the chunk locations based on server rank */
+        qsort(*chunks, *num_chunks, sizeof(chunk_read_req_t),
+              compare_chunk_read_reqs);
     }
-    margo_destroy(preq.handle);
 
     return ret;
 }
 
 /*************************************************************************
- * File extents metadata lookup request
+ * Read-through block fetch request
  *************************************************************************/
 
-/* find extents rpc handler */
-static void find_extents_rpc(hg_handle_t handle)
+/* Read-through fetch rpc handler, runs in the i/o pool */
+static void readthrough_fetch_rpc(hg_handle_t handle)
 {
-    LOGDBG("find_extents rpc handler");
+    LOGDBG("readthrough_fetch rpc handler");
 
     int32_t ret;
-    unsigned int num_chunks = 0;
-    chunk_read_req_t* chunk_locs = NULL;
-
-    const struct hg_info* hgi = margo_get_info(handle);
-    assert(hgi);
-
-    margo_instance_id mid = margo_hg_info_get_instance(hgi);
-    assert(mid != MARGO_INSTANCE_NULL);
+    size_t log_offset = 0;
+    int client_id = 0;
+    uint64_t log_epoch = 0;
 
     /* get input params */
-    find_extents_in_t in;
+    readthrough_fetch_in_t in;
     hg_return_t hret = margo_get_input(handle, &in);
     if (hret != HG_SUCCESS) {
         LOGERR("margo_get_input() failed");
         ret = UNIFYFS_ERROR_MARGO;
     } else {
-        int sender = in.src_rank;
-        int gfid = in.gfid;
-        size_t num_extents = (size_t) in.num_extents;
-        size_t bulk_sz = num_extents * sizeof(unifyfs_inode_extent_t);
-
-        /* make sure I'm the owner */
-        assert(glb_pmi_rank == hash_gfid_to_server(gfid));
-
-        /* allocate memory for extents */
-        void* extents_buf = malloc(bulk_sz);
-        if (NULL == extents_buf) {
-            LOGERR("allocation for bulk extents failed");
-            ret = ENOMEM;
-        } else {
-            /* register local target buffer for bulk access */
-            hg_bulk_t bulk_req_handle;
-            hret = margo_bulk_create(mid, 1, &extents_buf, &bulk_sz,
-                                     HG_BULK_WRITE_ONLY, &bulk_req_handle);
-            if (hret != HG_SUCCESS) {
-                LOGERR("margo_bulk_create() failed");
-                ret = UNIFYFS_ERROR_MARGO;
-            } else {
-                /* get list of read requests */
-                hret = margo_bulk_transfer(mid, HG_BULK_PULL,
-                                           hgi->addr, in.extents, 0,
-                                           bulk_req_handle, 0,
-                                           bulk_sz);
-                if (hret != HG_SUCCESS) {
-                    LOGERR("margo_bulk_transfer() failed");
-                    ret = UNIFYFS_ERROR_MARGO;
-                } else {
-                    /* lookup requested extents */
-                    unifyfs_inode_extent_t* extents = extents_buf;
-                    unsigned int n_ext = (unsigned int) num_extents;
-                    LOGDBG("received %u extent lookups for gfid=%d from %d",
-                           n_ext, gfid, sender);
-                    ret = unifyfs_inode_resolve_extent_chunks(n_ext, extents,
-                                                              &num_chunks,
-                                                              &chunk_locs);
-                    if (ret) {
-                        LOGERR("failed to find extents for %d (ret=%d)",
-                               sender, ret);
-                    } else if (num_chunks == 0) {
-                        LOGDBG("extent lookup found no matching chunks");
-                    }
-                }
-                margo_bulk_free(bulk_req_handle);
-            }
-            free(extents_buf);
-        }
+        ret = unifyfs_readthrough_fetch_block((int) in.gfid,
+                                              (size_t) in.offset,
+                                              (size_t) in.length,
+                                              &log_offset, &client_id,
+                                              &log_epoch);
         margo_free_input(handle, &in);
     }
 
-    /* define a bulk handle to transfer chunk address info */
-    hg_bulk_t bulk_resp_handle = HG_BULK_NULL;
-    if (ret == UNIFYFS_SUCCESS) {
-        if (num_chunks > 0) {
-            void* buf = (void*) chunk_locs;
-            size_t buf_sz = (size_t)num_chunks * sizeof(chunk_read_req_t);
-            hret = margo_bulk_create(mid, 1, &buf, &buf_sz,
-                                     HG_BULK_READ_ONLY, &bulk_resp_handle);
-            if (hret != HG_SUCCESS) {
-                LOGERR("margo_bulk_create() failed");
-                ret = UNIFYFS_ERROR_MARGO;
-            }
-        }
-    }
-
-    /* fill rpc response struct with output values */
-    find_extents_out_t out;
-    out.ret           = ret;
-    out.num_locations = num_chunks;
-    out.locations     = bulk_resp_handle;
+    /* fill output values */
+    readthrough_fetch_out_t out;
+    out.ret = ret;
+    out.log_offset = (hg_size_t) log_offset;
+    out.client_id = (int32_t) client_id;
+    out.log_epoch = log_epoch;
 
     /* send output back to caller */
     hret = margo_respond(handle, &out);
@@ -349,135 +1615,57 @@ static void find_extents_rpc(hg_handle_t handle)
     }
 
     /* free margo resources */
-    if (bulk_resp_handle != HG_BULK_NULL) {
-        margo_bulk_free(bulk_resp_handle);
-    }
     margo_destroy(handle);
 }
-DEFINE_MARGO_RPC_HANDLER(find_extents_rpc)
-
-/* Lookup extent locations for target file */
-int unifyfs_invoke_find_extents_rpc(int gfid,
-                                    unsigned int num_extents,
-                                    unifyfs_inode_extent_t* extents,
-                                    unsigned int* num_chunks,
-                                    chunk_read_req_t** chunks)
+DEFINE_MARGO_RPC_HANDLER(readthrough_fetch_rpc)
+
+/* Read a block of a read-through file into the cache log of a server */
+int unifyfs_invoke_readthrough_fetch_rpc(int holder_rank,
+                                         int gfid,
+                                         size_t offset,
+                                         size_t length,
+                                         size_t* log_offset,
+                                         int* client_id,
+                                         uint64_t* log_epoch)
 {
-    if ((NULL == num_chunks) || (NULL == chunks)) {
-        return EINVAL;
-    }
-    *num_chunks = 0;
-    *chunks = NULL;
-
-    int owner_rank = hash_gfid_to_server(gfid);
-
-    /* do local inode metadata lookup to check for laminated */
-    unifyfs_file_attr_t attrs;
-    int ret = unifyfs_inode_metaget(gfid, &attrs);
-    if (ret == UNIFYFS_SUCCESS) {
-        if (attrs.is_laminated || (owner_rank == glb_pmi_rank)) {
-            /* do local lookup */
-            ret = unifyfs_inode_resolve_extent_chunks(num_extents,
-                                                      extents,
-                                                      num_chunks, chunks);
-            if (ret) {
-                LOGERR("failed to find extents for gfid=%d (ret=%d)",
-                       gfid, ret);
-            } else if (*num_chunks == 0) {
-                LOGDBG("extent lookup found no matching chunks");
-            }
-            return ret;
-        }
-    }
-
-    /* forward request to file owner */
     p2p_request preq;
-    margo_instance_id mid = unifyfsd_rpc_context->svr_mid;
-    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.extent_lookup_id;
-    int rc = get_request_handle(req_hgid, owner_rank, &preq);
+    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.readthrough_fetch_id;
+    int rc = get_request_handle(req_hgid, holder_rank, &preq);
     if (rc != UNIFYFS_SUCCESS) {
         return rc;
     }
 
-    /* create a margo bulk transfer handle for extents array */
-    hg_bulk_t bulk_req_handle;
-    void* buf = (void*) extents;
-    size_t buf_sz = (size_t)num_extents * sizeof(unifyfs_inode_extent_t);
-    hg_return_t hret = margo_bulk_create(mid, 1, &buf, &buf_sz,
-                                         HG_BULK_READ_ONLY, &bulk_req_handle);
-    if (hret != HG_SUCCESS) {
-        LOGERR("margo_bulk_create() failed");
-        return UNIFYFS_ERROR_MARGO;
-    }
-
     /* fill rpc input struct and forward request */
-    find_extents_in_t in;
-    in.src_rank = (int32_t) glb_pmi_rank;
+    readthrough_fetch_in_t in;
     in.gfid = (int32_t) gfid;
-    in.num_extents = (int32_t) num_extents;
-    in.extents = bulk_req_handle;
+    in.offset = (hg_size_t) offset;
+    in.length = (hg_size_t) length;
     rc = forward_request((void*)&in, &preq);
     if (rc != UNIFYFS_SUCCESS) {
+        margo_destroy(preq.handle);
         return rc;
     }
-    margo_bulk_free(bulk_req_handle);
 
     /* wait for request completion */
     rc = wait_for_request(&preq);
     if (rc != UNIFYFS_SUCCESS) {
+        margo_destroy(preq.handle);
         return rc;
     }
 
     /* get the output of the rpc */
-    find_extents_out_t out;
-    hret = margo_get_output(preq.handle, &out);
+    int ret;
+    readthrough_fetch_out_t out;
+    hg_return_t hret = margo_get_output(preq.handle, &out);
     if (hret != HG_SUCCESS) {
         LOGERR("margo_get_output() failed");
         ret = UNIFYFS_ERROR_MARGO;
     } else {
-        /* set return value */
         ret = out.ret;
         if (ret == UNIFYFS_SUCCESS) {
-            /* get number of chunks */
-            unsigned int n_chks = (unsigned int) out.num_locations;
-            if (n_chks > 0) {
-                /* got some chunks to read, allocate a buffer
-                 * to hold chunk location data */
-                buf_sz = (size_t)n_chks * sizeof(chunk_read_req_t);
-                buf = malloc(buf_sz);
-                if (NULL == buf) {
-                    LOGERR("allocation for bulk locations failed");
-                    ret = ENOMEM;
-                } else {
-                    /* create a margo bulk transfer handle for
-                     * locations array */
-                    hg_bulk_t bulk_resp_handle;
-                    hret = margo_bulk_create(mid, 1, &buf, &buf_sz,
-                                             HG_BULK_WRITE_ONLY,
-                                             &bulk_resp_handle);
-                    if (hret != HG_SUCCESS) {
-                        LOGERR("margo_bulk_create() failed");
-                        ret = UNIFYFS_ERROR_MARGO;
-                    } else {
-                        /* pull locations array */
-                        hret = margo_bulk_transfer(mid, HG_BULK_PULL,
-                                                   preq.peer, out.locations, 0,
-                                                   bulk_resp_handle, 0,
-                                                   buf_sz);
-                        if (hret != HG_SUCCESS) {
-                            LOGERR("margo_bulk_transfer() failed");
-                            ret = UNIFYFS_ERROR_MARGO;
-                        } else {
-                            /* lookup requested extents */
-                            LOGDBG("received %u chunk locations for gfid=%d",
-                                   n_chks, gfid);
-                            *chunks = (chunk_read_req_t*) buf;
-                            *num_chunks = (unsigned int) n_chks;
-                        }
-                        margo_bulk_free(bulk_resp_handle);
-                    }
-                }
-            }
+            *log_offset = (size_t) out.log_offset;
+            *client_id = (int) out.client_id;
+            *log_epoch = (uint64_t) out.log_epoch;
         }
         margo_free_output(preq.handle, &out);
     }
@@ -494,6 +1682,7 @@ int unifyfs_invoke_find_extents_rpc(int gfid,
 static void metaget_rpc(hg_handle_t handle)
 {
     LOGDBG("metaget rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
 
@@ -525,6 +1714,8 @@ static void metaget_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_METAGET, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(metaget_rpc)
 
@@ -611,6 +1802,7 @@ int unifyfs_invoke_metaget_rpc(int gfid,
 static void filesize_rpc(hg_handle_t handle)
 {
     LOGDBG("filesize rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
     hg_size_t filesize = 0;
@@ -639,6 +1831,8 @@ static void filesize_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_FILESIZE, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(filesize_rpc)
 
@@ -715,6 +1909,7 @@ int unifyfs_invoke_filesize_rpc(int gfid,
 static void metaset_rpc(hg_handle_t handle)
 {
     LOGDBG("metaset rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
 
@@ -742,6 +1937,8 @@ static void metaset_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_METASET, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(metaset_rpc)
 
@@ -810,10 +2007,82 @@ int unifyfs_invoke_metaset_rpc(int gfid,
  * File lamination request
  *************************************************************************/
 
+/* with striped extents, collect the extents of all offset ranges of
+ * the file from the servers owning them into the local inode, so that
+ * the owner has the complete extent map to broadcast on laminate */
+static int laminate_collect_striped_extents(int gfid)
+{
+    size_t filesize = 0;
+    int ret = unifyfs_inode_get_filesize(gfid, &filesize);
+    if ((ret != UNIFYFS_SUCCESS) || (filesize == 0)) {
+        return ret;
+    }
+
+    unifyfs_inode_extent_t whole;
+    whole.gfid = gfid;
+    whole.offset = 0;
+    whole.length = filesize;
+
+    unsigned int ext_chunks = 0;
+    unsigned int num_chunks = 0;
+    chunk_read_req_t* chunks = NULL;
+    ret = unifyfs_invoke_find_extents_batch_rpc(1, &whole, &ext_chunks,
+                                                &num_chunks, &chunks);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to collect striped extents for gfid=%d", gfid);
+        return ret;
+    }
+    if (num_chunks == 0) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* each chunk location describes one extent */
+    struct extent_tree_node* nodes = calloc(num_chunks, sizeof(*nodes));
+    if (NULL == nodes) {
+        free(chunks);
+        return ENOMEM;
+    }
+    for (unsigned int i = 0; i < num_chunks; i++) {
+        chunk_read_req_t* chk = chunks + i;
+        nodes[i].start = chk->offset;
+        nodes[i].end = chk->offset + chk->nbytes - 1;
+        nodes[i].svr_rank = chk->rank;
+        nodes[i].app_id = chk->log_app_id;
+        nodes[i].cli_id = chk->log_client_id;
+        nodes[i].pos = chk->log_offset;
+        nodes[i].epoch = (unsigned long) chk->log_epoch;
+    }
+    free(chunks);
+
+    LOGDBG("collected %u striped extents for gfid=%d", num_chunks, gfid);
+    ret = unifyfs_inode_add_extents(gfid, (int)num_chunks, nodes);
+    free(nodes);
+
+    return ret;
+}
+
+/* laminate a file we own, and tell the rest of the servers */
+static int laminate_owned_file(int gfid)
+{
+    int ret = UNIFYFS_SUCCESS;
+    if (meta_stripe_extents) {
+        ret = laminate_collect_striped_extents(gfid);
+    }
+    if (ret == UNIFYFS_SUCCESS) {
+        ret = unifyfs_inode_laminate(gfid);
+    }
+    if (ret == UNIFYFS_SUCCESS) {
+        /* tell the rest of the servers */
+        ret = unifyfs_invoke_broadcast_laminate(gfid);
+    }
+    return ret;
+}
+
 /* Laminate rpc handler */
 static void laminate_rpc(hg_handle_t handle)
 {
     LOGDBG("laminate rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
 
@@ -827,11 +2096,7 @@ static void laminate_rpc(hg_handle_t handle)
         int gfid = (int) in.gfid;
         margo_free_input(handle, &in);
 
-        ret = unifyfs_inode_laminate(gfid);
-        if (ret == UNIFYFS_SUCCESS) {
-            /* tell the rest of the servers */
-            ret = unifyfs_invoke_broadcast_laminate(gfid);
-        }
+        ret = laminate_owned_file(gfid);
     }
 
     /* build our output values */
@@ -846,6 +2111,8 @@ static void laminate_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_LAMINATE, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(laminate_rpc)
 
@@ -856,12 +2123,7 @@ int unifyfs_invoke_laminate_rpc(int gfid)
     int owner_rank = hash_gfid_to_server(gfid);
     if (owner_rank == glb_pmi_rank) {
         /* I'm the owner, do local inode metadata update */
-        ret = unifyfs_inode_laminate(gfid);
-        if (ret == UNIFYFS_SUCCESS) {
-            /* tell the rest of the servers */
-            ret = unifyfs_invoke_broadcast_laminate(gfid);
-        }
-        return ret;
+        return laminate_owned_file(gfid);
     }
 
     /* forward request to file owner */
@@ -910,6 +2172,7 @@ int unifyfs_invoke_laminate_rpc(int gfid)
 static void truncate_rpc(hg_handle_t handle)
 {
     LOGDBG("truncate rpc handler");
+    uint64_t start = unifyfs_stats_start();
 
     int32_t ret;
 
@@ -942,6 +2205,8 @@ static void truncate_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_P2P_TRUNCATE, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(truncate_rpc)
 
@@ -995,3 +2260,158 @@ int unifyfs_invoke_truncate_rpc(int gfid,
 
     return ret;
 }
+
+/*************************************************************************
+ * Server statistics request
+ *************************************************************************/
+
+/* Server statistics rpc handler */
+static void server_stats_rpc(hg_handle_t handle)
+{
+    LOGDBG("server stats rpc handler");
+
+    int32_t ret;
+    char* json = NULL;
+
+    /* get input params */
+    server_stats_in_t in;
+    hg_return_t hret = margo_get_input(handle, &in);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_get_input() failed");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        ret = unifyfs_stats_to_json(&json);
+        margo_free_input(handle, &in);
+    }
+
+    /* build our output values */
+    server_stats_out_t out;
+    out.ret = ret;
+    out.json = (NULL != json) ? json : "";
+
+    /* send output back to caller */
+    hret = margo_respond(handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* free margo resources */
+    margo_destroy(handle);
+    if (NULL != json) {
+        free(json);
+    }
+}
+DEFINE_MARGO_RPC_HANDLER(server_stats_rpc)
+
+/* get the JSON statistics from a completed server stats request */
+static int server_stats_result(p2p_request* req, char** json)
+{
+    int ret = wait_for_request(req);
+    if (ret == UNIFYFS_SUCCESS) {
+        server_stats_out_t out;
+        hg_return_t hret = margo_get_output(req->handle, &out);
+        if (hret != HG_SUCCESS) {
+            LOGERR("margo_get_output() failed");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            ret = out.ret;
+            if ((ret == UNIFYFS_SUCCESS) && (NULL != out.json)) {
+                *json = strdup(out.json);
+                if (NULL == *json) {
+                    ret = ENOMEM;
+                }
+            }
+            margo_free_output(req->handle, &out);
+        }
+    }
+    margo_destroy(req->handle);
+    return ret;
+}
+
+/* Get server statistics, from all servers if all is set */
+int unifyfs_invoke_server_stats_rpc(int all, char** json)
+{
+    if (NULL == json) {
+        return EINVAL;
+    }
+    if (!all || (glb_pmi_size == 1)) {
+        return unifyfs_stats_to_json(json);
+    }
+
+    int num_servers = glb_pmi_size;
+    p2p_request* reqs = calloc(num_servers, sizeof(p2p_request));
+    int* req_rc = calloc(num_servers, sizeof(int));
+    char** results = calloc(num_servers, sizeof(char*));
+    if ((NULL == reqs) || (NULL == req_rc) || (NULL == results)) {
+        free(reqs);
+        free(req_rc);
+        free(results);
+        return ENOMEM;
+    }
+
+    /* send requests to all other servers before gathering our own
+     * statistics, so the servers build their snapshots concurrently */
+    hg_id_t req_hgid = unifyfsd_rpc_context->rpcs.server_stats_id;
+    server_stats_in_t in;
+    in.src_rank = (int32_t) glb_pmi_rank;
+    for (int i = 0; i < num_servers; i++) {
+        if (i == glb_pmi_rank) {
+            continue;
+        }
+        req_rc[i] = get_request_handle(req_hgid, i, reqs + i);
+        if (req_rc[i] == UNIFYFS_SUCCESS) {
+            req_rc[i] = forward_request((void*)&in, reqs + i);
+            if (req_rc[i] != UNIFYFS_SUCCESS) {
+                margo_destroy(reqs[i].handle);
+            }
+        }
+    }
+
+    req_rc[glb_pmi_rank] = unifyfs_stats_to_json(results + glb_pmi_rank);
+
+    for (int i = 0; i < num_servers; i++) {
+        if ((i != glb_pmi_rank) && (req_rc[i] == UNIFYFS_SUCCESS)) {
+            req_rc[i] = server_stats_result(reqs + i, results + i);
+        }
+    }
+
+    /* combine the server statistics in rank order, reporting the
+     * error for servers that did not respond */
+    int ret = UNIFYFS_SUCCESS;
+    char* buf = NULL;
+    size_t bufsz = 0;
+    FILE* fp = open_memstream(&buf, &bufsz);
+    if (NULL == fp) {
+        ret = ENOMEM;
+    } else {
+        fprintf(fp, "{\"servers\":[");
+        for (int i = 0; i < num_servers; i++) {
+            if (i) {
+                fprintf(fp, ",");
+            }
+            if ((req_rc[i] == UNIFYFS_SUCCESS) && (NULL != results[i])) {
+                fprintf(fp, "%s", results[i]);
+            } else {
+                LOGWARN("failed to get stats of server %d (ret=%d)",
+                        i, req_rc[i]);
+                fprintf(fp, "{\"rank\":%d,\"error\":%d}", i, req_rc[i]);
+            }
+        }
+        fprintf(fp, "]}");
+        if (fclose(fp) != 0) {
+            ret = ENOMEM;
+            free(buf);
+        } else {
+            *json = buf;
+        }
+    }
+
+    for (int i = 0; i < num_servers; i++) {
+        free(results[i]);
+    }
+    free(results);
+    free(req_rc);
+    free(reqs);
+
+    return ret;
+}
@@ -23,9 +23,20 @@
 /* Point-to-point Server RPCs */
 
 
+/* when set, file extent metadata is partitioned across servers by
+ * offset ranges of meta_slice_sz bytes (see meta.stripe_extents) */
+extern bool meta_stripe_extents;
+
+/* read point-to-point rpc settings from server configuration */
+int unifyfs_p2p_rpc_init(unifyfs_cfg_t* cfg);
+
 /* determine server responsible for maintaining target file's metadata */
 int hash_gfid_to_server(int gfid);
 
+/* determine server responsible for maintaining target file's extent
+ * metadata at the given file offset */
+int hash_gfid_offset_to_server(int gfid, size_t offset);
+
 
 /**
  * @brief Add new extents to target file
@@ -40,6 +51,22 @@ int unifyfs_invoke_add_extents_rpc(int gfid,
                                    unsigned int num_extents,
                                    struct extent_tree_node* extents);
 
+/**
+ * @brief Move the log data of extents of target file at its owner,
+ * as done when compacting a client log
+ *
+ * @param gfid         target file
+ * @param num_extents  length of file extents arrays
+ * @param old_extents  extents with current log offsets of the data
+ * @param new_extents  the same extents with new log offsets
+ *
+ * @return success|failure, EBUSY if the owner could not move some data
+ */
+int unifyfs_invoke_relocate_extents_rpc(int gfid,
+                                        unsigned int num_extents,
+                                        struct extent_tree_node* old_extents,
+                                        struct extent_tree_node* new_extents);
+
 /**
  * @brief Find location of extents for target file
  *
@@ -48,7 +75,8 @@ int unifyfs_invoke_add_extents_rpc(int gfid,
  * @param extents      array of extents to find
  *
  * @param[out] num_chunks  number of chunk locations
- * @param[out] chunks      array of chunk locations for requested extents
+ * @param[out] chunks      array of chunk locations for requested extents,
+ *                         sorted by server rank
  *
  * @return success|failure
  */
@@ -58,6 +86,28 @@ int unifyfs_invoke_find_extents_rpc(int gfid,
                                     unsigned int* num_chunks,
                                     chunk_read_req_t** chunks);
 
+/**
+ * @brief Find location of extents for any number of files. Extents are
+ * grouped by the server that can resolve them, and a single lookup request
+ * is sent to each of those servers concurrently.
+ *
+ * @param num_extents  length of file extents array
+ * @param extents      array of extents to find
+ *
+ * @param[out] ext_chunks  number of chunk locations for each extent
+ *                         (array of length num_extents allocated by caller)
+ * @param[out] num_chunks  total number of chunk locations
+ * @param[out] chunks      array of chunk locations, where the chunks of
+ *                         each extent are contiguous and in extent order
+ *
+ * @return success|failure
+ */
+int unifyfs_invoke_find_extents_batch_rpc(unsigned int num_extents,
+                                          unifyfs_inode_extent_t* extents,
+                                          unsigned int* ext_chunks,
+                                          unsigned int* num_chunks,
+                                          chunk_read_req_t** chunks);
+
 /**
  * @brief Get file size for the target file
  *
@@ -112,5 +162,39 @@ int unifyfs_invoke_metaset_rpc(int gfid, int attr_op,
  */
 int unifyfs_invoke_truncate_rpc(int gfid, size_t filesize);
 
+/**
+ * @brief Get server statistics as JSON
+ *
+ * @param all   if set, get statistics of all servers, otherwise only
+ *              of this server
+ * @param json  set to allocated JSON string, caller should free
+ *
+ * @return success|failure
+ */
+int unifyfs_invoke_server_stats_rpc(int all, char** json);
+
+
+/**
+ * @brief Read a block of a read-through file from its backing file into
+ * the cache log of a server
+ *
+ * @param holder_rank  server whose cache log gets the data
+ * @param gfid         target file
+ * @param offset       file offset of the data
+ * @param length       length of the data
+ *
+ * @param[out] log_offset  offset of the data in the cache log
+ * @param[out] client_id   client id of the cache log on the holder
+ * @param[out] log_epoch   release epoch of the cache log at the write
+ *
+ * @return success|failure, ENOSPC if the cache log is full
+ */
+int unifyfs_invoke_readthrough_fetch_rpc(int holder_rank,
+                                         int gfid,
+                                         size_t offset,
+                                         size_t length,
+                                         size_t* log_offset,
+                                         int* client_id,
+                                         uint64_t* log_epoch);
 
 #endif // UNIFYFS_P2P_RPC_H
@@ -0,0 +1,810 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <fcntl.h>
+
+#include "unifyfs_readthrough.h"
+#include "unifyfs_p2p_rpc.h"
+#include "margo_server.h"
+#include "unifyfs_reclaim.h"
+
+/* a block of a read-through file being fetched by one fill. Other fills
+ * that need the block wait for it instead of reading it again */
+typedef struct readthrough_claim {
+    struct readthrough_claim* next;
+    int gfid;
+    size_t offset;  /* file offset of the block */
+    int done;       /* set once the extents of the block are added */
+    int waiters;    /* number of other fills waiting for the block */
+} readthrough_claim;
+
+/* a read of data in one block of the backing file into the cache log of
+ * the holder server */
+typedef struct {
+    int gfid;
+    int holder;         /* server whose cache log gets the data */
+    size_t offset;      /* file offset */
+    size_t length;
+    size_t log_offset;  /* where the data was written in the cache log */
+    int cli_id;         /* client id of the cache log on the holder */
+    uint64_t log_epoch; /* release epoch of the cache log at the write */
+    int ret;
+} readthrough_task;
+
+static struct {
+    unifyfs_cfg_t* cfg;         /* server configuration, for the cache log */
+    ABT_mutex sync;             /* protects claims and extent updates */
+    ABT_cond claim_done;        /* signals fetches of claimed blocks */
+    readthrough_claim* claims;  /* blocks being fetched */
+    ABT_mutex log_sync;         /* protects cache log allocation */
+    app_client* cache;          /* server-owned client holding the log */
+} readthrough;
+
+int unifyfs_readthrough_init(unifyfs_cfg_t* cfg)
+{
+    readthrough.cfg = cfg;
+    readthrough.cache = NULL;
+    readthrough.claims = NULL;
+    if ((ABT_mutex_create(&(readthrough.sync)) != ABT_SUCCESS) ||
+        (ABT_mutex_create(&(readthrough.log_sync)) != ABT_SUCCESS) ||
+        (ABT_cond_create(&(readthrough.claim_done)) != ABT_SUCCESS)) {
+        LOGERR("failed to create read-through mutexes");
+        return UNIFYFS_FAILURE;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+void unifyfs_readthrough_fini(void)
+{
+    /* the log itself is closed along with the other application clients,
+     * but nobody else will unlink its shared memory */
+    app_client* cache = readthrough.cache;
+    if ((NULL != cache) && (NULL != cache->logio) &&
+        (NULL != cache->logio->shmem)) {
+        unifyfs_shm_unlink(cache->logio->shmem);
+    }
+}
+
+/* get the client holding the cache log, creating it on first use.
+ * assumes caller holds the cache log mutex */
+static app_client* readthrough_cache(void)
+{
+    if (NULL == readthrough.cache) {
+        app_config* app = get_application(UNIFYFS_READTHROUGH_APP_ID);
+        if (NULL == app) {
+            app = new_application(UNIFYFS_READTHROUGH_APP_ID);
+        }
+        if (NULL != app) {
+            readthrough.cache = new_server_app_client(app, readthrough.cfg);
+        }
+        if (NULL == readthrough.cache) {
+            LOGERR("failed to create read-through cache log");
+        } else {
+            LOGINFO("created read-through cache log (client %d:%d)",
+                    readthrough.cache->app_id,
+                    readthrough.cache->client_id);
+        }
+    }
+    return readthrough.cache;
+}
+
+int unifyfs_readthrough_register(unifyfs_file_attr_t* attr,
+                                 const char* backing_file)
+{
+    int gfid = attr->gfid;
+
+    attr->is_laminated = 1;
+    int ret = unifyfs_inode_create_backed(gfid, attr, backing_file);
+    if (ret == EEXIST) {
+        /* registering the same backing file again is not an error */
+        char* existing = NULL;
+        if ((UNIFYFS_SUCCESS ==
+             unifyfs_inode_get_backing_path(gfid, &existing)) &&
+            (NULL != existing) && (0 == strcmp(existing, backing_file))) {
+            ret = UNIFYFS_SUCCESS;
+        }
+        free(existing);
+    }
+
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to register read-through file %s (gfid=%d) - %s",
+               attr->filename, gfid, unifyfs_rc_enum_description(ret));
+    } else {
+        LOGDBG("registered read-through file %s (gfid=%d, size=%zu) from %s",
+               attr->filename, gfid, (size_t) attr->size, backing_file);
+    }
+    return ret;
+}
+
+int unifyfs_readthrough_is_backed(int gfid)
+{
+    char* backing_file = NULL;
+    int rc = unifyfs_inode_get_backing_path(gfid, &backing_file);
+    if ((rc != UNIFYFS_SUCCESS) || (NULL == backing_file)) {
+        return 0;
+    }
+    free(backing_file);
+    return 1;
+}
+
+/* get the backing file and size of gfid, the backing file is NULL if gfid
+ * is not a read-through file */
+static void readthrough_lookup(int gfid,
+                               char** backing_file,
+                               size_t* file_size)
+{
+    unifyfs_file_attr_t attr;
+
+    *backing_file = NULL;
+    *file_size = 0;
+    if ((UNIFYFS_SUCCESS ==
+         unifyfs_inode_get_backing_path(gfid, backing_file)) &&
+        (NULL != *backing_file) &&
+        (UNIFYFS_SUCCESS == unifyfs_inode_metaget(gfid, &attr))) {
+        *file_size = (size_t) attr.size;
+    }
+}
+
+/* read count bytes at offset of the backing file into buf, zero filling
+ * past the end of the file */
+static int pread_backing(const char* backing_file,
+                         char* buf,
+                         size_t count,
+                         off_t offset)
+{
+    int fd = open(backing_file, O_RDONLY);
+    if (fd < 0) {
+        int err = errno;
+        LOGERR("failed to open read-through backing file %s - %s",
+               backing_file, strerror(err));
+        return err;
+    }
+
+    int ret = UNIFYFS_SUCCESS;
+    while (count > 0) {
+        ssize_t n = pread(fd, buf, count, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ret = errno;
+            LOGERR("failed to read %s (off=%zu, len=%zu) - %s",
+                   backing_file, (size_t) offset, count, strerror(ret));
+            break;
+        }
+        if (n == 0) {
+            LOGWARN("backing file is shorter than registered size "
+                    "(offset=%zu)", (size_t) offset);
+            memset(buf, 0, count);
+            break;
+        }
+        buf += n;
+        count -= (size_t) n;
+        offset += (off_t) n;
+    }
+    close(fd);
+
+    return ret;
+}
+
+int unifyfs_readthrough_fetch_block(int gfid,
+                                    size_t offset,
+                                    size_t length,
+                                    size_t* log_offset,
+                                    int* client_id,
+                                    uint64_t* log_epoch)
+{
+    char* backing_file = NULL;
+    int ret = unifyfs_inode_get_backing_path(gfid, &backing_file);
+    if ((ret != UNIFYFS_SUCCESS) || (NULL == backing_file)) {
+        LOGERR("gfid=%d is not a read-through file", gfid);
+        return (ret != UNIFYFS_SUCCESS) ? ret : EINVAL;
+    }
+
+    /* reserve log space first, so a full log costs no read */
+    off_t log_off = 0;
+    ABT_mutex_lock(readthrough.log_sync);
+    app_client* cache = readthrough_cache();
+    if ((NULL == cache) || (NULL == cache->logio)) {
+        ret = UNIFYFS_FAILURE;
+    } else {
+        ret = unifyfs_logio_alloc(cache->logio, length, &log_off);
+    }
+    ABT_mutex_unlock(readthrough.log_sync);
+    if (ret == ENOSPC) {
+        LOGDBG("read-through cache log is full");
+        free(backing_file);
+        return ret;
+    } else if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to allocate %zu bytes of read-through cache log - %s",
+               length, unifyfs_rc_enum_description(ret));
+        free(backing_file);
+        return ret;
+    }
+
+    char* buf = malloc(length);
+    if (NULL == buf) {
+        ret = ENOMEM;
+    } else {
+        ret = pread_backing(backing_file, buf, length, (off_t) offset);
+    }
+    if (ret == UNIFYFS_SUCCESS) {
+        size_t nwrite = 0;
+        ret = unifyfs_logio_write(cache->logio, log_off, length, buf,
+                                  &nwrite);
+        if ((ret == UNIFYFS_SUCCESS) && (nwrite != length)) {
+            ret = EIO;
+        }
+        if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("failed to write read-through cache log - %s",
+                   unifyfs_rc_enum_description(ret));
+        }
+    }
+    if (ret != UNIFYFS_SUCCESS) {
+        ABT_mutex_lock(readthrough.log_sync);
+        unifyfs_logio_free(cache->logio, log_off, length);
+        ABT_mutex_unlock(readthrough.log_sync);
+    } else {
+        *log_offset = (size_t) log_off;
+        *client_id = cache->client_id;
+        *log_epoch = unifyfs_reclaim_epoch(cache);
+        LOGDBG("read %zu bytes of gfid=%d at offset %zu from %s",
+               length, gfid, offset, backing_file);
+    }
+    free(buf);
+    free(backing_file);
+
+    return ret;
+}
+
+/* fetch a block into the cache log of its holder, for ABT_thread_create */
+static void readthrough_task_run(void* arg)
+{
+    readthrough_task* task = (readthrough_task*) arg;
+    if (task->holder == glb_pmi_rank) {
+        task->ret = unifyfs_readthrough_fetch_block(task->gfid,
+                                                    task->offset,
+                                                    task->length,
+                                                    &(task->log_offset),
+                                                    &(task->cli_id),
+                                                    &(task->log_epoch));
+    } else {
+        task->ret = unifyfs_invoke_readthrough_fetch_rpc(task->holder,
+                                                         task->gfid,
+                                                         task->offset,
+                                                         task->length,
+                                                         &(task->log_offset),
+                                                         &(task->cli_id),
+                                                         &(task->log_epoch));
+    }
+}
+
+/* run the fetches concurrently in the i/o pool, so that the calling rpc
+ * handler only yields while the backing file is read */
+static void readthrough_run_tasks(readthrough_task* tasks,
+                                  size_t n_tasks)
+{
+    ABT_pool pool = margo_server_io_pool();
+    ABT_thread* threads = NULL;
+    if (ABT_POOL_NULL != pool) {
+        threads = calloc(n_tasks, sizeof(ABT_thread));
+    }
+
+    for (size_t i = 0; i < n_tasks; i++) {
+        if ((NULL == threads) ||
+            (ABT_thread_create(pool, readthrough_task_run, tasks + i,
+                               ABT_THREAD_ATTR_NULL, threads + i)
+             != ABT_SUCCESS)) {
+            if (NULL != threads) {
+                threads[i] = ABT_THREAD_NULL;
+            }
+            readthrough_task_run(tasks + i);
+        }
+    }
+
+    if (NULL != threads) {
+        for (size_t i = 0; i < n_tasks; i++) {
+            if (ABT_THREAD_NULL != threads[i]) {
+                /* waits for the fetch to complete */
+                ABT_thread_free(threads + i);
+            }
+        }
+        free(threads);
+    }
+}
+
+/* make room for one more element of elem_sz bytes in the array */
+static int readthrough_grow(void** arr,
+                            size_t* cap,
+                            size_t n,
+                            size_t elem_sz)
+{
+    if (n < *cap) {
+        return UNIFYFS_SUCCESS;
+    }
+    size_t new_cap = (*cap > 0) ? (2 * *cap) : 16;
+    void* tmp = realloc(*arr, new_cap * elem_sz);
+    if (NULL == tmp) {
+        return ENOMEM;
+    }
+    *arr = tmp;
+    *cap = new_cap;
+    return UNIFYFS_SUCCESS;
+}
+
+/* the blocks a fill fetches and the blocks it waits for */
+typedef struct {
+    readthrough_task* tasks;
+    size_t n_tasks;
+    size_t tasks_cap;
+    readthrough_claim** owned;
+    size_t n_owned;
+    size_t owned_cap;
+    readthrough_claim** waits;
+    size_t n_waits;
+    size_t waits_cap;
+} readthrough_plan;
+
+/* add a fetch of [start, end) within the block at block_off to the plan,
+ * claiming the block or waiting for the fill that claimed it.
+ * assumes caller holds the read-through mutex */
+static int readthrough_plan_add(readthrough_plan* plan,
+                                int gfid,
+                                int holder,
+                                size_t block_off,
+                                size_t start,
+                                size_t end)
+{
+    readthrough_claim* claim = readthrough.claims;
+    while ((NULL != claim) &&
+           ((claim->gfid != gfid) || (claim->offset != block_off))) {
+        claim = claim->next;
+    }
+
+    size_t i;
+    if (NULL != claim) {
+        for (i = 0; i < plan->n_owned; i++) {
+            if (plan->owned[i] == claim) {
+                break;
+            }
+        }
+        if (i == plan->n_owned) {
+            /* another fill is fetching the block, wait for it */
+            for (i = 0; i < plan->n_waits; i++) {
+                if (plan->waits[i] == claim) {
+                    return UNIFYFS_SUCCESS;
+                }
+            }
+            if (readthrough_grow((void**) &(plan->waits), &(plan->waits_cap),
+                                 plan->n_waits, sizeof(*(plan->waits)))) {
+                return ENOMEM;
+            }
+            claim->waiters++;
+            plan->waits[plan->n_waits++] = claim;
+            return UNIFYFS_SUCCESS;
+        }
+    } else {
+        if (readthrough_grow((void**) &(plan->owned), &(plan->owned_cap),
+                             plan->n_owned, sizeof(*(plan->owned)))) {
+            return ENOMEM;
+        }
+        claim = calloc(1, sizeof(*claim));
+        if (NULL == claim) {
+            return ENOMEM;
+        }
+        claim->gfid = gfid;
+        claim->offset = block_off;
+        claim->next = readthrough.claims;
+        readthrough.claims = claim;
+        plan->owned[plan->n_owned++] = claim;
+    }
+
+    if (readthrough_grow((void**) &(plan->tasks), &(plan->tasks_cap),
+                         plan->n_tasks, sizeof(*(plan->tasks)))) {
+        return ENOMEM;
+    }
+    readthrough_task* task = plan->tasks + plan->n_tasks++;
+    memset(task, 0, sizeof(*task));
+    task->gfid = gfid;
+    task->holder = holder;
+    task->offset = start;
+    task->length = end - start;
+    return UNIFYFS_SUCCESS;
+}
+
+/* plan fetches of the blocks overlapping the extent that have no data.
+ * assumes caller holds the read-through mutex */
+static int readthrough_plan_extent(readthrough_plan* plan,
+                                   int holder,
+                                   size_t file_size,
+                                   unifyfs_inode_extent_t* extent)
+{
+    int gfid = extent->gfid;
+    size_t start = extent->offset;
+    size_t end = start + extent->length;
+    if (end > file_size) {
+        end = file_size;
+    }
+    if (start >= end) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* fetch whole blocks, within the offset range we own */
+    size_t first = start - (start % UNIFYFS_READTHROUGH_BLOCK_SIZE);
+    size_t last = end + UNIFYFS_READTHROUGH_BLOCK_SIZE - 1;
+    last -= last % UNIFYFS_READTHROUGH_BLOCK_SIZE;
+    if (last > file_size) {
+        last = file_size;
+    }
+    if (meta_stripe_extents) {
+        size_t slice_start = start - (start % meta_slice_sz);
+        size_t slice_end = slice_start + meta_slice_sz;
+        if (first < slice_start) {
+            first = slice_start;
+        }
+        if (last > slice_end) {
+            last = slice_end;
+        }
+    }
+
+    /* find the holes between the data we already have */
+    unifyfs_inode_extent_t range = {
+        .gfid = gfid,
+        .offset = first,
+        .length = last - first
+    };
+    unsigned int n_chunks = 0;
+    chunk_read_req_t* chunks = NULL;
+    int ret = unifyfs_inode_get_extent_chunks(&range, &n_chunks, &chunks);
+    if (ret != UNIFYFS_SUCCESS) {
+        return ret;
+    }
+
+    size_t pos = first;
+    for (unsigned int i = 0; (i <= n_chunks) && (ret == UNIFYFS_SUCCESS);
+         i++) {
+        size_t next = (i < n_chunks) ? chunks[i].offset : last;
+        while ((pos < next) && (ret == UNIFYFS_SUCCESS)) {
+            /* split the hole at block boundaries */
+            size_t block_off = pos - (pos % UNIFYFS_READTHROUGH_BLOCK_SIZE);
+            size_t piece_end = block_off + UNIFYFS_READTHROUGH_BLOCK_SIZE;
+            if (piece_end > next) {
+                piece_end = next;
+            }
+            ret = readthrough_plan_add(plan, gfid, holder, block_off,
+                                       pos, piece_end);
+            pos = piece_end;
+        }
+        if (i < n_chunks) {
+            size_t chunk_end = chunks[i].offset + chunks[i].nbytes;
+            if (chunk_end > pos) {
+                pos = chunk_end;
+            }
+        }
+    }
+    if (NULL != chunks) {
+        free(chunks);
+    }
+
+    return ret;
+}
+
+/* add the extents of the fetched blocks, release the blocks we claimed,
+ * and wait for the blocks claimed by other fills.
+ * assumes caller holds the read-through mutex */
+static int readthrough_plan_finish(readthrough_plan* plan)
+{
+    int ret = UNIFYFS_SUCCESS;
+    size_t i = 0;
+    while (i < plan->n_tasks) {
+        /* add extents of the successful fetches for each run of tasks
+         * of the same file at once */
+        int gfid = plan->tasks[i].gfid;
+        size_t j = i;
+        while ((j < plan->n_tasks) && (plan->tasks[j].gfid == gfid)) {
+            j++;
+        }
+
+        struct extent_tree_node* nodes = calloc(j - i, sizeof(*nodes));
+        if (NULL == nodes) {
+            ret = ENOMEM;
+            break;
+        }
+        int n = 0;
+        for (size_t k = i; k < j; k++) {
+            readthrough_task* task = plan->tasks + k;
+            if (task->ret == ENOSPC) {
+                /* read from the backing file by unifyfs_readthrough_read */
+                LOGDBG("cache log of server %d is full, gfid=%d "
+                       "(off=%zu, len=%zu) is not cached",
+                       task->holder, gfid, task->offset, task->length);
+                continue;
+            } else if (task->ret != UNIFYFS_SUCCESS) {
+                LOGERR("read-through of gfid=%d (off=%zu, len=%zu) "
+                       "on server %d failed", gfid, task->offset,
+                       task->length, task->holder);
+                ret = task->ret;
+                continue;
+            }
+            struct extent_tree_node* node = nodes + n++;
+            node->start    = task->offset;
+            node->end      = task->offset + task->length - 1;
+            node->svr_rank = task->holder;
+            node->app_id   = UNIFYFS_READTHROUGH_APP_ID;
+            node->cli_id   = task->cli_id;
+            node->pos      = (unsigned long) task->log_offset;
+            node->epoch    = (unsigned long) task->log_epoch;
+        }
+        if (n > 0) {
+            int rc = unifyfs_inode_add_extents(gfid, n, nodes);
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to add read-through extents of gfid=%d",
+                       gfid);
+                ret = rc;
+            }
+        }
+        free(nodes);
+        i = j;
+    }
+
+    /* release our claims */
+    for (i = 0; i < plan->n_owned; i++) {
+        readthrough_claim* claim = plan->owned[i];
+        readthrough_claim** prev = &(readthrough.claims);
+        while (*prev != claim) {
+            prev = &((*prev)->next);
+        }
+        *prev = claim->next;
+        claim->done = 1;
+        if (0 == claim->waiters) {
+            free(claim);
+        }
+    }
+    if (plan->n_owned > 0) {
+        ABT_cond_broadcast(readthrough.claim_done);
+    }
+
+    /* the last waiter frees the claim */
+    for (i = 0; i < plan->n_waits; i++) {
+        readthrough_claim* claim = plan->waits[i];
+        while (!claim->done) {
+            ABT_cond_wait(readthrough.claim_done, readthrough.sync);
+        }
+        claim->waiters--;
+        if (0 == claim->waiters) {
+            free(claim);
+        }
+    }
+
+    return ret;
+}
+
+int unifyfs_readthrough_fill(int reader,
+                             unsigned int n_extents,
+                             unifyfs_inode_extent_t* extents)
+{
+    int ret = UNIFYFS_SUCCESS;
+    int last_gfid = -1;
+    char* backing_file = NULL;
+    size_t file_size = 0;
+
+    /* cache the data at the server reading it, so the cache of a file is
+     * spread over the servers of its readers */
+    int holder = ((reader >= 0) && (reader < glb_pmi_size)) ?
+                 reader : glb_pmi_rank;
+
+    readthrough_plan plan;
+    memset(&plan, 0, sizeof(plan));
+
+    ABT_mutex_lock(readthrough.sync);
+    for (unsigned int i = 0; i < n_extents; i++) {
+        int gfid = extents[i].gfid;
+        if (gfid != last_gfid) {
+            /* reuse the lookup for runs of extents from the same file */
+            last_gfid = gfid;
+            free(backing_file);
+            readthrough_lookup(gfid, &backing_file, &file_size);
+        }
+        if ((NULL == backing_file) || (0 == extents[i].length)) {
+            continue;
+        }
+
+        int rc = readthrough_plan_extent(&plan, holder, file_size,
+                                         extents + i);
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("read-through of gfid=%d (off=%lu, len=%lu) failed",
+                   gfid, extents[i].offset, extents[i].length);
+            ret = rc;
+            break;
+        }
+    }
+    free(backing_file);
+    ABT_mutex_unlock(readthrough.sync);
+
+    /* fetch without holding the mutex, so fills of other blocks and
+     * files proceed concurrently */
+    if (plan.n_tasks > 0) {
+        readthrough_run_tasks(plan.tasks, plan.n_tasks);
+    }
+
+    ABT_mutex_lock(readthrough.sync);
+    int rc = readthrough_plan_finish(&plan);
+    ABT_mutex_unlock(readthrough.sync);
+    if (ret == UNIFYFS_SUCCESS) {
+        ret = rc;
+    }
+
+    free(plan.tasks);
+    free(plan.owned);
+    free(plan.waits);
+
+    return ret;
+}
+
+/* find the holes of an extent in [extent offset, end) not covered by its
+ * chunks, storing them as direct reads in holes if not NULL.
+ * returns the number of holes */
+static unsigned int readthrough_holes(int reader,
+                                      unifyfs_inode_extent_t* extent,
+                                      size_t end,
+                                      chunk_read_req_t* chunks,
+                                      unsigned int n_chunks,
+                                      chunk_read_req_t* out)
+{
+    unsigned int n = 0;
+    unsigned int i = 0;
+    size_t pos = extent->offset;
+    while (pos < end) {
+        size_t next = (i < n_chunks) ? chunks[i].offset : end;
+        if (next > end) {
+            next = end;
+        }
+        if (next > pos) {
+            if (NULL != out) {
+                chunk_read_req_t* hole = out + n;
+                memset(hole, 0, sizeof(*hole));
+                hole->gfid          = extent->gfid;
+                hole->offset        = pos;
+                hole->nbytes        = next - pos;
+                hole->log_offset    = pos;
+                hole->log_app_id    = UNIFYFS_READTHROUGH_APP_ID;
+                hole->log_client_id = UNIFYFS_READTHROUGH_DIRECT;
+                hole->rank          = reader;
+            }
+            n++;
+        }
+        if (i == n_chunks) {
+            break;
+        }
+        size_t chunk_end = chunks[i].offset + chunks[i].nbytes;
+        if (chunk_end > pos) {
+            pos = chunk_end;
+        }
+        i++;
+    }
+    return n;
+}
+
+int unifyfs_readthrough_add_direct(int reader,
+                                   unsigned int n_extents,
+                                   unifyfs_inode_extent_t* extents,
+                                   unsigned int* ext_chunks,
+                                   unsigned int* n_chunks,
+                                   chunk_read_req_t** chunks)
+{
+    int last_gfid = -1;
+    char* backing_file = NULL;
+    size_t file_size = 0;
+
+    /* get the end of the data of each extent of a read-through file, or
+     * zero for other files */
+    size_t* ends = calloc(n_extents, sizeof(size_t));
+    if (NULL == ends) {
+        return ENOMEM;
+    }
+    unsigned int n_holes = 0;
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < n_extents; i++) {
+        int gfid = extents[i].gfid;
+        if (gfid != last_gfid) {
+            last_gfid = gfid;
+            free(backing_file);
+            readthrough_lookup(gfid, &backing_file, &file_size);
+        }
+        if (NULL != backing_file) {
+            ends[i] = extents[i].offset + extents[i].length;
+            if (ends[i] > file_size) {
+                ends[i] = file_size;
+            }
+            n_holes += readthrough_holes(reader, extents + i, ends[i],
+                                         *chunks + first, ext_chunks[i],
+                                         NULL);
+        }
+        first += ext_chunks[i];
+    }
+    free(backing_file);
+    if (0 == n_holes) {
+        free(ends);
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* merge the direct reads with the chunks of each extent, in offset
+     * order */
+    unsigned int total = *n_chunks + n_holes;
+    chunk_read_req_t* merged = calloc(total, sizeof(*merged));
+    chunk_read_req_t* holes = calloc(n_holes, sizeof(*holes));
+    if ((NULL == merged) || (NULL == holes)) {
+        free(merged);
+        free(holes);
+        free(ends);
+        return ENOMEM;
+    }
+    chunk_read_req_t* src = *chunks;
+    chunk_read_req_t* dst = merged;
+    for (unsigned int i = 0; i < n_extents; i++) {
+        unsigned int n_src = ext_chunks[i];
+        unsigned int n_ext_holes = 0;
+        if (ends[i] > 0) {
+            n_ext_holes = readthrough_holes(reader, extents + i, ends[i],
+                                            src, n_src, holes);
+        }
+        unsigned int s = 0;
+        unsigned int h = 0;
+        while ((s < n_src) || (h < n_ext_holes)) {
+            if ((h == n_ext_holes) ||
+                ((s < n_src) && (src[s].offset < holes[h].offset))) {
+                *dst++ = src[s++];
+            } else {
+                *dst++ = holes[h++];
+            }
+        }
+        ext_chunks[i] = n_src + n_ext_holes;
+        src += n_src;
+    }
+    LOGDBG("reading %u uncached read-through ranges from backing files",
+           n_holes);
+
+    free(holes);
+    free(ends);
+    free(*chunks);
+    *chunks = merged;
+    *n_chunks = total;
+
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_readthrough_is_direct(chunk_read_req_t* rreq)
+{
+    return ((rreq->log_app_id == UNIFYFS_READTHROUGH_APP_ID) &&
+            (rreq->log_client_id == UNIFYFS_READTHROUGH_DIRECT));
+}
+
+ssize_t unifyfs_readthrough_read(chunk_read_req_t* rreq,
+                                 char* buf)
+{
+    char* backing_file = NULL;
+    int ret = unifyfs_inode_get_backing_path(rreq->gfid, &backing_file);
+    if ((ret != UNIFYFS_SUCCESS) || (NULL == backing_file)) {
+        LOGERR("gfid=%d is not a read-through file", rreq->gfid);
+        return (ssize_t)(-EINVAL);
+    }
+
+    ret = pread_backing(backing_file, buf, rreq->nbytes,
+                        (off_t) rreq->log_offset);
+    free(backing_file);
+    if (ret != UNIFYFS_SUCCESS) {
+        return (ssize_t)(-ret);
+    }
+    return (ssize_t) rreq->nbytes;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_READTHROUGH_H
+#define UNIFYFS_READTHROUGH_H
+
+#include "unifyfs_global.h"
+#include "unifyfs_inode.h"
+
+/*
+ * Read-through stage-in.
+ *
+ * A read-through file is a laminated file registered on every server with
+ * the path of a backing file in a file system that all servers can read,
+ * without copying any of its data. Extent lookups for a read-through file
+ * are sent to the server owning the offset range, as for files that are
+ * not laminated. When that server finds blocks of the range with no data,
+ * it has the server of the reader read them from the backing file into a
+ * log of its own, and adds extents for them, so later reads of those
+ * blocks by any client are served from that log like any other file data.
+ * Blocks are fetched concurrently on the servers' i/o threads. Data that
+ * does not fit in the log of the reader's server is read directly from
+ * the backing file instead.
+ */
+
+/* application id of the server-owned log caching read-through data */
+#define UNIFYFS_READTHROUGH_APP_ID (-1)
+
+/* log client id of chunks read directly from the backing file, whose log
+ * offset is the file offset */
+#define UNIFYFS_READTHROUGH_DIRECT (-1)
+
+/* set up read-through state, the cache log is created on first use */
+int unifyfs_readthrough_init(unifyfs_cfg_t* cfg);
+
+/* remove the shared memory of the cache log */
+void unifyfs_readthrough_fini(void);
+
+/* create the inode of a read-through file with the given attributes,
+ * whose data is read from backing_file */
+int unifyfs_readthrough_register(unifyfs_file_attr_t* attr,
+                                 const char* backing_file);
+
+/* return nonzero if gfid is a read-through file */
+int unifyfs_readthrough_is_backed(int gfid);
+
+/* fetch the blocks of any read-through files covered by the extents that
+ * have no data yet into the cache log of the reader server, and add
+ * their extents. Blocks that do not fit in the cache log are left
+ * without data */
+int unifyfs_readthrough_fill(int reader,
+                             unsigned int n_extents,
+                             unifyfs_inode_extent_t* extents);
+
+/* read length bytes at offset of read-through file gfid into our cache
+ * log, returning where they were written and the release epoch of the
+ * log at that time. Returns ENOSPC if the log is full */
+int unifyfs_readthrough_fetch_block(int gfid,
+                                    size_t offset,
+                                    size_t length,
+                                    size_t* log_offset,
+                                    int* client_id,
+                                    uint64_t* log_epoch);
+
+/* add chunks that the reader server reads directly from the backing file
+ * for the ranges of read-through extents that have no data, updating the
+ * chunk count of each extent and the chunk array */
+int unifyfs_readthrough_add_direct(int reader,
+                                   unsigned int n_extents,
+                                   unifyfs_inode_extent_t* extents,
+                                   unsigned int* ext_chunks,
+                                   unsigned int* n_chunks,
+                                   chunk_read_req_t** chunks);
+
+/* return nonzero if the chunk is read directly from a backing file */
+int unifyfs_readthrough_is_direct(chunk_read_req_t* rreq);
+
+/* read a direct chunk from its backing file into buf, returns the number
+ * of bytes read or a negative error code */
+ssize_t unifyfs_readthrough_read(chunk_read_req_t* rreq,
+                                 char* buf);
+
+#endif /* UNIFYFS_READTHROUGH_H */
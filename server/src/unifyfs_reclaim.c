@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "extent_tree.h"
+#include "unifyfs_reclaim.h"
+
+/* reclaim state for a client log */
+typedef struct log_reclaim {
+    pthread_mutex_t lock;
+    size_t n_chunks;         /* number of chunks in client log */
+    size_t chunk_sz;         /* size of a log chunk */
+    size_t* live;            /* referenced bytes in each chunk */
+    uint64_t* dead_since;    /* time chunk became unreferenced, or 0 */
+    uint64_t* released;      /* release epoch of last release of chunk */
+    uint64_t epoch;          /* release epoch, counts release batches */
+    size_t dead_chunks;      /* unreferenced chunks not yet released */
+    int* gfids;              /* sorted ids of files with synced data */
+    size_t n_gfids;          /* number of file ids */
+    size_t max_gfids;        /* capacity of gfids array */
+    size_t reclaimed_bytes;  /* bytes released to client */
+    int active_reads;        /* reads of client log in progress */
+    uint64_t reads_since;    /* time reads last became active */
+    size_t compacted_bytes;  /* bytes moved by log compaction */
+    uint64_t compact_usecs;  /* time spent compacting log */
+    uint64_t ref_updates;    /* count of reference updates */
+    uint64_t compact_idle;   /* ref_updates at last compaction that moved
+                              * nothing, or 0 */
+} log_reclaim;
+
+static int reclaim_enabled;       // = 0
+static uint64_t reclaim_delay_us; // = 0
+
+/* held shared while using the reclaim state of a client, and exclusive
+ * to free it, since extent tree callbacks for a client's data can run on
+ * any thread while the client detaches */
+static pthread_rwlock_t reclaim_detach_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* get the reclaim state of a client, or NULL. When not NULL, the state
+ * stays valid until reclaim_put() */
+static log_reclaim* reclaim_get(app_client* client)
+{
+    if (NULL == client) {
+        return NULL;
+    }
+    pthread_rwlock_rdlock(&reclaim_detach_lock);
+    log_reclaim* rec = client->reclaim;
+    if (NULL == rec) {
+        pthread_rwlock_unlock(&reclaim_detach_lock);
+    }
+    return rec;
+}
+
+static void reclaim_put(log_reclaim* rec)
+{
+    if (NULL != rec) {
+        pthread_rwlock_unlock(&reclaim_detach_lock);
+    }
+}
+
+/* get current time in usecs */
+static inline uint64_t reclaim_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000ULL) + ((uint64_t)ts.tv_nsec / 1000);
+}
+
+/* extent tree callback to count references to log data of local clients */
+static void reclaim_extent_ref(int svr_rank,
+                               int app_id,
+                               int cli_id,
+                               unsigned long pos,
+                               unsigned long length,
+                               int added)
+{
+    if (svr_rank != glb_pmi_rank) {
+        /* data is in the log of another server's client */
+        return;
+    }
+
+    app_client* client = get_app_client(app_id, cli_id);
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+    if (NULL == client->logio) {
+        reclaim_put(rec);
+        return;
+    }
+
+    uint64_t now = reclaim_now();
+    off_t log_off = (off_t) pos;
+    size_t remaining = (size_t) length;
+
+    pthread_mutex_lock(&(rec->lock));
+    rec->ref_updates++;
+    while (remaining > 0) {
+        size_t ndx;
+        off_t chunk_off;
+        int rc = unifyfs_logio_get_chunk(client->logio, log_off,
+                                         &ndx, &chunk_off);
+        if ((rc != UNIFYFS_SUCCESS) || (ndx >= rec->n_chunks)) {
+            LOGWARN("extent data is outside of client %d:%d log "
+                    "(offset=%zu)", app_id, cli_id, (size_t)log_off);
+            break;
+        }
+
+        /* bytes of the data within this chunk */
+        size_t nbytes = rec->chunk_sz - (size_t)(log_off - chunk_off);
+        if (nbytes > remaining) {
+            nbytes = remaining;
+        }
+
+        if (added) {
+            if ((0 == rec->live[ndx]) && (0 != rec->dead_since[ndx])) {
+                /* data referenced again before the chunk was released */
+                rec->dead_since[ndx] = 0;
+                rec->dead_chunks--;
+            }
+            rec->live[ndx] += nbytes;
+        } else if (rec->live[ndx] > 0) {
+            if (rec->live[ndx] > nbytes) {
+                rec->live[ndx] -= nbytes;
+            } else {
+                /* last reference is gone */
+                rec->live[ndx] = 0;
+                rec->dead_since[ndx] = now;
+                rec->dead_chunks++;
+            }
+        }
+
+        log_off += (off_t) nbytes;
+        remaining -= nbytes;
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+int unifyfs_reclaim_init(unifyfs_cfg_t* cfg)
+{
+    bool b;
+    long l;
+
+    reclaim_enabled = 1;
+    if ((NULL != cfg) && (NULL != cfg->logio_reclaim)) {
+        if (0 == configurator_bool_val(cfg->logio_reclaim, &b)) {
+            reclaim_enabled = (int) b;
+        }
+    }
+
+    reclaim_delay_us = UNIFYFS_LOGIO_RECLAIM_DELAY;
+    if ((NULL != cfg) && (NULL != cfg->logio_reclaim_delay)) {
+        if ((0 == configurator_int_val(cfg->logio_reclaim_delay, &l)) &&
+            (l >= 0)) {
+            reclaim_delay_us = (uint64_t) l;
+        }
+    }
+
+    if (reclaim_enabled) {
+        LOGINFO("reclaiming client log space (delay=%" PRIu64 " usec)",
+                reclaim_delay_us);
+        extent_tree_set_ref_callback(reclaim_extent_ref);
+    } else {
+        extent_tree_set_ref_callback(NULL);
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_reclaim_attach(app_client* client)
+{
+    if (NULL == client) {
+        return EINVAL;
+    }
+
+    if (!reclaim_enabled || (NULL == client->logio)) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    size_t n_chunks = 0;
+    size_t chunk_sz = 0;
+    unifyfs_logio_get_chunks(client->logio, &n_chunks, &chunk_sz);
+    if (0 == n_chunks) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    log_reclaim* rec = calloc(1, sizeof(*rec));
+    if (NULL == rec) {
+        return ENOMEM;
+    }
+    rec->live = calloc(n_chunks, sizeof(size_t));
+    rec->dead_since = calloc(n_chunks, sizeof(uint64_t));
+    rec->released = calloc(n_chunks, sizeof(uint64_t));
+    if ((NULL == rec->live) || (NULL == rec->dead_since) ||
+        (NULL == rec->released)) {
+        LOGERR("failed to allocate log reclaim state for %zu chunks",
+               n_chunks);
+        free(rec->live);
+        free(rec->dead_since);
+        free(rec->released);
+        free(rec);
+        return ENOMEM;
+    }
+    rec->n_chunks = n_chunks;
+    rec->chunk_sz = chunk_sz;
+    pthread_mutex_init(&(rec->lock), NULL);
+
+    client->reclaim = rec;
+    return UNIFYFS_SUCCESS;
+}
+
+void unifyfs_reclaim_detach(app_client* client)
+{
+    if ((NULL == client) || (NULL == client->reclaim)) {
+        return;
+    }
+
+    /* wait for anyone using the state */
+    pthread_rwlock_wrlock(&reclaim_detach_lock);
+    log_reclaim* rec = client->reclaim;
+    client->reclaim = NULL;
+    pthread_rwlock_unlock(&reclaim_detach_lock);
+
+    LOGDBG("client %d:%d - reclaimed %zu log bytes",
+           client->app_id, client->client_id, rec->reclaimed_bytes);
+
+    pthread_mutex_destroy(&(rec->lock));
+    free(rec->live);
+    free(rec->dead_since);
+    free(rec->released);
+    free(rec->gfids);
+    free(rec);
+}
+
+/* find the index of gfid in the sorted file ids, or where it belongs,
+ * assumes caller holds the lock */
+static size_t find_gfid(log_reclaim* rec, int gfid)
+{
+    size_t lo = 0;
+    size_t hi = rec->n_gfids;
+    while (lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if (rec->gfids[mid] < gfid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void unifyfs_reclaim_add_file(app_client* client, int gfid)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+    size_t i = find_gfid(rec, gfid);
+    if ((i == rec->n_gfids) || (rec->gfids[i] != gfid)) {
+        if (rec->n_gfids == rec->max_gfids) {
+            size_t max = (rec->max_gfids) ? (2 * rec->max_gfids) : 16;
+            int* gfids = realloc(rec->gfids, max * sizeof(int));
+            if (NULL == gfids) {
+                /* the file's data is just not compacted */
+                pthread_mutex_unlock(&(rec->lock));
+                reclaim_put(rec);
+                return;
+            }
+            rec->gfids = gfids;
+            rec->max_gfids = max;
+        }
+        memmove(rec->gfids + i + 1, rec->gfids + i,
+                (rec->n_gfids - i) * sizeof(int));
+        rec->gfids[i] = gfid;
+        rec->n_gfids++;
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+void unifyfs_reclaim_remove_file(app_client* client, int gfid)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+    size_t i = find_gfid(rec, gfid);
+    if ((i < rec->n_gfids) && (rec->gfids[i] == gfid)) {
+        rec->n_gfids--;
+        memmove(rec->gfids + i, rec->gfids + i + 1,
+                (rec->n_gfids - i) * sizeof(int));
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+int unifyfs_reclaim_get_files(app_client* client,
+                              int** gfids,
+                              size_t* n_gfids)
+{
+    if ((NULL == gfids) || (NULL == n_gfids)) {
+        return EINVAL;
+    }
+
+    *gfids = NULL;
+    *n_gfids = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    int ret = UNIFYFS_SUCCESS;
+    pthread_mutex_lock(&(rec->lock));
+    if (rec->n_gfids > 0) {
+        *gfids = malloc(rec->n_gfids * sizeof(int));
+        if (NULL == *gfids) {
+            ret = ENOMEM;
+        } else {
+            memcpy(*gfids, rec->gfids, rec->n_gfids * sizeof(int));
+            *n_gfids = rec->n_gfids;
+        }
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+    return ret;
+}
+
+void unifyfs_reclaim_read_begin(app_client* client)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+    if (0 == rec->active_reads++) {
+        rec->reads_since = reclaim_now();
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+void unifyfs_reclaim_read_end(app_client* client)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+    if (rec->active_reads > 0) {
+        rec->active_reads--;
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+uint64_t unifyfs_reclaim_epoch(app_client* client)
+{
+    uint64_t epoch = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL != rec) {
+        pthread_mutex_lock(&(rec->lock));
+        epoch = rec->epoch;
+        pthread_mutex_unlock(&(rec->lock));
+        reclaim_put(rec);
+    }
+    return epoch;
+}
+
+int unifyfs_reclaim_check_read(app_client* client,
+                               chunk_read_req_t* req)
+{
+    /* without reclaim, log data is never replaced */
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    /* the data is gone if any of its chunks was released after the
+     * data was synced */
+    int rc = UNIFYFS_SUCCESS;
+    off_t log_off = (off_t) req->log_offset;
+    size_t remaining = req->nbytes;
+    pthread_mutex_lock(&(rec->lock));
+    while ((remaining > 0) && (rc == UNIFYFS_SUCCESS)) {
+        size_t ndx;
+        off_t chunk_off;
+        rc = unifyfs_logio_get_chunk(client->logio, log_off,
+                                     &ndx, &chunk_off);
+        if ((rc != UNIFYFS_SUCCESS) || (ndx >= rec->n_chunks)) {
+            rc = EINVAL;
+            break;
+        }
+        if (rec->released[ndx] > req->log_epoch) {
+            rc = ESTALE;
+            break;
+        }
+        size_t nbytes = rec->chunk_sz - (size_t)(log_off - chunk_off);
+        if (nbytes > remaining) {
+            nbytes = remaining;
+        }
+        log_off += (off_t) nbytes;
+        remaining -= nbytes;
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+
+    if (rc == ESTALE) {
+        LOGWARN("log data of gfid=%d (offset=%zu, len=%zu) in client %d:%d "
+                "log was released since it was synced",
+                req->gfid, req->offset, req->nbytes,
+                req->log_app_id, req->log_client_id);
+    }
+    return rc;
+}
+
+void unifyfs_reclaim_get_counts(app_client* client,
+                                size_t* reclaimable,
+                                size_t* reclaimed)
+{
+    size_t dead = 0;
+    size_t done = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL != rec) {
+        pthread_mutex_lock(&(rec->lock));
+        dead = rec->dead_chunks * rec->chunk_sz;
+        done = rec->reclaimed_bytes;
+        pthread_mutex_unlock(&(rec->lock));
+        reclaim_put(rec);
+    }
+
+    if (NULL != reclaimable) {
+        *reclaimable = dead;
+    }
+    if (NULL != reclaimed) {
+        *reclaimed = done;
+    }
+}
+
+int unifyfs_reclaim_release(app_client* client,
+                            uint64_t* chunks,
+                            size_t max_chunks,
+                            size_t* n_chunks)
+{
+    if ((NULL == client) || (NULL == n_chunks) ||
+        ((max_chunks > 0) && (NULL == chunks))) {
+        return EINVAL;
+    }
+
+    *n_chunks = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+
+    /* a chunk is ready once it has been unreferenced for the delay, unless
+     * reads of the log have been active since before then */
+    uint64_t limit = reclaim_now();
+    if ((rec->active_reads > 0) && (rec->reads_since < limit)) {
+        limit = rec->reads_since;
+    }
+
+    /* chunks released together share the next release epoch, so data
+     * synced before now is known to be gone from them */
+    uint64_t epoch = rec->epoch + 1;
+    size_t count = 0;
+    for (size_t i = 0; (i < rec->n_chunks) && (rec->dead_chunks > 0); i++) {
+        if (count == max_chunks) {
+            break;
+        }
+        uint64_t dead = rec->dead_since[i];
+        if ((0 != dead) && ((dead + reclaim_delay_us) <= limit)) {
+            rec->dead_since[i] = 0;
+            rec->dead_chunks--;
+            rec->reclaimed_bytes += rec->chunk_sz;
+            rec->released[i] = epoch;
+            chunks[count++] = (uint64_t) i;
+        }
+    }
+    if (count > 0) {
+        rec->epoch = epoch;
+    }
+
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+
+    *n_chunks = count;
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_reclaim_get_sparse(app_client* client,
+                               size_t max_live,
+                               uint8_t* sparse,
+                               size_t* n_sparse,
+                               size_t* live_bytes)
+{
+    if ((NULL == client) || (NULL == sparse) ||
+        (NULL == n_sparse) || (NULL == live_bytes)) {
+        return EINVAL;
+    }
+
+    *n_sparse = 0;
+    *live_bytes = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    size_t count = 0;
+    size_t live = 0;
+    pthread_mutex_lock(&(rec->lock));
+    if (rec->compact_idle == rec->ref_updates) {
+        /* nothing has changed since compaction last found nothing to move */
+        pthread_mutex_unlock(&(rec->lock));
+        reclaim_put(rec);
+        return UNIFYFS_SUCCESS;
+    }
+    for (size_t i = 0; i < rec->n_chunks; i++) {
+        size_t n = rec->live[i];
+        sparse[i] = ((n > 0) && (n < max_live));
+        if (sparse[i]) {
+            count++;
+            live += n;
+        }
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+
+    *n_sparse = count;
+    *live_bytes = live;
+    return UNIFYFS_SUCCESS;
+}
+
+void unifyfs_reclaim_unreferenced(app_client* client,
+                                  off_t log_pos,
+                                  size_t length)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    uint64_t now = reclaim_now();
+    off_t log_off = log_pos;
+    size_t remaining = length;
+    pthread_mutex_lock(&(rec->lock));
+    while (remaining > 0) {
+        size_t ndx;
+        off_t chunk_off;
+        int rc = unifyfs_logio_get_chunk(client->logio, log_off,
+                                         &ndx, &chunk_off);
+        if ((rc != UNIFYFS_SUCCESS) || (ndx >= rec->n_chunks)) {
+            break;
+        }
+        if ((0 == rec->live[ndx]) && (0 == rec->dead_since[ndx])) {
+            rec->dead_since[ndx] = now;
+            rec->dead_chunks++;
+        }
+        size_t nbytes = rec->chunk_sz - (size_t)(log_off - chunk_off);
+        if (nbytes > remaining) {
+            nbytes = remaining;
+        }
+        log_off += (off_t) nbytes;
+        remaining -= nbytes;
+    }
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+void unifyfs_reclaim_add_compacted(app_client* client,
+                                   size_t bytes,
+                                   uint64_t usecs)
+{
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL == rec) {
+        return;
+    }
+
+    pthread_mutex_lock(&(rec->lock));
+    rec->compacted_bytes += bytes;
+    rec->compact_usecs += usecs;
+    rec->compact_idle = (0 == bytes) ? rec->ref_updates : 0;
+    pthread_mutex_unlock(&(rec->lock));
+    reclaim_put(rec);
+}
+
+void unifyfs_reclaim_get_compacted(app_client* client,
+                                   size_t* bytes,
+                                   uint64_t* usecs)
+{
+    size_t b = 0;
+    uint64_t us = 0;
+    log_reclaim* rec = reclaim_get(client);
+    if (NULL != rec) {
+        pthread_mutex_lock(&(rec->lock));
+        b = rec->compacted_bytes;
+        us = rec->compact_usecs;
+        pthread_mutex_unlock(&(rec->lock));
+        reclaim_put(rec);
+    }
+
+    if (NULL != bytes) {
+        *bytes = b;
+    }
+    if (NULL != usecs) {
+        *usecs = us;
+    }
+}
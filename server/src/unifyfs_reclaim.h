@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_RECLAIM_H
+#define UNIFYFS_RECLAIM_H
+
+#include "unifyfs_global.h"
+
+/*
+ * Log space reclamation.
+ *
+ * Client write logs are divided into fixed-size chunks, and each write
+ * reserves whole chunks. For each local client, the server counts the
+ * bytes of each log chunk that are referenced by the extents of its
+ * inodes. When the count for a chunk drops to zero because its data was
+ * overwritten, truncated, or unlinked, the chunk becomes reclaimable.
+ * Only the client may release chunks in its log slot map, so reclaimable
+ * chunks are handed back to the client when it asks for them, once they
+ * have been unreferenced for the configured delay and no reads of the
+ * client log that began before then are still in progress. Reads whose
+ * extents were looked up before the data was replaced may still arrive
+ * after the chunk was released and reused. Each batch of released chunks
+ * starts a new release epoch of the client log, and extents record the
+ * epoch at which their data was synced, so a read fails with ESTALE only
+ * if one of its chunks was released after its data was synced. Chunks
+ * referenced when the read began are not released until it ends.
+ */
+
+/* read reclaim settings from server configuration, and start tracking
+ * references to client log data when enabled */
+int unifyfs_reclaim_init(unifyfs_cfg_t* cfg);
+
+/* set up reclaim state for the log of a newly attached client */
+int unifyfs_reclaim_attach(app_client* client);
+
+/* free reclaim state of a client */
+void unifyfs_reclaim_detach(app_client* client);
+
+/* mark the start and end of a read of the client log */
+void unifyfs_reclaim_read_begin(app_client* client);
+void unifyfs_reclaim_read_end(app_client* client);
+
+/* record that the client synced data of the file gfid, or that the
+ * file is gone */
+void unifyfs_reclaim_add_file(app_client* client, int gfid);
+void unifyfs_reclaim_remove_file(app_client* client, int gfid);
+
+/* get an allocated array of the ids of the files the client synced data
+ * of, which the caller must free */
+int unifyfs_reclaim_get_files(app_client* client,
+                              int** gfids,
+                              size_t* n_gfids);
+
+/* get the current release epoch of the client log, recorded in the
+ * extents of data synced from it */
+uint64_t unifyfs_reclaim_epoch(app_client* client);
+
+/* check that the log data of a chunk read still holds the requested file
+ * data, called between unifyfs_reclaim_read_begin() and _end(). Returns
+ * UNIFYFS_SUCCESS, or ESTALE if a chunk holding the data was released
+ * after the data was synced */
+int unifyfs_reclaim_check_read(app_client* client,
+                               chunk_read_req_t* req);
+
+/* get the number of bytes in unreferenced chunks of the client log that
+ * have not yet been released, and the total bytes released to the client */
+void unifyfs_reclaim_get_counts(app_client* client,
+                                size_t* reclaimable,
+                                size_t* reclaimed);
+
+/* get indices of up to max_chunks unreferenced chunks of the client log
+ * that are ready to be released, and mark them as released. Sets
+ * n_chunks to the number of chunk indices returned */
+int unifyfs_reclaim_release(app_client* client,
+                            uint64_t* chunks,
+                            size_t max_chunks,
+                            size_t* n_chunks);
+
+/* mark the chunks of the client log that hold some, but less than
+ * max_live, referenced bytes in the sparse array of per-chunk flags.
+ * Sets n_sparse to the number of such chunks, and live_bytes to the
+ * referenced bytes they hold. No chunks are marked if no references have
+ * changed since compaction last moved nothing */
+int unifyfs_reclaim_get_sparse(app_client* client,
+                               size_t max_live,
+                               uint8_t* sparse,
+                               size_t* n_sparse,
+                               size_t* live_bytes);
+
+/* start the release delay of the chunks holding the given client log
+ * data that are not referenced by any extent, such as compaction space
+ * whose data could not be relocated */
+void unifyfs_reclaim_unreferenced(app_client* client,
+                                  off_t log_pos,
+                                  size_t length);
+
+/* count bytes moved and time spent by compaction of the client log */
+void unifyfs_reclaim_add_compacted(app_client* client,
+                                   size_t bytes,
+                                   uint64_t usecs);
+
+/* get the bytes moved and time spent by compaction of the client log */
+void unifyfs_reclaim_get_compacted(app_client* client,
+                                   size_t* bytes,
+                                   uint64_t* usecs);
+
+#endif /* UNIFYFS_RECLAIM_H */
@@ -34,7 +34,10 @@
 #include "unifyfs_inode_tree.h"
 #include "unifyfs_metadata_mdhim.h"
 #include "unifyfs_request_manager.h"
+#include "unifyfs_compact.h"
+#include "unifyfs_reclaim.h"
 #include "unifyfs_service_manager.h"
+#include "unifyfs_stats.h"
 
 // margo rpcs
 #include "unifyfs_group_rpc.h"
@@ -191,6 +194,7 @@ server_read_req_t* rm_reserve_read_req(reqmgr_thrd_t* thrd_ctrl)
             }
         }
         thrd_ctrl->num_read_reqs++;
+        unifyfs_stats_gauge_add(UNIFYFS_GAUGE_READ_REQS, 1);
         rdreq->in_use = 1;
         LOGDBG("reserved read req %d (active=%d, next=%d)", rdreq->req_ndx,
                thrd_ctrl->num_read_reqs, thrd_ctrl->next_rdreq_ndx);
@@ -221,6 +225,7 @@ static int release_read_req(reqmgr_thrd_t* thrd_ctrl,
         }
         memset((void*)rdreq, 0, sizeof(server_read_req_t));
         thrd_ctrl->num_read_reqs--;
+        unifyfs_stats_gauge_add(UNIFYFS_GAUGE_READ_REQS, -1);
         LOGDBG("after release (active=%d, next=%d)",
                thrd_ctrl->num_read_reqs, thrd_ctrl->next_rdreq_ndx);
         RM_REQ_UNLOCK(thrd_ctrl);
@@ -439,9 +444,12 @@ int rm_submit_read_request(server_read_req_t* req)
     rdreq->chunks = req->chunks;
     rdreq->remote_reads = req->remote_reads;
     rdreq->extent = req->extent;
+    rdreq->trace_id = req->trace_id;
+    rdreq->trace_start = unifyfs_trace_start();
 
     for (i = 0; i < rdreq->num_server_reads; i++) {
         rdreq->remote_reads[i].rdreq_id = rm_req_index;
+        rdreq->remote_reads[i].trace_id = req->trace_id;
     }
 
     rdreq->status = READREQ_READY;
@@ -557,6 +565,8 @@ static int rm_request_remote_chunks(reqmgr_thrd_t* thrd_ctrl)
             debug_print_read_req(req);
             if (req->status == READREQ_READY) {
                 req->status = READREQ_STARTED;
+                unifyfs_trace_end("server_rm_read_queue", req->trace_id,
+                                  req->trace_start);
                 /* iterate over each server we need to send requests to */
                 server_chunk_reads_t* remote_reads;
                 size_t packed_sz;
@@ -811,6 +821,7 @@ int rm_handle_chunk_read_responses(reqmgr_thrd_t* thrd_ctrl,
                server_chunks->rank, num_chks, server_chunks->total_sz);
         responses = server_chunks->resp;
         data_buf = (char*)(responses + num_chks);
+        uint64_t trace_start = unifyfs_trace_start();
 
         for (i = 0; i < num_chks; i++) {
             chunk_read_resp_t* resp = responses + i;
@@ -824,6 +835,8 @@ int rm_handle_chunk_read_responses(reqmgr_thrd_t* thrd_ctrl,
 
             data_buf += processed;
         }
+        unifyfs_trace_end("server_send_to_client", rdreq->trace_id,
+                          trace_start);
 
         /* cleanup */
         free((void*)responses);
@@ -842,6 +855,8 @@ int rm_handle_chunk_read_responses(reqmgr_thrd_t* thrd_ctrl,
         }
         if (completed_remote_reads == rdreq->num_server_reads) {
             rdreq->status = READREQ_COMPLETE;
+            unifyfs_trace_end("server_read", rdreq->trace_id,
+                              rdreq->trace_start);
 
             int app_id = rdreq->app_id;
             int client_id = rdreq->client_id;
@@ -882,9 +897,11 @@ int rm_submit_client_rpc_request(unifyfs_fops_ctx_t* ctx,
     /* get thread control structure */
     reqmgr_thrd_t* reqmgr = client->reqmgr;
     assert(NULL != reqmgr);
+    req->submit_time = unifyfs_trace_start();
     RM_REQ_LOCK(reqmgr);
     arraylist_add(reqmgr->client_reqs, req);
     RM_REQ_UNLOCK(reqmgr);
+    unifyfs_stats_gauge_add(UNIFYFS_GAUGE_CLIENT_REQS, 1);
 
     signal_new_requests(reqmgr);
 
@@ -984,23 +1001,78 @@ static int process_fsync_rpc(reqmgr_thrd_t* reqmgr,
     unifyfs_fsync_in_t* in = req->input;
     assert(in != NULL);
     int gfid = in->gfid;
+    uint64_t trace_id = in->trace_id;
     margo_free_input(req->handle, in);
     free(in);
 
     LOGINFO("syncing gfid=%d", gfid);
 
+    unifyfs_trace_end("server_rm_queue", trace_id, req->submit_time);
+    uint64_t trace_start = unifyfs_trace_start();
+
     unifyfs_fops_ctx_t ctx = {
         .app_id = reqmgr->app_id,
         .client_id = reqmgr->client_id,
+        .trace_id = trace_id,
     };
     ret = unifyfs_fops_fsync(&ctx, gfid);
     if (ret != UNIFYFS_SUCCESS) {
         LOGERR("unifyfs_fops_fsync() failed");
     }
+    unifyfs_trace_end("server_sync", trace_id, trace_start);
+
+    /* report any log space of the client that can now be reclaimed */
+    size_t reclaimable = 0;
+    app_client* client = get_app_client(reqmgr->app_id, reqmgr->client_id);
+    unifyfs_reclaim_get_counts(client, &reclaimable, NULL);
+
+    /* ask the client to reserve space if its log needs compaction */
+    size_t compactable = unifyfs_compact_check(client);
 
     /* send rpc response */
     unifyfs_fsync_out_t out;
     out.ret = (int32_t) ret;
+    out.reclaimable = (hg_size_t) reclaimable;
+    out.compactable = (hg_size_t) compactable;
+    hg_return_t hret = margo_respond(req->handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* cleanup req */
+    margo_destroy(req->handle);
+
+    return ret;
+}
+
+static int process_compact_rpc(reqmgr_thrd_t* reqmgr,
+                               client_rpc_req_t* req)
+{
+    unifyfs_compact_in_t* in = req->input;
+    assert(in != NULL);
+    off_t log_offset = (off_t) in->log_offset;
+    size_t length = (size_t) in->length;
+    margo_free_input(req->handle, in);
+    free(in);
+
+    LOGDBG("compacting log of client %d:%d into [%zu, +%zu)",
+           reqmgr->app_id, reqmgr->client_id, (size_t)log_offset, length);
+
+    size_t used = 0;
+    size_t moved = 0;
+    app_client* client = get_app_client(reqmgr->app_id, reqmgr->client_id);
+    int ret = unifyfs_compact_client(client, log_offset, length,
+                                     &used, &moved);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("log compaction failed for client %d:%d",
+               reqmgr->app_id, reqmgr->client_id);
+    }
+
+    /* send rpc response */
+    unifyfs_compact_out_t out;
+    out.ret = (int32_t) ret;
+    out.used = (hg_size_t) used;
+    out.moved = (hg_size_t) moved;
     hg_return_t hret = margo_respond(req->handle, &out);
     if (hret != HG_SUCCESS) {
         LOGERR("margo_respond() failed");
@@ -1020,19 +1092,25 @@ static int process_laminate_rpc(reqmgr_thrd_t* reqmgr,
     unifyfs_laminate_in_t* in = req->input;
     assert(in != NULL);
     int gfid = in->gfid;
+    uint64_t trace_id = in->trace_id;
     margo_free_input(req->handle, in);
     free(in);
 
     LOGDBG("laminating gfid=%d", gfid);
 
+    unifyfs_trace_end("server_rm_queue", trace_id, req->submit_time);
+    uint64_t trace_start = unifyfs_trace_start();
+
     unifyfs_fops_ctx_t ctx = {
         .app_id = reqmgr->app_id,
         .client_id = reqmgr->client_id,
+        .trace_id = trace_id,
     };
     ret = unifyfs_fops_laminate(&ctx, gfid);
     if (ret != UNIFYFS_SUCCESS) {
         LOGERR("unifyfs_fops_laminate() failed");
     }
+    unifyfs_trace_end("server_laminate", trace_id, trace_start);
 
     /* send rpc response */
     unifyfs_laminate_out_t out;
@@ -1048,6 +1126,73 @@ static int process_laminate_rpc(reqmgr_thrd_t* reqmgr,
     return ret;
 }
 
+static int process_transfer_rpc(reqmgr_thrd_t* reqmgr,
+                                client_rpc_req_t* req)
+{
+    int ret = UNIFYFS_SUCCESS;
+
+    unifyfs_transfer_in_t* in = req->input;
+    assert(in != NULL);
+    int gfid = in->gfid;
+
+    LOGDBG("staging out gfid=%d to %s", gfid, in->dst_file);
+
+    /* every server writes the data it holds */
+    ret = unifyfs_invoke_broadcast_transfer(gfid, in->dst_file);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("unifyfs_invoke_broadcast_transfer() failed");
+    }
+    margo_free_input(req->handle, in);
+    free(in);
+
+    /* send rpc response */
+    unifyfs_transfer_out_t out;
+    out.ret = (int32_t) ret;
+    hg_return_t hret = margo_respond(req->handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* cleanup req */
+    margo_destroy(req->handle);
+
+    return ret;
+}
+
+static int process_readthrough_rpc(reqmgr_thrd_t* reqmgr,
+                                   client_rpc_req_t* req)
+{
+    int ret = UNIFYFS_SUCCESS;
+
+    unifyfs_readthrough_in_t* in = req->input;
+    assert(in != NULL);
+
+    LOGDBG("registering read-through file %s (gfid=%d) from %s",
+           in->attr.filename, in->attr.gfid, in->backing_file);
+
+    /* every server needs the file, its owners read the data */
+    ret = unifyfs_invoke_broadcast_readthrough(&(in->attr),
+                                               in->backing_file);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("unifyfs_invoke_broadcast_readthrough() failed");
+    }
+    margo_free_input(req->handle, in);
+    free(in);
+
+    /* send rpc response */
+    unifyfs_readthrough_out_t out;
+    out.ret = (int32_t) ret;
+    hg_return_t hret = margo_respond(req->handle, &out);
+    if (hret != HG_SUCCESS) {
+        LOGERR("margo_respond() failed");
+    }
+
+    /* cleanup req */
+    margo_destroy(req->handle);
+
+    return ret;
+}
+
 static int process_metaget_rpc(reqmgr_thrd_t* reqmgr,
                                client_rpc_req_t* req)
 {
@@ -1141,20 +1286,26 @@ static int process_read_rpc(reqmgr_thrd_t* reqmgr,
     assert(in != NULL);
     int mread_id = in->mread_id;
     size_t read_count = in->read_count;
+    uint64_t trace_id = in->trace_id;
     margo_free_input(req->handle, in);
     free(in);
 
     LOGDBG("processing mread[%d] with %zu requests", mread_id, read_count);
 
+    unifyfs_trace_end("server_rm_queue", trace_id, req->submit_time);
+    uint64_t trace_start = unifyfs_trace_start();
+
     unifyfs_fops_ctx_t ctx = {
         .app_id = reqmgr->app_id,
         .client_id = reqmgr->client_id,
-        .mread_id = mread_id
+        .mread_id = mread_id,
+        .trace_id = trace_id
     };
     ret = unifyfs_fops_mread(&ctx, read_count, req->bulk_buf);
     if (ret != UNIFYFS_SUCCESS) {
         LOGERR("unifyfs_fops_read() failed");
     }
+    unifyfs_trace_end("server_mread_submit", trace_id, trace_start);
 
     /* send rpc response */
     unifyfs_mread_out_t out;
@@ -1276,34 +1427,58 @@ static int rm_process_client_requests(reqmgr_thrd_t* reqmgr)
     for (int i = 0; i < num_client_reqs; i++) {
         /* process next request */
         int rret;
+        unifyfs_stat_op_e op = UNIFYFS_STAT_OP_COUNT;
+        uint64_t start = unifyfs_stats_start();
         client_rpc_req_t* req = (client_rpc_req_t*)
             arraylist_get(client_reqs, i);
+        unifyfs_stats_gauge_add(UNIFYFS_GAUGE_CLIENT_REQS, -1);
         switch (req->req_type) {
         case UNIFYFS_CLIENT_RPC_ATTACH:
+            op = UNIFYFS_STAT_CLIENT_ATTACH;
             rret = process_attach_rpc(reqmgr, req);
             break;
+        case UNIFYFS_CLIENT_RPC_COMPACT:
+            op = UNIFYFS_STAT_CLIENT_COMPACT;
+            rret = process_compact_rpc(reqmgr, req);
+            break;
         case UNIFYFS_CLIENT_RPC_FILESIZE:
+            op = UNIFYFS_STAT_CLIENT_FILESIZE;
             rret = process_filesize_rpc(reqmgr, req);
             break;
         case UNIFYFS_CLIENT_RPC_LAMINATE:
+            op = UNIFYFS_STAT_CLIENT_LAMINATE;
             rret = process_laminate_rpc(reqmgr, req);
             break;
         case UNIFYFS_CLIENT_RPC_METAGET:
+            op = UNIFYFS_STAT_CLIENT_METAGET;
             rret = process_metaget_rpc(reqmgr, req);
             break;
         case UNIFYFS_CLIENT_RPC_METASET:
+            op = UNIFYFS_STAT_CLIENT_METASET;
             rret = process_metaset_rpc(reqmgr, req);
             break;
         case UNIFYFS_CLIENT_RPC_READ:
+            op = UNIFYFS_STAT_CLIENT_READ;
             rret = process_read_rpc(reqmgr, req);
             break;
+        case UNIFYFS_CLIENT_RPC_READTHROUGH:
+            op = UNIFYFS_STAT_CLIENT_READTHROUGH;
+            rret = process_readthrough_rpc(reqmgr, req);
+            break;
         case UNIFYFS_CLIENT_RPC_SYNC:
+            op = UNIFYFS_STAT_CLIENT_SYNC;
             rret = process_fsync_rpc(reqmgr, req);
             break;
+        case UNIFYFS_CLIENT_RPC_TRANSFER:
+            op = UNIFYFS_STAT_CLIENT_TRANSFER;
+            rret = process_transfer_rpc(reqmgr, req);
+            break;
         case UNIFYFS_CLIENT_RPC_TRUNCATE:
+            op = UNIFYFS_STAT_CLIENT_TRUNCATE;
             rret = process_truncate_rpc(reqmgr, req);
             break;
         case UNIFYFS_CLIENT_RPC_UNLINK:
+            op = UNIFYFS_STAT_CLIENT_UNLINK;
             rret = process_unlink_rpc(reqmgr, req);
             break;
         default:
@@ -1311,6 +1486,7 @@ static int rm_process_client_requests(reqmgr_thrd_t* reqmgr)
             rret = UNIFYFS_ERROR_NYI;
             break;
         }
+        unifyfs_stats_record(op, start, rret);
         if (rret != UNIFYFS_SUCCESS) {
             if ((rret != ENOENT) && (rret != EEXIST)) {
                 LOGERR("client rpc request %d failed (%s)",
@@ -1433,10 +1609,12 @@ int invoke_chunk_read_request_rpc(int dst_srvr_rank,
                                     rdreq->client_id,
                                     rdreq->req_ndx,
                                     num_chunks,
+                                    rdreq->trace_id,
                                     (char*)data_buf);
     }
 
     int ret = UNIFYFS_SUCCESS;
+    uint64_t trace_start = unifyfs_trace_start();
     hg_handle_t handle;
     chunk_read_request_in_t in;
     chunk_read_request_out_t out;
@@ -1461,6 +1639,7 @@ int invoke_chunk_read_request_rpc(int dst_srvr_rank,
     in.client_id = (int32_t)rdreq->client_id;
     in.req_id = (int32_t)rdreq->req_ndx;
     in.num_chks = (int32_t)num_chunks;
+    in.trace_id = rdreq->trace_id;
     in.bulk_size = bulk_sz;
 
     /* register request buffer for bulk remote access */
@@ -1494,6 +1673,9 @@ int invoke_chunk_read_request_rpc(int dst_srvr_rank,
     }
     margo_destroy(handle);
 
+    unifyfs_trace_end("server_chunk_read_request", rdreq->trace_id,
+                      trace_start);
+
     return ret;
 }
 
@@ -1505,6 +1687,7 @@ static void chunk_read_response_rpc(hg_handle_t handle)
 {
     int32_t ret;
     chunk_read_response_out_t out;
+    uint64_t start = unifyfs_stats_start();
 
     /* get input params */
     chunk_read_response_in_t in;
@@ -1520,6 +1703,8 @@ static void chunk_read_response_rpc(hg_handle_t handle)
         int req_id     = (int)in.req_id;
         int num_chks   = (int)in.num_chks;
         size_t bulk_sz = (size_t)in.bulk_size;
+        uint64_t trace_id = in.trace_id;
+        uint64_t trace_start = unifyfs_trace_start();
 
         LOGDBG("received chunk read response from server %d (%d chunks)",
             src_rank, num_chks);
@@ -1612,6 +1797,9 @@ static void chunk_read_response_rpc(hg_handle_t handle)
 
                 /* deregister our bulk transfer buffer */
                 margo_bulk_free(bulk_handle);
+
+                unifyfs_trace_end("server_chunk_read_response", trace_id,
+                                  trace_start);
             }
         }
         margo_free_input(handle, &in);
@@ -1627,5 +1815,7 @@ out_respond:
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_CHUNK_READ_RESPONSE, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(chunk_read_response_rpc)
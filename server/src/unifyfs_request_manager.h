@@ -41,6 +41,7 @@ typedef struct {
     void* input;
     void* bulk_buf;
     size_t bulk_sz;
+    uint64_t submit_time;      /* time request was queued, when tracing */
 } client_rpc_req_t;
 
 typedef struct {
@@ -55,6 +56,8 @@ typedef struct {
     chunk_read_req_t* chunks;  /* array of chunk-reads */
     server_chunk_reads_t* remote_reads; /* per-server remote reads array */
     unifyfs_inode_extent_t extent; /* the requested extent */
+    uint64_t trace_id;         /* trace id of client mread, or zero */
+    uint64_t trace_start;      /* time request was submitted, when tracing */
 } server_read_req_t;
 
 /* Request manager state structure - created by main thread for each request
@@ -39,8 +39,14 @@
 #include "unifyfs_global.h"
 #include "unifyfs_metadata_mdhim.h"
 #include "unifyfs_request_manager.h"
+#include "unifyfs_compact.h"
+#include "unifyfs_numa.h"
+#include "unifyfs_readthrough.h"
+#include "unifyfs_reclaim.h"
 #include "unifyfs_service_manager.h"
+#include "unifyfs_spillio.h"
 #include "unifyfs_inode_tree.h"
+#include "unifyfs_stats.h"
 
 // margo rpcs
 #include "margo_server.h"
@@ -198,6 +204,21 @@ static int allocate_servers(size_t n_servers)
     return (int)UNIFYFS_SUCCESS;
 }
 
+/* set margo rpc handler pool size from configuration value, keeping the
+ * current size if the value is missing or less than min_size */
+static void get_pool_size(const char* cfg_val, int min_size, int* pool_size)
+{
+    long l;
+    if (NULL != cfg_val) {
+        if ((0 == configurator_int_val(cfg_val, &l)) && (l >= min_size)) {
+            *pool_size = (int) l;
+        } else {
+            LOGWARN("invalid margo pool size '%s', using %d",
+                    cfg_val, *pool_size);
+        }
+    }
+}
+
 static int process_servers_hostfile(const char* hostfile)
 {
     int rc;
@@ -333,6 +354,18 @@ int main(int argc, char* argv[])
     // print config
     unifyfs_config_print(&server_cfg, unifyfs_log_stream);
 
+    if (server_cfg.log_async != NULL) {
+        bool enable = false;
+        rc = configurator_bool_val(server_cfg.log_async, &enable);
+        if ((0 == rc) && enable) {
+            rc = unifyfs_log_async_start();
+            if (rc != UNIFYFS_SUCCESS) {
+                LOGERR("failed to start log writer thread (%s)",
+                       strerror(rc));
+            }
+        }
+    }
+
     if (NULL != server_cfg.server_hostfile) {
         rc = process_servers_hostfile(server_cfg.server_hostfile);
         if (rc != (int)UNIFYFS_SUCCESS) {
@@ -373,6 +406,14 @@ int main(int argc, char* argv[])
     ABT_init(argc, argv);
     ABT_mutex_create(&app_configs_abt_sync);
     rc = configurator_bool_val(server_cfg.margo_tcp, &margo_use_tcp);
+    get_pool_size(server_cfg.margo_client_pool_size, 1,
+                  &margo_client_server_pool_sz);
+    get_pool_size(server_cfg.margo_server_pool_size, 1,
+                  &margo_server_server_pool_sz);
+    get_pool_size(server_cfg.margo_meta_pool_size, 0, &margo_meta_pool_sz);
+    get_pool_size(server_cfg.margo_data_pool_size, 0, &margo_data_pool_sz);
+    get_pool_size(server_cfg.margo_coll_pool_size, 0, &margo_coll_pool_sz);
+    get_pool_size(server_cfg.margo_io_pool_size, 0, &margo_io_pool_sz);
     rc = margo_server_rpc_init();
     if (rc != UNIFYFS_SUCCESS) {
         LOGERR("%s", unifyfs_rc_enum_description(rc));
@@ -401,8 +442,58 @@ int main(int argc, char* argv[])
         exit(1);
     }
 
-    /* initialize our tree that maps a gfid to its extent tree */
-    unifyfs_inode_tree_init(global_inode_tree);
+    /* initialize our table that maps a gfid to its inode */
+    rc = unifyfs_inode_table_init(global_inode_table,
+                                  UNIFYFS_INODE_TABLE_SHARDS);
+    if (rc != 0) {
+        LOGERR("failed to initialize inode table - %s", strerror(rc));
+        exit(1);
+    }
+
+    rc = unifyfs_stats_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize server statistics");
+        exit(1);
+    }
+
+    rc = unifyfs_reclaim_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize log space reclaim");
+        exit(1);
+    }
+
+    rc = unifyfs_compact_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize log compaction");
+        exit(1);
+    }
+
+    rc = unifyfs_spillio_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize asynchronous spill I/O");
+        exit(1);
+    }
+
+    rc = unifyfs_numa_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize NUMA placement");
+        exit(1);
+    }
+
+    rc = unifyfs_readthrough_init(&server_cfg);
+    if (rc != 0) {
+        LOGERR("failed to initialize read-through stage-in");
+        exit(1);
+    }
+
+    char trace_label[64];
+    snprintf(trace_label, sizeof(trace_label), "unifyfsd rank %d",
+             glb_pmi_rank);
+    rc = unifyfs_trace_init(&server_cfg, trace_label);
+    if (rc != 0) {
+        LOGERR("failed to initialize request tracing");
+        exit(1);
+    }
 
     LOGDBG("publishing server pid");
     rc = unifyfs_publish_server_pids();
@@ -422,8 +513,11 @@ int main(int argc, char* argv[])
         }
     }
 
-    /* tear down gfid-to-extents tree */
-    unifyfs_inode_tree_destroy(global_inode_tree);
+    /* write final stats before the inode table goes away */
+    unifyfs_stats_fini();
+
+    /* tear down gfid-to-inode table */
+    unifyfs_inode_table_destroy(global_inode_table);
 
     LOGDBG("stopping service manager thread");
     rc = svcmgr_fini();
@@ -595,6 +689,9 @@ static int unifyfs_exit(void)
 {
     int ret = UNIFYFS_SUCCESS;
 
+    /* release read-through cache log shared memory */
+    unifyfs_readthrough_fini();
+
     /* iterate over each active application and free resources */
     ABT_mutex_lock(app_configs_abt_sync);
     for (int i = 0; i < MAX_NUM_APPS; i++) {
@@ -621,6 +718,12 @@ static int unifyfs_exit(void)
     LOGDBG("stopping rpc service");
     margo_server_rpc_finalize();
 
+    /* write request trace once rpc handlers have stopped */
+    unifyfs_trace_fini();
+
+    /* stop spill I/O threads */
+    unifyfs_spillio_fini();
+
 #if defined(USE_MDHIM)
     /* shutdown the metadata service*/
     LOGDBG("stopping metadata service");
@@ -653,6 +756,58 @@ app_config* get_application(int app_id)
     return NULL;
 }
 
+/* sum the shmem and spill log data in use by all application clients */
+unifyfs_rc get_storage_usage(size_t* shmem_bytes, size_t* spill_bytes)
+{
+    size_t shmem_total = 0;
+    size_t spill_total = 0;
+
+    ABT_mutex_lock(app_configs_abt_sync);
+    for (int i = 0; i < MAX_NUM_APPS; i++) {
+        app_config* app = app_configs[i];
+        if (NULL == app) {
+            continue;
+        }
+        for (size_t j = 0; j < app->clients_sz; j++) {
+            app_client* client = app->clients[j];
+            if ((NULL != client) && (NULL != client->logio)) {
+                size_t shmem_used = 0;
+                size_t spill_used = 0;
+                unifyfs_logio_get_usage(client->logio,
+                                        &shmem_used, &spill_used);
+                shmem_total += shmem_used;
+                spill_total += spill_used;
+            }
+        }
+    }
+    ABT_mutex_unlock(app_configs_abt_sync);
+
+    *shmem_bytes = shmem_total;
+    *spill_bytes = spill_total;
+    return UNIFYFS_SUCCESS;
+}
+
+/* call fn with each application client */
+unifyfs_rc foreach_app_client(void (*fn)(app_client*, void*), void* arg)
+{
+    ABT_mutex_lock(app_configs_abt_sync);
+    for (int i = 0; i < MAX_NUM_APPS; i++) {
+        app_config* app = app_configs[i];
+        if (NULL == app) {
+            continue;
+        }
+        for (size_t j = 0; j < app->clients_sz; j++) {
+            app_client* client = app->clients[j];
+            if (NULL != client) {
+                fn(client, arg);
+            }
+        }
+    }
+    ABT_mutex_unlock(app_configs_abt_sync);
+
+    return UNIFYFS_SUCCESS;
+}
+
 /* insert a new app config in app_configs[] */
 app_config* new_application(int app_id)
 {
@@ -847,6 +1002,58 @@ app_client* new_app_client(app_config* app,
     return client;
 }
 
+/**
+ * Initialize a client for log data written by the server itself, such as
+ * data cached for read-through files. It has no margo address or request
+ * manager thread and is never connected, but its log is read like that of
+ * any other client. The log is created using the logio settings of cfg.
+ */
+app_client* new_server_app_client(app_config* app,
+                                  const unifyfs_cfg_t* cfg)
+{
+    if ((NULL == app) || (NULL == cfg)) {
+        return NULL;
+    }
+
+    ABT_mutex_lock(app_configs_abt_sync);
+
+    if (app->num_clients == app->clients_sz) {
+        LOGERR("reached maximum number of application clients");
+        ABT_mutex_unlock(app_configs_abt_sync);
+        return NULL;
+    }
+
+    int app_id = app->app_id;
+    int client_id = app->num_clients + 1; /* next client id */
+    int client_ndx = client_id - 1;       /* clients array index is (id - 1) */
+
+    app_client* client = (app_client*) calloc(1, sizeof(app_client));
+    if (NULL != client) {
+        client->app_id = app_id;
+        client->client_id = client_id;
+        client->dbg_rank = glb_pmi_rank;
+
+        int rc = unifyfs_logio_init_client(app_id, client_id, cfg,
+                                           &(client->logio));
+        if (rc != UNIFYFS_SUCCESS) {
+            LOGERR("failed to initialize server client log");
+            cleanup_app_client(app, client);
+            ABT_mutex_unlock(app_configs_abt_sync);
+            return NULL;
+        }
+
+        /* update app state */
+        app->num_clients++;
+        app->clients[client_ndx] = client;
+    } else {
+        LOGERR("failed to allocate client structure");
+    }
+
+    ABT_mutex_unlock(app_configs_abt_sync);
+
+    return client;
+}
+
 /**
  * Attaches server to shared client state (e.g., logio and shmem regions)
  */
@@ -874,6 +1081,12 @@ unifyfs_rc attach_app_client(app_client* client,
                                        &(client->logio));
     if (rc != UNIFYFS_SUCCESS) {
         failure = 1;
+    } else {
+        /* track log space that can be reclaimed */
+        rc = unifyfs_reclaim_attach(client);
+        if (rc != UNIFYFS_SUCCESS) {
+            failure = 1;
+        }
     }
 
     /* attach server-side shmem regions for this client */
@@ -954,6 +1167,7 @@ unifyfs_rc cleanup_app_client(app_config* app, app_client* client)
     disconnect_app_client(client);
 
     /* close client logio context */
+    unifyfs_reclaim_detach(client);
     if (NULL != client->logio) {
         unifyfs_logio_close(client->logio, 1);
         client->logio = NULL;
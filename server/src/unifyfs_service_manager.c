@@ -28,8 +28,12 @@
  */
 
 #include "unifyfs_global.h"
+#include "unifyfs_numa.h"
 #include "unifyfs_request_manager.h"
+#include "unifyfs_readthrough.h"
+#include "unifyfs_reclaim.h"
 #include "unifyfs_service_manager.h"
+#include "unifyfs_stats.h"
 #include "unifyfs_server_rpcs.h"
 #include "margo_server.h"
 
@@ -69,6 +73,41 @@ do { \
     ABT_mutex_unlock(sm->sync); \
 } while (0)
 
+/* most NUMA nodes tracked when choosing where to serve chunk reads */
+#define SM_NUMA_MAX_NODES 64
+
+/* Find the NUMA node whose client logs hold the most bytes of the given
+ * chunk reads. Returns -1 if NUMA placement is disabled, the reads are
+ * too small to be worth moving the thread, or no log node is known. */
+static int sm_numa_node(chunk_read_req_t* reqs,
+                        int num_chks,
+                        size_t total_data_sz)
+{
+    if (!unifyfs_numa_enabled() ||
+        (total_data_sz < UNIFYFS_NUMA_MIN_COPY)) {
+        return -1;
+    }
+
+    size_t node_bytes[SM_NUMA_MAX_NODES] = {0};
+    int best = -1;
+    for (int i = 0; i < num_chks; i++) {
+        app_client* clnt = get_app_client(reqs[i].log_app_id,
+                                          reqs[i].log_client_id);
+        if ((NULL == clnt) || (NULL == clnt->logio)) {
+            continue;
+        }
+        int node = clnt->logio->numa_node;
+        if ((node < 0) || (node >= SM_NUMA_MAX_NODES)) {
+            continue;
+        }
+        node_bytes[node] += reqs[i].nbytes;
+        if ((best < 0) || (node_bytes[node] > node_bytes[best])) {
+            best = node;
+        }
+    }
+    return best;
+}
+
 /* Decode and issue chunk-reads received from request manager.
  * We get a list of read requests for data on our node.  Read
  * data for each request and construct a set of read replies
@@ -79,6 +118,7 @@ do { \
  * @param src_client_id : client id at source server
  * @param src_req_id    : request id at source server
  * @param num_chks      : number of chunk requests
+ * @param trace_id      : trace id of client read, or zero
  * @param msg_buf       : message buffer containing request(s)
  * @return success/error code
  */
@@ -87,6 +127,7 @@ int sm_issue_chunk_reads(int src_rank,
                          int src_client_id,
                          int src_req_id,
                          int num_chks,
+                         uint64_t trace_id,
                          char* msg_buf)
 {
     /* get pointer to start of receive buffer */
@@ -114,11 +155,20 @@ int sm_issue_chunk_reads(int src_rank,
     size_t resp_sz = sizeof(chunk_read_resp_t) * num_chks;
     size_t buf_sz  = resp_sz + total_data_sz;
 
+    /* run on the NUMA node holding most of the client log data, so that
+     * the reply buffer is allocated there and copies stay on the node */
+    unifyfs_numa_place place = { .node = -1 };
+    int numa_node = sm_numa_node(reqs, num_chks, total_data_sz);
+    if (numa_node >= 0) {
+        unifyfs_numa_enter(numa_node, &place);
+    }
+
     /* allocate the buffer */
     // NOTE: calloc() is required here, don't use malloc
     char* crbuf = (char*) calloc(1, buf_sz);
     if (NULL == crbuf) {
         LOGERR("failed to allocate chunk_read_reqs");
+        unifyfs_numa_leave(&place);
         return ENOMEM;
     }
 
@@ -133,6 +183,7 @@ int sm_issue_chunk_reads(int src_rank,
         calloc(1, sizeof(server_chunk_reads_t));
     if (NULL == scr) {
         LOGERR("failed to allocate remote_chunk_reads");
+        unifyfs_numa_leave(&place);
         return ENOMEM;
     }
 
@@ -145,16 +196,34 @@ int sm_issue_chunk_reads(int src_rank,
     scr->reqs       = NULL;
     scr->total_sz   = buf_sz;
     scr->resp       = resp;
+    scr->trace_id   = trace_id;
 
     LOGDBG("issuing %d requests for req=%d, total data size = %zu",
            num_chks, src_req_id, total_data_sz);
 
+    /* the reads of all chunks are issued as one batch, so that reads of
+     * spill data are in flight concurrently */
+    logio_io* ios = (logio_io*) calloc(num_chks, sizeof(logio_io));
+    app_client** clients = (app_client**) calloc(num_chks,
+                                                 sizeof(app_client*));
+    int* read_errs = (int*) calloc(num_chks, sizeof(int));
+    if ((NULL == ios) || (NULL == clients) || (NULL == read_errs)) {
+        LOGERR("failed to allocate chunk read batch");
+        free(ios);
+        free(clients);
+        free(read_errs);
+        free(scr);
+        free(crbuf);
+        unifyfs_numa_leave(&place);
+        return ENOMEM;
+    }
+
     /* points to offset in read reply buffer to place
      * data for next read */
     size_t buf_cursor = 0;
+    uint64_t trace_start = unifyfs_trace_start();
 
     int i;
-    app_client* app_clnt = NULL;
     for (i = 0; i < num_chks; i++) {
         /* pointer to next read request */
         chunk_read_req_t* rreq = reqs + i;
@@ -174,35 +243,76 @@ int sm_issue_chunk_reads(int src_rank,
         LOGDBG("reading chunk(offset=%zu, size=%zu)",
                rreq->offset, nbytes);
 
-        /* get pointer to next position in buffer to store read data */
-        char* buf_ptr = databuf + buf_cursor;
-
-        /* read data from client log */
+        /* add read of client log data at next position in buffer */
         int app_id = rreq->log_app_id;
         int cli_id = rreq->log_client_id;
-        app_clnt = get_app_client(app_id, cli_id);
-        if (NULL != app_clnt) {
-            logio_context* logio_ctx = app_clnt->logio;
-            if (NULL != logio_ctx) {
-                size_t nread = 0;
-                int rc = unifyfs_logio_read(logio_ctx, log_offset, nbytes,
-                                            buf_ptr, &nread);
-                if (UNIFYFS_SUCCESS == rc) {
-                    rresp->read_rc = nread;
-                } else {
-                    rresp->read_rc = (ssize_t)(-rc);
-                }
+        app_client* app_clnt = get_app_client(app_id, cli_id);
+        if (unifyfs_readthrough_is_direct(rreq)) {
+            /* uncached read-through data, read from the backing file once
+             * the log reads are issued */
+            ios[i].nbytes = nbytes;
+            ios[i].buf = databuf + buf_cursor;
+        } else if ((NULL != app_clnt) && (NULL != app_clnt->logio)) {
+            /* the data may have been replaced, and its log space reused,
+             * since the extents were looked up */
+            unifyfs_reclaim_read_begin(app_clnt);
+            read_errs[i] = unifyfs_reclaim_check_read(app_clnt, rreq);
+            if (UNIFYFS_SUCCESS == read_errs[i]) {
+                clients[i] = app_clnt;
+                ios[i].ctx = app_clnt->logio;
+                ios[i].log_offset = (off_t) log_offset;
+                ios[i].nbytes = nbytes;
+                ios[i].buf = databuf + buf_cursor;
             } else {
-                rresp->read_rc = (ssize_t)(-EINVAL);
+                unifyfs_reclaim_read_end(app_clnt);
             }
         } else {
-            rresp->read_rc = (ssize_t)(-EINVAL);
+            /* nothing to read, the response gets an error */
+            read_errs[i] = EINVAL;
         }
 
         /* update to point to next slot in read reply buffer */
         buf_cursor += nbytes;
     }
 
+    /* read data from client logs */
+    unifyfs_logio_read_batch(ios, (size_t)num_chks);
+
+    int cur_node = unifyfs_numa_current_node();
+    size_t numa_local = 0;
+    size_t numa_remote = 0;
+    for (i = 0; i < num_chks; i++) {
+        chunk_read_resp_t* rresp = resp + i;
+        if (NULL != clients[i]) {
+            unifyfs_reclaim_read_end(clients[i]);
+            int log_node = ios[i].ctx->numa_node;
+            if ((log_node >= 0) && (cur_node >= 0)) {
+                if (log_node == cur_node) {
+                    numa_local += ios[i].nio;
+                } else {
+                    numa_remote += ios[i].nio;
+                }
+            }
+        }
+        if (unifyfs_readthrough_is_direct(reqs + i)) {
+            rresp->read_rc = unifyfs_readthrough_read(reqs + i, ios[i].buf);
+        } else if (UNIFYFS_SUCCESS != read_errs[i]) {
+            rresp->read_rc = (ssize_t)(-read_errs[i]);
+        } else if ((UNIFYFS_SUCCESS == ios[i].rc) || (ios[i].nio > 0)) {
+            rresp->read_rc = (ssize_t) ios[i].nio;
+        } else {
+            rresp->read_rc = (ssize_t)(-ios[i].rc);
+        }
+    }
+    free(ios);
+    free(clients);
+    free(read_errs);
+    unifyfs_numa_leave(&place);
+    if (numa_local || numa_remote) {
+        unifyfs_stats_numa_copy(numa_local, numa_remote);
+    }
+    unifyfs_trace_end("sm_chunk_reads", trace_id, trace_start);
+
     if (src_rank != glb_pmi_rank) {
         /* we need to send these read responses to another rank,
          * add chunk_reads to svcmgr response list and another
@@ -213,6 +323,7 @@ int sm_issue_chunk_reads(int src_rank,
         SM_LOCK();
         arraylist_add(sm->chunk_reads, scr);
         SM_UNLOCK();
+        unifyfs_stats_gauge_add(UNIFYFS_GAUGE_CHUNK_READS, 1);
 
         /* scr will be freed later by the sending thread */
 
@@ -329,6 +440,7 @@ static int send_chunk_read_responses(void)
             arraylist_get(chunk_reads, i);
 
         rc = invoke_chunk_read_response_rpc(scr);
+        unifyfs_stats_gauge_add(UNIFYFS_GAUGE_CHUNK_READS, -1);
     }
 
     /* free the list if we have one */
@@ -389,6 +501,8 @@ int invoke_chunk_read_response_rpc(server_chunk_reads_t* scr)
     int dst_rank = scr->rank;
     assert(dst_rank < (int)glb_num_servers);
 
+    uint64_t trace_start = unifyfs_trace_start();
+
     /* get address of destinaton server */
     hg_addr_t dst_addr = glb_servers[dst_rank].margo_svr_addr;
 
@@ -425,6 +539,7 @@ int invoke_chunk_read_response_rpc(server_chunk_reads_t* scr)
     in.client_id = (int32_t)scr->client_id;
     in.req_id    = (int32_t)scr->rdreq_id;
     in.num_chks  = (int32_t)scr->num_chunks;
+    in.trace_id  = scr->trace_id;
     in.bulk_size = bulk_sz;
 
     /* call the read response rpc */
@@ -456,6 +571,8 @@ int invoke_chunk_read_response_rpc(server_chunk_reads_t* scr)
     free(data_buf);
     scr->resp = NULL;
 
+    unifyfs_trace_end("sm_chunk_read_response", scr->trace_id, trace_start);
+
     return rc;
 }
 
@@ -465,6 +582,7 @@ int invoke_chunk_read_response_rpc(server_chunk_reads_t* scr)
 static void chunk_read_request_rpc(hg_handle_t handle)
 {
     int32_t ret = UNIFYFS_SUCCESS;
+    uint64_t start = unifyfs_stats_start();
 
     /* get input params */
     chunk_read_request_in_t in;
@@ -523,6 +641,7 @@ static void chunk_read_request_rpc(hg_handle_t handle)
                             ret = sm_issue_chunk_reads(src_rank,
                                                        app_id, client_id,
                                                        req_id, num_chks,
+                                                       in.trace_id,
                                                        (char*)reqbuf);
                         } else {
                             LOGERR("invalid command %d from server %d",
@@ -550,5 +669,7 @@ static void chunk_read_request_rpc(hg_handle_t handle)
 
     /* free margo resources */
     margo_destroy(handle);
+
+    unifyfs_stats_record(UNIFYFS_STAT_CHUNK_READ_REQUEST, start, ret);
 }
 DEFINE_MARGO_RPC_HANDLER(chunk_read_request_rpc)
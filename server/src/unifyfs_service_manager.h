@@ -47,6 +47,7 @@ int sm_issue_chunk_reads(int src_rank,
                          int src_client_id,
                          int src_req_id,
                          int num_chks,
+                         uint64_t trace_id,
                          char* msg_buf);
 
 /* MARGO SERVER-SERVER RPC INVOCATION FUNCTIONS */
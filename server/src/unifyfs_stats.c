@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unifyfs_global.h"
+#include "unifyfs_inode.h"
+#include "unifyfs_reclaim.h"
+#include "unifyfs_stats.h"
+
+/* per-operation counters and latency histogram */
+typedef struct {
+    uint64_t count;
+    uint64_t errors;
+    uint64_t total_usec;
+    uint64_t max_usec;
+    uint64_t hist[UNIFYFS_STAT_HIST_BUCKETS];
+} stat_op_t;
+
+static stat_op_t stat_ops[UNIFYFS_STAT_OP_COUNT];
+static int64_t stat_gauges[UNIFYFS_GAUGE_COUNT];
+
+static const char* stat_op_names[UNIFYFS_STAT_OP_COUNT] = {
+    [UNIFYFS_STAT_CLIENT_ATTACH]       = "client_attach",
+    [UNIFYFS_STAT_CLIENT_COMPACT]      = "client_compact",
+    [UNIFYFS_STAT_CLIENT_FILESIZE]     = "client_filesize",
+    [UNIFYFS_STAT_CLIENT_LAMINATE]     = "client_laminate",
+    [UNIFYFS_STAT_CLIENT_METAGET]      = "client_metaget",
+    [UNIFYFS_STAT_CLIENT_METASET]      = "client_metaset",
+    [UNIFYFS_STAT_CLIENT_READ]         = "client_read",
+    [UNIFYFS_STAT_CLIENT_READTHROUGH]  = "client_readthrough",
+    [UNIFYFS_STAT_CLIENT_SYNC]         = "client_sync",
+    [UNIFYFS_STAT_CLIENT_TRANSFER]     = "client_transfer",
+    [UNIFYFS_STAT_CLIENT_TRUNCATE]     = "client_truncate",
+    [UNIFYFS_STAT_CLIENT_UNLINK]       = "client_unlink",
+    [UNIFYFS_STAT_P2P_ADD_EXTENTS]     = "p2p_add_extents",
+    [UNIFYFS_STAT_P2P_FIND_EXTENTS]    = "p2p_find_extents",
+    [UNIFYFS_STAT_P2P_FILESIZE]        = "p2p_filesize",
+    [UNIFYFS_STAT_P2P_LAMINATE]        = "p2p_laminate",
+    [UNIFYFS_STAT_P2P_METAGET]         = "p2p_metaget",
+    [UNIFYFS_STAT_P2P_METASET]         = "p2p_metaset",
+    [UNIFYFS_STAT_P2P_RELOCATE_EXTENTS] = "p2p_relocate_extents",
+    [UNIFYFS_STAT_P2P_TRUNCATE]        = "p2p_truncate",
+    [UNIFYFS_STAT_BCAST_EXTENTS]       = "bcast_extents",
+    [UNIFYFS_STAT_BCAST_FILEATTR]      = "bcast_fileattr",
+    [UNIFYFS_STAT_BCAST_LAMINATE]      = "bcast_laminate",
+    [UNIFYFS_STAT_BCAST_READTHROUGH]   = "bcast_readthrough",
+    [UNIFYFS_STAT_BCAST_TRANSFER]      = "bcast_transfer",
+    [UNIFYFS_STAT_BCAST_TRUNCATE]      = "bcast_truncate",
+    [UNIFYFS_STAT_BCAST_UNLINK]        = "bcast_unlink",
+    [UNIFYFS_STAT_CHUNK_READ_REQUEST]  = "chunk_read_request",
+    [UNIFYFS_STAT_CHUNK_READ_RESPONSE] = "chunk_read_response"
+};
+
+/* bytes copied from client logs on the same and on other NUMA nodes */
+static uint64_t stat_numa_local_bytes;
+static uint64_t stat_numa_remote_bytes;
+
+static const char* stat_gauge_names[UNIFYFS_GAUGE_COUNT] = {
+    [UNIFYFS_GAUGE_CLIENT_REQS] = "client_reqs_queued",
+    [UNIFYFS_GAUGE_READ_REQS]   = "read_reqs_active",
+    [UNIFYFS_GAUGE_CHUNK_READS] = "chunk_reads_active"
+};
+
+/* server start time, for reporting uptime */
+static uint64_t stats_start_ns;
+
+/* periodic dump state */
+static long stats_interval;           /* seconds between dumps, 0=disabled */
+static char stats_file[UNIFYFS_MAX_FILENAME];
+static pthread_t stats_thread;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stats_cond = PTHREAD_COND_INITIALIZER;
+static int stats_thread_running; /* = 0 */
+static int stats_thread_exit; /* = 0 */
+
+int unifyfs_stats_hist_bucket(uint64_t usecs)
+{
+    int bucket = 0;
+    while ((usecs > 0) && (bucket < (UNIFYFS_STAT_HIST_BUCKETS - 1))) {
+        usecs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void unifyfs_stats_record(unifyfs_stat_op_e op, uint64_t start_ns, int rc)
+{
+    if ((op < 0) || (op >= UNIFYFS_STAT_OP_COUNT)) {
+        return;
+    }
+
+    uint64_t usecs = (unifyfs_stats_start() - start_ns) / 1000;
+    stat_op_t* sop = &(stat_ops[op]);
+
+    __atomic_fetch_add(&(sop->count), 1, __ATOMIC_RELAXED);
+    if (rc != 0) {
+        __atomic_fetch_add(&(sop->errors), 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&(sop->total_usec), usecs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&(sop->hist[unifyfs_stats_hist_bucket(usecs)]), 1,
+                       __ATOMIC_RELAXED);
+
+    /* update max with compare-and-swap, retrying if another thread
+     * raised the max in the meantime */
+    uint64_t max = __atomic_load_n(&(sop->max_usec), __ATOMIC_RELAXED);
+    while ((usecs > max) &&
+           !__atomic_compare_exchange_n(&(sop->max_usec), &max, usecs, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void unifyfs_stats_gauge_add(unifyfs_stat_gauge_e gauge, int64_t delta)
+{
+    if ((gauge < 0) || (gauge >= UNIFYFS_GAUGE_COUNT)) {
+        return;
+    }
+    __atomic_fetch_add(&(stat_gauges[gauge]), delta, __ATOMIC_RELAXED);
+}
+
+void unifyfs_stats_numa_copy(size_t local_bytes, size_t remote_bytes)
+{
+    __atomic_fetch_add(&stat_numa_local_bytes, (uint64_t) local_bytes,
+                       __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stat_numa_remote_bytes, (uint64_t) remote_bytes,
+                       __ATOMIC_RELAXED);
+}
+
+/* state for printing per-client stats */
+typedef struct {
+    FILE* fp;
+    int count;
+} stats_clients_t;
+
+static void stats_print_client(app_client* client, void* arg)
+{
+    stats_clients_t* sc = (stats_clients_t*) arg;
+    size_t reclaimable = 0;
+    size_t reclaimed = 0;
+    size_t compacted = 0;
+    uint64_t compact_usec = 0;
+    unifyfs_reclaim_get_counts(client, &reclaimable, &reclaimed);
+    unifyfs_reclaim_get_compacted(client, &compacted, &compact_usec);
+    int numa_node = -1;
+    if (NULL != client->logio) {
+        numa_node = client->logio->numa_node;
+    }
+    fprintf(sc->fp, "%s{\"app_id\":%d,\"client_id\":%d,"
+            "\"log_reclaimable_bytes\":%zu,\"log_reclaimed_bytes\":%zu,"
+            "\"log_compacted_bytes\":%zu,\"log_compact_usec\":%llu,"
+            "\"numa_node\":%d}",
+            (sc->count ? "," : ""), client->app_id, client->client_id,
+            reclaimable, reclaimed, compacted,
+            (unsigned long long) compact_usec, numa_node);
+    sc->count++;
+}
+
+int unifyfs_stats_to_json(char** json)
+{
+    char* buf = NULL;
+    size_t bufsz = 0;
+    FILE* fp = open_memstream(&buf, &bufsz);
+    if (NULL == fp) {
+        LOGERR("failed to open memory stream (%s)", strerror(errno));
+        return ENOMEM;
+    }
+
+    uint64_t uptime_usec = (unifyfs_stats_start() - stats_start_ns) / 1000;
+    fprintf(fp, "{\"rank\":%d,\"uptime_usec\":%llu,\"ops\":{",
+            glb_pmi_rank, (unsigned long long) uptime_usec);
+
+    for (int i = 0; i < UNIFYFS_STAT_OP_COUNT; i++) {
+        stat_op_t* sop = &(stat_ops[i]);
+        unsigned long long count, errors, total, max;
+        count = __atomic_load_n(&(sop->count), __ATOMIC_RELAXED);
+        errors = __atomic_load_n(&(sop->errors), __ATOMIC_RELAXED);
+        total = __atomic_load_n(&(sop->total_usec), __ATOMIC_RELAXED);
+        max = __atomic_load_n(&(sop->max_usec), __ATOMIC_RELAXED);
+        fprintf(fp, "%s\"%s\":{\"count\":%llu,\"errors\":%llu,"
+                "\"total_usec\":%llu,\"max_usec\":%llu,\"hist_usec\":[",
+                (i ? "," : ""), stat_op_names[i],
+                count, errors, total, max);
+        for (int b = 0; b < UNIFYFS_STAT_HIST_BUCKETS; b++) {
+            unsigned long long n;
+            n = __atomic_load_n(&(sop->hist[b]), __ATOMIC_RELAXED);
+            fprintf(fp, "%s%llu", (b ? "," : ""), n);
+        }
+        fprintf(fp, "]}");
+    }
+
+    fprintf(fp, "},\"gauges\":{");
+    for (int i = 0; i < UNIFYFS_GAUGE_COUNT; i++) {
+        long long val = __atomic_load_n(&(stat_gauges[i]), __ATOMIC_RELAXED);
+        fprintf(fp, "\"%s\":%lld,", stat_gauge_names[i], val);
+    }
+
+    /* gauges of server state are sampled when taking the snapshot */
+    size_t shmem_bytes = 0;
+    size_t spill_bytes = 0;
+    size_t n_inodes = 0;
+    size_t n_extents = 0;
+    get_storage_usage(&shmem_bytes, &spill_bytes);
+    unifyfs_inode_get_counts(&n_inodes, &n_extents);
+    fprintf(fp, "\"shmem_bytes\":%zu,\"spill_bytes\":%zu,"
+            "\"inodes\":%zu,\"extents\":%zu,\"log_dropped\":%lu}",
+            shmem_bytes, spill_bytes, n_inodes, n_extents,
+            unifyfs_log_dropped());
+
+    /* copies from client logs by NUMA locality */
+    unsigned long long numa_local, numa_remote;
+    numa_local = __atomic_load_n(&stat_numa_local_bytes, __ATOMIC_RELAXED);
+    numa_remote = __atomic_load_n(&stat_numa_remote_bytes, __ATOMIC_RELAXED);
+    double remote_ratio = 0.0;
+    if ((numa_local + numa_remote) > 0) {
+        remote_ratio = (double) numa_remote /
+                       (double)(numa_local + numa_remote);
+    }
+    fprintf(fp, ",\"numa\":{\"local_copy_bytes\":%llu,"
+            "\"remote_copy_bytes\":%llu,\"remote_copy_ratio\":%.4f}",
+            numa_local, numa_remote, remote_ratio);
+
+    /* per-client log space reclaim counters */
+    stats_clients_t sc = { .fp = fp, .count = 0 };
+    fprintf(fp, ",\"clients\":[");
+    foreach_app_client(stats_print_client, &sc);
+    fprintf(fp, "]}");
+
+    if (fclose(fp) != 0) {
+        free(buf);
+        return ENOMEM;
+    }
+
+    *json = buf;
+    return UNIFYFS_SUCCESS;
+}
+
+/* write stats to the dump file, using a temporary file and rename so
+ * readers never see a partial dump */
+static int stats_dump(void)
+{
+    char* json = NULL;
+    int rc = unifyfs_stats_to_json(&json);
+    if (rc != UNIFYFS_SUCCESS) {
+        return rc;
+    }
+
+    char tmpfile[UNIFYFS_MAX_FILENAME + 8];
+    snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", stats_file);
+    FILE* fp = fopen(tmpfile, "w");
+    if (NULL == fp) {
+        rc = errno;
+        LOGERR("failed to create file %s (%s)", tmpfile, strerror(rc));
+        free(json);
+        return rc;
+    }
+    fprintf(fp, "%s\n", json);
+    free(json);
+    if (fclose(fp) != 0) {
+        rc = errno;
+        LOGERR("failed to write file %s (%s)", tmpfile, strerror(rc));
+        unlink(tmpfile);
+        return rc;
+    }
+
+    if (rename(tmpfile, stats_file) != 0) {
+        rc = errno;
+        LOGERR("failed to rename %s to %s (%s)",
+               tmpfile, stats_file, strerror(rc));
+        unlink(tmpfile);
+        return rc;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+static void* stats_thread_main(void* arg)
+{
+    struct timespec timeout;
+
+    pthread_mutex_lock(&stats_mutex);
+    while (!stats_thread_exit) {
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += stats_interval;
+        int rc = 0;
+        while (!stats_thread_exit && (rc != ETIMEDOUT)) {
+            rc = pthread_cond_timedwait(&stats_cond, &stats_mutex, &timeout);
+        }
+        if (stats_thread_exit) {
+            break;
+        }
+        pthread_mutex_unlock(&stats_mutex);
+        stats_dump();
+        pthread_mutex_lock(&stats_mutex);
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    return NULL;
+}
+
+int unifyfs_stats_init(unifyfs_cfg_t* cfg)
+{
+    int rc;
+
+    stats_start_ns = unifyfs_stats_start();
+
+    stats_interval = 0;
+    if (NULL != cfg->server_stats_interval) {
+        rc = configurator_int_val(cfg->server_stats_interval,
+                                  &stats_interval);
+        if (rc) {
+            LOGERR("failed to read configuration");
+            return rc;
+        }
+    }
+    if (stats_interval <= 0) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    snprintf(stats_file, sizeof(stats_file), "%s/%s",
+             cfg->runstate_dir, UNIFYFSD_STATS_FILENAME);
+
+    stats_thread_exit = 0;
+    rc = pthread_create(&stats_thread, NULL, stats_thread_main, NULL);
+    if (rc) {
+        LOGERR("failed to create stats thread (%s)", strerror(rc));
+        return rc;
+    }
+    stats_thread_running = 1;
+
+    LOGINFO("writing server stats to %s every %ld seconds",
+            stats_file, stats_interval);
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_stats_fini(void)
+{
+    if (!stats_thread_running) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    pthread_mutex_lock(&stats_mutex);
+    stats_thread_exit = 1;
+    pthread_cond_signal(&stats_cond);
+    pthread_mutex_unlock(&stats_mutex);
+
+    pthread_join(stats_thread, NULL);
+    stats_thread_running = 0;
+
+    return stats_dump();
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_STATS_H
+#define UNIFYFS_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "unifyfs_configurator.h"
+
+/*
+ * Server statistics.
+ *
+ * For each operation type, the server counts the number of operations and
+ * errors, and keeps a histogram of operation latencies with power-of-two
+ * microsecond buckets. Gauges track the current value of server state
+ * such as storage usage and request queue depths. Counters and gauges are
+ * updated with atomic operations, so they may be updated from any thread
+ * without locking. A snapshot of all statistics is formatted as JSON.
+ */
+
+/* operation types */
+typedef enum {
+    /* client rpcs processed by request managers */
+    UNIFYFS_STAT_CLIENT_ATTACH = 0,
+    UNIFYFS_STAT_CLIENT_COMPACT,
+    UNIFYFS_STAT_CLIENT_FILESIZE,
+    UNIFYFS_STAT_CLIENT_LAMINATE,
+    UNIFYFS_STAT_CLIENT_METAGET,
+    UNIFYFS_STAT_CLIENT_METASET,
+    UNIFYFS_STAT_CLIENT_READ,
+    UNIFYFS_STAT_CLIENT_READTHROUGH,
+    UNIFYFS_STAT_CLIENT_SYNC,
+    UNIFYFS_STAT_CLIENT_TRANSFER,
+    UNIFYFS_STAT_CLIENT_TRUNCATE,
+    UNIFYFS_STAT_CLIENT_UNLINK,
+
+    /* point-to-point server rpcs handled */
+    UNIFYFS_STAT_P2P_ADD_EXTENTS,
+    UNIFYFS_STAT_P2P_FIND_EXTENTS,
+    UNIFYFS_STAT_P2P_FILESIZE,
+    UNIFYFS_STAT_P2P_LAMINATE,
+    UNIFYFS_STAT_P2P_METAGET,
+    UNIFYFS_STAT_P2P_METASET,
+    UNIFYFS_STAT_P2P_RELOCATE_EXTENTS,
+    UNIFYFS_STAT_P2P_TRUNCATE,
+
+    /* broadcast server rpcs handled */
+    UNIFYFS_STAT_BCAST_EXTENTS,
+    UNIFYFS_STAT_BCAST_FILEATTR,
+    UNIFYFS_STAT_BCAST_LAMINATE,
+    UNIFYFS_STAT_BCAST_READTHROUGH,
+    UNIFYFS_STAT_BCAST_TRANSFER,
+    UNIFYFS_STAT_BCAST_TRUNCATE,
+    UNIFYFS_STAT_BCAST_UNLINK,
+
+    /* chunk reads */
+    UNIFYFS_STAT_CHUNK_READ_REQUEST,  /* remote chunk reads served */
+    UNIFYFS_STAT_CHUNK_READ_RESPONSE, /* remote chunk read data received */
+
+    UNIFYFS_STAT_OP_COUNT
+} unifyfs_stat_op_e;
+
+/* gauges */
+typedef enum {
+    UNIFYFS_GAUGE_CLIENT_REQS = 0, /* client rpcs queued for processing */
+    UNIFYFS_GAUGE_READ_REQS,       /* active client read requests */
+    UNIFYFS_GAUGE_CHUNK_READS,     /* remote chunk reads being served */
+
+    UNIFYFS_GAUGE_COUNT
+} unifyfs_stat_gauge_e;
+
+/* number of latency histogram buckets, bucket 0 counts latencies below
+ * 1 usec, bucket i counts latencies in [2^(i-1), 2^i) usecs, and the
+ * last bucket counts all longer latencies */
+#define UNIFYFS_STAT_HIST_BUCKETS 28
+
+/* get start time of an operation, to pass to unifyfs_stats_record() */
+static inline uint64_t unifyfs_stats_start(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/* record completion of an operation started at start_ns, the operation
+ * is counted as an error when rc is nonzero */
+void unifyfs_stats_record(unifyfs_stat_op_e op, uint64_t start_ns, int rc);
+
+/* add delta to gauge */
+void unifyfs_stats_gauge_add(unifyfs_stat_gauge_e gauge, int64_t delta);
+
+/* count bytes copied out of client logs by threads running on the NUMA
+ * node of the log (local) or on another node (remote) */
+void unifyfs_stats_numa_copy(size_t local_bytes, size_t remote_bytes);
+
+/* get the histogram bucket for a latency in usecs */
+int unifyfs_stats_hist_bucket(uint64_t usecs);
+
+/* format a snapshot of the server statistics as a JSON object. On
+ * success, sets json to an allocated string the caller must free */
+int unifyfs_stats_to_json(char** json);
+
+/* read stats settings from server configuration, and start periodic
+ * dumps of the statistics to a JSON file in the runstate directory
+ * when enabled */
+int unifyfs_stats_init(unifyfs_cfg_t* cfg);
+
+/* stop periodic dumps, writing a final dump if enabled */
+int unifyfs_stats_fini(void);
+
+#endif /* UNIFYFS_STATS_H */
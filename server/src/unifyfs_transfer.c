@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <fcntl.h>
+
+#include "unifyfs_transfer.h"
+#include "unifyfs_inode.h"
+#include "unifyfs_reclaim.h"
+#include "margo_server.h"
+
+/* a batch of log reads, placed one after another in the data buffer */
+typedef struct {
+    int fd;                  /* destination file */
+    char* buf;               /* data buffer */
+    size_t buf_used;         /* bytes of buffer holding batch data */
+    size_t count;            /* reads in batch */
+    logio_io* ios;           /* log reads */
+    app_client** clients;    /* client of each log read */
+    off_t* file_offsets;     /* destination file offset of each read */
+    size_t written;          /* total bytes written */
+} transfer_batch;
+
+/* write count bytes of buf to fd at offset, retrying short writes */
+static int pwrite_all(int fd,
+                      const char* buf,
+                      size_t count,
+                      off_t offset)
+{
+    while (count > 0) {
+        ssize_t n = pwrite(fd, buf, count, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        buf += n;
+        count -= (size_t) n;
+        offset += (off_t) n;
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* read the log data of the batch, then write it to the destination file,
+ * merging reads that are contiguous in the file into one write */
+static int transfer_batch_flush(transfer_batch* tb)
+{
+    int ret = UNIFYFS_SUCCESS;
+    size_t i;
+
+    if (0 == tb->count) {
+        return UNIFYFS_SUCCESS;
+    }
+
+    for (i = 0; i < tb->count; i++) {
+        unifyfs_reclaim_read_begin(tb->clients[i]);
+    }
+    unifyfs_logio_read_batch(tb->ios, tb->count);
+    for (i = 0; i < tb->count; i++) {
+        unifyfs_reclaim_read_end(tb->clients[i]);
+        logio_io* io = tb->ios + i;
+        if ((UNIFYFS_SUCCESS != io->rc) || (io->nio != io->nbytes)) {
+            LOGERR("failed to read log data of client %d:%d "
+                   "(off=%zu, len=%zu) - %s",
+                   tb->clients[i]->app_id, tb->clients[i]->client_id,
+                   (size_t) io->log_offset, io->nbytes,
+                   unifyfs_rc_enum_description(io->rc));
+            ret = (UNIFYFS_SUCCESS != io->rc) ? io->rc : EIO;
+        }
+    }
+
+    i = 0;
+    while ((UNIFYFS_SUCCESS == ret) && (i < tb->count)) {
+        /* data of consecutive reads is adjacent in the buffer */
+        char* data = tb->ios[i].buf;
+        off_t offset = tb->file_offsets[i];
+        size_t len = tb->ios[i].nbytes;
+        for (i++; i < tb->count; i++) {
+            if (tb->file_offsets[i] != (offset + (off_t)len)) {
+                break;
+            }
+            len += tb->ios[i].nbytes;
+        }
+        ret = pwrite_all(tb->fd, data, len, offset);
+        if (ret != UNIFYFS_SUCCESS) {
+            LOGERR("pwrite(off=%zu, len=%zu) failed - %s",
+                   (size_t) offset, len, strerror(ret));
+        } else {
+            tb->written += len;
+        }
+    }
+
+    tb->count = 0;
+    tb->buf_used = 0;
+    return ret;
+}
+
+/* add the read of an extent piece to the batch, flushing it first if
+ * it is full */
+static int transfer_batch_add(transfer_batch* tb,
+                              app_client* client,
+                              off_t log_offset,
+                              size_t nbytes,
+                              off_t file_offset)
+{
+    if ((tb->count == UNIFYFS_TRANSFER_MAX_READS) ||
+        ((tb->buf_used + nbytes) > UNIFYFS_TRANSFER_BUF_SIZE)) {
+        int ret = transfer_batch_flush(tb);
+        if (ret != UNIFYFS_SUCCESS) {
+            return ret;
+        }
+    }
+
+    logio_io* io = tb->ios + tb->count;
+    memset(io, 0, sizeof(*io));
+    io->ctx = client->logio;
+    io->log_offset = log_offset;
+    io->nbytes = nbytes;
+    io->buf = tb->buf + tb->buf_used;
+    tb->clients[tb->count] = client;
+    tb->file_offsets[tb->count] = file_offset;
+    tb->buf_used += nbytes;
+    tb->count++;
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_transfer_local(int gfid,
+                           const char* dst_file,
+                           size_t* nbytes)
+{
+    *nbytes = 0;
+
+    unifyfs_file_attr_t attr;
+    int ret = unifyfs_inode_metaget(gfid, &attr);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get attributes of gfid=%d", gfid);
+        return ret;
+    }
+    if (!attr.is_laminated) {
+        LOGERR("only laminated files can be staged out (gfid=%d)", gfid);
+        return EINVAL;
+    }
+
+    size_t n_extents = 0;
+    struct extent_tree_node* extents = NULL;
+    ret = unifyfs_inode_get_extents(gfid, &n_extents, &extents);
+    if (ret != UNIFYFS_SUCCESS) {
+        LOGERR("failed to get extents of gfid=%d", gfid);
+        return ret;
+    }
+
+    /* most servers hold nothing of small files */
+    size_t n_local = 0;
+    for (size_t i = 0; i < n_extents; i++) {
+        if (extents[i].svr_rank == glb_pmi_rank) {
+            n_local++;
+        }
+    }
+    if (0 == n_local) {
+        free(extents);
+        return UNIFYFS_SUCCESS;
+    }
+
+    transfer_batch tb = { .fd = -1 };
+    tb.buf = malloc(UNIFYFS_TRANSFER_BUF_SIZE);
+    tb.ios = calloc(UNIFYFS_TRANSFER_MAX_READS, sizeof(logio_io));
+    tb.clients = calloc(UNIFYFS_TRANSFER_MAX_READS, sizeof(app_client*));
+    tb.file_offsets = calloc(UNIFYFS_TRANSFER_MAX_READS, sizeof(off_t));
+    if ((NULL == tb.buf) || (NULL == tb.ios) ||
+        (NULL == tb.clients) || (NULL == tb.file_offsets)) {
+        ret = ENOMEM;
+        goto out;
+    }
+
+    tb.fd = open(dst_file, O_WRONLY);
+    if (tb.fd < 0) {
+        ret = errno;
+        LOGERR("failed to open stage-out file %s - %s",
+               dst_file, strerror(ret));
+        goto out;
+    }
+
+    for (size_t i = 0; (i < n_extents) && (ret == UNIFYFS_SUCCESS); i++) {
+        struct extent_tree_node* ext = extents + i;
+        if (ext->svr_rank != glb_pmi_rank) {
+            continue;
+        }
+        app_client* client = get_app_client(ext->app_id, ext->cli_id);
+        if ((NULL == client) || (NULL == client->logio)) {
+            LOGERR("log of client %d:%d holding gfid=%d data not found",
+                   ext->app_id, ext->cli_id, gfid);
+            ret = ENOENT;
+            break;
+        }
+
+        /* split extents larger than the buffer */
+        size_t length = ext->end - ext->start + 1;
+        size_t done = 0;
+        while ((done < length) && (ret == UNIFYFS_SUCCESS)) {
+            size_t n = length - done;
+            if (n > UNIFYFS_TRANSFER_BUF_SIZE) {
+                n = UNIFYFS_TRANSFER_BUF_SIZE;
+            }
+            ret = transfer_batch_add(&tb, client,
+                                     (off_t)(ext->pos + done), n,
+                                     (off_t)(ext->start + done));
+            done += n;
+        }
+    }
+    if (ret == UNIFYFS_SUCCESS) {
+        ret = transfer_batch_flush(&tb);
+    }
+    if ((ret == UNIFYFS_SUCCESS) && (0 != fsync(tb.fd))) {
+        ret = errno;
+        LOGERR("fsync(%s) failed - %s", dst_file, strerror(ret));
+    }
+
+    LOGINFO("staged out %zu bytes of gfid=%d in %zu extents to %s",
+            tb.written, gfid, n_local, dst_file);
+    *nbytes = tb.written;
+
+out:
+    if (tb.fd >= 0) {
+        close(tb.fd);
+    }
+    free(tb.buf);
+    free(tb.ios);
+    free(tb.clients);
+    free(tb.file_offsets);
+    free(extents);
+    return ret;
+}
+
+struct unifyfs_transfer_req {
+    int gfid;
+    const char* dst_file;
+    ABT_thread thread;  /* i/o thread, or ABT_THREAD_NULL if run inline */
+    size_t nbytes;
+    int ret;
+};
+
+/* run a local stage-out, for ABT_thread_create */
+static void transfer_local_run(void* arg)
+{
+    unifyfs_transfer_req* req = (unifyfs_transfer_req*) arg;
+    req->ret = unifyfs_transfer_local(req->gfid, req->dst_file,
+                                      &(req->nbytes));
+}
+
+int unifyfs_transfer_local_start(int gfid,
+                                 const char* dst_file,
+                                 unifyfs_transfer_req** req)
+{
+    unifyfs_transfer_req* treq = calloc(1, sizeof(*treq));
+    if (NULL == treq) {
+        return ENOMEM;
+    }
+    treq->gfid = gfid;
+    treq->dst_file = dst_file;
+    treq->thread = ABT_THREAD_NULL;
+
+    ABT_pool pool = margo_server_io_pool();
+    if ((ABT_POOL_NULL == pool) ||
+        (ABT_thread_create(pool, transfer_local_run, treq,
+                           ABT_THREAD_ATTR_NULL, &(treq->thread))
+         != ABT_SUCCESS)) {
+        /* no i/o threads, write it now */
+        treq->thread = ABT_THREAD_NULL;
+        transfer_local_run(treq);
+    }
+
+    *req = treq;
+    return UNIFYFS_SUCCESS;
+}
+
+int unifyfs_transfer_local_wait(unifyfs_transfer_req* req,
+                                size_t* nbytes)
+{
+    if (ABT_THREAD_NULL != req->thread) {
+        /* waits for the thread to complete */
+        ABT_thread_free(&(req->thread));
+    }
+    int ret = req->ret;
+    if (NULL != nbytes) {
+        *nbytes = req->nbytes;
+    }
+    free(req);
+    return ret;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#ifndef UNIFYFS_TRANSFER_H
+#define UNIFYFS_TRANSFER_H
+
+#include "unifyfs_global.h"
+
+/*
+ * Server-side stage-out.
+ *
+ * Once a file is laminated, every server has all of its extents, each of
+ * which records the server holding the data. To stage out the file, the
+ * server of the requesting client broadcasts the destination path, and
+ * each server reads the extents it holds from its local client logs and
+ * writes them with pwrite() at their file offsets to the destination. All
+ * servers write at once, and no file data moves between servers.
+ */
+
+/* write the data of the laminated file held in the logs of local clients
+ * to dst_file, which must already exist. Sets nbytes to the number of
+ * bytes written */
+int unifyfs_transfer_local(int gfid,
+                           const char* dst_file,
+                           size_t* nbytes);
+
+/* a local stage-out running on an i/o thread */
+typedef struct unifyfs_transfer_req unifyfs_transfer_req;
+
+/* start unifyfs_transfer_local() on an i/o thread, so the calling rpc
+ * handler is free while the data is written. dst_file must remain valid
+ * until unifyfs_transfer_local_wait() returns */
+int unifyfs_transfer_local_start(int gfid,
+                                 const char* dst_file,
+                                 unifyfs_transfer_req** req);
+
+/* wait for a local stage-out to complete and free it, returns its result
+ * and sets nbytes to the number of bytes written */
+int unifyfs_transfer_local_wait(unifyfs_transfer_req* req,
+                                size_t* nbytes);
+
+#endif /* UNIFYFS_TRANSFER_H */
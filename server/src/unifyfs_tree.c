@@ -15,9 +15,134 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <strings.h>
 
 #include "unifyfs_tree.h"
 
+/* compute the parent and children of the given rank in a k-ary tree
+ * rooted at rank 0, the child rank list must have room for k entries */
+static void tree_kary(int rank, int ranks, int k, unifyfs_tree_t* t)
+{
+    int i;
+
+    /* compute rank of our parent if we have one */
+    if (rank > 0) {
+        t->parent_rank = (rank - 1) / k;
+    }
+
+    /* identify ranks of what would be leftmost
+     * and rightmost children */
+    int left  = rank * k + 1;
+    int right = rank * k + k;
+
+    /* if we have at least one child,
+     * compute number of children and list of child ranks */
+    if (left < ranks) {
+        /* adjust right child in case we don't have a full set of k */
+        if (right >= ranks) {
+            right = ranks - 1;
+        }
+
+        /* compute number of children */
+        t->child_count = right - left + 1;
+
+        /* fill in rank for each child */
+        for (i = 0; i < t->child_count; i++) {
+            t->child_ranks[i] = left + i;
+        }
+    }
+}
+
+/* return the span of the subtree below the given rank in a binomial
+ * tree rooted at rank 0, children are at rank + 2^i for 2^i < span */
+static int binomial_span(int rank, int ranks)
+{
+    if (rank > 0) {
+        /* lowest set bit of our rank */
+        return rank & -rank;
+    }
+
+    /* root spans all ranks */
+    int span = 1;
+    while (span < ranks) {
+        span <<= 1;
+    }
+    return span;
+}
+
+/* return the maximum number of children of the given rank
+ * in a binomial tree rooted at rank 0 */
+static int binomial_max_children(int rank, int ranks)
+{
+    int count = 0;
+    int mask;
+    int span = binomial_span(rank, ranks);
+    for (mask = 1; mask < span; mask <<= 1) {
+        count++;
+    }
+    return count;
+}
+
+/* compute the parent and children of the given rank in a binomial tree
+ * rooted at rank 0. children are listed from the largest subtree to the
+ * smallest, so the deepest subtrees are started first */
+static void tree_binomial(int rank, int ranks, unifyfs_tree_t* t)
+{
+    int mask;
+
+    /* parent is our rank with the lowest set bit cleared */
+    if (rank > 0) {
+        t->parent_rank = rank & (rank - 1);
+    }
+
+    int span = binomial_span(rank, ranks);
+    for (mask = span >> 1; mask > 0; mask >>= 1) {
+        int child = rank + mask;
+        if (child < ranks) {
+            t->child_ranks[t->child_count] = child;
+            t->child_count++;
+        }
+    }
+}
+
+/* return the number of levels below the root of a tree of the given
+ * shape and size */
+static int tree_depth(int ranks, unifyfs_tree_type_e type, int k)
+{
+    int depth = 0;
+    if (ranks <= 1) {
+        return 0;
+    }
+
+    if (type == UNIFYFS_TREE_BINOMIAL) {
+        /* the level of a rank is the number of bits set in it, the
+         * deepest is the last rank or the one below its highest bit
+         * with all lower bits set */
+        int last = ranks - 1;
+        int bits = 0;
+        int high = 0;
+        while ((last >> (high + 1)) > 0) {
+            high++;
+        }
+        for (int r = last; r > 0; r &= (r - 1)) {
+            bits++;
+        }
+        depth = (bits > high) ? bits : high;
+    } else if (k == 1) {
+        depth = ranks - 1;
+    } else {
+        /* add full levels until all ranks are covered */
+        long covered = 1;
+        long width = 1;
+        while (covered < ranks) {
+            width *= k;
+            covered += width;
+            depth++;
+        }
+    }
+    return depth;
+}
+
 /**
  * @brief given the process's rank and the number of ranks, this computes a
  * k-ary tree rooted at rank 0, the structure records the number of children of
@@ -35,9 +160,38 @@ int unifyfs_tree_init(
     int root,          /* rank of root of tree */
     int k,             /* degree of k-ary tree */
     unifyfs_tree_t* t) /* output tree structure */
+{
+    return unifyfs_tree_init_type(rank, ranks, root,
+                                  UNIFYFS_TREE_K_ARY, k, t);
+}
+
+/**
+ * @brief given the process's rank and the number of ranks, this computes a
+ * tree of the given shape rooted at the given root rank, the structure
+ * records the number of children of the local rank and the list of their
+ * ranks
+ *
+ * @param rank rank of calling process
+ * @param ranks number of ranks in tree
+ * @param root rank of root of tree
+ * @param type shape of tree
+ * @param k degree of k-ary tree (ignored for binomial trees)
+ * @param t output tree structure
+ */
+int unifyfs_tree_init_type(
+    int rank,                 /* rank of calling process */
+    int ranks,                /* number of ranks in tree */
+    int root,                 /* rank of root of tree */
+    unifyfs_tree_type_e type, /* shape of tree */
+    int k,                    /* degree of k-ary tree */
+    unifyfs_tree_t* t)        /* output tree structure */
 {
     int i;
 
+    if ((type == UNIFYFS_TREE_K_ARY) && (k < 1)) {
+        return EINVAL;
+    }
+
     /* compute distance from our rank to root,
      * rotate ranks to put root as rank 0 */
     rank -= root;
@@ -53,9 +207,13 @@ int unifyfs_tree_init(
     t->parent_rank = -1;
     t->child_count = 0;
     t->child_ranks = NULL;
+    t->depth       = tree_depth(ranks, type, k);
 
     /* compute the maximum number of children this task may have */
     int max_children = k;
+    if (type == UNIFYFS_TREE_BINOMIAL) {
+        max_children = binomial_max_children(rank, ranks);
+    }
 
     /* allocate memory to hold list of children ranks */
     if (max_children > 0) {
@@ -73,31 +231,10 @@ int unifyfs_tree_init(
         t->child_ranks[i] = -1;
     }
 
-    /* compute rank of our parent if we have one */
-    if (rank > 0) {
-        t->parent_rank = (rank - 1) / k;
-    }
-
-    /* identify ranks of what would be leftmost
-     * and rightmost children */
-    int left  = rank * k + 1;
-    int right = rank * k + k;
-
-    /* if we have at least one child,
-     * compute number of children and list of child ranks */
-    if (left < ranks) {
-        /* adjust right child in case we don't have a full set of k */
-        if (right >= ranks) {
-            right = ranks - 1;
-        }
-
-        /* compute number of children */
-        t->child_count = right - left + 1;
-
-        /* fill in rank for each child */
-        for (i = 0; i < t->child_count; i++) {
-            t->child_ranks[i] = left + i;
-        }
+    if (type == UNIFYFS_TREE_BINOMIAL) {
+        tree_binomial(rank, ranks, t);
+    } else {
+        tree_kary(rank, ranks, k, t);
     }
 
     /* rotate tree neighbor ranks to use global ranks */
@@ -127,6 +264,30 @@ int unifyfs_tree_init(
     return 0;
 }
 
+int unifyfs_tree_type_parse(const char* name, unifyfs_tree_type_e* type)
+{
+    if ((NULL == name) || (NULL == type)) {
+        return EINVAL;
+    }
+
+    if (0 == strcasecmp(name, "kary")) {
+        *type = UNIFYFS_TREE_K_ARY;
+    } else if (0 == strcasecmp(name, "binomial")) {
+        *type = UNIFYFS_TREE_BINOMIAL;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+const char* unifyfs_tree_type_name(unifyfs_tree_type_e type)
+{
+    if (type == UNIFYFS_TREE_BINOMIAL) {
+        return "binomial";
+    }
+    return "kary";
+}
+
 void unifyfs_tree_free(unifyfs_tree_t* t)
 {
     /* free child rank list */
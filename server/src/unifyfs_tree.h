@@ -18,6 +18,12 @@
 #include <abt.h>
 #include "unifyfs_meta.h"
 
+/* supported tree shapes */
+typedef enum {
+    UNIFYFS_TREE_K_ARY = 0, /* each rank has up to k children */
+    UNIFYFS_TREE_BINOMIAL,  /* children at power-of-two rank distances */
+} unifyfs_tree_type_e;
+
 /* define tree structure */
 typedef struct {
     int rank;         /* global rank of calling process */
@@ -25,6 +31,7 @@ typedef struct {
     int parent_rank;  /* parent rank, -1 if root */
     int child_count;  /* number of children */
     int* child_ranks; /* list of child ranks */
+    int depth;        /* number of levels below the root of the tree */
 } unifyfs_tree_t;
 
 /* given the process's rank and the number of ranks, this computes a k-ary
@@ -38,6 +45,24 @@ int unifyfs_tree_init(
     unifyfs_tree_t* t /* output tree structure */
 );
 
+/* same as unifyfs_tree_init, but computes a tree of the given shape.
+ * k is the degree of a k-ary tree, and is ignored for binomial trees */
+int unifyfs_tree_init_type(
+    int rank,                 /* rank of calling process */
+    int ranks,                /* number of ranks in tree */
+    int root,                 /* rank of root process */
+    unifyfs_tree_type_e type, /* shape of tree */
+    int k,                    /* degree of k-ary tree */
+    unifyfs_tree_t* t         /* output tree structure */
+);
+
+/* parse a tree shape name ("kary" or "binomial"),
+ * returns EINVAL for unknown names */
+int unifyfs_tree_type_parse(const char* name, unifyfs_tree_type_e* type);
+
+/* return the name of the given tree shape */
+const char* unifyfs_tree_type_name(unifyfs_tree_type_e type);
+
 /* free resources allocated in unifyfs_tree_init */
 void unifyfs_tree_free(unifyfs_tree_t* t);
 
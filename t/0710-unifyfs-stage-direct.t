@@ -0,0 +1,90 @@
+#!/bin/bash
+#
+# Test direct stage-out by the unifyfs servers with unifyfs-stage
+#
+
+test_description="Test direct stage-out with unifyfs-stage"
+
+. $(dirname $0)/sharness.sh
+
+test_expect_success "unifyfs-stage exists" '
+    test_path_is_file ${SHARNESS_BUILD_DIRECTORY}/util/unifyfs-stage/src/unifyfs-stage
+'
+test_expect_success "testing temp dir exists" '
+    test_path_is_dir  ${UNIFYFS_TEST_TMPDIR}
+'
+
+mkdir -p ${UNIFYFS_TEST_TMPDIR}/config_0710
+mkdir -p ${UNIFYFS_TEST_TMPDIR}/stage_source
+mkdir -p ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710
+
+test_expect_success "stage testing dirs exist" '
+    test_path_is_dir  ${UNIFYFS_TEST_TMPDIR}/config_0710
+    test_path_is_dir  ${UNIFYFS_TEST_TMPDIR}/stage_source
+    test_path_is_dir  ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710
+'
+
+dd if=/dev/urandom bs=4M count=1 of=${UNIFYFS_TEST_TMPDIR}/stage_source/source_0710.file
+
+test_expect_success "source.file exists" '
+    test_path_is_file ${UNIFYFS_TEST_TMPDIR}/stage_source/source_0710.file
+'
+
+rm -f ${UNIFYFS_TEST_TMPDIR}/config_0710/*
+rm -f ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/*
+
+# a destination that must survive a failed stage-out
+echo "keep me" > ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/existing_0710.file
+
+echo "\"${UNIFYFS_TEST_TMPDIR}/stage_source/source_0710.file\" \"${UNIFYFS_TEST_MOUNT}/intermediate_0710.file\""  > ${UNIFYFS_TEST_TMPDIR}/config_0710/test_IN.manifest
+echo "\"${UNIFYFS_TEST_MOUNT}/intermediate_0710.file\" \"${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/destination_0710.file\"" > ${UNIFYFS_TEST_TMPDIR}/config_0710/test_OUT.manifest
+echo "\"${UNIFYFS_TEST_MOUNT}/missing_0710.file\" \"${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/existing_0710.file\"" > ${UNIFYFS_TEST_TMPDIR}/config_0710/test_MISSING.manifest
+
+test_expect_success "config_0710 directory now has manifest files" '
+    test_path_is_file  ${UNIFYFS_TEST_TMPDIR}/config_0710/test_IN.manifest
+    test_path_is_file  ${UNIFYFS_TEST_TMPDIR}/config_0710/test_OUT.manifest
+    test_path_is_file  ${UNIFYFS_TEST_TMPDIR}/config_0710/test_MISSING.manifest
+'
+
+$JOB_RUN_COMMAND ${SHARNESS_BUILD_DIRECTORY}/util/unifyfs-stage/src/unifyfs-stage -m ${UNIFYFS_TEST_MOUNT} ${UNIFYFS_TEST_TMPDIR}/config_0710/test_IN.manifest > ${UNIFYFS_TEST_TMPDIR}/config_0710/stage_IN_output.OUT 2>&1
+
+$JOB_RUN_COMMAND ${SHARNESS_BUILD_DIRECTORY}/util/unifyfs-stage/src/unifyfs-stage -D -m ${UNIFYFS_TEST_MOUNT} ${UNIFYFS_TEST_TMPDIR}/config_0710/test_OUT.manifest > ${UNIFYFS_TEST_TMPDIR}/config_0710/stage_OUT_output.OUT 2>&1
+
+test_expect_success "input file has been staged out by the servers" '
+    test_path_is_file ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/destination_0710.file
+'
+
+test_expect_success "direct output is identical to initial input" '
+    test_cmp ${UNIFYFS_TEST_TMPDIR}/stage_source/source_0710.file ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/destination_0710.file
+'
+
+$JOB_RUN_COMMAND ${SHARNESS_BUILD_DIRECTORY}/util/unifyfs-stage/src/unifyfs-stage -D -m ${UNIFYFS_TEST_MOUNT} ${UNIFYFS_TEST_TMPDIR}/config_0710/test_MISSING.manifest > ${UNIFYFS_TEST_TMPDIR}/config_0710/stage_MISSING_output.OUT 2>&1
+
+test_expect_success "failed direct stage-out leaves destination intact" '
+    echo "keep me" > ${UNIFYFS_TEST_TMPDIR}/config_0710/existing.expect &&
+    test_cmp ${UNIFYFS_TEST_TMPDIR}/config_0710/existing.expect ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710/existing_0710.file
+'
+
+test_expect_success "successful direct stage-out leaves no temporary files" '
+    test -z "$(ls ${UNIFYFS_TEST_TMPDIR}/stage_destination_0710 | grep "\.unifyfs\.")"
+'
+
+# the servers write into a temporary file that must not replace the
+# destination when the stage-out fails after it was created
+mkdir -p ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710
+echo "keep me" > ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710/existing_0710.file
+chmod a-w ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710
+test -w ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710 || test_set_prereq READONLY_DIR
+echo "\"${UNIFYFS_TEST_MOUNT}/intermediate_0710.file\" \"${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710/existing_0710.file\"" > ${UNIFYFS_TEST_TMPDIR}/config_0710/test_READONLY.manifest
+
+$JOB_RUN_COMMAND ${SHARNESS_BUILD_DIRECTORY}/util/unifyfs-stage/src/unifyfs-stage -D -m ${UNIFYFS_TEST_MOUNT} ${UNIFYFS_TEST_TMPDIR}/config_0710/test_READONLY.manifest > ${UNIFYFS_TEST_TMPDIR}/config_0710/stage_READONLY_output.OUT 2>&1
+
+test_expect_success READONLY_DIR "failed direct stage-out into a read-only directory leaves destination intact" '
+    echo "keep me" > ${UNIFYFS_TEST_TMPDIR}/config_0710/readonly.expect &&
+    test_cmp ${UNIFYFS_TEST_TMPDIR}/config_0710/readonly.expect ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710/existing_0710.file &&
+    test -z "$(ls ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710 | grep "\.unifyfs\.")"
+'
+
+chmod u+w ${UNIFYFS_TEST_TMPDIR}/stage_readonly_0710
+
+test_done
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "client_reclaim.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test for the client log chunk lifecycle.
+ *
+ * Chunks of unsynced data are released once nothing references them,
+ * chunks of synced data only when the server says so, and a write that
+ * finds the log full syncs and waits for the server to release chunks.
+ * The server is replaced by the sync and release operations below.
+ */
+
+#define CHUNK_SZ (64 * 1024)
+#define MEM_CHUNKS 4
+#define SPILL_CHUNKS 4
+
+static logio_context* cli;
+
+/* state of the fake server */
+static int sync_calls;
+static int release_calls;
+static off_t sync_pos;             /* log data marked synced on sync */
+static size_t sync_len;
+static size_t sync_reclaimable;    /* bytes reported reclaimable on sync */
+static uint64_t release_chunks[8]; /* chunks released by the server */
+static size_t release_n;
+static int release_after;          /* release calls before chunks are out */
+
+/* sync all files, marking the synced log data */
+static int fake_sync(void)
+{
+    sync_calls++;
+    if (sync_len > 0) {
+        client_reclaim_set_state(sync_pos, sync_len, LOG_CHUNK_SYNCED);
+        client_reclaim_unsynced();
+        client_reclaim_set_reclaimable(sync_reclaimable);
+    }
+    return UNIFYFS_SUCCESS;
+}
+
+/* release chunks once release_after calls have been made */
+static int fake_release(uint64_t* chunks, size_t max_chunks,
+                        size_t* n_chunks, size_t* reclaimable)
+{
+    release_calls++;
+    *n_chunks = 0;
+    if (release_calls <= release_after) {
+        /* still in the server delay */
+        return UNIFYFS_SUCCESS;
+    }
+    for (size_t i = 0; (i < release_n) && (i < max_chunks); i++) {
+        chunks[i] = release_chunks[i];
+    }
+    *n_chunks = release_n;
+    *reclaimable = 0;
+    release_n = 0;
+    return UNIFYFS_SUCCESS;
+}
+
+static const client_reclaim_ops fake_ops = {
+    .sync = fake_sync,
+    .release = fake_release
+};
+
+/* reset the fake server */
+static void reset_server(void)
+{
+    sync_calls = 0;
+    release_calls = 0;
+    sync_len = 0;
+    sync_reclaimable = 0;
+    release_n = 0;
+    release_after = 0;
+}
+
+/* allocate n_chunks of log data that an unsynced extent references */
+static int write_data(size_t n_chunks, off_t* log_off)
+{
+    size_t len = n_chunks * CHUNK_SZ;
+    int rc = unifyfs_logio_alloc(cli, len, log_off);
+    if (rc == UNIFYFS_SUCCESS) {
+        client_reclaim_set_state(*log_off, len, LOG_CHUNK_UNSYNCED);
+        client_reclaim_ref(*log_off, len, 1);
+    }
+    return rc;
+}
+
+/* get the index of the chunk holding a log offset */
+static size_t chunk_of(off_t log_off)
+{
+    size_t ndx = (size_t) -1;
+    off_t chunk_off;
+    unifyfs_logio_get_chunk(cli, log_off, &ndx, &chunk_off);
+    return ndx;
+}
+
+/* get the state of the chunk holding a log offset */
+static int state_of(off_t log_off)
+{
+    return client_reclaim_chunk_state(chunk_of(log_off));
+}
+
+int main(int argc, char** argv)
+{
+    char spill_dir[64];
+    char shmem_sz[32];
+    char spill_sz[32];
+    char chunk_sz[32];
+    size_t pgsz = get_page_size();
+    size_t unsynced, synced, reclaimable;
+    int app_id = 9903;
+    int client_id = (int) getpid();
+    int rc;
+
+    plan(NO_PLAN);
+
+    snprintf(spill_dir, sizeof(spill_dir), "/tmp/reclaim.%d", client_id);
+    mkdir(spill_dir, 0700);
+    snprintf(shmem_sz, sizeof(shmem_sz), "%zu",
+             pgsz + MEM_CHUNKS * CHUNK_SZ);
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             pgsz + SPILL_CHUNKS * CHUNK_SZ);
+    snprintf(chunk_sz, sizeof(chunk_sz), "%d", CHUNK_SZ);
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = shmem_sz;
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = spill_dir;
+    cfg.logio_chunk_size = chunk_sz;
+
+    rc = unifyfs_logio_init_client(app_id, client_id, &cfg, &cli);
+    ok(rc == UNIFYFS_SUCCESS && cli != NULL, "client logio initialized");
+    if (NULL == cli) {
+        done_testing();
+    }
+
+    rc = client_reclaim_init(cli, 1000, &fake_ops);
+    ok(rc == UNIFYFS_SUCCESS && client_reclaim_enabled(),
+       "log chunk tracking initialized");
+
+    /* unsynced data that is completely overwritten is released */
+    off_t off_a, off_b, off_c, off_d, off_e, off_f;
+    rc = write_data(2, &off_a);
+    ok(rc == UNIFYFS_SUCCESS &&
+       state_of(off_a) == LOG_CHUNK_UNSYNCED &&
+       state_of(off_a + CHUNK_SZ) == LOG_CHUNK_UNSYNCED,
+       "written chunks are unsynced");
+    client_reclaim_ref(off_a, 2 * CHUNK_SZ, 0);
+    client_reclaim_unsynced();
+    client_reclaim_get_counts(&unsynced, &synced, &reclaimable);
+    ok(state_of(off_a) == LOG_CHUNK_FREE &&
+       state_of(off_a + CHUNK_SZ) == LOG_CHUNK_FREE &&
+       unsynced == 2 * CHUNK_SZ,
+       "overwritten unsynced chunks are released");
+
+    /* a partially overwritten chunk is kept */
+    rc = write_data(2, &off_b);
+    client_reclaim_ref(off_b, CHUNK_SZ + (CHUNK_SZ / 2), 0);
+    client_reclaim_unsynced();
+    ok(rc == UNIFYFS_SUCCESS &&
+       state_of(off_b) == LOG_CHUNK_FREE &&
+       state_of(off_b + CHUNK_SZ) == LOG_CHUNK_UNSYNCED,
+       "partially overwritten unsynced chunk is kept");
+
+    /* synced data is not released by the client */
+    rc = write_data(1, &off_c);
+    client_reclaim_set_state(off_c, CHUNK_SZ, LOG_CHUNK_SYNCED);
+    client_reclaim_ref(off_c, CHUNK_SZ, 0);
+    client_reclaim_unsynced();
+    ok(rc == UNIFYFS_SUCCESS && state_of(off_c) == LOG_CHUNK_SYNCED,
+       "synced chunk is not released locally");
+
+    /* synced chunks are released when the server says so, but not
+     * chunks that are still unsynced */
+    reset_server();
+    release_chunks[0] = chunk_of(off_c);
+    release_chunks[1] = chunk_of(off_b + CHUNK_SZ);
+    release_n = 2;
+    client_reclaim_synced();
+    client_reclaim_get_counts(&unsynced, &synced, &reclaimable);
+    ok(state_of(off_c) == LOG_CHUNK_FREE && synced == CHUNK_SZ,
+       "synced chunk released by server is freed");
+    ok(state_of(off_b + CHUNK_SZ) == LOG_CHUNK_UNSYNCED,
+       "unsynced chunk released by server is kept");
+
+    client_reclaim_ref(off_b + CHUNK_SZ, CHUNK_SZ / 2, 0);
+    client_reclaim_unsynced();
+
+    /* fill the log, half with unsynced and half with synced data */
+    rc = write_data(4, &off_d);
+    rc |= write_data(4, &off_e);
+    client_reclaim_set_state(off_e, 4 * CHUNK_SZ, LOG_CHUNK_SYNCED);
+    ok(rc == UNIFYFS_SUCCESS, "log filled");
+    rc = unifyfs_logio_alloc(cli, CHUNK_SZ, &off_f);
+    ok(rc == ENOSPC, "allocation in full log fails with ENOSPC");
+
+    /* on ENOSPC, the client syncs, then waits for the server to release
+     * the synced chunks it reports as reclaimable */
+    reset_server();
+    sync_pos = off_d;
+    sync_len = 4 * CHUNK_SZ;
+    sync_reclaimable = 4 * CHUNK_SZ;
+    for (size_t i = 0; i < 4; i++) {
+        release_chunks[i] = chunk_of(off_e + (off_t)(i * CHUNK_SZ));
+    }
+    release_n = 4;
+    release_after = 1;
+    ok(client_reclaim_log_space(), "log space reclaimed on ENOSPC");
+    ok(sync_calls == 1 && release_calls == 2,
+       "synced once and retried release after delay (%d syncs, %d releases)",
+       sync_calls, release_calls);
+    ok(state_of(off_d) == LOG_CHUNK_SYNCED && state_of(off_e) == LOG_CHUNK_FREE,
+       "only chunks released by server are freed");
+    rc = unifyfs_logio_alloc(cli, 4 * CHUNK_SZ, &off_f);
+    ok(rc == UNIFYFS_SUCCESS, "allocation succeeds after reclaim");
+
+    /* nothing is reclaimed when all data is still referenced */
+    reset_server();
+    ok(!client_reclaim_log_space() && sync_calls == 1 && release_calls == 0,
+       "no log space reclaimed when all data is referenced");
+
+    client_reclaim_fini();
+    ok(!client_reclaim_enabled(), "log chunk tracking finalized");
+
+    unifyfs_logio_close(cli, 0);
+    rmdir(spill_dir);
+
+    /* remove the shmem region */
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "logio_mem.%d.%d",
+             app_id, client_id);
+    shm_unlink(shm_name);
+
+    done_testing();
+}
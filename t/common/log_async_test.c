@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "unifyfs_log.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and benchmark for asynchronous logging.
+ *
+ * Several threads log bursts of debug messages, first written directly
+ * and then through the background writer, reporting the time spent in
+ * logging calls per message for each. Checks every asynchronous message
+ * is either written to the log or counted as dropped, and that written
+ * messages are intact. Also checks that the writer keeps messages of
+ * different threads in order, keeps long messages whole, writes errors
+ * before LOGERR() returns, and writes queued messages at exit.
+ */
+
+#define NUM_THREADS 8
+#define BURST_MSGS 64
+#define BURST_PAUSE_USEC 2000
+
+static int msgs_per_thread = 16384;
+static double thread_secs[NUM_THREADS];
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1.0e9);
+}
+
+static void* log_thread(void* arg)
+{
+    long id = (long) arg;
+    double secs = 0.0;
+    int i = 0;
+    while (i < msgs_per_thread) {
+        double start = now_secs();
+        for (int b = 0; (b < BURST_MSGS) && (i < msgs_per_thread); b++) {
+            LOGDBG("thread=%ld msg=%d offset=%zu length=%zu",
+                   id, i, (size_t)i * 4096, (size_t)4096);
+            i++;
+        }
+        secs += now_secs() - start;
+        usleep(BURST_PAUSE_USEC);
+    }
+    thread_secs[id] = secs;
+    return NULL;
+}
+
+/* run the logging threads, returns the time in logging calls per
+ * message in usecs */
+static double run_threads(void)
+{
+    pthread_t threads[NUM_THREADS];
+    for (long t = 0; t < NUM_THREADS; t++) {
+        pthread_create(&threads[t], NULL, log_thread, (void*)t);
+    }
+    double secs = 0.0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        secs += thread_secs[t];
+    }
+    return (secs * 1.0e6) / ((double)NUM_THREADS * msgs_per_thread);
+}
+
+/* count the intact test messages in the log file */
+static long count_messages(const char* file, int* garbled)
+{
+    char line[4096];
+    long count = 0;
+    *garbled = 0;
+    FILE* fp = fopen(file, "r");
+    if (NULL == fp) {
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        char* msg = strstr(line, "thread=");
+        if (NULL != msg) {
+            long id;
+            int i;
+            size_t off, len;
+            if ((4 == sscanf(msg, "thread=%ld msg=%d offset=%zu length=%zu",
+                             &id, &i, &off, &len)) &&
+                (off == ((size_t)i * 4096)) && (len == 4096)) {
+                count++;
+            } else {
+                (*garbled)++;
+            }
+        }
+    }
+    fclose(fp);
+    return count;
+}
+
+/* find the line holding tag in the log file, returns its line number
+ * or -1, and copies the line to buf */
+static int find_line(const char* file, const char* tag,
+                     char* buf, size_t size)
+{
+    char line[8192];
+    int lineno = 0;
+    FILE* fp = fopen(file, "r");
+    if (NULL == fp) {
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        lineno++;
+        if (NULL != strstr(line, tag)) {
+            fclose(fp);
+            snprintf(buf, size, "%s", line);
+            return lineno;
+        }
+    }
+    fclose(fp);
+    return -1;
+}
+
+static void* order_thread(void* arg)
+{
+    LOGDBG("order=1");
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        msgs_per_thread = atoi(argv[1]);
+    }
+
+    plan(NO_PLAN);
+
+    char sync_file[] = "/tmp/unifyfs_log_sync.XXXXXX";
+    char async_file[] = "/tmp/unifyfs_log_async.XXXXXX";
+    close(mkstemp(sync_file));
+    close(mkstemp(async_file));
+
+    unifyfs_set_log_level(LOG_DBG);
+
+    /* messages written directly by each thread */
+    ok(unifyfs_log_open(sync_file) == 0, "open log %s", sync_file);
+    double sync_usec = run_threads();
+    unifyfs_log_close();
+
+    int garbled;
+    long total = (long)NUM_THREADS * msgs_per_thread;
+    ok(count_messages(sync_file, &garbled) == total,
+       "direct logging wrote %ld messages (%.3f usec/msg)",
+       total, sync_usec);
+
+    /* messages queued for the background writer */
+    ok(unifyfs_log_open(async_file) == 0, "open log %s", async_file);
+    ok(unifyfs_log_async_start() == 0, "start log writer");
+    double async_usec = run_threads();
+    unsigned long dropped = unifyfs_log_dropped();
+    unifyfs_log_close();
+
+    long written = count_messages(async_file, &garbled);
+    ok(written + (long)dropped == total,
+       "async logging wrote %ld and dropped %lu of %ld messages "
+       "(%.3f usec/msg, %.1fx faster)",
+       written, dropped, total, async_usec, sync_usec / async_usec);
+    ok(garbled == 0, "async log messages are intact");
+
+    /* logging after the writer stops goes directly to the log */
+    ok(unifyfs_log_open(async_file) == 0, "reopen log %s", async_file);
+    LOGDBG("thread=%d msg=%d offset=%d length=%d", 0, 0, 0, 4096);
+    unifyfs_log_close();
+    ok(count_messages(async_file, &garbled) == (written + 1),
+       "direct logging after writer stops");
+
+    /* messages of different threads are written in the order logged,
+     * long messages are kept whole, and timestamps have microseconds */
+    char line[8192];
+    char big[4000];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    ok(unifyfs_log_open(async_file) == 0, "reopen log %s", async_file);
+    ok(unifyfs_log_async_start() == 0, "restart log writer");
+    LOGDBG("order=0");
+    pthread_t t;
+    pthread_create(&t, NULL, order_thread, NULL);
+    pthread_join(t, NULL);
+    LOGDBG("order=2 big=%s", big);
+
+    /* an error is in the log as soon as LOGERR() returns */
+    LOGERR("order=3 error");
+    ok(find_line(async_file, "order=3", line, sizeof(line)) > 0,
+       "error written before LOGERR() returns");
+    unifyfs_log_close();
+
+    int l0 = find_line(async_file, "order=0", line, sizeof(line));
+    int l1 = find_line(async_file, "order=1", line, sizeof(line));
+    int l2 = find_line(async_file, "order=2", line, sizeof(line));
+    ok((l0 > 0) && (l0 < l1) && (l1 < l2),
+       "messages of different threads are in order (%d, %d, %d)",
+       l0, l1, l2);
+    char* msg = strstr(line, "big=");
+    ok((NULL != msg) && (0 == strncmp(msg + 4, big, strlen(big))),
+       "%zu byte message is intact", strlen(big));
+    int year, mon, day, hour, min, sec, usec, nchars = 0;
+    ok((7 == sscanf(line, "%d-%d-%dT%d:%d:%d.%6d%n", &year, &mon, &day,
+                    &hour, &min, &sec, &usec, &nchars)) && (nchars == 26),
+       "timestamp has microseconds");
+
+    /* queued messages are written when the process exits */
+    fflush(stdout);
+    pid_t pid = fork();
+    if (0 == pid) {
+        unifyfs_log_open(async_file);
+        unifyfs_log_async_start();
+        LOGDBG("order=4 exit");
+        exit(1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    ok(find_line(async_file, "order=4", line, sizeof(line)) > 0,
+       "queued message written at exit");
+
+    /* and when the process gets a fatal signal */
+    pid = fork();
+    if (0 == pid) {
+        unifyfs_log_open(async_file);
+        unifyfs_log_async_start();
+        LOGDBG("order=5 abort");
+        abort();
+    }
+    waitpid(pid, &status, 0);
+    ok(WIFSIGNALED(status) && (WTERMSIG(status) == SIGABRT) &&
+       (find_line(async_file, "order=5", line, sizeof(line)) > 0),
+       "queued message written on fatal signal");
+
+    /* a backlog left to the signal handler is written in full */
+    pid = fork();
+    if (0 == pid) {
+        unifyfs_log_open(async_file);
+        unifyfs_log_async_start();
+        for (int i = 0; i < 1000; i++) {
+            LOGDBG("order=6 backlog %d", i);
+        }
+        abort();
+    }
+    waitpid(pid, &status, 0);
+    ok(WIFSIGNALED(status) && (WTERMSIG(status) == SIGABRT) &&
+       (find_line(async_file, "order=6 backlog 999", line, sizeof(line)) > 0),
+       "queued backlog written on fatal signal");
+
+    unlink(sync_file);
+    unlink(async_file);
+
+    done_testing();
+}
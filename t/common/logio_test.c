@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "unifyfs_logio.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test for log chunk allocation after chunks are freed.
+ *
+ * When a reservation does not fit in shmem, the free chunks at the end of
+ * shmem may be joined with the first chunks of the spill file. This frees
+ * and reallocates chunks so that the most recent allocation is below free
+ * chunks at the start of shmem and below chunks still in use, and checks
+ * that a large allocation is not joined across the chunks in use, and that
+ * a later one is joined when the end of shmem really is free.
+ */
+
+#define CHUNK_SZ (64 * 1024)
+#define MEM_CHUNKS 8
+#define SPILL_CHUNKS 16
+
+/* fill buffer with the pattern for id */
+static void fill_data(char* buf, size_t len, int id)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (char)((id * 31) + (i % 251));
+    }
+}
+
+/* allocate and write n_chunks of the pattern for id */
+static int write_data(logio_context* ctx, size_t n_chunks, int id,
+                      off_t* log_off)
+{
+    size_t len = n_chunks * CHUNK_SZ;
+    size_t nwrite = 0;
+    char* buf = malloc(len);
+    fill_data(buf, len, id);
+    int rc = unifyfs_logio_alloc(ctx, len, log_off);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = unifyfs_logio_write(ctx, *log_off, len, buf, &nwrite);
+        if ((rc == UNIFYFS_SUCCESS) && (nwrite != len)) {
+            rc = EIO;
+        }
+    }
+    free(buf);
+    return rc;
+}
+
+/* check that n_chunks at the log offset hold the pattern for id */
+static int check_data(logio_context* ctx, off_t log_off, size_t n_chunks,
+                      int id)
+{
+    size_t len = n_chunks * CHUNK_SZ;
+    size_t nread = 0;
+    char* expect = malloc(len);
+    char* buf = malloc(len);
+    fill_data(expect, len, id);
+    int rc = unifyfs_logio_read(ctx, log_off, len, buf, &nread);
+    int same = (rc == UNIFYFS_SUCCESS) && (nread == len) &&
+               (0 == memcmp(expect, buf, len));
+    free(expect);
+    free(buf);
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    char spill_dir[64];
+    char shmem_sz[32];
+    char spill_sz[32];
+    char chunk_sz[32];
+    size_t pgsz = get_page_size();
+    size_t mem_data_sz = MEM_CHUNKS * CHUNK_SZ;
+    int app_id = 9902;
+    int client_id = (int) getpid();
+    int rc;
+
+    plan(NO_PLAN);
+
+    snprintf(spill_dir, sizeof(spill_dir), "/tmp/logio.%d", client_id);
+    mkdir(spill_dir, 0700);
+    snprintf(shmem_sz, sizeof(shmem_sz), "%zu", pgsz + mem_data_sz);
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             pgsz + SPILL_CHUNKS * CHUNK_SZ);
+    snprintf(chunk_sz, sizeof(chunk_sz), "%d", CHUNK_SZ);
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = shmem_sz;
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = spill_dir;
+    cfg.logio_chunk_size = chunk_sz;
+
+    logio_context* cli = NULL;
+    rc = unifyfs_logio_init_client(app_id, client_id, &cfg, &cli);
+    ok(rc == UNIFYFS_SUCCESS && cli != NULL, "client logio initialized");
+    if (NULL == cli) {
+        done_testing();
+    }
+
+    /* fill shmem with A (slots 0-3), B (4-5) and C (6-7) */
+    off_t off_a, off_b, off_c, off_d, off_e, off_f;
+    rc = write_data(cli, 4, 1, &off_a);
+    rc |= write_data(cli, 2, 2, &off_b);
+    rc |= write_data(cli, 2, 3, &off_c);
+    ok(rc == UNIFYFS_SUCCESS && off_a == 0 &&
+       off_b == 4 * CHUNK_SZ && off_c == 6 * CHUNK_SZ,
+       "filled shmem with three allocations");
+
+    /* reuse the middle run, so the last allocation ends below C */
+    unifyfs_logio_free(cli, off_b, 2 * CHUNK_SZ);
+    rc = write_data(cli, 2, 4, &off_d);
+    ok(rc == UNIFYFS_SUCCESS && off_d == off_b,
+       "freed middle chunks reallocated");
+
+    /* free the low run, leaving four free chunks followed by D and C */
+    unifyfs_logio_free(cli, off_a, 4 * CHUNK_SZ);
+
+    /* five chunks don't fit in shmem, and the end of shmem is in use, so
+     * the allocation must be entirely in spill */
+    rc = write_data(cli, 5, 5, &off_e);
+    ok(rc == UNIFYFS_SUCCESS && off_e >= (off_t) mem_data_sz,
+       "allocation is not joined across chunks in use (off=%zu)",
+       (size_t) off_e);
+    ok(check_data(cli, off_d, 2, 4) && check_data(cli, off_c, 2, 3),
+       "data in use is intact");
+    ok(check_data(cli, off_e, 5, 5), "spill allocation reads back");
+
+    /* free C and E, so the two chunks at the end of shmem and the start
+     * of spill are free, and the next allocation spans both */
+    unifyfs_logio_free(cli, off_c, 2 * CHUNK_SZ);
+    unifyfs_logio_free(cli, off_e, 5 * CHUNK_SZ);
+    rc = write_data(cli, 5, 6, &off_f);
+    ok(rc == UNIFYFS_SUCCESS && off_f == 6 * CHUNK_SZ,
+       "allocation spans the end of shmem and spill (off=%zu)",
+       (size_t) off_f);
+    ok(check_data(cli, off_f, 5, 6) && check_data(cli, off_d, 2, 4),
+       "spanning allocation reads back, data in use is intact");
+
+    unifyfs_logio_close(cli, 0);
+    rmdir(spill_dir);
+
+    /* remove the shmem region */
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "logio_mem.%d.%d",
+             app_id, client_id);
+    shm_unlink(shm_name);
+
+    done_testing();
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "unifyfs_logio.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test for log chunk tiering.
+ *
+ * Fills the shmem part of a small client log and checks that the tiering
+ * thread moves cold chunks to the spill file to keep shmem chunks free,
+ * that new writes then get shmem chunks, that advised chunks are moved,
+ * that the data reads back intact through both the client and a server
+ * view of the log while chunks are being moved, and that chunks written
+ * by the server are only moved once the client marks them written.
+ */
+
+#define CHUNK_SZ (64 * 1024)
+#define MEM_CHUNKS 4
+#define SPILL_CHUNKS 8
+
+static char chunk_buf[CHUNK_SZ];
+
+/* fill buffer with the pattern for a chunk of data */
+static void fill_chunk(char* buf, int id)
+{
+    for (size_t i = 0; i < CHUNK_SZ; i++) {
+        buf[i] = (char)((id * 31) + (i % 251));
+    }
+}
+
+/* check that the data at a log offset holds the pattern for id */
+static int check_chunk(logio_context* ctx, off_t log_off, int id)
+{
+    char expect[CHUNK_SZ];
+    size_t nread = 0;
+    fill_chunk(expect, id);
+    int rc = unifyfs_logio_read(ctx, log_off, CHUNK_SZ, chunk_buf, &nread);
+    return (rc == UNIFYFS_SUCCESS) && (nread == CHUNK_SZ) &&
+           (0 == memcmp(expect, chunk_buf, CHUNK_SZ));
+}
+
+/* wait up to a second for the tier counts to reach the given values */
+static void wait_counts(logio_context* ctx, size_t demoted, size_t promoted)
+{
+    for (int i = 0; i < 1000; i++) {
+        size_t d, p;
+        unifyfs_logio_get_tier_counts(ctx, &d, &p);
+        if ((d >= demoted) && (p >= promoted)) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    char spill_dir[64];
+    char shmem_sz[32];
+    char spill_sz[32];
+    char chunk_sz[32];
+    size_t pgsz = get_page_size();
+    int app_id = 9901;
+    int client_id = (int) getpid();
+    int rc;
+
+    plan(NO_PLAN);
+
+    snprintf(spill_dir, sizeof(spill_dir), "/tmp/logio_tier.%d", client_id);
+    mkdir(spill_dir, 0700);
+    snprintf(shmem_sz, sizeof(shmem_sz), "%zu", pgsz + MEM_CHUNKS * CHUNK_SZ);
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             pgsz + SPILL_CHUNKS * CHUNK_SZ);
+    snprintf(chunk_sz, sizeof(chunk_sz), "%d", CHUNK_SZ);
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = shmem_sz;
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = spill_dir;
+    cfg.logio_chunk_size = chunk_sz;
+    cfg.logio_tier_interval = "1000";
+    cfg.logio_tier_free_pct = "50";
+
+    logio_context* cli = NULL;
+    rc = unifyfs_logio_init_client(app_id, client_id, &cfg, &cli);
+    ok(rc == UNIFYFS_SUCCESS && cli != NULL && cli->tiers != NULL,
+       "client logio with tiering initialized");
+    if (NULL == cli) {
+        done_testing();
+    }
+
+    logio_context* svr = NULL;
+    rc = unifyfs_logio_init_server(app_id, client_id,
+                                   pgsz + MEM_CHUNKS * CHUNK_SZ,
+                                   pgsz + SPILL_CHUNKS * CHUNK_SZ,
+                                   spill_dir, &svr);
+    ok(rc == UNIFYFS_SUCCESS && svr != NULL && svr->tiers != NULL,
+       "server logio attached to tier map");
+
+    /* fill the shmem log chunks */
+    off_t offs[MEM_CHUNKS + 2];
+    int all_written = 1;
+    for (int i = 0; i < MEM_CHUNKS; i++) {
+        size_t nwrite = 0;
+        fill_chunk(chunk_buf, i);
+        rc = unifyfs_logio_alloc(cli, CHUNK_SZ, &offs[i]);
+        if (rc == UNIFYFS_SUCCESS) {
+            rc = unifyfs_logio_write(cli, offs[i], CHUNK_SZ, chunk_buf,
+                                     &nwrite);
+        }
+        if ((rc != UNIFYFS_SUCCESS) || (nwrite != CHUNK_SZ)) {
+            all_written = 0;
+        }
+    }
+    ok(all_written, "wrote %d chunks filling shmem", MEM_CHUNKS);
+
+    /* half of shmem is kept free, so two chunks are moved to spill */
+    wait_counts(cli, MEM_CHUNKS / 2, 0);
+    size_t demoted, promoted;
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok(demoted == MEM_CHUNKS / 2, "cold chunks demoted (%zu)", demoted);
+
+    int intact = 1;
+    for (int i = 0; i < MEM_CHUNKS; i++) {
+        intact &= check_chunk(cli, offs[i], i);
+        intact &= check_chunk(svr, offs[i], i);
+    }
+    ok(intact, "demoted data reads back intact from client and server");
+
+    /* the next writes spill by log offset, but get the freed shmem. They
+     * are advised as needed so that the older chunks are demoted */
+    size_t mem_used = 0;
+    size_t spill_used = 0;
+    for (int i = MEM_CHUNKS; i < MEM_CHUNKS + 2; i++) {
+        size_t nwrite = 0;
+        fill_chunk(chunk_buf, i);
+        unifyfs_logio_alloc(cli, CHUNK_SZ, &offs[i]);
+        unifyfs_logio_advise(cli, offs[i], CHUNK_SZ, LOGIO_ADVICE_WILLNEED);
+        unifyfs_logio_write(cli, offs[i], CHUNK_SZ, chunk_buf, &nwrite);
+    }
+    unifyfs_logio_get_usage(cli, &mem_used, &spill_used);
+    ok(spill_used == 2 * CHUNK_SZ, "new log chunks are in the spill range");
+    wait_counts(cli, MEM_CHUNKS, 0);
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok(demoted == MEM_CHUNKS, "shmem kept free for new writes (%zu)",
+       demoted);
+
+    /* free a shmem chunk, then advise that a spill chunk will be needed */
+    unifyfs_logio_free(cli, offs[MEM_CHUNKS + 1], CHUNK_SZ);
+    unifyfs_logio_advise(cli, offs[0], CHUNK_SZ, LOGIO_ADVICE_WILLNEED);
+    wait_counts(cli, MEM_CHUNKS, 1);
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok(promoted == 1, "needed chunk promoted into free shmem (%zu)",
+       promoted);
+
+    /* advise that a shmem chunk will not be needed */
+    unifyfs_logio_advise(cli, offs[MEM_CHUNKS], CHUNK_SZ,
+                         LOGIO_ADVICE_DONTNEED);
+    wait_counts(cli, MEM_CHUNKS + 1, 1);
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok(demoted == MEM_CHUNKS + 1, "unneeded chunk demoted (%zu)", demoted);
+
+    intact = 1;
+    for (int i = 0; i < MEM_CHUNKS + 1; i++) {
+        intact &= check_chunk(cli, offs[i], i);
+        intact &= check_chunk(svr, offs[i], i);
+    }
+    ok(intact, "all data reads back intact after moves");
+
+    /* fill shmem with needed chunks, so the next chunk is in spill */
+    off_t need_offs[MEM_CHUNKS];
+    for (int i = 0; i < MEM_CHUNKS; i++) {
+        size_t nwrite = 0;
+        fill_chunk(chunk_buf, i);
+        unifyfs_logio_alloc(cli, CHUNK_SZ, &need_offs[i]);
+        unifyfs_logio_advise(cli, need_offs[i], CHUNK_SZ,
+                             LOGIO_ADVICE_WILLNEED);
+        unifyfs_logio_write(cli, need_offs[i], CHUNK_SZ, chunk_buf, &nwrite);
+        wait_counts(cli, MEM_CHUNKS + 2, 1);
+    }
+
+    /* a chunk the server writes in place, as for log compaction, is not
+     * moved until the client marks it written */
+    off_t svr_off;
+    size_t nwrite = 0;
+    fill_chunk(chunk_buf, MEM_CHUNKS + 1);
+    rc = unifyfs_logio_alloc(cli, CHUNK_SZ, &svr_off);
+    if (rc == UNIFYFS_SUCCESS) {
+        rc = unifyfs_logio_write(svr, svr_off, CHUNK_SZ, chunk_buf, &nwrite);
+    }
+    unifyfs_logio_advise(cli, svr_off, CHUNK_SZ, LOGIO_ADVICE_WILLNEED);
+    for (int i = 0; i < MEM_CHUNKS - 1; i++) {
+        unifyfs_logio_free(cli, need_offs[i], CHUNK_SZ);
+    }
+    wait_counts(cli, MEM_CHUNKS + 2, 2);
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok((rc == UNIFYFS_SUCCESS) && (nwrite == CHUNK_SZ) && (promoted == 1),
+       "chunk written by server is not promoted (%zu)", promoted);
+
+    unifyfs_logio_set_written(cli, svr_off, CHUNK_SZ);
+    wait_counts(cli, MEM_CHUNKS + 2, 2);
+    unifyfs_logio_get_tier_counts(cli, &demoted, &promoted);
+    ok(promoted == 2, "chunk marked written is promoted (%zu)", promoted);
+    ok(check_chunk(cli, svr_off, MEM_CHUNKS + 1),
+       "promoted server data reads back intact");
+
+    unifyfs_logio_close(svr, 1);
+    unifyfs_logio_close(cli, 0);
+    rmdir(spill_dir);
+
+    /* remove the shmem regions */
+    char shm_name[64];
+    snprintf(shm_name, sizeof(shm_name), "logio_mem.%d.%d",
+             app_id, client_id);
+    shm_unlink(shm_name);
+    snprintf(shm_name, sizeof(shm_name), "logio_tiers.%d.%d",
+             app_id, client_id);
+    shm_unlink(shm_name);
+
+    done_testing();
+}
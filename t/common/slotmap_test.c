@@ -120,6 +120,21 @@ int main(int argc, char** argv)
     rc = slotmap_clear(smap);
     ok(rc == 0, "clear the slotmap");
 
+    /* the high-water mark only drops when the highest slots are freed */
+    ssize_t low = slotmap_reserve(smap, 4);
+    ssize_t high = slotmap_reserve(smap, 4);
+    ok(slotmap_high_water(smap) == (size_t)(high + 4),
+       "high-water mark is past the last reservation");
+    slotmap_release(smap, low, 4);
+    ok(slotmap_high_water(smap) == (size_t)(high + 4),
+       "high-water mark unchanged after releasing lower slots");
+    ok(slotmap_reserve_at(smap, high + 2, 4) == -1,
+       "slotmap_reserve_at() fails on used slots");
+    ok(slotmap_reserve_at(smap, high + 4, 4) == (high + 4),
+       "slotmap_reserve_at() reserves the given free slots");
+    slotmap_release(smap, high, 8);
+    ok(slotmap_high_water(smap) == 0, "high-water mark of empty slotmap");
+
     done_testing();
 }
 
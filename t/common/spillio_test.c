@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "unifyfs_logio.h"
+#include "unifyfs_spillio.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and benchmark for asynchronous spill file I/O.
+ *
+ * Reads random blocks of a local file one pread() at a time (queue depth
+ * one), and then as batches submitted to a spill I/O queue, reporting
+ * the time per read for each. This is done with io_uring when the kernel
+ * provides it, and with the I/O thread pool. Checks that the batched
+ * reads return the right data, and that batched log writes and reads of
+ * a spill-only client log are intact, including unaligned ones when the
+ * spill file uses O_DIRECT, and when the log is striped across several
+ * spill directories.
+ *
+ * usage: spillio_test.t [dir] [file MiB] [block KiB] [reads]
+ */
+
+static size_t block_sz = 4096;
+static size_t n_reads = 8192;
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1.0e9);
+}
+
+/* value of the 8-byte word at a file offset */
+static inline uint64_t word_at(off_t off)
+{
+    return ((uint64_t)off * 2654435761ULL) ^ 0x5bd1e995ULL;
+}
+
+/* check that a block read from the given offset holds the right data */
+static int check_block(const char* buf, off_t off)
+{
+    const uint64_t* w = (const uint64_t*) buf;
+    for (size_t i = 0; i < (block_sz / sizeof(uint64_t)); i++) {
+        if (w[i] != word_at(off + (off_t)(i * sizeof(uint64_t)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* time batched reads of the blocks at the given offsets. Returns
+ * seconds, or a negative value if data was wrong */
+static double batched_reads(int fd, off_t* offs, char* bufs)
+{
+    spillio_queue* q = unifyfs_spillio_queue();
+    spillio_req* reqs = calloc(n_reads, sizeof(spillio_req));
+    spillio_req** preqs = calloc(n_reads, sizeof(spillio_req*));
+    for (size_t i = 0; i < n_reads; i++) {
+        reqs[i].fd = fd;
+        reqs[i].buf = bufs + (i * block_sz);
+        reqs[i].len = block_sz;
+        reqs[i].offset = offs[i];
+        preqs[i] = reqs + i;
+    }
+
+    double start = now_secs();
+    int rc = unifyfs_spillio_run(q, preqs, n_reads);
+    double secs = now_secs() - start;
+
+    int good = (rc == UNIFYFS_SUCCESS);
+    for (size_t i = 0; good && (i < n_reads); i++) {
+        good = (reqs[i].result == (ssize_t)block_sz) &&
+               check_block(reqs[i].buf, offs[i]);
+    }
+    free(reqs);
+    free(preqs);
+    return good ? secs : -1.0;
+}
+
+/* remove the spill file of a test log */
+static void remove_spillfile(const char* dir, int app_id)
+{
+    char spillfile[256];
+    snprintf(spillfile, sizeof(spillfile), "%s/logio_spill.%d.%d",
+             dir, app_id, (int)getpid());
+    unlink(spillfile);
+}
+
+/* write and read back data with batched log I/O on a spill-only log */
+static int logio_batch_check(const char* dir)
+{
+    char spill_sz[32];
+    size_t chunk = 64 * 1024;
+    size_t nbytes = 16 * chunk;
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             get_page_size() + (32 * chunk));
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = "0";
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = (char*) dir;
+    cfg.logio_chunk_size = "65536";
+
+    logio_context* ctx = NULL;
+    int rc = unifyfs_logio_init_client(9902, (int)getpid(), &cfg, &ctx);
+    if (rc != UNIFYFS_SUCCESS) {
+        return 0;
+    }
+
+    char* wbuf = malloc(nbytes);
+    char* rbuf = calloc(1, nbytes);
+    for (size_t i = 0; i < nbytes; i++) {
+        wbuf[i] = (char)(i % 253);
+    }
+
+    /* one large write is split into concurrent pieces */
+    off_t log_off;
+    size_t nwrite = 0;
+    int good = (UNIFYFS_SUCCESS == unifyfs_logio_alloc(ctx, nbytes, &log_off));
+    if (good) {
+        rc = unifyfs_logio_write(ctx, log_off, nbytes, wbuf, &nwrite);
+        good = (rc == UNIFYFS_SUCCESS) && (nwrite == nbytes);
+    }
+
+    /* read it back as a batch of reads of each chunk */
+    logio_io ios[16];
+    memset(ios, 0, sizeof(ios));
+    for (int i = 0; i < 16; i++) {
+        ios[i].ctx = ctx;
+        ios[i].log_offset = log_off + (off_t)(i * chunk);
+        ios[i].nbytes = chunk;
+        ios[i].buf = rbuf + (i * chunk);
+    }
+    if (good) {
+        rc = unifyfs_logio_read_batch(ios, 16);
+        good = (rc == UNIFYFS_SUCCESS);
+        for (int i = 0; good && (i < 16); i++) {
+            good = (ios[i].rc == UNIFYFS_SUCCESS) && (ios[i].nio == chunk);
+        }
+        good = good && (0 == memcmp(wbuf, rbuf, nbytes));
+    }
+
+    free(wbuf);
+    free(rbuf);
+    unifyfs_logio_close(ctx, 0);
+    remove_spillfile(dir, 9902);
+    return good;
+}
+
+/* write and read back data at unaligned buffers and offsets of an
+ * O_DIRECT spill-only log. Returns -1 if O_DIRECT is not supported */
+static int logio_odirect_check(const char* dir)
+{
+    char spill_sz[32];
+    size_t chunk = 64 * 1024;
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             get_page_size() + (32 * chunk));
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = "0";
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = (char*) dir;
+    cfg.logio_spill_odirect = "on";
+    cfg.logio_chunk_size = "65536";
+
+    logio_context* ctx = NULL;
+    int rc = unifyfs_logio_init_client(9903, (int)getpid(), &cfg, &ctx);
+    if (rc != UNIFYFS_SUCCESS) {
+        return 0;
+    }
+    if (0 == ctx->spill_align) {
+        unifyfs_logio_close(ctx, 0);
+        remove_spillfile(dir, 9903);
+        return -1;
+    }
+
+    /* unaligned buffers, lengths, and offsets, with small writes that
+     * share blocks, and a batched write that starts mid-block */
+    size_t nbytes = (4 * chunk) + 1000;
+    char* wmem = malloc(nbytes + 1);
+    char* rmem = calloc(1, nbytes + 1);
+    char* wbuf = wmem + 1;
+    char* rbuf = rmem + 1;
+    for (size_t i = 0; i < nbytes; i++) {
+        wbuf[i] = (char)((i * 7) % 251);
+    }
+
+    off_t log_off;
+    int good = (UNIFYFS_SUCCESS == unifyfs_logio_alloc(ctx, nbytes + 10,
+                                                        &log_off));
+    size_t pieces[] = { 10, 100, 3000, 5000, nbytes - 8110 };
+    size_t pos = 0;
+    for (int i = 0; good && (i < 5); i++) {
+        size_t nwrite = 0;
+        rc = unifyfs_logio_write(ctx, log_off + 10 + (off_t)pos, pieces[i],
+                                 wbuf + pos, &nwrite);
+        good = (rc == UNIFYFS_SUCCESS) && (nwrite == pieces[i]);
+        pos += pieces[i];
+    }
+
+    /* read back synchronously, then as a batch of unaligned pieces */
+    size_t nread = 0;
+    if (good) {
+        rc = unifyfs_logio_read(ctx, log_off + 10, nbytes, rbuf, &nread);
+        good = (rc == UNIFYFS_SUCCESS) && (nread == nbytes) &&
+               (0 == memcmp(wbuf, rbuf, nbytes));
+    }
+    logio_io ios[4];
+    memset(ios, 0, sizeof(ios));
+    memset(rbuf, 0, nbytes);
+    size_t third = nbytes / 3;
+    for (int i = 0; i < 3; i++) {
+        ios[i].ctx = ctx;
+        ios[i].log_offset = log_off + 10 + (off_t)(i * third);
+        ios[i].nbytes = (i == 2) ? (nbytes - (2 * third)) : third;
+        ios[i].buf = rbuf + (i * third);
+    }
+
+    /* an aligned offset into an unaligned buffer is staged */
+    size_t staged_len = (2 * chunk) + 5;
+    char* smem = calloc(1, staged_len + 1);
+    ios[3].ctx = ctx;
+    ios[3].log_offset = log_off + 4096;
+    ios[3].nbytes = staged_len;
+    ios[3].buf = smem + 1;
+    if (good) {
+        rc = unifyfs_logio_read_batch(ios, 4);
+        good = (rc == UNIFYFS_SUCCESS);
+        for (int i = 0; good && (i < 4); i++) {
+            good = (ios[i].rc == UNIFYFS_SUCCESS) &&
+                   (ios[i].nio == ios[i].nbytes);
+        }
+        good = good && (0 == memcmp(wbuf, rbuf, nbytes)) &&
+               (0 == memcmp(wbuf + 4086, smem + 1, staged_len));
+    }
+    free(smem);
+
+    free(wmem);
+    free(rmem);
+    unifyfs_logio_close(ctx, 0);
+    remove_spillfile(dir, 9903);
+    return good;
+}
+
+/* write data to a spill-only log striped across three directories, and
+ * check that each holds some of it and that it reads back intact from
+ * the client and a server view of the log */
+static int logio_stripe_check(const char* dir)
+{
+    char dirs[3][128];
+    char dir_list[400];
+    char spill_sz[32];
+    size_t chunk = 64 * 1024;
+    size_t nbytes = (10 * chunk) + 123;
+    int app_id = 9904;
+    int client_id = (int) getpid();
+    for (int i = 0; i < 3; i++) {
+        snprintf(dirs[i], sizeof(dirs[i]), "%s/spillio_stripe.%d.%d",
+                 dir, client_id, i);
+        mkdir(dirs[i], 0700);
+    }
+    snprintf(dir_list, sizeof(dir_list), "%s:%s:%s",
+             dirs[0], dirs[1], dirs[2]);
+    snprintf(spill_sz, sizeof(spill_sz), "%zu",
+             get_page_size() + (32 * chunk));
+
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.logio_shmem_size = "0";
+    cfg.logio_spill_size = spill_sz;
+    cfg.logio_spill_dir = dir_list;
+    cfg.logio_chunk_size = "65536";
+
+    logio_context* ctx = NULL;
+    int rc = unifyfs_logio_init_client(app_id, client_id, &cfg, &ctx);
+    int good = (rc == UNIFYFS_SUCCESS) && (ctx->spill_nstripes == 3);
+    if (rc != UNIFYFS_SUCCESS) {
+        return 0;
+    }
+
+    char* wbuf = malloc(nbytes);
+    char* rbuf = calloc(1, nbytes);
+    for (size_t i = 0; i < nbytes; i++) {
+        wbuf[i] = (char)((i * 13) % 241);
+    }
+
+    /* one small and one large write */
+    off_t log_off;
+    size_t nwrite = 0;
+    good = good &&
+           (UNIFYFS_SUCCESS == unifyfs_logio_alloc(ctx, nbytes, &log_off));
+    if (good) {
+        rc = unifyfs_logio_write(ctx, log_off, 1000, wbuf, &nwrite);
+        good = (rc == UNIFYFS_SUCCESS) && (nwrite == 1000);
+    }
+    if (good) {
+        rc = unifyfs_logio_write(ctx, log_off + 1000, nbytes - 1000,
+                                 wbuf + 1000, &nwrite);
+        good = (rc == UNIFYFS_SUCCESS) && (nwrite == (nbytes - 1000));
+    }
+
+    /* each stripe file holds some of the data */
+    for (int i = 0; good && (i < 3); i++) {
+        struct stat st;
+        good = (0 == stat(ctx->spill_stripe_files[i], &st)) &&
+               (st.st_blocks > 0);
+    }
+
+    size_t nread = 0;
+    if (good) {
+        rc = unifyfs_logio_read(ctx, log_off, nbytes, rbuf, &nread);
+        good = (rc == UNIFYFS_SUCCESS) && (nread == nbytes) &&
+               (0 == memcmp(wbuf, rbuf, nbytes));
+    }
+
+    logio_context* svr = NULL;
+    if (good) {
+        rc = unifyfs_logio_init_server(app_id, client_id, 0,
+                                       get_page_size() + (32 * chunk),
+                                       dir_list, &svr);
+        good = (rc == UNIFYFS_SUCCESS);
+    }
+    if (good) {
+        logio_io io;
+        memset(&io, 0, sizeof(io));
+        memset(rbuf, 0, nbytes);
+        io.ctx = svr;
+        io.log_offset = log_off;
+        io.nbytes = nbytes;
+        io.buf = rbuf;
+        rc = unifyfs_logio_read_batch(&io, 1);
+        good = (rc == UNIFYFS_SUCCESS) && (io.rc == UNIFYFS_SUCCESS) &&
+               (io.nio == nbytes) && (0 == memcmp(wbuf, rbuf, nbytes));
+    }
+
+    free(wbuf);
+    free(rbuf);
+    unifyfs_logio_close(ctx, 0);
+    if (NULL != svr) {
+        unifyfs_logio_close(svr, 1);
+    }
+    for (int i = 0; i < 3; i++) {
+        rmdir(dirs[i]);
+    }
+    return good;
+}
+
+int main(int argc, char** argv)
+{
+    const char* dir = "/tmp";
+    size_t file_mib = 64;
+    if (argc > 1) {
+        dir = argv[1];
+    }
+    if (argc > 2) {
+        file_mib = (size_t) atol(argv[2]);
+    }
+    if (argc > 3) {
+        block_sz = (size_t) atol(argv[3]) * 1024;
+    }
+    if (argc > 4) {
+        n_reads = (size_t) atol(argv[4]);
+    }
+
+    plan(NO_PLAN);
+
+    /* create the test file */
+    char path[256];
+    snprintf(path, sizeof(path), "%s/spillio_test.%d", dir, (int)getpid());
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    ok(fd >= 0, "created test file %s", path);
+    if (fd < 0) {
+        done_testing();
+    }
+    size_t file_sz = file_mib * 1024 * 1024;
+    size_t wbuf_sz = 1024 * 1024;
+    uint64_t* wbuf = malloc(wbuf_sz);
+    int written = 1;
+    for (size_t off = 0; off < file_sz; off += wbuf_sz) {
+        for (size_t i = 0; i < (wbuf_sz / sizeof(uint64_t)); i++) {
+            wbuf[i] = word_at((off_t)(off + (i * sizeof(uint64_t))));
+        }
+        if (pwrite(fd, wbuf, wbuf_sz, (off_t)off) != (ssize_t)wbuf_sz) {
+            written = 0;
+        }
+    }
+    free(wbuf);
+    fsync(fd);
+    ok(written, "wrote %zu MiB", file_mib);
+
+    /* choose random block-aligned offsets */
+    srand(12345);
+    size_t n_blocks = file_sz / block_sz;
+    off_t* offs = malloc(n_reads * sizeof(off_t));
+    for (size_t i = 0; i < n_reads; i++) {
+        offs[i] = (off_t)(((size_t)rand() % n_blocks) * block_sz);
+    }
+    char* bufs = malloc(n_reads * block_sz);
+
+    /* queue depth one */
+    int good = 1;
+    double start = now_secs();
+    for (size_t i = 0; i < n_reads; i++) {
+        char* buf = bufs + (i * block_sz);
+        if (pread(fd, buf, block_sz, offs[i]) != (ssize_t)block_sz) {
+            good = 0;
+        }
+    }
+    double qd1_secs = now_secs() - start;
+    for (size_t i = 0; good && (i < n_reads); i++) {
+        good = check_block(bufs + (i * block_sz), offs[i]);
+    }
+    ok(good, "QD1 pread: %zu reads of %zu B, %.2f us/read",
+       n_reads, block_sz, (qd1_secs * 1.0e6) / (double)n_reads);
+
+    /* batched with io_uring, if available, and with I/O threads */
+    unifyfs_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    for (int use_uring = 1; use_uring >= 0; use_uring--) {
+        cfg.logio_spill_io_uring = (use_uring ? "on" : "off");
+        int rc = unifyfs_spillio_init(&cfg);
+        ok(rc == UNIFYFS_SUCCESS, "initialized spill I/O (uring=%d)",
+           use_uring);
+        skip(use_uring && !unifyfs_spillio_uses_uring(), 1,
+             "io_uring not available");
+            memset(bufs, 0, n_reads * block_sz);
+            double secs = batched_reads(fd, offs, bufs);
+            ok(secs >= 0.0, "batched %s: %.2f us/read, %.2fx QD1",
+               (use_uring ? "io_uring" : "I/O threads"),
+               (secs * 1.0e6) / (double)n_reads,
+               (secs > 0.0) ? (qd1_secs / secs) : 0.0);
+        end_skip;
+        if (!use_uring) {
+            ok(logio_batch_check(dir), "batched log writes and reads");
+            int odirect = logio_odirect_check(dir);
+            skip(odirect < 0, 1, "O_DIRECT not supported in %s", dir);
+                ok(odirect, "unaligned O_DIRECT log writes and reads");
+            end_skip;
+            ok(logio_stripe_check(dir), "log striped across directories");
+        }
+        unifyfs_spillio_fini();
+    }
+
+    free(offs);
+    free(bufs);
+    close(fd);
+    unlink(path);
+
+    done_testing();
+}
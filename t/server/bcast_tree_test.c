@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unifyfs_tree.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and cost model for server broadcast tree shapes.
+ *
+ * The test checks that every tree shape spans all ranks exactly once for
+ * various rank counts and roots. It then estimates the broadcast time of
+ * each shape with a simple cost model rather than timing processes on one
+ * machine, which would measure the local scheduler instead of the network.
+ * A server sends the payload to its children one after the other, each send
+ * taking the per-message overhead plus the payload size over the link
+ * bandwidth, and the payload arrives after the network latency. A server
+ * acknowledges to its parent once all of its children have acknowledged,
+ * which mirrors the forwarding of the server broadcast rpcs. Payloads are
+ * not pipelined through the tree in the model. With no latency and unit
+ * send time, the model gives the number of sequential send steps of a
+ * shape, which is checked for the chain and binomial trees.
+ */
+
+/* a tree shape to test */
+struct tree_shape {
+    const char* name;
+    unifyfs_tree_type_e type;
+    int degree;
+};
+
+static struct tree_shape shapes[] = {
+    { "chain",    UNIFYFS_TREE_K_ARY,    1 },
+    { "2-ary",    UNIFYFS_TREE_K_ARY,    2 },
+    { "8-ary",    UNIFYFS_TREE_K_ARY,    8 },
+    { "16-ary",   UNIFYFS_TREE_K_ARY,    16 },
+    { "binomial", UNIFYFS_TREE_BINOMIAL, 0 },
+};
+static int num_shapes = (int)(sizeof(shapes) / sizeof(shapes[0]));
+
+/* check the trees of all ranks for the given shape are consistent and
+ * span all ranks, returns number of errors and sets tree depth */
+static int check_tree(struct tree_shape* shape, int ranks, int root,
+                      int* depth)
+{
+    int errors = 0;
+    int r, i;
+    unifyfs_tree_t* trees = calloc(ranks, sizeof(unifyfs_tree_t));
+    int* parent_of = calloc(ranks, sizeof(int));
+    int* level = calloc(ranks, sizeof(int));
+    if ((NULL == trees) || (NULL == parent_of) || (NULL == level)) {
+        free(trees);
+        free(parent_of);
+        free(level);
+        return 1;
+    }
+
+    for (r = 0; r < ranks; r++) {
+        parent_of[r] = -2;
+        level[r] = -1;
+        if (unifyfs_tree_init_type(r, ranks, root, shape->type,
+                                   shape->degree, &trees[r])) {
+            errors++;
+        }
+    }
+
+    /* each rank other than the root must be the child of exactly one
+     * rank, and that rank must be its parent */
+    for (r = 0; r < ranks; r++) {
+        for (i = 0; i < trees[r].child_count; i++) {
+            int child = trees[r].child_ranks[i];
+            if ((child < 0) || (child >= ranks) || (child == root) ||
+                (parent_of[child] != -2)) {
+                errors++;
+            } else {
+                parent_of[child] = r;
+            }
+        }
+    }
+    for (r = 0; r < ranks; r++) {
+        if (r == root) {
+            if (trees[r].parent_rank != -1) {
+                errors++;
+            }
+        } else if (trees[r].parent_rank != parent_of[r]) {
+            errors++;
+        }
+    }
+
+    /* walk the tree from the root to compute the depth, which also
+     * verifies all ranks are reachable */
+    int* queue = parent_of; /* reuse */
+    int head = 0;
+    int tail = 0;
+    *depth = 0;
+    if (0 == errors) {
+        queue[tail++] = root;
+        level[root] = 0;
+        while (head < tail) {
+            r = queue[head++];
+            for (i = 0; i < trees[r].child_count; i++) {
+                int child = trees[r].child_ranks[i];
+                level[child] = level[r] + 1;
+                if (level[child] > *depth) {
+                    *depth = level[child];
+                }
+                queue[tail++] = child;
+            }
+        }
+        if (tail != ranks) {
+            errors++;
+        }
+        for (r = 0; r < ranks; r++) {
+            if (trees[r].depth != *depth) {
+                errors++;
+            }
+        }
+    }
+
+    for (r = 0; r < ranks; r++) {
+        unifyfs_tree_free(&trees[r]);
+    }
+    free(trees);
+    free(parent_of);
+    free(level);
+    return errors;
+}
+
+/* estimate the time of a broadcast from rank 0 among the given number of
+ * ranks, where each send to a child takes send_time and each message
+ * (payload or ack) arrives latency after it is sent. returns a negative
+ * value on error */
+static double model_bcast(struct tree_shape* shape, int ranks,
+                          double latency, double send_time)
+{
+    int r, i;
+    double elapsed = -1.0;
+    unifyfs_tree_t* trees = calloc(ranks, sizeof(unifyfs_tree_t));
+    double* arrive = calloc(ranks, sizeof(double));
+    double* done = calloc(ranks, sizeof(double));
+    int* order = calloc(ranks, sizeof(int));
+    if ((NULL == trees) || (NULL == arrive) || (NULL == done) ||
+        (NULL == order)) {
+        goto out;
+    }
+
+    for (r = 0; r < ranks; r++) {
+        unifyfs_tree_init_type(r, ranks, 0, shape->type, shape->degree,
+                               &trees[r]);
+    }
+
+    /* the payload reaches each child after the sends to the children
+     * listed before it, in breadth-first order from the root */
+    int head = 0;
+    int tail = 0;
+    order[tail++] = 0;
+    while (head < tail) {
+        r = order[head++];
+        for (i = 0; i < trees[r].child_count; i++) {
+            int child = trees[r].child_ranks[i];
+            arrive[child] = arrive[r] + ((i + 1) * send_time) + latency;
+            order[tail++] = child;
+        }
+    }
+
+    /* each rank is done once it has sent to all of its children and
+     * received the acks of their subtrees, in reverse breadth-first order */
+    for (head = tail - 1; head >= 0; head--) {
+        r = order[head];
+        done[r] = arrive[r] + (trees[r].child_count * send_time);
+        for (i = 0; i < trees[r].child_count; i++) {
+            double ack = done[trees[r].child_ranks[i]] + latency;
+            if (ack > done[r]) {
+                done[r] = ack;
+            }
+        }
+    }
+    elapsed = (tail == ranks) ? done[0] : -1.0;
+
+    for (r = 0; r < ranks; r++) {
+        unifyfs_tree_free(&trees[r]);
+    }
+
+out:
+    free(trees);
+    free(arrive);
+    free(done);
+    free(order);
+    return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+    int i, j, s, rc;
+
+    /* process test args */
+    int max_servers = 4096;
+    if (argc > 1) {
+        max_servers = atoi(argv[1]);
+    }
+
+    size_t large_size = 1024 * 1024;
+    if (argc > 2) {
+        large_size = strtoul(argv[2], NULL, 0);
+    }
+
+    /* network latency and per-message overhead in usecs */
+    double latency = 2.0;
+    if (argc > 3) {
+        latency = atof(argv[3]);
+    }
+
+    double overhead = 1.0;
+    if (argc > 4) {
+        overhead = atof(argv[4]);
+    }
+
+    /* link bandwidth in bytes per usec */
+    double bandwidth = 10000.0;
+    if (argc > 5) {
+        bandwidth = atof(argv[5]);
+    }
+
+    plan(NO_PLAN);
+
+    /* check tree shapes */
+    int rank_counts[] = { 1, 2, 3, 7, 8, 64, 100, 1000 };
+    int num_counts = (int)(sizeof(rank_counts) / sizeof(rank_counts[0]));
+    for (s = 0; s < num_shapes; s++) {
+        int errors = 0;
+        int depth = 0;
+        for (i = 0; i < num_counts; i++) {
+            int ranks = rank_counts[i];
+            int roots[] = { 0, ranks / 3, ranks - 1 };
+            for (j = 0; j < 3; j++) {
+                errors += check_tree(&shapes[s], ranks, roots[j], &depth);
+            }
+        }
+        ok(errors == 0, "%s trees span all ranks (depth %d for %d ranks)",
+           shapes[s].name, depth, rank_counts[num_counts - 1]);
+    }
+
+    unifyfs_tree_type_e type;
+    ok((unifyfs_tree_type_parse("binomial", &type) == 0) &&
+       (type == UNIFYFS_TREE_BINOMIAL) &&
+       (unifyfs_tree_type_parse("KARY", &type) == 0) &&
+       (type == UNIFYFS_TREE_K_ARY) &&
+       (unifyfs_tree_type_parse("star", &type) == EINVAL),
+       "parse tree type names");
+
+    /* count the sequential send steps of the chain and binomial trees */
+    int step_errors = 0;
+    for (i = 0; i < num_counts; i++) {
+        int ranks = rank_counts[i];
+        int log2_ranks = 0;
+        while ((1 << log2_ranks) < ranks) {
+            log2_ranks++;
+        }
+        if ((model_bcast(&shapes[0], ranks, 0.0, 1.0) != (ranks - 1)) ||
+            (model_bcast(&shapes[num_shapes - 1], ranks, 0.0, 1.0) !=
+             log2_ranks)) {
+            step_errors++;
+        }
+    }
+    ok(step_errors == 0,
+       "chain takes ranks-1 send steps, binomial takes log2(ranks)");
+
+    /* estimate broadcast times */
+    printf("# model: %.1f usec latency, %.1f usec overhead, "
+           "%.0f bytes/usec\n", latency, overhead, bandwidth);
+    size_t payload_sizes[] = { 256, large_size };
+    for (int ranks = 8; ranks <= max_servers; ranks *= 8) {
+        for (i = 0; i < 2; i++) {
+            double send_time = overhead +
+                               ((double)payload_sizes[i] / bandwidth);
+            for (s = 0; s < num_shapes; s++) {
+                double usecs = model_bcast(&shapes[s], ranks, latency,
+                                           send_time);
+                rc = (usecs >= 0.0) ? 0 : 1;
+                ok(rc == 0, "%d servers, %zu byte %s broadcast: "
+                   "%.1f usecs (modeled)",
+                   ranks, payload_sizes[i], shapes[s].name, usecs);
+            }
+        }
+    }
+
+    done_testing();
+}
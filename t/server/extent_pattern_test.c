@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "extent_tree.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and benchmark for strided extent patterns in compacted extent trees.
+ *
+ * Mimics the index of an IOR-style shared file, where each of num_clients
+ * clients writes num_blocks blocks of block_size bytes, interleaved with
+ * the blocks of the other clients (i.e., a segment count of one and a
+ * transfer size equal to the block size). By default, this creates 1M
+ * extents. The benchmark compares the memory used and the time taken for
+ * random chunk list lookups by a normal extent tree and a compacted tree.
+ */
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1.0e9);
+}
+
+/* random offset within the file, which may exceed RAND_MAX */
+static unsigned long random_offset(unsigned long file_size)
+{
+    unsigned long r = ((unsigned long)rand() << 31) ^ (unsigned long)rand();
+    return r % file_size;
+}
+
+/* add the extents of the strided pattern to the tree */
+static int add_strided_extents(struct extent_tree* tree,
+                               int num_clients,
+                               unsigned long num_blocks,
+                               unsigned long block_size)
+{
+    unsigned long stride = (unsigned long)num_clients * block_size;
+    for (int c = 0; c < num_clients; c++) {
+        for (unsigned long k = 0; k < num_blocks; k++) {
+            unsigned long start = (k * stride) + (c * block_size);
+            unsigned long pos = k * block_size;
+            int rc = extent_tree_add(tree, start, start + block_size - 1,
+                                     0, 1, c, pos, 0);
+            if (rc) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+/* add extents where each pair of clients interleaves its blocks within
+ * its own segment of the file, so patterns of different pairs are
+ * disjoint */
+static int add_segmented_extents(struct extent_tree* tree,
+                                 int num_clients,
+                                 unsigned long num_blocks,
+                                 unsigned long block_size)
+{
+    unsigned long stride = 2 * block_size;
+    unsigned long segment = num_blocks * stride;
+    for (int c = 0; c < num_clients; c++) {
+        unsigned long base = (unsigned long)(c / 2) * segment;
+        for (unsigned long k = 0; k < num_blocks; k++) {
+            unsigned long start = base + (k * stride) + ((c % 2) * block_size);
+            unsigned long pos = k * block_size;
+            int rc = extent_tree_add(tree, start, start + block_size - 1,
+                                     0, 1, c, pos, 0);
+            if (rc) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+/* perform num_lookups random chunk list lookups, returns number of
+ * errors and sets the elapsed time */
+static int time_lookups(struct extent_tree* tree,
+                        unsigned long file_size,
+                        unsigned long read_size,
+                        int num_lookups,
+                        unsigned int seed,
+                        double* elapsed)
+{
+    int errors = 0;
+    srand(seed);
+    double start = now_secs();
+    for (int i = 0; i < num_lookups; i++) {
+        unsigned long offset = random_offset(file_size);
+        unsigned int n_chunks = 0;
+        chunk_read_req_t* chunks = NULL;
+        int rc = extent_tree_get_chunk_list(tree, offset, read_size,
+                                            &n_chunks, &chunks);
+        if (rc || (0 == n_chunks)) {
+            errors++;
+        }
+        free(chunks);
+    }
+    *elapsed = now_secs() - start;
+    return errors;
+}
+
+/* compare chunk lists returned by both trees for random lookups,
+ * returns number of mismatches */
+static int compare_lookups(struct extent_tree* tree,
+                           struct extent_tree* compact,
+                           unsigned long file_size,
+                           unsigned long read_size,
+                           int num_lookups)
+{
+    int mismatches = 0;
+    for (int i = 0; i < num_lookups; i++) {
+        unsigned long offset = random_offset(file_size);
+        unsigned int n1 = 0, n2 = 0;
+        chunk_read_req_t* c1 = NULL;
+        chunk_read_req_t* c2 = NULL;
+        extent_tree_get_chunk_list(tree, offset, read_size, &n1, &c1);
+        extent_tree_get_chunk_list(compact, offset, read_size, &n2, &c2);
+        if (n1 != n2) {
+            mismatches++;
+        } else {
+            for (unsigned int j = 0; j < n1; j++) {
+                if ((c1[j].offset != c2[j].offset) ||
+                    (c1[j].nbytes != c2[j].nbytes) ||
+                    (c1[j].log_offset != c2[j].log_offset) ||
+                    (c1[j].log_client_id != c2[j].log_client_id)) {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+        free(c1);
+        free(c2);
+    }
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    int rc;
+
+    /* process test args */
+    int num_clients = 64;
+    if (argc > 1) {
+        num_clients = atoi(argv[1]);
+    }
+
+    unsigned long num_blocks = 16384;
+    if (argc > 2) {
+        num_blocks = strtoul(argv[2], NULL, 0);
+    }
+
+    unsigned long block_size = 4096;
+    if (argc > 3) {
+        block_size = strtoul(argv[3], NULL, 0);
+    }
+
+    int num_lookups = 100000;
+    if (argc > 4) {
+        num_lookups = atoi(argv[4]);
+    }
+
+    unsigned long num_extents = (unsigned long)num_clients * num_blocks;
+    unsigned long file_size = num_extents * block_size;
+    unsigned long read_size = 4 * block_size;
+
+    plan(NO_PLAN);
+
+    struct extent_tree tree;
+    struct extent_tree compact;
+    extent_tree_init(&tree);
+    extent_tree_init(&compact);
+
+    rc = add_strided_extents(&tree, num_clients, num_blocks, block_size);
+    ok(rc == 0, "add %lu strided extents to tree", num_extents);
+    rc = add_strided_extents(&compact, num_clients, num_blocks, block_size);
+    ok(rc == 0, "add %lu strided extents to compacted tree", num_extents);
+
+    double start = now_secs();
+    rc = extent_tree_compact(&compact);
+    double compact_secs = now_secs() - start;
+    ok(rc == 0, "compact tree (%.3f secs)", compact_secs);
+
+    struct extent_tree_flat* flat = compact.flat;
+    ok((flat != NULL) && (flat->n_patterns == (unsigned long)num_clients) &&
+       (flat->n_extents == 0),
+       "one pattern per client");
+    ok(extent_tree_count(&compact) == num_extents,
+       "compacted tree retains extent count");
+    ok(extent_tree_max_offset(&compact) == (file_size - 1),
+       "compacted tree retains max offset");
+
+    /* compare memory use, tree nodes exclude allocator overheads */
+    size_t tree_bytes = num_extents * sizeof(struct extent_tree_node);
+    size_t flat_bytes = (flat != NULL) ? flat->bytes : 0;
+    ok(flat_bytes < tree_bytes,
+       "memory: tree %zu bytes, compacted %zu bytes (%.3f bytes/extent)",
+       tree_bytes, flat_bytes, (double)flat_bytes / (double)num_extents);
+
+    /* verify both trees give the same results */
+    srand(42);
+    rc = compare_lookups(&tree, &compact, file_size, read_size, 1000);
+    ok(rc == 0, "compacted tree lookups match tree lookups");
+
+    size_t n_nodes = 0;
+    struct extent_tree_node* nodes = NULL;
+    rc = extent_tree_get_nodes(&compact, &n_nodes, &nodes);
+    ok((rc == 0) && (n_nodes == num_extents) &&
+       (nodes[0].start == 0) &&
+       (nodes[n_nodes - 1].end == (file_size - 1)),
+       "expand all extents of compacted tree");
+    free(nodes);
+
+    /* compare lookup times */
+    double tree_secs = 0.0;
+    double flat_secs = 0.0;
+    rc = time_lookups(&tree, file_size, read_size, num_lookups, 7,
+                      &tree_secs);
+    ok(rc == 0, "tree: %d lookups in %.3f secs (%.0f lookups/sec)",
+       num_lookups, tree_secs, num_lookups / tree_secs);
+    rc = time_lookups(&compact, file_size, read_size, num_lookups, 7,
+                      &flat_secs);
+    ok(rc == 0, "compacted: %d lookups in %.3f secs (%.0f lookups/sec)",
+       num_lookups, flat_secs, num_lookups / flat_secs);
+
+    extent_tree_destroy(&tree);
+    extent_tree_destroy(&compact);
+
+    /* patterns in disjoint segments, lookups only visit the patterns
+     * of the segments they overlap */
+    unsigned long seg_blocks = 256;
+    unsigned long seg_file_size = (unsigned long)(num_clients / 2) *
+                                  seg_blocks * 2 * block_size;
+    extent_tree_init(&tree);
+    extent_tree_init(&compact);
+    rc = add_segmented_extents(&tree, num_clients, seg_blocks, block_size);
+    rc |= add_segmented_extents(&compact, num_clients, seg_blocks,
+                                block_size);
+    rc |= extent_tree_compact(&compact);
+    flat = compact.flat;
+    ok((rc == 0) && (flat != NULL) &&
+       (flat->n_patterns == (unsigned long)num_clients),
+       "compact segmented extents into one pattern per client");
+
+    srand(43);
+    rc = compare_lookups(&tree, &compact, seg_file_size, read_size, 1000);
+    ok(rc == 0, "segmented compacted tree lookups match tree lookups");
+    srand(44);
+    rc = compare_lookups(&tree, &compact, seg_file_size,
+                         seg_blocks * 3 * block_size, 1000);
+    ok(rc == 0, "segment-spanning compacted tree lookups match tree lookups");
+
+    extent_tree_destroy(&tree);
+    extent_tree_destroy(&compact);
+
+    done_testing();
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extent_tree.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test the extent tree reference callback used for log space reclamation.
+ * The bytes referenced for each client must always match the bytes of the
+ * file covered by that client's extents, and drop to zero once the extents
+ * are overwritten, truncated, or cleared. Relocating an extent, as done by
+ * log compaction, moves its references to the new log offset.
+ */
+
+#define NUM_CLIENTS 8
+
+static long live_bytes[NUM_CLIENTS];
+static unsigned long last_added_pos;
+static int ref_errors;
+
+static void count_ref(int svr_rank,
+                      int app_id,
+                      int cli_id,
+                      unsigned long pos,
+                      unsigned long length,
+                      int added)
+{
+    if ((cli_id < 0) || (cli_id >= NUM_CLIENTS) || (0 == length)) {
+        ref_errors++;
+        return;
+    }
+    if (added) {
+        live_bytes[cli_id] += (long) length;
+        last_added_pos = pos;
+    } else {
+        live_bytes[cli_id] -= (long) length;
+        if (live_bytes[cli_id] < 0) {
+            ref_errors++;
+        }
+    }
+}
+
+static long total_live(void)
+{
+    long total = 0;
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        total += live_bytes[i];
+    }
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    int rc;
+
+    plan(NO_PLAN);
+
+    extent_tree_set_ref_callback(count_ref);
+
+    struct extent_tree tree;
+    extent_tree_init(&tree);
+
+    rc = extent_tree_add(&tree, 0, 99, 0, 1, 0, 0, 0);
+    ok((rc == 0) && (live_bytes[0] == 100), "add references new data");
+
+    /* overwrite tail of client 0 data */
+    rc = extent_tree_add(&tree, 50, 149, 0, 1, 1, 1000, 0);
+    ok((rc == 0) && (live_bytes[0] == 50) && (live_bytes[1] == 100),
+       "overwrite releases overlapped data");
+
+    /* overwrite middle of client 0 data, splitting its extent */
+    rc = extent_tree_add(&tree, 20, 29, 0, 1, 2, 2000, 0);
+    ok((rc == 0) && (live_bytes[0] == 40) && (live_bytes[2] == 10),
+       "split releases only overlapped data");
+
+    /* fully overwrite client 2 data */
+    rc = extent_tree_add(&tree, 10, 39, 0, 1, 3, 3000, 0);
+    ok((rc == 0) && (live_bytes[0] == 20) && (live_bytes[2] == 0) &&
+       (live_bytes[3] == 30),
+       "full overwrite releases all data");
+
+    /* contiguous writes by the same client are merged */
+    rc = extent_tree_add(&tree, 150, 199, 0, 1, 1, 1100, 0);
+    ok((rc == 0) && (live_bytes[1] == 150), "merged extents keep references");
+    ok(total_live() == 200, "references match file size after writes");
+
+    rc = extent_tree_truncate(&tree, 120);
+    ok((rc == 0) && (live_bytes[1] == 70) && (total_live() == 120),
+       "truncate releases truncated data");
+
+    rc = extent_tree_truncate(&tree, 30);
+    ok((rc == 0) && (live_bytes[1] == 0) && (live_bytes[3] == 20) &&
+       (total_live() == 30),
+       "truncate releases removed extents");
+
+    /* move data of client 3 to a new log offset */
+    rc = extent_tree_relocate(&tree, 10, 29, 0, 1, 3, 3000, 5000, 0);
+    ok((rc == 0) && (live_bytes[3] == 20) && (last_added_pos == 5000),
+       "relocate references moved data");
+
+    last_added_pos = 0;
+    rc = extent_tree_relocate(&tree, 10, 29, 0, 1, 3, 3000, 6000, 0);
+    ok((rc == 0) && (live_bytes[3] == 20) && (last_added_pos == 0),
+       "relocate ignores extents holding other data");
+
+    rc = extent_tree_relocate(&tree, 10, 19, 0, 1, 3, 5000, 6000, 0);
+    ok((rc == EBUSY) && (live_bytes[3] == 20) && (last_added_pos == 0),
+       "relocate of part of an extent fails");
+
+    /* contiguous data synced at different log release epochs is kept
+     * in separate extents, so reads can check each epoch */
+    rc = extent_tree_add(&tree, 200, 209, 0, 1, 2, 4000, 1);
+    if (rc == 0) {
+        rc = extent_tree_add(&tree, 210, 219, 0, 1, 2, 4010, 2);
+    }
+    struct extent_tree_node* node = extent_tree_find(&tree, 210, 219);
+    ok((rc == 0) && (NULL != node) && (node->start == 210) &&
+       (node->epoch == 2),
+       "extents of different release epochs are not merged");
+
+    extent_tree_clear(&tree);
+    ok(total_live() == 0, "clear releases all data");
+
+    /* strided pattern of writes by all clients, then compact */
+    unsigned long block = 64;
+    unsigned long nblocks = 32;
+    unsigned long stride = NUM_CLIENTS * block;
+    rc = 0;
+    for (int c = 0; c < NUM_CLIENTS; c++) {
+        for (unsigned long k = 0; (k < nblocks) && !rc; k++) {
+            unsigned long start = (k * stride) + (c * block);
+            rc = extent_tree_add(&tree, start, start + block - 1,
+                                 0, 1, c, k * block, 0);
+        }
+    }
+    ok((rc == 0) && (total_live() == (long)(stride * nblocks)),
+       "strided writes reference all data");
+
+    rc = extent_tree_compact(&tree);
+    ok((rc == 0) && (total_live() == (long)(stride * nblocks)),
+       "compaction keeps references");
+
+    rc = extent_tree_relocate(&tree, 0, block - 1, 0, 1, 0, 0, 9000, 0);
+    ok(rc == EROFS, "relocate fails on compacted tree");
+
+    extent_tree_clear(&tree);
+    ok(total_live() == 0, "clear of compacted tree releases all data");
+    ok(ref_errors == 0, "no invalid references");
+
+    extent_tree_destroy(&tree);
+    extent_tree_set_ref_callback(NULL);
+
+    done_testing();
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "extent_wire.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and benchmark for the compact extent wire format.
+ *
+ * Encodes and decodes extent lists typical of different write patterns,
+ * checks the decoded extents match the originals, and reports the size in
+ * bytes per extent compared to sending raw struct extent_tree_node arrays,
+ * along with the encode and decode rates.
+ */
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1.0e9);
+}
+
+static unsigned long random_ulong(void)
+{
+    return ((unsigned long)rand() << 31) ^ (unsigned long)rand();
+}
+
+/* each client appends num_extents / num_clients blocks to its log, and
+ * the blocks of all clients are interleaved in the file (IOR N-1 strided) */
+static void fill_strided(struct extent_tree_node* ext, size_t n,
+                         int num_clients, unsigned long block)
+{
+    for (size_t i = 0; i < n; i++) {
+        unsigned long k = i / num_clients;
+        int c = (int)(i % num_clients);
+        ext[i].start = (i * block);
+        ext[i].end = ext[i].start + block - 1;
+        ext[i].svr_rank = c / 16;
+        ext[i].app_id = 1511735092;
+        ext[i].cli_id = c % 16;
+        ext[i].pos = k * block;
+    }
+}
+
+/* each client writes its own contiguous segment of the file (IOR N-1
+ * segmented), extents are in client order */
+static void fill_segmented(struct extent_tree_node* ext, size_t n,
+                           int num_clients, unsigned long block)
+{
+    size_t per_client = n / num_clients;
+    for (size_t i = 0; i < n; i++) {
+        int c = (int)(i / per_client);
+        unsigned long k = i % per_client;
+        ext[i].start = (i * block);
+        ext[i].end = ext[i].start + block - 1;
+        ext[i].svr_rank = c / 16;
+        ext[i].app_id = 1511735092;
+        ext[i].cli_id = c % 16;
+        ext[i].pos = k * block;
+    }
+}
+
+/* random offsets, lengths, and logs */
+static void fill_random(struct extent_tree_node* ext, size_t n,
+                        int num_clients, unsigned long block)
+{
+    for (size_t i = 0; i < n; i++) {
+        int c = rand() % num_clients;
+        ext[i].start = random_ulong() % (1UL << 40);
+        ext[i].end = ext[i].start + (random_ulong() % (4 * block));
+        ext[i].svr_rank = c / 16;
+        ext[i].app_id = -(rand() % 1000);
+        ext[i].cli_id = c % 16;
+        ext[i].pos = random_ulong() % (1UL << 34);
+        ext[i].epoch = (unsigned long)(rand() % 8);
+    }
+}
+
+static int extents_equal(const struct extent_tree_node* a,
+                         const struct extent_tree_node* b,
+                         size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if ((a[i].start != b[i].start) || (a[i].end != b[i].end) ||
+            (a[i].pos != b[i].pos) || (a[i].svr_rank != b[i].svr_rank) ||
+            (a[i].app_id != b[i].app_id) || (a[i].cli_id != b[i].cli_id) ||
+            (a[i].epoch != b[i].epoch)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef void (*fill_fn)(struct extent_tree_node*, size_t, int,
+                        unsigned long);
+
+static void run_pattern(const char* name, fill_fn fill,
+                        size_t num_extents, int num_clients)
+{
+    size_t raw = num_extents * sizeof(struct extent_tree_node);
+    struct extent_tree_node* ext = calloc(num_extents, sizeof(*ext));
+    if (NULL == ext) {
+        ok(0, "%s: allocate extents", name);
+        return;
+    }
+    fill(ext, num_extents, num_clients, 4096);
+
+    void* buf = NULL;
+    size_t size = 0;
+    double start = now_secs();
+    int rc = extent_wire_encode(ext, num_extents, &buf, &size);
+    double enc_secs = now_secs() - start;
+    ok(rc == 0, "%s: encode %zu extents (%.0f extents/sec)",
+       name, num_extents, num_extents / enc_secs);
+
+    size_t n_out = 0;
+    struct extent_tree_node* out = NULL;
+    start = now_secs();
+    rc = extent_wire_decode(buf, size, &n_out, &out);
+    double dec_secs = now_secs() - start;
+    ok((rc == 0) && (n_out == num_extents) &&
+       extents_equal(ext, out, num_extents),
+       "%s: decode matches (%.0f extents/sec)",
+       name, num_extents / dec_secs);
+
+    ok(size < raw, "%s: %.2f bytes/extent vs %zu raw (%.1fx smaller)",
+       name, (double)size / num_extents, sizeof(struct extent_tree_node),
+       (double)raw / size);
+
+    free(buf);
+    free(out);
+    free(ext);
+}
+
+int main(int argc, char** argv)
+{
+    int rc;
+
+    /* process test args */
+    size_t num_extents = 1024 * 1024;
+    if (argc > 1) {
+        num_extents = strtoul(argv[1], NULL, 0);
+    }
+
+    int num_clients = 256;
+    if (argc > 2) {
+        num_clients = atoi(argv[2]);
+    }
+
+    plan(NO_PLAN);
+    srand(42);
+
+    run_pattern("strided", fill_strided, num_extents, num_clients);
+    run_pattern("segmented", fill_segmented, num_extents, num_clients);
+    run_pattern("random", fill_random, num_extents, num_clients);
+
+    /* empty extent list */
+    void* buf = NULL;
+    size_t size = 0;
+    size_t n_out = 1;
+    struct extent_tree_node* out = NULL;
+    rc = extent_wire_encode(NULL, 0, &buf, &size);
+    ok((rc == 0) && (extent_wire_decode(buf, size, &n_out, &out) == 0) &&
+       (n_out == 0) && (out == NULL), "encode and decode empty list");
+    free(buf);
+
+    /* malformed input is rejected */
+    struct extent_tree_node ext[8];
+    fill_random(ext, 8, 4, 4096);
+    rc = extent_wire_encode(ext, 8, &buf, &size);
+    ok((rc == 0) && (extent_wire_decode(buf, size - 1, &n_out, &out) ==
+                     EINVAL),
+       "decode rejects truncated buffer");
+    ((unsigned char*)buf)[0] = EXTENT_WIRE_VERSION + 1;
+    ok(extent_wire_decode(buf, size, &n_out, &out) == EINVAL,
+       "decode rejects unknown version");
+    free(buf);
+
+    done_testing();
+}
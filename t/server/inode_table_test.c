@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unifyfs_inode.h"
+#include "unifyfs_inode_tree.h"
+#include "t/lib/tap.h"
+#include "t/lib/testutil.h"
+
+/*
+ * Test and stress benchmark for the sharded server inode table.
+ *
+ * Each thread stands in for a concurrent RPC handler, and repeatedly
+ * creates files, adds extents, queries attributes and file sizes, and
+ * unlinks its files. The benchmark reports aggregate throughput for
+ * increasing thread counts, using a single shard (i.e., one global lock)
+ * and the default number of shards.
+ */
+
+/* per-thread benchmark state */
+struct stress_args {
+    pthread_t thrd;
+    int id;           /* thread index */
+    int num_files;    /* files per thread */
+    int num_extents;  /* extents added per file */
+    int errors;       /* number of failed operations */
+};
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1.0e9);
+}
+
+static void* stress_inodes(void* arg)
+{
+    struct stress_args* args = (struct stress_args*) arg;
+    struct extent_tree_node node;
+    unifyfs_file_attr_t attr;
+    size_t filesize;
+    int i, j, rc;
+
+    for (i = 0; i < args->num_files; i++) {
+        int gfid = (args->id * args->num_files) + i + 1;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.gfid = gfid;
+        attr.filename = "/unifyfs/stress";
+        rc = unifyfs_inode_create(gfid, &attr);
+        if (rc) {
+            args->errors++;
+            continue;
+        }
+
+        for (j = 0; j < args->num_extents; j++) {
+            memset(&node, 0, sizeof(node));
+            node.start = (unsigned long)j * 4096;
+            node.end = node.start + 4095;
+            node.pos = node.start;
+            node.svr_rank = 0;
+            node.app_id = 1;
+            node.cli_id = args->id;
+            rc = unifyfs_inode_add_extents(gfid, 1, &node);
+            if (rc) {
+                args->errors++;
+            }
+
+            rc = unifyfs_inode_metaget(gfid, &attr);
+            if (rc || (attr.gfid != gfid)) {
+                args->errors++;
+            }
+        }
+
+        rc = unifyfs_inode_get_filesize(gfid, &filesize);
+        if (rc || (filesize != ((size_t)args->num_extents * 4096))) {
+            args->errors++;
+        }
+
+        rc = unifyfs_inode_unlink(gfid);
+        if (rc) {
+            args->errors++;
+        }
+    }
+
+    return NULL;
+}
+
+/* run the stress workload with the given number of shards and threads,
+ * returns the number of failed operations and sets the throughput */
+static int run_stress(unsigned int n_shards, int n_threads,
+                      int num_files, int num_extents, double* ops_per_sec)
+{
+    int i;
+    int errors = 0;
+
+    if (unifyfs_inode_table_init(global_inode_table, n_shards)) {
+        return -1;
+    }
+
+    struct stress_args* args = calloc(n_threads, sizeof(*args));
+    if (NULL == args) {
+        unifyfs_inode_table_destroy(global_inode_table);
+        return -1;
+    }
+
+    double start = now_secs();
+    for (i = 0; i < n_threads; i++) {
+        args[i].id = i;
+        args[i].num_files = num_files;
+        args[i].num_extents = num_extents;
+        pthread_create(&args[i].thrd, NULL, stress_inodes, &args[i]);
+    }
+    for (i = 0; i < n_threads; i++) {
+        pthread_join(args[i].thrd, NULL);
+        errors += args[i].errors;
+    }
+    double elapsed = now_secs() - start;
+
+    /* create + unlink + filesize, plus add + metaget per extent */
+    double ops = (double)n_threads * num_files * (3 + (2 * num_extents));
+    *ops_per_sec = (elapsed > 0.0) ? (ops / elapsed) : 0.0;
+
+    free(args);
+    unifyfs_inode_table_destroy(global_inode_table);
+
+    return errors;
+}
+
+int main(int argc, char** argv)
+{
+    int rc;
+
+    /* process test args */
+    int max_threads = 64;
+    if (argc > 1) {
+        max_threads = atoi(argv[1]);
+    }
+
+    int num_files = 64;
+    if (argc > 2) {
+        num_files = atoi(argv[2]);
+    }
+
+    int num_extents = 16;
+    if (argc > 3) {
+        num_extents = atoi(argv[3]);
+    }
+
+    plan(NO_PLAN);
+
+    /* basic sharding behavior */
+    struct unifyfs_inode_table table;
+    rc = unifyfs_inode_table_init(&table, 48);
+    ok(rc == 0, "inode table init");
+    ok(table.n_shards == 64, "shard count rounded up to power of two");
+    ok(unifyfs_inode_table_shard(&table, 1234) ==
+       unifyfs_inode_table_shard(&table, 1234),
+       "gfid maps to a stable shard");
+    unifyfs_inode_table_destroy(&table);
+    ok(table.shards == NULL, "inode table destroy");
+
+    /* stress with one shard (single lock) and the default shard count */
+    unsigned int shard_counts[2] = { 1, UNIFYFS_INODE_TABLE_SHARDS };
+    for (int s = 0; s < 2; s++) {
+        unsigned int n_shards = shard_counts[s];
+        for (int n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+            double ops_per_sec = 0.0;
+            rc = run_stress(n_shards, n_threads, num_files, num_extents,
+                            &ops_per_sec);
+            ok(rc == 0, "stress shards=%u threads=%d: %.0f ops/sec",
+               n_shards, n_threads, ops_per_sec);
+        }
+    }
+
+    done_testing();
+}
@@ -258,6 +258,299 @@ unifyfs_parse_manifest_line(char* line, char** src, char** dest)
     return rc;
 }
 
+/* a file listed in the manifest */
+typedef struct {
+    char* src;
+    char* dst;
+} stage_entry_t;
+
+/**
+ * @brief reads all entries of the manifest file
+ *
+ * @param fp          manifest file
+ * @param entries     return val of the entries, to be freed by the caller
+ * @param n_entries   return val of the number of entries
+ *
+ * @return 0 on success, errno otherwise
+ */
+static int read_manifest(FILE* fp, stage_entry_t** entries, int* n_entries)
+{
+    int ret = 0;
+    int count = 0;
+    int capacity = 0;
+    char* src = NULL;
+    char* dst = NULL;
+    stage_entry_t* list = NULL;
+    char linebuf[LINE_MAX] = { 0, };
+
+    while (NULL != fgets(linebuf, LINE_MAX - 1, fp)) {
+        if (strlen(linebuf) < 5) {
+            if (linebuf[0] == '\n') {
+                // manifest file ends in a blank line
+                break;
+            } else {
+                fprintf(stderr, "Short (bad) manifest file line: >%s<\n",
+                        linebuf);
+                ret = EINVAL;
+                break;
+            }
+        }
+        ret = unifyfs_parse_manifest_line(linebuf, &src, &dst);
+        if (ret) {
+            ret = EINVAL;
+            break;
+        }
+        if (!src) {
+            /* nothing but whitespace */
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = (capacity ? 2 * capacity : 64);
+            stage_entry_t* tmp = realloc(list, capacity * sizeof(*list));
+            if (!tmp) {
+                free(src);
+                free(dst);
+                ret = ENOMEM;
+                break;
+            }
+            list = tmp;
+        }
+        list[count].src = src;
+        list[count].dst = dst;
+        count++;
+    }
+
+    *entries = list;
+    *n_entries = count;
+
+    return ret;
+}
+
+/**
+ * @brief checks whether a path is in the unifyfs volume
+ *
+ * @param ctx     stage context
+ * @param path    path to check
+ *
+ * @return 1 if @path is under the unifyfs mountpoint, 0 otherwise
+ */
+static int is_unifyfs_path(unifyfs_stage_t* ctx, const char* path)
+{
+    size_t len = strlen(ctx->mountpoint);
+
+    return (0 == strncmp(path, ctx->mountpoint, len)) &&
+           (path[len] == '/' || path[len] == '\0');
+}
+
+/**
+ * @brief finds where a process's share of the bytes of all files begins.
+ *        The files are taken one after another, and the total is split
+ *        evenly across processes, except that files are only split at
+ *        multiples of UNIFYFS_STAGE_SPLIT_SIZE.
+ *
+ * @param starts      offset of each file among all bytes, plus the total
+ * @param n_files     number of files
+ * @param proc        process rank, or the number of processes for the end
+ *
+ * @return offset among all bytes where the share of @proc begins
+ */
+static uint64_t stage_share_start(uint64_t* starts, int n_files, int proc)
+{
+    int i = 0;
+    uint64_t total = starts[n_files];
+    uint64_t pos = (total / total_ranks) * proc +
+                   ((total % total_ranks) * proc) / total_ranks;
+
+    if (proc >= total_ranks) {
+        return total;
+    }
+
+    for (i = 0; i < n_files; i++) {
+        if (pos < starts[i + 1]) {
+            uint64_t off = pos - starts[i];
+            return starts[i] + off - (off % UNIFYFS_STAGE_SPLIT_SIZE);
+        }
+    }
+
+    return total;
+}
+
+/**
+ * @brief transfers all files of the manifest with all processes. Instead
+ *        of splitting each file in turn, the bytes of all files are split
+ *        evenly, so each process copies whole small files and ranges of
+ *        large files. The process whose share holds the first byte of a
+ *        file creates it, and later laminates and checks it.
+ *
+ * @param ctx         stage context and instructions
+ * @param entries     manifest entries
+ * @param n_entries   number of manifest entries
+ *
+ * @return 0 on success, errno otherwise
+ */
+static int stage_parallel(unifyfs_stage_t* ctx,
+                          stage_entry_t* entries, int n_entries)
+{
+    int ret = 0;
+    int all_ret = 0;
+    int i = 0;
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    uint64_t* info = NULL;      /* size and mode of each file, and error */
+    uint64_t* starts = NULL;    /* offset of each file among all bytes */
+    char* owner = NULL;         /* whether this process creates the file */
+
+    info = calloc(2 * n_entries + 1, sizeof(*info));
+    starts = calloc(n_entries + 1, sizeof(*starts));
+    owner = calloc(n_entries + 1, sizeof(*owner));
+    if (!info || !starts || !owner) {
+        ret = ENOMEM;
+    }
+
+    MPI_Allreduce(&ret, &all_ret, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (all_ret) {
+        ret = all_ret;
+        goto out;
+    }
+
+    /* only one process looks up the sizes of all source files */
+    if (0 == rank) {
+        for (i = 0; i < n_entries; i++) {
+            struct stat sb = { 0, };
+
+            if (stat(entries[i].src, &sb) < 0) {
+                fprintf(stderr, "stat on %s failed (err=%d, %s)\n",
+                        entries[i].src, errno, strerror(errno));
+                info[2 * n_entries] = errno;
+                break;
+            }
+            info[2 * i] = (uint64_t) sb.st_size;
+            info[2 * i + 1] = (uint64_t) sb.st_mode;
+        }
+    }
+
+    MPI_Bcast(info, 2 * n_entries + 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    if (info[2 * n_entries]) {
+        ret = (int) info[2 * n_entries];
+        goto out;
+    }
+
+    for (i = 0; i < n_entries; i++) {
+        starts[i + 1] = starts[i] + info[2 * i];
+    }
+
+    lo = stage_share_start(starts, n_entries, rank);
+    hi = stage_share_start(starts, n_entries, rank + 1);
+
+    if (verbose) {
+        fprintf(stdout, "[%d] parallel transfer: %lu of %lu bytes\n",
+                rank, (unsigned long) (hi - lo),
+                (unsigned long) starts[n_entries]);
+    }
+
+    for (i = 0; i < n_entries; i++) {
+        /* empty files past the last byte go to the last process */
+        if ((lo <= starts[i] && starts[i] < hi) ||
+            (rank == total_ranks - 1 && starts[i] == hi)) {
+            int fd = -1;
+
+            owner[i] = 1;
+            fd = open(entries[i].dst, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            if (fd < 0) {
+                ret = errno;
+                fprintf(stderr, "[%d] failed to create the file %s\n",
+                        rank, entries[i].dst);
+                break;
+            }
+            close(fd);
+        }
+    }
+
+    MPI_Allreduce(&ret, &all_ret, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (all_ret) {
+        ret = all_ret;
+        goto out;
+    }
+
+    for (i = 0; i < n_entries; i++) {
+        uint64_t start = starts[i];
+        uint64_t end = starts[i + 1];
+
+        if (start < lo) {
+            start = lo;
+        }
+        if (end > hi) {
+            end = hi;
+        }
+        if (start >= end) {
+            continue;
+        }
+
+        if (verbose) {
+            fprintf(stdout, "[%d] range transfer: src=%s, dst=%s, "
+                    "offset=%lu, length=%lu\n",
+                    rank, entries[i].src, entries[i].dst,
+                    (unsigned long) (start - starts[i]),
+                    (unsigned long) (end - start));
+        }
+
+        ret = unifyfs_transfer_file_range(entries[i].src, entries[i].dst,
+                                          (off_t) (start - starts[i]),
+                                          (size_t) (end - start));
+        if (ret) {
+            ret = -ret;
+            fprintf(stderr, "[%d] failed to transfer file (src=%s, dst=%s):"
+                    " %s\n", rank, entries[i].src, entries[i].dst,
+                    strerror(ret));
+            break;
+        }
+    }
+
+    MPI_Allreduce(&ret, &all_ret, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (all_ret) {
+        ret = all_ret;
+        goto out;
+    }
+
+    for (i = 0; i < n_entries; i++) {
+        if (!owner[i]) {
+            continue;
+        }
+
+        /* all ranges are written, so files staged in can be laminated */
+        if (is_unifyfs_path(ctx, entries[i].dst)) {
+            mode_t mode = ((mode_t) info[2 * i + 1]) & ~(0222);
+
+            if (chmod(entries[i].dst, mode) < 0) {
+                ret = errno;
+                fprintf(stderr, "[%d] failed to laminate the file %s\n",
+                        rank, entries[i].dst);
+                break;
+            }
+        }
+
+        if (ctx->checksum) {
+            ret = verify_checksum(entries[i].src, entries[i].dst);
+            if (ret) {
+                fprintf(stderr, "checksums for >%s< and >%s< differ!\n",
+                        entries[i].src, entries[i].dst);
+                break;
+            }
+        }
+    }
+
+    MPI_Allreduce(&ret, &all_ret, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    ret = all_ret;
+
+out:
+    free(info);
+    free(starts);
+    free(owner);
+
+    return ret;
+}
+
 /**
  * @brief controls the action of the stage-in or stage-out.  Opens up
  *        the manifest file, sends each line to be parsed, and fires
@@ -271,10 +564,11 @@ int unifyfs_stage_transfer(unifyfs_stage_t* ctx)
 {
     int ret = 0;
     int count = 0;
+    int n_entries = 0;
     FILE* fp = NULL;
     char* src = NULL;
     char* dst = NULL;
-    char linebuf[LINE_MAX] = { 0, };
+    stage_entry_t* entries = NULL;
 
     if (!ctx) {
         return EINVAL;
@@ -288,98 +582,82 @@ int unifyfs_stage_transfer(unifyfs_stage_t* ctx)
         goto out;
     }
 
-    while (NULL != fgets(linebuf, LINE_MAX - 1, fp)) {
-        if (strlen(linebuf) < 5) {
-            if (linebuf[0] == '\n') {
-                // manifest file ends in a blank line
-                goto out;
-            } else {
-                fprintf(stderr, "Short (bad) manifest file line: >%s<\n",
-                        linebuf);
-                ret = -EINVAL;
-                goto out;
-            }
-        }
-        ret = unifyfs_parse_manifest_line(linebuf, &src, &dst);
-        if (ret < 0) {
-            fprintf(stderr, "failed to parse %s (%s)\n",
-                    linebuf, strerror(ret));
-            goto out;
-        }
-        if (ctx->mode == UNIFYFS_STAGE_SERIAL) {
-            if (count % total_ranks == rank) {
-                if (verbose) {
-                    fprintf(stdout, "[%d] serial transfer: src=%s, dst=%s\n",
-                            rank, src, dst);
-                }
-
-                ret = unifyfs_transfer_file_serial(src, dst);
-                if (ret) {
-                    goto out;
-                }
+    ret = read_manifest(fp, &entries, &n_entries);
+    if (ret) {
+        fprintf(stderr, "failed to parse %s (%s)\n",
+                ctx->manifest_file, strerror(ret));
+        goto out;
+    }
 
-                if (ret < 0) {
-                    fprintf(stderr, "stat on %s failed (err=%d, %s)\n",
-                            dst, errno, strerror(errno));
-                    ret = errno;
-                    goto out;
-                }
+    if (ctx->mode == UNIFYFS_STAGE_PARALLEL) {
+        ret = stage_parallel(ctx, entries, n_entries);
+        goto out;
+    }
 
-                if (ctx->checksum) {
-                    ret = verify_checksum(src, dst);
-                    if (ret) {
-                        fprintf(stderr, "checksums for >%s< and >%s< differ!\n",
-                                src, dst);
-                        goto out;
-                    }
-                }
-            }
-        } else {
-            if (0 == rank) {
-                int fd = -1;
+    for (count = 0; count < n_entries; count++) {
+        if (count % total_ranks != rank) {
+            continue;
+        }
 
-                if (verbose) {
-                    fprintf(stdout, "[%d] parallel transfer: src=%s, dst=%s\n",
-                            rank, src, dst);
-                }
+        src = entries[count].src;
+        dst = entries[count].dst;
 
-                fd = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0600);
-                if (fd < 0) {
-                    fprintf(stderr, "[%d] failed to create the file %s\n",
-                            rank, dst);
-                    goto out;
-                }
-                close(fd);
+        if (ctx->mode == UNIFYFS_STAGE_LAZY) {
+            if (verbose) {
+                fprintf(stdout, "[%d] lazy transfer: src=%s, dst=%s\n",
+                        rank, src, dst);
             }
 
-            MPI_Barrier(MPI_COMM_WORLD);
-
-            ret = unifyfs_transfer_file_parallel(src, dst);
+            ret = unifyfs_transfer_file_lazy(src, dst);
             if (ret) {
+                ret = -ret;
                 goto out;
             }
+        } else if (ctx->mode == UNIFYFS_STAGE_DIRECT) {
+            if (verbose) {
+                fprintf(stdout, "[%d] direct transfer: src=%s, dst=%s\n",
+                        rank, src, dst);
+            }
 
-            MPI_Barrier(MPI_COMM_WORLD);
-
-            // possible lamination check or force lamination
-            // may need to go here
+            ret = unifyfs_transfer_file_direct(src, dst);
+            if (ret) {
+                ret = -ret;
+                goto out;
+            }
+        } else {
+            if (verbose) {
+                fprintf(stdout, "[%d] serial transfer: src=%s, dst=%s\n",
+                        rank, src, dst);
+            }
 
-            if (ctx->checksum && 0 == rank) {
-                ret = verify_checksum(src, dst);
-                if (ret) {
-                    goto out;
-                }
+            ret = unifyfs_transfer_file_serial(src, dst);
+            if (ret) {
+                goto out;
             }
         }
 
-        count++;
+        if (ctx->checksum) {
+            ret = verify_checksum(src, dst);
+            if (ret) {
+                fprintf(stderr, "checksums for >%s< and >%s< differ!\n",
+                        src, dst);
+                goto out;
+            }
+        }
     }
+
 out:
-    if (ret) {
+    if (ret && src) {
         fprintf(stderr, "failed to transfer file (src=%s, dst=%s): %s\n",
                 src, dst, strerror(ret));
     }
 
+    for (count = 0; count < n_entries; count++) {
+        free(entries[count].src);
+        free(entries[count].dst);
+    }
+    free(entries);
+
     if (fp) {
         fclose(fp);
         fp = NULL;
@@ -387,4 +665,3 @@ out:
 
     return ret;
 }
-
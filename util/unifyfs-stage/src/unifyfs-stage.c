@@ -28,14 +28,18 @@
  *
  * - serial: Each process will transfer a file. Data of a single file will
  *   reside in a single compute node.
- * - parallel (-p, --parallel): Each file will be split and transferred by all
- *   processes. Data of a single file will be spread evenly across all
+ * - parallel (-p, --parallel): The bytes of all files are split evenly across
+ *   all processes, so each process transfers whole small files and ranges of
+ *   large files. Data of large files will be spread evenly across all
  *   available compute nodes.
- *
- * TODO:
- * Maybe later on, it would be better to have a size threshold. Based on the
- * threshold, we can determine whether a file needs to transferred serially (if
- * smaller than threshold), or parallelly.
+ * - direct (-D, --direct): For stage out only. Each file is requested by a
+ *   process, and all unifyfs servers write the data of the file they hold
+ *   directly to the destination, so file data does not pass through this
+ *   application.
+ * - lazy (-L, --lazy): For stage in only. Each file is registered by a
+ *   process, without copying its data. The unifyfs servers read each part
+ *   of the file from the source the first time it is read, so the job can
+ *   start before its inputs are copied.
  */
 #include <config.h>
 
@@ -106,7 +110,9 @@ static int create_status_file(int status)
 static struct option long_opts[] = {
     { "checksum", 0, 0, 'c' },
     { "debug", 0, 0, 'd' },
+    { "direct", 0, 0, 'D' },
     { "help", 0, 0, 'h' },
+    { "lazy", 0, 0, 'L' },
     { "mountpoint", 1, 0, 'm' },
     { "parallel", 0, 0, 'p' },
     { "share-dir", 1, 0, 's' },
@@ -115,7 +121,7 @@ static struct option long_opts[] = {
     { 0, 0, 0, 0 },
 };
 
-static char* short_opts = "cdhm:ps:vN";
+static char* short_opts = "cdDhLm:ps:vN";
 
 static const char* usage_str =
     "\n"
@@ -136,18 +142,25 @@ static const char* usage_str =
     "Available options:\n"
     "\n"
     "  -c, --checksum           verify md5 checksum for each transfer\n"
+    "  -D, --direct             have unifyfs servers write staged out files\n"
     "  -h, --help               print this usage\n"
+    "  -L, --lazy               stage in files as they are read\n"
     "  -m, --mountpoint=<mnt>   use <mnt> as unifyfs mountpoint\n"
     "                           (default: /unifyfs)\n"
-    "  -p, --parallel           transfer each file in parallel\n"
-    "                           (experimental)\n"
+    "  -p, --parallel           split the transfer of all files evenly\n"
+    "                           across processes\n"
     "  -s, --share-dir=<path>   directory path for creating status file\n"
     "  -v, --verbose            print noisy outputs\n"
     "  -N, --no-mount-unifyfs   don't mount unifyfs file system (for testing)\n"
     "\n"
     "Without the '-p, --parallel' option, a file is transferred by a single\n"
-    "process. If the '-p, --parallel' option is specified, each file will be\n"
-    "divided by multiple processes and transferred in parallel.\n"
+    "process. If the '-p, --parallel' option is specified, the bytes of all\n"
+    "files are divided evenly between processes, and files larger than 8 MiB\n"
+    "are transferred by multiple processes in parallel. With the\n"
+    "'-D, --direct' option, files are staged out by the unifyfs servers,\n"
+    "each writing the file data it holds. Files must be laminated. With\n"
+    "the '-L, --lazy' option, files are staged in without copying, and the\n"
+    "unifyfs servers read their data from the source when first needed.\n"
     "\n";
 
 static char* program;
@@ -201,6 +214,14 @@ static int parse_option(int argc, char** argv)
             debug = 1;
             break;
 
+        case 'D':
+            mode = UNIFYFS_STAGE_DIRECT;
+            break;
+
+        case 'L':
+            mode = UNIFYFS_STAGE_LAZY;
+            break;
+
         case 'm':
             mountpoint = strdup(optarg);
             break;
@@ -7,13 +7,23 @@
 
 #define UNIFYFS_STAGE_MD5_BLOCKSIZE    (1048576)
 
+/* in parallel mode, files are only split between processes at multiples
+ * of this size, so smaller files are each copied by a single process */
+#define UNIFYFS_STAGE_SPLIT_SIZE       (8 * 1048576)
+
 /*
  * serial: each file is tranferred by a process.
- * parallel: a file is transferred by all processes.
+ * parallel: the bytes of all files are split evenly across processes.
+ * direct: each file is staged out by all servers, writing the data they
+ *         hold, as requested by a process.
+ * lazy: each file is registered for stage-in by a process, and the servers
+ *       read its data when it is first read.
  */
 enum {
     UNIFYFS_STAGE_SERIAL = 0,
     UNIFYFS_STAGE_PARALLEL = 1,
+    UNIFYFS_STAGE_DIRECT = 2,
+    UNIFYFS_STAGE_LAZY = 3,
 };
 
 struct _unifyfs_stage {
@@ -21,7 +31,8 @@ struct _unifyfs_stage {
     int total_ranks;        /* mpi world size */
 
     int checksum;           /* perform checksum? 0:no, 1:yes */
-    int mode;               /* transfer mode? 0:serial, 1:parallel */
+    int mode;               /* transfer mode? 0:serial, 1:parallel,
+                             * 2:direct, 3:lazy */
     int should_we_mount_unifyfs;  /* mount? 0:no (for testing), 1: yes */
     char* mountpoint;       /* unifyfs mountpoint */
     char* manifest_file;    /* manifest file containing the transfer list */
@@ -719,6 +719,13 @@ static size_t construct_stage_argv(unifyfs_args_t* args,
         argc += 2;
     }
 
+    if (args->stage_in && args->stage_lazy) {
+        if (stage_argv != NULL) {
+            stage_argv[argc] = strdup("-L");
+        }
+        argc += 1;
+    }
+
     if (stage_argv != NULL) {
         char* manifest_file = args->stage_in ? args->stage_in
                               : args->stage_out;
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ *
+ * Copyright 2020, UT-Battelle, LLC.
+ *
+ * LLNL-CODE-741539
+ * All rights reserved.
+ *
+ * This is the license for UnifyFS.
+ * For details, see https://github.com/LLNL/UnifyFS.
+ * Please read https://github.com/LLNL/UnifyFS/LICENSE for full license text.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <margo.h>
+
+#include "unifyfs.h"
+#include "unifyfs_client_rpcs.h"
+#include "unifyfs_rc.h"
+#include "unifyfs_rpc_util.h"
+
+/*
+ * Query the server on this node for its statistics, or for the statistics
+ * of all servers, and print them to stdout as JSON.
+ */
+int unifyfs_print_stats(unifyfs_args_t* args)
+{
+    int ret = UNIFYFS_SUCCESS;
+    hg_return_t hret;
+
+    /* the local server address is published in the runstate
+     * key-value store, and in a file in /tmp */
+    char* svr_addr_string = rpc_lookup_local_server_addr();
+    if (NULL == svr_addr_string) {
+        fprintf(stderr, "ERROR: no UnifyFS server found on this node\n");
+        return ENOENT;
+    }
+
+    /* protocol is the part of the address before the colon */
+    char* proto = strdup(svr_addr_string);
+    char* colon = strchr(proto, ':');
+    if (NULL != colon) {
+        *colon = '\0';
+    }
+
+    margo_instance_id mid = margo_init(proto, MARGO_CLIENT_MODE, 0, 0);
+    free(proto);
+    if (MARGO_INSTANCE_NULL == mid) {
+        fprintf(stderr, "ERROR: failed to initialize margo\n");
+        free(svr_addr_string);
+        return UNIFYFS_ERROR_MARGO;
+    }
+
+    hg_addr_t svr_addr = HG_ADDR_NULL;
+    hret = margo_addr_lookup(mid, svr_addr_string, &svr_addr);
+    if ((hret != HG_SUCCESS) || (HG_ADDR_NULL == svr_addr)) {
+        fprintf(stderr, "ERROR: failed to resolve server address %s\n",
+                svr_addr_string);
+        free(svr_addr_string);
+        margo_finalize(mid);
+        return UNIFYFS_ERROR_MARGO;
+    }
+    free(svr_addr_string);
+
+    hg_id_t stats_id = MARGO_REGISTER(mid, "unifyfs_stats_rpc",
+                                      unifyfs_stats_in_t,
+                                      unifyfs_stats_out_t,
+                                      NULL);
+
+    hg_handle_t handle;
+    hret = margo_create(mid, svr_addr, stats_id, &handle);
+    if (hret != HG_SUCCESS) {
+        fprintf(stderr, "ERROR: margo_create() failed\n");
+        ret = UNIFYFS_ERROR_MARGO;
+    } else {
+        unifyfs_stats_in_t in;
+        in.all = (int32_t) args->stats_all;
+        hret = margo_forward(handle, &in);
+        if (hret != HG_SUCCESS) {
+            fprintf(stderr, "ERROR: margo_forward() failed\n");
+            ret = UNIFYFS_ERROR_MARGO;
+        } else {
+            unifyfs_stats_out_t out;
+            hret = margo_get_output(handle, &out);
+            if (hret != HG_SUCCESS) {
+                fprintf(stderr, "ERROR: margo_get_output() failed\n");
+                ret = UNIFYFS_ERROR_MARGO;
+            } else {
+                ret = (int) out.ret;
+                if (ret == UNIFYFS_SUCCESS) {
+                    printf("%s\n", out.json);
+                } else {
+                    fprintf(stderr, "ERROR: server stats failed - %s\n",
+                            unifyfs_rc_enum_description(ret));
+                }
+                margo_free_output(handle, &out);
+            }
+        }
+        margo_destroy(handle);
+    }
+
+    margo_addr_free(mid, svr_addr);
+    margo_finalize(mid);
+
+    return ret;
+}
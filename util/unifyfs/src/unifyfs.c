@@ -56,16 +56,18 @@ typedef enum {
     INVALID_ACTION   = -1,
     ACT_START        = 0,
     ACT_TERMINATE    = 1,
-    N_ACT            = 2
+    ACT_STATS        = 2,
+    N_ACT            = 3
 } action_e;
 
-static char* actions[N_ACT] = { "start", "terminate" };
+static char* actions[N_ACT] = { "start", "terminate", "stats" };
 
 static action_e action = INVALID_ACTION;
 static unifyfs_args_t cli_args;
 static unifyfs_resource_t resource;
 
 static struct option const long_opts[] = {
+    { "all", no_argument, NULL, 'a' },
     { "cleanup", no_argument, NULL, 'c' },
     { "consistency", required_argument, NULL, 'C' },
     { "debug", no_argument, NULL, 'd' },
@@ -75,6 +77,7 @@ static struct option const long_opts[] = {
     { "script", required_argument, NULL, 's' },
     { "share-dir", required_argument, NULL, 'S' },
     { "stage-in", required_argument, NULL, 'i' },
+    { "stage-lazy", no_argument, NULL, 'L' },
     { "stage-out", required_argument, NULL, 'o' },
     { "timeout", required_argument, NULL, 't' },
     { "stage-timeout", required_argument, NULL, 'T' },
@@ -82,7 +85,7 @@ static struct option const long_opts[] = {
 };
 
 static char* program;
-static char* short_opts = ":cC:de:hi:m:o:s:S:t:T:";
+static char* short_opts = ":acC:de:hi:Lm:o:s:S:t:T:";
 static char* usage_str =
     "\n"
     "Usage: %s <command> [options...]\n"
@@ -90,6 +93,7 @@ static char* usage_str =
     "<command> should be one of the following:\n"
     "  start       start the UnifyFS server daemons\n"
     "  terminate   terminate the UnifyFS server daemons\n"
+    "  stats       print statistics of the UnifyFS server on this node\n"
     "\n"
     "Common options:\n"
     "  -d, --debug               enable debug output\n"
@@ -104,6 +108,8 @@ static char* usage_str =
     "  -S, --share-dir=<path>     [REQUIRED] shared file system <path> for use by servers\n"
     "  -c, --cleanup              [OPTIONAL] clean up the UnifyFS storage upon server exit\n"
     "  -i, --stage-in=<manifest>  [OPTIONAL] stage in file(s) listed in <manifest> file\n"
+    "  -L, --stage-lazy           [OPTIONAL] stage in files without copying"
+    " their data\n"
     "  -T, --stage-timeout=<sec>  [OPTIONAL] timeout for stage-in operation\n"
     "\n"
     "Command options for \"terminate\":\n"
@@ -111,6 +117,9 @@ static char* usage_str =
     "  -T, --stage-timeout=<sec>  [OPTIONAL] timeout for stage-out operation\n"
     "  -s, --script=<path>        [OPTIONAL] <path> to custom termination script\n"
     "  -S, --share-dir=<path>     [REQUIRED for --stage-out] shared file system <path> for use by servers\n"
+    "\n"
+    "Command options for \"stats\":\n"
+    "  -a, --all                  [OPTIONAL] print statistics of all servers\n"
     "\n";
 
 static int debug;
@@ -126,8 +135,10 @@ static void parse_cmd_arguments(int argc, char** argv)
     int ch = 0;
     int optidx = 2;
     int cleanup = 0;
+    int stats_all = 0;
     int timeout = UNIFYFS_DEFAULT_INIT_TIMEOUT;
     int stage_timeout = -1;
+    int stage_lazy = 0;
     unifyfs_cm_e consistency = UNIFYFS_CM_LAMINATED;
     char* mountpoint = NULL;
     char* script = NULL;
@@ -141,6 +152,10 @@ static void parse_cmd_arguments(int argc, char** argv)
     while ((ch = getopt_long(argc, argv,
                              short_opts, long_opts, &optidx)) >= 0) {
         switch (ch) {
+        case 'a':
+            stats_all = 1;
+            break;
+
         case 'c':
             printf("WARNING: cleanup not yet supported!\n");
             cleanup = 1;
@@ -185,6 +200,10 @@ static void parse_cmd_arguments(int argc, char** argv)
             stage_in = strdup(optarg);
             break;
 
+        case 'L':
+            stage_lazy = 1;
+            break;
+
         case 'o':
             stage_out = strdup(optarg);
             break;
@@ -209,8 +228,10 @@ static void parse_cmd_arguments(int argc, char** argv)
     cli_args.server_path = srvr_exe;
     cli_args.share_dir = share_dir;
     cli_args.stage_in = stage_in;
+    cli_args.stage_lazy = stage_lazy;
     cli_args.stage_out = stage_out;
     cli_args.stage_timeout = stage_timeout;
+    cli_args.stats_all = stats_all;
     cli_args.timeout = timeout;
 }
 
@@ -252,10 +273,16 @@ int main(int argc, char** argv)
         printf("share_dir:\t%s\n", cli_args.share_dir);
         printf("server:\t%s\n", cli_args.server_path);
         printf("stage_in:\t%s\n", cli_args.stage_in);
+        printf("stage_lazy:\t%d\n", cli_args.stage_lazy);
         printf("stage_out:\t%s\n", cli_args.stage_out);
         printf("stage_timeout:\t%d\n", cli_args.stage_timeout);
     }
 
+    /* stats only talks to the local server */
+    if (action == ACT_STATS) {
+        return unifyfs_print_stats(&cli_args);
+    }
+
     ret = unifyfs_detect_resources(&resource);
     if (ret) {
         fprintf(stderr, "ERROR: no supported resource manager detected\n");
@@ -64,9 +64,11 @@ struct _unifyfs_args {
     char* share_dir;           /* full path to shared file system directory */
     char* share_hostfile;      /* full path to shared server hostfile */
     char* stage_in;            /* data path to stage-in */
+    int stage_lazy;            /* stage in by reading through? (0 or 1) */
     char* stage_out;           /* data path to stage-out (drain) */
     int stage_timeout;         /* timeout of (in or out) file staging*/
     char* script;              /* path to custom launch/terminate script */
+    int stats_all;             /* get statistics of all servers? (0 or 1) */
 };
 typedef struct _unifyfs_args unifyfs_args_t;
 
@@ -112,5 +114,7 @@ int unifyfs_start_servers(unifyfs_resource_t* resource,
 int unifyfs_stop_servers(unifyfs_resource_t* resource,
                          unifyfs_args_t* args);
 
+int unifyfs_print_stats(unifyfs_args_t* args);
+
 #endif  /* __UNIFYFS_H */
 